@@ -0,0 +1,424 @@
+/*
+ * BloomCoin Consensus Certificates
+ * ================================
+ *
+ * Compile: gcc -O3 -c nexthash256.c bloom_sha256.c
+ *          gcc -O3 -o bloom_cert bloom_cert.c nexthash256.o bloom_sha256.o -lm -DTEST_MAIN
+ */
+
+#include "bloom_cert.h"
+#include "bloom_gate.h"
+#include "bloom_sha256.h"
+#include "nexthash256.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ========================================================================== */
+/* Little-Endian Access                                                        */
+/* ========================================================================== */
+
+static inline uint32_t load_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline float load_lef32(const uint8_t *p) {
+    uint32_t u = load_le32(p);
+    float f;
+    memcpy(&f, &u, 4);
+    return f;
+}
+
+static inline void store_le32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline void store_lef32(uint8_t *p, float f) {
+    uint32_t u;
+    memcpy(&u, &f, 4);
+    store_le32(p, u);
+}
+
+float bloom_cert_r(const bloom_cert_view *v, uint32_t i) {
+    return load_lef32(v->r_values + 4 * (size_t)i);
+}
+
+float bloom_cert_psi(const bloom_cert_view *v, uint32_t i) {
+    return load_lef32(v->psi_values + 4 * (size_t)i);
+}
+
+float bloom_cert_phase(const bloom_cert_view *v, uint32_t i) {
+    return load_lef32(v->final_phases + 4 * (size_t)i);
+}
+
+/* ========================================================================== */
+/* Serialization                                                               */
+/* ========================================================================== */
+
+size_t bloom_cert_size(uint32_t num_values, uint32_t oscillator_count) {
+    return BLOOM_CERT_HEADER_SIZE + 8 * (size_t)num_values + 4 * (size_t)oscillator_count;
+}
+
+size_t bloom_cert_serialize(const bloom_cert_fields *f, uint8_t *out, size_t out_cap) {
+    size_t size = bloom_cert_size(f->num_values, f->oscillator_count);
+    uint8_t *p = out;
+    uint32_t i;
+
+    if (out_cap < size) return 0;
+
+    store_le32(p, f->bloom_start);      p += 4;
+    store_le32(p, f->bloom_end);        p += 4;
+    store_le32(p, f->oscillator_count); p += 4;
+    store_lef32(p, f->threshold);       p += 4;
+    store_le32(p, f->required_rounds);  p += 4;
+    store_le32(p, f->num_values);       p += 4;
+
+    for (i = 0; i < f->num_values; i++, p += 4) store_lef32(p, f->r_values[i]);
+    for (i = 0; i < f->num_values; i++, p += 4) store_lef32(p, f->psi_values[i]);
+    for (i = 0; i < f->oscillator_count; i++, p += 4) store_lef32(p, f->final_phases[i]);
+
+    return size;
+}
+
+int bloom_cert_parse(const uint8_t *data, size_t len, bloom_cert_view *v) {
+    if (len < BLOOM_CERT_HEADER_SIZE) return BLOOM_CERT_ERR_TRUNCATED;
+
+    v->base = data;
+    v->bloom_start = load_le32(data);
+    v->bloom_end = load_le32(data + 4);
+    v->oscillator_count = load_le32(data + 8);
+    v->threshold = load_lef32(data + 12);
+    v->required_rounds = load_le32(data + 16);
+    v->num_values = load_le32(data + 20);
+
+    v->size = bloom_cert_size(v->num_values, v->oscillator_count);
+    if (len < v->size) return BLOOM_CERT_ERR_TRUNCATED;
+
+    v->r_values = data + BLOOM_CERT_HEADER_SIZE;
+    v->psi_values = v->r_values + 4 * (size_t)v->num_values;
+    v->final_phases = v->psi_values + 4 * (size_t)v->num_values;
+    return BLOOM_CERT_OK;
+}
+
+int bloom_cert_parse_block(const uint8_t *block, size_t len,
+                           const uint8_t **header, bloom_cert_view *v) {
+    size_t cert_len;
+
+    if (len < BLOOM_BLOCK_HEADER_SIZE + 4) return BLOOM_CERT_ERR_TRUNCATED;
+    cert_len = load_le32(block + BLOOM_BLOCK_HEADER_SIZE);
+    if (len - BLOOM_BLOCK_HEADER_SIZE - 4 < cert_len) return BLOOM_CERT_ERR_TRUNCATED;
+
+    if (header) *header = block;
+    return bloom_cert_parse(block + BLOOM_BLOCK_HEADER_SIZE + 4, cert_len, v);
+}
+
+/* ========================================================================== */
+/* Verification                                                                */
+/* ========================================================================== */
+
+int bloom_cert_verify(const bloom_cert_view *v) {
+    int64_t duration = (int64_t)v->bloom_end - (int64_t)v->bloom_start + 1;
+    const float th = v->threshold;
+    uint32_t below = 0, i;
+    double sum_c = 0.0, sum_s = 0.0, r_re;
+
+    /* Check 1: duration */
+    if (duration < (int64_t)v->required_rounds) return BLOOM_CERT_ERR_DURATION;
+
+    /* Check 2: all r >= threshold (branch-free scan, NaN passes as in Python) */
+    for (i = 0; i < v->num_values; i++) {
+        below |= (uint32_t)(load_lef32(v->r_values + 4 * (size_t)i) < th);
+    }
+    if (below) return BLOOM_CERT_ERR_BELOW_THRESH;
+
+    /* Check 3: r_values length matches duration */
+    if ((int64_t)v->num_values != duration || v->num_values == 0) {
+        return BLOOM_CERT_ERR_LENGTH;
+    }
+
+    /* Check 4 holds by construction: final_phases has oscillator_count entries */
+
+    /* Check 5: recompute r from final phases */
+    for (i = 0; i < v->oscillator_count; i++) {
+        double theta = (double)load_lef32(v->final_phases + 4 * (size_t)i);
+        sum_c += cos(theta);
+        sum_s += sin(theta);
+    }
+    if (v->oscillator_count > 0) {
+        sum_c /= v->oscillator_count;
+        sum_s /= v->oscillator_count;
+    }
+    r_re = sqrt(sum_c * sum_c + sum_s * sum_s);
+    if (fabs(r_re - (double)bloom_cert_r(v, v->num_values - 1)) > BLOOM_CERT_R_TOLERANCE) {
+        return BLOOM_CERT_ERR_R_MISMATCH;
+    }
+
+    return BLOOM_CERT_OK;
+}
+
+void bloom_cert_hash_batch(const bloom_cert_view *certs, size_t n,
+                           uint8_t (*digests)[32]) {
+    for (size_t i = 0; i < n; i++) bloom_sha256(certs[i].base, certs[i].size, digests[i]);
+}
+
+void bloom_cert_nexthash_batch(const bloom_cert_view *certs, size_t n,
+                               uint8_t (*digests)[32]) {
+    const uint8_t **ptrs;
+    size_t *lens;
+    size_t i;
+
+    ptrs = (const uint8_t **)malloc(n * sizeof(*ptrs));
+    lens = (size_t *)malloc(n * sizeof(*lens));
+    if (!ptrs || !lens) {
+        for (i = 0; i < n; i++) nexthash256(certs[i].base, certs[i].size, digests[i]);
+        free(ptrs);
+        free(lens);
+        return;
+    }
+    for (i = 0; i < n; i++) {
+        ptrs[i] = certs[i].base;
+        lens[i] = certs[i].size;
+    }
+    nexthash256_batch(ptrs, lens, n, digests);
+    free(ptrs);
+    free(lens);
+}
+
+size_t bloom_cert_verify_run(const uint8_t *const *headers,
+                             const bloom_cert_view *certs, size_t n,
+                             int *status) {
+    size_t first_bad = n;
+
+    for (size_t base = 0; base < n; base += 64) {
+        size_t m = (n - base < 64) ? n - base : 64;
+        float r_hdr[64];
+        uint32_t n_hdr[64], n_cert[64];
+        uint64_t bad_r = 0, bad_n = 0;
+        size_t k;
+
+        /* Gather header phase fields into contiguous columns */
+        for (k = 0; k < m; k++) {
+            const uint8_t *h = headers[base + k];
+            r_hdr[k] = load_lef32(h + 80);
+            n_hdr[k] = load_le32(h + 88);
+            n_cert[k] = certs[base + k].oscillator_count;
+        }
+        for (k = 0; k < m; k++) {
+            bad_r |= (uint64_t)((double)r_hdr[k] < BLOOM_Z_C) << k;
+            bad_n |= (uint64_t)(n_hdr[k] != n_cert[k]) << k;
+        }
+
+        /* Certificate check first, as in validate_consensus_certificate() */
+        for (k = 0; k < m; k++) {
+            int st = bloom_cert_verify(&certs[base + k]);
+            if (st == BLOOM_CERT_OK && ((bad_r >> k) & 1)) st = BLOOM_CERT_ERR_HEADER_R;
+            if (st == BLOOM_CERT_OK && ((bad_n >> k) & 1)) st = BLOOM_CERT_ERR_HEADER_N;
+            if (status) status[base + k] = st;
+            if (st != BLOOM_CERT_OK && first_bad == n) first_bad = base + k;
+        }
+    }
+    return first_bad;
+}
+
+const char *bloom_cert_strerror(int status) {
+    switch (status) {
+    case BLOOM_CERT_OK:               return "Certificate valid";
+    case BLOOM_CERT_ERR_TRUNCATED:    return "Certificate truncated";
+    case BLOOM_CERT_ERR_DURATION:     return "Bloom duration < required";
+    case BLOOM_CERT_ERR_BELOW_THRESH: return "r value below threshold";
+    case BLOOM_CERT_ERR_LENGTH:       return "r_values length != duration";
+    case BLOOM_CERT_ERR_R_MISMATCH:   return "Recomputed r != claimed r";
+    case BLOOM_CERT_ERR_HEADER_R:     return "Header order_parameter < z_c";
+    case BLOOM_CERT_ERR_HEADER_N:     return "Header oscillator_count doesn't match certificate";
+    default:                          return "Unknown status";
+    }
+}
+
+/* ========================================================================== */
+/* Test Main                                                                   */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+
+#include <stdio.h>
+#include <time.h>
+
+#define N_OSC 63
+#define N_BLOCKS 2000
+
+/* Build a synced certificate embedded in a Block-shaped buffer */
+static size_t make_block(uint8_t *out, uint32_t height, float spread) {
+    float r[BLOOM_L4], psi[BLOOM_L4], phases[N_OSC];
+    double c = 0.0, s = 0.0, rr;
+    bloom_cert_fields f;
+    size_t cert_len;
+
+    for (int i = 0; i < N_OSC; i++) {
+        phases[i] = 1.0f + spread * (float)((i * 37 % N_OSC) - N_OSC / 2) / N_OSC;
+        c += cos(phases[i]);
+        s += sin(phases[i]);
+    }
+    rr = sqrt(c * c + s * s) / N_OSC;
+    for (int i = 0; i < BLOOM_L4; i++) {
+        r[i] = (float)rr;
+        psi[i] = 1.0f;
+    }
+
+    memset(out, 0, BLOOM_BLOCK_HEADER_SIZE);
+    store_le32(out, 1);
+    store_le32(out + 68, 1700000000u + height);
+    store_lef32(out + 80, (float)rr);
+    store_lef32(out + 84, 1.0f);
+    store_le32(out + 88, N_OSC);
+
+    f.bloom_start = height * 10;
+    f.bloom_end = height * 10 + BLOOM_L4 - 1;
+    f.oscillator_count = N_OSC;
+    f.threshold = (float)BLOOM_Z_C;
+    f.required_rounds = BLOOM_L4;
+    f.num_values = BLOOM_L4;
+    f.r_values = r;
+    f.psi_values = psi;
+    f.final_phases = phases;
+    cert_len = bloom_cert_serialize(&f, out + BLOOM_BLOCK_HEADER_SIZE + 4, 4096);
+    store_le32(out + BLOOM_BLOCK_HEADER_SIZE, (uint32_t)cert_len);
+    return BLOOM_BLOCK_HEADER_SIZE + 4 + cert_len;
+}
+
+int main(void) {
+    uint8_t (*blocks)[1024] = malloc(N_BLOCKS * sizeof(*blocks));
+    const uint8_t **headers = malloc(N_BLOCKS * sizeof(*headers));
+    bloom_cert_view *views = malloc(N_BLOCKS * sizeof(*views));
+    uint8_t (*digests)[32] = malloc(N_BLOCKS * 32);
+    int *status = malloc(N_BLOCKS * sizeof(int));
+    size_t lens[N_BLOCKS], bad;
+    int failures = 0;
+
+    printf("BloomCoin Consensus Certificates\n");
+    printf("================================\n\n");
+
+    for (uint32_t h = 0; h < N_BLOCKS; h++) {
+        lens[h] = make_block(blocks[h], h, 0.5f);
+        if (bloom_cert_parse_block(blocks[h], lens[h], &headers[h], &views[h]) != BLOOM_CERT_OK) {
+            failures++;
+        }
+    }
+    printf("  Parsed %d blocks, cert size %zu bytes\n", N_BLOCKS, views[0].size);
+
+    /* Round trip: re-serializing the view reproduces the bytes */
+    {
+        float r[BLOOM_L4], psi[BLOOM_L4], ph[N_OSC];
+        uint8_t buf[1024];
+        bloom_cert_fields f;
+        for (uint32_t i = 0; i < BLOOM_L4; i++) {
+            r[i] = bloom_cert_r(&views[5], i);
+            psi[i] = bloom_cert_psi(&views[5], i);
+        }
+        for (uint32_t i = 0; i < N_OSC; i++) ph[i] = bloom_cert_phase(&views[5], i);
+        f.bloom_start = views[5].bloom_start;
+        f.bloom_end = views[5].bloom_end;
+        f.oscillator_count = views[5].oscillator_count;
+        f.threshold = views[5].threshold;
+        f.required_rounds = views[5].required_rounds;
+        f.num_values = views[5].num_values;
+        f.r_values = r;
+        f.psi_values = psi;
+        f.final_phases = ph;
+        size_t n = bloom_cert_serialize(&f, buf, sizeof(buf));
+        int ok = n == views[5].size && memcmp(buf, views[5].base, n) == 0;
+        printf("  Serialize round trip: %s\n", ok ? "OK" : "FAIL");
+        if (!ok) failures++;
+    }
+
+    /* Corrupt a few: low r in header, N mismatch, r below threshold */
+    store_lef32(blocks[700] + 80, 0.5f);
+    store_le32(blocks[900] + 88, N_OSC + 1);
+    store_lef32((uint8_t *)views[1200].r_values + 8, 0.3f);
+    lens[1500] = make_block(blocks[1500], 1500, 6.0f);
+    store_lef32(blocks[1500] + 80, 0.9f);
+    bloom_cert_parse_block(blocks[1500], lens[1500], &headers[1500], &views[1500]);
+    {
+        float r6 = bloom_cert_r(&views[1500], BLOOM_L4 - 1);
+        /* Claim full sync although phases are spread */
+        store_lef32((uint8_t *)views[1500].r_values + 4 * (BLOOM_L4 - 1), r6 < 0.9f ? 0.99f : r6);
+        for (uint32_t i = 0; i < BLOOM_L4 - 1; i++) {
+            store_lef32((uint8_t *)views[1500].r_values + 4 * i, 0.99f);
+        }
+    }
+
+    bad = bloom_cert_verify_run(headers, views, N_BLOCKS, status);
+    {
+        int ok = bad == 700 &&
+                 status[700] == BLOOM_CERT_ERR_HEADER_R &&
+                 status[900] == BLOOM_CERT_ERR_HEADER_N &&
+                 status[1200] == BLOOM_CERT_ERR_BELOW_THRESH &&
+                 status[1500] == BLOOM_CERT_ERR_R_MISMATCH &&
+                 status[0] == BLOOM_CERT_OK && status[N_BLOCKS - 1] == BLOOM_CERT_OK;
+        printf("  Run verify: first failure %zu (%s): %s\n", bad,
+               bloom_cert_strerror(status[bad]), ok ? "OK" : "FAIL");
+        printf("    900: %s\n    1200: %s\n    1500: %s\n",
+               bloom_cert_strerror(status[900]), bloom_cert_strerror(status[1200]),
+               bloom_cert_strerror(status[1500]));
+        if (!ok) failures++;
+    }
+
+    /* compute_hash() of a small certificate, digest from hashlib */
+    {
+        static const uint8_t expect[32] = {
+            0x73, 0xe5, 0x19, 0xfb, 0x7c, 0x12, 0x15, 0x27, 0xae, 0xae, 0x5d, 0xe9, 0x37, 0xb3, 0xeb, 0x67,
+            0x5c, 0xd7, 0x13, 0x03, 0xd9, 0x75, 0x8a, 0xe4, 0xfd, 0x84, 0xec, 0xb3, 0xc7, 0x64, 0x36, 0x71
+        };
+        float r = 0.75f, psi = 0.25f, ph[2] = { 1.0f, 2.0f };
+        bloom_cert_fields f = { 1, 5, 2, 0.5f, 5, 1, &r, &psi, ph };
+        uint8_t buf[64], one[1][32];
+        bloom_cert_view v;
+        int ok = bloom_cert_parse(buf, bloom_cert_serialize(&f, buf, sizeof(buf)), &v) == BLOOM_CERT_OK;
+        bloom_cert_hash_batch(&v, 1, one);
+        ok &= memcmp(one[0], expect, 32) == 0;
+        printf("  compute_hash() matches hashlib: %s\n", ok ? "OK" : "FAIL");
+        if (!ok) failures++;
+    }
+
+    /* Batch NEXTHASH digests equal one-shot hashes */
+    {
+        uint8_t one[32];
+        int ok = 1;
+        bloom_cert_nexthash_batch(views, N_BLOCKS, digests);
+        for (int i = 0; i < N_BLOCKS; i += 97) {
+            nexthash256(views[i].base, views[i].size, one);
+            if (memcmp(one, digests[i], 32) != 0) ok = 0;
+        }
+        printf("  NEXTHASH batch matches one-shot: %s\n", ok ? "OK" : "FAIL");
+        if (!ok) failures++;
+    }
+
+    /* Throughput of parse + verify + hash for the run */
+    {
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (int rep = 0; rep < 20; rep++) {
+            for (int h = 0; h < N_BLOCKS; h++) {
+                bloom_cert_parse_block(blocks[h], lens[h], &headers[h], &views[h]);
+            }
+            bloom_cert_verify_run(headers, views, N_BLOCKS, status);
+            bloom_cert_hash_batch(views, N_BLOCKS, digests);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+        printf("  Sync path: %.0f certificates/s\n", 20.0 * N_BLOCKS / sec);
+    }
+
+    free(blocks);
+    free(headers);
+    free(views);
+    free(digests);
+    free(status);
+    printf("\n%s\n", failures ? "FAILURES DETECTED" : "All certificate tests passed.");
+    return failures ? 1 : 0;
+}
+
+#endif /* TEST_MAIN */
@@ -0,0 +1,130 @@
+/*
+ * BloomCoin Consensus Certificates
+ * ================================
+ *
+ * Packed ConsensusCertificate handling for block sync, matching the wire
+ * format of ConsensusCertificate.serialize() in consensus/threshold_gate.py.
+ *
+ * Features:
+ * - Zero-copy parsing: a view points into the received block bytes
+ * - Serialization from host arrays
+ * - verify() checks 1-5 without materializing Python lists
+ * - compute_hash() (SHA-256 of the serialized bytes) over a batch
+ * - NEXTHASH-256 certificate digests through nexthash256_batch(), for
+ *   native indexes; these are not the Python certificate hash
+ * - Batch verification of header/certificate pairs over whole header runs
+ *
+ * Wire format (little-endian):
+ *   bloom_start u32 | bloom_end u32 | oscillator_count u32 |
+ *   threshold f32 | required_rounds u32 | num_values u32 |
+ *   r_values f32[num_values] | psi_values f32[num_values] |
+ *   final_phases f32[oscillator_count]
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef BLOOM_CERT_H
+#define BLOOM_CERT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLOOM_CERT_HEADER_SIZE   24
+#define BLOOM_BLOCK_HEADER_SIZE  92   /* PhaseEncodedHeader.serialize() */
+
+/* Tolerance on recomputed final r (check 5) */
+#define BLOOM_CERT_R_TOLERANCE   0.01
+
+/* Status codes */
+#define BLOOM_CERT_OK                 0
+#define BLOOM_CERT_ERR_TRUNCATED     -1   /* buffer shorter than declared */
+#define BLOOM_CERT_ERR_DURATION      -2   /* check 1 */
+#define BLOOM_CERT_ERR_BELOW_THRESH  -3   /* check 2 */
+#define BLOOM_CERT_ERR_LENGTH        -4   /* check 3 */
+#define BLOOM_CERT_ERR_R_MISMATCH    -5   /* check 5 */
+#define BLOOM_CERT_ERR_HEADER_R      -6   /* header order_parameter < z_c */
+#define BLOOM_CERT_ERR_HEADER_N      -7   /* header oscillator_count mismatch */
+
+/* Parsed certificate; array pointers alias the source buffer */
+typedef struct {
+    const uint8_t *base;
+    size_t size;                /* serialized size in bytes */
+
+    uint32_t bloom_start;
+    uint32_t bloom_end;
+    uint32_t oscillator_count;
+    float threshold;
+    uint32_t required_rounds;
+    uint32_t num_values;
+
+    const uint8_t *r_values;    /* f32 LE [num_values] */
+    const uint8_t *psi_values;  /* f32 LE [num_values] */
+    const uint8_t *final_phases;/* f32 LE [oscillator_count] */
+} bloom_cert_view;
+
+/* Fields for serialization (host-order arrays) */
+typedef struct {
+    uint32_t bloom_start;
+    uint32_t bloom_end;
+    uint32_t oscillator_count;
+    float threshold;
+    uint32_t required_rounds;
+    uint32_t num_values;
+    const float *r_values;
+    const float *psi_values;
+    const float *final_phases;
+} bloom_cert_fields;
+
+/* Serialized size for given array lengths */
+size_t bloom_cert_size(uint32_t num_values, uint32_t oscillator_count);
+
+/* Write certificate bytes; returns bytes written or 0 if out_cap too small */
+size_t bloom_cert_serialize(const bloom_cert_fields *f, uint8_t *out, size_t out_cap);
+
+/* Parse without copying; trailing bytes are ignored, as in deserialize() */
+int bloom_cert_parse(const uint8_t *data, size_t len, bloom_cert_view *v);
+
+/*
+ * Parse a serialized Block: header (92) | cert_len (4) | certificate.
+ * *header is set to the start of the block.
+ */
+int bloom_cert_parse_block(const uint8_t *block, size_t len,
+                           const uint8_t **header, bloom_cert_view *v);
+
+float bloom_cert_r(const bloom_cert_view *v, uint32_t i);
+float bloom_cert_psi(const bloom_cert_view *v, uint32_t i);
+float bloom_cert_phase(const bloom_cert_view *v, uint32_t i);
+
+/* ConsensusCertificate.verify() */
+int bloom_cert_verify(const bloom_cert_view *v);
+
+/* ConsensusCertificate.compute_hash(): SHA-256 of the serialized bytes */
+void bloom_cert_hash_batch(const bloom_cert_view *certs, size_t n,
+                           uint8_t (*digests)[32]);
+
+/* NEXTHASH-256 of each certificate's serialized bytes */
+void bloom_cert_nexthash_batch(const bloom_cert_view *certs, size_t n,
+                               uint8_t (*digests)[32]);
+
+/*
+ * validate_consensus_certificate() over a run of blocks. headers[i] points
+ * at a 92-byte header. status[i] receives each result. Returns the index
+ * of the first failure, or n if all pass.
+ */
+size_t bloom_cert_verify_run(const uint8_t *const *headers,
+                             const bloom_cert_view *certs, size_t n,
+                             int *status);
+
+/* Human-readable status */
+const char *bloom_cert_strerror(int status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOOM_CERT_H */
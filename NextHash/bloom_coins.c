@@ -0,0 +1,656 @@
+/*
+ * BloomCoin Coin Selection
+ * ========================
+ *
+ * Compile: gcc -O3 -o bloom_coins bloom_coins.c -DTEST_MAIN
+ */
+
+#define _GNU_SOURCE
+#include "bloom_coins.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* ========================================================================== */
+/* Internal Structures                                                         */
+/* ========================================================================== */
+
+#define NONE 0xFFFFFFFFu
+
+/* Knapsack candidates: the largest coins below the target, at least this many */
+#define KNAPSACK_WINDOW 1024
+
+struct bloom_coins {
+    uint64_t *amount;           /* descending */
+    bloom_outpoint *outpoint;
+    uint64_t *prefix;           /* prefix[i] = amount[0] + ... + amount[i - 1] */
+    size_t n, cap;
+};
+
+/* Read-only view of the pool at one fee rate */
+typedef struct {
+    const uint64_t *amount;
+    const uint64_t *prefix;
+    uint64_t input_fee;         /* fee for spending one coin */
+    size_t n;                   /* coins with positive effective value */
+} coin_view;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t op_hash(const bloom_outpoint *op) {
+    uint64_t h;
+    memcpy(&h, op->txid, 8);
+    return (h ^ op->index) * 0x9E3779B97F4A7C15ull;
+}
+
+/* ========================================================================== */
+/* Pool                                                                        */
+/* ========================================================================== */
+
+bloom_coins *bloom_coins_create(void) {
+    return (bloom_coins *)calloc(1, sizeof(bloom_coins));
+}
+
+void bloom_coins_destroy(bloom_coins *pool) {
+    if (!pool) return;
+    free(pool->amount);
+    free(pool->outpoint);
+    free(pool->prefix);
+    free(pool);
+}
+
+static void rebuild_prefix(bloom_coins *pool) {
+    pool->prefix[0] = 0;
+    for (size_t i = 0; i < pool->n; i++) pool->prefix[i + 1] = pool->prefix[i] + pool->amount[i];
+}
+
+static int by_amount_desc(const void *a, const void *b) {
+    uint64_t x = ((const bloom_coin *)a)->amount, y = ((const bloom_coin *)b)->amount;
+    return (x < y) - (x > y);
+}
+
+int bloom_coins_add(bloom_coins *pool, const bloom_coin *coins, size_t n) {
+    if (n == 0) return BLOOM_COINS_OK;
+    size_t need = pool->n + n;
+    if (need > pool->cap) {
+        size_t cap = pool->cap ? pool->cap : 1024;
+        while (cap < need) cap *= 2;
+        uint64_t *amount = (uint64_t *)realloc(pool->amount, cap * sizeof(uint64_t));
+        if (amount) pool->amount = amount;
+        bloom_outpoint *outpoint = (bloom_outpoint *)realloc(pool->outpoint,
+                                                             cap * sizeof(bloom_outpoint));
+        if (outpoint) pool->outpoint = outpoint;
+        uint64_t *prefix = (uint64_t *)realloc(pool->prefix, (cap + 1) * sizeof(uint64_t));
+        if (prefix) pool->prefix = prefix;
+        if (!amount || !outpoint || !prefix) return BLOOM_COINS_ERR_NOMEM;
+        pool->cap = cap;
+    }
+
+    bloom_coin *sorted = (bloom_coin *)malloc(n * sizeof(bloom_coin));
+    if (!sorted) return BLOOM_COINS_ERR_NOMEM;
+    memcpy(sorted, coins, n * sizeof(bloom_coin));
+    qsort(sorted, n, sizeof(bloom_coin), by_amount_desc);
+
+    /* Merge from the back so the pool can be merged in place */
+    size_t i = pool->n, j = n, k = need;
+    while (j > 0) {
+        if (i > 0 && pool->amount[i - 1] < sorted[j - 1].amount) {
+            k--; i--;
+            pool->amount[k] = pool->amount[i];
+            pool->outpoint[k] = pool->outpoint[i];
+        } else {
+            k--; j--;
+            pool->amount[k] = sorted[j].amount;
+            pool->outpoint[k] = sorted[j].outpoint;
+        }
+    }
+    free(sorted);
+    pool->n = need;
+    rebuild_prefix(pool);
+    return BLOOM_COINS_OK;
+}
+
+size_t bloom_coins_remove(bloom_coins *pool, const bloom_outpoint *spent, size_t n) {
+    if (n == 0 || pool->n == 0) return 0;
+    size_t slots = 16;
+    while (slots < 2 * n) slots *= 2;
+    uint32_t *set = (uint32_t *)malloc(slots * sizeof(uint32_t));
+    if (!set) return 0;
+    memset(set, 0xFF, slots * sizeof(uint32_t));
+    for (size_t i = 0; i < n; i++) {
+        size_t s = op_hash(&spent[i]) & (slots - 1);
+        while (set[s] != NONE) s = (s + 1) & (slots - 1);
+        set[s] = (uint32_t)i;
+    }
+
+    /* One compaction pass keeps the order */
+    size_t kept = 0;
+    for (size_t i = 0; i < pool->n; i++) {
+        const bloom_outpoint *op = &pool->outpoint[i];
+        size_t s = op_hash(op) & (slots - 1);
+        int hit = 0;
+        for (; set[s] != NONE; s = (s + 1) & (slots - 1)) {
+            if (memcmp(&spent[set[s]], op, sizeof(bloom_outpoint)) == 0) {
+                hit = 1;
+                break;
+            }
+        }
+        if (hit) continue;
+        pool->amount[kept] = pool->amount[i];
+        pool->outpoint[kept] = *op;
+        kept++;
+    }
+    free(set);
+    size_t removed = pool->n - kept;
+    pool->n = kept;
+    rebuild_prefix(pool);
+    return removed;
+}
+
+size_t bloom_coins_count(const bloom_coins *pool) {
+    return pool->n;
+}
+
+uint64_t bloom_coins_total(const bloom_coins *pool) {
+    return pool->n ? pool->prefix[pool->n] : 0;
+}
+
+int bloom_coins_get(const bloom_coins *pool, size_t i, bloom_coin *out) {
+    if (i >= pool->n) return BLOOM_COINS_ERR_INVALID;
+    out->outpoint = pool->outpoint[i];
+    out->amount = pool->amount[i];
+    return BLOOM_COINS_OK;
+}
+
+uint64_t bloom_coins_fee(uint32_t n_inputs, uint32_t n_outputs, uint64_t fee_rate) {
+    return fee_rate * (BLOOM_COINS_TX_BYTES + (uint64_t)n_inputs * BLOOM_COINS_INPUT_BYTES +
+                       (uint64_t)n_outputs * BLOOM_COINS_OUTPUT_BYTES);
+}
+
+/* ========================================================================== */
+/* Effective Values                                                            */
+/* ========================================================================== */
+
+static uint64_t eff(const coin_view *v, size_t i) {
+    return v->amount[i] - v->input_fee;
+}
+
+/* Sum of effective values of coins [a, b) */
+static uint64_t eff_sum(const coin_view *v, size_t a, size_t b) {
+    return v->prefix[b] - v->prefix[a] - (uint64_t)(b - a) * v->input_fee;
+}
+
+/* First coin with amount <= x (coins are descending) */
+static size_t first_at_most(const uint64_t *amount, size_t n, uint64_t x) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (amount[mid] <= x) hi = mid;
+        else lo = mid + 1;
+    }
+    return lo;
+}
+
+/* First coin with effective value <= x */
+static size_t first_eff_at_most(const coin_view *v, uint64_t x) {
+    uint64_t a = x + v->input_fee;
+    return first_at_most(v->amount, v->n, a < x ? UINT64_MAX : a);
+}
+
+/* ========================================================================== */
+/* Branch and Bound                                                            */
+/* ========================================================================== */
+
+/*
+ * Depth-first search over include / exclude decisions in descending order
+ * for a set with effective value in [target, target + slack]. Solutions
+ * are ranked by excess, then by input count. Returns the best size or 0.
+ */
+static uint32_t branch_and_bound(const coin_view *v, uint64_t target, uint64_t slack,
+                                 uint32_t max_inputs, double budget, uint32_t *sel,
+                                 uint32_t *best, uint64_t *tries_out) {
+    size_t start = first_eff_at_most(v, target + slack);
+    uint64_t avail = eff_sum(v, start, v->n), value = 0, best_excess = UINT64_MAX;
+    uint32_t n_sel = 0, n_best = 0;
+    uint64_t tries = 0;
+    double t0 = now_sec();
+    if (avail < target) {
+        *tries_out = 0;
+        return 0;
+    }
+
+    for (size_t i = start; tries < BLOOM_COINS_BNB_TRIES; tries++, i++) {
+        if ((tries & 1023) == 1023 && budget > 0 && now_sec() - t0 > budget) break;
+        int back = 0;
+        if (value + avail < target || value > target + slack) {
+            back = 1;
+        } else if (value >= target) {
+            uint64_t excess = value - target;
+            if (excess < best_excess || (excess == best_excess && n_sel < n_best)) {
+                best_excess = excess;
+                n_best = n_sel;
+                memcpy(best, sel, n_sel * sizeof(uint32_t));
+            }
+            back = 1;
+        } else if (n_sel == max_inputs) {
+            back = 1;
+        }
+
+        if (back) {
+            if (n_sel == 0) break;
+            /* Give back the skipped coins, then exclude the last included */
+            for (--i; i > sel[n_sel - 1]; --i) avail += eff(v, i);
+            value -= eff(v, i);
+            n_sel--;
+        } else {
+            uint64_t e = eff(v, i);
+            avail -= e;
+            /* Excluding a coin and including an equal one next is a repeat */
+            if (n_sel == 0 || i - 1 == sel[n_sel - 1] || v->amount[i] != v->amount[i - 1]) {
+                sel[n_sel++] = (uint32_t)i;
+                value += e;
+            }
+        }
+        if (best_excess == 0 && n_best == 1) break;
+    }
+    *tries_out = tries;
+    return n_best;
+}
+
+/* ========================================================================== */
+/* Knapsack                                                                    */
+/* ========================================================================== */
+
+static uint64_t xorshift(uint64_t *s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+/*
+ * Random subset sums over coins [lo, hi): each round includes coins with
+ * probability 1/2, then fills up in order, dropping the last coin every
+ * time the target is reached. Keeps the smallest sum >= target in best.
+ */
+static uint64_t approximate_subset(const coin_view *v, size_t lo, size_t hi, uint64_t target,
+                                   double budget, uint64_t *rng, uint8_t *inc, uint8_t *best) {
+    size_t m = hi - lo;
+    uint64_t best_sum = eff_sum(v, lo, hi);
+    double t0 = now_sec();
+    memset(best, 1, m);
+    for (int rep = 0; rep < BLOOM_COINS_KNAPSACK_ROUNDS && best_sum != target; rep++) {
+        if (rep && budget > 0 && now_sec() - t0 > budget) break;
+        uint64_t sum = 0, bits = 0;
+        int reached = 0;
+        memset(inc, 0, m);
+        for (int pass = 0; pass < 2 && !reached; pass++) {
+            for (size_t i = 0; i < m; i++) {
+                if (pass == 0) {
+                    if ((i & 63) == 0) bits = xorshift(rng);
+                    if (!(bits >> (i & 63) & 1)) continue;
+                } else if (inc[i]) {
+                    continue;
+                }
+                sum += eff(v, lo + i);
+                inc[i] = 1;
+                if (sum >= target) {
+                    reached = 1;
+                    if (sum < best_sum) {
+                        best_sum = sum;
+                        memcpy(best, inc, m);
+                    }
+                    sum -= eff(v, lo + i);
+                    inc[i] = 0;
+                }
+            }
+        }
+    }
+    return best_sum;
+}
+
+/* Returns the number of coins written to sel, 0 if funds are short */
+static size_t knapsack(const coin_view *v, uint64_t target, uint64_t min_change, double budget,
+                       uint32_t *sel, size_t cap, int *err) {
+    *err = BLOOM_COINS_OK;
+
+    /* A single coin that hits the target exactly */
+    size_t hit = first_eff_at_most(v, target);
+    if (hit < v->n && eff(v, hit) == target) {
+        sel[0] = (uint32_t)hit;
+        return 1;
+    }
+
+    /* Coins below target + min_change form a suffix; the one before is the
+     * smallest coin that covers the target with change on its own */
+    size_t lo = first_eff_at_most(v, target + min_change - 1);
+    uint64_t lower = eff_sum(v, lo, v->n);
+    size_t larger = lo > 0 ? lo - 1 : v->n;
+
+    if (lower < target) {
+        if (larger == v->n) return 0;
+        sel[0] = (uint32_t)larger;
+        return 1;
+    }
+
+    /* The largest small coins: enough of them to cover twice the target */
+    size_t hi = v->n - lo > KNAPSACK_WINDOW ? lo + KNAPSACK_WINDOW : v->n;
+    while (hi < v->n && eff_sum(v, lo, hi) < 2 * target) {
+        hi = v->n - hi > hi - lo ? hi + (hi - lo) : v->n;
+    }
+    lower = eff_sum(v, lo, hi);
+
+    size_t m = hi - lo, n = 0;
+    uint8_t *inc = NULL, *best = NULL;
+    if (lower > target) {
+        inc = (uint8_t *)malloc(m);
+        best = (uint8_t *)malloc(m);
+        if (!inc || !best) {
+            free(inc);
+            free(best);
+            *err = BLOOM_COINS_ERR_NOMEM;
+            return 0;
+        }
+    }
+
+    uint64_t rng = target ^ 0x9E3779B97F4A7C15ull, best_sum = lower;
+    if (lower > target) {
+        best_sum = approximate_subset(v, lo, hi, target, budget, &rng, inc, best);
+        if (best_sum != target && lower >= target + min_change) {
+            best_sum = approximate_subset(v, lo, hi, target + min_change, budget, &rng, inc,
+                                          best);
+        }
+    }
+
+    /* The single larger coin wins if the subset leaves dust or costs more */
+    if (larger != v->n &&
+        ((best_sum != target && best_sum < target + min_change) || eff(v, larger) <= best_sum)) {
+        sel[0] = (uint32_t)larger;
+        n = 1;
+    } else {
+        for (size_t i = 0; i < m; i++) {
+            if (best && !best[i]) continue;
+            if (n == cap) {
+                n = cap + 1;            /* too many inputs */
+                break;
+            }
+            sel[n++] = (uint32_t)(lo + i);
+        }
+    }
+    free(inc);
+    free(best);
+    return n;
+}
+
+/* ========================================================================== */
+/* Selection                                                                   */
+/* ========================================================================== */
+
+int bloom_coins_select(const bloom_coins *pool, const bloom_coins_target *t,
+                       bloom_coin *inputs, bloom_coins_selection *sel) {
+    memset(sel, 0, sizeof(*sel));
+    if (t->amount == 0 || t->max_inputs == 0) return BLOOM_COINS_ERR_INVALID;
+
+    coin_view v;
+    v.amount = pool->amount;
+    v.prefix = pool->prefix;
+    v.input_fee = t->fee_rate * BLOOM_COINS_INPUT_BYTES;
+    v.n = first_at_most(pool->amount, pool->n, v.input_fee);
+
+    uint64_t base = bloom_coins_fee(0, t->n_outputs, t->fee_rate);
+    uint64_t change_cost = t->fee_rate * BLOOM_COINS_OUTPUT_BYTES;
+    uint64_t target = t->amount + base;
+    if (v.n == 0 || eff_sum(&v, 0, v.n) < target) return BLOOM_COINS_ERR_FUNDS;
+
+    uint32_t *idx = (uint32_t *)malloc(2 * ((size_t)t->max_inputs + 1) * sizeof(uint32_t));
+    if (!idx) return BLOOM_COINS_ERR_NOMEM;
+    uint32_t *scratch = idx + t->max_inputs + 1;
+    size_t n = branch_and_bound(&v, target, change_cost + t->min_change, t->max_inputs,
+                                t->time_budget, scratch, idx, &sel->tries);
+    sel->method = BLOOM_COINS_BNB;
+
+    if (n == 0) {
+        int err;
+        n = knapsack(&v, target + change_cost, t->min_change, t->time_budget, idx,
+                     t->max_inputs, &err);
+        if (err != BLOOM_COINS_OK) {
+            free(idx);
+            return err;
+        }
+        sel->method = BLOOM_COINS_KNAPSACK;
+    }
+
+    if (n == 0 || n > t->max_inputs) {
+        /* Fewest inputs: take the largest coins */
+        uint64_t sum = 0;
+        n = 0;
+        while (n < t->max_inputs && n < v.n && sum < target) {
+            sum += eff(&v, n);
+            idx[n] = (uint32_t)n;
+            n++;
+        }
+        if (sum < target) {
+            free(idx);
+            return BLOOM_COINS_ERR_FUNDS;
+        }
+        sel->method = BLOOM_COINS_LARGEST_FIRST;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        inputs[i].outpoint = pool->outpoint[idx[i]];
+        inputs[i].amount = pool->amount[idx[i]];
+        sel->total_in += inputs[i].amount;
+    }
+    free(idx);
+    sel->n_inputs = (uint32_t)n;
+
+    /* Change output only if what it carries is worth keeping */
+    uint64_t fee = bloom_coins_fee(sel->n_inputs, t->n_outputs + 1, t->fee_rate);
+    uint64_t keep = t->min_change ? t->min_change : 1;
+    if (sel->total_in >= t->amount + fee + keep) {
+        sel->change = sel->total_in - t->amount - fee;
+        sel->fee = fee;
+    } else {
+        sel->fee = sel->total_in - t->amount;
+    }
+    return BLOOM_COINS_OK;
+}
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <stdio.h>
+
+static uint64_t test_rng = 0x2545F4914F6CDD1Dull;
+
+static uint64_t test_random(void) {
+    return xorshift(&test_rng);
+}
+
+static void random_coin(bloom_coin *c) {
+    for (int i = 0; i < 32; i += 8) {
+        uint64_t r = test_random();
+        memcpy(c->outpoint.txid + i, &r, 8);
+    }
+    c->outpoint.index = (uint32_t)(test_random() % 4);
+    /* Log-uniform between 10^3 and 10^9 */
+    double e = 3.0 + 6.0 * (double)(test_random() >> 11) / 9007199254740992.0;
+    double a = 1.0;
+    while (e >= 1.0) {
+        a *= 10.0;
+        e -= 1.0;
+    }
+    a *= 1.0 + e * 9.0;
+    c->amount = (uint64_t)a;
+}
+
+/* Checks a selection against the pool and the fee model */
+static int valid_selection(const bloom_coins *pool, const bloom_coins_target *t,
+                           const bloom_coin *in, const bloom_coins_selection *s) {
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < s->n_inputs; i++) {
+        int found = 0;
+        size_t j = first_at_most(pool->amount, pool->n, in[i].amount);
+        for (; j < pool->n && pool->amount[j] == in[i].amount && !found; j++) {
+            found = memcmp(&pool->outpoint[j], &in[i].outpoint, sizeof(bloom_outpoint)) == 0;
+        }
+        for (uint32_t k = 0; k < i && found; k++) {
+            found = memcmp(&in[k].outpoint, &in[i].outpoint, sizeof(bloom_outpoint)) != 0;
+        }
+        if (!found) return 0;
+        total += in[i].amount;
+    }
+    uint32_t outputs = t->n_outputs + (s->change > 0);
+    return s->n_inputs >= 1 && s->n_inputs <= t->max_inputs && total == s->total_in &&
+           total == t->amount + s->fee + s->change &&
+           s->fee >= bloom_coins_fee(s->n_inputs, outputs, t->fee_rate) &&
+           (s->change == 0 || s->change >= t->min_change);
+}
+
+int main(void) {
+    int fail = 0, ok;
+    printf("BloomCoin Coin Selection\n");
+    printf("========================\n\n");
+
+    const size_t N = 100000;
+    bloom_coin *coins = (bloom_coin *)malloc(N * sizeof(bloom_coin));
+    bloom_coin *inputs = (bloom_coin *)malloc(1000 * sizeof(bloom_coin));
+    bloom_coins *pool = bloom_coins_create();
+    for (size_t i = 0; i < N; i++) random_coin(&coins[i]);
+
+    /* Pool in two batches, then spend every 100th coin */
+    {
+        double t0 = now_sec();
+        bloom_coins_add(pool, coins, N / 2);
+        bloom_coins_add(pool, coins + N / 2, N - N / 2);
+        double t_add = now_sec() - t0;
+        bloom_outpoint spent[N / 100];
+        uint64_t total = 0;
+        for (size_t i = 0; i < N; i++) {
+            if (i % 100 == 0) spent[i / 100] = coins[i].outpoint;
+            else total += coins[i].amount;
+        }
+        t0 = now_sec();
+        size_t removed = bloom_coins_remove(pool, spent, N / 100);
+        double t_remove = now_sec() - t0;
+        ok = removed == N / 100 && bloom_coins_count(pool) == N - N / 100 &&
+             bloom_coins_total(pool) == total && bloom_coins_remove(pool, spent, 1) == 0;
+        bloom_coin prev, c;
+        bloom_coins_get(pool, 0, &prev);
+        for (size_t i = 1; i < bloom_coins_count(pool) && ok; i++) {
+            bloom_coins_get(pool, i, &c);
+            ok = c.amount <= prev.amount;
+            prev = c;
+        }
+        printf("pool add / remove:        add %.1f ms, remove %.1f ms  %s\n",
+               t_add * 1e3, t_remove * 1e3, ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    bloom_coins_target t;
+    bloom_coins_selection s;
+    memset(&t, 0, sizeof(t));
+    t.n_outputs = 1;
+    t.fee_rate = 1;
+    t.min_change = 1000;
+    t.max_inputs = 1000;
+    t.time_budget = 0.005;
+
+    /* 5 + 4 pays 9 exactly where largest-first would spend 10 */
+    {
+        bloom_coins *small = bloom_coins_create();
+        bloom_coin few[4];
+        const uint64_t value[4] = { 10000, 7000, 5000, 4000 };
+        for (int i = 0; i < 4; i++) {
+            random_coin(&few[i]);
+            few[i].amount = value[i] + bloom_coins_fee(1, 0, 1) - bloom_coins_fee(0, 0, 1);
+        }
+        bloom_coins_add(small, few, 4);
+        t.amount = 9000 - bloom_coins_fee(0, 1, 1);
+        int st = bloom_coins_select(small, &t, inputs, &s);
+        ok = st == BLOOM_COINS_OK && s.method == BLOOM_COINS_BNB && s.n_inputs == 2 &&
+             s.change == 0 && s.fee == bloom_coins_fee(2, 1, 1) &&
+             inputs[0].amount == few[2].amount && inputs[1].amount == few[3].amount &&
+             valid_selection(small, &t, inputs, &s);
+        printf("exact changeless:         %u inputs, %llu tries  %s\n", s.n_inputs,
+               (unsigned long long)s.tries, ok ? "OK" : "FAIL");
+        fail |= !ok;
+        bloom_coins_destroy(small);
+    }
+
+    /* Random payments */
+    {
+        int n_pay = 200, by[3] = { 0, 0, 0 }, bad = 0;
+        uint64_t fees = 0, ins = 0;
+        double worst = 0, t0 = now_sec();
+        for (int i = 0; i < n_pay; i++) {
+            bloom_coin c = { { { 0 }, 0 }, 0 };
+            bloom_coins_get(pool, test_random() % 5000, &c);
+            t.amount = c.amount / 3 + test_random() % (c.amount + 1) * 4;
+            t.n_outputs = 1 + (uint32_t)(test_random() % 3);
+            double t1 = now_sec();
+            int st = bloom_coins_select(pool, &t, inputs, &s);
+            double dt = now_sec() - t1;
+            if (dt > worst) worst = dt;
+            if (st != BLOOM_COINS_OK || !valid_selection(pool, &t, inputs, &s)) bad++;
+            by[s.method]++;
+            fees += s.fee;
+            ins += s.n_inputs;
+        }
+        double avg = (now_sec() - t0) / n_pay;
+        ok = bad == 0;
+        printf("random payments:          %d bnb, %d knapsack, %d largest-first, "
+               "%.1f inputs, fee %.0f  %s\n", by[0], by[1], by[2], (double)ins / n_pay,
+               (double)fees / n_pay, ok ? "OK" : "FAIL");
+        printf("  select, %zu coins:    %.2f ms average, %.2f ms worst\n",
+               bloom_coins_count(pool), avg * 1e3, worst * 1e3);
+        fail |= !ok;
+        t.n_outputs = 1;
+    }
+
+    /* Input limit forces largest-first; too little value fails */
+    {
+        bloom_coin c = { { { 0 }, 0 }, 0 };
+        bloom_coins_get(pool, 0, &c);
+        t.amount = c.amount * 3;
+        t.max_inputs = 4;
+        int st = bloom_coins_select(pool, &t, inputs, &s);
+        ok = st == BLOOM_COINS_OK && s.n_inputs <= 4 && valid_selection(pool, &t, inputs, &s);
+        t.max_inputs = 2;
+        ok &= bloom_coins_select(pool, &t, inputs, &s) == BLOOM_COINS_ERR_FUNDS;
+        t.max_inputs = 1000;
+        t.amount = bloom_coins_total(pool);
+        ok &= bloom_coins_select(pool, &t, inputs, &s) == BLOOM_COINS_ERR_FUNDS;
+        t.amount = 0;
+        ok &= bloom_coins_select(pool, &t, inputs, &s) == BLOOM_COINS_ERR_INVALID;
+        printf("limits / funds:           %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* select_inputs() sorts the whole UTXO list on every call */
+    {
+        size_t m = bloom_coins_count(pool);
+        bloom_coin *sorted = (bloom_coin *)malloc(m * sizeof(bloom_coin));
+        int reps = 20;
+        double t0 = now_sec();
+        for (int i = 0; i < reps; i++) {
+            for (size_t j = 0; j < m; j++) bloom_coins_get(pool, (j * 7919) % m, &sorted[j]);
+            qsort(sorted, m, sizeof(bloom_coin), by_amount_desc);
+        }
+        printf("  sort per call (C):      %.2f ms\n", (now_sec() - t0) / reps * 1e3);
+        free(sorted);
+    }
+
+    bloom_coins_destroy(pool);
+    free(coins);
+    free(inputs);
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
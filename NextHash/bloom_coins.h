@@ -0,0 +1,118 @@
+/*
+ * BloomCoin Coin Selection
+ * ========================
+ *
+ * Wallet UTXO pool and input selection for TransactionBuilder in
+ * bloomcoin/wallet/signer.py, sized for exchange wallets with 10^5 coins.
+ *
+ * Every coin is valued net of the fee for spending it (its effective
+ * value), so the target does not move as inputs are added. Selection tries,
+ * in order:
+ *   1. branch-and-bound for a changeless input set whose excess is below
+ *      the cost of a change output
+ *   2. knapsack (random subset approximation) for a set with change
+ *   3. largest-first when the knapsack set exceeds max_inputs
+ *
+ * Fees follow TransactionBuilder.estimate_fee():
+ *   fee = fee_rate * (20 + 100 * inputs + 40 * outputs)
+ *
+ * Features:
+ * - Coins kept sorted by amount in flat arrays with prefix sums: range
+ *   sums and cut-offs by binary search, no per-call sorting
+ * - Batched add (sort + merge) and remove (hash set + compaction)
+ * - Branch-and-bound with lookahead pruning and equal-value skipping,
+ *   bounded by tries and a time budget
+ * - Knapsack over a window of the largest coins below the target, so its
+ *   cost does not grow with thousands of dust-sized coins
+ * - Change below min_change is folded into the fee
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef BLOOM_COINS_H
+#define BLOOM_COINS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "bloom_mempool.h"      /* bloom_outpoint */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Serialized size model of estimate_fee() */
+#define BLOOM_COINS_TX_BYTES     20
+#define BLOOM_COINS_INPUT_BYTES  100
+#define BLOOM_COINS_OUTPUT_BYTES 40
+
+/* Search limits */
+#define BLOOM_COINS_BNB_TRIES        100000
+#define BLOOM_COINS_KNAPSACK_ROUNDS  100
+
+/* Selection methods */
+#define BLOOM_COINS_BNB           0
+#define BLOOM_COINS_KNAPSACK      1
+#define BLOOM_COINS_LARGEST_FIRST 2
+
+/* Status codes */
+#define BLOOM_COINS_OK             0
+#define BLOOM_COINS_ERR_NOMEM     -1
+#define BLOOM_COINS_ERR_FUNDS     -2   /* not enough value within max_inputs */
+#define BLOOM_COINS_ERR_INVALID   -3
+
+typedef struct {
+    bloom_outpoint outpoint;
+    uint64_t amount;
+} bloom_coin;
+
+typedef struct {
+    uint64_t amount;            /* sum of recipient outputs */
+    uint32_t n_outputs;         /* recipient outputs, change excluded */
+    uint64_t fee_rate;          /* per byte */
+    uint64_t min_change;        /* smaller change is left to the fee */
+    uint32_t max_inputs;        /* also the capacity of the inputs buffer */
+    double time_budget;         /* seconds per search stage; 0 = tries only */
+} bloom_coins_target;
+
+typedef struct {
+    uint32_t n_inputs;
+    int method;                 /* BLOOM_COINS_BNB, ... */
+    uint64_t total_in;
+    uint64_t fee;               /* total_in - amount - change */
+    uint64_t change;            /* 0 = no change output */
+    uint64_t tries;             /* branch-and-bound steps taken */
+} bloom_coins_selection;
+
+typedef struct bloom_coins bloom_coins;
+
+bloom_coins *bloom_coins_create(void);
+void bloom_coins_destroy(bloom_coins *pool);
+
+/* Add n coins (outpoints must not already be in the pool) */
+int bloom_coins_add(bloom_coins *pool, const bloom_coin *coins, size_t n);
+
+/* Remove spent coins; returns the number found and removed */
+size_t bloom_coins_remove(bloom_coins *pool, const bloom_outpoint *spent, size_t n);
+
+size_t bloom_coins_count(const bloom_coins *pool);
+uint64_t bloom_coins_total(const bloom_coins *pool);
+
+/* Coin i in descending amount order */
+int bloom_coins_get(const bloom_coins *pool, size_t i, bloom_coin *out);
+
+/* estimate_fee() for a transaction shape */
+uint64_t bloom_coins_fee(uint32_t n_inputs, uint32_t n_outputs, uint64_t fee_rate);
+
+/*
+ * Select inputs paying t->amount to t->n_outputs outputs plus fee. inputs
+ * receives up to t->max_inputs coins; sel describes the transaction.
+ */
+int bloom_coins_select(const bloom_coins *pool, const bloom_coins_target *t,
+                       bloom_coin *inputs, bloom_coins_selection *sel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOOM_COINS_H */
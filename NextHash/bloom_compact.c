@@ -0,0 +1,492 @@
+/*
+ * BloomCoin Compact Block Relay
+ * =============================
+ *
+ * Compile: gcc -O3 -c nexthash256.c bloom_sha256.c
+ *          gcc -O3 -c bloom_mempool.c
+ *          gcc -O3 -o bloom_compact bloom_compact.c bloom_mempool.o nexthash256.o bloom_sha256.o -DTEST_MAIN
+ */
+
+#include "bloom_compact.h"
+#include "nexthash256.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Txids hashed per nexthash256_batch() call */
+#define HASH_CHUNK 256
+
+#define SLOT_EMPTY     0xFFFFFFFFu
+#define SLOT_AMBIGUOUS 0xFFFFFFFEu
+
+/* ========================================================================== */
+/* Helpers                                                                     */
+/* ========================================================================== */
+
+static void store32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void store64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint32_t load32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+           (uint32_t)p[3] << 24;
+}
+
+static uint64_t load64(const uint8_t *p) {
+    return (uint64_t)load32(p) | (uint64_t)load32(p + 4) << 32;
+}
+
+static uint64_t load_sid(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = BLOOM_SHORTID_SIZE - 1; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+/* ========================================================================== */
+/* Short IDs                                                                   */
+/* ========================================================================== */
+
+void bloom_compact_key(const uint8_t *header, size_t header_len, uint64_t nonce,
+                       uint8_t key[BLOOM_COMPACT_KEY]) {
+    nexthash256_ctx ctx;
+    uint8_t le[8], digest[32];
+    store64(le, nonce);
+    nexthash256_init(&ctx);
+    nexthash256_update(&ctx, header, header_len);
+    nexthash256_update(&ctx, le, 8);
+    nexthash256_final(&ctx, digest);
+    memcpy(key, digest, BLOOM_COMPACT_KEY);
+}
+
+void bloom_compact_short_ids(const uint8_t key[BLOOM_COMPACT_KEY],
+                             const uint8_t (*txids)[32], size_t n,
+                             uint8_t (*out)[BLOOM_SHORTID_SIZE]) {
+    uint8_t msgs[HASH_CHUNK][BLOOM_COMPACT_KEY + 32];
+    const uint8_t *ptrs[HASH_CHUNK];
+    size_t lens[HASH_CHUNK];
+    uint8_t digests[HASH_CHUNK][32];
+
+    for (size_t i = 0; i < HASH_CHUNK; i++) {
+        memcpy(msgs[i], key, BLOOM_COMPACT_KEY);
+        ptrs[i] = msgs[i];
+        lens[i] = sizeof(msgs[i]);
+    }
+    for (size_t base = 0; base < n; base += HASH_CHUNK) {
+        size_t cnt = n - base < HASH_CHUNK ? n - base : HASH_CHUNK;
+        for (size_t i = 0; i < cnt; i++) {
+            memcpy(msgs[i] + BLOOM_COMPACT_KEY, txids[base + i], 32);
+        }
+        nexthash256_batch(ptrs, lens, cnt, digests);
+        for (size_t i = 0; i < cnt; i++) {
+            memcpy(out[base + i], digests[i], BLOOM_SHORTID_SIZE);
+        }
+    }
+}
+
+/* ========================================================================== */
+/* Encoding                                                                    */
+/* ========================================================================== */
+
+size_t bloom_compact_size(size_t header_len, uint32_t n_tx,
+                          const bloom_prefilled *prefilled, uint32_t n_prefilled) {
+    size_t size = 4 + header_len + 8 + 4 + 4;
+    for (uint32_t i = 0; i < n_prefilled; i++) size += 8 + prefilled[i].len;
+    return size + (size_t)(n_tx - n_prefilled) * BLOOM_SHORTID_SIZE;
+}
+
+long bloom_compact_encode(const uint8_t *header, size_t header_len, uint64_t nonce,
+                          const uint8_t (*txids)[32], uint32_t n_tx,
+                          const bloom_prefilled *prefilled, uint32_t n_prefilled,
+                          uint8_t *out, size_t cap) {
+    if (n_prefilled > n_tx) return BLOOM_COMPACT_ERR_INVALID;
+    for (uint32_t i = 0; i < n_prefilled; i++) {
+        if (prefilled[i].index >= n_tx ||
+            (i > 0 && prefilled[i].index <= prefilled[i - 1].index)) {
+            return BLOOM_COMPACT_ERR_INVALID;
+        }
+    }
+    size_t size = bloom_compact_size(header_len, n_tx, prefilled, n_prefilled);
+    if (size > cap) return BLOOM_COMPACT_ERR_SPACE;
+
+    uint32_t n_short = n_tx - n_prefilled;
+    uint8_t (*ids)[32] = (uint8_t (*)[32])malloc((n_short ? n_short : 1) * 32);
+    if (!ids) return BLOOM_COMPACT_ERR_NOMEM;
+
+    uint8_t *p = out;
+    store32(p, (uint32_t)header_len);
+    memcpy(p + 4, header, header_len);
+    p += 4 + header_len;
+    store64(p, nonce);
+    store32(p + 8, n_tx);
+    store32(p + 12, n_prefilled);
+    p += 16;
+    for (uint32_t i = 0; i < n_prefilled; i++) {
+        store32(p, prefilled[i].index);
+        store32(p + 4, prefilled[i].len);
+        memcpy(p + 8, prefilled[i].tx, prefilled[i].len);
+        p += 8 + prefilled[i].len;
+    }
+
+    /* Short IDs for the slots not carried in full */
+    uint32_t k = 0, pi = 0;
+    for (uint32_t slot = 0; slot < n_tx; slot++) {
+        if (pi < n_prefilled && prefilled[pi].index == slot) {
+            pi++;
+            continue;
+        }
+        memcpy(ids[k++], txids[slot], 32);
+    }
+    uint8_t key[BLOOM_COMPACT_KEY];
+    bloom_compact_key(header, header_len, nonce, key);
+    bloom_compact_short_ids(key, (const uint8_t (*)[32])ids, n_short,
+                            (uint8_t (*)[BLOOM_SHORTID_SIZE])p);
+    free(ids);
+    return (long)size;
+}
+
+int bloom_compact_parse(bloom_compact_view *v, const uint8_t *buf, size_t len) {
+    memset(v, 0, sizeof(*v));
+    if (len < 4) return BLOOM_COMPACT_ERR_TRUNCATED;
+    v->header_len = load32(buf);
+    if (len - 4 < (size_t)v->header_len + 16) return BLOOM_COMPACT_ERR_TRUNCATED;
+    v->header = buf + 4;
+    const uint8_t *p = buf + 4 + v->header_len;
+    v->nonce = load64(p);
+    v->n_tx = load32(p + 8);
+    v->n_prefilled = load32(p + 12);
+    p += 16;
+    if (v->n_prefilled > v->n_tx) return BLOOM_COMPACT_ERR_INVALID;
+
+    const uint8_t *end = buf + len;
+    v->prefilled = p;
+    for (uint32_t i = 0; i < v->n_prefilled; i++) {
+        if ((size_t)(end - p) < 8) return BLOOM_COMPACT_ERR_TRUNCATED;
+        uint32_t index = load32(p), tx_len = load32(p + 4);
+        if (index >= v->n_tx) return BLOOM_COMPACT_ERR_INVALID;
+        if ((size_t)(end - p) - 8 < tx_len) return BLOOM_COMPACT_ERR_TRUNCATED;
+        p += 8 + tx_len;
+    }
+    size_t n_short = (size_t)(v->n_tx - v->n_prefilled);
+    if ((size_t)(end - p) < n_short * BLOOM_SHORTID_SIZE) return BLOOM_COMPACT_ERR_TRUNCATED;
+    v->short_ids = p;
+
+    /* Indices must increase */
+    const uint8_t *q = v->prefilled;
+    uint32_t prev = 0;
+    for (uint32_t i = 0; i < v->n_prefilled; i++) {
+        uint32_t index = load32(q);
+        if (i > 0 && index <= prev) return BLOOM_COMPACT_ERR_INVALID;
+        prev = index;
+        q += 8 + load32(q + 4);
+    }
+
+    bloom_compact_key(v->header, v->header_len, v->nonce, v->key);
+    return BLOOM_COMPACT_OK;
+}
+
+void bloom_compact_prefilled_at(const bloom_compact_view *v, uint32_t i,
+                                bloom_prefilled *out) {
+    const uint8_t *p = v->prefilled;
+    while (i--) p += 8 + load32(p + 4);
+    out->index = load32(p);
+    out->len = load32(p + 4);
+    out->tx = p + 8;
+}
+
+/* ========================================================================== */
+/* Short-ID Index                                                              */
+/* ========================================================================== */
+
+typedef struct {
+    uint64_t sid;
+    uint32_t pos;           /* into txids, SLOT_EMPTY or SLOT_AMBIGUOUS */
+} sid_slot;
+
+struct bloom_shortid_index {
+    sid_slot *slots;
+    uint64_t mask;
+    uint8_t (*txids)[32];
+    size_t n;
+};
+
+/* Short IDs are uniform, so the low bits index the table directly */
+static void index_insert(bloom_shortid_index *idx, uint64_t sid, uint32_t pos) {
+    uint64_t s = sid & idx->mask;
+    for (;;) {
+        sid_slot *e = &idx->slots[s];
+        if (e->pos == SLOT_EMPTY) {
+            e->sid = sid;
+            e->pos = pos;
+            return;
+        }
+        if (e->sid == sid) {
+            /* Same txid twice is harmless; two txids on one ID are not */
+            if (e->pos != SLOT_AMBIGUOUS &&
+                memcmp(idx->txids[e->pos], idx->txids[pos], 32) != 0) {
+                e->pos = SLOT_AMBIGUOUS;
+            }
+            return;
+        }
+        s = (s + 1) & idx->mask;
+    }
+}
+
+static uint32_t index_find(const bloom_shortid_index *idx, uint64_t sid) {
+    uint64_t s = sid & idx->mask;
+    for (;;) {
+        const sid_slot *e = &idx->slots[s];
+        if (e->pos == SLOT_EMPTY) return SLOT_EMPTY;
+        if (e->sid == sid) return e->pos;
+        s = (s + 1) & idx->mask;
+    }
+}
+
+static bloom_shortid_index *index_alloc(size_t n) {
+    bloom_shortid_index *idx = (bloom_shortid_index *)calloc(1, sizeof(*idx));
+    if (!idx) return NULL;
+    size_t cap = 16;
+    while (cap < 2 * n) cap <<= 1;
+    idx->slots = (sid_slot *)malloc(cap * sizeof(sid_slot));
+    idx->txids = (uint8_t (*)[32])malloc((n ? n : 1) * 32);
+    if (!idx->slots || !idx->txids) {
+        bloom_shortid_index_free(idx);
+        return NULL;
+    }
+    memset(idx->slots, 0xFF, cap * sizeof(sid_slot));
+    idx->mask = cap - 1;
+    idx->n = n;
+    return idx;
+}
+
+static bloom_shortid_index *index_fill(bloom_shortid_index *idx,
+                                       const uint8_t key[BLOOM_COMPACT_KEY]) {
+    uint8_t (*sids)[BLOOM_SHORTID_SIZE] =
+        (uint8_t (*)[BLOOM_SHORTID_SIZE])malloc((idx->n ? idx->n : 1) * BLOOM_SHORTID_SIZE);
+    if (!sids) {
+        bloom_shortid_index_free(idx);
+        return NULL;
+    }
+    bloom_compact_short_ids(key, (const uint8_t (*)[32])idx->txids, idx->n, sids);
+    for (size_t i = 0; i < idx->n; i++) {
+        index_insert(idx, load_sid(sids[i]), (uint32_t)i);
+    }
+    free(sids);
+    return idx;
+}
+
+bloom_shortid_index *bloom_shortid_index_build(const uint8_t key[BLOOM_COMPACT_KEY],
+                                               const uint8_t (*txids)[32], size_t n) {
+    bloom_shortid_index *idx = index_alloc(n);
+    if (!idx) return NULL;
+    memcpy(idx->txids, txids, n * 32);
+    return index_fill(idx, key);
+}
+
+bloom_shortid_index *bloom_shortid_index_from_pool(const uint8_t key[BLOOM_COMPACT_KEY],
+                                                   const bloom_mempool *pool) {
+    bloom_shortid_index *idx = index_alloc(bloom_mempool_count(pool));
+    if (!idx) return NULL;
+    idx->n = bloom_mempool_txids(pool, idx->txids, idx->n);
+    return index_fill(idx, key);
+}
+
+void bloom_shortid_index_free(bloom_shortid_index *idx) {
+    if (!idx) return;
+    free(idx->slots);
+    free(idx->txids);
+    free(idx);
+}
+
+/* ========================================================================== */
+/* Reconstruction                                                              */
+/* ========================================================================== */
+
+long bloom_compact_reconstruct(const bloom_compact_view *v,
+                               const bloom_shortid_index *idx,
+                               uint8_t *state, uint8_t (*txids)[32],
+                               uint32_t *missing) {
+    const uint8_t *pf = v->prefilled;
+    uint32_t pi = 0, next_pf = v->n_prefilled ? load32(pf) : UINT32_MAX;
+    const uint8_t *sid = v->short_ids;
+    long n_missing = 0;
+
+    for (uint32_t slot = 0; slot < v->n_tx; slot++) {
+        if (slot == next_pf) {
+            state[slot] = BLOOM_SLOT_PREFILLED;
+            pf += 8 + load32(pf + 4);
+            next_pf = ++pi < v->n_prefilled ? load32(pf) : UINT32_MAX;
+            continue;
+        }
+        /* Probe a few IDs ahead so table misses overlap */
+        if (sid + 8 * BLOOM_SHORTID_SIZE <
+            v->short_ids + (size_t)(v->n_tx - v->n_prefilled) * BLOOM_SHORTID_SIZE) {
+            __builtin_prefetch(&idx->slots[load_sid(sid + 8 * BLOOM_SHORTID_SIZE) & idx->mask]);
+        }
+        uint32_t pos = index_find(idx, load_sid(sid));
+        sid += BLOOM_SHORTID_SIZE;
+        if (pos < SLOT_AMBIGUOUS) {
+            state[slot] = BLOOM_SLOT_FOUND;
+            memcpy(txids[slot], idx->txids[pos], 32);
+        } else {
+            state[slot] = BLOOM_SLOT_MISSING;
+            missing[n_missing++] = slot;
+        }
+    }
+    return n_missing;
+}
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <stdio.h>
+#include <time.h>
+
+static uint64_t test_rng = 0x853C49E6748FEA9Bull;
+
+static uint64_t xorshift(void) {
+    test_rng ^= test_rng << 13;
+    test_rng ^= test_rng >> 7;
+    test_rng ^= test_rng << 17;
+    return test_rng;
+}
+
+static void rand_bytes(uint8_t *p, size_t n) {
+    for (size_t i = 0; i < n; i++) p[i] = (uint8_t)xorshift();
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(void) {
+    int fail = 0;
+    printf("BloomCoin Compact Block Relay\n");
+    printf("=============================\n\n");
+
+    enum { POOL = 20000, BLOCK = 3000, ABSENT = 150, TX_BYTES = 250 };
+    static uint8_t pool_txids[POOL][32];
+    static bloom_outpoint inputs[POOL];
+    rand_bytes(&pool_txids[0][0], sizeof(pool_txids));
+    bloom_mempool *pool = bloom_mempool_create(POOL, (uint64_t)POOL * 1000);
+    for (int i = 0; i < POOL; i++) {
+        bloom_tx_info tx;
+        rand_bytes(inputs[i].txid, 32);
+        inputs[i].index = 0;
+        memcpy(tx.txid, pool_txids[i], 32);
+        tx.fee = 1000 + xorshift() % 1000;
+        tx.size = TX_BYTES;
+        tx.inputs = &inputs[i];
+        tx.n_inputs = 1;
+        bloom_mempool_add(pool, &tx);
+    }
+
+    /* Block: coinbase prefilled, mostly pool txs, some the receiver lacks */
+    static uint8_t block_txids[BLOCK][32];
+    static uint8_t absent[BLOCK];
+    uint8_t coinbase[120];
+    rand_bytes(coinbase, sizeof(coinbase));
+    rand_bytes(block_txids[0], 32);
+    for (int i = 1; i < BLOCK; i++) {
+        if (i % (BLOCK / ABSENT) == 7) {
+            rand_bytes(block_txids[i], 32);
+            absent[i] = 1;
+        } else {
+            memcpy(block_txids[i], pool_txids[(i * 7919) % POOL], 32);
+        }
+    }
+    uint8_t header[92];
+    rand_bytes(header, sizeof(header));
+    bloom_prefilled pf = { 0, coinbase, sizeof(coinbase) };
+
+    size_t cap = bloom_compact_size(sizeof(header), BLOCK, &pf, 1);
+    uint8_t *wire = malloc(cap);
+    long len = bloom_compact_encode(header, sizeof(header), 0x1234567890ull,
+                                    (const uint8_t (*)[32])block_txids, BLOCK,
+                                    &pf, 1, wire, cap);
+    size_t full = sizeof(header) + sizeof(coinbase) + (size_t)(BLOCK - 1) * TX_BYTES;
+    printf("encoded:                  %ld bytes vs ~%zu full (%.1f%%)  %s\n",
+           len, full, 100.0 * len / full, len == (long)cap ? "OK" : "FAIL");
+    fail |= len != (long)cap;
+
+    bloom_compact_view v;
+    int st = bloom_compact_parse(&v, wire, (size_t)len);
+    bloom_prefilled got;
+    bloom_compact_prefilled_at(&v, 0, &got);
+    int ok = st == 0 && v.n_tx == BLOCK && v.n_prefilled == 1 && got.index == 0 &&
+             got.len == sizeof(coinbase) && memcmp(got.tx, coinbase, got.len) == 0;
+    printf("parse:                    %s\n", ok ? "OK" : "FAIL");
+    fail |= !ok;
+
+    {
+        static uint8_t state[BLOCK], out[BLOCK][32];
+        static uint32_t missing[BLOCK];
+        double t0 = now_sec();
+        bloom_shortid_index *idx = bloom_shortid_index_from_pool(v.key, pool);
+        double t1 = now_sec();
+        long nm = bloom_compact_reconstruct(&v, idx, state, out, missing);
+        double t2 = now_sec();
+
+        ok = state[0] == BLOOM_SLOT_PREFILLED;
+        long expect = 0;
+        for (int i = 1; i < BLOCK; i++) {
+            if (absent[i]) {
+                ok &= state[i] == BLOOM_SLOT_MISSING && missing[expect] == (uint32_t)i;
+                expect++;
+            } else {
+                ok &= state[i] == BLOOM_SLOT_FOUND && memcmp(out[i], block_txids[i], 32) == 0;
+            }
+        }
+        ok &= nm == expect;
+        printf("reconstruct:              %ld missing of %d, index %.2f ms, "
+               "lookup %.3f ms  %s\n", nm, BLOCK, 1e3 * (t1 - t0), 1e3 * (t2 - t1),
+               ok ? "OK" : "FAIL");
+        fail |= !ok;
+        bloom_shortid_index_free(idx);
+    }
+
+    /* Colliding short IDs resolve to missing, duplicates do not */
+    {
+        bloom_shortid_index *idx = index_alloc(3);
+        rand_bytes(&idx->txids[0][0], 64);
+        memcpy(idx->txids[2], idx->txids[0], 32);
+        index_insert(idx, 42, 0);
+        index_insert(idx, 42, 2);                   /* same txid */
+        index_insert(idx, 43, 1);
+        ok = index_find(idx, 42) == 0 && index_find(idx, 43) == 1;
+        index_insert(idx, 43, 0);                   /* different txid */
+        ok &= index_find(idx, 43) == SLOT_AMBIGUOUS && index_find(idx, 44) == SLOT_EMPTY;
+        printf("short-ID collisions:      %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+        bloom_shortid_index_free(idx);
+    }
+
+    /* Malformed input */
+    {
+        bloom_prefilled bad[2] = { { 5, coinbase, 4 }, { 5, coinbase, 4 } };
+        ok = bloom_compact_encode(header, sizeof(header), 0, (const uint8_t (*)[32])block_txids,
+                                  BLOCK, bad, 2, wire, cap) == BLOOM_COMPACT_ERR_INVALID;
+        ok &= bloom_compact_encode(header, sizeof(header), 0, (const uint8_t (*)[32])block_txids,
+                                   BLOCK, &pf, 1, wire, 10) == BLOOM_COMPACT_ERR_SPACE;
+        ok &= bloom_compact_parse(&v, wire, 3) == BLOOM_COMPACT_ERR_TRUNCATED;
+        len = bloom_compact_encode(header, sizeof(header), 0, (const uint8_t (*)[32])block_txids,
+                                   BLOCK, &pf, 1, wire, cap);
+        ok &= bloom_compact_parse(&v, wire, (size_t)len - 1) == BLOOM_COMPACT_ERR_TRUNCATED;
+        store32(wire + 4 + sizeof(header) + 16, BLOCK);         /* prefilled index */
+        ok &= bloom_compact_parse(&v, wire, (size_t)len) == BLOOM_COMPACT_ERR_INVALID;
+        printf("malformed input:          %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    free(wire);
+    bloom_mempool_destroy(pool);
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
@@ -0,0 +1,125 @@
+/*
+ * BloomCoin Compact Block Relay
+ * =============================
+ *
+ * Blocks announced as header + 6-byte short transaction IDs instead of
+ * full transactions (network/node.py _handle_block). The receiver rebuilds
+ * the block from its mempool and requests only what it lacks.
+ *
+ * Features:
+ * - Per-block key: NEXTHASH-256(header || nonce LE)[0..15]
+ * - Short ID: NEXTHASH-256(key || txid)[0..5], hashed in batches
+ * - Prefilled transactions (the coinbase, anything the sender expects
+ *   peers to miss) carried in full
+ * - Short-ID index over the mempool's txids, built in one batched pass;
+ *   colliding short IDs resolve to "missing" rather than a wrong txid
+ *
+ * Wire format (little-endian):
+ *   header_len u32 | header | nonce u64 | n_tx u32 | n_prefilled u32 |
+ *   { index u32 | len u32 | tx bytes } * n_prefilled |
+ *   short_id[6] * (n_tx - n_prefilled)      (slots in block order)
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef BLOOM_COMPACT_H
+#define BLOOM_COMPACT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "bloom_mempool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLOOM_SHORTID_SIZE 6
+#define BLOOM_COMPACT_KEY  16
+
+/* Status codes */
+#define BLOOM_COMPACT_OK              0
+#define BLOOM_COMPACT_ERR_TRUNCATED  -1   /* buffer shorter than declared */
+#define BLOOM_COMPACT_ERR_INVALID    -2   /* bad prefilled index */
+#define BLOOM_COMPACT_ERR_NOMEM      -3
+#define BLOOM_COMPACT_ERR_SPACE      -4   /* output buffer too small */
+
+/* Slot states after reconstruction */
+#define BLOOM_SLOT_PREFILLED 0
+#define BLOOM_SLOT_FOUND     1
+#define BLOOM_SLOT_MISSING   2
+
+typedef struct {
+    uint32_t index;             /* slot in the block */
+    const uint8_t *tx;
+    uint32_t len;
+} bloom_prefilled;
+
+/* Parsed compact block; pointers alias the source buffer */
+typedef struct {
+    const uint8_t *header;
+    uint32_t header_len;
+    uint64_t nonce;
+    uint32_t n_tx;
+    uint32_t n_prefilled;
+    const uint8_t *prefilled;   /* first prefilled record */
+    const uint8_t *short_ids;   /* (n_tx - n_prefilled) * 6 bytes */
+    uint8_t key[BLOOM_COMPACT_KEY];
+} bloom_compact_view;
+
+/* Short-ID index over a set of txids for one block key */
+typedef struct bloom_shortid_index bloom_shortid_index;
+
+/* Per-block key */
+void bloom_compact_key(const uint8_t *header, size_t header_len, uint64_t nonce,
+                       uint8_t key[BLOOM_COMPACT_KEY]);
+
+/* Short IDs of n txids (batched) */
+void bloom_compact_short_ids(const uint8_t key[BLOOM_COMPACT_KEY],
+                             const uint8_t (*txids)[32], size_t n,
+                             uint8_t (*out)[BLOOM_SHORTID_SIZE]);
+
+/* Bytes needed by bloom_compact_encode() */
+size_t bloom_compact_size(size_t header_len, uint32_t n_tx,
+                          const bloom_prefilled *prefilled, uint32_t n_prefilled);
+
+/*
+ * Serialize a compact block. txids[n_tx] in block order; prefilled sorted
+ * by index. Returns bytes written or a negative status code.
+ */
+long bloom_compact_encode(const uint8_t *header, size_t header_len, uint64_t nonce,
+                          const uint8_t (*txids)[32], uint32_t n_tx,
+                          const bloom_prefilled *prefilled, uint32_t n_prefilled,
+                          uint8_t *out, size_t cap);
+
+/* Parse and validate; also derives the block key */
+int bloom_compact_parse(bloom_compact_view *v, const uint8_t *buf, size_t len);
+
+/* Prefilled record i of a parsed view */
+void bloom_compact_prefilled_at(const bloom_compact_view *v, uint32_t i,
+                                bloom_prefilled *out);
+
+bloom_shortid_index *bloom_shortid_index_build(const uint8_t key[BLOOM_COMPACT_KEY],
+                                               const uint8_t (*txids)[32], size_t n);
+
+/* Index of the pool's current contents */
+bloom_shortid_index *bloom_shortid_index_from_pool(const uint8_t key[BLOOM_COMPACT_KEY],
+                                                   const bloom_mempool *pool);
+
+void bloom_shortid_index_free(bloom_shortid_index *idx);
+
+/*
+ * Resolve every slot. state[n_tx] gets BLOOM_SLOT_*; txids[n_tx] is set for
+ * FOUND slots; missing[] receives the slot indices to request. Returns the
+ * number of missing slots or a negative status code.
+ */
+long bloom_compact_reconstruct(const bloom_compact_view *v,
+                               const bloom_shortid_index *idx,
+                               uint8_t *state, uint8_t (*txids)[32],
+                               uint32_t *missing);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOOM_COMPACT_H */
@@ -0,0 +1,526 @@
+/*
+ * BloomCoin Phase Correlation Engine
+ * ==================================
+ *
+ * Compile: gcc -O3 -mavx2 -mfma -fopenmp -o bloom_corr bloom_corr.c -lm -DTEST_MAIN
+ */
+
+#include "bloom_corr.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define T BLOOM_CORR_TILE
+
+/* ========================================================================== */
+/* Tile Storage                                                                */
+/* ========================================================================== */
+
+/* Offset of tile (I, J), I <= J, in the upper-triangle tile array */
+static inline size_t tile_index(const bloom_corr *c, uint32_t I, uint32_t J) {
+    size_t nt = c->n_tiles;
+    return (size_t)I * nt - (size_t)I * (I - 1) / 2 + (J - I);
+}
+
+static inline float *tile_at(const bloom_corr *c, uint32_t I, uint32_t J) {
+    return c->sum + tile_index(c, I, J) * (T * T);
+}
+
+int bloom_corr_init(bloom_corr *c, uint32_t n) {
+    memset(c, 0, sizeof(*c));
+    if (n == 0) {
+        return -1;
+    }
+    c->n = n;
+    c->n_tiles = (n + T - 1) / T;
+    c->n_pad = c->n_tiles * T;
+
+    size_t tiles = (size_t)c->n_tiles * (c->n_tiles + 1) / 2;
+    c->sum = (float *)calloc(tiles * T * T, sizeof(float));
+    c->feat = (float *)calloc((size_t)2 * BLOOM_CORR_BATCH * c->n_pad, sizeof(float));
+    if (!c->sum || !c->feat) {
+        bloom_corr_free(c);
+        return -1;
+    }
+    return 0;
+}
+
+void bloom_corr_free(bloom_corr *c) {
+    free(c->sum);
+    free(c->feat);
+    memset(c, 0, sizeof(*c));
+}
+
+void bloom_corr_reset(bloom_corr *c) {
+    size_t tiles = (size_t)c->n_tiles * (c->n_tiles + 1) / 2;
+    memset(c->sum, 0, tiles * T * T * sizeof(float));
+    c->steps = 0;
+    c->pending = 0;
+}
+
+/* ========================================================================== */
+/* Accumulation                                                                */
+/* ========================================================================== */
+
+/*
+ * S += sum_r f_r[I-block]^T f_r[J-block] over the pending cos and sin rows.
+ * The inner loop runs along a contiguous tile row and vectorizes.
+ */
+static void tile_update(bloom_corr *c, uint32_t I, uint32_t J) {
+    float *restrict S = tile_at(c, I, J);
+    const size_t stride = c->n_pad;
+    const uint32_t p = c->pending;
+
+    for (uint32_t a = 0; a < T; a++) {
+        float *restrict row = S + (size_t)a * T;
+        for (uint32_t r = 0; r < p; r++) {
+            const float *fc = c->feat + (size_t)r * stride;
+            const float *fs = c->feat + (size_t)(BLOOM_CORR_BATCH + r) * stride;
+            const float ci = fc[(size_t)I * T + a];
+            const float si = fs[(size_t)I * T + a];
+            const float *restrict cj = fc + (size_t)J * T;
+            const float *restrict sj = fs + (size_t)J * T;
+            for (uint32_t b = 0; b < T; b++) {
+                row[b] += ci * cj[b] + si * sj[b];
+            }
+        }
+    }
+}
+
+void bloom_corr_flush(bloom_corr *c) {
+    if (c->pending == 0) {
+        return;
+    }
+    int64_t nt = c->n_tiles;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int64_t I = 0; I < nt; I++) {
+        for (int64_t J = I; J < nt; J++) {
+            tile_update(c, (uint32_t)I, (uint32_t)J);
+        }
+    }
+    c->steps += c->pending;
+    c->pending = 0;
+}
+
+void bloom_corr_push(bloom_corr *c, const float *phases) {
+    float *fc = c->feat + (size_t)c->pending * c->n_pad;
+    float *fs = c->feat + (size_t)(BLOOM_CORR_BATCH + c->pending) * c->n_pad;
+    for (uint32_t i = 0; i < c->n; i++) {
+        fc[i] = cosf(phases[i]);
+        fs[i] = sinf(phases[i]);
+    }
+    if (++c->pending == BLOOM_CORR_BATCH) {
+        bloom_corr_flush(c);
+    }
+}
+
+void bloom_corr_push_many(bloom_corr *c, const float *phases, size_t steps) {
+    for (size_t t = 0; t < steps; t++) {
+        bloom_corr_push(c, phases + t * c->n);
+    }
+}
+
+/* ========================================================================== */
+/* Readout                                                                     */
+/* ========================================================================== */
+
+static inline float raw_sum(const bloom_corr *c, uint32_t i, uint32_t j) {
+    if (i > j) {
+        uint32_t t = i;
+        i = j;
+        j = t;
+    }
+    return tile_at(c, i / T, j / T)[(i % T) * T + (j % T)];
+}
+
+float bloom_corr_get(bloom_corr *c, uint32_t i, uint32_t j) {
+    bloom_corr_flush(c);
+    return c->steps ? raw_sum(c, i, j) / (float)c->steps : 0.0f;
+}
+
+void bloom_corr_row(bloom_corr *c, uint32_t i, float *out) {
+    bloom_corr_flush(c);
+    float inv = c->steps ? 1.0f / (float)c->steps : 0.0f;
+    for (uint32_t j = 0; j < c->n; j++) {
+        out[j] = raw_sum(c, i, j) * inv;
+    }
+}
+
+void bloom_corr_matrix(bloom_corr *c, float *out) {
+    bloom_corr_flush(c);
+    float inv = c->steps ? 1.0f / (float)c->steps : 0.0f;
+    uint32_t n = c->n;
+    for (uint32_t I = 0; I < c->n_tiles; I++) {
+        for (uint32_t J = I; J < c->n_tiles; J++) {
+            const float *S = tile_at(c, I, J);
+            for (uint32_t a = 0; a < T && I * T + a < n; a++) {
+                for (uint32_t b = 0; b < T && J * T + b < n; b++) {
+                    float v = S[a * T + b] * inv;
+                    uint32_t i = I * T + a, j = J * T + b;
+                    out[(size_t)i * n + j] = v;
+                    out[(size_t)j * n + i] = v;
+                }
+            }
+        }
+    }
+}
+
+/* ========================================================================== */
+/* Union-Find                                                                  */
+/* ========================================================================== */
+
+/* Find with path halving; concurrent halving writes only shorten paths */
+static uint32_t uf_find(uint32_t *parent, uint32_t x) {
+    for (;;) {
+        uint32_t p = __atomic_load_n(&parent[x], __ATOMIC_RELAXED);
+        if (p == x) {
+            return x;
+        }
+        uint32_t gp = __atomic_load_n(&parent[p], __ATOMIC_RELAXED);
+        if (gp != p) {
+            __atomic_compare_exchange_n(&parent[x], &p, gp, 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        }
+        x = gp;
+    }
+}
+
+/* Link larger root under smaller; retry if another thread moved a root */
+static void uf_union(uint32_t *parent, uint32_t a, uint32_t b) {
+    for (;;) {
+        a = uf_find(parent, a);
+        b = uf_find(parent, b);
+        if (a == b) {
+            return;
+        }
+        if (a < b) {
+            uint32_t t = a;
+            a = b;
+            b = t;
+        }
+        uint32_t expect = a;
+        if (__atomic_compare_exchange_n(&parent[a], &expect, b, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            return;
+        }
+    }
+}
+
+/* Roots to 0..k-1 in order of first member */
+static uint32_t uf_labels(uint32_t *parent, uint32_t n, uint32_t *labels) {
+    uint32_t k = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        labels[i] = UINT32_MAX;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t r = uf_find(parent, i);
+        if (labels[r] == UINT32_MAX) {
+            labels[r] = k++;
+        }
+        labels[i] = labels[r];
+    }
+    return k;
+}
+
+uint32_t bloom_corr_clusters(bloom_corr *c, float min_corr, uint32_t *labels) {
+    bloom_corr_flush(c);
+    uint32_t n = c->n;
+    uint32_t *parent = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+    if (!parent) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        parent[i] = i;
+    }
+
+    /* Compare raw sums against min_corr * steps: no division per pair */
+    const float thr = min_corr * (float)c->steps;
+    int64_t nt = c->n_tiles;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int64_t I = 0; I < nt; I++) {
+        for (int64_t J = I; J < nt; J++) {
+            const float *S = tile_at(c, (uint32_t)I, (uint32_t)J);
+            for (uint32_t a = 0; a < T; a++) {
+                uint32_t i = (uint32_t)I * T + a;
+                if (i >= n) {
+                    break;
+                }
+                uint32_t b0 = (I == J) ? a + 1 : 0;
+                for (uint32_t b = b0; b < T; b++) {
+                    uint32_t j = (uint32_t)J * T + b;
+                    if (j >= n) {
+                        break;
+                    }
+                    if (S[a * T + b] >= thr) {
+                        uf_union(parent, i, j);
+                    }
+                }
+            }
+        }
+    }
+
+    uint32_t k = uf_labels(parent, n, labels);
+    free(parent);
+    return k;
+}
+
+/* ========================================================================== */
+/* Single-Snapshot Clustering                                                  */
+/* ========================================================================== */
+
+typedef struct {
+    float phase;
+    uint32_t idx;
+} phase_item;
+
+static int cmp_phase(const void *a, const void *b) {
+    const phase_item *x = (const phase_item *)a, *y = (const phase_item *)b;
+    if (x->phase != y->phase) {
+        return x->phase < y->phase ? -1 : 1;
+    }
+    return (x->idx > y->idx) - (x->idx < y->idx);
+}
+
+/*
+ * On a circle, single-linkage components are the arcs left after cutting
+ * every gap between sorted neighbours wider than max_dist * pi.
+ */
+uint32_t bloom_phase_clusters(const float *phases, uint32_t n, float max_dist,
+                              uint32_t *labels) {
+    if (n == 0) {
+        return 0;
+    }
+    const float two_pi = 6.28318530717958647692f;
+    const float pi = 3.14159265358979323846f;
+    phase_item *items = (phase_item *)malloc((size_t)n * sizeof(phase_item));
+    uint32_t *parent = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+    if (!items || !parent) {
+        free(items);
+        free(parent);
+        return 0;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        float p = fmodf(phases[i], two_pi);
+        items[i].phase = p < 0.0f ? p + two_pi : p;
+        items[i].idx = i;
+        parent[i] = i;
+    }
+    qsort(items, n, sizeof(phase_item), cmp_phase);
+
+    const float cut = max_dist * pi;
+    for (uint32_t k = 0; k < n; k++) {
+        uint32_t next = k + 1 < n ? k + 1 : 0;
+        if (next == k) {
+            break;
+        }
+        float gap = items[next].phase - items[k].phase;
+        if (next == 0) {
+            gap += two_pi;
+        }
+        if (gap > pi) {
+            gap = two_pi - gap;
+        }
+        if (gap <= cut) {
+            uf_union(parent, items[k].idx, items[next].idx);
+        }
+    }
+
+    uint32_t k = uf_labels(parent, n, labels);
+    free(items);
+    free(parent);
+    return k;
+}
+
+#undef T
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <stdio.h>
+#include <time.h>
+
+static uint64_t test_rng = 0x2545F4914F6CDD1Dull;
+
+static double urand(void) {
+    test_rng ^= test_rng << 13;
+    test_rng ^= test_rng >> 7;
+    test_rng ^= test_rng << 17;
+    return (double)(test_rng >> 11) / 9007199254740992.0;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Phases for `groups` coherent groups drifting at different rates */
+static void make_history(float *h, uint32_t n, uint32_t steps, uint32_t groups,
+                         double noise) {
+    for (uint32_t t = 0; t < steps; t++) {
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t g = i % groups;
+            double base = 0.3 * t * (g + 1) + 1.7 * g;
+            h[(size_t)t * n + i] = (float)(base + noise * (urand() - 0.5));
+        }
+    }
+}
+
+/* Same partition up to relabelling (labels are first-member ordered) */
+static int same_labels(const uint32_t *a, const uint32_t *b, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        if (a[i] != b[i]) return 0;
+    }
+    return 1;
+}
+
+/* Brute-force single linkage */
+static uint32_t ref_linkage(const float *M, uint32_t n, float thr, int ge,
+                            uint32_t *labels) {
+    uint32_t *parent = malloc(n * sizeof(uint32_t));
+    for (uint32_t i = 0; i < n; i++) parent[i] = i;
+    for (uint32_t i = 0; i < n; i++) {
+        for (uint32_t j = i + 1; j < n; j++) {
+            float v = M[(size_t)i * n + j];
+            if (ge ? v >= thr : v <= thr) uf_union(parent, i, j);
+        }
+    }
+    uint32_t k = uf_labels(parent, n, labels);
+    free(parent);
+    return k;
+}
+
+int main(void) {
+    int fail = 0;
+    printf("BloomCoin Phase Correlation Engine\n");
+    printf("==================================\n\n");
+
+    /* Matrix vs direct mean cos(theta_i - theta_j) */
+    {
+        const uint32_t n = 203, steps = 37;
+        float *h = malloc((size_t)n * steps * sizeof(float));
+        float *M = malloc((size_t)n * n * sizeof(float));
+        make_history(h, n, steps, 5, 2.0);
+
+        bloom_corr c;
+        bloom_corr_init(&c, n);
+        bloom_corr_push_many(&c, h, steps);
+        bloom_corr_matrix(&c, M);
+
+        double max_err = 0.0;
+        for (uint32_t i = 0; i < n; i++) {
+            for (uint32_t j = 0; j < n; j++) {
+                double s = 0.0;
+                for (uint32_t t = 0; t < steps; t++) {
+                    s += cos((double)h[(size_t)t * n + i] - h[(size_t)t * n + j]);
+                }
+                double e = fabs(s / steps - M[(size_t)i * n + j]);
+                if (e > max_err) max_err = e;
+            }
+        }
+        printf("matrix vs reference:      max err %.2e  %s\n", max_err,
+               max_err < 1e-5 ? "OK" : "FAIL");
+        fail |= !(max_err < 1e-5);
+
+        float g = bloom_corr_get(&c, 17, 150);
+        int ok = fabsf(g - M[17 * n + 150]) < 1e-7f;
+        printf("get / row consistency:    %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+
+        /* Clusters match brute-force linkage on the same matrix */
+        uint32_t *la = malloc(n * sizeof(uint32_t)), *lb = malloc(n * sizeof(uint32_t));
+        uint32_t ka = bloom_corr_clusters(&c, 0.5f, la);
+        uint32_t kb = ref_linkage(M, n, 0.5f, 1, lb);
+        ok = ka == kb && same_labels(la, lb, n);
+        printf("corr clusters:            %u (ref %u)  %s\n", ka, kb, ok ? "OK" : "FAIL");
+        fail |= !ok;
+
+        /* Single snapshot: sorted gaps == brute-force on phase distance */
+        const float *snap = h + (size_t)(steps - 1) * n;
+        for (uint32_t i = 0; i < n; i++) {
+            for (uint32_t j = 0; j < n; j++) {
+                float pi_ = fmodf(snap[i], 6.2831853f), pj = fmodf(snap[j], 6.2831853f);
+                float d = fabsf(pi_ - pj);
+                d = fminf(d, 6.2831853f - d);
+                M[(size_t)i * n + j] = d / 3.14159265f;
+            }
+        }
+        int all = 1;
+        for (float md = 0.02f; md < 0.6f; md += 0.07f) {
+            ka = bloom_phase_clusters(snap, n, md, la);
+            kb = ref_linkage(M, n, md, 0, lb);
+            all &= ka == kb && same_labels(la, lb, n);
+        }
+        printf("phase clusters:           %s\n", all ? "OK" : "FAIL");
+        fail |= !all;
+
+        bloom_corr_free(&c);
+        free(h); free(M); free(la); free(lb);
+    }
+
+    /* Streaming: pushes across resets and partial batches */
+    {
+        const uint32_t n = 130;
+        float *h = malloc((size_t)n * 50 * sizeof(float));
+        make_history(h, n, 50, 3, 1.0);
+        bloom_corr a, b;
+        bloom_corr_init(&a, n);
+        bloom_corr_init(&b, n);
+        bloom_corr_push_many(&a, h, 50);
+        for (uint32_t t = 0; t < 50; t++) {
+            bloom_corr_push(&b, h + (size_t)t * n);
+            if (t % 7 == 0) (void)bloom_corr_get(&b, 0, 1);   /* forces flush */
+        }
+        float ra[130], rb[130];
+        bloom_corr_row(&a, 77, ra);
+        bloom_corr_row(&b, 77, rb);
+        double max_err = 0.0;
+        for (uint32_t j = 0; j < n; j++) {
+            double e = fabs(ra[j] - rb[j]);
+            if (e > max_err) max_err = e;
+        }
+        printf("streaming flushes:        max err %.2e  %s\n", max_err,
+               max_err < 1e-6 ? "OK" : "FAIL");
+        fail |= !(max_err < 1e-6);
+        bloom_corr_free(&a);
+        bloom_corr_free(&b);
+        free(h);
+    }
+
+    /* Throughput */
+    {
+        const uint32_t n = 8192, steps = 64;
+        float *h = malloc((size_t)n * steps * sizeof(float));
+        uint32_t *labels = malloc(n * sizeof(uint32_t));
+        make_history(h, n, steps, 8, 0.5);
+        bloom_corr c;
+        bloom_corr_init(&c, n);
+        double t0 = now_sec();
+        bloom_corr_push_many(&c, h, steps);
+        bloom_corr_flush(&c);
+        double t_acc = now_sec() - t0;
+        t0 = now_sec();
+        uint32_t k = bloom_corr_clusters(&c, 0.9f, labels);
+        double t_cl = now_sec() - t0;
+        printf("\nN=%u, %u snapshots: %.1f ms/snapshot (%.1f GFLOP/s), "
+               "clusters %u in %.0f ms  %s\n",
+               n, steps, 1e3 * t_acc / steps,
+               (double)c.n_tiles * (c.n_tiles + 1) / 2 * BLOOM_CORR_TILE *
+               BLOOM_CORR_TILE * 4.0 * steps / t_acc / 1e9, k, 1e3 * t_cl,
+               k == 8 ? "OK" : "FAIL");
+        fail |= k != 8;
+        bloom_corr_free(&c);
+        free(h);
+        free(labels);
+    }
+
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
@@ -0,0 +1,88 @@
+/*
+ * BloomCoin Phase Correlation Engine
+ * ==================================
+ *
+ * Streaming circular phase correlation and cluster detection for large
+ * oscillator populations, mirroring compute_phase_correlation_matrix()
+ * and identify_clusters() in analysis/multi_body.py.
+ *
+ * Features:
+ * - corr[i][j] = mean_t cos(theta_i - theta_j), accumulated as
+ *   cos*cos + sin*sin rank updates over cache-sized tiles
+ * - Upper-triangle tile storage (half the memory of a dense matrix)
+ * - Snapshots can be pushed one at a time as the simulation runs
+ * - Clusters via lock-free union-find over thresholded correlations
+ *   (OpenMP over tiles when enabled)
+ * - Single-snapshot phase clustering by sorted circular gaps
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef BLOOM_CORR_H
+#define BLOOM_CORR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLOOM_CORR_TILE  64     /* tile edge, oscillators */
+#define BLOOM_CORR_BATCH 16     /* snapshots buffered per tile pass */
+
+typedef struct {
+    uint32_t n;             /* oscillators */
+    uint32_t n_pad;         /* n rounded up to BLOOM_CORR_TILE */
+    uint32_t n_tiles;       /* tiles per edge */
+    uint64_t steps;         /* snapshots accumulated */
+
+    float *sum;             /* upper-triangle tiles, TILE*TILE floats each */
+    float *feat;            /* pending [2*BATCH][n_pad]: cos rows, sin rows */
+    uint32_t pending;       /* snapshots in feat */
+} bloom_corr;
+
+int bloom_corr_init(bloom_corr *c, uint32_t n);
+void bloom_corr_free(bloom_corr *c);
+
+/* Forget all snapshots */
+void bloom_corr_reset(bloom_corr *c);
+
+/* Add one phase snapshot (n values) */
+void bloom_corr_push(bloom_corr *c, const float *phases);
+
+/* Add `steps` snapshots laid out [step][oscillator] */
+void bloom_corr_push_many(bloom_corr *c, const float *phases, size_t steps);
+
+/* Fold buffered snapshots into the tiles (done implicitly by readers) */
+void bloom_corr_flush(bloom_corr *c);
+
+/* Mean correlation of one pair (0 before any snapshot) */
+float bloom_corr_get(bloom_corr *c, uint32_t i, uint32_t j);
+
+/* Row i of the correlation matrix into out[n] */
+void bloom_corr_row(bloom_corr *c, uint32_t i, float *out);
+
+/* Dense n x n matrix, as compute_phase_correlation_matrix() */
+void bloom_corr_matrix(bloom_corr *c, float *out);
+
+/*
+ * Single-linkage clusters: i and j are joined when corr >= min_corr.
+ * labels[n] receives cluster ids 0..k-1 in order of first member.
+ * Returns k.
+ */
+uint32_t bloom_corr_clusters(bloom_corr *c, float min_corr, uint32_t *labels);
+
+/*
+ * Clusters of one snapshot by circular phase distance / pi <= max_dist
+ * (single linkage, O(n log n)). Returns the number of clusters.
+ */
+uint32_t bloom_phase_clusters(const float *phases, uint32_t n, float max_dist,
+                              uint32_t *labels);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOOM_CORR_H */
@@ -0,0 +1,504 @@
+/*
+ * BloomCoin Compact Block Filters
+ * ===============================
+ *
+ * Compile: gcc -O3 -c nexthash256.c
+ *          gcc -O3 -o bloom_filter bloom_filter.c nexthash256.o -DTEST_MAIN
+ */
+
+#include "bloom_filter.h"
+#include "nexthash256.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Items hashed per nexthash256_batch() call */
+#define HASH_CHUNK 256
+
+/* ========================================================================== */
+/* Element Hashing                                                             */
+/* ========================================================================== */
+
+static uint64_t load_le64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+/* Position in [0, range) by multiply-shift (monotonic in h) */
+static uint64_t map_range(uint64_t h, uint64_t range) {
+    return (uint64_t)(((unsigned __int128)h * range) >> 64);
+}
+
+/* out[i] = first 8 bytes (LE) of NEXTHASH-256(key || items[i]) */
+static int hash_items(const uint8_t block_hash[32], const uint8_t *const *items,
+                      const size_t *lens, size_t n, uint64_t *out) {
+    const uint8_t *ptrs[HASH_CHUNK];
+    size_t mlens[HASH_CHUNK];
+    uint8_t digests[HASH_CHUNK][32];
+    uint8_t *buf = NULL;
+    size_t cap = 0;
+
+    for (size_t base = 0; base < n; base += HASH_CHUNK) {
+        size_t cnt = n - base < HASH_CHUNK ? n - base : HASH_CHUNK;
+        size_t need = 0;
+        for (size_t i = 0; i < cnt; i++) need += BLOOM_FILTER_KEY + lens[base + i];
+        if (need > cap) {
+            uint8_t *nb = (uint8_t *)realloc(buf, need);
+            if (!nb) {
+                free(buf);
+                return BLOOM_FILTER_ERR_NOMEM;
+            }
+            buf = nb;
+            cap = need;
+        }
+        size_t off = 0;
+        for (size_t i = 0; i < cnt; i++) {
+            size_t len = lens[base + i];
+            memcpy(buf + off, block_hash, BLOOM_FILTER_KEY);
+            memcpy(buf + off + BLOOM_FILTER_KEY, items[base + i], len);
+            ptrs[i] = buf + off;
+            mlens[i] = BLOOM_FILTER_KEY + len;
+            off += mlens[i];
+        }
+        nexthash256_batch(ptrs, mlens, cnt, digests);
+        for (size_t i = 0; i < cnt; i++) out[base + i] = load_le64(digests[i]);
+    }
+    free(buf);
+    return BLOOM_FILTER_OK;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* ========================================================================== */
+/* Golomb-Rice Coding                                                          */
+/* ========================================================================== */
+
+typedef struct {
+    uint8_t *p;
+    size_t pos;
+    uint64_t acc;
+    unsigned bits;          /* pending bits in acc */
+} bit_writer;
+
+/* Append the low k (<= 32) bits of v, MSB first */
+static void put_bits(bit_writer *w, uint64_t v, unsigned k) {
+    w->acc = (w->acc << k) | v;
+    w->bits += k;
+    while (w->bits >= 8) {
+        w->bits -= 8;
+        w->p[w->pos++] = (uint8_t)(w->acc >> w->bits);
+    }
+}
+
+static void put_golomb(bit_writer *w, uint64_t x) {
+    uint64_t q = x >> BLOOM_FILTER_P;
+    while (q >= 31) {
+        put_bits(w, 0x7FFFFFFF, 31);
+        q -= 31;
+    }
+    put_bits(w, ((1ull << q) - 1) << 1, (unsigned)q + 1);     /* q ones, a zero */
+    put_bits(w, x & ((1ull << BLOOM_FILTER_P) - 1), BLOOM_FILTER_P);
+}
+
+typedef struct {
+    const uint8_t *p;
+    size_t size;
+    size_t bit;
+} bit_reader;
+
+/* Next 64 bits of the stream from the cursor, zero past the end */
+static uint64_t peek64(const bit_reader *r) {
+    size_t byte = r->bit >> 3;
+    uint64_t v = 0;
+    if (byte + 8 <= r->size) {
+        for (int i = 0; i < 8; i++) v = (v << 8) | r->p[byte + i];
+        uint8_t next = byte + 8 < r->size ? r->p[byte + 8] : 0;
+        unsigned sh = r->bit & 7;
+        return sh ? (v << sh) | (next >> (8 - sh)) : v;
+    }
+    for (int i = 0; i < 9; i++) {
+        uint8_t b = byte + i < r->size ? r->p[byte + i] : 0;
+        if (i < 8) v = (v << 8) | b;
+        else if (r->bit & 7) v = (v << (r->bit & 7)) | (b >> (8 - (r->bit & 7)));
+    }
+    return v;
+}
+
+/* Decode one value; returns 0 or ERR_TRUNCATED */
+static int get_golomb(bit_reader *r, uint64_t *x) {
+    uint64_t q = 0;
+    for (;;) {
+        uint64_t v = peek64(r);
+        if (~v == 0) {
+            q += 64;
+            r->bit += 64;
+            if (r->bit > r->size * 8) return BLOOM_FILTER_ERR_TRUNCATED;
+            continue;
+        }
+        unsigned ones = (unsigned)__builtin_clzll(~v);
+        q += ones;
+        r->bit += ones + 1;
+        break;
+    }
+    uint64_t rem = peek64(r) >> (64 - BLOOM_FILTER_P);
+    r->bit += BLOOM_FILTER_P;
+    if (r->bit > r->size * 8) return BLOOM_FILTER_ERR_TRUNCATED;
+    *x = (q << BLOOM_FILTER_P) | rem;
+    return BLOOM_FILTER_OK;
+}
+
+/* ========================================================================== */
+/* Construction                                                                */
+/* ========================================================================== */
+
+int bloom_filter_build(bloom_filter *f, const uint8_t block_hash[32],
+                       const uint8_t *const *items, const size_t *lens, size_t n) {
+    memset(f, 0, sizeof(*f));
+    uint64_t *h = (uint64_t *)malloc((n ? n : 1) * sizeof(uint64_t));
+    if (!h) return BLOOM_FILTER_ERR_NOMEM;
+    int st = hash_items(block_hash, items, lens, n, h);
+    if (st != BLOOM_FILTER_OK) {
+        free(h);
+        return st;
+    }
+
+    /* Duplicate items collapse before N is fixed */
+    qsort(h, n, sizeof(uint64_t), cmp_u64);
+    size_t u = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (u == 0 || h[i] != h[u - 1]) h[u++] = h[i];
+    }
+
+    /* Sum of quotients <= N * M / 2^P < 1.5 N */
+    size_t cap = 4 + (u * (BLOOM_FILTER_P + 3)) / 8 + 16;
+    f->data = (uint8_t *)malloc(cap);
+    if (!f->data) {
+        free(h);
+        return BLOOM_FILTER_ERR_NOMEM;
+    }
+    f->n = (uint32_t)u;
+    for (int i = 0; i < 4; i++) f->data[i] = (uint8_t)(f->n >> (8 * i));
+
+    bit_writer w = { f->data + 4, 0, 0, 0 };
+    uint64_t range = (uint64_t)u * BLOOM_FILTER_M, prev = 0;
+    for (size_t i = 0; i < u; i++) {
+        uint64_t v = map_range(h[i], range);
+        put_golomb(&w, v - prev);
+        prev = v;
+    }
+    if (w.bits) put_bits(&w, 0, 8 - w.bits);
+    f->size = 4 + w.pos;
+    free(h);
+    return BLOOM_FILTER_OK;
+}
+
+void bloom_filter_outpoint_item(const bloom_outpoint *op, uint8_t out[36]) {
+    memcpy(out, op->txid, 32);
+    for (int i = 0; i < 4; i++) out[32 + i] = (uint8_t)(op->index >> (8 * i));
+}
+
+int bloom_filter_build_block(bloom_filter *f, const uint8_t block_hash[32],
+                             const uint8_t (*addresses)[32], size_t n_addresses,
+                             const bloom_outpoint *spent, size_t n_spent) {
+    size_t n = n_addresses + n_spent;
+    const uint8_t **items = (const uint8_t **)malloc((n ? n : 1) * sizeof(uint8_t *));
+    size_t *lens = (size_t *)malloc((n ? n : 1) * sizeof(size_t));
+    uint8_t *ops = (uint8_t *)malloc((n_spent ? n_spent : 1) * 36);
+    int st = BLOOM_FILTER_ERR_NOMEM;
+    if (items && lens && ops) {
+        for (size_t i = 0; i < n_addresses; i++) {
+            items[i] = addresses[i];
+            lens[i] = 32;
+        }
+        for (size_t i = 0; i < n_spent; i++) {
+            bloom_filter_outpoint_item(&spent[i], ops + 36 * i);
+            items[n_addresses + i] = ops + 36 * i;
+            lens[n_addresses + i] = 36;
+        }
+        st = bloom_filter_build(f, block_hash, items, lens, n);
+    }
+    free(items);
+    free(lens);
+    free(ops);
+    return st;
+}
+
+void bloom_filter_free(bloom_filter *f) {
+    free(f->data);
+    memset(f, 0, sizeof(*f));
+}
+
+/* ========================================================================== */
+/* Queries                                                                     */
+/* ========================================================================== */
+
+typedef struct {
+    uint64_t v;
+    size_t idx;
+} query;
+
+static int cmp_query(const void *a, const void *b) {
+    uint64_t x = ((const query *)a)->v, y = ((const query *)b)->v;
+    return (x > y) - (x < y);
+}
+
+/* Merge sorted queries against the filter; stop_at_first for match_any */
+static int match_impl(const uint8_t *filter, size_t size, const uint8_t block_hash[32],
+                      const uint8_t *const *items, const size_t *lens, size_t n,
+                      uint8_t *hits, int stop_at_first) {
+    if (size < 4) return BLOOM_FILTER_ERR_TRUNCATED;
+    uint32_t count = (uint32_t)filter[0] | (uint32_t)filter[1] << 8 |
+                     (uint32_t)filter[2] << 16 | (uint32_t)filter[3] << 24;
+    if (hits) memset(hits, 0, n);
+    if (count == 0 || n == 0) return 0;
+
+    query *q = (query *)malloc(n * sizeof(query));
+    uint64_t *h = (uint64_t *)malloc(n * sizeof(uint64_t));
+    if (!q || !h) {
+        free(q);
+        free(h);
+        return BLOOM_FILTER_ERR_NOMEM;
+    }
+    int st = hash_items(block_hash, items, lens, n, h);
+    if (st != BLOOM_FILTER_OK) {
+        free(q);
+        free(h);
+        return st;
+    }
+    uint64_t range = (uint64_t)count * BLOOM_FILTER_M;
+    for (size_t i = 0; i < n; i++) {
+        q[i].v = map_range(h[i], range);
+        q[i].idx = i;
+    }
+    free(h);
+    qsort(q, n, sizeof(query), cmp_query);
+
+    bit_reader r = { filter + 4, size - 4, 0 };
+    uint64_t cur = 0;
+    size_t qi = 0;
+    int found = 0;
+    for (uint32_t e = 0; e < count && qi < n; e++) {
+        uint64_t delta;
+        if (get_golomb(&r, &delta) != BLOOM_FILTER_OK) {
+            found = BLOOM_FILTER_ERR_TRUNCATED;
+            break;
+        }
+        cur += delta;
+        while (qi < n && q[qi].v < cur) qi++;
+        while (qi < n && q[qi].v == cur) {
+            if (hits) hits[q[qi].idx] = 1;
+            found++;
+            qi++;
+        }
+        if (found && stop_at_first) break;
+    }
+    free(q);
+    return stop_at_first && found > 0 ? 1 : found;
+}
+
+int bloom_filter_match(const uint8_t *filter, size_t size, const uint8_t block_hash[32],
+                       const uint8_t *const *items, const size_t *lens, size_t n,
+                       uint8_t *hits) {
+    return match_impl(filter, size, block_hash, items, lens, n, hits, 0);
+}
+
+int bloom_filter_match_any(const uint8_t *filter, size_t size,
+                           const uint8_t block_hash[32],
+                           const uint8_t *const *items, const size_t *lens, size_t n) {
+    return match_impl(filter, size, block_hash, items, lens, n, NULL, 1);
+}
+
+void bloom_filter_header(const uint8_t *filter, size_t size, const uint8_t prev[32],
+                         uint8_t header[32]) {
+    uint8_t buf[64];
+    nexthash256(filter, size, buf);
+    memcpy(buf + 32, prev, 32);
+    nexthash256(buf, 64, header);
+}
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <stdio.h>
+#include <time.h>
+
+static uint64_t test_rng = 0x2545F4914F6CDD1Dull;
+
+static uint64_t xorshift(void) {
+    test_rng ^= test_rng << 13;
+    test_rng ^= test_rng >> 7;
+    test_rng ^= test_rng << 17;
+    return test_rng;
+}
+
+static void rand_bytes(uint8_t *p, size_t n) {
+    for (size_t i = 0; i < n; i++) p[i] = (uint8_t)xorshift();
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(void) {
+    int fail = 0;
+    printf("BloomCoin Compact Block Filters\n");
+    printf("===============================\n\n");
+
+    /* Golomb round trip over awkward values */
+    {
+        uint64_t vals[] = { 0, 1, (1u << BLOOM_FILTER_P) - 1, 1u << BLOOM_FILTER_P,
+                            123456789ull, (uint64_t)40 << BLOOM_FILTER_P, 7, 0, 99ull << 22 };
+        size_t nv = sizeof(vals) / sizeof(vals[0]);
+        uint8_t buf[256] = {0};
+        bit_writer w = { buf, 0, 0, 0 };
+        for (size_t i = 0; i < nv; i++) put_golomb(&w, vals[i]);
+        if (w.bits) put_bits(&w, 0, 8 - w.bits);
+        bit_reader r = { buf, w.pos, 0 };
+        int ok = 1;
+        for (size_t i = 0; i < nv; i++) {
+            uint64_t x = 0;
+            ok &= get_golomb(&r, &x) == BLOOM_FILTER_OK && x == vals[i];
+        }
+        uint64_t x;
+        r.size = 3;
+        r.bit = 0;
+        ok &= get_golomb(&r, &x) == BLOOM_FILTER_OK;
+        ok &= get_golomb(&r, &x) == BLOOM_FILTER_ERR_TRUNCATED;
+        printf("golomb round trip:        %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    enum { OUTS = 3000, INS = 2000 };
+    uint8_t block_hash[32];
+    static uint8_t addrs[OUTS][32];
+    static bloom_outpoint spent[INS];
+    rand_bytes(block_hash, 32);
+    rand_bytes(&addrs[0][0], sizeof(addrs));
+    for (int i = 0; i < INS; i++) {
+        rand_bytes(spent[i].txid, 32);
+        spent[i].index = (uint32_t)(xorshift() % 8);
+    }
+    memcpy(addrs[OUTS - 1], addrs[0], 32);      /* repeated address */
+
+    bloom_filter f;
+    double t0 = now_sec();
+    int st = bloom_filter_build_block(&f, block_hash, addrs, OUTS, spent, INS);
+    double t_build = now_sec() - t0;
+    printf("build %d elements:      %u distinct, %zu bytes (%.1f bits each), %.2f ms  %s\n",
+           OUTS + INS, f.n, f.size, 8.0 * f.size / f.n, 1e3 * t_build,
+           st == 0 && f.n == OUTS + INS - 1 ? "OK" : "FAIL");
+    fail |= !(st == 0 && f.n == OUTS + INS - 1);
+
+    /* Every member matches */
+    {
+        static const uint8_t *items[OUTS + INS];
+        static size_t lens[OUTS + INS];
+        static uint8_t ops[INS][36], hits[OUTS + INS];
+        for (int i = 0; i < OUTS; i++) {
+            items[i] = addrs[i];
+            lens[i] = 32;
+        }
+        for (int i = 0; i < INS; i++) {
+            bloom_filter_outpoint_item(&spent[i], ops[i]);
+            items[OUTS + i] = ops[i];
+            lens[OUTS + i] = 36;
+        }
+        int k = bloom_filter_match(f.data, f.size, block_hash, items, lens, OUTS + INS, hits);
+        int ok = k == OUTS + INS;
+        for (int i = 0; i < OUTS + INS; i++) ok &= hits[i] == 1;
+        printf("members match:            %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Wallet query: many addresses, few in the block */
+    {
+        enum { WALLET = 20000 };
+        static uint8_t mine[WALLET][32];
+        static const uint8_t *items[WALLET];
+        static size_t lens[WALLET];
+        static uint8_t hits[WALLET];
+        rand_bytes(&mine[0][0], sizeof(mine));
+        memcpy(mine[123], addrs[77], 32);
+        memcpy(mine[WALLET - 1], addrs[2500], 32);
+        for (int i = 0; i < WALLET; i++) {
+            items[i] = mine[i];
+            lens[i] = 32;
+        }
+        t0 = now_sec();
+        int k = bloom_filter_match(f.data, f.size, block_hash, items, lens, WALLET, hits);
+        double t_q = now_sec() - t0;
+        int any = bloom_filter_match_any(f.data, f.size, block_hash, items, lens, WALLET);
+        int none = bloom_filter_match_any(f.data, f.size, block_hash, items, lens, 100);
+        uint8_t other[32];
+        memcpy(other, block_hash, 32);
+        other[0] ^= 1;
+        int rekeyed = bloom_filter_match(f.data, f.size, other, items, lens, WALLET, NULL);
+        int ok = k >= 2 && k <= 4 && hits[123] && hits[WALLET - 1] && any == 1 &&
+                 none == 0 && rekeyed <= 2;
+        printf("wallet query (%d items): %d hits in %.2f ms (%.0f ns/item)  %s\n",
+               WALLET, k, 1e3 * t_q, 1e9 * t_q / WALLET, ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* False-positive rate with a small filter and many queries */
+    {
+        enum { Q = 200000 };
+        uint8_t (*qs)[32] = malloc((size_t)Q * 32);
+        const uint8_t **items = malloc(Q * sizeof(uint8_t *));
+        size_t *lens = malloc(Q * sizeof(size_t));
+        rand_bytes(&qs[0][0], (size_t)Q * 32);
+        for (int i = 0; i < Q; i++) {
+            items[i] = qs[i];
+            lens[i] = 32;
+        }
+        int fp = 0;
+        for (int b = 0; b < 10; b++) {
+            bloom_filter g;
+            uint8_t bh[32];
+            rand_bytes(bh, 32);
+            bloom_filter_build_block(&g, bh, addrs, 1000, NULL, 0);
+            fp += bloom_filter_match(g.data, g.size, bh, items, lens, Q, NULL);
+            bloom_filter_free(&g);
+        }
+        double rate = fp / (10.0 * Q);
+        int ok = rate < 5.0 / BLOOM_FILTER_M + 1e-5;
+        printf("false positives:          %d / %d (%.2e, target %.2e)  %s\n",
+               fp, 10 * Q, rate, 1.0 / BLOOM_FILTER_M, ok ? "OK" : "FAIL");
+        fail |= !ok;
+        free(qs);
+        free(items);
+        free(lens);
+    }
+
+    /* Empty, truncated and header chain */
+    {
+        bloom_filter e;
+        uint8_t h0[32] = {0}, h1[32], h2[32];
+        const uint8_t *item = addrs[0];
+        size_t len = 32;
+        int ok = bloom_filter_build(&e, block_hash, NULL, NULL, 0) == 0 && e.size == 4;
+        ok &= bloom_filter_match(e.data, e.size, block_hash, &item, &len, 1, NULL) == 0;
+        int half = bloom_filter_match(f.data, f.size / 2, block_hash, &item, &len, 1, NULL);
+        ok &= half == 1 || half == BLOOM_FILTER_ERR_TRUNCATED;
+        ok &= bloom_filter_match(f.data, 2, block_hash, &item, &len, 1, NULL)
+              == BLOOM_FILTER_ERR_TRUNCATED;
+        bloom_filter_header(f.data, f.size, h0, h1);
+        bloom_filter_header(e.data, e.size, h1, h2);
+        ok &= memcmp(h1, h2, 32) != 0;
+        printf("empty / truncated / chain: %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+        bloom_filter_free(&e);
+    }
+
+    bloom_filter_free(&f);
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
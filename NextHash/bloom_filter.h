@@ -0,0 +1,90 @@
+/*
+ * BloomCoin Compact Block Filters
+ * ===============================
+ *
+ * Per-block Golomb-Rice coded sets for light wallets (wallet/wallet.py):
+ * a wallet tests its addresses and outpoints against a small filter and
+ * downloads only the blocks that match, instead of scanning every block
+ * as update_utxos_from_chain() does.
+ *
+ * Features:
+ * - Elements: output addresses (TxOutput.address, 32 bytes) and spent
+ *   outpoints (TxInput prev_tx || output_index LE, 36 bytes)
+ * - Element hash: first 8 bytes of NEXTHASH-256(block_hash[0..15] || item),
+ *   mapped onto [0, N * M); all elements hashed in one nexthash256_batch()
+ * - Golomb-Rice coding with P = 19, M = 784931 (~1 / 784931 false positives,
+ *   ~21 bits per element)
+ * - Batched queries: many items are hashed, sorted and merged against the
+ *   filter in a single decoding pass
+ * - Filter header chain: header = NEXTHASH-256(NEXTHASH-256(filter) || prev)
+ *
+ * Wire format: n_elements u32 LE | Golomb-Rice bit stream (MSB first,
+ * zero-padded to a byte).
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "bloom_mempool.h"      /* bloom_outpoint */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLOOM_FILTER_P      19
+#define BLOOM_FILTER_M      784931
+#define BLOOM_FILTER_KEY    16      /* block hash bytes used as the key */
+
+/* Status codes */
+#define BLOOM_FILTER_OK              0
+#define BLOOM_FILTER_ERR_TRUNCATED  -1   /* bit stream ends early */
+#define BLOOM_FILTER_ERR_NOMEM      -2
+
+/* Serialized filter (owned) */
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    uint32_t n;             /* distinct elements */
+} bloom_filter;
+
+/* Filter over arbitrary items */
+int bloom_filter_build(bloom_filter *f, const uint8_t block_hash[32],
+                       const uint8_t *const *items, const size_t *lens, size_t n);
+
+/* Filter over a block's output addresses and spent outpoints */
+int bloom_filter_build_block(bloom_filter *f, const uint8_t block_hash[32],
+                             const uint8_t (*addresses)[32], size_t n_addresses,
+                             const bloom_outpoint *spent, size_t n_spent);
+
+void bloom_filter_free(bloom_filter *f);
+
+/* 36-byte element encoding of an outpoint */
+void bloom_filter_outpoint_item(const bloom_outpoint *op, uint8_t out[36]);
+
+/*
+ * hits[i] = 1 if items[i] may be in the filter, else 0 (hits may be NULL).
+ * Returns the number of hits, or a negative status code.
+ */
+int bloom_filter_match(const uint8_t *filter, size_t size, const uint8_t block_hash[32],
+                       const uint8_t *const *items, const size_t *lens, size_t n,
+                       uint8_t *hits);
+
+/* 1 if any item may be in the filter (stops at the first hit), 0, or < 0 */
+int bloom_filter_match_any(const uint8_t *filter, size_t size,
+                           const uint8_t block_hash[32],
+                           const uint8_t *const *items, const size_t *lens, size_t n);
+
+/* Next link of the filter header chain */
+void bloom_filter_header(const uint8_t *filter, size_t size, const uint8_t prev[32],
+                         uint8_t header[32]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOOM_FILTER_H */
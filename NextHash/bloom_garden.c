@@ -0,0 +1,689 @@
+/*
+ * BloomCoin Garden Tick Engine
+ * ============================
+ *
+ * Compile: gcc -O3 -c nexthash256.c nexthash_rng.c bloom_sampler.c
+ *          gcc -O3 -mavx2 -fopenmp -o bloom_garden bloom_garden.c bloom_sampler.o nexthash_rng.o nexthash256.o -lm -DTEST_MAIN
+ */
+
+#include "bloom_garden.h"
+#include "bloom_sampler.h"
+#include "nexthash256.h"
+#include "nexthash_rng.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/* Events per parallel chunk */
+#define CHUNK       256
+
+/* Stream words per event: selection draws (index, coin), then votes */
+#define EVENT_WORDS 64
+#define SELECT_DRAWS 24
+#define VOTE_WORD   (2 * SELECT_DRAWS)
+
+/* Block record: agent, type, coherence, significance, content, validators */
+#define RECORD_LEN  (4 + 1 + 8 + 8 + 32 + 1 + 4 * BLOOM_GARDEN_MAX_VALIDATORS)
+
+#define Z_CRITICAL  0.8660254037844386      /* 3**0.5 / 2 */
+#define CONSENSUS   0.667
+
+#define MAX_AGENTS  BLOOM_SAMPLER_MAX
+
+struct bloom_garden {
+    uint32_t key[8];                /* selection and vote stream */
+    uint64_t tick;
+
+    size_t n_agents, cap_agents;
+    bloom_garden_agent *agents;
+    double *reputation;
+    double *coherence;              /* agents[i].coherence, contiguous */
+
+    /* Reputation weights, zero for offline agents; read-only during a tick */
+    bloom_sampler *sampler;
+    uint32_t n_online;
+    uint32_t *online;               /* slot -> agent */
+
+    /* Per-event scratch */
+    size_t cap;
+    uint8_t *bonus;                 /* weighted consensus approved */
+
+    uint8_t head[32];
+    uint64_t height;
+};
+
+/* ========================================================================== */
+/* Rules                                                                       */
+/* ========================================================================== */
+
+static double sigmoid(double x) {
+    return 1.0 / (1.0 + exp(-x));
+}
+
+/* ConsensusRules.required_validators() */
+static uint32_t required_validators(uint64_t network_size) {
+    if (network_size < 3) return 1;
+    if (network_size < 10) return 2;
+    if (network_size < 50) return 3;
+    uint32_t log2n = 63 - (uint32_t)__builtin_clzll(network_size);
+    return log2n < BLOOM_GARDEN_MAX_VALIDATORS ? log2n : BLOOM_GARDEN_MAX_VALIDATORS;
+}
+
+/* AIAgent._calculate_coherence() */
+static double learn_coherence(const bloom_garden_agent *a, double overlap) {
+    double d = overlap + a->curiosity / 2.0 - Z_CRITICAL;
+    double c = exp(-(d * d));
+    return c < 0 ? 0 : c > 1 ? 1 : c;
+}
+
+/* AIAgent._is_bloom_worthy() */
+static int bloom_worthy(const bloom_garden_agent *a, const bloom_garden_event *ev,
+                        double coherence) {
+    return coherence >= Z_CRITICAL - a->curiosity * 0.1 && ev->novelty >= 0.3 &&
+           ev->content_size >= 50;
+}
+
+/* AIAgent._calculate_significance() */
+static double significance(const bloom_garden_agent *a, const bloom_garden_event *ev,
+                           double coherence) {
+    static const double type_weight[4] = { 1.0, 1.5, 1.3, 1.2 };
+    double bonus = 0;
+    if (ev->memory_type == BLOOM_GARDEN_CREATION && a->creativity > 0.7f) {
+        bonus = 0.2;
+    } else if (ev->memory_type == BLOOM_GARDEN_FACT && a->specialization == BLOOM_GARDEN_SCIENCE) {
+        bonus = 0.15;
+    }
+    return ev->novelty * type_weight[ev->memory_type] + coherence * 0.5 + bonus;
+}
+
+/* AIAgent.validate_bloom_event() approval chance */
+static double approval_chance(const bloom_garden_agent *v, uint8_t memory_type, double coherence) {
+    double chance = v->reliability;
+    if (coherence < Z_CRITICAL * 0.7) {
+        chance *= 0.5;
+    } else if (coherence > Z_CRITICAL * 1.3) {
+        chance *= 0.8;
+    }
+    if (memory_type == v->specialization) chance += 0.1;
+    return chance;
+}
+
+/* ========================================================================== */
+/* Validator Weights                                                           */
+/* ========================================================================== */
+
+/* Sampler weight of agent i: reputation in 32.32 fixed point, 0 offline */
+static void sync_weight(bloom_garden *g, uint32_t i) {
+    uint64_t w = 0;
+    if (g->agents[i].online) {
+        w = (uint64_t)(g->reputation[i] * 0x1p32 + 0.5);
+        if (w > BLOOM_SAMPLER_ONE) w = BLOOM_SAMPLER_ONE;
+    }
+    bloom_sampler_set(g->sampler, i, w);
+}
+
+/*
+ * _select_validators(): count distinct online agents other than the
+ * proposer. Draws that repeat are skipped; if the draws run out, the
+ * online list is walked from a drawn slot.
+ */
+static uint32_t select_validators(const bloom_garden *g, uint32_t proposer, const uint32_t *w,
+                                  uint32_t *sel) {
+    uint64_t avail = g->n_online - (g->agents[proposer].online != 0);
+    uint32_t count = required_validators(avail + 1), k = 0;
+
+    if (avail <= count || bloom_sampler_total(g->sampler) == 0) {
+        for (uint32_t j = 0; j < g->n_online; j++) {
+            if (g->online[j] != proposer) sel[k++] = g->online[j];
+        }
+        return k;
+    }
+    for (int d = 0; d < SELECT_DRAWS && k < count; d++) {
+        uint32_t v = bloom_sampler_pick(g->sampler, (uint64_t)w[2 * d] | (uint64_t)w[2 * d + 1] << 32);
+        int seen = v == proposer;
+        for (uint32_t t = 0; t < k && !seen; t++) seen = sel[t] == v;
+        if (!seen) sel[k++] = v;
+    }
+    for (uint32_t j = w[0] % g->n_online; k < count; j = (j + 1) % g->n_online) {
+        uint32_t v = g->online[j];
+        int seen = v == proposer;
+        for (uint32_t t = 0; t < k && !seen; t++) seen = sel[t] == v;
+        if (!seen) sel[k++] = v;
+    }
+    return k;
+}
+
+/* ========================================================================== */
+/* Engine                                                                      */
+/* ========================================================================== */
+
+bloom_garden *bloom_garden_create(uint64_t seed) {
+    bloom_garden *g = (bloom_garden *)calloc(1, sizeof(*g));
+    if (!g) return NULL;
+    g->sampler = bloom_sampler_create();
+    if (!g->sampler) {
+        free(g);
+        return NULL;
+    }
+    nexthash_rng_key(g->key, seed, 0x6772646E);     /* "grdn" */
+    return g;
+}
+
+void bloom_garden_destroy(bloom_garden *g) {
+    if (!g) return;
+    free(g->agents);
+    free(g->reputation);
+    free(g->coherence);
+    free(g->online);
+    free(g->bonus);
+    bloom_sampler_destroy(g->sampler);
+    free(g);
+}
+
+static int grow(void **p, size_t n, size_t size) {
+    void *q = realloc(*p, n * size);
+    if (!q) return 0;
+    *p = q;
+    return 1;
+}
+
+int bloom_garden_set_agents(bloom_garden *g, const bloom_garden_agent *agents, size_t n) {
+    if (n > MAX_AGENTS) return BLOOM_GARDEN_ERR_INVALID;
+    for (size_t i = 0; i < n; i++) {
+        if (agents[i].specialization > BLOOM_GARDEN_GENERAL) return BLOOM_GARDEN_ERR_INVALID;
+    }
+    if (n > g->cap_agents) {
+        if (!grow((void **)&g->agents, n, sizeof(bloom_garden_agent)) ||
+            !grow((void **)&g->reputation, n, sizeof(double)) ||
+            !grow((void **)&g->coherence, n, sizeof(double)) ||
+            !grow((void **)&g->online, n, sizeof(uint32_t))) {
+            return BLOOM_GARDEN_ERR_NOMEM;
+        }
+        g->cap_agents = n;
+    }
+    while (bloom_sampler_count(g->sampler) < n) {
+        if (bloom_sampler_register(g->sampler, NULL) != BLOOM_SAMPLER_OK) {
+            return BLOOM_GARDEN_ERR_NOMEM;
+        }
+    }
+    for (size_t i = g->n_agents; i < n; i++) g->reputation[i] = 0.5;
+    memcpy(g->agents, agents, n * sizeof(bloom_garden_agent));
+    g->n_online = 0;
+    for (size_t i = 0; i < n; i++) {
+        g->coherence[i] = agents[i].coherence;
+        if (agents[i].online) g->online[g->n_online++] = (uint32_t)i;
+        sync_weight(g, (uint32_t)i);
+    }
+    /* Agents dropped from the end keep their slot, never drawn */
+    for (size_t i = n; i < bloom_sampler_count(g->sampler); i++) {
+        bloom_sampler_set(g->sampler, (uint32_t)i, 0);
+    }
+    g->n_agents = n;
+    return BLOOM_GARDEN_OK;
+}
+
+double bloom_garden_reputation(const bloom_garden *g, uint32_t agent) {
+    return agent < g->n_agents ? g->reputation[agent] : 0.5;
+}
+
+uint64_t bloom_garden_head(const bloom_garden *g, uint8_t hash[32]) {
+    memcpy(hash, g->head, 32);
+    return g->height;
+}
+
+uint64_t bloom_garden_ticks(const bloom_garden *g) {
+    return g->tick;
+}
+
+double bloom_garden_network_coherence(const bloom_garden *g) {
+    size_t n = g->n_agents, i = 0;
+    const double *c = g->coherence;
+    if (n == 0) return 0.5;
+
+    double sum = 0;
+#if defined(__AVX2__)
+    __m256d acc = _mm256_setzero_pd();
+    for (; i + 4 <= n; i += 4) acc = _mm256_add_pd(acc, _mm256_loadu_pd(c + i));
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < n; i++) sum += c[i];
+    double mean = sum / n;
+
+    double ss = 0;
+    i = 0;
+#if defined(__AVX2__)
+    __m256d vm = _mm256_set1_pd(mean);
+    acc = _mm256_setzero_pd();
+    for (; i + 4 <= n; i += 4) {
+        __m256d d = _mm256_sub_pd(_mm256_loadu_pd(c + i), vm);
+        acc = _mm256_add_pd(acc, _mm256_mul_pd(d, d));
+    }
+    _mm256_storeu_pd(lanes, acc);
+    ss = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < n; i++) ss += (c[i] - mean) * (c[i] - mean);
+    return mean * exp(-(ss / n));
+}
+
+/* ========================================================================== */
+/* Tick                                                                        */
+/* ========================================================================== */
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void put_le64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void put_double(uint8_t *p, double d) {
+    uint64_t v;
+    memcpy(&v, &d, 8);
+    put_le64(p, v);
+}
+
+/* Block record of an accepted bloom; validator slots past n are zero */
+static void make_record(const bloom_garden_event *ev, const bloom_garden_outcome *o,
+                        uint8_t rec[RECORD_LEN]) {
+    memset(rec, 0, RECORD_LEN);
+    put_le32(rec, ev->agent);
+    rec[4] = ev->memory_type;
+    put_double(rec + 5, o->coherence);
+    put_double(rec + 13, o->significance);
+    memcpy(rec + 21, ev->content, 32);
+    rec[53] = o->n_validators;
+    for (int k = 0; k < o->n_validators; k++) put_le32(rec + 54 + 4 * k, o->validators[k]);
+}
+
+/* Learning, selection and votes for events [from, to); record digests of
+ * accepted blooms are left in block_hash */
+static void run_chunk(bloom_garden *g, const bloom_garden_event *events,
+                      bloom_garden_outcome *out, size_t from, size_t to) {
+    uint8_t recs[CHUNK][RECORD_LEN];
+    const uint8_t *ptrs[CHUNK];
+    size_t lens[CHUNK], idx[CHUNK], n_acc = 0;
+    uint32_t w[EVENT_WORDS];
+
+    for (size_t i = from; i < to; i++) {
+        const bloom_garden_event *ev = &events[i];
+        const bloom_garden_agent *a = &g->agents[ev->agent];
+        bloom_garden_outcome *o = &out[i];
+
+        memset(o, 0, sizeof(*o));
+        o->block_index = BLOOM_GARDEN_NONE;
+        o->coherence = learn_coherence(a, ev->overlap);
+        g->bonus[i] = 0;
+        if (!bloom_worthy(a, ev, o->coherence)) continue;
+        o->flags = BLOOM_GARDEN_BLOOM;
+        o->significance = significance(a, ev, o->coherence);
+
+        nexthash_rng_fill_at(g->key, ((g->tick << 32) | i) * EVENT_WORDS, w, EVENT_WORDS);
+        o->n_validators = (uint8_t)select_validators(g, ev->agent, w, o->validators);
+
+        /* Votes until the pool reaches consensus */
+        double weight = 0, weight_approved = 0;
+        for (int k = 0; k < o->n_validators; k++) {
+            const bloom_garden_agent *v = &g->agents[o->validators[k]];
+            int yes = w[VOTE_WORD + k] * 0x1p-32 < approval_chance(v, ev->memory_type, o->coherence);
+            o->votes++;
+            o->approvals += (uint8_t)yes;
+            o->approved |= (uint8_t)(yes << k);
+            weight += v->reliability;
+            if (yes) weight_approved += v->reliability;
+            if (o->votes >= o->n_validators * 0.5 &&
+                (double)o->approvals / o->votes >= CONSENSUS) {
+                o->flags |= BLOOM_GARDEN_ACCEPTED;
+                g->bonus[i] = weight_approved / weight >= CONSENSUS;
+                break;
+            }
+        }
+        if (o->flags & BLOOM_GARDEN_ACCEPTED) {
+            make_record(ev, o, recs[n_acc]);
+            ptrs[n_acc] = recs[n_acc];
+            lens[n_acc] = RECORD_LEN;
+            idx[n_acc++] = i;
+        }
+    }
+
+    if (n_acc == 0) return;
+    uint8_t digests[CHUNK][32];
+    nexthash256_batch(ptrs, lens, n_acc, digests);
+    for (size_t k = 0; k < n_acc; k++) memcpy(out[idx[k]].block_hash, digests[k], 32);
+}
+
+int bloom_garden_tick(bloom_garden *g, const bloom_garden_event *events, size_t n,
+                      bloom_garden_outcome *out, bloom_garden_stats *stats) {
+    if (n > UINT32_MAX) return BLOOM_GARDEN_ERR_INVALID;
+    for (size_t i = 0; i < n; i++) {
+        if (events[i].agent >= g->n_agents || events[i].memory_type > BLOOM_GARDEN_INSIGHT) {
+            return BLOOM_GARDEN_ERR_INVALID;
+        }
+    }
+    if (n > g->cap) {
+        if (!grow((void **)&g->bonus, n, 1)) return BLOOM_GARDEN_ERR_NOMEM;
+        g->cap = n;
+    }
+
+    long n_chunks = (long)((n + CHUNK - 1) / CHUNK);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 4)
+#endif
+    for (long ch = 0; ch < n_chunks; ch++) {
+        size_t from = (size_t)ch * CHUNK;
+        size_t to = from + CHUNK < n ? from + CHUNK : n;
+        run_chunk(g, events, out, from, to);
+    }
+
+    /* Reputation and chain, in event order */
+    bloom_garden_stats st = { 0, 0, 0, 0 };
+    for (size_t i = 0; i < n; i++) {
+        bloom_garden_outcome *o = &out[i];
+        if (!(o->flags & BLOOM_GARDEN_BLOOM)) continue;
+        st.blooms++;
+        for (int k = 0; k < o->votes; k++) {
+            double *r = &g->reputation[o->validators[k]];
+            *r = sigmoid(*r + 0.01);
+            sync_weight(g, o->validators[k]);
+        }
+        if (!(o->flags & BLOOM_GARDEN_ACCEPTED)) continue;
+        st.accepted++;
+        if (g->bonus[i]) {
+            for (int k = 0; k < o->votes; k++) {
+                if (!(o->approved >> k & 1)) continue;
+                double *r = &g->reputation[o->validators[k]];
+                *r = sigmoid(*r + 0.05);
+                sync_weight(g, o->validators[k]);
+            }
+        }
+
+        uint8_t link[72];
+        memcpy(link, g->head, 32);
+        put_le64(link + 32, g->height);
+        memcpy(link + 40, o->block_hash, 32);
+        nexthash256(link, sizeof(link), g->head);
+        memcpy(o->block_hash, g->head, 32);
+        o->block_index = g->height++;
+    }
+
+    st.height = g->height;
+    st.network_coherence = bloom_garden_network_coherence(g);
+    if (stats) *stats = st;
+    g->tick++;
+    return BLOOM_GARDEN_OK;
+}
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <stdio.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+static uint64_t test_rng = 0x9E3779B97F4A7C15ull;
+
+static uint64_t xorshift(void) {
+    test_rng ^= test_rng << 13;
+    test_rng ^= test_rng >> 7;
+    test_rng ^= test_rng << 17;
+    return test_rng;
+}
+
+static double unit(void) {
+    return (xorshift() >> 11) * 0x1p-53;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void random_events(bloom_garden_event *ev, size_t n, uint32_t n_agents) {
+    for (size_t i = 0; i < n; i++) {
+        ev[i].agent = (uint32_t)(xorshift() % n_agents);
+        ev[i].memory_type = (uint8_t)(xorshift() % 4);
+        ev[i].overlap = unit() * 0.8;
+        ev[i].novelty = 0.2 + unit() * 0.8;
+        ev[i].content_size = (uint32_t)(30 + xorshift() % 200);
+        for (int b = 0; b < 32; b++) ev[i].content[b] = (uint8_t)xorshift();
+    }
+}
+
+int main(void) {
+    int fail = 0, ok;
+    printf("BloomCoin Garden Tick Engine\n");
+    printf("============================\n\n");
+
+    enum { AGENTS = 20000, EVENTS = 100000, TICKS = 5 };
+    bloom_garden_agent *agents = malloc(AGENTS * sizeof(bloom_garden_agent));
+    for (int i = 0; i < AGENTS; i++) {
+        agents[i].curiosity = (float)unit();
+        agents[i].creativity = (float)unit();
+        agents[i].reliability = (float)(0.5 + 0.5 * unit());
+        agents[i].specialization = (uint8_t)(xorshift() % 6);
+        agents[i].online = xorshift() % 10 != 0;
+        agents[i].coherence = 0.5 + 0.3 * unit();
+    }
+    bloom_garden_event *ev = malloc((size_t)TICKS * EVENTS * sizeof(bloom_garden_event));
+    random_events(ev, (size_t)TICKS * EVENTS, AGENTS);
+    bloom_garden_outcome *out = malloc((size_t)TICKS * EVENTS * sizeof(bloom_garden_outcome));
+    bloom_garden_outcome *out2 = malloc((size_t)TICKS * EVENTS * sizeof(bloom_garden_outcome));
+    double *rep0 = malloc(AGENTS * sizeof(double));
+
+    bloom_garden *g = bloom_garden_create(7);
+    bloom_garden_set_agents(g, agents, AGENTS);
+    bloom_garden_stats st = { 0, 0, 0, 0 };
+    uint64_t blooms = 0, accepted = 0;
+    double dt = 0;
+    for (int t = 0; t < TICKS; t++) {
+        for (int i = 0; i < AGENTS; i++) rep0[i] = g->reputation[i];
+        double t0 = now_sec();
+        if (bloom_garden_tick(g, ev + (size_t)t * EVENTS, EVENTS, out + (size_t)t * EVENTS,
+                              &st) != BLOOM_GARDEN_OK) {
+            fail = 1;
+        }
+        dt += now_sec() - t0;
+        blooms += st.blooms;
+        accepted += st.accepted;
+    }
+    printf("throughput:               %.0f events/s (%llu blooms, %llu accepted)\n",
+           TICKS * EVENTS / dt, (unsigned long long)blooms, (unsigned long long)accepted);
+
+    /* Same seed, one thread: identical outcomes and chain */
+    {
+#ifdef _OPENMP
+        int threads = omp_get_max_threads();
+        omp_set_num_threads(1);
+#endif
+        bloom_garden *g2 = bloom_garden_create(7);
+        bloom_garden_set_agents(g2, agents, AGENTS);
+        for (int t = 0; t < TICKS; t++) {
+            bloom_garden_tick(g2, ev + (size_t)t * EVENTS, EVENTS, out2 + (size_t)t * EVENTS, NULL);
+        }
+#ifdef _OPENMP
+        omp_set_num_threads(threads);
+#endif
+        uint8_t h1[32], h2[32];
+        ok = bloom_garden_head(g, h1) == bloom_garden_head(g2, h2) && memcmp(h1, h2, 32) == 0 &&
+             memcmp(g->reputation, g2->reputation, AGENTS * sizeof(double)) == 0 &&
+             bloom_garden_ticks(g2) == TICKS;
+        for (size_t i = 0; i < (size_t)TICKS * EVENTS && ok; i++) {
+            ok = memcmp(&out[i].validators, &out2[i].validators, sizeof(out[i].validators)) == 0 &&
+                 out[i].flags == out2[i].flags && out[i].approved == out2[i].approved &&
+                 out[i].block_index == out2[i].block_index &&
+                 memcmp(out[i].block_hash, out2[i].block_hash, 32) == 0;
+        }
+        printf("deterministic replay:     %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+        bloom_garden_destroy(g2);
+    }
+
+    /* Learning rules, selection and consensus per event */
+    {
+        uint32_t n_online = 0;
+        for (int i = 0; i < AGENTS; i++) n_online += agents[i].online;
+        ok = 1;
+        for (size_t i = 0; i < (size_t)TICKS * EVENTS && ok; i++) {
+            const bloom_garden_event *e = &ev[i];
+            const bloom_garden_agent *a = &agents[e->agent];
+            const bloom_garden_outcome *o = &out[i];
+            double d = e->overlap + a->curiosity / 2.0 - Z_CRITICAL;
+            double coh = exp(-(d * d));
+            int worthy = coh >= Z_CRITICAL - a->curiosity * 0.1 && e->novelty >= 0.3 &&
+                         e->content_size >= 50;
+            ok = o->coherence == coh && (o->flags & BLOOM_GARDEN_BLOOM) == worthy;
+            if (!worthy || !ok) continue;
+
+            uint32_t want = required_validators(n_online - a->online + 1);
+            ok = o->n_validators == want;
+            for (int k = 0; k < o->n_validators && ok; k++) {
+                ok = o->validators[k] != e->agent && agents[o->validators[k]].online;
+                for (int t = 0; t < k; t++) ok &= o->validators[t] != o->validators[k];
+            }
+            /* Accepted at the first qualifying vote, else all votes counted */
+            int app = 0, first = 0;
+            for (int k = 0; k < o->n_validators && !first; k++) {
+                app += o->approved >> k & 1;
+                if (k + 1 >= o->n_validators * 0.5 && (double)app / (k + 1) >= CONSENSUS) first = k + 1;
+            }
+            ok &= (o->flags & BLOOM_GARDEN_ACCEPTED) ? o->votes == first
+                                                      : !first && o->votes == o->n_validators;
+            ok &= o->approvals == app;
+        }
+        printf("learning and consensus:   %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Chain recomputed from the outcomes */
+    {
+        uint8_t head[32] = { 0 }, h[32];
+        uint64_t height = 0;
+        ok = 1;
+        for (size_t i = 0; i < (size_t)TICKS * EVENTS && ok; i++) {
+            if (!(out[i].flags & BLOOM_GARDEN_ACCEPTED)) {
+                ok = out[i].block_index == BLOOM_GARDEN_NONE;
+                continue;
+            }
+            uint8_t rec[RECORD_LEN], link[72];
+            make_record(&ev[i], &out[i], rec);
+            memcpy(link, head, 32);
+            put_le64(link + 32, height);
+            nexthash256(rec, RECORD_LEN, link + 40);
+            nexthash256(link, sizeof(link), head);
+            ok = out[i].block_index == height++ && memcmp(out[i].block_hash, head, 32) == 0;
+        }
+        ok &= bloom_garden_head(g, h) == height && memcmp(h, head, 32) == 0 && height == accepted;
+        printf("batched chain append:     %llu blocks  %s\n", (unsigned long long)height,
+               ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Reputation of the last tick replayed vote by vote */
+    {
+        const bloom_garden_outcome *o = out + (size_t)(TICKS - 1) * EVENTS;
+        for (int i = 0; i < EVENTS; i++) {
+            double w = 0, wa = 0;
+            for (int k = 0; k < o[i].votes; k++) {
+                double *r = &rep0[o[i].validators[k]];
+                *r = 1 / (1 + exp(-(*r + 0.01)));
+                w += agents[o[i].validators[k]].reliability;
+                if (o[i].approved >> k & 1) wa += agents[o[i].validators[k]].reliability;
+            }
+            if (!(o[i].flags & BLOOM_GARDEN_ACCEPTED) || wa / w < CONSENSUS) continue;
+            for (int k = 0; k < o[i].votes; k++) {
+                if (!(o[i].approved >> k & 1)) continue;
+                double *r = &rep0[o[i].validators[k]];
+                *r = 1 / (1 + exp(-(*r + 0.05)));
+            }
+        }
+        ok = memcmp(rep0, g->reputation, AGENTS * sizeof(double)) == 0;
+        printf("reputation updates:       %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Validator picks follow reputation; offline agents never picked */
+    {
+        enum { SMALL = 16, OFFLINE = 5, DRAWS = 1600000 };
+        bloom_garden *gs = bloom_garden_create(1);
+        bloom_garden_agent small[SMALL];
+        uint32_t event_words[EVENT_WORDS], sel[BLOOM_GARDEN_MAX_VALIDATORS];
+        memcpy(small, agents, sizeof(small));
+        for (int i = 0; i < SMALL; i++) small[i].online = i != OFFLINE;
+        bloom_garden_set_agents(gs, small, SMALL);
+        for (uint32_t i = 0; i < SMALL; i++) {
+            gs->reputation[i] = 0.05 + i * 0.06;
+            sync_weight(gs, i);
+        }
+        static uint32_t words[2 * DRAWS];
+        uint32_t key[8];
+        nexthash_rng_key(key, 99, 1);
+        nexthash_rng_fill_at(key, 0, words, 2 * DRAWS);
+        uint32_t hits[SMALL] = { 0 };
+        for (int d = 0; d < DRAWS; d++) {
+            hits[bloom_sampler_pick(gs->sampler, (uint64_t)words[2 * d] | (uint64_t)words[2 * d + 1] << 32)]++;
+        }
+        /* Pearson chi-square against the fixed-point weights, 14 df: 36.12 is p = 0.001 */
+        double chi2 = 0;
+        for (uint32_t i = 0; i < SMALL; i++) {
+            bloom_sampler_node node = { 0, 0, 0 };
+            bloom_sampler_get(gs->sampler, i, &node);
+            if (i == OFFLINE) continue;
+            double expect = (double)DRAWS * node.weight / bloom_sampler_total(gs->sampler);
+            chi2 += (hits[i] - expect) * (hits[i] - expect) / expect;
+        }
+        ok = chi2 < 36.12 && hits[OFFLINE] == 0;
+        /* Selection through the tick path: distinct, online, not the proposer */
+        for (uint64_t e = 0; e < 10000 && ok; e++) {
+            nexthash_rng_fill_at(key, e * EVENT_WORDS, event_words, EVENT_WORDS);
+            uint32_t k = select_validators(gs, 0, event_words, sel);
+            ok = k == required_validators(SMALL - 1);
+            for (uint32_t j = 0; j < k && ok; j++) {
+                ok = sel[j] != 0 && sel[j] != OFFLINE;
+                for (uint32_t t = 0; t < j; t++) ok &= sel[t] != sel[j];
+            }
+        }
+        printf("validator picks:          chi2 %.1f (14 df)  %s\n", chi2, ok ? "OK" : "FAIL");
+        fail |= !ok;
+        bloom_garden_destroy(gs);
+    }
+
+    /* Network coherence against numpy's mean and var */
+    {
+        double s = 0, v = 0;
+        for (int i = 0; i < AGENTS; i++) s += agents[i].coherence;
+        double m = s / AGENTS;
+        for (int i = 0; i < AGENTS; i++) v += (agents[i].coherence - m) * (agents[i].coherence - m);
+        double want = m * exp(-(v / AGENTS));
+        double got = bloom_garden_network_coherence(g);
+        ok = fabs(got - want) < 1e-12 && got == st.network_coherence;
+        printf("network coherence:        %.6f  %s\n", got, ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    ev[5].agent = AGENTS;
+    ok = bloom_garden_tick(g, ev, EVENTS, out, NULL) == BLOOM_GARDEN_ERR_INVALID &&
+         bloom_garden_ticks(g) == TICKS;
+    printf("invalid agent:            %s\n", ok ? "OK" : "FAIL");
+    fail |= !ok;
+
+    bloom_garden_destroy(g);
+    free(agents);
+    free(ev);
+    free(out);
+    free(out2);
+    free(rep0);
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
@@ -0,0 +1,142 @@
+/*
+ * BloomCoin Garden Tick Engine
+ * ============================
+ *
+ * Native tick for GardenSystem (garden/garden_system.py): every learning
+ * event of every agent in a tick goes through process_learning(),
+ * validator selection, _request_validation() and _commit_bloom_to_ledger()
+ * in one call. Agent state (personality, reputation, coherence) lives in
+ * the engine; content, rewards and the Python ledger objects stay with the
+ * caller, which applies the outcomes.
+ *
+ * Rules as in the Python classes:
+ *   learn:     coherence = clip(exp(-(overlap + curiosity/2 - z_c)^2), 0, 1)
+ *              bloom when coherence >= z_c - 0.1 curiosity, novelty >= 0.3
+ *              and content size >= 50
+ *   validate:  approve with chance reliability (x0.5 below 0.7 z_c, x0.8
+ *              above 1.3 z_c, +0.1 on the validator's specialization)
+ *   consensus: votes counted in order; accepted at the first vote where
+ *              at least half the validators voted and 2/3 approve
+ *   reputation r <- sigmoid(r + 0.01) per counted vote, and
+ *              sigmoid(r + 0.05) for approvers of an accepted bloom
+ *
+ * Features:
+ * - Validators drawn in proportion to reputation through bloom_sampler:
+ *   weights kept in its Fenwick tree and updated with each reputation
+ *   change (O(log n) per pick, no per-tick rebuild); required_validators()
+ *   count, proposer excluded, no repeats
+ * - Learning, selection and votes for all events in parallel (OpenMP over
+ *   event chunks); draws come from a counter-based NEXTHASH stream at
+ *   (tick, event), so a tick is reproducible whatever the thread layout
+ * - Reputation updates applied after the votes, in event order
+ * - Accepted blooms appended as one batch: record digests through
+ *   nexthash256_batch(), then block = NEXTHASH-256(prev || height || digest)
+ * - Network coherence (mean x exp(-variance)) in AVX2 lanes
+ *
+ * Differences from the Python loop: selection reads the reputations at
+ * the start of the tick, and candidates are sampled by weight rather than
+ * from the top 2k by reputation.
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef BLOOM_GARDEN_H
+#define BLOOM_GARDEN_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLOOM_GARDEN_MAX_VALIDATORS 7   /* ConsensusRules.max_validators */
+#define BLOOM_GARDEN_NONE           UINT64_MAX
+
+/* Memory types; specializations use the same codes */
+#define BLOOM_GARDEN_FACT     0
+#define BLOOM_GARDEN_SKILL    1
+#define BLOOM_GARDEN_CREATION 2
+#define BLOOM_GARDEN_INSIGHT  3
+#define BLOOM_GARDEN_SCIENCE  4       /* specialization only */
+#define BLOOM_GARDEN_GENERAL  5       /* specialization only */
+
+/* Outcome flags */
+#define BLOOM_GARDEN_BLOOM    0x01    /* bloom-worthy learning */
+#define BLOOM_GARDEN_ACCEPTED 0x02    /* consensus reached, committed */
+
+/* Status codes */
+#define BLOOM_GARDEN_OK            0
+#define BLOOM_GARDEN_ERR_NOMEM    -1
+#define BLOOM_GARDEN_ERR_INVALID  -2   /* unknown agent or memory type */
+
+typedef struct {
+    float curiosity;
+    float creativity;
+    float reliability;
+    uint8_t specialization;
+    uint8_t online;                 /* state != OFFLINE */
+    double coherence;               /* current_coherence */
+} bloom_garden_agent;
+
+typedef struct {
+    uint32_t agent;
+    uint8_t memory_type;
+    double overlap;                 /* knowledge_base.calculate_overlap() */
+    double novelty;                 /* novelty of the new memory */
+    uint32_t content_size;          /* len(json.dumps(content)) */
+    uint8_t content[32];            /* digest of the content, goes on chain */
+} bloom_garden_event;
+
+typedef struct {
+    uint8_t flags;
+    uint8_t n_validators;
+    uint8_t votes;                  /* votes counted before the decision */
+    uint8_t approvals;
+    uint8_t approved;               /* bit k: validators[k] voted to approve */
+    double coherence;
+    double significance;            /* _calculate_significance() */
+    uint32_t validators[BLOOM_GARDEN_MAX_VALIDATORS];
+    uint64_t block_index;           /* BLOOM_GARDEN_NONE unless accepted */
+    uint8_t block_hash[32];
+} bloom_garden_outcome;
+
+typedef struct {
+    uint32_t blooms;
+    uint32_t accepted;
+    uint64_t height;                /* chain length after the tick */
+    double network_coherence;
+} bloom_garden_stats;
+
+typedef struct bloom_garden bloom_garden;
+
+bloom_garden *bloom_garden_create(uint64_t seed);
+void bloom_garden_destroy(bloom_garden *g);
+
+/*
+ * Set the agent table. Agents keep their reputation across calls;
+ * agents beyond the previous count start at 0.5.
+ */
+int bloom_garden_set_agents(bloom_garden *g, const bloom_garden_agent *agents, size_t n);
+
+double bloom_garden_reputation(const bloom_garden *g, uint32_t agent);
+
+/* Run one tick over n learning events; out[n] receives the outcomes */
+int bloom_garden_tick(bloom_garden *g, const bloom_garden_event *events, size_t n,
+                      bloom_garden_outcome *out, bloom_garden_stats *stats);
+
+/* calculate_network_coherence(): mean x exp(-variance), 0.5 when empty */
+double bloom_garden_network_coherence(const bloom_garden *g);
+
+/* Chain head (zeros before the first block) and height */
+uint64_t bloom_garden_head(const bloom_garden *g, uint8_t hash[32]);
+
+/* Ticks run so far */
+uint64_t bloom_garden_ticks(const bloom_garden *g);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOOM_GARDEN_H */
@@ -0,0 +1,403 @@
+/*
+ * BloomCoin Streaming Threshold Gate
+ * ==================================
+ *
+ * Compile: gcc -O3 -mavx2 -o bloom_gate bloom_gate.c -DTEST_MAIN
+ */
+
+#include "bloom_gate.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/* ========================================================================== */
+/* Threshold Mask                                                              */
+/* ========================================================================== */
+
+/*
+ * Bit i set iff r[i] >= th, for n <= 64; NaN bits go to *nan. NaN is
+ * neither above nor below, so as in Python it never takes part in a
+ * crossing, on either side.
+ */
+static uint64_t above_mask(const double *r, size_t n, double th, uint64_t *nan) {
+    uint64_t m = 0, u = 0;
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    __m256d vth = _mm256_set1_pd(th);
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(r + i);
+        uint64_t bits = (uint64_t)_mm256_movemask_pd(_mm256_cmp_pd(v, vth, _CMP_GE_OQ));
+        uint64_t unord = (uint64_t)_mm256_movemask_pd(_mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+        m |= bits << i;
+        u |= unord << i;
+    }
+#endif
+    for (; i < n; i++) {
+        m |= (uint64_t)(r[i] >= th) << i;
+        u |= (uint64_t)(r[i] != r[i]) << i;
+    }
+    *nan = u;
+    return m;
+}
+
+static inline unsigned ctz64(uint64_t x) {
+    return (unsigned)__builtin_ctzll(x);
+}
+
+/* ========================================================================== */
+/* Single Stream                                                               */
+/* ========================================================================== */
+
+void bloom_gate_init(bloom_gate *g, double threshold, uint32_t required_rounds) {
+    memset(g, 0, sizeof(*g));
+    g->threshold = threshold > 0.0 ? threshold : BLOOM_Z_C;
+    g->required_rounds = required_rounds ? required_rounds : BLOOM_L4;
+    g->bloom_start = BLOOM_GATE_NO_BLOOM;
+    g->bloom_valid_at = BLOOM_GATE_NO_BLOOM;
+}
+
+/* Commit the first k values of the current chunk */
+static void gate_commit(bloom_gate *g, const double *r, size_t k) {
+    if (k > 0) {
+        g->r_last = r[k - 1];
+        g->round += k;
+    }
+}
+
+/*
+ * Extend the current run over chunk positions [s, e). Returns the chunk
+ * index at which the first valid bloom completes, or -1.
+ */
+static int64_t gate_extend_run(bloom_gate *g, size_t s, size_t e) {
+    int64_t hit = -1;
+    if (g->bloom_start == BLOOM_GATE_NO_BLOOM &&
+        g->run_len + (e - s) >= g->required_rounds) {
+        hit = (int64_t)(s + (g->required_rounds - g->run_len) - 1);
+        g->bloom_start = (int64_t)g->run_start;
+        g->bloom_valid_at = (int64_t)(g->round + (uint64_t)hit);
+    }
+    g->run_len += e - s;
+    return hit;
+}
+
+size_t bloom_gate_feed(bloom_gate *g, const double *r, size_t n,
+                       bloom_crossing *out, size_t max_out, size_t *n_out,
+                       int stop_on_bloom) {
+    const double th = g->threshold;
+    size_t consumed = 0, written = 0;
+
+    while (consumed < n) {
+        const double *c = r + consumed;
+        size_t chunk = (n - consumed < 64) ? n - consumed : 64;
+        uint64_t valid = (chunk == 64) ? ~0ULL : ((1ULL << chunk) - 1);
+        uint64_t nan;
+        uint64_t m = above_mask(c, chunk, th, &nan);
+        uint64_t prev = (g->round > 0 && g->r_last >= th) ? 1 : 0;
+        uint64_t prev_nan = (g->round > 0 && g->r_last != g->r_last) ? 1 : 0;
+        uint64_t t = (m ^ ((m << 1) | prev)) & valid;
+        /* State changes next to a NaN move the run but are not crossings */
+        uint64_t quiet = nan | (nan << 1) | prev_nan;
+        int in_run = (int)prev;
+        size_t s = 0;
+        int64_t hit;
+
+        /* Walk state changes; above/below is constant between them */
+        while (t) {
+            size_t p = ctz64(t);
+            int up = (int)((m >> p) & 1);
+            t &= t - 1;
+
+            if (in_run) {
+                hit = gate_extend_run(g, s, p);
+                if (hit >= 0 && stop_on_bloom) {
+                    gate_commit(g, c, (size_t)hit + 1);
+                    if (n_out) *n_out = written;
+                    return consumed + (size_t)hit + 1;
+                }
+            }
+
+            /* detect_crossings() has no crossing at the very first value */
+            if (g->round + p > 0 && !((quiet >> p) & 1)) {
+                bloom_crossing *x;
+                if (written == max_out) {
+                    gate_commit(g, c, p);
+                    if (n_out) *n_out = written;
+                    return consumed + p;
+                }
+                x = &out[written++];
+                x->round_num = g->round + p;
+                x->direction = up ? 1 : -1;
+                x->r_before = p ? c[p - 1] : g->r_last;
+                x->r_after = c[p];
+                if (up) g->n_up++;
+                else g->n_down++;
+            }
+
+            in_run = up;
+            g->run_len = 0;
+            if (up) g->run_start = g->round + p;
+            s = p;
+        }
+
+        if (in_run) {
+            hit = gate_extend_run(g, s, chunk);
+            if (hit >= 0 && stop_on_bloom) {
+                gate_commit(g, c, (size_t)hit + 1);
+                if (n_out) *n_out = written;
+                return consumed + (size_t)hit + 1;
+            }
+        }
+        gate_commit(g, c, chunk);
+        consumed += chunk;
+    }
+
+    if (n_out) *n_out = written;
+    return consumed;
+}
+
+/* ========================================================================== */
+/* Ensemble                                                                    */
+/* ========================================================================== */
+
+int bloom_gate_ensemble_init(bloom_gate_ensemble *e, size_t n,
+                             double threshold, uint32_t required_rounds) {
+    memset(e, 0, sizeof(*e));
+    e->n = n;
+    e->threshold = threshold > 0.0 ? threshold : BLOOM_Z_C;
+    e->required_rounds = required_rounds ? required_rounds : BLOOM_L4;
+    e->run_len = (uint32_t *)calloc(n, sizeof(uint32_t));
+    e->above = (uint8_t *)calloc(n, 1);
+    e->bloom_start = (int64_t *)malloc(n * sizeof(int64_t));
+    e->n_up = (uint32_t *)calloc(n, sizeof(uint32_t));
+    e->n_down = (uint32_t *)calloc(n, sizeof(uint32_t));
+    if (!e->run_len || !e->above || !e->bloom_start || !e->n_up || !e->n_down) {
+        bloom_gate_ensemble_free(e);
+        return -1;
+    }
+    for (size_t j = 0; j < n; j++) e->bloom_start[j] = BLOOM_GATE_NO_BLOOM;
+    return 0;
+}
+
+void bloom_gate_ensemble_free(bloom_gate_ensemble *e) {
+    free(e->run_len);
+    free(e->above);
+    free(e->bloom_start);
+    free(e->n_up);
+    free(e->n_down);
+    memset(e, 0, sizeof(*e));
+}
+
+size_t bloom_gate_ensemble_feed(bloom_gate_ensemble *e, const double *r,
+                                size_t rounds) {
+    const double th = e->threshold;
+    const uint32_t req = e->required_rounds;
+    const size_t n = e->n;
+    size_t row;
+
+    for (row = 0; row < rounds && e->n_bloomed < n; row++) {
+        const double *rv = r + row * n;
+        uint32_t *restrict run = e->run_len;
+        uint8_t *restrict above = e->above;
+        uint32_t *restrict up = e->n_up;
+        uint32_t *restrict down = e->n_down;
+        uint32_t completed = 0;
+        size_t j;
+
+        /* Branch-free update; vectorizes across members */
+        for (j = 0; j < n; j++) {
+            uint32_t a = rv[j] >= th;
+            uint32_t b = rv[j] < th;
+            uint32_t was = above[j];
+            up[j] += a & (was >> 1);
+            down[j] += b & was & 1;
+            run[j] = a ? run[j] + 1 : 0;
+            above[j] = (uint8_t)(a | (b << 1));
+            completed |= (run[j] == req);
+        }
+
+        /* Runs reach exactly `req` once each, so this pass is rare */
+        if (completed) {
+            for (j = 0; j < n; j++) {
+                if (run[j] == req && e->bloom_start[j] == BLOOM_GATE_NO_BLOOM) {
+                    e->bloom_start[j] = (int64_t)(e->round + 1 - req);
+                    e->n_bloomed++;
+                }
+            }
+        }
+        e->round++;
+    }
+    return row;
+}
+
+/* ========================================================================== */
+/* Test Main                                                                   */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+/* Straight port of detect_crossings() + validate_bloom() */
+static size_t reference(const double *r, size_t n, double th, uint32_t req,
+                        bloom_crossing *out, int64_t *bloom_start) {
+    size_t k = 0, consecutive = 0, start = 0;
+    *bloom_start = BLOOM_GATE_NO_BLOOM;
+    for (size_t i = 1; i < n; i++) {
+        if (r[i - 1] < th && th <= r[i]) {
+            out[k].round_num = i; out[k].direction = 1;
+            out[k].r_before = r[i - 1]; out[k++].r_after = r[i];
+        } else if (r[i - 1] >= th && th > r[i]) {
+            out[k].round_num = i; out[k].direction = -1;
+            out[k].r_before = r[i - 1]; out[k++].r_after = r[i];
+        }
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (r[i] >= th) {
+            if (consecutive == 0) start = i;
+            if (++consecutive >= req && *bloom_start == BLOOM_GATE_NO_BLOOM) {
+                *bloom_start = (int64_t)start;
+            }
+        } else {
+            consecutive = 0;
+        }
+    }
+    return k;
+}
+
+int main(void) {
+    const size_t N = 200000;
+    double *r = malloc(N * sizeof(double));
+    bloom_crossing *ref = malloc(N * sizeof(bloom_crossing));
+    bloom_crossing *got = malloc(N * sizeof(bloom_crossing));
+    uint64_t s = 0x9E3779B97F4A7C15ULL;
+    int failures = 0;
+
+    printf("BloomCoin Streaming Threshold Gate\n");
+    printf("==================================\n\n");
+
+    /* Noisy r drifting around z_c: many short runs, rare long ones */
+    double level = 0.8;
+    for (size_t i = 0; i < N; i++) {
+        s ^= s << 13; s ^= s >> 7; s ^= s << 17;
+        level += ((double)(s >> 11) / 9007199254740992.0 - 0.5) * 0.02;
+        if (level < 0.6) level = 0.6;
+        if (level > 0.95) level = 0.95;
+        r[i] = level;
+    }
+
+    /* Full stream in uneven batches matches the reference */
+    {
+        bloom_gate g;
+        int64_t ref_bloom;
+        size_t n_ref = reference(r, N, BLOOM_Z_C, BLOOM_L4, ref, &ref_bloom);
+        size_t pos = 0, total = 0, batch = 1;
+
+        bloom_gate_init(&g, 0.0, 0);
+        while (pos < N) {
+            size_t want = batch < N - pos ? batch : N - pos, n_out;
+            size_t used = bloom_gate_feed(&g, r + pos, want, got + total, 7, &n_out, 0);
+            pos += used;
+            total += n_out;
+            batch = batch * 3 % 97 + 1;
+        }
+        int same = total == n_ref && g.bloom_start == ref_bloom;
+        for (size_t i = 0; same && i < total; i++) {
+            same = got[i].round_num == ref[i].round_num &&
+                   got[i].direction == ref[i].direction &&
+                   got[i].r_before == ref[i].r_before;
+        }
+        printf("  Crossings: %zu (ref %zu), first bloom at %lld (ref %lld): %s\n",
+               total, n_ref, (long long)g.bloom_start, (long long)ref_bloom,
+               same ? "OK" : "FAIL");
+        if (!same) failures++;
+    }
+
+    /* Early stop: consumption ends on the round the bloom becomes valid */
+    {
+        bloom_gate g;
+        size_t n_out, used;
+        bloom_gate_init(&g, 0.0, 0);
+        used = bloom_gate_feed(&g, r, N, got, N, &n_out, 1);
+        int ok = bloom_gate_has_bloom(&g) &&
+                 (int64_t)used == g.bloom_valid_at + 1 &&
+                 g.bloom_valid_at == g.bloom_start + BLOOM_L4 - 1;
+        printf("  Early stop after %zu of %zu rounds: %s\n", used, N, ok ? "OK" : "FAIL");
+        if (!ok) failures++;
+    }
+
+    /* Ensemble: each member is a shifted copy of the stream */
+    {
+        const size_t M = 64, R = 4096;
+        bloom_gate_ensemble e;
+        double *rows = malloc(M * R * sizeof(double));
+        int ok = 1;
+        for (size_t t = 0; t < R; t++)
+            for (size_t j = 0; j < M; j++) rows[t * M + j] = r[t + j * 1000];
+        bloom_gate_ensemble_init(&e, M, 0.0, 0);
+        bloom_gate_ensemble_feed(&e, rows, R);
+        for (size_t j = 0; j < M; j++) {
+            int64_t rb;
+            reference(r + j * 1000, R, BLOOM_Z_C, BLOOM_L4, ref, &rb);
+            if (rb != e.bloom_start[j]) ok = 0;
+        }
+        printf("  Ensemble of %zu: %zu bloomed by round %llu: %s\n", M, e.n_bloomed,
+               (unsigned long long)e.round, ok ? "OK" : "FAIL");
+        if (!ok) failures++;
+        bloom_gate_ensemble_free(&e);
+        free(rows);
+    }
+
+    /* NaN is neither above nor below: no crossing on either side of it */
+    {
+        static const double seq[3][3] = { { 0.9, NAN, 0.9 }, { 0.5, NAN, 0.9 }, { 0.9, NAN, 0.5 } };
+        double rows[3][3];
+        bloom_gate_ensemble e;
+        int ok = 1;
+        for (size_t k = 0; k < 3; k++) {
+            bloom_gate g;
+            int64_t rb;
+            size_t n_out, n_ref = reference(seq[k], 3, BLOOM_Z_C, BLOOM_L4, ref, &rb);
+            bloom_gate_init(&g, 0.0, 0);
+            bloom_gate_feed(&g, seq[k], 2, got, 3, &n_out, 0);
+            ok &= n_out == 0;
+            bloom_gate_feed(&g, seq[k] + 2, 1, got, 3, &n_out, 0);
+            ok &= n_ref == 0 && n_out == 0 && g.n_up == 0 && g.n_down == 0;
+            for (size_t t = 0; t < 3; t++) rows[t][k] = seq[k][t];
+        }
+        bloom_gate_ensemble_init(&e, 3, 0.0, 0);
+        bloom_gate_ensemble_feed(&e, &rows[0][0], 3);
+        for (size_t k = 0; k < 3; k++) ok &= e.n_up[k] == 0 && e.n_down[k] == 0;
+        bloom_gate_ensemble_free(&e);
+        printf("  NaN between values: no crossings: %s\n", ok ? "OK" : "FAIL");
+        if (!ok) failures++;
+    }
+
+    /* Throughput */
+    {
+        struct timespec t0, t1;
+        bloom_gate g;
+        size_t n_out;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (int rep = 0; rep < 50; rep++) {
+            bloom_gate_init(&g, 0.0, 0);
+            bloom_gate_feed(&g, r, N, got, N, &n_out, 0);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+        printf("  Throughput: %.1f M r-values/s\n", 50.0 * N / sec / 1e6);
+    }
+
+    free(r);
+    free(ref);
+    free(got);
+    printf("\n%s\n", failures ? "FAILURES DETECTED" : "All gate tests passed.");
+    return failures ? 1 : 0;
+}
+
+#endif /* TEST_MAIN */
@@ -0,0 +1,107 @@
+/*
+ * BloomCoin Streaming Threshold Gate
+ * ==================================
+ *
+ * Incremental threshold-crossing and bloom detection over order
+ * parameter (r) histories, mirroring consensus/threshold_gate.py.
+ *
+ * Features:
+ * - Batches of r values are compared against z_c 64 at a time
+ *   (AVX2 when available) and walked as bitmasks
+ * - Up/down crossings reported with the same rule as detect_crossings()
+ * - Feeding stops at the round the first valid bloom completes, so a
+ *   simulation can end early instead of running to max_rounds
+ * - Ensemble form tracks many independent simulations per round
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef BLOOM_GATE_H
+#define BLOOM_GATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* constants.py: Z_C = sqrt(3)/2, L4 = 7 */
+#define BLOOM_Z_C 0.8660254037844386
+#define BLOOM_L4  7
+
+#define BLOOM_GATE_NO_BLOOM (-1)
+
+/* One threshold crossing (ThresholdCrossing without the time field) */
+typedef struct {
+    uint64_t round_num;
+    int32_t direction;      /* +1 up, -1 down */
+    double r_before;
+    double r_after;
+} bloom_crossing;
+
+/* Single-stream detector state */
+typedef struct {
+    double threshold;
+    uint32_t required_rounds;
+
+    uint64_t round;         /* values consumed so far */
+    double r_last;
+    uint64_t run_start;     /* start of current run above threshold */
+    uint64_t run_len;
+
+    int64_t bloom_start;    /* first valid bloom, or BLOOM_GATE_NO_BLOOM */
+    int64_t bloom_valid_at; /* round at which it reached required_rounds */
+    uint64_t n_up, n_down;
+} bloom_gate;
+
+/* Initialize a detector (threshold <= 0 selects Z_C, required 0 selects L4) */
+void bloom_gate_init(bloom_gate *g, double threshold, uint32_t required_rounds);
+
+/*
+ * Consume up to n values of r. Crossings are written to out[] (up to
+ * max_out, *n_out set to the number written). Consumption stops early
+ * when out[] is full, or right after the first valid bloom completes if
+ * stop_on_bloom is set. Returns the number of values consumed.
+ */
+size_t bloom_gate_feed(bloom_gate *g, const double *r, size_t n,
+                       bloom_crossing *out, size_t max_out, size_t *n_out,
+                       int stop_on_bloom);
+
+/* Has the first valid bloom been seen? */
+static inline int bloom_gate_has_bloom(const bloom_gate *g) {
+    return g->bloom_start != BLOOM_GATE_NO_BLOOM;
+}
+
+/* Ensemble detector: structure of arrays over n simulations */
+typedef struct {
+    size_t n;
+    double threshold;
+    uint32_t required_rounds;
+    uint64_t round;
+
+    uint32_t *run_len;
+    uint8_t *above;         /* previous round: 1 above, 2 below, 0 NaN/none */
+    int64_t *bloom_start;   /* per member, or BLOOM_GATE_NO_BLOOM */
+    uint32_t *n_up;
+    uint32_t *n_down;
+    size_t n_bloomed;
+} bloom_gate_ensemble;
+
+int bloom_gate_ensemble_init(bloom_gate_ensemble *e, size_t n,
+                             double threshold, uint32_t required_rounds);
+void bloom_gate_ensemble_free(bloom_gate_ensemble *e);
+
+/*
+ * Consume `rounds` rows of r values laid out [round][member]. Stops after
+ * the row in which every member has bloomed. Returns rows consumed.
+ */
+size_t bloom_gate_ensemble_feed(bloom_gate_ensemble *e, const double *r,
+                                size_t rounds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOOM_GATE_H */
@@ -0,0 +1,710 @@
+/*
+ * BloomCoin Columnar Header Archive
+ * =================================
+ *
+ * Compile: gcc -O3 -mavx2 -o bloom_headers bloom_headers.c -DTEST_MAIN -lm
+ *          gcc -O3 -mavx2 -shared -fPIC -o libbloom_headers.so bloom_headers.c
+ */
+
+#include "bloom_headers.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#define ARCHIVE_MAGIC   0x4C4F4348u     /* "HCOL" */
+#define ARCHIVE_VERSION 1
+#define N_COLUMNS       9
+
+#define ENC_RAW   0
+#define ENC_DELTA 1
+#define ENC_DICT  2
+
+#define DICT_MAX  256
+#define DICT_SLOTS 1024                 /* hash slots for distinct counting */
+
+/* Column ids, in header field order */
+enum {
+    COL_VERSION, COL_PREV_HASH, COL_MERKLE_ROOT, COL_TIMESTAMP, COL_DIFFICULTY,
+    COL_NONCE, COL_ORDER_PARAMETER, COL_MEAN_PHASE, COL_OSCILLATOR_COUNT
+};
+
+/* ========================================================================== */
+/* Helpers                                                                     */
+/* ========================================================================== */
+
+static void store32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint32_t load32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+           (uint32_t)p[3] << 24;
+}
+
+static float load_f32(const uint8_t *p) {
+    uint32_t u = load32(p);
+    float f;
+    memcpy(&f, &u, 4);
+    return f;
+}
+
+static void store_f32(uint8_t *p, float f) {
+    uint32_t u;
+    memcpy(&u, &f, 4);
+    store32(p, u);
+}
+
+/* ========================================================================== */
+/* Columns                                                                     */
+/* ========================================================================== */
+
+/* Aligned (re)allocation keeping the first n elements */
+static void *col_grow(void *old, size_t n, size_t cap, size_t elem) {
+    size_t bytes = (cap * elem + 63) & ~(size_t)63;
+    void *p = aligned_alloc(64, bytes ? bytes : 64);
+    if (p && old) memcpy(p, old, n * elem);
+    free(old);
+    return p;
+}
+
+static int reserve(bloom_headers *h, size_t need) {
+    if (need <= h->cap && h->version) return BLOOM_HEADERS_OK;
+    size_t cap = h->cap ? h->cap : 1024;
+    while (cap < need) cap *= 2;
+    h->version = (uint32_t *)col_grow(h->version, h->n, cap, 4);
+    h->timestamp = (uint32_t *)col_grow(h->timestamp, h->n, cap, 4);
+    h->difficulty = (uint32_t *)col_grow(h->difficulty, h->n, cap, 4);
+    h->nonce = (uint32_t *)col_grow(h->nonce, h->n, cap, 4);
+    h->order_parameter = (float *)col_grow(h->order_parameter, h->n, cap, 4);
+    h->mean_phase = (float *)col_grow(h->mean_phase, h->n, cap, 4);
+    h->oscillator_count = (uint32_t *)col_grow(h->oscillator_count, h->n, cap, 4);
+    h->prev_hash = (uint8_t (*)[32])col_grow(h->prev_hash, h->n, cap, 32);
+    h->merkle_root = (uint8_t (*)[32])col_grow(h->merkle_root, h->n, cap, 32);
+    if (!h->version || !h->timestamp || !h->difficulty || !h->nonce ||
+        !h->order_parameter || !h->mean_phase || !h->oscillator_count ||
+        !h->prev_hash || !h->merkle_root) {
+        bloom_headers_free(h);
+        return BLOOM_HEADERS_ERR_NOMEM;
+    }
+    h->cap = cap;
+    return BLOOM_HEADERS_OK;
+}
+
+int bloom_headers_init(bloom_headers *h, size_t cap) {
+    memset(h, 0, sizeof(*h));
+    return reserve(h, cap);
+}
+
+void bloom_headers_free(bloom_headers *h) {
+    free(h->version);
+    free(h->timestamp);
+    free(h->difficulty);
+    free(h->nonce);
+    free(h->order_parameter);
+    free(h->mean_phase);
+    free(h->oscillator_count);
+    free(h->prev_hash);
+    free(h->merkle_root);
+    memset(h, 0, sizeof(*h));
+}
+
+int bloom_headers_append(bloom_headers *h, const uint8_t *raw, size_t n, size_t stride) {
+    int st = reserve(h, h->n + n);
+    if (st != BLOOM_HEADERS_OK) return st;
+    for (size_t i = 0; i < n; i++) {
+        const uint8_t *p = raw + i * stride;
+        size_t j = h->n + i;
+        h->version[j] = load32(p);
+        memcpy(h->prev_hash[j], p + 4, 32);
+        memcpy(h->merkle_root[j], p + 36, 32);
+        h->timestamp[j] = load32(p + 68);
+        h->difficulty[j] = load32(p + 72);
+        h->nonce[j] = load32(p + 76);
+        h->order_parameter[j] = load_f32(p + 80);
+        h->mean_phase[j] = load_f32(p + 84);
+        h->oscillator_count[j] = load32(p + 88);
+    }
+    h->n += n;
+    return BLOOM_HEADERS_OK;
+}
+
+void bloom_headers_row(const bloom_headers *h, size_t i, uint8_t out[BLOOM_HEADER_SIZE]) {
+    store32(out, h->version[i]);
+    memcpy(out + 4, h->prev_hash[i], 32);
+    memcpy(out + 36, h->merkle_root[i], 32);
+    store32(out + 68, h->timestamp[i]);
+    store32(out + 72, h->difficulty[i]);
+    store32(out + 76, h->nonce[i]);
+    store_f32(out + 80, h->order_parameter[i]);
+    store_f32(out + 84, h->mean_phase[i]);
+    store32(out + 88, h->oscillator_count[i]);
+}
+
+/* ========================================================================== */
+/* Archive Encoding                                                            */
+/* ========================================================================== */
+
+/* Output cursor; with p == NULL only counts */
+typedef struct {
+    uint8_t *p;
+    size_t len, cap;
+} writer;
+
+static void put(writer *w, const void *src, size_t n) {
+    if (w->p && w->len + n <= w->cap) memcpy(w->p + w->len, src, n);
+    w->len += n;
+}
+
+static void put8(writer *w, uint8_t v) { put(w, &v, 1); }
+
+static void put32(writer *w, uint32_t v) {
+    uint8_t b[4];
+    store32(b, v);
+    put(w, b, 4);
+}
+
+static size_t varint_len(uint64_t v) {
+    size_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static void put_varint(writer *w, uint64_t v) {
+    uint8_t b[10];
+    size_t n = 0;
+    while (v >= 0x80) {
+        b[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    b[n++] = (uint8_t)v;
+    put(w, b, n);
+}
+
+static uint64_t zigzag(int64_t d) {
+    return ((uint64_t)d << 1) ^ (uint64_t)(d >> 63);
+}
+
+static uint64_t delta_of(const uint32_t *x, size_t i) {
+    return zigzag((int64_t)x[i] - (i ? (int64_t)x[i - 1] : 0));
+}
+
+/* Value -> dictionary code, codes assigned in first-seen order */
+typedef struct {
+    uint32_t value[DICT_SLOTS];
+    uint16_t code[DICT_SLOTS];      /* code + 1, 0 = empty */
+} dict_table;
+
+/* Code of v, adding it if new; -1 once the dictionary is full */
+static int dict_code(dict_table *t, uint32_t v, uint32_t *dict, size_t *k) {
+    uint32_t s = (v * 0x9E3779B1u) >> 22;
+    while (t->code[s]) {
+        if (t->value[s] == v) return t->code[s] - 1;
+        s = (s + 1) & (DICT_SLOTS - 1);
+    }
+    if (*k == DICT_MAX) return -1;
+    t->value[s] = v;
+    t->code[s] = (uint16_t)(*k + 1);
+    dict[*k] = v;
+    return (int)(*k)++;
+}
+
+static void put_u32_column(writer *w, int id, const uint32_t *x, size_t n) {
+    size_t delta = 0;
+    for (size_t i = 0; i < n; i++) delta += varint_len(delta_of(x, i));
+
+    dict_table t;
+    uint32_t dict[DICT_MAX];
+    size_t k = 0, i = 0;
+    memset(&t, 0, sizeof(t));
+    while (i < n && dict_code(&t, x[i], dict, &k) >= 0) i++;
+    size_t dict_size = i == n ? 2 + 4 * k + n : SIZE_MAX;
+
+    size_t raw = 4 * n;
+    put8(w, (uint8_t)id);
+    if (dict_size <= delta && dict_size < raw) {
+        put8(w, ENC_DICT);
+        put32(w, (uint32_t)dict_size);
+        uint8_t b[2] = { (uint8_t)k, (uint8_t)(k >> 8) };
+        put(w, b, 2);
+        for (size_t j = 0; j < k; j++) put32(w, dict[j]);
+        for (size_t j = 0; j < n; j++) put8(w, (uint8_t)dict_code(&t, x[j], dict, &k));
+    } else if (delta < raw) {
+        put8(w, ENC_DELTA);
+        put32(w, (uint32_t)delta);
+        for (size_t j = 0; j < n; j++) put_varint(w, delta_of(x, j));
+    } else {
+        put8(w, ENC_RAW);
+        put32(w, (uint32_t)raw);
+        for (size_t j = 0; j < n; j++) put32(w, x[j]);
+    }
+}
+
+static void put_f32_column(writer *w, int id, const float *x, size_t n) {
+    put8(w, (uint8_t)id);
+    put8(w, ENC_RAW);
+    put32(w, (uint32_t)(4 * n));
+    for (size_t i = 0; i < n; i++) {
+        uint32_t u;
+        memcpy(&u, &x[i], 4);
+        put32(w, u);
+    }
+}
+
+long bloom_headers_encode(const bloom_headers *h, uint8_t *out, size_t cap) {
+    writer w = { out, 0, cap };
+    put32(&w, ARCHIVE_MAGIC);
+    put32(&w, ARCHIVE_VERSION);
+    put32(&w, (uint32_t)h->n);
+    put_u32_column(&w, COL_VERSION, h->version, h->n);
+    put8(&w, COL_PREV_HASH);
+    put8(&w, ENC_RAW);
+    put32(&w, (uint32_t)(32 * h->n));
+    put(&w, h->prev_hash, 32 * h->n);
+    put8(&w, COL_MERKLE_ROOT);
+    put8(&w, ENC_RAW);
+    put32(&w, (uint32_t)(32 * h->n));
+    put(&w, h->merkle_root, 32 * h->n);
+    put_u32_column(&w, COL_TIMESTAMP, h->timestamp, h->n);
+    put_u32_column(&w, COL_DIFFICULTY, h->difficulty, h->n);
+    put_u32_column(&w, COL_NONCE, h->nonce, h->n);
+    put_f32_column(&w, COL_ORDER_PARAMETER, h->order_parameter, h->n);
+    put_f32_column(&w, COL_MEAN_PHASE, h->mean_phase, h->n);
+    put_u32_column(&w, COL_OSCILLATOR_COUNT, h->oscillator_count, h->n);
+    if (out && w.len > cap) return BLOOM_HEADERS_ERR_SPACE;
+    return (long)w.len;
+}
+
+/* ========================================================================== */
+/* Archive Decoding                                                            */
+/* ========================================================================== */
+
+static int get_u32_column(const uint8_t *p, size_t size, int enc, uint32_t *x, size_t n) {
+    const uint8_t *end = p + size;
+    if (enc == ENC_RAW) {
+        if (size != 4 * n) return BLOOM_HEADERS_ERR_FORMAT;
+        for (size_t i = 0; i < n; i++) x[i] = load32(p + 4 * i);
+        return BLOOM_HEADERS_OK;
+    }
+    if (enc == ENC_DELTA) {
+        int64_t prev = 0;
+        for (size_t i = 0; i < n; i++) {
+            uint64_t v = 0;
+            int shift = 0;
+            for (;;) {
+                if (p == end || shift > 63) return BLOOM_HEADERS_ERR_FORMAT;
+                uint8_t b = *p++;
+                v |= (uint64_t)(b & 0x7F) << shift;
+                shift += 7;
+                if (!(b & 0x80)) break;
+            }
+            prev += (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+            x[i] = (uint32_t)prev;
+        }
+        return p == end ? BLOOM_HEADERS_OK : BLOOM_HEADERS_ERR_FORMAT;
+    }
+    if (enc == ENC_DICT) {
+        if (size < 2) return BLOOM_HEADERS_ERR_FORMAT;
+        size_t k = (size_t)p[0] | (size_t)p[1] << 8;
+        if (k > DICT_MAX || size != 2 + 4 * k + n) return BLOOM_HEADERS_ERR_FORMAT;
+        const uint8_t *codes = p + 2 + 4 * k;
+        for (size_t i = 0; i < n; i++) {
+            if (codes[i] >= k) return BLOOM_HEADERS_ERR_FORMAT;
+            x[i] = load32(p + 2 + 4 * codes[i]);
+        }
+        return BLOOM_HEADERS_OK;
+    }
+    return BLOOM_HEADERS_ERR_FORMAT;
+}
+
+int bloom_headers_decode(bloom_headers *h, const uint8_t *buf, size_t len) {
+    if (len < 12 || load32(buf) != ARCHIVE_MAGIC || load32(buf + 4) != ARCHIVE_VERSION) {
+        return BLOOM_HEADERS_ERR_FORMAT;
+    }
+    size_t n = load32(buf + 8);
+    h->n = 0;
+    int st = reserve(h, n);
+    if (st != BLOOM_HEADERS_OK) return st;
+
+    const uint8_t *p = buf + 12, *end = buf + len;
+    for (int id = 0; id < N_COLUMNS; id++) {
+        if (end - p < 6 || p[0] != id) return BLOOM_HEADERS_ERR_FORMAT;
+        int enc = p[1];
+        size_t size = load32(p + 2);
+        p += 6;
+        if ((size_t)(end - p) < size) return BLOOM_HEADERS_ERR_FORMAT;
+
+        uint32_t *col = NULL;
+        float *fcol = NULL;
+        uint8_t (*hcol)[32] = NULL;
+        switch (id) {
+        case COL_VERSION: col = h->version; break;
+        case COL_PREV_HASH: hcol = h->prev_hash; break;
+        case COL_MERKLE_ROOT: hcol = h->merkle_root; break;
+        case COL_TIMESTAMP: col = h->timestamp; break;
+        case COL_DIFFICULTY: col = h->difficulty; break;
+        case COL_NONCE: col = h->nonce; break;
+        case COL_ORDER_PARAMETER: fcol = h->order_parameter; break;
+        case COL_MEAN_PHASE: fcol = h->mean_phase; break;
+        default: col = h->oscillator_count; break;
+        }
+        if (col) {
+            st = get_u32_column(p, size, enc, col, n);
+            if (st != BLOOM_HEADERS_OK) return st;
+        } else if (fcol) {
+            if (enc != ENC_RAW || size != 4 * n) return BLOOM_HEADERS_ERR_FORMAT;
+            for (size_t i = 0; i < n; i++) fcol[i] = load_f32(p + 4 * i);
+        } else {
+            if (enc != ENC_RAW || size != 32 * n) return BLOOM_HEADERS_ERR_FORMAT;
+            if (n) memcpy(hcol[0], p, size);
+        }
+        p += size;
+    }
+    if (p != end) return BLOOM_HEADERS_ERR_FORMAT;
+    h->n = n;
+    return BLOOM_HEADERS_OK;
+}
+
+/* ========================================================================== */
+/* Column Kernels                                                              */
+/* ========================================================================== */
+
+#if defined(__AVX2__)
+static double hsum_pd(__m256d v) {
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+#endif
+
+void bloom_col_stats_f32(const float *x, size_t n, bloom_col_stats *out) {
+    out->n = n;
+    out->sum = out->sum_sq = 0;
+    out->min = out->max = 0;
+    if (n == 0) return;
+    float lo = x[0], hi = x[0];
+    double sum = 0, sum_sq = 0;
+    size_t i = 0;
+#if defined(__AVX2__)
+    if (n >= 8) {
+        __m256 vlo = _mm256_loadu_ps(x), vhi = vlo;
+        __m256d s0 = _mm256_setzero_pd(), s1 = s0, q0 = s0, q1 = s0;
+        for (; i + 8 <= n; i += 8) {
+            __m256 v = _mm256_loadu_ps(x + i);
+            vlo = _mm256_min_ps(vlo, v);
+            vhi = _mm256_max_ps(vhi, v);
+            __m256d a = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+            __m256d b = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+            s0 = _mm256_add_pd(s0, a);
+            s1 = _mm256_add_pd(s1, b);
+            q0 = _mm256_add_pd(q0, _mm256_mul_pd(a, a));
+            q1 = _mm256_add_pd(q1, _mm256_mul_pd(b, b));
+        }
+        float l[8], h[8];
+        _mm256_storeu_ps(l, vlo);
+        _mm256_storeu_ps(h, vhi);
+        for (int j = 0; j < 8; j++) {
+            if (l[j] < lo) lo = l[j];
+            if (h[j] > hi) hi = h[j];
+        }
+        sum = hsum_pd(_mm256_add_pd(s0, s1));
+        sum_sq = hsum_pd(_mm256_add_pd(q0, q1));
+    }
+#endif
+    for (; i < n; i++) {
+        if (x[i] < lo) lo = x[i];
+        if (x[i] > hi) hi = x[i];
+        sum += x[i];
+        sum_sq += (double)x[i] * x[i];
+    }
+    out->min = lo;
+    out->max = hi;
+    out->sum = sum;
+    out->sum_sq = sum_sq;
+}
+
+size_t bloom_col_count_ge_f32(const float *x, size_t n, float threshold) {
+    size_t count = 0, i = 0;
+#if defined(__AVX2__)
+    __m256 t = _mm256_set1_ps(threshold);
+    for (; i + 8 <= n; i += 8) {
+        __m256 m = _mm256_cmp_ps(_mm256_loadu_ps(x + i), t, _CMP_GE_OQ);
+        count += (size_t)__builtin_popcount((unsigned)_mm256_movemask_ps(m));
+    }
+#endif
+    for (; i < n; i++) count += x[i] >= threshold;
+    return count;
+}
+
+size_t bloom_col_select_ge_f32(const float *x, size_t n, float threshold, uint32_t *idx) {
+    size_t count = 0, i = 0;
+#if defined(__AVX2__)
+    __m256 t = _mm256_set1_ps(threshold);
+    for (; i + 8 <= n; i += 8) {
+        unsigned bits = (unsigned)_mm256_movemask_ps(
+            _mm256_cmp_ps(_mm256_loadu_ps(x + i), t, _CMP_GE_OQ));
+        while (bits) {
+            idx[count++] = (uint32_t)(i + (size_t)__builtin_ctz(bits));
+            bits &= bits - 1;
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (x[i] >= threshold) idx[count++] = (uint32_t)i;
+    }
+    return count;
+}
+
+void bloom_col_deltas_u32(const uint32_t *x, size_t n, int32_t *out) {
+    if (n == 0) return;
+    out[0] = 0;
+    size_t i = 1;
+#if defined(__AVX2__)
+    for (; i + 8 <= n; i += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(x + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(x + i - 1));
+        _mm256_storeu_si256((__m256i *)(out + i), _mm256_sub_epi32(a, b));
+    }
+#endif
+    for (; i < n; i++) out[i] = (int32_t)(x[i] - x[i - 1]);
+}
+
+static double sum_f32(const float *x, size_t n) {
+    double sum = 0;
+    size_t i = 0;
+#if defined(__AVX2__)
+    __m256d s0 = _mm256_setzero_pd(), s1 = s0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(x + i);
+        s0 = _mm256_add_pd(s0, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+        s1 = _mm256_add_pd(s1, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+    }
+    sum = hsum_pd(_mm256_add_pd(s0, s1));
+#endif
+    for (; i < n; i++) sum += x[i];
+    return sum;
+}
+
+static uint64_t sum_u32(const uint32_t *x, size_t n) {
+    uint64_t sum = 0;
+    size_t i = 0;
+#if defined(__AVX2__)
+    __m256i s = _mm256_setzero_si256();
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(x + i));
+        s = _mm256_add_epi64(s, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v)));
+        s = _mm256_add_epi64(s, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+    uint64_t l[4];
+    _mm256_storeu_si256((__m256i *)l, s);
+    sum = l[0] + l[1] + l[2] + l[3];
+#endif
+    for (; i < n; i++) sum += x[i];
+    return sum;
+}
+
+void bloom_col_window_mean_f32(const float *x, size_t n, size_t window, float *out) {
+    for (size_t w = 0, i = 0; i < n; w++, i += window) {
+        size_t len = n - i < window ? n - i : window;
+        out[w] = (float)(sum_f32(x + i, len) / (double)len);
+    }
+}
+
+void bloom_col_window_mean_u32(const uint32_t *x, size_t n, size_t window, double *out) {
+    for (size_t w = 0, i = 0; i < n; w++, i += window) {
+        size_t len = n - i < window ? n - i : window;
+        out[w] = (double)sum_u32(x + i, len) / (double)len;
+    }
+}
+
+size_t bloom_col_runs_u32(const uint32_t *x, size_t n, uint32_t *starts) {
+    if (n == 0) return 0;
+    size_t count = 0, i = 1;
+    starts[count++] = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= n; i += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(x + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(x + i - 1));
+        unsigned bits = ~(unsigned)_mm256_movemask_ps(
+            _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b))) & 0xFF;
+        while (bits) {
+            starts[count++] = (uint32_t)(i + (size_t)__builtin_ctz(bits));
+            bits &= bits - 1;
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (x[i] != x[i - 1]) starts[count++] = (uint32_t)i;
+    }
+    return count;
+}
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+static uint64_t test_rng = 0x9E3779B97F4A7C15ull;
+
+static uint64_t xorshift(void) {
+    test_rng ^= test_rng << 13;
+    test_rng ^= test_rng >> 7;
+    test_rng ^= test_rng << 17;
+    return test_rng;
+}
+
+static float frand(void) {
+    return (float)(xorshift() >> 40) / (float)(1 << 24);
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(void) {
+    int fail = 0, ok;
+    printf("BloomCoin Columnar Header Archive\n");
+    printf("=================================\n\n");
+
+    enum { N = 123 * 8000 + 77, INTERVAL = 123 };
+    const float z_c = 0.8660254f;
+
+    /* Synthetic chain: retargets every INTERVAL blocks, ~60 s spacing */
+    uint8_t *raw = malloc((size_t)N * BLOOM_HEADER_SIZE);
+    uint32_t ts = 1700000000u, diff = 0x1d00ffffu;
+    const uint32_t counts[3] = { 7, 64, 256 };
+    for (size_t i = 0; i < N; i++) {
+        uint8_t *p = raw + i * BLOOM_HEADER_SIZE;
+        if (i && i % INTERVAL == 0) diff += (uint32_t)(xorshift() % 2001) - 1000;
+        ts += 30 + (uint32_t)(xorshift() % 61);
+        store32(p, 1);
+        for (int j = 0; j < 64; j++) p[4 + j] = (uint8_t)xorshift();
+        store32(p + 68, ts);
+        store32(p + 72, diff);
+        store32(p + 76, (uint32_t)xorshift());
+        store_f32(p + 80, 0.8f + 0.2f * frand());
+        store_f32(p + 84, 6.2831853f * frand() - 3.1415927f);
+        store32(p + 88, counts[xorshift() % 3]);
+    }
+
+    bloom_headers h;
+    bloom_headers_init(&h, 0);
+    double t0 = now_sec();
+    bloom_headers_append(&h, raw, N, BLOOM_HEADER_SIZE);
+    double t1 = now_sec();
+    uint8_t row[BLOOM_HEADER_SIZE];
+    ok = h.n == N && ((uintptr_t)h.order_parameter & 63) == 0;
+    for (size_t i = 0; i < N && ok; i += 997) {
+        bloom_headers_row(&h, i, row);
+        ok = memcmp(row, raw + i * BLOOM_HEADER_SIZE, BLOOM_HEADER_SIZE) == 0;
+    }
+    printf("columns from headers:     %d rows in %.1f ms  %s\n", N, 1e3 * (t1 - t0),
+           ok ? "OK" : "FAIL");
+    fail |= !ok;
+
+    /* Archive round trip */
+    long size = bloom_headers_encode(&h, NULL, 0);
+    uint8_t *arc = malloc((size_t)size);
+    ok = bloom_headers_encode(&h, arc, (size_t)size) == size &&
+         bloom_headers_encode(&h, arc, (size_t)size - 1) == BLOOM_HEADERS_ERR_SPACE;
+    bloom_headers d;
+    bloom_headers_init(&d, 0);
+    ok &= bloom_headers_decode(&d, arc, (size_t)size) == BLOOM_HEADERS_OK && d.n == N;
+    for (size_t i = 0; i < N && ok; i++) {
+        bloom_headers_row(&d, i, row);
+        ok = memcmp(row, raw + i * BLOOM_HEADER_SIZE, BLOOM_HEADER_SIZE) == 0;
+    }
+    ok &= bloom_headers_decode(&d, arc, (size_t)size - 1) == BLOOM_HEADERS_ERR_FORMAT;
+    printf("archive round trip:       %ld bytes (%.1f%% of raw)  %s\n", size,
+           100.0 * size / ((double)N * BLOOM_HEADER_SIZE), ok ? "OK" : "FAIL");
+    fail |= !ok;
+    {
+        /* Constant and slowly drifting columns compress, random ones do not */
+        const uint8_t *p = arc + 12;
+        int encs[N_COLUMNS];
+        for (int c = 0; c < N_COLUMNS; c++) {
+            encs[c] = p[1];
+            p += 6 + load32(p + 2);
+        }
+        ok = encs[COL_VERSION] != ENC_RAW && encs[COL_TIMESTAMP] == ENC_DELTA &&
+             encs[COL_DIFFICULTY] == ENC_DELTA && encs[COL_NONCE] == ENC_RAW &&
+             encs[COL_OSCILLATOR_COUNT] == ENC_DICT;
+        printf("column encodings:         %d %d %d %d %d  %s\n", encs[COL_VERSION],
+               encs[COL_TIMESTAMP], encs[COL_DIFFICULTY], encs[COL_NONCE],
+               encs[COL_OSCILLATOR_COUNT], ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Kernels against scalar references */
+    {
+        bloom_col_stats s;
+        t0 = now_sec();
+        bloom_col_stats_f32(h.order_parameter, N, &s);
+        size_t coherent = bloom_col_count_ge_f32(h.order_parameter, N, z_c);
+        t1 = now_sec();
+        double ref_sum = 0;
+        float ref_lo = 2, ref_hi = -2;
+        size_t ref_count = 0;
+        for (size_t i = 0; i < N; i++) {
+            float v = h.order_parameter[i];
+            ref_sum += v;
+            if (v < ref_lo) ref_lo = v;
+            if (v > ref_hi) ref_hi = v;
+            ref_count += v >= z_c;
+        }
+        ok = fabs(s.sum - ref_sum) < 1e-6 * ref_sum && s.min == ref_lo && s.max == ref_hi &&
+             coherent == ref_count;
+        uint32_t *idx = malloc(N * sizeof(uint32_t));
+        size_t sel = bloom_col_select_ge_f32(h.order_parameter, N, z_c, idx);
+        ok &= sel == ref_count;
+        for (size_t j = 0; j < sel && ok; j++) ok = h.order_parameter[idx[j]] >= z_c;
+        printf("order_parameter scan:     mean %.4f, %zu >= Z_C, %.2f ms  %s\n",
+               s.sum / s.n, coherent, 1e3 * (t1 - t0), ok ? "OK" : "FAIL");
+        fail |= !ok;
+
+        int32_t *dt = malloc(N * sizeof(int32_t));
+        size_t n_win = (N + INTERVAL - 1) / INTERVAL;
+        double *interval = malloc(n_win * sizeof(double));
+        float *win_r = malloc(n_win * sizeof(float));
+        t0 = now_sec();
+        bloom_col_deltas_u32(h.timestamp, N, dt);
+        size_t runs = bloom_col_runs_u32(h.difficulty, N, idx);
+        bloom_col_window_mean_u32((const uint32_t *)dt + 1, N - 1, INTERVAL, interval);
+        bloom_col_window_mean_f32(h.order_parameter, N, INTERVAL, win_r);
+        t1 = now_sec();
+        ok = dt[0] == 0;
+        for (size_t i = 1; i < N && ok; i++) ok = dt[i] >= 30 && dt[i] <= 90;
+        ok &= fabs(interval[0] - 60) < 5 && fabs(interval[n_win / 2] - 60) < 5;
+        double ref_w = 0;
+        for (int i = 0; i < INTERVAL; i++) ref_w += h.order_parameter[INTERVAL + i];
+        ok &= fabsf(win_r[1] - (float)(ref_w / INTERVAL)) < 1e-6f;
+        size_t ref_runs = 1;
+        for (size_t i = 1; i < N; i++) ref_runs += h.difficulty[i] != h.difficulty[i - 1];
+        ok &= runs == ref_runs && runs <= n_win && idx[1] % INTERVAL == 0;
+        printf("retarget study:           %zu epochs, %zu difficulty runs, %.2f ms  %s\n",
+               n_win, runs, 1e3 * (t1 - t0), ok ? "OK" : "FAIL");
+        fail |= !ok;
+        free(idx);
+        free(dt);
+        free(interval);
+        free(win_r);
+    }
+
+    bloom_headers_free(&d);
+    bloom_headers_free(&h);
+    free(arc);
+    free(raw);
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
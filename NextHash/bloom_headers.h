@@ -0,0 +1,104 @@
+/*
+ * BloomCoin Columnar Header Archive
+ * =================================
+ *
+ * The header chain as one contiguous typed column per PhaseEncodedHeader
+ * field (core/hash_wrapper.py), so coherence and retarget studies scan
+ * plain arrays instead of materializing header objects.
+ *
+ * Features:
+ * - Columns built from raw 92-byte headers at any stride (a header array,
+ *   or block data from bloom_store_range(), which starts with the header)
+ * - 64-byte aligned columns; NumPy wraps them without copying
+ *   (bloomcoin/core/header_columns.py: HeaderColumns.order_parameter etc.)
+ * - Archive format choosing per column between raw, delta (zigzag varint;
+ *   timestamps) and dictionary (u8 codes; difficulty, version,
+ *   oscillator_count) encoding, whichever is smallest
+ * - Scan / aggregate kernels in AVX2 when compiled with -mavx2: stats,
+ *   threshold count and select, deltas, per-window means and value runs
+ *   (difficulty retarget points)
+ *
+ * Archive: magic u32 | version u32 | n u32 | 9 columns of
+ *          { id u8 | encoding u8 | size u32 | payload }   (little-endian)
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef BLOOM_HEADERS_H
+#define BLOOM_HEADERS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLOOM_HEADER_SIZE 92
+
+/* Status codes */
+#define BLOOM_HEADERS_OK            0
+#define BLOOM_HEADERS_ERR_NOMEM    -1
+#define BLOOM_HEADERS_ERR_FORMAT   -2   /* archive malformed or truncated */
+#define BLOOM_HEADERS_ERR_SPACE    -3   /* output buffer too small */
+
+typedef struct {
+    size_t n, cap;
+    uint32_t *version;
+    uint32_t *timestamp;
+    uint32_t *difficulty;
+    uint32_t *nonce;
+    float *order_parameter;
+    float *mean_phase;
+    uint32_t *oscillator_count;
+    uint8_t (*prev_hash)[32];
+    uint8_t (*merkle_root)[32];
+} bloom_headers;
+
+typedef struct {
+    size_t n;
+    float min, max;
+    double sum, sum_sq;
+} bloom_col_stats;
+
+int bloom_headers_init(bloom_headers *h, size_t cap);
+void bloom_headers_free(bloom_headers *h);
+
+/* Append n serialized headers, header i at raw + i * stride */
+int bloom_headers_append(bloom_headers *h, const uint8_t *raw, size_t n, size_t stride);
+
+/* Serialize row i back to its 92 bytes */
+void bloom_headers_row(const bloom_headers *h, size_t i, uint8_t out[BLOOM_HEADER_SIZE]);
+
+/* Archive; with out == NULL only the size is returned. Bytes or < 0 */
+long bloom_headers_encode(const bloom_headers *h, uint8_t *out, size_t cap);
+
+/* Replace the contents of an initialized h with an archive */
+int bloom_headers_decode(bloom_headers *h, const uint8_t *buf, size_t len);
+
+/* ========================================================================== */
+/* Column Kernels                                                              */
+/* ========================================================================== */
+
+void bloom_col_stats_f32(const float *x, size_t n, bloom_col_stats *out);
+
+/* Elements >= threshold: count, or their indices into idx */
+size_t bloom_col_count_ge_f32(const float *x, size_t n, float threshold);
+size_t bloom_col_select_ge_f32(const float *x, size_t n, float threshold, uint32_t *idx);
+
+/* out[0] = 0, out[i] = x[i] - x[i-1] */
+void bloom_col_deltas_u32(const uint32_t *x, size_t n, int32_t *out);
+
+/* Mean of each window of `window` elements (last may be short) */
+void bloom_col_window_mean_f32(const float *x, size_t n, size_t window, float *out);
+void bloom_col_window_mean_u32(const uint32_t *x, size_t n, size_t window, double *out);
+
+/* Start index of every run of equal values; returns the number of runs */
+size_t bloom_col_runs_u32(const uint32_t *x, size_t n, uint32_t *starts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOOM_HEADERS_H */
@@ -0,0 +1,817 @@
+/*
+ * BloomCoin Sparse Lattice Kuramoto Engine
+ * ========================================
+ *
+ * Compile: gcc -O3 -c nexthash256.c
+ *          gcc -O3 -mavx2 -c nexthash_rng.c
+ *          gcc -O3 -mavx2 -mfma -fopenmp -o bloom_lattice bloom_lattice.c \
+ *              nexthash_rng.o nexthash256.o -lm -DTEST_MAIN
+ */
+
+#include "bloom_lattice.h"
+#include "nexthash_rng.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#define TWO_PI_F   6.28318530717958647692f
+#define INV_2PI_F  0.15915494309189533577f
+#define PI_F       3.14159265358979323846f
+
+/* Sites per work block in the step kernel */
+#define LATTICE_BLOCK 256
+
+/* Gaussians generated per task in the noise kernel */
+#define NOISE_BLOCK 4096
+
+/* ========================================================================== */
+/* Vectorizable Sine                                                           */
+/* ========================================================================== */
+
+/*
+ * sin(x) for |x| < ~1e4. Reduce to [-pi, pi], fold onto [0, pi/2] using
+ * sin(x) = sin(pi - x), then a degree-11 odd polynomial (error < 1e-7).
+ * Branch-free so the neighbour loop vectorizes.
+ */
+static inline float fast_sinf(float x) {
+    x -= TWO_PI_F * rintf(x * INV_2PI_F);
+    float ax = fabsf(x);
+    float y = fminf(ax, PI_F - ax);
+    float y2 = y * y;
+    float p = -2.5052108385441720e-08f;
+    p = p * y2 + 2.7557319223985893e-06f;
+    p = p * y2 - 1.9841269841269841e-04f;
+    p = p * y2 + 8.3333333333333333e-03f;
+    p = p * y2 - 1.6666666666666667e-01f;
+    p = p * y2 * y + y;
+    return copysignf(p, x);
+}
+
+#if defined(__AVX2__)
+/* Eight lanes of fast_sinf() */
+static inline __m256 fast_sin_ps(__m256 x) {
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 k = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(INV_2PI_F)),
+                               _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    x = _mm256_sub_ps(x, _mm256_mul_ps(k, _mm256_set1_ps(TWO_PI_F)));
+    __m256 ax = _mm256_andnot_ps(sign, x);
+    __m256 y = _mm256_min_ps(ax, _mm256_sub_ps(_mm256_set1_ps(PI_F), ax));
+    __m256 y2 = _mm256_mul_ps(y, y);
+    __m256 p = _mm256_set1_ps(-2.5052108385441720e-08f);
+    p = _mm256_add_ps(_mm256_mul_ps(p, y2), _mm256_set1_ps(2.7557319223985893e-06f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, y2), _mm256_set1_ps(-1.9841269841269841e-04f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, y2), _mm256_set1_ps(8.3333333333333333e-03f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, y2), _mm256_set1_ps(-1.6666666666666667e-01f));
+    p = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(p, y2), y), y);
+    return _mm256_xor_ps(p, _mm256_and_ps(x, sign));
+}
+#endif
+
+/* ========================================================================== */
+/* Construction                                                                */
+/* ========================================================================== */
+
+static int lattice_alloc(bloom_lattice *lat, uint32_t n, uint32_t width) {
+    memset(lat, 0, sizeof(*lat));
+    lat->n = n;
+    lat->width = width;
+    size_t slots = (size_t)n * width;
+    lat->nbr = (uint32_t *)malloc((slots ? slots : 1) * sizeof(uint32_t));
+    lat->w = (float *)malloc((slots ? slots : 1) * sizeof(float));
+    lat->x = (double *)malloc((n ? n : 1) * sizeof(double));
+    lat->y = (double *)malloc((n ? n : 1) * sizeof(double));
+    lat->perm = (uint32_t *)malloc((n ? n : 1) * sizeof(uint32_t));
+    if (!lat->nbr || !lat->w || !lat->x || !lat->y || !lat->perm) {
+        bloom_lattice_free(lat);
+        return -1;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        lat->perm[i] = i;
+    }
+    /* Padding: self-neighbour with zero weight contributes nothing */
+    for (uint32_t k = 0; k < width; k++) {
+        for (uint32_t i = 0; i < n; i++) {
+            lat->nbr[(size_t)k * n + i] = i;
+            lat->w[(size_t)k * n + i] = 0.0f;
+        }
+    }
+    return 0;
+}
+
+void bloom_lattice_free(bloom_lattice *lat) {
+    free(lat->nbr);
+    free(lat->w);
+    free(lat->x);
+    free(lat->y);
+    free(lat->perm);
+    memset(lat, 0, sizeof(*lat));
+}
+
+int bloom_lattice_hexagon(bloom_lattice *lat, uint32_t n_rings) {
+    int64_t R = n_rings;
+    uint64_t n64 = 3 * (uint64_t)R * (uint64_t)(R + 1) + 1;
+    if (n64 > UINT32_MAX) {
+        return -1;
+    }
+    uint32_t n = (uint32_t)n64;
+    if (lattice_alloc(lat, n, 6) != 0) {
+        return -1;
+    }
+
+    /* Axial coordinates (q, r), |q|, |r|, |q + r| <= R, row-major in r */
+    uint32_t *row_start = (uint32_t *)malloc((size_t)(2 * R + 1) * sizeof(uint32_t));
+    if (!row_start) {
+        bloom_lattice_free(lat);
+        return -1;
+    }
+    const double h = 0.86602540378443864676;    /* sqrt(3)/2 */
+    uint32_t idx = 0;
+    for (int64_t r = -R; r <= R; r++) {
+        int64_t q0 = (-R > -r - R) ? -R : -r - R;
+        int64_t q1 = (R < -r + R) ? R : -r + R;
+        row_start[r + R] = idx - (uint32_t)(q0 + R);
+        for (int64_t q = q0; q <= q1; q++) {
+            lat->x[idx] = (double)q + 0.5 * (double)r;
+            lat->y[idx] = h * (double)r;
+            idx++;
+        }
+    }
+
+    static const int dq[6] = { 1, 1, 0, -1, -1, 0 };
+    static const int dr[6] = { 0, -1, -1, 0, 1, 1 };
+    idx = 0;
+    for (int64_t r = -R; r <= R; r++) {
+        int64_t q0 = (-R > -r - R) ? -R : -r - R;
+        int64_t q1 = (R < -r + R) ? R : -r + R;
+        for (int64_t q = q0; q <= q1; q++, idx++) {
+            for (int k = 0; k < 6; k++) {
+                int64_t nq = q + dq[k], nr = r + dr[k];
+                if (nq < -R || nq > R || nr < -R || nr > R ||
+                    nq + nr < -R || nq + nr > R) {
+                    continue;
+                }
+                size_t slot = (size_t)k * n + idx;
+                lat->nbr[slot] = row_start[nr + R] + (uint32_t)(nq + R);
+                lat->w[slot] = 0.5f;    /* 1 / (1 + 1) */
+            }
+        }
+    }
+
+    free(row_start);
+    return 0;
+}
+
+/* Cell grid over the bounding box; cells at least `cutoff` wide */
+typedef struct {
+    double x0, y0, cell;
+    uint32_t nx, ny;
+    uint32_t *start;        /* [nx*ny + 1] */
+    uint32_t *items;        /* point indices grouped by cell */
+} cell_grid;
+
+static uint32_t grid_cell(const cell_grid *g, double x, double y, uint32_t *cx, uint32_t *cy) {
+    uint32_t ix = (uint32_t)((x - g->x0) / g->cell);
+    uint32_t iy = (uint32_t)((y - g->y0) / g->cell);
+    if (ix >= g->nx) ix = g->nx - 1;
+    if (iy >= g->ny) iy = g->ny - 1;
+    *cx = ix;
+    *cy = iy;
+    return iy * g->nx + ix;
+}
+
+static int grid_build(cell_grid *g, const double *xy, uint32_t n, double cutoff) {
+    double x0 = xy[0], x1 = xy[0], y0 = xy[1], y1 = xy[1];
+    for (uint32_t i = 1; i < n; i++) {
+        if (xy[2 * i] < x0) x0 = xy[2 * i];
+        if (xy[2 * i] > x1) x1 = xy[2 * i];
+        if (xy[2 * i + 1] < y0) y0 = xy[2 * i + 1];
+        if (xy[2 * i + 1] > y1) y1 = xy[2 * i + 1];
+    }
+    /* Coarsen sparse clouds so the grid stays O(n) */
+    double cell = cutoff;
+    for (;;) {
+        double fx = (x1 - x0) / cell + 1.0, fy = (y1 - y0) / cell + 1.0;
+        if (fx * fy <= 4.0 * n + 16.0) {
+            g->nx = (uint32_t)fx;
+            g->ny = (uint32_t)fy;
+            break;
+        }
+        cell *= 2.0;
+    }
+    g->x0 = x0;
+    g->y0 = y0;
+    g->cell = cell;
+
+    size_t cells = (size_t)g->nx * g->ny;
+    g->start = (uint32_t *)calloc(cells + 1, sizeof(uint32_t));
+    g->items = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+    uint32_t *cell_of = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+    if (!g->start || !g->items || !cell_of) {
+        free(g->start);
+        free(g->items);
+        free(cell_of);
+        return -1;
+    }
+
+    /* Counting sort of points by cell */
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t cx, cy;
+        cell_of[i] = grid_cell(g, xy[2 * i], xy[2 * i + 1], &cx, &cy);
+        g->start[cell_of[i] + 1]++;
+    }
+    for (size_t c = 0; c < cells; c++) {
+        g->start[c + 1] += g->start[c];
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        g->items[g->start[cell_of[i]]++] = i;
+    }
+    for (size_t c = cells; c > 0; c--) {
+        g->start[c] = g->start[c - 1];
+    }
+    g->start[0] = 0;
+
+    free(cell_of);
+    return 0;
+}
+
+/*
+ * Visit neighbours of point i (dist < cutoff, j != i). With out == NULL
+ * only counts; otherwise writes ELL slots. Returns the degree.
+ */
+static uint32_t grid_neighbours(const cell_grid *g, const double *xy, uint32_t i,
+                                double cutoff, bloom_lattice *out) {
+    uint32_t cx, cy, deg = 0;
+    double xi = xy[2 * i], yi = xy[2 * i + 1];
+    double c2 = cutoff * cutoff;
+    grid_cell(g, xi, yi, &cx, &cy);
+
+    uint32_t ya = cy ? cy - 1 : 0, yb = cy + 1 < g->ny ? cy + 1 : cy;
+    uint32_t xa = cx ? cx - 1 : 0, xb = cx + 1 < g->nx ? cx + 1 : cx;
+    for (uint32_t y = ya; y <= yb; y++) {
+        for (uint32_t x = xa; x <= xb; x++) {
+            uint32_t c = y * g->nx + x;
+            for (uint32_t t = g->start[c]; t < g->start[c + 1]; t++) {
+                uint32_t j = g->items[t];
+                double dx = xy[2 * j] - xi, dy = xy[2 * j + 1] - yi;
+                double d2 = dx * dx + dy * dy;
+                if (j == i || d2 >= c2) {
+                    continue;
+                }
+                if (out) {
+                    size_t slot = (size_t)deg * out->n + i;
+                    out->nbr[slot] = j;
+                    out->w[slot] = (float)(1.0 / (1.0 + sqrt(d2)));
+                }
+                deg++;
+            }
+        }
+    }
+    return deg;
+}
+
+int bloom_lattice_from_coords(bloom_lattice *lat, const double *xy, uint32_t n,
+                              double cutoff) {
+    if (n == 0 || !(cutoff > 0.0)) {
+        return -1;
+    }
+    cell_grid g;
+    if (grid_build(&g, xy, n, cutoff) != 0) {
+        return -1;
+    }
+
+    uint32_t width = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t d = grid_neighbours(&g, xy, i, cutoff, NULL);
+        if (d > width) width = d;
+    }
+
+    int rc = lattice_alloc(lat, n, width);
+    if (rc == 0) {
+        for (uint32_t i = 0; i < n; i++) {
+            lat->x[i] = xy[2 * i];
+            lat->y[i] = xy[2 * i + 1];
+            grid_neighbours(&g, xy, i, cutoff, lat);
+        }
+    }
+    free(g.start);
+    free(g.items);
+    return rc;
+}
+
+/* ========================================================================== */
+/* Space-Filling Curve Ordering                                                */
+/* ========================================================================== */
+
+static uint32_t spread16(uint32_t v) {
+    v &= 0xFFFF;
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+static uint32_t morton_key(uint32_t x, uint32_t y) {
+    return spread16(x) | (spread16(y) << 1);
+}
+
+/* Distance along a 2^16 x 2^16 Hilbert curve */
+static uint32_t hilbert_key(uint32_t x, uint32_t y) {
+    uint32_t d = 0;
+    for (uint32_t s = 1u << 15; s > 0; s >>= 1) {
+        uint32_t rx = (x & s) ? 1 : 0;
+        uint32_t ry = (y & s) ? 1 : 0;
+        d += s * s * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - x;
+                y = s - 1 - y;
+            }
+            uint32_t t = x;
+            x = y;
+            y = t;
+        }
+    }
+    return d;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+int bloom_lattice_reorder(bloom_lattice *lat, int order) {
+    uint32_t n = lat->n, W = lat->width;
+    if (order == BLOOM_ORDER_NATIVE || n < 2) {
+        return 0;
+    }
+    if (order != BLOOM_ORDER_MORTON && order != BLOOM_ORDER_HILBERT) {
+        return -1;
+    }
+
+    double x0 = lat->x[0], x1 = lat->x[0], y0 = lat->y[0], y1 = lat->y[0];
+    for (uint32_t i = 1; i < n; i++) {
+        if (lat->x[i] < x0) x0 = lat->x[i];
+        if (lat->x[i] > x1) x1 = lat->x[i];
+        if (lat->y[i] < y0) y0 = lat->y[i];
+        if (lat->y[i] > y1) y1 = lat->y[i];
+    }
+    double span = (x1 - x0) > (y1 - y0) ? (x1 - x0) : (y1 - y0);
+    double scale = span > 0.0 ? 65535.0 / span : 0.0;
+
+    /* (key << 32 | old index), sorted: ties keep the old order */
+    uint64_t *keyed = (uint64_t *)malloc((size_t)n * sizeof(uint64_t));
+    uint32_t *inv = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+    bloom_lattice nl;
+    if (!keyed || !inv || lattice_alloc(&nl, n, W) != 0) {
+        free(keyed);
+        free(inv);
+        return -1;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t qx = (uint32_t)((lat->x[i] - x0) * scale + 0.5);
+        uint32_t qy = (uint32_t)((lat->y[i] - y0) * scale + 0.5);
+        uint32_t key = order == BLOOM_ORDER_MORTON ? morton_key(qx, qy)
+                                                   : hilbert_key(qx, qy);
+        keyed[i] = ((uint64_t)key << 32) | i;
+    }
+    qsort(keyed, n, sizeof(uint64_t), cmp_u64);
+    for (uint32_t i = 0; i < n; i++) {
+        inv[(uint32_t)keyed[i]] = i;
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t o = (uint32_t)keyed[i];
+        nl.x[i] = lat->x[o];
+        nl.y[i] = lat->y[o];
+        nl.perm[i] = lat->perm[o];
+        for (uint32_t k = 0; k < W; k++) {
+            nl.nbr[(size_t)k * n + i] = inv[lat->nbr[(size_t)k * n + o]];
+            nl.w[(size_t)k * n + i] = lat->w[(size_t)k * n + o];
+        }
+    }
+
+    free(keyed);
+    free(inv);
+    bloom_lattice_free(lat);
+    *lat = nl;
+    return 0;
+}
+
+void bloom_lattice_gather(const bloom_lattice *lat, const float *src, float *dst) {
+    for (uint32_t i = 0; i < lat->n; i++) {
+        dst[i] = src[lat->perm[i]];
+    }
+}
+
+void bloom_lattice_scatter(const bloom_lattice *lat, const float *src, float *dst) {
+    for (uint32_t i = 0; i < lat->n; i++) {
+        dst[lat->perm[i]] = src[i];
+    }
+}
+
+/* ========================================================================== */
+/* Integration                                                                 */
+/* ========================================================================== */
+
+/* One Euler step over sites [b, e) from ph into out */
+static void step_block(const bloom_lattice *lat, const float *restrict ph,
+                       float *restrict out, const float *omega,
+                       float K, float dt, uint32_t b, uint32_t e) {
+    float acc[LATTICE_BLOCK];
+    uint32_t len = e - b, n = lat->n;
+    const float *self = ph + b;
+
+    for (uint32_t i = 0; i < len; i++) {
+        acc[i] = 0.0f;
+    }
+    for (uint32_t k = 0; k < lat->width; k++) {
+        const uint32_t *restrict nb = lat->nbr + (size_t)k * n + b;
+        const float *restrict wk = lat->w + (size_t)k * n + b;
+        uint32_t i = 0;
+#if defined(__AVX2__)
+        /* Site indices are < 2^31 for any lattice that fits in memory */
+        for (; i + 8 <= len; i += 8) {
+            __m256i idx = _mm256_loadu_si256((const __m256i *)(nb + i));
+            __m256 d = _mm256_sub_ps(_mm256_i32gather_ps(ph, idx, 4),
+                                     _mm256_loadu_ps(self + i));
+            __m256 a = _mm256_loadu_ps(acc + i);
+            a = _mm256_add_ps(a, _mm256_mul_ps(_mm256_loadu_ps(wk + i), fast_sin_ps(d)));
+            _mm256_storeu_ps(acc + i, a);
+        }
+#endif
+        for (; i < len; i++) {
+            acc[i] += wk[i] * fast_sinf(ph[nb[i]] - self[i]);
+        }
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        acc[i] *= K;
+    }
+    if (omega) {
+        for (uint32_t i = 0; i < len; i++) {
+            acc[i] += omega[b + i];
+        }
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        float v = self[i] + dt * acc[i];
+        v -= TWO_PI_F * floorf(v * INV_2PI_F);
+        out[b + i] = v < TWO_PI_F ? v : v - TWO_PI_F;
+    }
+}
+
+void bloom_lattice_run(const bloom_lattice *lat, float *phases, const float *omega,
+                       float K, float dt, uint32_t steps, float *scratch) {
+    uint32_t n = lat->n;
+    if (n == 0 || steps == 0) {
+        return;
+    }
+    float *tmp = scratch;
+    if (!tmp) {
+        tmp = (float *)malloc((size_t)n * sizeof(float));
+        if (!tmp) {
+            return;
+        }
+    }
+
+    float *cur = phases, *nxt = tmp;
+    int64_t blocks = ((int64_t)n + LATTICE_BLOCK - 1) / LATTICE_BLOCK;
+    for (uint32_t s = 0; s < steps; s++) {
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(static)
+#endif
+        for (int64_t blk = 0; blk < blocks; blk++) {
+            uint32_t b = (uint32_t)blk * LATTICE_BLOCK;
+            uint32_t e = b + LATTICE_BLOCK < n ? b + LATTICE_BLOCK : n;
+            step_block(lat, cur, nxt, omega, K, dt, b, e);
+        }
+        float *t = cur;
+        cur = nxt;
+        nxt = t;
+    }
+    if (cur != phases) {
+        memcpy(phases, cur, (size_t)n * sizeof(float));
+    }
+    if (!scratch) {
+        free(tmp);
+    }
+}
+
+void bloom_lattice_noise(const bloom_lattice *lat, float *phases, float sigma,
+                         const uint32_t key[8], uint64_t step, float *scratch) {
+    uint32_t n = lat->n;
+    if (n == 0) {
+        return;
+    }
+    float *xi = scratch;
+    if (!xi) {
+        xi = (float *)malloc((size_t)n * sizeof(float));
+        if (!xi) {
+            return;
+        }
+    }
+
+    /* Draws in native order, so kicks follow the site, not its slot */
+    int64_t blocks = ((int64_t)n + NOISE_BLOCK - 1) / NOISE_BLOCK;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int64_t blk = 0; blk < blocks; blk++) {
+        uint32_t b = (uint32_t)blk * NOISE_BLOCK;
+        uint32_t len = n - b < NOISE_BLOCK ? n - b : NOISE_BLOCK;
+        nexthash_rng_normal_f32_at(key, step * n + b, xi + b, len);
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        float v = phases[i] + sigma * xi[lat->perm[i]];
+        v -= TWO_PI_F * floorf(v * INV_2PI_F);
+        phases[i] = v < TWO_PI_F ? v : v - TWO_PI_F;
+    }
+    if (!scratch) {
+        free(xi);
+    }
+}
+
+void bloom_lattice_order_parameter(const float *phases, uint32_t n,
+                                   double *r, double *psi) {
+    if (n == 0) {
+        *r = 0.0;
+        *psi = 0.0;
+        return;
+    }
+    double c = 0.0, s = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        c += cos((double)phases[i]);
+        s += sin((double)phases[i]);
+    }
+    c /= n;
+    s /= n;
+    *r = sqrt(c * c + s * s);
+    double p = atan2(s, c);
+    *psi = p < 0.0 ? p + 2.0 * 3.14159265358979323846 : p;
+}
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <stdio.h>
+#include <time.h>
+
+static uint64_t test_rng = 0x9E3779B97F4A7C15ull;
+
+static double urand(void) {
+    test_rng ^= test_rng << 13;
+    test_rng ^= test_rng >> 7;
+    test_rng ^= test_rng << 17;
+    return (double)(test_rng >> 11) / 9007199254740992.0;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Dense reference: hexagonal_coupling_matrix() + Euler step in double */
+static void dense_run(const double *xy, uint32_t n, double cutoff, double *ph,
+                      const double *omega, double K, double dt, uint32_t steps) {
+    double *Wd = calloc((size_t)n * n, sizeof(double));
+    double *nx = malloc(n * sizeof(double));
+    for (uint32_t i = 0; i < n; i++) {
+        for (uint32_t j = 0; j < n; j++) {
+            double dx = xy[2 * i] - xy[2 * j], dy = xy[2 * i + 1] - xy[2 * j + 1];
+            double d = sqrt(dx * dx + dy * dy);
+            if (i != j && d < cutoff) {
+                Wd[(size_t)i * n + j] = 1.0 / (1.0 + d);
+            }
+        }
+    }
+    for (uint32_t s = 0; s < steps; s++) {
+        for (uint32_t i = 0; i < n; i++) {
+            double acc = 0.0;
+            for (uint32_t j = 0; j < n; j++) {
+                acc += Wd[(size_t)i * n + j] * sin(ph[j] - ph[i]);
+            }
+            nx[i] = fmod(ph[i] + dt * (omega[i] + K * acc), 2.0 * M_PI);
+            if (nx[i] < 0) nx[i] += 2.0 * M_PI;
+        }
+        memcpy(ph, nx, n * sizeof(double));
+    }
+    free(Wd);
+    free(nx);
+}
+
+static double phase_err(double a, double b) {
+    double d = fabs(a - b);
+    return d < M_PI ? d : 2.0 * M_PI - d;
+}
+
+int main(void) {
+    int fail = 0;
+    printf("BloomCoin Sparse Lattice Kuramoto\n");
+    printf("=================================\n\n");
+
+    /* fast_sinf accuracy */
+    double max_sin = 0.0;
+    for (int i = 0; i <= 200000; i++) {
+        float x = (float)(-4.0 * M_PI + 8.0 * M_PI * i / 200000.0);
+        double e = fabs((double)fast_sinf(x) - sin((double)x));
+        if (e > max_sin) max_sin = e;
+    }
+    printf("fast_sinf max error:      %.2e  %s\n", max_sin, max_sin < 1e-6 ? "OK" : "FAIL");
+    fail |= !(max_sin < 1e-6);
+
+    /* Site count matches generate_hexagonal_lattice() (19 for 2 rings) */
+    bloom_lattice hex;
+    bloom_lattice_hexagon(&hex, 2);
+    printf("hexagon(2) sites:         %u  %s\n", hex.n, hex.n == 19 ? "OK" : "FAIL");
+    fail |= hex.n != 19;
+    bloom_lattice_free(&hex);
+
+    /* Native hexagon == cell-grid search over the same points */
+    {
+        bloom_lattice a, b;
+        bloom_lattice_hexagon(&a, 12);
+        double *xy = calloc(2 * (size_t)a.n, sizeof(double));
+        for (uint32_t i = 0; i < a.n; i++) {
+            xy[2 * i] = a.x[i];
+            xy[2 * i + 1] = a.y[i];
+        }
+        bloom_lattice_from_coords(&b, xy, a.n, 1.5);
+        int same = b.width == 6;
+        for (uint32_t i = 0; i < a.n && same; i++) {
+            uint64_t ha = 0, hb = 0;
+            uint32_t da = 0, db = 0;
+            for (uint32_t k = 0; k < 6; k++) {
+                size_t sa = (size_t)k * a.n + i;
+                if (a.w[sa] > 0) { ha += a.nbr[sa] * 2654435761ull; da++; }
+                if (b.w[sa] > 0) { hb += b.nbr[sa] * 2654435761ull; db++;
+                                   same &= fabsf(b.w[sa] - 0.5f) < 1e-6f; }
+            }
+            same &= ha == hb && da == db;
+        }
+        printf("hexagon == from_coords:   %s\n", same ? "OK" : "FAIL");
+        fail |= !same;
+        free(xy);
+        bloom_lattice_free(&a);
+        bloom_lattice_free(&b);
+    }
+
+    /* Sparse run (Hilbert order) vs dense reference on jittered points */
+    {
+        const uint32_t n = 400;
+        const double cutoff = 1.5, K = 0.8, dt = 0.01;
+        const uint32_t steps = 50;
+        double *xy = malloc(2 * n * sizeof(double));
+        double *ph_ref = malloc(n * sizeof(double));
+        double *om_ref = malloc(n * sizeof(double));
+        float *ph_in = malloc(n * sizeof(float));
+        float *om_in = calloc(n, sizeof(float));
+        float *ph = malloc(n * sizeof(float));
+        float *om = calloc(n, sizeof(float));
+        float *back = malloc(n * sizeof(float));
+        for (uint32_t i = 0; i < n; i++) {
+            xy[2 * i] = (i % 20) + 0.3 * urand();
+            xy[2 * i + 1] = (i / 20) + 0.3 * urand();
+            ph_in[i] = (float)(2.0 * M_PI * urand());
+            om_in[i] = (float)(0.5 * (urand() - 0.5));
+            ph_ref[i] = ph_in[i];
+            om_ref[i] = om_in[i];
+        }
+
+        bloom_lattice lat;
+        bloom_lattice_from_coords(&lat, xy, n, cutoff);
+        bloom_lattice_reorder(&lat, BLOOM_ORDER_HILBERT);
+        bloom_lattice_gather(&lat, ph_in, ph);
+        bloom_lattice_gather(&lat, om_in, om);
+        bloom_lattice_run(&lat, ph, om, (float)K, (float)dt, steps, NULL);
+        bloom_lattice_scatter(&lat, ph, back);
+        dense_run(xy, n, cutoff, ph_ref, om_ref, K, dt, steps);
+
+        double max_err = 0.0;
+        for (uint32_t i = 0; i < n; i++) {
+            double e = phase_err(back[i], ph_ref[i]);
+            if (e > max_err) max_err = e;
+        }
+        printf("sparse vs dense (w=%u):   max err %.2e  %s\n", lat.width, max_err,
+               max_err < 1e-4 ? "OK" : "FAIL");
+        fail |= !(max_err < 1e-4);
+
+        double r0, p0, r1, p1;
+        float *ref_f = malloc(n * sizeof(float));
+        for (uint32_t i = 0; i < n; i++) ref_f[i] = (float)ph_ref[i];
+        bloom_lattice_order_parameter(back, n, &r0, &p0);
+        bloom_lattice_order_parameter(ref_f, n, &r1, &p1);
+        printf("order parameter r:        %.6f vs %.6f  %s\n", r0, r1,
+               fabs(r0 - r1) < 1e-5 ? "OK" : "FAIL");
+        fail |= !(fabs(r0 - r1) < 1e-5);
+
+        bloom_lattice_free(&lat);
+        free(xy); free(ph_ref); free(om_ref); free(ph_in); free(om_in);
+        free(ph); free(om); free(back); free(ref_f);
+    }
+
+    /* Ordering does not change the dynamics */
+    {
+        bloom_lattice a, b;
+        bloom_lattice_hexagon(&a, 30);
+        bloom_lattice_hexagon(&b, 30);
+        bloom_lattice_reorder(&b, BLOOM_ORDER_MORTON);
+        uint32_t n = a.n;
+        float *pa = malloc(n * sizeof(float)), *pb = malloc(n * sizeof(float));
+        float *back = malloc(n * sizeof(float));
+        for (uint32_t i = 0; i < n; i++) pa[i] = (float)(2.0 * M_PI * urand());
+        bloom_lattice_gather(&b, pa, pb);
+        bloom_lattice_run(&a, pa, NULL, 1.0f, 0.05f, 40, NULL);
+        bloom_lattice_run(&b, pb, NULL, 1.0f, 0.05f, 40, NULL);
+        bloom_lattice_scatter(&b, pb, back);
+        double max_err = 0.0;
+        for (uint32_t i = 0; i < n; i++) {
+            double e = phase_err(pa[i], back[i]);
+            if (e > max_err) max_err = e;
+        }
+        printf("native vs Morton order:   max err %.2e  %s\n", max_err,
+               max_err < 1e-4 ? "OK" : "FAIL");
+        fail |= !(max_err < 1e-4);
+        free(pa); free(pb); free(back);
+        bloom_lattice_free(&a);
+        bloom_lattice_free(&b);
+    }
+
+    /* Noise follows the site: same kicks in any order, right variance */
+    {
+        bloom_lattice a, b;
+        uint32_t key[8];
+        nexthash_rng_key(key, 42, 0);
+        bloom_lattice_hexagon(&a, 30);
+        bloom_lattice_hexagon(&b, 30);
+        bloom_lattice_reorder(&b, BLOOM_ORDER_HILBERT);
+        uint32_t n = a.n;
+        float *pa = malloc(n * sizeof(float)), *pb = malloc(n * sizeof(float));
+        float *back = malloc(n * sizeof(float));
+        for (uint32_t i = 0; i < n; i++) pa[i] = (float)(2.0 * M_PI * urand());
+        bloom_lattice_gather(&b, pa, pb);
+        for (uint32_t s = 0; s < 40; s++) {
+            bloom_lattice_run(&a, pa, NULL, 1.0f, 0.05f, 1, NULL);
+            bloom_lattice_noise(&a, pa, 0.1f, key, s, NULL);
+            bloom_lattice_run(&b, pb, NULL, 1.0f, 0.05f, 1, NULL);
+            bloom_lattice_noise(&b, pb, 0.1f, key, s, NULL);
+        }
+        bloom_lattice_scatter(&b, pb, back);
+        double max_err = 0.0;
+        for (uint32_t i = 0; i < n; i++) {
+            double e = phase_err(pa[i], back[i]);
+            if (e > max_err) max_err = e;
+        }
+
+        /* Pure diffusion: Var = steps * sigma^2 */
+        for (uint32_t i = 0; i < n; i++) pa[i] = (float)M_PI;
+        for (uint32_t s = 0; s < 100; s++) {
+            bloom_lattice_noise(&a, pa, 0.01f, key, 1000 + s, NULL);
+        }
+        double var = 0.0;
+        for (uint32_t i = 0; i < n; i++) var += (pa[i] - M_PI) * (pa[i] - M_PI);
+        var /= n;
+        int ok = max_err < 1e-4 && fabs(var / 0.01 - 1.0) < 0.1;
+        printf("noise native vs Hilbert:  max err %.2e, diffusion var %.4f  %s\n",
+               max_err, var, ok ? "OK" : "FAIL");
+        fail |= !ok;
+        free(pa); free(pb); free(back);
+        bloom_lattice_free(&a);
+        bloom_lattice_free(&b);
+    }
+
+    /* Throughput at ~10^6 sites */
+    {
+        bloom_lattice lat;
+        double t0 = now_sec();
+        bloom_lattice_hexagon(&lat, 577);
+        bloom_lattice_reorder(&lat, BLOOM_ORDER_HILBERT);
+        double t_build = now_sec() - t0;
+        uint32_t n = lat.n;
+        float *ph = malloc(n * sizeof(float)), *om = malloc(n * sizeof(float));
+        float *scratch = malloc(n * sizeof(float));
+        for (uint32_t i = 0; i < n; i++) {
+            ph[i] = (float)(2.0 * M_PI * urand());
+            om[i] = (float)(0.1 * (urand() - 0.5));
+        }
+        const uint32_t steps = 20;
+        t0 = now_sec();
+        bloom_lattice_run(&lat, ph, om, 1.0f, 0.05f, steps, scratch);
+        double t = now_sec() - t0;
+        double r, psi;
+        bloom_lattice_order_parameter(ph, n, &r, &psi);
+        printf("\n%u sites: build %.2f s, %.2f ms/step (%.0f M edges/s), r = %.4f\n",
+               n, t_build, 1e3 * t / steps, (double)n * 6 * steps / t / 1e6, r);
+        free(ph); free(om); free(scratch);
+        bloom_lattice_free(&lat);
+    }
+
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
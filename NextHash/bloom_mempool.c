@@ -0,0 +1,1431 @@
+/*
+ * BloomCoin Native Mempool
+ * ========================
+ *
+ * Compile: gcc -O3 -c bloom_sha256.c
+ *          gcc -O3 -o bloom_mempool bloom_mempool.c bloom_sha256.o -DTEST_MAIN
+ */
+
+#include "bloom_mempool.h"
+#include "bloom_sha256.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ========================================================================== */
+/* Internal Structures                                                         */
+/* ========================================================================== */
+
+#define NONE BLOOM_MEMPOOL_NONE
+
+/* Per refresh: candidates skipped for size; per candidate: packages evicted */
+#define TEMPLATE_MAX_SKIPS     16
+#define TEMPLATE_MAX_EVICTIONS 8
+
+typedef struct {
+    uint8_t txid[32];
+    uint64_t fee;
+    uint32_t size;
+    uint8_t in_use;
+
+    bloom_outpoint *inputs;
+    uint32_t n_inputs;
+
+    uint32_t *parents;
+    uint32_t n_parents, cap_parents;
+    uint32_t *children;
+    uint32_t n_children, cap_children;
+
+    /* Aggregates include the entry itself */
+    uint64_t anc_fee, anc_size;
+    uint32_t anc_count;
+    uint64_t desc_fee, desc_size;
+    uint32_t desc_count;
+
+    uint32_t visit;         /* BFS epoch stamp */
+    uint32_t next_free;     /* free list link */
+} mp_entry;
+
+/* Indexed binary min-heap over entry ids */
+typedef struct {
+    double key;
+    uint32_t id;
+} heap_node;
+
+typedef struct {
+    heap_node *nodes;
+    uint32_t *pos;          /* pos[id] = heap slot or NONE */
+    uint32_t n;
+} idx_heap;
+
+typedef struct {
+    bloom_outpoint op;
+    uint32_t spender;       /* entry id + 1, 0 = empty */
+} op_slot;
+
+struct bloom_mempool {
+    mp_entry *entries;
+    uint32_t cap;
+    uint32_t count;
+    uint32_t free_head;
+    uint64_t bytes;
+    uint64_t max_bytes;
+
+    uint32_t *tx_slots;     /* entry id + 1, 0 = empty */
+    uint32_t tx_mask;
+
+    op_slot *op_slots;
+    uint32_t op_mask;
+    uint32_t op_used;
+
+    idx_heap evict;         /* min descendant score first */
+    uint32_t epoch;
+
+    uint32_t *scratch_outer;
+    uint32_t *scratch_inner;
+    uint32_t *scratch_anc;
+    uint64_t *scratch_sort;
+
+    bloom_template *tpl;
+};
+
+struct bloom_template {
+    bloom_mempool *pool;
+    uint64_t max_bytes;
+    bloom_merkle_node_fn node_fn;
+
+    uint32_t *pos;          /* pos[id] = index in order or NONE */
+    uint32_t *order;
+    uint32_t n;
+    uint64_t fees, bytes;
+
+    idx_heap incl;          /* included, weakest ancestor score first */
+    idx_heap excl;          /* excluded, best ancestor score first */
+
+    uint8_t coinbase[32];
+
+    /* Merkle levels: level 0 holds leaves (coinbase + order) */
+    uint8_t **levels;
+    uint32_t n_levels;
+    uint32_t prev_leaves;
+    uint32_t *dirty;
+    uint32_t n_dirty;
+    uint8_t *dirty_flag;
+    uint32_t dirty_from;    /* all leaves >= dirty_from are dirty */
+    uint32_t *dirty_next;
+
+    uint32_t *pkg;
+    uint32_t *evicted;
+    uint32_t *anc;
+    uint32_t *stash;
+};
+
+/* ========================================================================== */
+/* Helper Functions                                                            */
+/* ========================================================================== */
+
+static inline uint64_t load64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static inline uint32_t mix_hash(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return (uint32_t)x;
+}
+
+static inline uint32_t txid_hash(const uint8_t txid[32]) {
+    return mix_hash(load64(txid) ^ load64(txid + 8));
+}
+
+static inline uint32_t outpoint_hash(const bloom_outpoint *op) {
+    return mix_hash(load64(op->txid) ^ ((uint64_t)op->index * 0x9E3779B97F4A7C15ULL));
+}
+
+static inline int outpoint_eq(const bloom_outpoint *a, const bloom_outpoint *b) {
+    return a->index == b->index && memcmp(a->txid, b->txid, 32) == 0;
+}
+
+static inline double score(uint64_t fee, uint64_t size) {
+    return size ? (double)fee / (double)size : 0.0;
+}
+
+static inline double anc_score(const mp_entry *e) {
+    return score(e->anc_fee, e->anc_size);
+}
+
+static inline double desc_score(const mp_entry *e) {
+    return score(e->desc_fee, e->desc_size);
+}
+
+static uint32_t next_pow2(uint32_t x) {
+    uint32_t p = 1;
+    while (p < x) p <<= 1;
+    return p;
+}
+
+static int push_id(uint32_t **arr, uint32_t *n, uint32_t *cap, uint32_t id) {
+    if (*n == *cap) {
+        uint32_t ncap = *cap ? *cap * 2 : 4;
+        uint32_t *p = (uint32_t *)realloc(*arr, ncap * sizeof(uint32_t));
+        if (!p) return -1;
+        *arr = p;
+        *cap = ncap;
+    }
+    (*arr)[(*n)++] = id;
+    return 0;
+}
+
+static void erase_id(uint32_t *arr, uint32_t *n, uint32_t id) {
+    for (uint32_t i = 0; i < *n; i++) {
+        if (arr[i] == id) {
+            arr[i] = arr[--(*n)];
+            return;
+        }
+    }
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* ========================================================================== */
+/* Indexed Heap                                                                */
+/* ========================================================================== */
+
+static int heap_init(idx_heap *h, uint32_t cap) {
+    h->nodes = (heap_node *)malloc(cap * sizeof(heap_node));
+    h->pos = (uint32_t *)malloc(cap * sizeof(uint32_t));
+    h->n = 0;
+    if (!h->nodes || !h->pos) return -1;
+    memset(h->pos, 0xFF, cap * sizeof(uint32_t));
+    return 0;
+}
+
+static void heap_free(idx_heap *h) {
+    free(h->nodes);
+    free(h->pos);
+}
+
+static inline void heap_set(idx_heap *h, uint32_t slot, heap_node node) {
+    h->nodes[slot] = node;
+    h->pos[node.id] = slot;
+}
+
+static void heap_sift_up(idx_heap *h, uint32_t slot) {
+    heap_node node = h->nodes[slot];
+    while (slot > 0) {
+        uint32_t parent = (slot - 1) / 2;
+        if (h->nodes[parent].key <= node.key) break;
+        heap_set(h, slot, h->nodes[parent]);
+        slot = parent;
+    }
+    heap_set(h, slot, node);
+}
+
+static void heap_sift_down(idx_heap *h, uint32_t slot) {
+    heap_node node = h->nodes[slot];
+    for (;;) {
+        uint32_t child = 2 * slot + 1;
+        if (child >= h->n) break;
+        if (child + 1 < h->n && h->nodes[child + 1].key < h->nodes[child].key) child++;
+        if (node.key <= h->nodes[child].key) break;
+        heap_set(h, slot, h->nodes[child]);
+        slot = child;
+    }
+    heap_set(h, slot, node);
+}
+
+static inline int heap_contains(const idx_heap *h, uint32_t id) {
+    return h->pos[id] != NONE;
+}
+
+static void heap_push(idx_heap *h, uint32_t id, double key) {
+    heap_node node = { key, id };
+    heap_set(h, h->n++, node);
+    heap_sift_up(h, h->n - 1);
+}
+
+static void heap_remove(idx_heap *h, uint32_t id) {
+    uint32_t slot = h->pos[id];
+    heap_node moved;
+    if (slot == NONE) return;
+    h->pos[id] = NONE;
+    if (--h->n == slot) return;
+    moved = h->nodes[h->n];
+    heap_set(h, slot, moved);
+    heap_sift_up(h, slot);
+    heap_sift_down(h, h->pos[moved.id]);
+}
+
+static void heap_update(idx_heap *h, uint32_t id, double key) {
+    uint32_t slot = h->pos[id];
+    if (slot == NONE) return;
+    h->nodes[slot].key = key;
+    heap_sift_up(h, slot);
+    heap_sift_down(h, h->pos[id]);
+}
+
+/* ========================================================================== */
+/* Hash Tables                                                                 */
+/* ========================================================================== */
+
+static uint32_t tx_lookup(const bloom_mempool *pool, const uint8_t txid[32]) {
+    uint32_t slot = txid_hash(txid) & pool->tx_mask;
+    for (;;) {
+        uint32_t v = pool->tx_slots[slot];
+        if (v == 0) return NONE;
+        if (memcmp(pool->entries[v - 1].txid, txid, 32) == 0) return v - 1;
+        slot = (slot + 1) & pool->tx_mask;
+    }
+}
+
+static void tx_insert(bloom_mempool *pool, uint32_t id) {
+    uint32_t slot = txid_hash(pool->entries[id].txid) & pool->tx_mask;
+    while (pool->tx_slots[slot] != 0) slot = (slot + 1) & pool->tx_mask;
+    pool->tx_slots[slot] = id + 1;
+}
+
+static void tx_erase(bloom_mempool *pool, uint32_t id) {
+    uint32_t mask = pool->tx_mask;
+    uint32_t i = txid_hash(pool->entries[id].txid) & mask;
+    while (pool->tx_slots[i] != id + 1) i = (i + 1) & mask;
+
+    /* Backward-shift deletion keeps probe chains intact */
+    uint32_t j = i;
+    for (;;) {
+        j = (j + 1) & mask;
+        uint32_t v = pool->tx_slots[j];
+        if (v == 0) break;
+        uint32_t home = txid_hash(pool->entries[v - 1].txid) & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            pool->tx_slots[i] = v;
+            i = j;
+        }
+    }
+    pool->tx_slots[i] = 0;
+}
+
+static uint32_t op_lookup(const bloom_mempool *pool, const bloom_outpoint *op) {
+    uint32_t slot = outpoint_hash(op) & pool->op_mask;
+    for (;;) {
+        const op_slot *s = &pool->op_slots[slot];
+        if (s->spender == 0) return NONE;
+        if (outpoint_eq(&s->op, op)) return s->spender - 1;
+        slot = (slot + 1) & pool->op_mask;
+    }
+}
+
+static void op_place(op_slot *slots, uint32_t mask, const bloom_outpoint *op,
+                     uint32_t spender) {
+    uint32_t slot = outpoint_hash(op) & mask;
+    while (slots[slot].spender != 0) slot = (slot + 1) & mask;
+    slots[slot].op = *op;
+    slots[slot].spender = spender + 1;
+}
+
+static int op_insert(bloom_mempool *pool, const bloom_outpoint *op, uint32_t spender) {
+    if ((pool->op_used + 1) * 4 > (pool->op_mask + 1) * 3) {
+        uint32_t ncap = (pool->op_mask + 1) * 2;
+        op_slot *nslots = (op_slot *)calloc(ncap, sizeof(op_slot));
+        if (!nslots) return -1;
+        for (uint32_t i = 0; i <= pool->op_mask; i++) {
+            if (pool->op_slots[i].spender != 0) {
+                op_place(nslots, ncap - 1, &pool->op_slots[i].op,
+                         pool->op_slots[i].spender - 1);
+            }
+        }
+        free(pool->op_slots);
+        pool->op_slots = nslots;
+        pool->op_mask = ncap - 1;
+    }
+    op_place(pool->op_slots, pool->op_mask, op, spender);
+    pool->op_used++;
+    return 0;
+}
+
+static void op_erase(bloom_mempool *pool, const bloom_outpoint *op, uint32_t spender) {
+    uint32_t mask = pool->op_mask;
+    uint32_t i = outpoint_hash(op) & mask;
+    for (;;) {
+        if (pool->op_slots[i].spender == 0) return;
+        if (pool->op_slots[i].spender == spender + 1 &&
+            outpoint_eq(&pool->op_slots[i].op, op)) break;
+        i = (i + 1) & mask;
+    }
+
+    uint32_t j = i;
+    for (;;) {
+        j = (j + 1) & mask;
+        if (pool->op_slots[j].spender == 0) break;
+        uint32_t home = outpoint_hash(&pool->op_slots[j].op) & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            pool->op_slots[i] = pool->op_slots[j];
+            i = j;
+        }
+    }
+    pool->op_slots[i].spender = 0;
+    pool->op_used--;
+}
+
+/* ========================================================================== */
+/* Graph Traversal                                                             */
+/* ========================================================================== */
+
+/*
+ * Collect the closure of seeds over parent (up) or child (down) edges into
+ * out[]. Seeds are included. Returns the number collected.
+ */
+static uint32_t collect(bloom_mempool *pool, const uint32_t *seeds, uint32_t n_seeds,
+                        int up, uint32_t *out) {
+    uint32_t stamp = ++pool->epoch;
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < n_seeds; i++) {
+        mp_entry *e = &pool->entries[seeds[i]];
+        if (e->visit != stamp) {
+            e->visit = stamp;
+            out[n++] = seeds[i];
+        }
+    }
+    for (uint32_t head = 0; head < n; head++) {
+        mp_entry *e = &pool->entries[out[head]];
+        const uint32_t *next = up ? e->parents : e->children;
+        uint32_t n_next = up ? e->n_parents : e->n_children;
+        for (uint32_t k = 0; k < n_next; k++) {
+            mp_entry *x = &pool->entries[next[k]];
+            if (x->visit != stamp) {
+                x->visit = stamp;
+                out[n++] = next[k];
+            }
+        }
+    }
+    return n;
+}
+
+/*
+ * Sort ids so that ancestors come before descendants: an ancestor always
+ * has a smaller anc_count. Keys are (anc_count << 32 | id), so the sort
+ * needs no pool pointer and is deterministic on ties.
+ */
+static void sort_topological(bloom_mempool *pool, uint32_t *ids, uint32_t n) {
+    uint64_t *keys = pool->scratch_sort;
+    uint32_t i;
+
+    for (i = 0; i < n; i++) {
+        keys[i] = ((uint64_t)pool->entries[ids[i]].anc_count << 32) | ids[i];
+    }
+    qsort(keys, n, sizeof(uint64_t), cmp_u64);
+    for (i = 0; i < n; i++) ids[i] = (uint32_t)keys[i];
+}
+
+/* ========================================================================== */
+/* Template Hooks                                                              */
+/* ========================================================================== */
+
+static void tpl_on_add(bloom_template *tpl, uint32_t id);
+static void tpl_on_remove(bloom_template *tpl, uint32_t id);
+static void tpl_on_rescore(bloom_template *tpl, uint32_t id);
+
+/* ========================================================================== */
+/* Pool                                                                        */
+/* ========================================================================== */
+
+bloom_mempool *bloom_mempool_create(uint32_t max_entries, uint64_t max_bytes) {
+    bloom_mempool *pool;
+    uint32_t i;
+
+    if (max_entries == 0) return NULL;
+    pool = (bloom_mempool *)calloc(1, sizeof(*pool));
+    if (!pool) return NULL;
+
+    pool->cap = max_entries;
+    pool->max_bytes = max_bytes;
+    pool->entries = (mp_entry *)calloc(max_entries, sizeof(mp_entry));
+    pool->tx_mask = next_pow2(max_entries * 2) - 1;
+    pool->tx_slots = (uint32_t *)calloc(pool->tx_mask + 1, sizeof(uint32_t));
+    pool->op_mask = next_pow2(max_entries * 4) - 1;
+    pool->op_slots = (op_slot *)calloc(pool->op_mask + 1, sizeof(op_slot));
+    pool->scratch_outer = (uint32_t *)malloc(max_entries * sizeof(uint32_t));
+    pool->scratch_inner = (uint32_t *)malloc(max_entries * sizeof(uint32_t));
+    pool->scratch_anc = (uint32_t *)malloc(max_entries * sizeof(uint32_t));
+    pool->scratch_sort = (uint64_t *)malloc(max_entries * sizeof(uint64_t));
+
+    if (!pool->entries || !pool->tx_slots || !pool->op_slots ||
+        !pool->scratch_outer || !pool->scratch_inner || !pool->scratch_anc ||
+        !pool->scratch_sort ||
+        heap_init(&pool->evict, max_entries) != 0) {
+        bloom_mempool_destroy(pool);
+        return NULL;
+    }
+
+    for (i = 0; i < max_entries; i++) {
+        pool->entries[i].next_free = (i + 1 < max_entries) ? i + 1 : NONE;
+    }
+    pool->free_head = 0;
+    return pool;
+}
+
+static void entry_release(mp_entry *e) {
+    free(e->inputs);
+    free(e->parents);
+    free(e->children);
+    e->inputs = NULL;
+    e->parents = NULL;
+    e->children = NULL;
+    e->n_inputs = e->n_parents = e->n_children = 0;
+    e->cap_parents = e->cap_children = 0;
+    e->in_use = 0;
+}
+
+void bloom_mempool_destroy(bloom_mempool *pool) {
+    if (!pool) return;
+    if (pool->entries) {
+        for (uint32_t i = 0; i < pool->cap; i++) {
+            if (pool->entries[i].in_use) entry_release(&pool->entries[i]);
+        }
+    }
+    if (pool->tpl) pool->tpl->pool = NULL;
+    free(pool->entries);
+    free(pool->tx_slots);
+    free(pool->op_slots);
+    free(pool->scratch_outer);
+    free(pool->scratch_inner);
+    free(pool->scratch_anc);
+    free(pool->scratch_sort);
+    heap_free(&pool->evict);
+    free(pool);
+}
+
+/* Unlink and free a single entry; descendants stay and lose it as ancestor */
+static void remove_entry(bloom_mempool *pool, uint32_t id) {
+    mp_entry *e = &pool->entries[id];
+    uint32_t *buf = pool->scratch_inner;
+    uint32_t n, k;
+
+    /* Ancestors no longer count this entry among their descendants */
+    n = collect(pool, e->parents, e->n_parents, 1, buf);
+    for (k = 0; k < n; k++) {
+        mp_entry *a = &pool->entries[buf[k]];
+        a->desc_fee -= e->fee;
+        a->desc_size -= e->size;
+        a->desc_count--;
+        heap_update(&pool->evict, buf[k], desc_score(a));
+    }
+
+    /* Descendants no longer count it among their ancestors */
+    n = collect(pool, e->children, e->n_children, 0, buf);
+    for (k = 0; k < n; k++) {
+        mp_entry *d = &pool->entries[buf[k]];
+        d->anc_fee -= e->fee;
+        d->anc_size -= e->size;
+        d->anc_count--;
+        if (pool->tpl) tpl_on_rescore(pool->tpl, buf[k]);
+    }
+
+    for (k = 0; k < e->n_parents; k++) {
+        mp_entry *p = &pool->entries[e->parents[k]];
+        erase_id(p->children, &p->n_children, id);
+    }
+    for (k = 0; k < e->n_children; k++) {
+        mp_entry *c = &pool->entries[e->children[k]];
+        erase_id(c->parents, &c->n_parents, id);
+    }
+
+    for (k = 0; k < e->n_inputs; k++) op_erase(pool, &e->inputs[k], id);
+    tx_erase(pool, id);
+    heap_remove(&pool->evict, id);
+    if (pool->tpl) tpl_on_remove(pool->tpl, id);
+
+    pool->bytes -= e->size;
+    pool->count--;
+    entry_release(e);
+    e->next_free = pool->free_head;
+    pool->free_head = id;
+}
+
+/* Remove an entry together with all of its descendants */
+static void remove_with_descendants(bloom_mempool *pool, uint32_t id) {
+    uint32_t *buf = pool->scratch_outer;
+    uint32_t n = collect(pool, &id, 1, 0, buf);
+
+    /* Leaves first so no removal touches an already-freed entry */
+    sort_topological(pool, buf, n);
+    while (n > 0) remove_entry(pool, buf[--n]);
+}
+
+int bloom_mempool_add(bloom_mempool *pool, const bloom_tx_info *tx) {
+    uint32_t *conflicts = pool->scratch_outer;
+    uint32_t *anc = pool->scratch_anc;
+    uint32_t parents[BLOOM_MEMPOOL_MAX_ANCESTORS];
+    uint32_t n_conflicts = 0, n_parents = 0, n_anc, i, k;
+    uint64_t removed_fee = 0;
+    double rate = score(tx->fee, tx->size);
+    uint32_t id;
+    mp_entry *e;
+
+    if (tx_lookup(pool, tx->txid) != NONE) return BLOOM_MEMPOOL_ERR_DUPLICATE;
+
+    /* Direct conflicts and in-pool parents */
+    for (i = 0; i < tx->n_inputs; i++) {
+        uint32_t spender = op_lookup(pool, &tx->inputs[i]);
+        uint32_t parent = tx_lookup(pool, tx->inputs[i].txid);
+        if (spender != NONE) {
+            for (k = 0; k < n_conflicts && conflicts[k] != spender; k++) {}
+            if (k == n_conflicts) conflicts[n_conflicts++] = spender;
+        }
+        if (parent != NONE) {
+            for (k = 0; k < n_parents && parents[k] != parent; k++) {}
+            if (k == n_parents) {
+                if (n_parents == BLOOM_MEMPOOL_MAX_ANCESTORS) {
+                    return BLOOM_MEMPOOL_ERR_CHAIN_LIMIT;
+                }
+                parents[n_parents++] = parent;
+            }
+        }
+    }
+
+    /* Replace-by-fee: must beat each conflict's rate and the evicted fees */
+    if (n_conflicts > 0) {
+        uint32_t n_removed;
+        for (k = 0; k < n_conflicts; k++) {
+            const mp_entry *c = &pool->entries[conflicts[k]];
+            if (rate <= score(c->fee, c->size)) return BLOOM_MEMPOOL_ERR_CONFLICT;
+        }
+        n_removed = collect(pool, conflicts, n_conflicts, 0, conflicts);
+        for (k = 0; k < n_removed; k++) {
+            removed_fee += pool->entries[conflicts[k]].fee;
+        }
+        if (tx->fee <= removed_fee) return BLOOM_MEMPOOL_ERR_CONFLICT;
+
+        /* Spending an output of a transaction we would evict is invalid */
+        for (k = 0; k < n_parents; k++) {
+            if (pool->entries[parents[k]].visit == pool->epoch) {
+                return BLOOM_MEMPOOL_ERR_CONFLICT;
+            }
+        }
+        n_conflicts = n_removed;
+    }
+
+    /* Chain limits */
+    n_anc = collect(pool, parents, n_parents, 1, anc);
+    if (n_anc + 1 > BLOOM_MEMPOOL_MAX_ANCESTORS) return BLOOM_MEMPOOL_ERR_CHAIN_LIMIT;
+    for (k = 0; k < n_anc; k++) {
+        if (pool->entries[anc[k]].desc_count + 1 > BLOOM_MEMPOOL_MAX_DESCENDANTS) {
+            return BLOOM_MEMPOOL_ERR_CHAIN_LIMIT;
+        }
+    }
+
+    /* Replaced transactions leave first; scratch is reused by removal, so
+     * direct spenders are resolved again from the outpoint index */
+    if (n_conflicts > 0) {
+        for (i = 0; i < tx->n_inputs; i++) {
+            uint32_t spender = op_lookup(pool, &tx->inputs[i]);
+            if (spender != NONE) remove_with_descendants(pool, spender);
+        }
+    }
+
+    /* Make room by evicting the weakest descendant packages */
+    while (pool->count >= pool->cap ||
+           (pool->max_bytes && pool->bytes + tx->size > pool->max_bytes)) {
+        uint32_t victim;
+        if (pool->evict.n == 0) return BLOOM_MEMPOOL_ERR_FULL;
+        victim = pool->evict.nodes[0].id;
+        if (pool->evict.nodes[0].key >= rate) return BLOOM_MEMPOOL_ERR_FULL;
+        for (k = 0; k < n_anc && anc[k] != victim; k++) {}
+        if (k < n_anc) return BLOOM_MEMPOOL_ERR_FULL;
+        remove_with_descendants(pool, victim);
+        /* Eviction may have taken ancestors' descendants; recollect */
+        n_anc = collect(pool, parents, n_parents, 1, anc);
+    }
+
+    /* Allocate and link */
+    id = pool->free_head;
+    e = &pool->entries[id];
+    pool->free_head = e->next_free;
+
+    memcpy(e->txid, tx->txid, 32);
+    e->fee = tx->fee;
+    e->size = tx->size;
+    e->in_use = 1;
+    e->inputs = NULL;
+    e->n_inputs = tx->n_inputs;
+    if (tx->n_inputs) {
+        e->inputs = (bloom_outpoint *)malloc(tx->n_inputs * sizeof(bloom_outpoint));
+        if (!e->inputs) goto nomem;
+        memcpy(e->inputs, tx->inputs, tx->n_inputs * sizeof(bloom_outpoint));
+    }
+    for (k = 0; k < n_parents; k++) {
+        mp_entry *p = &pool->entries[parents[k]];
+        if (push_id(&e->parents, &e->n_parents, &e->cap_parents, parents[k]) != 0 ||
+            push_id(&p->children, &p->n_children, &p->cap_children, id) != 0) {
+            goto nomem;
+        }
+    }
+
+    e->anc_fee = e->fee;
+    e->anc_size = e->size;
+    e->anc_count = 1;
+    for (k = 0; k < n_anc; k++) {
+        mp_entry *a = &pool->entries[anc[k]];
+        e->anc_fee += a->fee;
+        e->anc_size += a->size;
+        e->anc_count++;
+        a->desc_fee += e->fee;
+        a->desc_size += e->size;
+        a->desc_count++;
+        heap_update(&pool->evict, anc[k], desc_score(a));
+    }
+    e->desc_fee = e->fee;
+    e->desc_size = e->size;
+    e->desc_count = 1;
+
+    tx_insert(pool, id);
+    for (k = 0; k < e->n_inputs; k++) {
+        if (op_insert(pool, &e->inputs[k], id) != 0) {
+            e->n_inputs = k;
+            pool->count++;
+            pool->bytes += e->size;
+            heap_push(&pool->evict, id, desc_score(e));
+            remove_entry(pool, id);
+            return BLOOM_MEMPOOL_ERR_NOMEM;
+        }
+    }
+    heap_push(&pool->evict, id, desc_score(e));
+    pool->count++;
+    pool->bytes += e->size;
+
+    if (pool->tpl) tpl_on_add(pool->tpl, id);
+    return BLOOM_MEMPOOL_OK;
+
+nomem:
+    for (k = 0; k < e->n_parents; k++) {
+        mp_entry *p = &pool->entries[e->parents[k]];
+        erase_id(p->children, &p->n_children, id);
+    }
+    entry_release(e);
+    e->next_free = pool->free_head;
+    pool->free_head = id;
+    return BLOOM_MEMPOOL_ERR_NOMEM;
+}
+
+int bloom_mempool_remove(bloom_mempool *pool, const uint8_t txid[32]) {
+    uint32_t id = tx_lookup(pool, txid);
+    if (id == NONE) return BLOOM_MEMPOOL_ERR_NOT_FOUND;
+    remove_with_descendants(pool, id);
+    return BLOOM_MEMPOOL_OK;
+}
+
+void bloom_mempool_remove_for_block(bloom_mempool *pool,
+                                    const uint8_t (*txids)[32], size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        uint32_t id = tx_lookup(pool, txids[i]);
+        if (id != NONE) remove_entry(pool, id);
+    }
+}
+
+void bloom_mempool_remove_spenders(bloom_mempool *pool,
+                                   const bloom_outpoint *spent, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        uint32_t id = op_lookup(pool, &spent[i]);
+        if (id != NONE) remove_with_descendants(pool, id);
+    }
+}
+
+int bloom_mempool_contains(const bloom_mempool *pool, const uint8_t txid[32]) {
+    return tx_lookup(pool, txid) != NONE;
+}
+
+uint32_t bloom_mempool_count(const bloom_mempool *pool) {
+    return pool->count;
+}
+
+uint64_t bloom_mempool_bytes(const bloom_mempool *pool) {
+    return pool->bytes;
+}
+
+size_t bloom_mempool_txids(const bloom_mempool *pool, uint8_t (*out)[32], size_t max) {
+    size_t k = 0;
+    for (uint32_t id = 0; id < pool->cap && k < max; id++) {
+        if (pool->entries[id].in_use) {
+            memcpy(out[k++], pool->entries[id].txid, 32);
+        }
+    }
+    return k;
+}
+
+int bloom_mempool_get_aggregates(const bloom_mempool *pool,
+                                 const uint8_t txid[32],
+                                 uint64_t *anc_fee, uint64_t *anc_size,
+                                 uint32_t *anc_count,
+                                 uint64_t *desc_fee, uint64_t *desc_size,
+                                 uint32_t *desc_count) {
+    uint32_t id = tx_lookup(pool, txid);
+    const mp_entry *e;
+    if (id == NONE) return BLOOM_MEMPOOL_ERR_NOT_FOUND;
+    e = &pool->entries[id];
+    if (anc_fee) *anc_fee = e->anc_fee;
+    if (anc_size) *anc_size = e->anc_size;
+    if (anc_count) *anc_count = e->anc_count;
+    if (desc_fee) *desc_fee = e->desc_fee;
+    if (desc_size) *desc_size = e->desc_size;
+    if (desc_count) *desc_count = e->desc_count;
+    return BLOOM_MEMPOOL_OK;
+}
+
+/* ========================================================================== */
+/* Block Template                                                              */
+/* ========================================================================== */
+
+/* merkle_hash() in core/merkle.py: double SHA-256 of left || right */
+static void default_node_fn(const uint8_t left[32], const uint8_t right[32],
+                            uint8_t out[32]) {
+    uint8_t buf[64];
+    memcpy(buf, left, 32);
+    memcpy(buf + 32, right, 32);
+    bloom_sha256d(buf, 64, out);
+}
+
+static void mark_leaf(bloom_template *tpl, uint32_t leaf) {
+    if (leaf >= tpl->dirty_from || tpl->dirty_flag[leaf]) return;
+    tpl->dirty_flag[leaf] = 1;
+    tpl->dirty[tpl->n_dirty++] = leaf;
+}
+
+bloom_template *bloom_template_create(bloom_mempool *pool,
+                                      uint64_t max_block_bytes,
+                                      bloom_merkle_node_fn node_fn) {
+    bloom_template *tpl;
+    uint32_t cap, leaves, width, l;
+
+    if (!pool || pool->tpl) return NULL;
+    tpl = (bloom_template *)calloc(1, sizeof(*tpl));
+    if (!tpl) return NULL;
+
+    cap = pool->cap;
+    leaves = cap + 1;
+    tpl->pool = pool;
+    tpl->max_bytes = max_block_bytes;
+    tpl->node_fn = node_fn ? node_fn : default_node_fn;
+    tpl->pos = (uint32_t *)malloc(cap * sizeof(uint32_t));
+    tpl->order = (uint32_t *)malloc(cap * sizeof(uint32_t));
+    tpl->dirty = (uint32_t *)malloc(leaves * sizeof(uint32_t));
+    tpl->dirty_next = (uint32_t *)malloc(leaves * sizeof(uint32_t));
+    tpl->dirty_flag = (uint8_t *)calloc(leaves, 1);
+    tpl->pkg = (uint32_t *)malloc(cap * sizeof(uint32_t));
+    tpl->evicted = (uint32_t *)malloc(cap * sizeof(uint32_t));
+    tpl->anc = (uint32_t *)malloc(cap * sizeof(uint32_t));
+    tpl->stash = (uint32_t *)malloc(cap * sizeof(uint32_t));
+
+    for (width = leaves, tpl->n_levels = 1; width > 1; width = (width + 1) / 2) {
+        tpl->n_levels++;
+    }
+    tpl->levels = (uint8_t **)calloc(tpl->n_levels, sizeof(uint8_t *));
+
+    if (!tpl->pos || !tpl->order || !tpl->dirty || !tpl->dirty_next ||
+        !tpl->dirty_flag || !tpl->pkg || !tpl->evicted || !tpl->anc ||
+        !tpl->stash || !tpl->levels ||
+        heap_init(&tpl->incl, cap) != 0 || heap_init(&tpl->excl, cap) != 0) {
+        bloom_template_destroy(tpl);
+        return NULL;
+    }
+    for (width = leaves, l = 0; l < tpl->n_levels; l++, width = (width + 1) / 2) {
+        tpl->levels[l] = (uint8_t *)malloc((size_t)width * 32);
+        if (!tpl->levels[l]) {
+            bloom_template_destroy(tpl);
+            return NULL;
+        }
+    }
+    memset(tpl->pos, 0xFF, cap * sizeof(uint32_t));
+
+    pool->tpl = tpl;
+    for (l = 0; l < cap; l++) {
+        if (pool->entries[l].in_use) tpl_on_add(tpl, l);
+    }
+    tpl->dirty_from = NONE;
+    mark_leaf(tpl, 0);
+    return tpl;
+}
+
+void bloom_template_destroy(bloom_template *tpl) {
+    if (!tpl) return;
+    if (tpl->pool && tpl->pool->tpl == tpl) tpl->pool->tpl = NULL;
+    if (tpl->levels) {
+        for (uint32_t l = 0; l < tpl->n_levels; l++) free(tpl->levels[l]);
+    }
+    free(tpl->levels);
+    free(tpl->pos);
+    free(tpl->order);
+    free(tpl->dirty);
+    free(tpl->dirty_next);
+    free(tpl->dirty_flag);
+    free(tpl->pkg);
+    free(tpl->evicted);
+    free(tpl->anc);
+    free(tpl->stash);
+    heap_free(&tpl->incl);
+    heap_free(&tpl->excl);
+    free(tpl);
+}
+
+void bloom_template_set_coinbase(bloom_template *tpl, const uint8_t txid[32]) {
+    memcpy(tpl->coinbase, txid, 32);
+    mark_leaf(tpl, 0);
+}
+
+/* Drop the transaction at order[i], keeping parents ahead of children */
+static void tpl_remove_at(bloom_template *tpl, uint32_t i) {
+    bloom_mempool *pool = tpl->pool;
+    uint32_t last = tpl->n - 1;
+    uint32_t id = tpl->order[i];
+    uint32_t k;
+
+    tpl->pos[id] = NONE;
+    tpl->n--;
+    if (i < last) {
+        /* Moving the tail into the hole is valid if its parents precede i */
+        uint32_t moved = tpl->order[last];
+        const mp_entry *m = &pool->entries[moved];
+        int ok = 1;
+        for (k = 0; k < m->n_parents; k++) {
+            uint32_t pp = tpl->pos[m->parents[k]];
+            if (pp != NONE && pp >= i) {
+                ok = 0;
+                break;
+            }
+        }
+        if (ok) {
+            tpl->order[i] = moved;
+            tpl->pos[moved] = i;
+            mark_leaf(tpl, i + 1);
+        } else {
+            memmove(tpl->order + i, tpl->order + i + 1, (last - i) * sizeof(uint32_t));
+            for (k = i; k < tpl->n; k++) tpl->pos[tpl->order[k]] = k;
+            if (i + 1 < tpl->dirty_from) tpl->dirty_from = i + 1;
+        }
+    }
+}
+
+static void tpl_on_add(bloom_template *tpl, uint32_t id) {
+    heap_push(&tpl->excl, id, -anc_score(&tpl->pool->entries[id]));
+}
+
+static void tpl_on_remove(bloom_template *tpl, uint32_t id) {
+    if (tpl->pos[id] != NONE) {
+        const mp_entry *e = &tpl->pool->entries[id];
+        tpl->fees -= e->fee;
+        tpl->bytes -= e->size;
+        heap_remove(&tpl->incl, id);
+        tpl_remove_at(tpl, tpl->pos[id]);
+    } else {
+        heap_remove(&tpl->excl, id);
+    }
+}
+
+static void tpl_on_rescore(bloom_template *tpl, uint32_t id) {
+    double s = anc_score(&tpl->pool->entries[id]);
+    if (heap_contains(&tpl->incl, id)) heap_update(&tpl->incl, id, s);
+    else heap_update(&tpl->excl, id, -s);
+}
+
+/* Excluded ancestors of id plus id itself; returns count, sets totals */
+static uint32_t tpl_package(bloom_template *tpl, uint32_t id,
+                            uint64_t *bytes, uint64_t *fees) {
+    bloom_mempool *pool = tpl->pool;
+    uint32_t stamp = ++pool->epoch;
+    uint32_t n = 0;
+    uint64_t sz = 0, fee = 0;
+
+    pool->entries[id].visit = stamp;
+    tpl->pkg[n++] = id;
+    for (uint32_t head = 0; head < n; head++) {
+        const mp_entry *e = &pool->entries[tpl->pkg[head]];
+        sz += e->size;
+        fee += e->fee;
+        for (uint32_t k = 0; k < e->n_parents; k++) {
+            uint32_t p = e->parents[k];
+            if (tpl->pos[p] == NONE && pool->entries[p].visit != stamp) {
+                pool->entries[p].visit = stamp;
+                tpl->pkg[n++] = p;
+            }
+        }
+    }
+    *bytes = sz;
+    *fees = fee;
+    return n;
+}
+
+static void tpl_include(bloom_template *tpl, uint32_t n) {
+    bloom_mempool *pool = tpl->pool;
+    sort_topological(pool, tpl->pkg, n);
+    for (uint32_t k = 0; k < n; k++) {
+        uint32_t id = tpl->pkg[k];
+        const mp_entry *e = &pool->entries[id];
+        heap_remove(&tpl->excl, id);
+        heap_push(&tpl->incl, id, anc_score(e));
+        tpl->pos[id] = tpl->n;
+        tpl->order[tpl->n++] = id;
+        tpl->fees += e->fee;
+        tpl->bytes += e->size;
+        mark_leaf(tpl, tpl->n);
+    }
+}
+
+/* Move id and its included descendants back to the excluded set */
+static void tpl_exclude(bloom_template *tpl, uint32_t id) {
+    bloom_mempool *pool = tpl->pool;
+    uint32_t stamp = ++pool->epoch;
+    uint32_t n = 0;
+
+    pool->entries[id].visit = stamp;
+    tpl->evicted[n++] = id;
+    for (uint32_t head = 0; head < n; head++) {
+        const mp_entry *e = &pool->entries[tpl->evicted[head]];
+        for (uint32_t k = 0; k < e->n_children; k++) {
+            uint32_t c = e->children[k];
+            if (tpl->pos[c] != NONE && pool->entries[c].visit != stamp) {
+                pool->entries[c].visit = stamp;
+                tpl->evicted[n++] = c;
+            }
+        }
+    }
+    sort_topological(pool, tpl->evicted, n);
+    while (n > 0) {
+        uint32_t x = tpl->evicted[--n];
+        const mp_entry *e = &pool->entries[x];
+        tpl->fees -= e->fee;
+        tpl->bytes -= e->size;
+        heap_remove(&tpl->incl, x);
+        tpl_remove_at(tpl, tpl->pos[x]);
+        heap_push(&tpl->excl, x, -anc_score(e));
+    }
+}
+
+/*
+ * Make room for a candidate package by excluding the weakest included
+ * packages (each with its included descendants). The swap only happens if
+ * it frees `need` bytes and strictly raises template fees, so repeated
+ * swaps cannot cycle.
+ */
+static int tpl_make_room(bloom_template *tpl, uint32_t cand, uint64_t pkg_fee,
+                         uint64_t need) {
+    bloom_mempool *pool = tpl->pool;
+    uint32_t victims[TEMPLATE_MAX_EVICTIONS];
+    uint32_t n = 0, n_anc, n_set = 0, stamp, k;
+    uint64_t freed = 0, lost_fee = 0;
+
+    n_anc = collect(pool, &cand, 1, 1, tpl->anc);
+    stamp = ++pool->epoch;
+
+    while (freed < need && n < TEMPLATE_MAX_EVICTIONS && tpl->incl.n > 0) {
+        uint32_t weakest = tpl->incl.nodes[0].id;
+        uint32_t head;
+
+        for (k = 1; k < n_anc && tpl->anc[k] != weakest; k++) {}
+        if (k < n_anc) break;
+        heap_remove(&tpl->incl, weakest);
+        victims[n++] = weakest;
+        if (pool->entries[weakest].visit == stamp) continue;
+
+        /* Victim set: weakest plus its included descendants */
+        head = n_set;
+        pool->entries[weakest].visit = stamp;
+        tpl->evicted[n_set++] = weakest;
+        for (; head < n_set; head++) {
+            const mp_entry *e = &pool->entries[tpl->evicted[head]];
+            freed += e->size;
+            lost_fee += e->fee;
+            for (k = 0; k < e->n_children; k++) {
+                uint32_t c = e->children[k];
+                if (tpl->pos[c] != NONE && pool->entries[c].visit != stamp) {
+                    pool->entries[c].visit = stamp;
+                    tpl->evicted[n_set++] = c;
+                }
+            }
+        }
+        if (lost_fee >= pkg_fee) break;
+    }
+    for (k = 0; k < n; k++) {
+        heap_push(&tpl->incl, victims[k], anc_score(&pool->entries[victims[k]]));
+    }
+    if (freed < need || lost_fee >= pkg_fee) return 0;
+
+    /* Earlier exclusions may already have taken later victims as descendants */
+    for (k = 0; k < n; k++) {
+        if (tpl->pos[victims[k]] != NONE) tpl_exclude(tpl, victims[k]);
+    }
+    return 1;
+}
+
+/* Greedy fill by ancestor score, swapping out weaker packages when full */
+static void tpl_fill(bloom_template *tpl) {
+    uint32_t skips = 0, n_stash = 0;
+    uint32_t budget = 2 * (tpl->excl.n + tpl->incl.n) + TEMPLATE_MAX_SKIPS;
+
+    while (tpl->excl.n > 0 && skips < TEMPLATE_MAX_SKIPS && budget-- > 0) {
+        uint32_t cand = tpl->excl.nodes[0].id;
+        uint64_t bytes, fees;
+        uint32_t n = tpl_package(tpl, cand, &bytes, &fees);
+
+        if (tpl->bytes + bytes > tpl->max_bytes && bytes <= tpl->max_bytes &&
+            tpl_make_room(tpl, cand, fees, tpl->bytes + bytes - tpl->max_bytes)) {
+            n = tpl_package(tpl, cand, &bytes, &fees);
+        }
+
+        if (tpl->bytes + bytes <= tpl->max_bytes) {
+            tpl_include(tpl, n);
+        } else {
+            heap_remove(&tpl->excl, cand);
+            tpl->stash[n_stash++] = cand;
+            skips++;
+        }
+    }
+    while (n_stash > 0) {
+        uint32_t id = tpl->stash[--n_stash];
+        if (tpl->pos[id] != NONE) continue;   /* pulled in as an ancestor */
+        heap_push(&tpl->excl, id, -anc_score(&tpl->pool->entries[id]));
+    }
+}
+
+/* Recompute Merkle nodes on the paths from dirty leaves to the root */
+static void tpl_update_merkle(bloom_template *tpl, uint8_t root[32]) {
+    bloom_mempool *pool = tpl->pool;
+    uint32_t leaves = tpl->n + 1;
+    uint32_t *cur = tpl->dirty, *next = tpl->dirty_next;
+    uint32_t n_cur, width, l, k;
+
+    if (leaves != tpl->prev_leaves) mark_leaf(tpl, leaves - 1);
+    if (tpl->dirty_from < leaves) {
+        for (k = tpl->dirty_from; k < leaves; k++) {
+            if (!tpl->dirty_flag[k]) {
+                tpl->dirty_flag[k] = 1;
+                tpl->dirty[tpl->n_dirty++] = k;
+            }
+        }
+    }
+    tpl->dirty_from = NONE;
+
+    /* Level 0: refresh leaf hashes, dropping leaves past the end */
+    n_cur = 0;
+    for (k = 0; k < tpl->n_dirty; k++) {
+        uint32_t leaf = tpl->dirty[k];
+        tpl->dirty_flag[leaf] = 0;
+        if (leaf >= leaves) continue;
+        memcpy(tpl->levels[0] + (size_t)leaf * 32,
+               leaf == 0 ? tpl->coinbase : pool->entries[tpl->order[leaf - 1]].txid, 32);
+        cur[n_cur++] = leaf;
+    }
+    tpl->n_dirty = 0;
+    qsort(cur, n_cur, sizeof(uint32_t), cmp_u32);
+
+    for (width = leaves, l = 0; width > 1; width = (width + 1) / 2, l++) {
+        const uint8_t *lvl = tpl->levels[l];
+        uint8_t *up = tpl->levels[l + 1];
+        uint32_t n_next = 0;
+        uint32_t *tmp;
+
+        for (k = 0; k < n_cur; k++) {
+            uint32_t j = cur[k] >> 1;
+            if (n_next > 0 && next[n_next - 1] == j) continue;
+            next[n_next++] = j;
+            tpl->node_fn(lvl + (size_t)(2 * j) * 32,
+                         lvl + (size_t)(2 * j + 1 < width ? 2 * j + 1 : 2 * j) * 32,
+                         up + (size_t)j * 32);
+        }
+        tmp = cur;
+        cur = next;
+        next = tmp;
+        n_cur = n_next;
+    }
+    /* Keep the dirty buffer pointers stable across calls */
+    if (cur != tpl->dirty) {
+        tpl->dirty_next = tpl->dirty;
+        tpl->dirty = cur;
+    }
+
+    tpl->prev_leaves = leaves;
+    memcpy(root, tpl->levels[l], 32);
+}
+
+void bloom_template_refresh(bloom_template *tpl, uint8_t merkle_root[32]) {
+    tpl_fill(tpl);
+    tpl_update_merkle(tpl, merkle_root);
+}
+
+void bloom_template_rebuild(bloom_template *tpl, uint8_t merkle_root[32]) {
+    while (tpl->n > 0) {
+        uint32_t id = tpl->order[--tpl->n];
+        tpl->pos[id] = NONE;
+        heap_remove(&tpl->incl, id);
+        heap_push(&tpl->excl, id, -anc_score(&tpl->pool->entries[id]));
+    }
+    tpl->fees = 0;
+    tpl->bytes = 0;
+    tpl->dirty_from = 1;
+    tpl_fill(tpl);
+    tpl_update_merkle(tpl, merkle_root);
+}
+
+uint32_t bloom_template_count(const bloom_template *tpl) {
+    return tpl->n;
+}
+
+size_t bloom_template_txids(const bloom_template *tpl,
+                            uint8_t (*out)[32], size_t max) {
+    size_t n = tpl->n < max ? tpl->n : max;
+    for (size_t i = 0; i < n; i++) {
+        memcpy(out[i], tpl->pool->entries[tpl->order[i]].txid, 32);
+    }
+    return n;
+}
+
+uint64_t bloom_template_fees(const bloom_template *tpl) {
+    return tpl->fees;
+}
+
+uint64_t bloom_template_bytes(const bloom_template *tpl) {
+    return tpl->bytes;
+}
+
+/* ========================================================================== */
+/* Test Main                                                                   */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+
+#include <stdio.h>
+#include <time.h>
+
+static uint64_t rng_state = 0x2545F4914F6CDD1DULL;
+
+static uint64_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+/* double_sha256(serial.to_bytes(4, 'big')) */
+static void make_txid(uint32_t serial, uint8_t txid[32]) {
+    uint8_t seed[4] = { (uint8_t)(serial >> 24), (uint8_t)(serial >> 16),
+                        (uint8_t)(serial >> 8), (uint8_t)serial };
+    bloom_sha256d(seed, 4, txid);
+}
+
+static void to_hex(const uint8_t d[32], char out[65]) {
+    for (int i = 0; i < 32; i++) sprintf(out + 2 * i, "%02x", d[i]);
+}
+
+/* Full recomputation, to check the incremental root after churn */
+static void naive_root(uint8_t (*leaves)[32], size_t n, uint8_t root[32]) {
+    while (n > 1) {
+        size_t m = 0;
+        for (size_t i = 0; i < n; i += 2) {
+            default_node_fn(leaves[i], leaves[i + 1 < n ? i + 1 : i], leaves[m++]);
+        }
+        n = m;
+    }
+    memcpy(root, leaves[0], 32);
+}
+
+/*
+ * Known answer from core/merkle.compute_merkle_root() over the coinbase
+ * make_txid(0xC0FFEE) and make_txid(2000001..2000004): five leaves, so
+ * the odd last node is duplicated on two levels.
+ */
+static int check_known_root(void) {
+    static const char expect[] =
+        "4b951432d426056ffea5d97e055c09b00658c1589d643fc6fc978f60ae404e5f";
+    bloom_mempool *pool = bloom_mempool_create(16, 100000);
+    bloom_template *tpl = bloom_template_create(pool, 100000, NULL);
+    uint8_t root[32], cb[32];
+    char hex[65];
+
+    for (uint32_t i = 0; i < 4; i++) {
+        bloom_outpoint in;
+        bloom_tx_info tx;
+        memset(&in, 0, sizeof(in));
+        memset(in.txid, 0xC0 + i, 32);
+        make_txid(2000001 + i, tx.txid);
+        tx.fee = 4000 - 1000 * i;       /* block order = serial order */
+        tx.size = 250;
+        tx.inputs = &in;
+        tx.n_inputs = 1;
+        bloom_mempool_add(pool, &tx);
+    }
+    make_txid(0xC0FFEE, cb);
+    bloom_template_set_coinbase(tpl, cb);
+    bloom_template_refresh(tpl, root);
+    to_hex(root, hex);
+
+    bloom_template_destroy(tpl);
+    bloom_mempool_destroy(pool);
+    return strcmp(hex, expect) == 0;
+}
+
+static int check_template(bloom_template *tpl, const uint8_t root[32]) {
+    bloom_mempool *pool = tpl->pool;
+    uint32_t n = bloom_template_count(tpl);
+    uint8_t (*leaves)[32] = malloc((n + 1) * 32);
+    uint8_t expect[32];
+    uint64_t bytes = 0;
+    int ok = 1;
+
+    memcpy(leaves[0], tpl->coinbase, 32);
+    bloom_template_txids(tpl, leaves + 1, n);
+    naive_root(leaves, n + 1, expect);
+    if (memcmp(expect, root, 32) != 0) ok = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        const mp_entry *e = &pool->entries[tpl->order[i]];
+        bytes += e->size;
+        for (uint32_t k = 0; k < e->n_parents; k++) {
+            uint32_t pp = tpl->pos[e->parents[k]];
+            if (pp == NONE || pp >= i) ok = 0;
+        }
+    }
+    if (bytes != tpl->bytes || bytes > tpl->max_bytes) ok = 0;
+    free(leaves);
+    return ok;
+}
+
+int main(void) {
+    const uint32_t CAP = 20000;
+    bloom_mempool *pool = bloom_mempool_create(CAP, 4000000);
+    bloom_template *tpl = bloom_template_create(pool, 100000, NULL);
+    uint8_t (*live)[32] = malloc(CAP * 4 * 32);
+    uint32_t n_live = 0, serial = 0, round;
+    uint8_t root[32], txid[32], cb[32];
+    int failures = 0;
+    double total_us = 0, worst_us = 0;
+
+    printf("BloomCoin Native Mempool\n");
+    printf("========================\n\n");
+
+    /* Ancestor / descendant aggregates on a simple chain */
+    {
+        bloom_outpoint in;
+        bloom_tx_info tx;
+        uint8_t a[32], b[32];
+        uint64_t af = 0, as = 0, df = 0, ds = 0;
+        uint32_t ac = 0, dc = 0;
+
+        make_txid(1000001, a);
+        memset(&in, 0, sizeof(in));
+        memset(in.txid, 0xAB, 32);
+        memcpy(tx.txid, a, 32); tx.fee = 1000; tx.size = 250;
+        tx.inputs = &in; tx.n_inputs = 1;
+        bloom_mempool_add(pool, &tx);
+
+        make_txid(1000002, b);
+        memcpy(in.txid, a, 32); in.index = 0;
+        memcpy(tx.txid, b, 32); tx.fee = 5000; tx.size = 250;
+        bloom_mempool_add(pool, &tx);
+
+        bloom_mempool_get_aggregates(pool, b, &af, &as, &ac, NULL, NULL, NULL);
+        bloom_mempool_get_aggregates(pool, a, NULL, NULL, NULL, &df, &ds, &dc);
+        printf("  Chain aggregates: anc=(%llu,%llu,%u) desc=(%llu,%llu,%u) %s\n",
+               (unsigned long long)af, (unsigned long long)as, ac,
+               (unsigned long long)df, (unsigned long long)ds, dc,
+               (af == 6000 && as == 500 && ac == 2 && df == 6000 && dc == 2) ? "OK" : "FAIL");
+        if (!(af == 6000 && ac == 2 && df == 6000 && dc == 2)) failures++;
+
+        /* Low-fee double spend is rejected, high-fee one replaces both */
+        make_txid(1000003, txid);
+        memset(in.txid, 0xAB, 32); in.index = 0;
+        memcpy(tx.txid, txid, 32); tx.fee = 2000; tx.size = 250;
+        if (bloom_mempool_add(pool, &tx) != BLOOM_MEMPOOL_ERR_CONFLICT) failures++;
+        tx.fee = 9000;
+        if (bloom_mempool_add(pool, &tx) != BLOOM_MEMPOOL_OK) failures++;
+        printf("  Replace-by-fee: %s\n",
+               (!bloom_mempool_contains(pool, a) && !bloom_mempool_contains(pool, b) &&
+                bloom_mempool_contains(pool, txid)) ? "OK" : "FAIL");
+        if (bloom_mempool_contains(pool, a) || bloom_mempool_contains(pool, b)) failures++;
+        bloom_mempool_remove(pool, txid);
+    }
+
+    {
+        int ok = check_known_root();
+        printf("  Root matches core/merkle.py: %s\n", ok ? "OK" : "FAIL");
+        if (!ok) failures++;
+    }
+
+    make_txid(0xC0FFEE, cb);
+    bloom_template_set_coinbase(tpl, cb);
+
+    /* Churn: arrivals with dependencies, conflicts and block confirmations */
+    for (round = 0; round < 400; round++) {
+        struct timespec t0, t1;
+        double us;
+
+        for (int j = 0; j < 100; j++) {
+            bloom_outpoint ins[3];
+            bloom_tx_info tx;
+            uint32_t n_in = 1 + (uint32_t)(rng_next() % 3);
+            for (uint32_t k = 0; k < n_in; k++) {
+                if (n_live > 0 && rng_next() % 3 == 0) {
+                    memcpy(ins[k].txid, live[rng_next() % n_live], 32);
+                    ins[k].index = (uint32_t)(rng_next() % 2);
+                } else {
+                    make_txid(0x80000000u | (uint32_t)rng_next(), ins[k].txid);
+                    ins[k].index = 0;
+                }
+            }
+            make_txid(++serial, tx.txid);
+            tx.fee = 200 + rng_next() % 20000;
+            tx.size = 150 + (uint32_t)(rng_next() % 600);
+            tx.inputs = ins;
+            tx.n_inputs = n_in;
+            if (bloom_mempool_add(pool, &tx) == BLOOM_MEMPOOL_OK && n_live < CAP * 4) {
+                memcpy(live[n_live++], tx.txid, 32);
+            }
+        }
+        if (round % 25 == 24) {
+            uint8_t (*mined)[32] = malloc(64 * 32);
+            size_t m = bloom_template_txids(tpl, mined, 64);
+            bloom_mempool_remove_for_block(pool, (const uint8_t (*)[32])mined, m);
+            free(mined);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        bloom_template_refresh(tpl, root);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        us = (t1.tv_sec - t0.tv_sec) * 1e6 + (t1.tv_nsec - t0.tv_nsec) / 1e3;
+        total_us += us;
+        if (us > worst_us) worst_us = us;
+
+        if (!check_template(tpl, root)) {
+            printf("  Template check failed at round %u\n", round);
+            failures++;
+            break;
+        }
+    }
+
+    printf("  Pool: %u txs, %llu bytes\n", bloom_mempool_count(pool),
+           (unsigned long long)bloom_mempool_bytes(pool));
+    printf("  Template: %u txs, %llu bytes, %llu fees\n", bloom_template_count(tpl),
+           (unsigned long long)bloom_template_bytes(tpl),
+           (unsigned long long)bloom_template_fees(tpl));
+    printf("  Refresh latency: avg %.1f us, worst %.1f us\n", total_us / round, worst_us);
+
+    bloom_template_rebuild(tpl, root);
+    if (!check_template(tpl, root)) failures++;
+    printf("  Rebuild root matches reference: %s\n", check_template(tpl, root) ? "OK" : "FAIL");
+
+    bloom_template_destroy(tpl);
+    bloom_mempool_destroy(pool);
+    free(live);
+
+    printf("\n%s\n", failures ? "FAILURES DETECTED" : "All mempool tests passed.");
+    return failures ? 1 : 0;
+}
+
+#endif /* TEST_MAIN */
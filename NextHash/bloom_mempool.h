@@ -0,0 +1,136 @@
+/*
+ * BloomCoin Native Mempool
+ * ========================
+ *
+ * Transaction pool with a fee-rate priority index and an incremental
+ * block-template builder.
+ *
+ * Features:
+ * - Fixed-capacity entry arena with free list
+ * - Ancestor / descendant fee and size aggregates per entry
+ * - Conflict detection on spent outpoints with replace-by-fee
+ * - Size-bounded pool with lowest-descendant-score eviction
+ * - Block template that tracks pool changes and updates its Merkle
+ *   root along dirty paths only
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef BLOOM_MEMPOOL_H
+#define BLOOM_MEMPOOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Policy limits */
+#define BLOOM_MEMPOOL_MAX_ANCESTORS   25
+#define BLOOM_MEMPOOL_MAX_DESCENDANTS 25
+#define BLOOM_MEMPOOL_NONE            0xFFFFFFFFu
+
+/* Status codes */
+#define BLOOM_MEMPOOL_OK               0
+#define BLOOM_MEMPOOL_ERR_DUPLICATE   -1   /* txid already in pool */
+#define BLOOM_MEMPOOL_ERR_FULL        -2   /* no room, fee rate too low */
+#define BLOOM_MEMPOOL_ERR_CONFLICT    -3   /* double spend, RBF rules not met */
+#define BLOOM_MEMPOOL_ERR_CHAIN_LIMIT -4   /* ancestor/descendant limit */
+#define BLOOM_MEMPOOL_ERR_NOT_FOUND   -5
+#define BLOOM_MEMPOOL_ERR_NOMEM       -6
+
+/* Reference to a previous output (TxInput.prev_tx, TxInput.output_index) */
+typedef struct {
+    uint8_t txid[32];
+    uint32_t index;
+} bloom_outpoint;
+
+/* Summary of a transaction as seen by the pool */
+typedef struct {
+    uint8_t txid[32];
+    uint64_t fee;                   /* sum(inputs) - sum(outputs) */
+    uint32_t size;                  /* serialized size in bytes */
+    const bloom_outpoint *inputs;
+    uint32_t n_inputs;
+} bloom_tx_info;
+
+/* Merkle node hash: out = H(left || right) */
+typedef void (*bloom_merkle_node_fn)(const uint8_t left[32],
+                                     const uint8_t right[32],
+                                     uint8_t out[32]);
+
+typedef struct bloom_mempool bloom_mempool;
+typedef struct bloom_template bloom_template;
+
+/* ---- Pool ---------------------------------------------------------------- */
+
+/* Create a pool holding at most max_entries transactions / max_bytes bytes */
+bloom_mempool *bloom_mempool_create(uint32_t max_entries, uint64_t max_bytes);
+void bloom_mempool_destroy(bloom_mempool *pool);
+
+/* Add a transaction; in-pool conflicts are replaced if fee rules allow */
+int bloom_mempool_add(bloom_mempool *pool, const bloom_tx_info *tx);
+
+/* Remove a transaction and all of its in-pool descendants */
+int bloom_mempool_remove(bloom_mempool *pool, const uint8_t txid[32]);
+
+/* Remove transactions confirmed in a block (descendants stay in the pool) */
+void bloom_mempool_remove_for_block(bloom_mempool *pool,
+                                    const uint8_t (*txids)[32], size_t n);
+
+/* Remove in-pool spenders of outpoints consumed by a block (with descendants) */
+void bloom_mempool_remove_spenders(bloom_mempool *pool,
+                                   const bloom_outpoint *spent, size_t n);
+
+int bloom_mempool_contains(const bloom_mempool *pool, const uint8_t txid[32]);
+uint32_t bloom_mempool_count(const bloom_mempool *pool);
+uint64_t bloom_mempool_bytes(const bloom_mempool *pool);
+
+/* Up to max pool txids in arbitrary order; returns the number written */
+size_t bloom_mempool_txids(const bloom_mempool *pool, uint8_t (*out)[32], size_t max);
+
+/* Ancestor / descendant aggregates (including the transaction itself) */
+int bloom_mempool_get_aggregates(const bloom_mempool *pool,
+                                 const uint8_t txid[32],
+                                 uint64_t *anc_fee, uint64_t *anc_size,
+                                 uint32_t *anc_count,
+                                 uint64_t *desc_fee, uint64_t *desc_size,
+                                 uint32_t *desc_count);
+
+/* ---- Block template ------------------------------------------------------ */
+
+/*
+ * Create a template bound to a pool. The pool reports every add/remove to
+ * the template; bloom_template_refresh() folds the changes in. Leaf 0 of
+ * the Merkle tree is reserved for the coinbase. A NULL node_fn selects
+ * double SHA-256 over the 64-byte concatenation, as core/merkle.py does
+ * for the roots block validation checks. At most one template may be
+ * bound to a pool, and it must be destroyed before the pool.
+ */
+bloom_template *bloom_template_create(bloom_mempool *pool,
+                                      uint64_t max_block_bytes,
+                                      bloom_merkle_node_fn node_fn);
+void bloom_template_destroy(bloom_template *tpl);
+
+void bloom_template_set_coinbase(bloom_template *tpl, const uint8_t txid[32]);
+
+/* Apply pending pool changes, refill free space, update the Merkle root */
+void bloom_template_refresh(bloom_template *tpl, uint8_t merkle_root[32]);
+
+/* Discard the template contents and reselect from scratch */
+void bloom_template_rebuild(bloom_template *tpl, uint8_t merkle_root[32]);
+
+/* Transactions in block order (excluding coinbase); returns count */
+uint32_t bloom_template_count(const bloom_template *tpl);
+size_t bloom_template_txids(const bloom_template *tpl,
+                            uint8_t (*out)[32], size_t max);
+uint64_t bloom_template_fees(const bloom_template *tpl);
+uint64_t bloom_template_bytes(const bloom_template *tpl);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOOM_MEMPOOL_H */
@@ -0,0 +1,600 @@
+/*
+ * BloomCoin Agent Memory Store
+ * ============================
+ *
+ * Compile: gcc -O3 -mavx2 -o bloom_memstore bloom_memstore.c -DTEST_MAIN
+ *          gcc -O3 -mavx2 -shared -fPIC -o libbloom_memstore.so bloom_memstore.c
+ */
+
+#include "bloom_memstore.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/* Same doubles as the Python objects: no contraction into FMA */
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#define NONE BLOOM_MEMSTORE_NONE
+
+/* ========================================================================== */
+/* Internal Structures                                                         */
+/* ========================================================================== */
+
+struct bloom_memstore {
+    uint32_t n_agents;
+
+    /* Columns, one row per memory, in insertion order */
+    size_t n, cap;
+    uint32_t *id;
+    uint32_t *agent;
+    uint8_t *type;
+    uint8_t *flags;
+    double *timestamp;
+    double *coherence;
+    double *novelty;
+    uint32_t *access_count;
+
+    /* id -> row */
+    uint32_t *row_of;
+    uint32_t next_id, cap_ids;
+
+    /* Access counts of each summary's top list, n_agents x TOP */
+    uint32_t *top_access;
+};
+
+bloom_memstore *bloom_memstore_create(uint32_t n_agents) {
+    if (n_agents == 0) return NULL;
+    bloom_memstore *s = (bloom_memstore *)calloc(1, sizeof(bloom_memstore));
+    if (!s) return NULL;
+    s->n_agents = n_agents;
+    s->top_access = (uint32_t *)malloc((size_t)n_agents * BLOOM_MEMSTORE_TOP * sizeof(uint32_t));
+    if (!s->top_access) {
+        free(s);
+        return NULL;
+    }
+    return s;
+}
+
+void bloom_memstore_destroy(bloom_memstore *s) {
+    if (!s) return;
+    free(s->id);
+    free(s->agent);
+    free(s->type);
+    free(s->flags);
+    free(s->timestamp);
+    free(s->coherence);
+    free(s->novelty);
+    free(s->access_count);
+    free(s->row_of);
+    free(s->top_access);
+    free(s);
+}
+
+static int grow(void **p, size_t cap, size_t size) {
+    void *q = realloc(*p, cap * size);
+    if (!q) return 0;
+    *p = q;
+    return 1;
+}
+
+static int reserve(bloom_memstore *s, size_t need) {
+    if (need > s->cap) {
+        size_t cap = s->cap ? s->cap : 1024;
+        while (cap < need) cap *= 2;
+        if (!grow((void **)&s->id, cap, sizeof(uint32_t)) ||
+            !grow((void **)&s->agent, cap, sizeof(uint32_t)) ||
+            !grow((void **)&s->type, cap, 1) ||
+            !grow((void **)&s->flags, cap, 1) ||
+            !grow((void **)&s->timestamp, cap, sizeof(double)) ||
+            !grow((void **)&s->coherence, cap, sizeof(double)) ||
+            !grow((void **)&s->novelty, cap, sizeof(double)) ||
+            !grow((void **)&s->access_count, cap, sizeof(uint32_t))) {
+            return 0;
+        }
+        s->cap = cap;
+    }
+    return 1;
+}
+
+static void put(bloom_memstore *s, size_t row, const bloom_memstore_entry *e) {
+    s->agent[row] = e->agent;
+    s->type[row] = e->type;
+    s->timestamp[row] = e->timestamp;
+    s->coherence[row] = e->coherence;
+    s->novelty[row] = e->novelty;
+    s->access_count[row] = e->access_count;
+}
+
+/* ========================================================================== */
+/* Rows and Ids                                                                */
+/* ========================================================================== */
+
+int bloom_memstore_add(bloom_memstore *s, const bloom_memstore_entry *entries, size_t n,
+                       uint32_t *ids) {
+    for (size_t i = 0; i < n; i++) {
+        if (entries[i].agent >= s->n_agents) return BLOOM_MEMSTORE_ERR_INVALID;
+    }
+    if ((uint64_t)s->next_id + n >= NONE) return BLOOM_MEMSTORE_ERR_NOMEM;
+    if (!reserve(s, s->n + n)) return BLOOM_MEMSTORE_ERR_NOMEM;
+    if (s->next_id + n > s->cap_ids) {
+        uint32_t cap = s->cap_ids ? s->cap_ids : 1024;
+        while (cap < s->next_id + n) cap = cap > NONE / 2 ? NONE : cap * 2;
+        if (!grow((void **)&s->row_of, cap, sizeof(uint32_t))) return BLOOM_MEMSTORE_ERR_NOMEM;
+        s->cap_ids = cap;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        size_t row = s->n++;
+        uint32_t id = s->next_id++;
+        put(s, row, &entries[i]);
+        s->flags[row] = 0;
+        s->id[row] = id;
+        s->row_of[id] = (uint32_t)row;
+        if (ids) ids[i] = id;
+    }
+    return BLOOM_MEMSTORE_OK;
+}
+
+size_t bloom_memstore_count(const bloom_memstore *s) {
+    return s->n;
+}
+
+uint32_t bloom_memstore_row(const bloom_memstore *s, uint32_t id) {
+    return id < s->next_id ? s->row_of[id] : NONE;
+}
+
+int bloom_memstore_get(const bloom_memstore *s, uint32_t id, bloom_memstore_entry *out) {
+    uint32_t row = bloom_memstore_row(s, id);
+    if (row == NONE) return BLOOM_MEMSTORE_ERR_INVALID;
+    out->agent = s->agent[row];
+    out->type = s->type[row];
+    out->timestamp = s->timestamp[row];
+    out->coherence = s->coherence[row];
+    out->novelty = s->novelty[row];
+    out->access_count = s->access_count[row];
+    return BLOOM_MEMSTORE_OK;
+}
+
+int bloom_memstore_set(bloom_memstore *s, uint32_t id, const bloom_memstore_entry *e) {
+    uint32_t row = bloom_memstore_row(s, id);
+    if (row == NONE || e->agent >= s->n_agents) return BLOOM_MEMSTORE_ERR_INVALID;
+    put(s, row, e);
+    return BLOOM_MEMSTORE_OK;
+}
+
+void bloom_memstore_columns_get(const bloom_memstore *s, bloom_memstore_columns *c) {
+    c->n = s->n;
+    c->id = s->id;
+    c->agent = s->agent;
+    c->type = s->type;
+    c->flags = s->flags;
+    c->timestamp = s->timestamp;
+    c->coherence = s->coherence;
+    c->novelty = s->novelty;
+    c->access_count = s->access_count;
+}
+
+size_t bloom_memstore_strengthen(bloom_memstore *s, const uint32_t *ids, size_t n) {
+    size_t found = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t row = bloom_memstore_row(s, ids[i]);
+        if (row == NONE) continue;
+        s->access_count[row]++;
+        double c = s->coherence[row] + 0.01;
+        s->coherence[row] = c < 1.0 ? c : 1.0;
+        found++;
+    }
+    return found;
+}
+
+/* ========================================================================== */
+/* Decay                                                                       */
+/* ========================================================================== */
+
+void bloom_memstore_decay(bloom_memstore *s, double now, double factor,
+                          const double *agent_factor) {
+    const double *ts = s->timestamp;
+    double *nov = s->novelty;
+    size_t i = 0, n = s->n;
+#if defined(__AVX2__)
+    __m256d vnow = _mm256_set1_pd(now), vf = _mm256_set1_pd(factor), zero = _mm256_setzero_pd();
+    for (; i + 4 <= n; i += 4) {
+        if (agent_factor) {
+            __m128i ag = _mm_loadu_si128((const __m128i *)(s->agent + i));
+            vf = _mm256_i32gather_pd(agent_factor, ag, 8);
+        }
+        __m256d decay = _mm256_mul_pd(_mm256_sub_pd(vnow, _mm256_loadu_pd(ts + i)), vf);
+        __m256d v = _mm256_sub_pd(_mm256_loadu_pd(nov + i), decay);
+        /* max(0, v) returns 0 for v <= 0, so NaN-free inputs match */
+        _mm256_storeu_pd(nov + i, _mm256_max_pd(v, zero));
+    }
+#endif
+    for (; i < n; i++) {
+        double f = agent_factor ? agent_factor[s->agent[i]] : factor;
+        double v = nov[i] - (now - ts[i]) * f;
+        nov[i] = v > 0 ? v : 0;
+    }
+}
+
+void bloom_memstore_decay_ids(bloom_memstore *s, double now, double factor,
+                              const uint32_t *ids, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        uint32_t row = bloom_memstore_row(s, ids[i]);
+        if (row == NONE) continue;
+        double v = s->novelty[row] - (now - s->timestamp[row]) * factor;
+        s->novelty[row] = v > 0 ? v : 0;
+    }
+}
+
+/* ========================================================================== */
+/* Consolidation                                                               */
+/* ========================================================================== */
+
+/* Flags column under a policy */
+static void mark(bloom_memstore *s, const bloom_memstore_policy *p) {
+    size_t i = 0, n = s->n;
+#if defined(__AVX2__)
+    __m256d vnow = _mm256_set1_pd(p->now), win = _mm256_set1_pd(p->recent_window);
+    __m256d fade = _mm256_set1_pd(p->fade_novelty);
+    /* Unsigned compare by flipping the sign bit */
+    __m128i bias = _mm_set1_epi32((int)0x80000000u);
+    __m128i keep = _mm_xor_si128(_mm_set1_epi32((int)p->keep_access), bias);
+    for (; i + 4 <= n; i += 4) {
+        __m256d age = _mm256_sub_pd(vnow, _mm256_loadu_pd(s->timestamp + i));
+        int recent = _mm256_movemask_pd(_mm256_cmp_pd(age, win, _CMP_LT_OQ));
+        __m256d low = _mm256_cmp_pd(_mm256_loadu_pd(s->novelty + i), fade, _CMP_LE_OQ);
+        __m128i acc = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(s->access_count + i)), bias);
+        __m256d rare = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm_cmplt_epi32(acc, keep)));
+        int faded = _mm256_movemask_pd(_mm256_and_pd(low, rare));
+        for (int k = 0; k < 4; k++) {
+            s->flags[i + k] = (uint8_t)((recent >> k & 1) * BLOOM_MEMSTORE_RECENT |
+                                        (faded >> k & 1) * BLOOM_MEMSTORE_FADED);
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        int recent = p->now - s->timestamp[i] < p->recent_window;
+        int faded = s->novelty[i] <= p->fade_novelty && s->access_count[i] < p->keep_access;
+        s->flags[i] = (uint8_t)(recent * BLOOM_MEMSTORE_RECENT | faded * BLOOM_MEMSTORE_FADED);
+    }
+}
+
+/*
+ * Count row i into a summary. Top list by access count; rows arrive oldest
+ * first, so a tie never displaces an earlier memory (Python's stable sort).
+ */
+static void summary_add(bloom_memstore *s, size_t i, bloom_memstore_summary *a, uint32_t *ta) {
+    uint8_t f = s->flags[i];
+    a->memories++;
+    a->recent += f & BLOOM_MEMSTORE_RECENT;
+    a->faded += (f & BLOOM_MEMSTORE_FADED) >> 1;
+
+    uint32_t acc = s->access_count[i];
+    uint32_t k = a->n_top;
+    if (k == BLOOM_MEMSTORE_TOP) {
+        if (acc <= ta[k - 1]) return;
+        k--;
+    } else {
+        a->n_top++;
+    }
+    while (k > 0 && ta[k - 1] < acc) {
+        a->top[k] = a->top[k - 1];
+        ta[k] = ta[k - 1];
+        k--;
+    }
+    a->top[k] = s->id[i];
+    ta[k] = acc;
+}
+
+static void summary_pad(bloom_memstore_summary *a) {
+    for (uint32_t k = a->n_top; k < BLOOM_MEMSTORE_TOP; k++) a->top[k] = NONE;
+}
+
+void bloom_memstore_consolidate(bloom_memstore *s, const bloom_memstore_policy *p,
+                                bloom_memstore_summary *sum) {
+    mark(s, p);
+    memset(sum, 0, s->n_agents * sizeof(bloom_memstore_summary));
+
+    for (size_t i = 0; i < s->n; i++) {
+        summary_add(s, i, &sum[s->agent[i]],
+                    s->top_access + (size_t)s->agent[i] * BLOOM_MEMSTORE_TOP);
+    }
+    for (uint32_t g = 0; g < s->n_agents; g++) summary_pad(&sum[g]);
+}
+
+void bloom_memstore_summarize(bloom_memstore *s, const bloom_memstore_policy *p,
+                              const uint32_t *ids, size_t n, bloom_memstore_summary *sum) {
+    uint32_t ta[BLOOM_MEMSTORE_TOP];
+
+    memset(sum, 0, sizeof(*sum));
+    for (size_t i = 0; i < n; i++) {
+        uint32_t row = bloom_memstore_row(s, ids[i]);
+        if (row == NONE) continue;
+        int recent = p->now - s->timestamp[row] < p->recent_window;
+        int faded = s->novelty[row] <= p->fade_novelty && s->access_count[row] < p->keep_access;
+        s->flags[row] = (uint8_t)(recent * BLOOM_MEMSTORE_RECENT | faded * BLOOM_MEMSTORE_FADED);
+        summary_add(s, row, sum, ta);
+    }
+    summary_pad(sum);
+}
+
+size_t bloom_memstore_forget(bloom_memstore *s, const bloom_memstore_policy *p) {
+    mark(s, p);
+    size_t kept = 0;
+    for (size_t i = 0; i < s->n; i++) {
+        if (s->flags[i] & BLOOM_MEMSTORE_FADED) {
+            s->row_of[s->id[i]] = NONE;
+            continue;
+        }
+        if (kept != i) {
+            s->id[kept] = s->id[i];
+            s->agent[kept] = s->agent[i];
+            s->type[kept] = s->type[i];
+            s->flags[kept] = s->flags[i];
+            s->timestamp[kept] = s->timestamp[i];
+            s->coherence[kept] = s->coherence[i];
+            s->novelty[kept] = s->novelty[i];
+            s->access_count[kept] = s->access_count[i];
+            s->row_of[s->id[kept]] = (uint32_t)kept;
+        }
+        kept++;
+    }
+    size_t removed = s->n - kept;
+    s->n = kept;
+    return removed;
+}
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <stdio.h>
+#include <time.h>
+
+static uint64_t test_rng = 0x2545F4914F6CDD1Dull;
+
+static uint64_t xorshift(void) {
+    test_rng ^= test_rng << 13;
+    test_rng ^= test_rng >> 7;
+    test_rng ^= test_rng << 17;
+    return test_rng;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Python-style objects: one heap record per memory, a list per agent */
+typedef struct {
+    double timestamp, coherence, novelty;
+    uint32_t access_count, id;
+} py_memory;
+
+typedef struct {
+    py_memory **mems;
+    size_t n;
+} py_agent;
+
+int main(void) {
+    int fail = 0, ok;
+    printf("BloomCoin Agent Memory Store\n");
+    printf("============================\n\n");
+
+    const uint32_t AGENTS = 2000, PER_AGENT = 500;
+    const size_t N = (size_t)AGENTS * PER_AGENT;
+    const double T0 = 1.7e9;
+    bloom_memstore *store = bloom_memstore_create(AGENTS);
+    bloom_memstore_entry *e = malloc(N * sizeof(bloom_memstore_entry));
+    uint32_t *ids = malloc(N * sizeof(uint32_t));
+    py_agent *py = calloc(AGENTS, sizeof(py_agent));
+
+    /* Agents learn in interleaved order, as in a garden tick */
+    for (size_t i = 0; i < N; i++) {
+        e[i].agent = (uint32_t)(xorshift() % AGENTS);
+        e[i].type = (uint8_t)(xorshift() % 4);
+        e[i].timestamp = T0 + (double)i * 0.01;
+        e[i].coherence = 0.5;
+        e[i].novelty = 1.0;
+        e[i].access_count = (uint32_t)(xorshift() % 8 == 0 ? xorshift() % 20 : 0);
+    }
+    ok = bloom_memstore_add(store, e, N, ids) == BLOOM_MEMSTORE_OK &&
+         bloom_memstore_count(store) == N;
+    for (size_t i = 0; i < N; i++) {
+        py_agent *a = &py[e[i].agent];
+        if ((a->n & (a->n - 1)) == 0) {
+            a->mems = realloc(a->mems, (a->n ? 2 * a->n : 1) * sizeof(py_memory *));
+        }
+        py_memory *m = malloc(sizeof(py_memory));
+        m->timestamp = e[i].timestamp;
+        m->coherence = e[i].coherence;
+        m->novelty = e[i].novelty;
+        m->access_count = e[i].access_count;
+        m->id = ids[i];
+        a->mems[a->n++] = m;
+    }
+    bloom_memstore_entry one = e[0];
+    one.agent = AGENTS;
+    ok &= bloom_memstore_add(store, &one, 1, NULL) == BLOOM_MEMSTORE_ERR_INVALID;
+    printf("add %zu memories:     %s\n", N, ok ? "OK" : "FAIL");
+    fail |= !ok;
+
+    /* Strengthen a few thousand accessed memories */
+    {
+        uint32_t touched[5000];
+        for (int i = 0; i < 5000; i++) touched[i] = (uint32_t)(xorshift() % N);
+        ok = bloom_memstore_strengthen(store, touched, 5000) == 5000;
+        for (int i = 0; i < 5000; i++) {
+            py_agent *a = &py[e[touched[i]].agent];
+            for (size_t k = 0; k < a->n; k++) {
+                if (a->mems[k]->id != touched[i]) continue;
+                a->mems[k]->access_count++;
+                double c = a->mems[k]->coherence + 0.01;
+                a->mems[k]->coherence = c < 1.0 ? c : 1.0;
+            }
+        }
+        printf("strengthen:               %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Decay ticks: column pass against per-object updates */
+    double *factor = malloc(AGENTS * sizeof(double));
+    for (uint32_t g = 0; g < AGENTS; g++) factor[g] = 1e-6 * (1 + g % 10);
+    {
+        const int TICKS = 10;
+        double t_col = 0, t_obj = 0;
+        for (int t = 0; t < TICKS; t++) {
+            double now = T0 + N * 0.01 + 60.0 * t;
+            double t1 = now_sec();
+            bloom_memstore_decay(store, now, 0, factor);
+            t_col += now_sec() - t1;
+
+            t1 = now_sec();
+            for (uint32_t g = 0; g < AGENTS; g++) {
+                for (size_t k = 0; k < py[g].n; k++) {
+                    py_memory *m = py[g].mems[k];
+                    double v = m->novelty - (now - m->timestamp) * factor[g];
+                    m->novelty = v > 0 ? v : 0;
+                }
+            }
+            t_obj += now_sec() - t1;
+        }
+        ok = 1;
+        for (uint32_t g = 0; g < AGENTS && ok; g++) {
+            for (size_t k = 0; k < py[g].n && ok; k++) {
+                bloom_memstore_entry got = { 0, 0, 0, 0, 0, 0 };
+                bloom_memstore_get(store, py[g].mems[k]->id, &got);
+                ok = got.novelty == py[g].mems[k]->novelty &&
+                     got.coherence == py[g].mems[k]->coherence &&
+                     got.access_count == py[g].mems[k]->access_count;
+            }
+        }
+        printf("decay, %u agents:       %.2f ms per tick (objects %.2f ms)  %s\n", AGENTS,
+               t_col / TICKS * 1e3, t_obj / TICKS * 1e3, ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Consolidation summaries against a per-agent scan */
+    bloom_memstore_policy pol = { T0 + N * 0.01 + 600, 3600, 0.5, 3 };
+    {
+        bloom_memstore_summary *sum = malloc(AGENTS * sizeof(bloom_memstore_summary));
+        double t1 = now_sec();
+        bloom_memstore_consolidate(store, &pol, sum);
+        double dt = now_sec() - t1;
+        ok = 1;
+        uint64_t faded = 0, recent = 0;
+        for (uint32_t g = 0; g < AGENTS && ok; g++) {
+            uint32_t r = 0, f = 0, top[BLOOM_MEMSTORE_TOP], nt = 0;
+            for (size_t k = 0; k < py[g].n; k++) {
+                py_memory *m = py[g].mems[k];
+                r += pol.now - m->timestamp < pol.recent_window;
+                f += m->novelty <= pol.fade_novelty && m->access_count < pol.keep_access;
+            }
+            /* Selection of the five largest, first occurrence on ties */
+            uint8_t *used = calloc(py[g].n, 1);
+            for (; nt < BLOOM_MEMSTORE_TOP && nt < py[g].n; nt++) {
+                size_t best = SIZE_MAX;
+                for (size_t k = 0; k < py[g].n; k++) {
+                    if (used[k]) continue;
+                    if (best == SIZE_MAX || py[g].mems[k]->access_count > py[g].mems[best]->access_count) best = k;
+                }
+                used[best] = 1;
+                top[nt] = py[g].mems[best]->id;
+            }
+            free(used);
+            ok = sum[g].memories == py[g].n && sum[g].recent == r && sum[g].faded == f &&
+                 sum[g].n_top == nt && memcmp(sum[g].top, top, nt * sizeof(uint32_t)) == 0;
+            faded += f;
+            recent += r;
+        }
+        printf("consolidate:              %.2f ms, %llu recent, %llu faded  %s\n", dt * 1e3,
+               (unsigned long long)recent, (unsigned long long)faded, ok ? "OK" : "FAIL");
+        fail |= !ok;
+
+        /* One agent's summary from its own ids, as a KnowledgeBase asks */
+        ok = 1;
+        uint32_t *own = malloc(N * sizeof(uint32_t));
+        t1 = now_sec();
+        for (uint32_t g = 0; g < AGENTS && ok; g++) {
+            bloom_memstore_summary one_sum;
+            for (size_t k = 0; k < py[g].n; k++) own[k] = py[g].mems[k]->id;
+            bloom_memstore_summarize(store, &pol, own, py[g].n, &one_sum);
+            ok = memcmp(&one_sum, &sum[g], sizeof(one_sum)) == 0;
+        }
+        dt = now_sec() - t1;
+        printf("summarize each agent:     %.2f ms for all %u  %s\n", dt * 1e3, AGENTS,
+               ok ? "OK" : "FAIL");
+        fail |= !ok;
+        free(own);
+        free(sum);
+
+        /* Forgetting keeps ids valid for the survivors */
+        size_t removed = bloom_memstore_forget(store, &pol);
+        ok = removed == faded && bloom_memstore_count(store) == N - faded;
+        for (uint32_t g = 0; g < AGENTS && ok; g++) {
+            for (size_t k = 0; k < py[g].n && ok; k++) {
+                py_memory *m = py[g].mems[k];
+                int gone = m->novelty <= pol.fade_novelty && m->access_count < pol.keep_access;
+                bloom_memstore_entry got;
+                int st = bloom_memstore_get(store, m->id, &got);
+                ok = gone ? st == BLOOM_MEMSTORE_ERR_INVALID
+                          : st == BLOOM_MEMSTORE_OK && got.timestamp == m->timestamp;
+            }
+        }
+        bloom_memstore_columns cols;
+        bloom_memstore_columns_get(store, &cols);
+        for (size_t i = 1; i < cols.n && ok; i++) ok = cols.id[i] > cols.id[i - 1];
+        printf("forget:                   %zu removed  %s\n", removed, ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Decay of one agent's ids leaves the other agents alone */
+    {
+        const uint32_t G = 7;
+        double now = T0 + N * 0.01 + 1200;
+        uint32_t *own = calloc(py[G].n + 1, sizeof(uint32_t));
+        uint32_t other = NONE;
+        bloom_memstore_entry before = { 0, 0, 0, 0, 0, 0 }, got;
+        for (size_t k = 0; k < py[G + 1].n && other == NONE; k++) {
+            if (bloom_memstore_get(store, py[G + 1].mems[k]->id, &before) == BLOOM_MEMSTORE_OK) {
+                other = py[G + 1].mems[k]->id;
+            }
+        }
+        for (size_t k = 0; k < py[G].n; k++) own[k] = py[G].mems[k]->id;
+        bloom_memstore_decay_ids(store, now, 1e-5, own, py[G].n);
+        ok = other != NONE;
+        for (size_t k = 0; k < py[G].n && ok; k++) {
+            py_memory *m = py[G].mems[k];
+            if (bloom_memstore_get(store, m->id, &got) != BLOOM_MEMSTORE_OK) continue;
+            double v = m->novelty - (now - m->timestamp) * 1e-5;
+            ok = got.novelty == (v > 0 ? v : 0);
+        }
+        ok &= bloom_memstore_get(store, other, &got) == BLOOM_MEMSTORE_OK &&
+              got.novelty == before.novelty;
+        printf("decay one agent's ids:    %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+        free(own);
+    }
+
+    for (uint32_t g = 0; g < AGENTS; g++) {
+        for (size_t k = 0; k < py[g].n; k++) free(py[g].mems[k]);
+        free(py[g].mems);
+    }
+    free(py);
+    free(factor);
+    free(e);
+    free(ids);
+    bloom_memstore_destroy(store);
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
@@ -0,0 +1,148 @@
+/*
+ * BloomCoin Agent Memory Store
+ * ============================
+ *
+ * Column store for the Memory objects of every agent in the garden
+ * (garden/agents/knowledge.py). KnowledgeBase.apply_decay() and
+ * consolidate() walk Python objects one at a time for every agent on
+ * every tick; here a tick is one pass over contiguous columns for all
+ * agents together, and a Memory becomes a view holding its id
+ * (MemoryView in garden/agents/native_memory.py).
+ *
+ * Same rules as the Python methods:
+ *   decay:      novelty = max(0, novelty - (now - timestamp) * factor)
+ *   strengthen: access_count += 1, coherence = min(1, coherence + 0.01)
+ *
+ * Features:
+ * - Columns: agent, type, timestamp, coherence, novelty, access count;
+ *   stable ids map to rows, so views survive compaction
+ * - Decay and threshold tests four memories at a time in AVX2 double
+ *   lanes (per-agent factors gathered by agent column), scalar fallback
+ * - Consolidation summary per agent in the same pass: memory count,
+ *   recent memories, faded memories and the five most accessed
+ * - Per-list decay and summary over one agent's ids, at the cost of
+ *   that agent's memories (KnowledgeBase.apply_decay() / consolidate())
+ * - Forgetting: faded memories removed by one order-preserving compaction
+ *
+ * Arithmetic follows the Python evaluation order without fused
+ * multiply-add, so views read the values the Python objects would hold.
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef BLOOM_MEMSTORE_H
+#define BLOOM_MEMSTORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLOOM_MEMSTORE_NONE 0xFFFFFFFFu
+#define BLOOM_MEMSTORE_TOP  5       /* most accessed memories per summary */
+
+/* Flags column bits, set by bloom_memstore_consolidate() */
+#define BLOOM_MEMSTORE_RECENT 0x01
+#define BLOOM_MEMSTORE_FADED  0x02
+
+/* Status codes */
+#define BLOOM_MEMSTORE_OK            0
+#define BLOOM_MEMSTORE_ERR_NOMEM    -1
+#define BLOOM_MEMSTORE_ERR_INVALID  -2   /* unknown id or agent */
+
+typedef struct {
+    uint32_t agent;
+    uint8_t type;                   /* memory_type: fact, skill, ... as a code */
+    double timestamp;
+    double coherence;
+    double novelty;
+    uint32_t access_count;
+} bloom_memstore_entry;
+
+/* Zero-copy column view; valid until the next add or forget */
+typedef struct {
+    size_t n;
+    const uint32_t *id;
+    const uint32_t *agent;
+    const uint8_t *type;
+    const uint8_t *flags;
+    const double *timestamp;
+    const double *coherence;
+    const double *novelty;
+    const uint32_t *access_count;
+} bloom_memstore_columns;
+
+typedef struct {
+    double now;
+    double recent_window;           /* recent: now - timestamp < window (3600) */
+    double fade_novelty;            /* faded: novelty <= fade_novelty ... */
+    uint32_t keep_access;           /* ... and access_count < keep_access */
+} bloom_memstore_policy;
+
+typedef struct {
+    uint32_t memories;
+    uint32_t recent;
+    uint32_t faded;
+    uint32_t n_top;
+    uint32_t top[BLOOM_MEMSTORE_TOP];   /* ids, most accessed first (ties: oldest) */
+} bloom_memstore_summary;
+
+typedef struct bloom_memstore bloom_memstore;
+
+bloom_memstore *bloom_memstore_create(uint32_t n_agents);
+void bloom_memstore_destroy(bloom_memstore *store);
+
+/* Append n memories; ids (may be NULL) receives their ids */
+int bloom_memstore_add(bloom_memstore *store, const bloom_memstore_entry *entries, size_t n,
+                       uint32_t *ids);
+
+size_t bloom_memstore_count(const bloom_memstore *store);
+
+/* Current row of an id in the columns, or BLOOM_MEMSTORE_NONE */
+uint32_t bloom_memstore_row(const bloom_memstore *store, uint32_t id);
+
+int bloom_memstore_get(const bloom_memstore *store, uint32_t id, bloom_memstore_entry *out);
+int bloom_memstore_set(bloom_memstore *store, uint32_t id, const bloom_memstore_entry *e);
+
+void bloom_memstore_columns_get(const bloom_memstore *store, bloom_memstore_columns *cols);
+
+/* Memory.strengthen() for n ids; returns the number found */
+size_t bloom_memstore_strengthen(bloom_memstore *store, const uint32_t *ids, size_t n);
+
+/*
+ * Memory.decay() for every memory of every agent. agent_factor[agent]
+ * overrides factor when not NULL.
+ */
+void bloom_memstore_decay(bloom_memstore *store, double now, double factor,
+                          const double *agent_factor);
+
+/* Memory.decay() for the n memories in ids[] only; unknown ids are skipped */
+void bloom_memstore_decay_ids(bloom_memstore *store, double now, double factor,
+                              const uint32_t *ids, size_t n);
+
+/*
+ * Set the flags column under the policy and fill one summary per agent
+ * (n_agents entries).
+ */
+void bloom_memstore_consolidate(bloom_memstore *store, const bloom_memstore_policy *policy,
+                                bloom_memstore_summary *summaries);
+
+/*
+ * One summary over the n memories in ids[], oldest first (one agent's
+ * KnowledgeBase). Costs O(n), not a pass over every agent; sets the
+ * flags of those rows only.
+ */
+void bloom_memstore_summarize(bloom_memstore *store, const bloom_memstore_policy *policy,
+                              const uint32_t *ids, size_t n, bloom_memstore_summary *summary);
+
+/* Remove faded memories; returns the number removed */
+size_t bloom_memstore_forget(bloom_memstore *store, const bloom_memstore_policy *policy);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOOM_MEMSTORE_H */
@@ -0,0 +1,828 @@
+/*
+ * BloomCoin Memory Recall Index
+ * =============================
+ *
+ * Compile: gcc -O3 -c nexthash256.c
+ *          gcc -O3 -mavx2 -fopenmp -o bloom_recall bloom_recall.c nexthash256.o -DTEST_MAIN -lm
+ */
+
+#include "bloom_recall.h"
+#include "nexthash256.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/* Tokens hashed per nexthash256_batch() call */
+#define HASH_CHUNK 256
+
+typedef struct {
+    uint32_t first, last;           /* ids in the block */
+    uint32_t offset;                /* into posting bytes */
+    uint32_t count;
+} block_ref;
+
+typedef struct {
+    uint64_t key;
+    uint32_t df;
+    uint32_t n_blocks, blocks_cap;
+    block_ref *blocks;
+    uint8_t *bytes;                 /* deltas - 1, varint */
+    uint32_t n_bytes, bytes_cap;
+    uint32_t *tail;                 /* open block, uncompressed */
+    uint32_t n_tail, tail_cap;
+} posting;
+
+struct bloom_recall_index {
+    /* Memories */
+    uint8_t *type, *alive;
+    float *strength;
+    double *timestamp;
+    double *tmax;                   /* running max of timestamps */
+    size_t n, cap, live;
+
+    /* Terms: open addressing key -> term index + 1 */
+    posting *terms;
+    size_t n_terms, terms_cap;
+    uint64_t *tkey;
+    uint32_t *tslot;
+    size_t tcap;
+
+    posting types[BLOOM_RECALL_MAX_TYPES];
+
+    /* Query scratch */
+    uint32_t *cand;
+    size_t cand_cap;
+};
+
+/* ========================================================================== */
+/* Helpers                                                                     */
+/* ========================================================================== */
+
+static uint64_t load64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static int is_token(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+/*
+ * Lowercase text into low and record token spans; returns the token count.
+ * tok / tok_len hold at least len / 2 + 1 entries.
+ */
+static size_t tokenize(const char *text, size_t len, char *low,
+                       const uint8_t **tok, size_t *tok_len) {
+    size_t n = 0;
+    for (size_t j = 0; j < len; j++) {
+        unsigned char c = (unsigned char)text[j];
+        low[j] = (char)(c >= 'A' && c <= 'Z' ? c + 32 : c);
+    }
+    for (size_t j = 0; j < len;) {
+        while (j < len && !is_token((unsigned char)low[j])) j++;
+        size_t start = j;
+        while (j < len && is_token((unsigned char)low[j])) j++;
+        if (j > start) {
+            tok[n] = (const uint8_t *)low + start;
+            tok_len[n++] = j - start;
+        }
+    }
+    return n;
+}
+
+static int cmp_u64(const void *x, const void *y) {
+    uint64_t a = *(const uint64_t *)x, b = *(const uint64_t *)y;
+    return (a > b) - (a < b);
+}
+
+static size_t unique_u64(uint64_t *v, size_t n) {
+    if (n < 2) return n;
+    qsort(v, n, sizeof(uint64_t), cmp_u64);
+    size_t m = 1;
+    for (size_t i = 1; i < n; i++) {
+        if (v[i] != v[m - 1]) v[m++] = v[i];
+    }
+    return m;
+}
+
+static int grow(void **p, uint32_t *cap, size_t need, size_t elem, uint32_t initial) {
+    if (need <= *cap) return 0;
+    size_t c = *cap ? *cap : initial;
+    while (c < need) c *= 2;
+    void *q = realloc(*p, c * elem);
+    if (!q) return -1;
+    *p = q;
+    *cap = (uint32_t)c;
+    return 0;
+}
+
+/* ========================================================================== */
+/* Posting Lists                                                               */
+/* ========================================================================== */
+
+static int posting_seal(posting *p) {
+    if (grow((void **)&p->blocks, &p->blocks_cap, p->n_blocks + 1, sizeof(block_ref), 4) ||
+        grow((void **)&p->bytes, &p->bytes_cap, p->n_bytes + 5 * (size_t)p->n_tail, 1, 256)) {
+        return BLOOM_RECALL_ERR_NOMEM;
+    }
+    block_ref *b = &p->blocks[p->n_blocks++];
+    b->first = p->tail[0];
+    b->last = p->tail[p->n_tail - 1];
+    b->offset = p->n_bytes;
+    b->count = p->n_tail;
+
+    uint8_t *out = p->bytes + p->n_bytes;
+    for (uint32_t i = 1; i < p->n_tail; i++) {
+        uint32_t d = p->tail[i] - p->tail[i - 1] - 1;
+        while (d >= 0x80) {
+            *out++ = (uint8_t)(d | 0x80);
+            d >>= 7;
+        }
+        *out++ = (uint8_t)d;
+    }
+    p->n_bytes = (uint32_t)(out - p->bytes);
+    p->n_tail = 0;
+    return BLOOM_RECALL_OK;
+}
+
+static int posting_append(posting *p, uint32_t id) {
+    if (p->n_tail == p->tail_cap &&
+        grow((void **)&p->tail, &p->tail_cap, p->n_tail + 1, sizeof(uint32_t), 4)) {
+        return BLOOM_RECALL_ERR_NOMEM;
+    }
+    p->tail[p->n_tail++] = id;
+    p->df++;
+    if (p->n_tail == BLOOM_RECALL_BLOCK) return posting_seal(p);
+    return BLOOM_RECALL_OK;
+}
+
+static uint32_t decode_block(const posting *p, const block_ref *b, uint32_t *out) {
+    const uint8_t *in = p->bytes + b->offset;
+    uint32_t id = b->first;
+    out[0] = id;
+    for (uint32_t i = 1; i < b->count; i++) {
+        uint32_t d = 0;
+        int shift = 0;
+        uint8_t c;
+        do {
+            c = *in++;
+            d |= (uint32_t)(c & 0x7F) << shift;
+            shift += 7;
+        } while (c & 0x80);
+        id += d + 1;
+        out[i] = id;
+    }
+    return b->count;
+}
+
+/* First sealed block whose last id is >= id */
+static uint32_t first_block(const posting *p, uint32_t id) {
+    uint32_t lo = 0, hi = p->n_blocks;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (p->blocks[mid].last < id) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static void posting_free(posting *p) {
+    free(p->blocks);
+    free(p->bytes);
+    free(p->tail);
+}
+
+/* ========================================================================== */
+/* Intersection                                                                */
+/* ========================================================================== */
+
+/*
+ * Intersect sorted a[na] with sorted b[nb] into out. out may alias a: every
+ * id is written at or before the position it was read from, and an id
+ * overwritten in the current block of a is no larger than one already
+ * matched, so it can no longer match.
+ */
+static size_t intersect_sorted(const uint32_t *a, size_t na, const uint32_t *b, size_t nb,
+                               uint32_t *out) {
+    size_t i = 0, j = 0, n = 0;
+#if defined(__AVX2__)
+    const __m256i rot = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    while (i + 8 <= na && j + 8 <= nb) {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + j));
+        __m256i eq = _mm256_cmpeq_epi32(va, vb);
+        for (int r = 1; r < 8; r++) {
+            vb = _mm256_permutevar8x32_epi32(vb, rot);
+            eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(va, vb));
+        }
+        uint32_t mask = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(eq));
+        uint32_t amax = a[i + 7], bmax = b[j + 7];
+        while (mask) {
+            out[n++] = a[i + (uint32_t)__builtin_ctz(mask)];
+            mask &= mask - 1;
+        }
+        if (amax <= bmax) i += 8;
+        if (bmax <= amax) j += 8;
+    }
+#endif
+    while (i < na && j < nb) {
+        if (a[i] < b[j]) i++;
+        else if (a[i] > b[j]) j++;
+        else {
+            out[n++] = a[i];
+            i++;
+            j++;
+        }
+    }
+    return n;
+}
+
+/* Keep the ids of cand[n] that are in p; returns the new count */
+static size_t intersect_posting(const posting *p, uint32_t *cand, size_t n) {
+    uint32_t buf[BLOOM_RECALL_BLOCK];
+    size_t i = 0, kept = 0;
+    if (n == 0) return 0;
+    for (uint32_t b = first_block(p, cand[0]); b <= p->n_blocks && i < n; b++) {
+        const uint32_t *ids;
+        uint32_t cnt;
+        if (b < p->n_blocks) {
+            const block_ref *ref = &p->blocks[b];
+            if (ref->last < cand[i]) continue;
+            while (i < n && cand[i] < ref->first) i++;
+            if (i == n || cand[i] > ref->last) continue;
+            cnt = decode_block(p, ref, buf);
+            ids = buf;
+        } else {
+            if (p->n_tail == 0) break;
+            ids = p->tail;
+            cnt = p->n_tail;
+        }
+        size_t j = i;
+        while (j < n && cand[j] <= ids[cnt - 1]) j++;
+        kept += intersect_sorted(cand + i, j - i, ids, cnt, cand + kept);
+        i = j;
+    }
+    return kept;
+}
+
+/* ========================================================================== */
+/* Index                                                                       */
+/* ========================================================================== */
+
+bloom_recall_index *bloom_recall_create(void) {
+    return (bloom_recall_index *)calloc(1, sizeof(bloom_recall_index));
+}
+
+void bloom_recall_destroy(bloom_recall_index *idx) {
+    if (!idx) return;
+    free(idx->type);
+    free(idx->alive);
+    free(idx->strength);
+    free(idx->timestamp);
+    free(idx->tmax);
+    for (size_t i = 0; i < idx->n_terms; i++) posting_free(&idx->terms[i]);
+    for (int t = 0; t < BLOOM_RECALL_MAX_TYPES; t++) posting_free(&idx->types[t]);
+    free(idx->terms);
+    free(idx->tkey);
+    free(idx->tslot);
+    free(idx->cand);
+    free(idx);
+}
+
+size_t bloom_recall_count(const bloom_recall_index *idx) {
+    return idx->live;
+}
+
+static size_t term_slot(const bloom_recall_index *idx, uint64_t key) {
+    size_t mask = idx->tcap - 1, s = (size_t)key & mask;
+    while (idx->tslot[s] && idx->tkey[s] != key) s = (s + 1) & mask;
+    return s;
+}
+
+static posting *term_find(const bloom_recall_index *idx, uint64_t key) {
+    if (!idx->tcap) return NULL;
+    size_t s = term_slot(idx, key);
+    return idx->tslot[s] ? &idx->terms[idx->tslot[s] - 1] : NULL;
+}
+
+static int term_table_grow(bloom_recall_index *idx) {
+    size_t old_cap = idx->tcap, cap = old_cap ? 2 * old_cap : 4096;
+    uint64_t *old_key = idx->tkey;
+    uint32_t *old_slot = idx->tslot;
+    idx->tkey = (uint64_t *)malloc(cap * sizeof(uint64_t));
+    idx->tslot = (uint32_t *)calloc(cap, sizeof(uint32_t));
+    if (!idx->tkey || !idx->tslot) {
+        free(idx->tkey);
+        free(idx->tslot);
+        idx->tkey = old_key;
+        idx->tslot = old_slot;
+        return -1;
+    }
+    idx->tcap = cap;
+    for (size_t i = 0; i < old_cap; i++) {
+        if (!old_slot[i]) continue;
+        size_t s = term_slot(idx, old_key[i]);
+        idx->tkey[s] = old_key[i];
+        idx->tslot[s] = old_slot[i];
+    }
+    free(old_key);
+    free(old_slot);
+    return 0;
+}
+
+static posting *term_intern(bloom_recall_index *idx, uint64_t key) {
+    if (2 * (idx->n_terms + 1) > idx->tcap && term_table_grow(idx)) return NULL;
+    size_t s = term_slot(idx, key);
+    if (idx->tslot[s]) return &idx->terms[idx->tslot[s] - 1];
+
+    if (idx->n_terms == idx->terms_cap) {
+        size_t cap = idx->terms_cap ? 2 * idx->terms_cap : 1024;
+        posting *t = (posting *)realloc(idx->terms, cap * sizeof(posting));
+        if (!t) return NULL;
+        idx->terms = t;
+        idx->terms_cap = cap;
+    }
+    posting *p = &idx->terms[idx->n_terms++];
+    memset(p, 0, sizeof(*p));
+    p->key = key;
+    idx->tkey[s] = key;
+    idx->tslot[s] = (uint32_t)idx->n_terms;
+    return p;
+}
+
+static int reserve_memories(bloom_recall_index *idx, size_t need) {
+    if (need <= idx->cap) return 0;
+    size_t cap = idx->cap ? idx->cap : 1024;
+    while (cap < need) cap *= 2;
+    uint8_t *type = (uint8_t *)realloc(idx->type, cap);
+    if (type) idx->type = type;
+    uint8_t *alive = (uint8_t *)realloc(idx->alive, cap);
+    if (alive) idx->alive = alive;
+    float *strength = (float *)realloc(idx->strength, cap * sizeof(float));
+    if (strength) idx->strength = strength;
+    double *ts = (double *)realloc(idx->timestamp, cap * sizeof(double));
+    if (ts) idx->timestamp = ts;
+    double *tmax = (double *)realloc(idx->tmax, cap * sizeof(double));
+    if (tmax) idx->tmax = tmax;
+    if (!type || !alive || !strength || !ts || !tmax) return -1;
+    idx->cap = cap;
+    return 0;
+}
+
+long bloom_recall_add(bloom_recall_index *idx, const bloom_recall_memory *mems, size_t n) {
+    size_t first_id = idx->n, total_len = 0, total_tok = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (mems[i].type >= BLOOM_RECALL_MAX_TYPES) return BLOOM_RECALL_ERR_INVALID;
+        total_len += mems[i].len;
+    }
+    if (first_id + n >= UINT32_MAX || reserve_memories(idx, first_id + n)) {
+        return BLOOM_RECALL_ERR_NOMEM;
+    }
+
+    char *low = (char *)malloc(total_len ? total_len : 1);
+    size_t *first = (size_t *)malloc((n + 1) * sizeof(size_t));
+    size_t tok_cap = total_len / 2 + 1;
+    const uint8_t **tok = (const uint8_t **)malloc(tok_cap * sizeof(*tok));
+    size_t *tok_len = (size_t *)malloc(tok_cap * sizeof(size_t));
+    uint64_t *hashes = (uint64_t *)malloc(tok_cap * sizeof(uint64_t));
+    long st = BLOOM_RECALL_ERR_NOMEM;
+    if (!low || !first || !tok || !tok_len || !hashes) goto done;
+
+    char *p = low;
+    for (size_t i = 0; i < n; i++) {
+        first[i] = total_tok;
+        total_tok += tokenize(mems[i].text, mems[i].len, p, tok + total_tok, tok_len + total_tok);
+        p += mems[i].len;
+    }
+    first[n] = total_tok;
+
+    long n_chunks = (long)((total_tok + HASH_CHUNK - 1) / HASH_CHUNK);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (long c = 0; c < n_chunks; c++) {
+        uint8_t digests[HASH_CHUNK][32];
+        size_t from = (size_t)c * HASH_CHUNK;
+        size_t cnt = total_tok - from < HASH_CHUNK ? total_tok - from : HASH_CHUNK;
+        nexthash256_batch(tok + from, tok_len + from, cnt, digests);
+        for (size_t t = 0; t < cnt; t++) hashes[from + t] = load64(digests[t]);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        uint32_t id = (uint32_t)idx->n;
+        const bloom_recall_memory *m = &mems[i];
+        idx->type[id] = m->type;
+        idx->alive[id] = 1;
+        idx->strength[id] = m->strength;
+        idx->timestamp[id] = m->timestamp;
+        idx->tmax[id] = id && idx->tmax[id - 1] > m->timestamp ? idx->tmax[id - 1] : m->timestamp;
+        idx->n++;
+        idx->live++;
+
+        size_t cnt = unique_u64(hashes + first[i], first[i + 1] - first[i]);
+        for (size_t t = 0; t < cnt; t++) {
+            posting *term = term_intern(idx, hashes[first[i] + t]);
+            if (!term || posting_append(term, id)) goto done;
+        }
+        if (posting_append(&idx->types[m->type], id)) goto done;
+    }
+    st = (long)first_id;
+
+done:
+    free(low);
+    free(first);
+    free(tok);
+    free(tok_len);
+    free(hashes);
+    return st;
+}
+
+int bloom_recall_remove(bloom_recall_index *idx, uint32_t id) {
+    if (id >= idx->n || !idx->alive[id]) return BLOOM_RECALL_ERR_INVALID;
+    idx->alive[id] = 0;
+    idx->live--;
+    return BLOOM_RECALL_OK;
+}
+
+int bloom_recall_touch(bloom_recall_index *idx, uint32_t id, float strength) {
+    if (id >= idx->n || !idx->alive[id]) return BLOOM_RECALL_ERR_INVALID;
+    idx->strength[id] = strength;
+    return BLOOM_RECALL_OK;
+}
+
+/* ========================================================================== */
+/* Queries                                                                     */
+/* ========================================================================== */
+
+/* First memory id that can have timestamp >= t_min */
+static uint32_t first_at(const bloom_recall_index *idx, double t_min) {
+    size_t lo = 0, hi = idx->n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (idx->tmax[mid] < t_min) lo = mid + 1;
+        else hi = mid;
+    }
+    return (uint32_t)lo;
+}
+
+static int reserve_cand(bloom_recall_index *idx, size_t need) {
+    if (need <= idx->cand_cap) return 0;
+    size_t cap = idx->cand_cap ? idx->cand_cap : 1024;
+    while (cap < need) cap *= 2;
+    uint32_t *c = (uint32_t *)realloc(idx->cand, cap * sizeof(uint32_t));
+    if (!c) return -1;
+    idx->cand = c;
+    idx->cand_cap = cap;
+    return 0;
+}
+
+static int cmp_df(const void *x, const void *y) {
+    const posting *a = *(const posting *const *)x, *b = *(const posting *const *)y;
+    return (a->df > b->df) - (a->df < b->df);
+}
+
+/*
+ * Candidate ids >= lo holding every query term (and the single type of
+ * type_mask, if it has one bit) into idx->cand. Returns the count, or
+ * SIZE_MAX when there is no posting constraint.
+ */
+static size_t collect(bloom_recall_index *idx, const char *query, size_t len,
+                      uint32_t type_mask, uint32_t lo) {
+    posting *lists[BLOOM_RECALL_MAX_TERMS + 1];
+    size_t n_lists = 0;
+
+    if (query && len) {
+        char *low = (char *)malloc(len);
+        size_t cap = len / 2 + 1;
+        const uint8_t **tok = (const uint8_t **)malloc(cap * sizeof(*tok));
+        size_t *tok_len = (size_t *)malloc(cap * sizeof(size_t));
+        size_t n_tok = 0;
+        int missing = 0;
+        uint8_t digests[BLOOM_RECALL_MAX_TERMS][32];
+        uint64_t keys[BLOOM_RECALL_MAX_TERMS];
+        if (low && tok && tok_len) {
+            n_tok = tokenize(query, len, low, tok, tok_len);
+            if (n_tok > BLOOM_RECALL_MAX_TERMS) n_tok = BLOOM_RECALL_MAX_TERMS;
+            nexthash256_batch(tok, tok_len, n_tok, digests);
+        }
+        for (size_t t = 0; t < n_tok; t++) keys[t] = load64(digests[t]);
+        n_tok = unique_u64(keys, n_tok);
+        for (size_t t = 0; t < n_tok; t++) {
+            posting *p = term_find(idx, keys[t]);
+            if (!p) missing = 1;
+            else lists[n_lists++] = p;
+        }
+        free(low);
+        free(tok);
+        free(tok_len);
+        if (missing) return 0;
+    }
+    if (type_mask && (type_mask & (type_mask - 1)) == 0) {
+        lists[n_lists++] = &idx->types[__builtin_ctz(type_mask)];
+    }
+    if (n_lists == 0) return SIZE_MAX;
+
+    /* Rarest list drives, the others filter it */
+    qsort(lists, n_lists, sizeof(posting *), cmp_df);
+    const posting *d = lists[0];
+    if (reserve_cand(idx, d->df)) return 0;
+    size_t n = 0;
+    for (uint32_t b = first_block(d, lo); b < d->n_blocks; b++) {
+        n += decode_block(d, &d->blocks[b], idx->cand + n);
+    }
+    for (uint32_t t = 0; t < d->n_tail; t++) idx->cand[n++] = d->tail[t];
+    size_t skip = 0;
+    while (skip < n && idx->cand[skip] < lo) skip++;
+    if (skip) memmove(idx->cand, idx->cand + skip, (n - skip) * sizeof(uint32_t));
+    n -= skip;
+
+    for (size_t l = 1; l < n_lists && n; l++) n = intersect_posting(lists[l], idx->cand, n);
+    return n;
+}
+
+static float recall_score(const bloom_recall_index *idx, uint32_t id,
+                          const bloom_recall_filter *f) {
+    float s = idx->strength[id];
+    if (f && f->half_life > 0) s *= (float)exp2(-(f->now - idx->timestamp[id]) / f->half_life);
+    return s;
+}
+
+/* a ranks above b: higher score, then the newer memory */
+static int hit_above(bloom_recall_hit a, bloom_recall_hit b) {
+    return a.score > b.score || (a.score == b.score && a.id > b.id);
+}
+
+/* Min-heap of the k best hits, worst at the root */
+static void heap_offer(bloom_recall_hit *h, size_t *n, size_t k, bloom_recall_hit x) {
+    size_t i;
+    if (*n < k) {
+        i = (*n)++;
+        while (i && hit_above(h[(i - 1) / 2], x)) {
+            h[i] = h[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        h[i] = x;
+        return;
+    }
+    if (!hit_above(x, h[0])) return;
+    i = 0;
+    for (;;) {
+        size_t c = 2 * i + 1;
+        if (c >= *n) break;
+        if (c + 1 < *n && hit_above(h[c], h[c + 1])) c++;
+        if (!hit_above(x, h[c])) break;
+        h[i] = h[c];
+        i = c;
+    }
+    h[i] = x;
+}
+
+static int cmp_hit(const void *x, const void *y) {
+    bloom_recall_hit a = *(const bloom_recall_hit *)x, b = *(const bloom_recall_hit *)y;
+    return hit_above(a, b) ? -1 : hit_above(b, a);
+}
+
+size_t bloom_recall_query(bloom_recall_index *idx, const char *query, size_t len,
+                          const bloom_recall_filter *filter, bloom_recall_hit *out, size_t k) {
+    uint32_t mask = filter ? filter->type_mask : 0;
+    double t_min = filter ? filter->t_min : -INFINITY;
+    double t_max = filter && filter->t_max > filter->t_min ? filter->t_max : INFINITY;
+    uint32_t lo = first_at(idx, t_min);
+    if (k == 0) return 0;
+
+    size_t n = collect(idx, query, len, mask, lo), found = 0;
+    int all = n == SIZE_MAX;
+    if (all) n = idx->n - lo;
+    for (size_t c = 0; c < n; c++) {
+        uint32_t id = all ? lo + (uint32_t)c : idx->cand[c];
+        if (!idx->alive[id]) continue;
+        if (mask && !(mask >> idx->type[id] & 1)) continue;
+        double ts = idx->timestamp[id];
+        if (ts < t_min || ts > t_max) continue;
+        bloom_recall_hit h = { id, recall_score(idx, id, filter) };
+        heap_offer(out, &found, k, h);
+    }
+    qsort(out, found, sizeof(bloom_recall_hit), cmp_hit);
+    return found;
+}
+
+size_t bloom_recall_topic_count(bloom_recall_index *idx, const char *topic, size_t len,
+                                double t_min) {
+    uint32_t lo = first_at(idx, t_min);
+    size_t n = collect(idx, topic, len, 0, lo), count = 0;
+    if (n == SIZE_MAX) return 0;
+    for (size_t c = 0; c < n; c++) {
+        uint32_t id = idx->cand[c];
+        count += idx->alive[id] && idx->timestamp[id] >= t_min;
+    }
+    return count;
+}
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <stdio.h>
+#include <time.h>
+
+static uint64_t test_rng = 0x2545F4914F6CDD1Dull;
+
+static uint64_t xorshift(void) {
+    test_rng ^= test_rng << 13;
+    test_rng ^= test_rng >> 7;
+    test_rng ^= test_rng << 17;
+    return test_rng;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+enum { N = 200000, WORDS = 20, VOCAB = 20000 };
+static uint16_t words[N][WORDS];
+
+/* Skewed vocabulary: low word ids are common */
+static uint16_t pick_word(void) {
+    uint64_t r = xorshift() % VOCAB;
+    return (uint16_t)(r * r / VOCAB);
+}
+
+static size_t make_text(char *buf, const uint16_t *w) {
+    size_t len = (size_t)sprintf(buf, "{\"note\": \"");
+    for (int i = 0; i < WORDS; i++) len += (size_t)sprintf(buf + len, "%sW%u", i ? " " : "", w[i]);
+    return len + (size_t)sprintf(buf + len, "\"}");
+}
+
+static int has_word(const uint16_t *w, uint16_t x) {
+    for (int i = 0; i < WORDS; i++) if (w[i] == x) return 1;
+    return 0;
+}
+
+int main(void) {
+    int fail = 0, ok;
+    printf("BloomCoin Memory Recall Index\n");
+    printf("=============================\n\n");
+
+    /* Small knowledge base */
+    {
+        const char *texts[] = {
+            "{\"lesson\": \"Fire crystals hum at dawn\"}",
+            "{\"skill\": \"grow fire ferns\"}",
+            "{\"lesson\": \"water crystals are CALM\"}",
+            "{\"insight\": \"crystals, fire and water\"}",
+        };
+        bloom_recall_memory m[4];
+        for (int i = 0; i < 4; i++) {
+            bloom_recall_memory x = { texts[i], strlen(texts[i]), (uint8_t)(i == 1), 100.0 * i, 1.0f };
+            m[i] = x;
+        }
+        bloom_recall_index *idx = bloom_recall_create();
+        ok = bloom_recall_add(idx, m, 4) == 0;
+        bloom_recall_hit h[4];
+        size_t got = bloom_recall_query(idx, "FIRE crystals", 13, NULL, h, 4);
+        ok &= got == 2 && h[0].id == 3 && h[1].id == 0;
+        bloom_recall_filter f = { 1u << 1, 0, 0, 0, 0 };
+        got = bloom_recall_query(idx, "fire", 4, &f, h, 4);
+        ok &= got == 1 && h[0].id == 1;
+        bloom_recall_filter recent = { 0, 150, 0, 300, 100 };
+        got = bloom_recall_query(idx, "crystals", 8, &recent, h, 4);
+        ok &= got == 2 && h[0].id == 3 && fabsf(h[1].score - 0.5f) < 1e-6f;
+        ok &= bloom_recall_touch(idx, 0, 5.0f) == BLOOM_RECALL_OK;
+        got = bloom_recall_query(idx, "crystals", 8, NULL, h, 2);
+        ok &= got == 2 && h[0].id == 0 && h[1].id == 3;
+        ok &= bloom_recall_query(idx, "fire ice", 8, NULL, h, 4) == 0;
+        ok &= bloom_recall_topic_count(idx, "crystals", 8, 50) == 2;
+        ok &= bloom_recall_remove(idx, 3) == BLOOM_RECALL_OK &&
+              bloom_recall_remove(idx, 3) == BLOOM_RECALL_ERR_INVALID;
+        got = bloom_recall_query(idx, NULL, 0, NULL, h, 4);
+        ok &= got == 3 && bloom_recall_count(idx) == 3;
+        printf("queries and filters:      %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+        bloom_recall_destroy(idx);
+    }
+
+    /* Intersection kernel against a plain merge */
+    {
+        static uint32_t a[1000], b[1000], x[1000];
+        ok = 1;
+        for (int round = 0; round < 200; round++) {
+            uint32_t va = 0, vb = 0;
+            size_t na = 1 + xorshift() % 1000, nb = 1 + xorshift() % 1000;
+            for (size_t i = 0; i < na; i++) a[i] = va += 1 + (uint32_t)(xorshift() % 4);
+            for (size_t i = 0; i < nb; i++) b[i] = vb += 1 + (uint32_t)(xorshift() % (round % 7 + 1));
+            size_t want = 0, i = 0, j = 0;
+            while (i < na && j < nb) {
+                if (a[i] < b[j]) i++;
+                else if (a[i] > b[j]) j++;
+                else { x[want++] = a[i]; i++; j++; }
+            }
+            size_t got = intersect_sorted(a, na, b, nb, a);
+            ok &= got == want && memcmp(a, x, want * sizeof(uint32_t)) == 0;
+        }
+        printf("SIMD intersection:        %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* 2 * 10^5 memories, one per second; checked against a linear scan */
+    bloom_recall_index *idx = bloom_recall_create();
+    bloom_recall_memory *mems = malloc(N * sizeof(bloom_recall_memory));
+    char *texts = malloc((size_t)N * 160);
+    for (int i = 0; i < N; i++) {
+        for (int w = 0; w < WORDS; w++) words[i][w] = pick_word();
+        char *t = texts + (size_t)i * 160;
+        bloom_recall_memory m = { t, make_text(t, words[i]), (uint8_t)(i % 4), 1000.0 + i,
+                                  (float)(xorshift() % 1000) / 1000.0f };
+        mems[i] = m;
+    }
+    double lat_small = 0, lat_full = 0;
+    const int Q = 2000;
+    for (int half = 0; half < 2; half++) {
+        size_t from = half ? N / 8 : 0, to = half ? N : N / 8;
+        double t0 = now_sec();
+        bloom_recall_add(idx, mems + from, to - from);
+        double t1 = now_sec();
+        if (half) {
+            printf("index build:              %d memories, %.0f ms for the last %zu\n",
+                   N, 1e3 * (t1 - t0), to - from);
+        }
+
+        /* Latency: two common terms in the last hour */
+        bloom_recall_hit h[10];
+        char q[64];
+        bloom_recall_filter f = { 0, 1000.0 + to - 3600, 0, 1000.0 + to, 3600 };
+        t0 = now_sec();
+        for (int r = 0; r < Q; r++) {
+            int len = sprintf(q, "w%u w%u", (unsigned)(r % 40), (unsigned)(r % 40 + 40));
+            bloom_recall_query(idx, q, (size_t)len, &f, h, 10);
+        }
+        *(half ? &lat_full : &lat_small) = 1e6 * (now_sec() - t0) / Q;
+    }
+    printf("last-hour query latency:  %.2f us at %d, %.2f us at %d memories\n",
+           lat_small, N / 8, lat_full, N);
+
+    {
+        ok = 1;
+        double scan = 0, indexed = 0;
+        for (int r = 0; r < 100 && ok; r++) {
+            const uint16_t *src = words[xorshift() % N];
+            uint16_t terms[3];
+            int nt = 1 + (int)(xorshift() % 3);
+            char q[64];
+            int len = 0;
+            for (int t = 0; t < nt; t++) {
+                terms[t] = src[xorshift() % WORDS];
+                len += sprintf(q + len, "W%u ", terms[t]);
+            }
+            bloom_recall_filter f = { 0, 1000.0 + (double)(xorshift() % N), 0, 1000.0 + N, 600 };
+            if (r % 3 == 1) f.type_mask = 1u << (r % 4);
+            if (r % 3 == 2) f.type_mask = 5, f.t_max = f.t_min + 20000;
+
+            bloom_recall_hit want[10], got[10];
+            size_t n_want = 0;
+            double t0 = now_sec();
+            for (uint32_t id = 0; id < N; id++) {
+                if (f.type_mask && !(f.type_mask >> (id % 4) & 1)) continue;
+                double ts = 1000.0 + id;
+                if (ts < f.t_min || (f.t_max > f.t_min && ts > f.t_max)) continue;
+                int all = 1;
+                for (int t = 0; t < nt; t++) all &= has_word(words[id], terms[t]);
+                if (!all) continue;
+                bloom_recall_hit x = { id, recall_score(idx, id, &f) };
+                heap_offer(want, &n_want, 10, x);
+            }
+            qsort(want, n_want, sizeof(bloom_recall_hit), cmp_hit);
+            double t1 = now_sec();
+            size_t n_got = bloom_recall_query(idx, q, (size_t)len, &f, got, 10);
+            double t2 = now_sec();
+            scan += t1 - t0;
+            indexed += t2 - t1;
+            ok &= n_got == n_want && memcmp(got, want, n_got * sizeof(bloom_recall_hit)) == 0;
+        }
+        printf("matches linear scan:      %.1f us vs %.1f us per query  %s\n",
+               1e6 * indexed / 100, 1e6 * scan / 100, ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    {
+        size_t want = 0;
+        for (uint32_t id = N - 3600; id < N; id++) want += has_word(words[id], 7);
+        ok = bloom_recall_topic_count(idx, "w7", 2, 1000.0 + N - 3600) == want;
+        printf("topic count:              %zu in the last hour  %s\n", want, ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    free(mems);
+    free(texts);
+    bloom_recall_destroy(idx);
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
@@ -0,0 +1,110 @@
+/*
+ * BloomCoin Memory Recall Index
+ * =============================
+ *
+ * Inverted index for agent memories (garden/agents/knowledge.py): replaces
+ * the linear scan of KnowledgeBase.retrieve_memories() and the per-topic
+ * Python lists of _index_topics(). A query touches only the posting lists
+ * of its terms, and a time window skips whole posting blocks, so recall
+ * latency follows the size of the answer rather than of the memory.
+ *
+ * Features:
+ * - Tokens: ASCII-lowercased runs of letters, digits and non-ASCII bytes
+ *   (JSON quotes and punctuation separate tokens)
+ * - Terms interned by the first 8 bytes of NEXTHASH-256(token); the tokens
+ *   of a batch of memories are hashed through nexthash256_batch()
+ * - Posting lists: sorted memory ids in blocks of 128, delta + varint
+ *   coded, with a block skip table (first / last id)
+ * - Multi-term AND queries by block-skipping intersection, eight ids
+ *   against eight with AVX2 when available
+ * - Filters: memory type mask, time window; a single-type mask also uses
+ *   that type's posting list
+ * - Top-k by strength * 2^(-age / half_life)
+ *
+ * Memories are expected in roughly increasing timestamp order (as the
+ * Python code creates them); out-of-order timestamps are still filtered
+ * exactly but make time windows skip fewer blocks.
+ *
+ * Not yet called from KnowledgeBase. retrieve_memories() matches the
+ * query as a substring of the JSON content, ranks by access_count *
+ * coherence and strengthens every hit. This index matches whole tokens
+ * and ranks by decayed strength. Switching the Python side over changes
+ * which memories a query returns, so the binding waits for that rule to
+ * be settled there.
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef BLOOM_RECALL_H
+#define BLOOM_RECALL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLOOM_RECALL_BLOCK     128  /* ids per posting block */
+#define BLOOM_RECALL_MAX_TYPES 32
+#define BLOOM_RECALL_MAX_TERMS 16   /* query terms used */
+
+/* Status codes */
+#define BLOOM_RECALL_OK            0
+#define BLOOM_RECALL_ERR_NOMEM    -1
+#define BLOOM_RECALL_ERR_INVALID  -2   /* bad type or unknown memory */
+
+typedef struct {
+    const char *text;               /* json.dumps(content) */
+    size_t len;
+    uint8_t type;                   /* memory_type as 0..BLOOM_RECALL_MAX_TYPES-1 */
+    double timestamp;
+    float strength;                 /* e.g. access_count * coherence */
+} bloom_recall_memory;
+
+typedef struct {
+    uint32_t type_mask;             /* bit per type; 0 = any */
+    double t_min, t_max;            /* t_max <= t_min = no upper bound */
+    double now;                     /* reference time for recency */
+    double half_life;               /* seconds; 0 = rank by strength only */
+} bloom_recall_filter;
+
+typedef struct {
+    uint32_t id;
+    float score;
+} bloom_recall_hit;
+
+typedef struct bloom_recall_index bloom_recall_index;
+
+bloom_recall_index *bloom_recall_create(void);
+void bloom_recall_destroy(bloom_recall_index *idx);
+
+/* Append n memories; returns the id of the first or a negative status code */
+long bloom_recall_add(bloom_recall_index *idx, const bloom_recall_memory *mems, size_t n);
+
+int bloom_recall_remove(bloom_recall_index *idx, uint32_t id);
+
+/* Update a memory's ranking strength (after strengthen()) */
+int bloom_recall_touch(bloom_recall_index *idx, uint32_t id, float strength);
+
+/* Live memories */
+size_t bloom_recall_count(const bloom_recall_index *idx);
+
+/*
+ * Top-k memories containing every token of query (NULL or empty = no term
+ * constraint) and passing filter (NULL = none), best first. Returns the
+ * number written to out.
+ */
+size_t bloom_recall_query(bloom_recall_index *idx, const char *query, size_t len,
+                          const bloom_recall_filter *filter, bloom_recall_hit *out, size_t k);
+
+/* Live memories containing topic with timestamp >= t_min */
+size_t bloom_recall_topic_count(bloom_recall_index *idx, const char *topic, size_t len,
+                                double t_min);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOOM_RECALL_H */
@@ -0,0 +1,534 @@
+/*
+ * BloomCoin Batch Receipt Generator
+ * =================================
+ *
+ * Compile: gcc -O3 -mavx2 -fopenmp -o bloom_receipt bloom_receipt.c -DTEST_MAIN -lm
+ */
+
+#include "bloom_receipt.h"
+#include <math.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/* Bit-identical to Python floats: no contraction of a * b + c into FMA */
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#define SPAN (2 * BLOOM_RECEIPT_RANGE + 1)
+#define N_CORRIDORS BLOOM_RECEIPT_CORRIDORS
+
+/* Blocks per staging chunk (and OpenMP work item) */
+#define CHUNK 256
+
+/* ========================================================================== */
+/* Schema Tables                                                               */
+/* ========================================================================== */
+
+/* constants.py */
+static const int CORRIDOR_VECTORS[N_CORRIDORS][5] = {
+    { 1, 0, 0, 0, 1 },      /* Awakening */
+    { 0, 0, -1, 0, 0 },     /* Emergence */
+    { 0, 1, 0, 1, 0 },      /* Transformation */
+    { 2, 0, 1, 0, 0 },      /* Transcendence */
+    { 0, 0, 0, -1, -1 },    /* Softening */
+    { 0, -1, 0, 1, 0 },     /* Integration */
+    { -1, -1, 0, 0, 0 },    /* Deepening */
+};
+
+enum {
+    INNOCENT, ORPHAN, WARRIOR, CAREGIVER, SEEKER, DESTROYER,
+    LOVER, CREATOR, RULER, MAGICIAN, SAGE, JESTER
+};
+
+static double PHI, TAU, Z_C, THRESHOLD;
+
+/* Indexed by coordinate + 20 */
+static double lum[SPAN];                /* a -> L */
+static double lum_balance[SPAN];        /* a -> max(0, 1 - |L - 0.5| * 2) */
+static double sat[SPAN];                /* c -> S */
+static double hue[SPAN];                /* b -> H */
+static double hue_activity[SPAN];       /* b -> |sin(H)| */
+static double hue_align[SPAN][N_CORRIDORS];
+static double cym[SPAN][3];             /* d -> CYM weights */
+static uint8_t cym8[SPAN][3];
+static double mix[SPAN];                /* d -> sigma_MIX before normalization */
+static double gray[SPAN][SPAN];         /* [a][c] distance from neutral gray */
+static double fix[SPAN][SPAN];          /* [a][c] sigma_FIX before normalization */
+static uint8_t rgb[SPAN][SPAN][SPAN][3];/* [b][a][c] */
+static double corridor_mag[N_CORRIDORS];
+
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+/* Python float % (result takes the sign of the divisor) */
+static double py_mod(double x, double m) {
+    double r = fmod(x, m);
+    if (r != 0.0) {
+        if ((m < 0) != (r < 0)) r += m;
+    } else {
+        r = copysign(0.0, m);
+    }
+    return r;
+}
+
+static double clamp(double x, double lo, double hi) {
+    return x < lo ? lo : (x > hi ? hi : x);
+}
+
+/* colorsys._v */
+static double hls_v(double m1, double m2, double h) {
+    h = py_mod(h, 1.0);
+    if (h < 1.0 / 6.0) return m1 + (m2 - m1) * h * 6.0;
+    if (h < 0.5) return m2;
+    if (h < 2.0 / 3.0) return m1 + (m2 - m1) * (2.0 / 3.0 - h) * 6.0;
+    return m1;
+}
+
+/* ColorState.to_rgb() */
+static void to_rgb(double h, double s, double l, uint8_t out[3]) {
+    double hn = py_mod(h, 360) / 360, c[3];
+    if (s == 0.0) {
+        c[0] = c[1] = c[2] = l;
+    } else {
+        double m2 = l <= 0.5 ? l * (1.0 + s) : l + s - (l * s);
+        double m1 = 2.0 * l - m2;
+        c[0] = hls_v(m1, m2, hn + 1.0 / 3.0);
+        c[1] = hls_v(m1, m2, hn);
+        c[2] = hls_v(m1, m2, hn - 1.0 / 3.0);
+    }
+    for (int i = 0; i < 3; i++) out[i] = (uint8_t)(int)(c[i] * 255);
+}
+
+static void build_tables(void) {
+    const double SQRT2 = sqrt(2.0), SQRT3 = sqrt(3.0), PI = 3.141592653589793;
+    PHI = (1 + sqrt(5.0)) / 2;
+    TAU = PHI - 1;
+    Z_C = sqrt(3.0) / 2;
+    THRESHOLD = Z_C * TAU * 0.5;
+
+    for (int i = 0; i < N_CORRIDORS; i++) {
+        int sq = 0;
+        for (int k = 0; k < 5; k++) sq += CORRIDOR_VECTORS[i][k] * CORRIDOR_VECTORS[i][k];
+        corridor_mag[i] = sqrt((double)sq);
+    }
+
+    for (int k = 0; k < SPAN; k++) {
+        int x = k - BLOOM_RECEIPT_RANGE;
+        lum[k] = clamp(Z_C * pow(PHI, x * 0.1), 0.05, 0.95);
+        double balance = 1 - fabs(lum[k] - 0.5) * 2;
+        lum_balance[k] = balance > 0 ? balance : 0;
+
+        hue[k] = py_mod(45.0 + x * 60, 360);
+        hue_activity[k] = fabs(sin(hue[k] * PI / 180));
+        for (int i = 0; i < N_CORRIDORS; i++) {
+            double diff = fabs(hue[k] - (i / 7.0) * 360);
+            if (360 - diff < diff) diff = 360 - diff;
+            hue_align[k][i] = 1 - (diff / 180);
+        }
+
+        sat[k] = clamp(TAU * pow(SQRT2, x * 0.15), 0.1, 1.0);
+
+        double d = pow(SQRT3, x * 0.1);
+        cym[k][0] = d / (1 + d);
+        cym[k][1] = 1 / (1 + d);
+        cym[k][2] = 1 - fabs(cym[k][0] - 0.5) * 0.5;
+        for (int i = 0; i < 3; i++) cym8[k][i] = (uint8_t)(int)(clamp(cym[k][i], 0, 1) * 255);
+        double mean = (cym[k][0] + cym[k][1] + cym[k][2]) / 3;
+        mix[k] = sqrt((pow(cym[k][0] - mean, 2) + pow(cym[k][1] - mean, 2) +
+                       pow(cym[k][2] - mean, 2)) / 3);
+    }
+
+    for (int a = 0; a < SPAN; a++) {
+        for (int c = 0; c < SPAN; c++) {
+            gray[a][c] = sqrt(pow(sat[c], 2) + pow(lum[a] - 0.5, 2));
+            fix[a][c] = exp(-gray[a][c] / TAU);
+        }
+    }
+    /* Hue takes six values: compute each colour once, copy to the rest */
+    for (int b = 0; b < SPAN; b++) {
+        if (b >= 6) {
+            memcpy(rgb[b], rgb[b % 6], sizeof(rgb[b]));
+            continue;
+        }
+        for (int a = 0; a < SPAN; a++) {
+            for (int c = 0; c < SPAN; c++) to_rgb(hue[b], sat[c], lum[a], rgb[b][a][c]);
+        }
+    }
+}
+
+/* ========================================================================== */
+/* Lattice                                                                     */
+/* ========================================================================== */
+
+static int clamp_coord(int v) {
+    return v < -BLOOM_RECEIPT_RANGE ? -BLOOM_RECEIPT_RANGE :
+           (v > BLOOM_RECEIPT_RANGE ? BLOOM_RECEIPT_RANGE : v);
+}
+
+/* GradientSchema.block_to_lattice() */
+static void block_to_lattice(const uint8_t hash[32], double order_param, uint64_t nonce,
+                             uint32_t oscillators, int8_t p[5]) {
+    int c[5];
+    for (int i = 0; i < 5; i++) {
+        uint64_t v = 0;
+        for (int j = 5; j >= 0; j--) v = (v << 8) | hash[6 * i + j];
+        c[i] = (int)(v % SPAN) - BLOOM_RECEIPT_RANGE;
+    }
+    if (order_param > Z_C) {
+        /* round() is half-to-even, as rint() in the default rounding mode */
+        double shift = rint((order_param - Z_C) * 7);
+        c[0] += (int)clamp(shift, -2 * SPAN, 2 * SPAN);
+    }
+    c[4] += (int)(nonce % 7) - 3;
+    c[3] += (int)(oscillators % 5) - 2;
+    for (int i = 0; i < 5; i++) p[i] = (int8_t)clamp_coord(c[i]);
+}
+
+/* ========================================================================== */
+/* Colour State                                                                */
+/* ========================================================================== */
+
+/* Normalize the four signature components to sum 1 */
+static void normalize_signatures(double *f, double *r, double *v, double *m, size_t n) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= n; i += 4) {
+        __m256d vf = _mm256_loadu_pd(f + i), vr = _mm256_loadu_pd(r + i);
+        __m256d vv = _mm256_loadu_pd(v + i), vm = _mm256_loadu_pd(m + i);
+        __m256d t = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(vf, vr), vv), vm);
+        _mm256_storeu_pd(f + i, _mm256_div_pd(vf, t));
+        _mm256_storeu_pd(r + i, _mm256_div_pd(vr, t));
+        _mm256_storeu_pd(v + i, _mm256_div_pd(vv, t));
+        _mm256_storeu_pd(m + i, _mm256_div_pd(vm, t));
+    }
+#endif
+    /* sigma_FIX = exp(...) > 0, so the total is never 0 */
+    for (; i < n; i++) {
+        double t = f[i] + r[i] + v[i] + m[i];
+        f[i] /= t;
+        r[i] /= t;
+        v[i] /= t;
+        m[i] /= t;
+    }
+}
+
+/* score = (alignment * 0.6 + hue_alignment * 0.4) * S * L for one corridor */
+static void corridor_scores(const double *dot, const double *mag, const double *align,
+                            const double *s, const double *l, double cmag, size_t n,
+                            double *score) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    __m256d vc = _mm256_set1_pd(cmag), w6 = _mm256_set1_pd(0.6), w4 = _mm256_set1_pd(0.4);
+    for (; i + 4 <= n; i += 4) {
+        __m256d a = _mm256_div_pd(_mm256_loadu_pd(dot + i),
+                                  _mm256_mul_pd(_mm256_loadu_pd(mag + i), vc));
+        __m256d x = _mm256_add_pd(_mm256_mul_pd(a, w6),
+                                  _mm256_mul_pd(_mm256_loadu_pd(align + i), w4));
+        x = _mm256_mul_pd(_mm256_mul_pd(x, _mm256_loadu_pd(s + i)), _mm256_loadu_pd(l + i));
+        _mm256_storeu_pd(score + i, x);
+    }
+#endif
+    for (; i < n; i++) {
+        double a = dot[i] / (mag[i] * cmag);
+        score[i] = (a * 0.6 + align[i] * 0.4) * s[i] * l[i];
+    }
+}
+
+/* GradientSchema._determine_archetype(); ties go to the first archetype */
+static int archetype(double h, double s, double l, const double sig[4]) {
+    double sc[BLOOM_RECEIPT_ARCHETYPES] = { 0 };
+    sc[SAGE] += sig[0] * 0.4;
+    sc[CAREGIVER] += sig[0] * 0.3;
+    sc[WARRIOR] += sig[1] * 0.4;
+    sc[DESTROYER] += sig[1] * 0.3;
+    sc[SEEKER] += sig[2] * 0.4;
+    sc[JESTER] += sig[2] * 0.3;
+    sc[CREATOR] += sig[3] * 0.4;
+    sc[MAGICIAN] += sig[3] * 0.3;
+
+    double hn = h / 360;
+    if ((0 <= hn && hn < 0.1) || hn >= 0.9) {
+        sc[WARRIOR] += 0.2;
+        sc[LOVER] += 0.15;
+    } else if (0.1 <= hn && hn < 0.2) {
+        sc[CREATOR] += 0.2;
+    } else if (0.2 <= hn && hn < 0.4) {
+        sc[CAREGIVER] += 0.2;
+        sc[INNOCENT] += 0.1;
+    } else if (0.4 <= hn && hn < 0.55) {
+        sc[SEEKER] += 0.2;
+    } else if (0.55 <= hn && hn < 0.7) {
+        sc[SAGE] += 0.2;
+        sc[RULER] += 0.1;
+    } else if (0.7 <= hn && hn < 0.85) {
+        sc[MAGICIAN] += 0.2;
+        sc[JESTER] += 0.1;
+    } else {
+        sc[LOVER] += 0.2;
+    }
+
+    if (l > Z_C) {
+        sc[INNOCENT] += 0.25;
+    } else if (l < TAU) {
+        sc[ORPHAN] += 0.25;
+        sc[DESTROYER] += 0.1;
+    }
+    if (s > 0.8) {
+        sc[WARRIOR] += 0.1;
+        sc[LOVER] += 0.1;
+    } else if (s < 0.3) {
+        sc[SAGE] += 0.1;
+        sc[ORPHAN] += 0.1;
+    }
+
+    int best = 0;
+    for (int i = 1; i < BLOOM_RECEIPT_ARCHETYPES; i++) {
+        if (sc[i] > sc[best]) best = i;
+    }
+    return best;
+}
+
+static uint8_t quantize63(double x) {
+    return (uint8_t)(int)(clamp(x, 0, 1) * 63);
+}
+
+/* lattice_to_color() for up to CHUNK points */
+static void receipt_chunk(const int8_t (*pts)[5], size_t n, bloom_receipt_record *out) {
+    double s[CHUNK], l[CHUNK], sf[CHUNK], sr[CHUNK], sv[CHUNK], sm[CHUNK], mag[CHUNK];
+    double dot[N_CORRIDORS][CHUNK], align[N_CORRIDORS][CHUNK], score[N_CORRIDORS][CHUNK];
+
+    for (size_t i = 0; i < n; i++) {
+        const int8_t *p = pts[i];
+        int a = p[0] + BLOOM_RECEIPT_RANGE, b = p[1] + BLOOM_RECEIPT_RANGE;
+        int c = p[2] + BLOOM_RECEIPT_RANGE, d = p[3] + BLOOM_RECEIPT_RANGE;
+        s[i] = sat[c];
+        l[i] = lum[a];
+        sf[i] = fix[a][c];
+        sr[i] = s[i] * gray[a][c];
+        sv[i] = hue_activity[b] * lum_balance[a];
+        sm[i] = mix[d];
+
+        int sq = 0;
+        for (int k = 0; k < 5; k++) sq += p[k] * p[k];
+        mag[i] = sq ? sqrt((double)sq) : 1;
+        for (int j = 0; j < N_CORRIDORS; j++) {
+            int dt = 0;
+            for (int k = 0; k < 5; k++) dt += p[k] * CORRIDOR_VECTORS[j][k];
+            dot[j][i] = dt;
+            align[j][i] = hue_align[b][j];
+        }
+    }
+
+    normalize_signatures(sf, sr, sv, sm, n);
+    for (int j = 0; j < N_CORRIDORS; j++) {
+        corridor_scores(dot[j], mag, align[j], s, l, corridor_mag[j], n, score[j]);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        const int8_t *p = pts[i];
+        int a = p[0] + BLOOM_RECEIPT_RANGE, b = p[1] + BLOOM_RECEIPT_RANGE;
+        int c = p[2] + BLOOM_RECEIPT_RANGE, d = p[3] + BLOOM_RECEIPT_RANGE;
+        bloom_receipt_record *r = &out[i];
+        double sig[4] = { sf[i], sr[i], sv[i], sm[i] };
+
+        memcpy(r->lattice, p, 5);
+        uint32_t packed = (uint32_t)quantize63(sig[0]) << 18 | (uint32_t)quantize63(sig[1]) << 12 |
+                          (uint32_t)quantize63(sig[2]) << 6 | quantize63(sig[3]);
+        r->signature[0] = (uint8_t)(packed >> 16);
+        r->signature[1] = (uint8_t)(packed >> 8);
+        r->signature[2] = (uint8_t)packed;
+        memcpy(r->cym, cym8[d], 3);
+        memcpy(r->rgb, rgb[b][a][c], 3);
+
+        /* Highest score first, ties to the higher index (reverse tuple sort) */
+        int top = 0;
+        uint8_t mask = 0;
+        for (int j = 0; j < N_CORRIDORS; j++) {
+            if (score[j][i] >= score[top][i]) top = j;
+            if (score[j][i] >= THRESHOLD) mask |= (uint8_t)(1u << j);
+        }
+        r->corridors = mask ? mask : (uint8_t)(1u << top);
+        r->corridor_archetype = (uint8_t)(top << 4 | archetype(hue[b], s[i], l[i], sig));
+    }
+}
+
+/* ========================================================================== */
+/* Public API                                                                  */
+/* ========================================================================== */
+
+void bloom_receipt_batch(const uint8_t (*hashes)[32], const double *order_param,
+                         const uint64_t *nonce, const uint32_t *oscillator_count,
+                         size_t n, bloom_receipt_record *out) {
+    pthread_once(&tables_once, build_tables);
+    long long n_chunks = (long long)((n + CHUNK - 1) / CHUNK);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) if (n_chunks > 1)
+#endif
+    for (long long k = 0; k < n_chunks; k++) {
+        int8_t pts[CHUNK][5];
+        size_t from = (size_t)k * CHUNK, m = n - from < CHUNK ? n - from : CHUNK;
+        for (size_t i = 0; i < m; i++) {
+            block_to_lattice(hashes[from + i], order_param[from + i], nonce[from + i],
+                             oscillator_count[from + i], pts[i]);
+        }
+        receipt_chunk((const int8_t (*)[5])pts, m, out + from);
+    }
+}
+
+size_t bloom_receipt_from_lattice(const int8_t (*points)[5], size_t n,
+                                  bloom_receipt_record *out) {
+    pthread_once(&tables_once, build_tables);
+    size_t valid = 0;
+    for (; valid < n; valid++) {
+        int ok = 1;
+        for (int k = 0; k < 5; k++) {
+            ok &= points[valid][k] >= -BLOOM_RECEIPT_RANGE && points[valid][k] <= BLOOM_RECEIPT_RANGE;
+        }
+        if (!ok) break;
+    }
+    long long n_chunks = (long long)((valid + CHUNK - 1) / CHUNK);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) if (n_chunks > 1)
+#endif
+    for (long long k = 0; k < n_chunks; k++) {
+        size_t from = (size_t)k * CHUNK;
+        receipt_chunk(points + from, valid - from < CHUNK ? valid - from : CHUNK, out + from);
+    }
+    return valid;
+}
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static uint64_t test_rng = 0x2545F4914F6CDD1Dull;
+
+static uint64_t xorshift(void) {
+    test_rng ^= test_rng << 13;
+    test_rng ^= test_rng >> 7;
+    test_rng ^= test_rng << 17;
+    return test_rng;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* zlib crc32 */
+static uint32_t crc32_update(uint32_t crc, const uint8_t *p, size_t n) {
+    crc = ~crc;
+    for (size_t i = 0; i < n; i++) {
+        crc ^= p[i];
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+/* Blocks as generated by the Python reference script */
+static void make_blocks(size_t n, uint8_t (*hashes)[32], double *op, uint64_t *nonce,
+                        uint32_t *osc) {
+    test_rng = 0x2545F4914F6CDD1Dull;
+    for (size_t i = 0; i < n; i++) {
+        for (int k = 0; k < 4; k++) {
+            uint64_t v = xorshift();
+            for (int j = 0; j < 8; j++) hashes[i][8 * k + j] = (uint8_t)(v >> (8 * j));
+        }
+        op[i] = 0.70 + (double)(xorshift() % 3000) / 10000.0;
+        nonce[i] = xorshift();
+        osc[i] = (uint32_t)(xorshift() % 128);
+    }
+}
+
+int main(void) {
+    int fail = 0, ok;
+    printf("BloomCoin Batch Receipt Generator\n");
+    printf("=================================\n\n");
+
+    const size_t N = 1000000, CHECKED = 100000;
+    uint8_t (*hashes)[32] = malloc(N * 32);
+    double *op = malloc(N * sizeof(double));
+    uint64_t *nonce = malloc(N * sizeof(uint64_t));
+    uint32_t *osc = malloc(N * sizeof(uint32_t));
+    bloom_receipt_record *rec = malloc(N * sizeof(bloom_receipt_record));
+    bloom_receipt_record *again = malloc(N * sizeof(bloom_receipt_record));
+    int8_t (*pts)[5] = malloc(N * 5);
+    make_blocks(N, hashes, op, nonce, osc);
+
+    /*
+     * Python reference: block_to_lattice() + lattice_to_color() over the
+     * first 100000 blocks, records packed as in bloom_receipt.h
+     */
+    {
+        static const char *first[4] = {
+            "14efedfb0a137c81906e90f6f0f5ef02", "fc1403f30f243db1cc53abe981ead004",
+            "000ded08f6237053cd9b63f1d8e4d404", "0e0613fcfa321ac089718df8fff8e50d",
+        };
+        bloom_receipt_batch((const uint8_t (*)[32])hashes, op, nonce, osc, CHECKED, rec);
+        ok = sizeof(bloom_receipt_record) == 16 &&
+             crc32_update(0, (const uint8_t *)rec, CHECKED * 16) == 0x3f9c8c63u;
+        for (int i = 0; i < 4; i++) {
+            char hex[33];
+            for (int j = 0; j < 16; j++) sprintf(hex + 2 * j, "%02x", ((uint8_t *)&rec[i])[j]);
+            ok &= strcmp(hex, first[i]) == 0;
+        }
+        printf("matches Python schema:    %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Every archetype and corridor shows up */
+    {
+        int arch = 0, corr = 0;
+        for (size_t i = 0; i < CHECKED; i++) {
+            arch |= 1 << (rec[i].corridor_archetype & 15);
+            corr |= rec[i].corridors;
+        }
+        printf("  archetypes seen %d/12, corridor mask %02x\n",
+               __builtin_popcount((unsigned)arch), corr);
+    }
+
+    /* Verifier path: lattice points back to identical records */
+    {
+        for (size_t i = 0; i < CHECKED; i++) memcpy(pts[i], rec[i].lattice, 5);
+        size_t done = bloom_receipt_from_lattice((const int8_t (*)[5])pts, CHECKED, again);
+        ok = done == CHECKED && memcmp(rec, again, CHECKED * 16) == 0;
+        pts[7][2] = 21;
+        ok &= bloom_receipt_from_lattice((const int8_t (*)[5])pts, CHECKED, again) == 7;
+        printf("from lattice:             %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Whole-chain regeneration */
+    {
+        double t0 = now_sec();
+        bloom_receipt_batch((const uint8_t (*)[32])hashes, op, nonce, osc, N, rec);
+        double dt = now_sec() - t0;
+        ok = crc32_update(0, (const uint8_t *)rec, CHECKED * 16) == 0x3f9c8c63u;
+        printf("%zu receipts:         %.3f s (%.0f ns/block, Python ~93 us)  %s\n",
+               N, dt, dt / N * 1e9, ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    free(hashes);
+    free(op);
+    free(nonce);
+    free(osc);
+    free(rec);
+    free(again);
+    free(pts);
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
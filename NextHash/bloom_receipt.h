@@ -0,0 +1,76 @@
+/*
+ * BloomCoin Batch Receipt Generator
+ * =================================
+ *
+ * Native GradientSchema.block_to_lattice() + lattice_to_color() from
+ * receipt/gradient_schema.py for whole arrays of blocks: lattice point,
+ * CYM weights, primitive signature, archetype, corridors and RGB, written
+ * as packed 16-byte records.
+ *
+ * Results are bit-identical to the Python schema, so a receipt made here
+ * verifies with receipt_verifier.py: generator powers and exp/sin come
+ * from tables filled by the same libm calls, the rest is IEEE arithmetic in
+ * the Python evaluation order (no fused multiply-add).
+ *
+ * Features:
+ * - Every colour quantity depends on one or two lattice coordinates:
+ *   41-entry (and 41 x 41) tables replace the per-block powers
+ * - Signature normalization and corridor scores four blocks at a time in
+ *   AVX2 double lanes (scalar fallback), chunked over OpenMP threads
+ * - Records carry the receipt payload encodings directly
+ *
+ * Record (16 bytes):
+ *   [0:5]   int8[5]  lattice (a, b, c, d, f)     LatticePoint.to_bytes()
+ *   [5]     uint8    (corridor_id << 4) | archetype_id   payload byte 55
+ *   [6:9]   uint24   signature, big-endian       to_packed_uint24()
+ *   [9:12]  uint8[3] CYM weights                 to_uint8_triple()
+ *   [12:15] uint8[3] RGB                         ColorState.to_rgb()
+ *   [15]    uint8    active corridor bitmask (bit i = corridor i)
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef BLOOM_RECEIPT_H
+#define BLOOM_RECEIPT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLOOM_RECEIPT_RANGE      20     /* coordinates in [-20, +20] */
+#define BLOOM_RECEIPT_CORRIDORS  7
+#define BLOOM_RECEIPT_ARCHETYPES 12
+
+typedef struct {
+    int8_t lattice[5];
+    uint8_t corridor_archetype;
+    uint8_t signature[3];
+    uint8_t cym[3];
+    uint8_t rgb[3];
+    uint8_t corridors;
+} bloom_receipt_record;
+
+/*
+ * Receipts for n blocks: block_to_lattice(hashes[i], order_param[i],
+ * nonce[i], oscillator_count[i]) followed by lattice_to_color().
+ */
+void bloom_receipt_batch(const uint8_t (*hashes)[32], const double *order_param,
+                         const uint64_t *nonce, const uint32_t *oscillator_count,
+                         size_t n, bloom_receipt_record *out);
+
+/*
+ * Receipts for n lattice points (as decoded from a payload). Returns the
+ * number of points processed; stops at the first coordinate out of range.
+ */
+size_t bloom_receipt_from_lattice(const int8_t (*points)[5], size_t n,
+                                  bloom_receipt_record *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOOM_RECEIPT_H */
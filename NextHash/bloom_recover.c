@@ -0,0 +1,1188 @@
+/*
+ * BloomCoin Mnemonic Recovery Search
+ * ==================================
+ *
+ * Compile: gcc -O3 -c bloom_sha256.c
+ *          gcc -O3 -march=native -fopenmp -o bloom_recover bloom_recover.c bloom_sha256.o -DTEST_MAIN
+ *
+ * Derivations per second on one core (Xeon, gcc 12, -fopenmp with one
+ * thread): about 470 with -O3 (scalar), 1300 with -O3 -mavx2 and 2100 with
+ * -O3 -march=native, where BMI2 and the wider instruction selection speed
+ * up the scalar Ed25519 and Blake2b steps. Rates scale with cores.
+ *
+ * Command line tool (same sources, -DRECOVER_MAIN instead of -DTEST_MAIN):
+ *   bloom_recover [-p passphrase] [-w wordlist] [-n] ADDRESS WORD...
+ * Each WORD is a known word, "?" for a lost word, or "pre*" for a lost
+ * word known to start with "pre". The search space, measured rate and
+ * estimated time are printed before the search starts; -n stops there.
+ */
+
+#define _GNU_SOURCE
+#include "bloom_recover.h"
+#include "bloom_sha256.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LANES 4
+#else
+#define LANES 1
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define PBKDF2_ITERATIONS 2048
+
+/* Candidates per OpenMP work item */
+#define SEARCH_BLOCK 256
+
+/* Longest mnemonic the search builds */
+#define MAX_MNEMONIC 1024
+
+typedef unsigned __int128 u128;
+
+/* ========================================================================== */
+/* Helpers                                                                     */
+/* ========================================================================== */
+
+static uint32_t load32_be(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void store32_be(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static uint64_t load64_be(const uint8_t *p) {
+    return ((uint64_t)load32_be(p) << 32) | load32_be(p + 4);
+}
+
+static void store64_be(uint8_t *p, uint64_t v) {
+    store32_be(p, (uint32_t)(v >> 32));
+    store32_be(p + 4, (uint32_t)v);
+}
+
+static uint64_t load64_le(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static void store64_le(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* ========================================================================== */
+/* SHA-256 (mnemonic checksum)                                                 */
+/* ========================================================================== */
+
+/* First byte of SHA-256 of at most 55 bytes: all the checksum needs */
+static uint8_t sha256_first_byte(const uint8_t *data, size_t len) {
+    uint8_t block[64] = { 0 };
+    uint32_t s[8];
+    memcpy(s, bloom_sha256_iv, sizeof(s));
+    memcpy(block, data, len);
+    block[len] = 0x80;
+    store64_be(block + 56, (uint64_t)len * 8);
+    bloom_sha256_block(s, block);
+    return (uint8_t)(s[0] >> 24);
+}
+
+/* ========================================================================== */
+/* SHA-512                                                                     */
+/* ========================================================================== */
+
+static const uint64_t K512[80] = {
+    0x428A2F98D728AE22ull, 0x7137449123EF65CDull, 0xB5C0FBCFEC4D3B2Full, 0xE9B5DBA58189DBBCull,
+    0x3956C25BF348B538ull, 0x59F111F1B605D019ull, 0x923F82A4AF194F9Bull, 0xAB1C5ED5DA6D8118ull,
+    0xD807AA98A3030242ull, 0x12835B0145706FBEull, 0x243185BE4EE4B28Cull, 0x550C7DC3D5FFB4E2ull,
+    0x72BE5D74F27B896Full, 0x80DEB1FE3B1696B1ull, 0x9BDC06A725C71235ull, 0xC19BF174CF692694ull,
+    0xE49B69C19EF14AD2ull, 0xEFBE4786384F25E3ull, 0x0FC19DC68B8CD5B5ull, 0x240CA1CC77AC9C65ull,
+    0x2DE92C6F592B0275ull, 0x4A7484AA6EA6E483ull, 0x5CB0A9DCBD41FBD4ull, 0x76F988DA831153B5ull,
+    0x983E5152EE66DFABull, 0xA831C66D2DB43210ull, 0xB00327C898FB213Full, 0xBF597FC7BEEF0EE4ull,
+    0xC6E00BF33DA88FC2ull, 0xD5A79147930AA725ull, 0x06CA6351E003826Full, 0x142929670A0E6E70ull,
+    0x27B70A8546D22FFCull, 0x2E1B21385C26C926ull, 0x4D2C6DFC5AC42AEDull, 0x53380D139D95B3DFull,
+    0x650A73548BAF63DEull, 0x766A0ABB3C77B2A8ull, 0x81C2C92E47EDAEE6ull, 0x92722C851482353Bull,
+    0xA2BFE8A14CF10364ull, 0xA81A664BBC423001ull, 0xC24B8B70D0F89791ull, 0xC76C51A30654BE30ull,
+    0xD192E819D6EF5218ull, 0xD69906245565A910ull, 0xF40E35855771202Aull, 0x106AA07032BBD1B8ull,
+    0x19A4C116B8D2D0C8ull, 0x1E376C085141AB53ull, 0x2748774CDF8EEB99ull, 0x34B0BCB5E19B48A8ull,
+    0x391C0CB3C5C95A63ull, 0x4ED8AA4AE3418ACBull, 0x5B9CCA4F7763E373ull, 0x682E6FF3D6B2B8A3ull,
+    0x748F82EE5DEFB2FCull, 0x78A5636F43172F60ull, 0x84C87814A1F0AB72ull, 0x8CC702081A6439ECull,
+    0x90BEFFFA23631E28ull, 0xA4506CEBDE82BDE9ull, 0xBEF9A3F7B2C67915ull, 0xC67178F2E372532Bull,
+    0xCA273ECEEA26619Cull, 0xD186B8C721C0C207ull, 0xEADA7DD6CDE0EB1Eull, 0xF57D4F7FEE6ED178ull,
+    0x06F067AA72176FBAull, 0x0A637DC5A2C898A6ull, 0x113F9804BEF90DAEull, 0x1B710B35131C471Bull,
+    0x28DB77F523047D84ull, 0x32CAAB7B40C72493ull, 0x3C9EBE0A15C9BEBCull, 0x431D67C49C100D4Cull,
+    0x4CC5D4BECB3E42B6ull, 0x597F299CFC657E2Aull, 0x5FCB6FAB3AD6FAECull, 0x6C44198C4A475817ull
+};
+
+static const uint64_t IV512[8] = {
+    0x6A09E667F3BCC908ull, 0xBB67AE8584CAA73Bull, 0x3C6EF372FE94F82Bull, 0xA54FF53A5F1D36F1ull,
+    0x510E527FADE682D1ull, 0x9B05688C2B3E6C1Full, 0x1F83D9ABFB41BD6Bull, 0x5BE0CD19137E2179ull
+};
+
+#define ROR64(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+static void sha512_compress(uint64_t s[8], const uint64_t in[16]) {
+    uint64_t w[80], a, b, c, d, e, f, g, h;
+    memcpy(w, in, 16 * sizeof(uint64_t));
+    for (int i = 16; i < 80; i++) {
+        uint64_t s0 = ROR64(w[i - 15], 1) ^ ROR64(w[i - 15], 8) ^ (w[i - 15] >> 7);
+        uint64_t s1 = ROR64(w[i - 2], 19) ^ ROR64(w[i - 2], 61) ^ (w[i - 2] >> 6);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    a = s[0]; b = s[1]; c = s[2]; d = s[3];
+    e = s[4]; f = s[5]; g = s[6]; h = s[7];
+    for (int i = 0; i < 80; i++) {
+        uint64_t t1 = h + (ROR64(e, 14) ^ ROR64(e, 18) ^ ROR64(e, 41)) + ((e & f) ^ (~e & g)) +
+                      K512[i] + w[i];
+        uint64_t t2 = (ROR64(a, 28) ^ ROR64(a, 34) ^ ROR64(a, 39)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    s[0] += a; s[1] += b; s[2] += c; s[3] += d;
+    s[4] += e; s[5] += f; s[6] += g; s[7] += h;
+}
+
+static void sha512_block(uint64_t s[8], const uint8_t block[128]) {
+    uint64_t w[16];
+    for (int i = 0; i < 16; i++) w[i] = load64_be(block + 8 * i);
+    sha512_compress(s, w);
+}
+
+/* Hash data into s, which has already absorbed `done` bytes, and finish */
+static void sha512_finish(uint64_t s[8], uint64_t done, const uint8_t *data, size_t len,
+                          uint8_t out[64]) {
+    uint8_t tail[256] = { 0 };
+    size_t full = len & ~(size_t)127, rest = len - full;
+    for (size_t i = 0; i < full; i += 128) sha512_block(s, data + i);
+    memcpy(tail, data + full, rest);
+    tail[rest] = 0x80;
+    size_t total = rest < 112 ? 128 : 256;
+    store64_be(tail + total - 8, (done + len) * 8);
+    for (size_t i = 0; i < total; i += 128) sha512_block(s, tail + i);
+    for (int i = 0; i < 8; i++) store64_be(out + 8 * i, s[i]);
+}
+
+static void sha512(const uint8_t *data, size_t len, uint8_t out[64]) {
+    uint64_t s[8];
+    memcpy(s, IV512, sizeof(s));
+    sha512_finish(s, 0, data, len, out);
+}
+
+#if defined(__AVX2__)
+#define ROR4(x, n) _mm256_or_si256(_mm256_srli_epi64((x), (n)), _mm256_slli_epi64((x), 64 - (n)))
+
+/* Four independent SHA-512 compressions, one per 64-bit lane */
+static void sha512_compress_x4(__m256i s[8], const __m256i in[16]) {
+    __m256i w[80], a, b, c, d, e, f, g, h;
+    memcpy(w, in, 16 * sizeof(__m256i));
+    for (int i = 16; i < 80; i++) {
+        __m256i x = w[i - 15], y = w[i - 2];
+        __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(ROR4(x, 1), ROR4(x, 8)),
+                                      _mm256_srli_epi64(x, 7));
+        __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(ROR4(y, 19), ROR4(y, 61)),
+                                      _mm256_srli_epi64(y, 6));
+        w[i] = _mm256_add_epi64(_mm256_add_epi64(w[i - 16], s0), _mm256_add_epi64(w[i - 7], s1));
+    }
+    a = s[0]; b = s[1]; c = s[2]; d = s[3];
+    e = s[4]; f = s[5]; g = s[6]; h = s[7];
+    for (int i = 0; i < 80; i++) {
+        __m256i S1 = _mm256_xor_si256(_mm256_xor_si256(ROR4(e, 14), ROR4(e, 18)), ROR4(e, 41));
+        __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        __m256i t1 = _mm256_add_epi64(_mm256_add_epi64(h, S1),
+                                      _mm256_add_epi64(ch, _mm256_add_epi64(
+                                          _mm256_set1_epi64x((long long)K512[i]), w[i])));
+        __m256i S0 = _mm256_xor_si256(_mm256_xor_si256(ROR4(a, 28), ROR4(a, 34)), ROR4(a, 39));
+        __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b),
+                                      _mm256_and_si256(c, _mm256_or_si256(a, b)));
+        __m256i t2 = _mm256_add_epi64(S0, maj);
+        h = g; g = f; f = e; e = _mm256_add_epi64(d, t1);
+        d = c; c = b; b = a; a = _mm256_add_epi64(t1, t2);
+    }
+    s[0] = _mm256_add_epi64(s[0], a); s[1] = _mm256_add_epi64(s[1], b);
+    s[2] = _mm256_add_epi64(s[2], c); s[3] = _mm256_add_epi64(s[3], d);
+    s[4] = _mm256_add_epi64(s[4], e); s[5] = _mm256_add_epi64(s[5], f);
+    s[6] = _mm256_add_epi64(s[6], g); s[7] = _mm256_add_epi64(s[7], h);
+}
+#endif
+
+/* ========================================================================== */
+/* PBKDF2-HMAC-SHA512                                                          */
+/* ========================================================================== */
+
+/*
+ * seeds[i] = PBKDF2-HMAC-SHA512(pw[i], salt, 2048, 64) for i < n <= LANES;
+ * msg is salt || INT(1). The first HMAC of each lane is scalar, the 2047
+ * after it run in lanes.
+ */
+static void pbkdf2_lanes(const uint8_t *const *pw, const size_t *pw_len, size_t n,
+                         const uint8_t *msg, size_t msg_len, uint8_t (*seeds)[64]) {
+    uint64_t inner[LANES][8], outer[LANES][8], u[LANES][8], t[LANES][8];
+
+    for (size_t l = 0; l < LANES; l++) {
+        size_t src = l < n ? l : 0;
+        uint8_t key[128] = { 0 }, pad[128], d[64];
+        if (pw_len[src] > 128) sha512(pw[src], pw_len[src], key);
+        else memcpy(key, pw[src], pw_len[src]);
+        memcpy(inner[l], IV512, sizeof(IV512));
+        memcpy(outer[l], IV512, sizeof(IV512));
+        for (int i = 0; i < 128; i++) pad[i] = key[i] ^ 0x36;
+        sha512_block(inner[l], pad);
+        for (int i = 0; i < 128; i++) pad[i] = key[i] ^ 0x5C;
+        sha512_block(outer[l], pad);
+
+        uint64_t s[8];
+        memcpy(s, inner[l], sizeof(s));
+        sha512_finish(s, 128, msg, msg_len, d);
+        memcpy(s, outer[l], sizeof(s));
+        sha512_finish(s, 128, d, 64, d);
+        for (int i = 0; i < 8; i++) t[l][i] = u[l][i] = load64_be(d + 8 * i);
+    }
+
+#if defined(__AVX2__)
+    __m256i vi[8], vo[8], vu[8], vt[8], w[16], s[8];
+    for (int i = 0; i < 8; i++) {
+        vi[i] = _mm256_set_epi64x((long long)inner[3][i], (long long)inner[2][i],
+                                  (long long)inner[1][i], (long long)inner[0][i]);
+        vo[i] = _mm256_set_epi64x((long long)outer[3][i], (long long)outer[2][i],
+                                  (long long)outer[1][i], (long long)outer[0][i]);
+        vu[i] = _mm256_set_epi64x((long long)u[3][i], (long long)u[2][i],
+                                  (long long)u[1][i], (long long)u[0][i]);
+        vt[i] = _mm256_set_epi64x((long long)t[3][i], (long long)t[2][i],
+                                  (long long)t[1][i], (long long)t[0][i]);
+    }
+    /* 64-byte message after a 128-byte key block: one padded block */
+    w[8] = _mm256_set1_epi64x((long long)0x8000000000000000ull);
+    for (int i = 9; i < 15; i++) w[i] = _mm256_setzero_si256();
+    w[15] = _mm256_set1_epi64x((128 + 64) * 8);
+    for (int it = 1; it < PBKDF2_ITERATIONS; it++) {
+        memcpy(w, vu, sizeof(vu));
+        memcpy(s, vi, sizeof(s));
+        sha512_compress_x4(s, w);
+        memcpy(w, s, sizeof(s));
+        memcpy(vu, vo, sizeof(vu));
+        sha512_compress_x4(vu, w);
+        for (int i = 0; i < 8; i++) vt[i] = _mm256_xor_si256(vt[i], vu[i]);
+    }
+    for (int i = 0; i < 8; i++) {
+        uint64_t lane[4];
+        _mm256_storeu_si256((__m256i *)lane, vt[i]);
+        for (size_t l = 0; l < n; l++) store64_be(seeds[l] + 8 * i, lane[l]);
+    }
+#else
+    uint64_t w[16] = { 0 }, s[8];
+    w[8] = 0x8000000000000000ull;
+    w[15] = (128 + 64) * 8;
+    for (int it = 1; it < PBKDF2_ITERATIONS; it++) {
+        memcpy(w, u[0], sizeof(u[0]));
+        memcpy(s, inner[0], sizeof(s));
+        sha512_compress(s, w);
+        memcpy(w, s, sizeof(s));
+        memcpy(u[0], outer[0], sizeof(u[0]));
+        sha512_compress(u[0], w);
+        for (int i = 0; i < 8; i++) t[0][i] ^= u[0][i];
+    }
+    for (int i = 0; i < 8; i++) store64_be(seeds[0] + 8 * i, t[0][i]);
+#endif
+}
+
+/* ========================================================================== */
+/* Ed25519 Public Keys                                                         */
+/* ========================================================================== */
+
+/* GF(2^255 - 19), five 51-bit limbs */
+typedef struct { uint64_t v[5]; } fe;
+
+/* Extended coordinates: x = X/Z, y = Y/Z, xy = T/Z */
+typedef struct { fe X, Y, Z, T; } ge;
+
+#define MASK51 ((1ull << 51) - 1)
+
+static const uint8_t ED_BX[32] = {
+    0x1a, 0xd5, 0x25, 0x8f, 0x60, 0x2d, 0x56, 0xc9, 0xb2, 0xa7, 0x25, 0x95, 0x60, 0xc7, 0x2c, 0x69,
+    0x5c, 0xdc, 0xd6, 0xfd, 0x31, 0xe2, 0xa4, 0xc0, 0xfe, 0x53, 0x6e, 0xcd, 0xd3, 0x36, 0x69, 0x21
+};
+static const uint8_t ED_BY[32] = {
+    0x58, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66,
+    0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66
+};
+static const uint8_t ED_D2[32] = {             /* 2d, d = -121665 / 121666 */
+    0x59, 0xf1, 0xb2, 0x26, 0x94, 0x9b, 0xd6, 0xeb, 0x56, 0xb1, 0x83, 0x82, 0x9a, 0x14, 0xe0, 0x00,
+    0x30, 0xd1, 0xf3, 0xee, 0xf2, 0x80, 0x8e, 0x19, 0xe7, 0xfc, 0xdf, 0x56, 0xdc, 0xd9, 0x06, 0x24
+};
+
+static void fe_frombytes(fe *h, const uint8_t s[32]) {
+    uint64_t w0 = load64_le(s), w1 = load64_le(s + 8), w2 = load64_le(s + 16),
+             w3 = load64_le(s + 24);
+    h->v[0] = w0 & MASK51;
+    h->v[1] = ((w0 >> 51) | (w1 << 13)) & MASK51;
+    h->v[2] = ((w1 >> 38) | (w2 << 26)) & MASK51;
+    h->v[3] = ((w2 >> 25) | (w3 << 39)) & MASK51;
+    h->v[4] = (w3 >> 12) & MASK51;
+}
+
+static void fe_carry(fe *h) {
+    uint64_t c;
+    for (int i = 0; i < 4; i++) {
+        c = h->v[i] >> 51;
+        h->v[i] &= MASK51;
+        h->v[i + 1] += c;
+    }
+    c = h->v[4] >> 51;
+    h->v[4] &= MASK51;
+    h->v[0] += 19 * c;
+}
+
+static void fe_add(fe *h, const fe *f, const fe *g) {
+    for (int i = 0; i < 5; i++) h->v[i] = f->v[i] + g->v[i];
+    fe_carry(h);
+}
+
+/* f - g + 2p keeps limbs positive */
+static void fe_sub(fe *h, const fe *f, const fe *g) {
+    h->v[0] = f->v[0] + 0xFFFFFFFFFFFDAull - g->v[0];
+    for (int i = 1; i < 5; i++) h->v[i] = f->v[i] + 0xFFFFFFFFFFFFEull - g->v[i];
+    fe_carry(h);
+}
+
+static void fe_mul(fe *h, const fe *f, const fe *g) {
+    const uint64_t *a = f->v, *b = g->v;
+    uint64_t b1 = 19 * b[1], b2 = 19 * b[2], b3 = 19 * b[3], b4 = 19 * b[4];
+    u128 r0 = (u128)a[0] * b[0] + (u128)a[1] * b4 + (u128)a[2] * b3 + (u128)a[3] * b2 + (u128)a[4] * b1;
+    u128 r1 = (u128)a[0] * b[1] + (u128)a[1] * b[0] + (u128)a[2] * b4 + (u128)a[3] * b3 + (u128)a[4] * b2;
+    u128 r2 = (u128)a[0] * b[2] + (u128)a[1] * b[1] + (u128)a[2] * b[0] + (u128)a[3] * b4 + (u128)a[4] * b3;
+    u128 r3 = (u128)a[0] * b[3] + (u128)a[1] * b[2] + (u128)a[2] * b[1] + (u128)a[3] * b[0] + (u128)a[4] * b4;
+    u128 r4 = (u128)a[0] * b[4] + (u128)a[1] * b[3] + (u128)a[2] * b[2] + (u128)a[3] * b[1] + (u128)a[4] * b[0];
+    r1 += (uint64_t)(r0 >> 51);
+    r2 += (uint64_t)(r1 >> 51);
+    r3 += (uint64_t)(r2 >> 51);
+    r4 += (uint64_t)(r3 >> 51);
+    uint64_t c = (uint64_t)(r4 >> 51);
+    h->v[0] = ((uint64_t)r0 & MASK51) + 19 * c;
+    h->v[1] = (uint64_t)r1 & MASK51;
+    h->v[2] = (uint64_t)r2 & MASK51;
+    h->v[3] = (uint64_t)r3 & MASK51;
+    h->v[4] = (uint64_t)r4 & MASK51;
+    fe_carry(h);
+}
+
+/* z^(p - 2) */
+static void fe_invert(fe *out, const fe *z) {
+    fe r = { { 1, 0, 0, 0, 0 } };
+    for (int bit = 254; bit >= 0; bit--) {
+        fe_mul(&r, &r, &r);
+        /* p - 2 = 2^255 - 21: every bit set except 2 and 4 */
+        if (bit != 2 && bit != 4) fe_mul(&r, &r, z);
+    }
+    *out = r;
+}
+
+static void fe_tobytes(uint8_t s[32], const fe *f) {
+    fe h = *f;
+    fe_carry(&h);
+    fe_carry(&h);
+    /* Subtract p when h >= p */
+    uint64_t q = (h.v[0] + 19) >> 51;
+    q = (h.v[1] + q) >> 51;
+    q = (h.v[2] + q) >> 51;
+    q = (h.v[3] + q) >> 51;
+    q = (h.v[4] + q) >> 51;
+    h.v[0] += 19 * q;
+    for (int i = 0; i < 4; i++) {
+        h.v[i + 1] += h.v[i] >> 51;
+        h.v[i] &= MASK51;
+    }
+    h.v[4] &= MASK51;
+    store64_le(s, h.v[0] | (h.v[1] << 51));
+    store64_le(s + 8, (h.v[1] >> 13) | (h.v[2] << 38));
+    store64_le(s + 16, (h.v[2] >> 26) | (h.v[3] << 25));
+    store64_le(s + 24, (h.v[3] >> 39) | (h.v[4] << 12));
+}
+
+static fe ed_d2;
+static ge ed_base[255];                          /* 2^i B */
+static pthread_once_t ed_once = PTHREAD_ONCE_INIT;
+
+/* Unified addition on -x^2 + y^2 = 1 + d x^2 y^2 (also doubles) */
+static void ge_add(ge *r, const ge *p, const ge *q) {
+    fe a, b, c, d, e, f, g, h, t;
+    fe_sub(&a, &p->Y, &p->X);
+    fe_sub(&t, &q->Y, &q->X);
+    fe_mul(&a, &a, &t);
+    fe_add(&b, &p->Y, &p->X);
+    fe_add(&t, &q->Y, &q->X);
+    fe_mul(&b, &b, &t);
+    fe_mul(&c, &p->T, &q->T);
+    fe_mul(&c, &c, &ed_d2);
+    fe_mul(&d, &p->Z, &q->Z);
+    fe_add(&d, &d, &d);
+    fe_sub(&e, &b, &a);
+    fe_sub(&f, &d, &c);
+    fe_add(&g, &d, &c);
+    fe_add(&h, &b, &a);
+    fe_mul(&r->X, &e, &f);
+    fe_mul(&r->Y, &g, &h);
+    fe_mul(&r->T, &e, &h);
+    fe_mul(&r->Z, &f, &g);
+}
+
+static void ed_init(void) {
+    ge *b = &ed_base[0];
+    fe_frombytes(&ed_d2, ED_D2);
+    fe_frombytes(&b->X, ED_BX);
+    fe_frombytes(&b->Y, ED_BY);
+    memset(&b->Z, 0, sizeof(fe));
+    b->Z.v[0] = 1;
+    fe_mul(&b->T, &b->X, &b->Y);
+    for (int i = 1; i < 255; i++) ge_add(&ed_base[i], &ed_base[i - 1], &ed_base[i - 1]);
+}
+
+/* RFC 8032 public key of a 32-byte secret */
+static void ed25519_public(const uint8_t secret[32], uint8_t pk[32]) {
+    uint8_t h[64];
+    sha512(secret, 32, h);
+    h[0] &= 248;
+    h[31] &= 127;
+    h[31] |= 64;
+
+    ge r;
+    memset(&r, 0, sizeof(r));
+    r.Y.v[0] = 1;
+    r.Z.v[0] = 1;
+    for (int i = 0; i < 255; i++) {
+        if (h[i >> 3] >> (i & 7) & 1) ge_add(&r, &r, &ed_base[i]);
+    }
+
+    fe zi, x, y;
+    uint8_t xb[32];
+    fe_invert(&zi, &r.Z);
+    fe_mul(&x, &r.X, &zi);
+    fe_mul(&y, &r.Y, &zi);
+    fe_tobytes(pk, &y);
+    fe_tobytes(xb, &x);
+    pk[31] |= (uint8_t)((xb[0] & 1) << 7);
+}
+
+/* ========================================================================== */
+/* Blake2b-256 (addresses)                                                     */
+/* ========================================================================== */
+
+static const uint8_t SIGMA[12][16] = {
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+    { 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },
+    { 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
+    { 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },
+    { 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
+    { 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },
+    { 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
+    { 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },
+    { 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 },
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+};
+
+#define B2_G(a, b, c, d, x, y)                     \
+    do {                                           \
+        v[a] = v[a] + v[b] + (x);                  \
+        v[d] = ROR64(v[d] ^ v[a], 32);             \
+        v[c] = v[c] + v[d];                        \
+        v[b] = ROR64(v[b] ^ v[c], 24);             \
+        v[a] = v[a] + v[b] + (y);                  \
+        v[d] = ROR64(v[d] ^ v[a], 16);             \
+        v[c] = v[c] + v[d];                        \
+        v[b] = ROR64(v[b] ^ v[c], 63);             \
+    } while (0)
+
+static void blake2b_compress(uint64_t h[8], const uint8_t block[128], uint64_t t, int last) {
+    uint64_t m[16], v[16];
+    for (int i = 0; i < 16; i++) m[i] = load64_le(block + 8 * i);
+    for (int i = 0; i < 8; i++) {
+        v[i] = h[i];
+        v[i + 8] = IV512[i];
+    }
+    v[12] ^= t;
+    if (last) v[14] = ~v[14];
+    for (int r = 0; r < 12; r++) {
+        const uint8_t *s = SIGMA[r];
+        B2_G(0, 4, 8, 12, m[s[0]], m[s[1]]);
+        B2_G(1, 5, 9, 13, m[s[2]], m[s[3]]);
+        B2_G(2, 6, 10, 14, m[s[4]], m[s[5]]);
+        B2_G(3, 7, 11, 15, m[s[6]], m[s[7]]);
+        B2_G(0, 5, 10, 15, m[s[8]], m[s[9]]);
+        B2_G(1, 6, 11, 12, m[s[10]], m[s[11]]);
+        B2_G(2, 7, 8, 13, m[s[12]], m[s[13]]);
+        B2_G(3, 4, 9, 14, m[s[14]], m[s[15]]);
+    }
+    for (int i = 0; i < 8; i++) h[i] ^= v[i] ^ v[i + 8];
+}
+
+static void blake2b_256(const uint8_t *data, size_t len, uint8_t out[32]) {
+    uint64_t h[8];
+    uint8_t block[128];
+    memcpy(h, IV512, sizeof(h));
+    h[0] ^= 0x01010000ull ^ 32;
+    size_t done = 0;
+    while (len - done > 128) {
+        blake2b_compress(h, data + done, done + 128, 0);
+        done += 128;
+    }
+    memset(block, 0, sizeof(block));
+    memcpy(block, data + done, len - done);
+    blake2b_compress(h, block, len, 1);
+    for (int i = 0; i < 4; i++) store64_le(out + 8 * i, h[i]);
+}
+
+/* ========================================================================== */
+/* Addresses                                                                   */
+/* ========================================================================== */
+
+static const char B58[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+int bloom_recover_address_payload(const char *address, uint8_t payload[20]) {
+    uint8_t raw[25] = { 0 };
+    size_t zeros = 0, len = strlen(address);
+    while (zeros < len && address[zeros] == '1') zeros++;
+
+    /* raw = big-endian base-58 value */
+    for (size_t i = 0; i < len; i++) {
+        const char *p = strchr(B58, address[i]);
+        if (!p || !address[i]) return BLOOM_RECOVER_ERR_INVALID;
+        uint32_t carry = (uint32_t)(p - B58);
+        for (int j = 24; j >= 0; j--) {
+            carry += 58u * raw[j];
+            raw[j] = (uint8_t)carry;
+            carry >>= 8;
+        }
+        if (carry) return BLOOM_RECOVER_ERR_INVALID;
+    }
+    size_t lead = 0;
+    while (lead < 25 && raw[lead] == 0) lead++;
+    if (lead != zeros || (raw[0] != 0x00 && raw[0] != 0x6F)) return BLOOM_RECOVER_ERR_INVALID;
+
+    uint8_t check[32];
+    blake2b_256(raw, 21, check);
+    blake2b_256(check, 32, check);
+    if (memcmp(check, raw + 21, 4) != 0) return BLOOM_RECOVER_ERR_INVALID;
+    memcpy(payload, raw + 1, 20);
+    return BLOOM_RECOVER_OK;
+}
+
+/* ========================================================================== */
+/* Derivation                                                                  */
+/* ========================================================================== */
+
+/* PBKDF2 first block message: "mnemonic" || passphrase || INT(1) */
+static uint8_t *make_salt(const char *passphrase, size_t *len) {
+    size_t pl = passphrase ? strlen(passphrase) : 0;
+    uint8_t *salt = (uint8_t *)malloc(8 + pl + 4);
+    if (!salt) return NULL;
+    memcpy(salt, "mnemonic", 8);
+    if (pl) memcpy(salt + 8, passphrase, pl);
+    store32_be(salt + 8 + pl, 1);
+    *len = 8 + pl + 4;
+    return salt;
+}
+
+/* Payloads of n <= LANES mnemonics */
+static void derive_lanes(const uint8_t *const *mn, const size_t *lens, size_t n,
+                         const uint8_t *salt, size_t salt_len, uint8_t (*payload)[20]) {
+    uint8_t seeds[LANES][64], pk[32], h[32];
+    pbkdf2_lanes(mn, lens, n, salt, salt_len, seeds);
+    for (size_t l = 0; l < n; l++) {
+        ed25519_public(seeds[l], pk);
+        blake2b_256(pk, 32, h);
+        memcpy(payload[l], h, 20);
+    }
+}
+
+int bloom_recover_derive(const char *mnemonic, size_t len, const char *passphrase,
+                         uint8_t seed[64], uint8_t public_key[32], uint8_t payload[20]) {
+    size_t salt_len;
+    uint8_t *salt = make_salt(passphrase, &salt_len);
+    if (!salt) return BLOOM_RECOVER_ERR_NOMEM;
+    pthread_once(&ed_once, ed_init);
+
+    const uint8_t *mn = (const uint8_t *)mnemonic;
+    uint8_t seeds[LANES][64], pk[32], h[32];
+    pbkdf2_lanes(&mn, &len, 1, salt, salt_len, seeds);
+    ed25519_public(seeds[0], pk);
+    blake2b_256(pk, 32, h);
+    if (seed) memcpy(seed, seeds[0], 64);
+    if (public_key) memcpy(public_key, pk, 32);
+    if (payload) memcpy(payload, h, 20);
+    free(salt);
+    return BLOOM_RECOVER_OK;
+}
+
+/* ========================================================================== */
+/* Search                                                                      */
+/* ========================================================================== */
+
+/* BIP39 checksum: leading words/3 bits of SHA-256(entropy) */
+static int checksum_ok(const uint16_t *w, size_t n) {
+    uint8_t bits[33] = { 0 };
+    size_t pos = 0;
+    for (size_t i = 0; i < n; i++) {
+        for (int b = 10; b >= 0; b--, pos++) {
+            if (w[i] >> b & 1) bits[pos >> 3] |= (uint8_t)(0x80 >> (pos & 7));
+        }
+    }
+    size_t ent = n * 11 * 32 / 33 / 8, cs = n / 3;
+    return (sha256_first_byte(bits, ent) >> (8 - cs)) == (bits[ent] >> (8 - cs));
+}
+
+static int query_valid(const bloom_recover_query *q) {
+    if (!q->wordlist || q->n_words < 12 || q->n_words > 24 || q->n_words % 3) return 0;
+    for (size_t i = 0; i < BLOOM_RECOVER_WORDS; i++) {
+        if (!q->wordlist[i]) return 0;
+    }
+    for (size_t i = 0; i < q->n_words; i++) {
+        int16_t w = q->words[i];
+        if (w != BLOOM_RECOVER_UNKNOWN && (w < 0 || w >= BLOOM_RECOVER_WORDS)) return 0;
+        if (w == BLOOM_RECOVER_UNKNOWN && q->choices[i]) {
+            if (q->n_choices[i] == 0) return 0;
+            for (size_t c = 0; c < q->n_choices[i]; c++) {
+                if (q->choices[i][c] >= BLOOM_RECOVER_WORDS) return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+uint64_t bloom_recover_space(const bloom_recover_query *q) {
+    uint64_t space = 1;
+    for (size_t i = 0; i < q->n_words && i < BLOOM_RECOVER_MAX_WORDS; i++) {
+        if (q->words[i] != BLOOM_RECOVER_UNKNOWN) continue;
+        uint64_t r = q->choices[i] ? q->n_choices[i] : BLOOM_RECOVER_WORDS;
+        if (r && space > UINT64_MAX / r) return UINT64_MAX;
+        space *= r;
+    }
+    return space;
+}
+
+double bloom_recover_eta(const bloom_recover_query *q, double rate) {
+    uint64_t space = bloom_recover_space(q);
+    return rate > 0 ? (double)space / (double)(1u << (q->n_words / 3)) / rate : 0;
+}
+
+/* Mnemonic text of word indices; returns its length */
+static size_t join_words(const bloom_recover_query *q, const uint16_t *w, const size_t *wlen,
+                         uint8_t *out) {
+    size_t len = 0;
+    for (size_t i = 0; i < q->n_words; i++) {
+        if (i) out[len++] = ' ';
+        memcpy(out + len, q->wordlist[w[i]], wlen[w[i]]);
+        len += wlen[w[i]];
+    }
+    return len;
+}
+
+int bloom_recover_search(const bloom_recover_query *q, bloom_recover_result *res) {
+    memset(res, 0, sizeof(*res));
+    if (!query_valid(q)) return BLOOM_RECOVER_ERR_INVALID;
+    uint64_t space = bloom_recover_space(q);
+    if (space == UINT64_MAX) return BLOOM_RECOVER_ERR_INVALID;
+
+    size_t wlen[BLOOM_RECOVER_WORDS], longest = 0;
+    for (size_t i = 0; i < BLOOM_RECOVER_WORDS; i++) {
+        wlen[i] = strlen(q->wordlist[i]);
+        if (wlen[i] > longest) longest = wlen[i];
+    }
+    if (q->n_words * (longest + 1) > MAX_MNEMONIC) return BLOOM_RECOVER_ERR_INVALID;
+
+    size_t pos[BLOOM_RECOVER_MAX_WORDS], n_unknown = 0;
+    for (size_t i = 0; i < q->n_words; i++) {
+        if (q->words[i] == BLOOM_RECOVER_UNKNOWN) pos[n_unknown++] = i;
+    }
+
+    size_t salt_len;
+    uint8_t *salt = make_salt(q->passphrase, &salt_len);
+    if (!salt) return BLOOM_RECOVER_ERR_NOMEM;
+    pthread_once(&ed_once, ed_init);
+
+    int found = 0;
+    uint64_t enumerated = 0, derived = 0;
+    long long n_blocks = (long long)((space + SEARCH_BLOCK - 1) / SEARCH_BLOCK);
+    double t0 = now_sec();
+
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+        uint8_t text[LANES][MAX_MNEMONIC], payload[LANES][20];
+        const uint8_t *mn[LANES];
+        size_t lens[LANES], batch = 0;
+        uint16_t w[BLOOM_RECOVER_MAX_WORDS], batch_w[LANES][BLOOM_RECOVER_MAX_WORDS];
+        uint64_t my_enum = 0, my_derived = 0;
+        for (size_t i = 0; i < q->n_words; i++) w[i] = (uint16_t)q->words[i];
+        for (int l = 0; l < LANES; l++) mn[l] = text[l];
+
+#ifdef _OPENMP
+        #pragma omp for schedule(dynamic)
+#endif
+        for (long long b = 0; b < n_blocks; b++) {
+            int stop;
+#ifdef _OPENMP
+            #pragma omp atomic read
+#endif
+            stop = found;
+            if (stop) continue;
+
+            uint64_t from = (uint64_t)b * SEARCH_BLOCK;
+            uint64_t to = space - from < SEARCH_BLOCK ? space : from + SEARCH_BLOCK;
+            for (uint64_t c = from; c <= to; c++) {
+                /* Flush a full batch, or the partial one at the end */
+                if (batch == LANES || (c == to && batch)) {
+                    derive_lanes(mn, lens, batch, salt, salt_len, payload);
+                    my_derived += batch;
+                    for (size_t l = 0; l < batch; l++) {
+                        if (memcmp(payload[l], q->target, 20) != 0) continue;
+#ifdef _OPENMP
+                        #pragma omp critical
+#endif
+                        {
+                            if (!found) memcpy(res->words, batch_w[l], sizeof(res->words));
+                            found = 1;
+                        }
+                    }
+                    batch = 0;
+                }
+                if (c == to) break;
+
+                uint64_t rest = c;
+                for (size_t u = 0; u < n_unknown; u++) {
+                    size_t p = pos[u];
+                    uint64_t r = q->choices[p] ? q->n_choices[p] : BLOOM_RECOVER_WORDS;
+                    uint64_t digit = rest % r;
+                    rest /= r;
+                    w[p] = q->choices[p] ? q->choices[p][digit] : (uint16_t)digit;
+                }
+                my_enum++;
+                if (!checksum_ok(w, q->n_words)) continue;
+                memcpy(batch_w[batch], w, sizeof(w));
+                lens[batch] = join_words(q, w, wlen, text[batch]);
+                batch++;
+            }
+        }
+#ifdef _OPENMP
+        #pragma omp atomic
+#endif
+        enumerated += my_enum;
+#ifdef _OPENMP
+        #pragma omp atomic
+#endif
+        derived += my_derived;
+    }
+
+    res->enumerated = enumerated;
+    res->derived = derived;
+    res->seconds = now_sec() - t0;
+    free(salt);
+    return found ? BLOOM_RECOVER_FOUND : BLOOM_RECOVER_OK;
+}
+
+double bloom_recover_benchmark(double seconds) {
+    static const uint8_t salt[12] = { 'm', 'n', 'e', 'm', 'o', 'n', 'i', 'c', 0, 0, 0, 1 };
+    uint64_t total = 0;
+    double t0 = now_sec(), elapsed;
+    pthread_once(&ed_once, ed_init);
+
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+        uint8_t text[LANES][96], payload[LANES][20];
+        const uint8_t *mn[LANES];
+        size_t lens[LANES];
+        uint64_t mine = 0;
+        for (int l = 0; l < LANES; l++) {
+            memset(text[l], 'a' + l, sizeof(text[l]));
+            mn[l] = text[l];
+            lens[l] = sizeof(text[l]);
+        }
+        do {
+            derive_lanes(mn, lens, LANES, salt, sizeof(salt), payload);
+            mine += LANES;
+        } while (now_sec() - t0 < seconds);
+#ifdef _OPENMP
+        #pragma omp atomic
+#endif
+        total += mine;
+    }
+    elapsed = now_sec() - t0;
+    return elapsed > 0 ? (double)total / elapsed : 0;
+}
+
+/* ========================================================================== */
+/* Default Wordlist                                                            */
+/* ========================================================================== */
+
+#if defined(TEST_MAIN) || defined(RECOVER_MAIN)
+#include <stdio.h>
+
+/* keypair.py BIP39_WORDLIST; BIP39_WORDLIST_FULL continues with "word<i>" */
+static const char *const LISTED[256] = {
+    "abandon", "ability", "able", "about", "above", "absent", "absorb", "abstract", "absurd",
+    "abuse", "access", "accident", "account", "accuse", "achieve", "acid", "acoustic",
+    "acquire", "across", "act", "action", "actor", "actress", "actual", "adapt", "add",
+    "addict", "address", "adjust", "admit", "adult", "advance", "advice", "aerobic", "affair",
+    "afford", "afraid", "again", "age", "agent", "agree", "ahead", "aim", "air", "airport",
+    "aisle", "alarm", "album", "alcohol", "alert", "alien", "all", "alley", "allow", "almost",
+    "alone", "alpha", "already", "also", "alter", "always", "amateur", "amazing", "among",
+    "amount", "amused", "analyst", "anchor", "ancient", "anger", "angle", "angry", "animal",
+    "ankle", "announce", "annual", "another", "answer", "antenna", "antique", "anxiety", "any",
+    "apart", "apology", "appear", "apple", "approve", "april", "arch", "arctic", "area",
+    "arena", "argue", "arm", "armed", "armor", "army", "around", "arrange", "arrest", "arrive",
+    "arrow", "art", "artefact", "artist", "artwork", "ask", "aspect", "assault", "asset",
+    "assist", "assume", "asthma", "athlete", "atom", "attack", "attend", "attitude", "attract",
+    "auction", "audit", "august", "aunt", "author", "auto", "autumn", "average", "avocado",
+    "avoid", "awake", "aware", "away", "awesome", "awful", "awkward", "axis", "baby",
+    "bachelor", "bacon", "badge", "bag", "balance", "balcony", "ball", "bamboo", "banana",
+    "banner", "bar", "barely", "bargain", "barrel", "base", "basic", "basket", "battle",
+    "beach", "bean", "beauty", "because", "become", "beef", "before", "begin", "behave",
+    "behind", "believe", "below", "belt", "bench", "benefit", "best", "betray", "better",
+    "between", "beyond", "bicycle", "bid", "bike", "bind", "biology", "bird", "birth", "bitter",
+    "black", "blade", "blame", "blanket", "blast", "bleak", "bless", "blind", "blood",
+    "blossom", "blouse", "blue", "blur", "blush", "board", "boat", "body", "boil", "bomb",
+    "bone", "bonus", "book", "boost", "border", "boring", "borrow", "boss", "bottom", "bounce",
+    "box", "boy", "bracket", "brain", "brand", "brass", "brave", "bread", "breeze", "brick",
+    "bridge", "brief", "bright", "bring", "brisk", "broccoli", "broken", "bronze", "broom",
+    "brother", "brown", "brush", "bubble", "buddy", "budget", "buffalo", "build", "bulb",
+    "bulk", "bullet", "bundle", "bunker", "burden", "burger", "burst", "bus", "business",
+    "busy", "butter", "buyer", "buzz", "cabbage", "cabin", "cable"
+};
+
+static const char *wordlist[BLOOM_RECOVER_WORDS];
+static char filler[BLOOM_RECOVER_WORDS][12];
+
+/* BIP39_WORDLIST_FULL as load_full_wordlist() builds it */
+static void default_wordlist(void) {
+    for (int i = 0; i < BLOOM_RECOVER_WORDS; i++) {
+        if (i < 256) {
+            wordlist[i] = LISTED[i];
+        } else {
+            snprintf(filler[i], sizeof(filler[i]), "word%d", i);
+            wordlist[i] = filler[i];
+        }
+    }
+}
+
+static int index_of(const char *word) {
+    for (int i = 0; i < BLOOM_RECOVER_WORDS; i++) {
+        if (strcmp(wordlist[i], word) == 0) return i;
+    }
+    return -1;
+}
+#endif
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+
+static void hex(const char *s, uint8_t *out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        unsigned v;
+        sscanf(s + 2 * i, "%2x", &v);
+        out[i] = (uint8_t)v;
+    }
+}
+
+/* Query for a mnemonic with the words at `unknown` positions blanked */
+static void make_query(bloom_recover_query *q, const char *mnemonic, const int *unknown,
+                       int n_unknown, const char *passphrase, const uint8_t target[20]) {
+    char buf[512], *save = NULL;
+    memset(q, 0, sizeof(*q));
+    q->wordlist = wordlist;
+    q->passphrase = passphrase;
+    memcpy(q->target, target, 20);
+    strcpy(buf, mnemonic);
+    for (char *t = strtok_r(buf, " ", &save); t; t = strtok_r(NULL, " ", &save)) {
+        q->words[q->n_words++] = (int16_t)index_of(t);
+    }
+    for (int i = 0; i < n_unknown; i++) q->words[unknown[i]] = BLOOM_RECOVER_UNKNOWN;
+}
+
+int main(void) {
+    int fail = 0, ok;
+    printf("BloomCoin Mnemonic Recovery Search (%d lanes)\n", LANES);
+    printf("=============================================\n\n");
+
+    default_wordlist();
+
+    /* Primitives against known answers */
+    {
+        uint8_t d[64], want[64], pk[32];
+        sha512((const uint8_t *)"abc", 3, d);
+        hex("ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+            "2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f", want, 64);
+        ok = memcmp(d, want, 64) == 0;
+        blake2b_256((const uint8_t *)"abc", 3, d);
+        hex("bddd813c634239723171ef3fee98579b94964e3bb1cb3e427262c8c068d52319", want, 32);
+        ok &= memcmp(d, want, 32) == 0;
+        pthread_once(&ed_once, ed_init);
+        hex("9d61b19deffd5a60ba844af492ec2cc44449c5697b326919703bac031cae7f60", d, 32);
+        ed25519_public(d, pk);
+        hex("d75a980182b10ab7d54bfed3c964073a0ee172f3daa62325af021a68f707511a", want, 32);
+        ok &= memcmp(pk, want, 32) == 0;
+        printf("primitives:               %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Whole derivation against the Python wallet */
+    const char *m12 = "absurd avoid word1544 anxiety word771 word1056 word289 word523 army "
+                      "word835 word1054 word261";
+    const char *m24 = "alpha word514 word532 bid word1542 word1080 word482 acquire bamboo "
+                      "word1221 aim word353 word908 arrive word835 word796 brown word1927 "
+                      "word1600 word530 word273 word1168 word1188 word1742";
+    uint8_t target12[20], target24[20];
+    {
+        uint8_t seed[64], pk[32], payload[20], want[64];
+        ok = bloom_recover_address_payload("1FZj86MZmPhWuLP1MSW3t3LVQ3vNYzsA2S", target12) == 0 &&
+             bloom_recover_address_payload("18izWci8G412X17Py38XMRQRsx8agX6hqw", target24) == 0 &&
+             bloom_recover_address_payload("1FZj86MZmPhWuLP1MSW3t3LVQ3vNYzsA2T", payload) ==
+                 BLOOM_RECOVER_ERR_INVALID;
+        bloom_recover_derive(m12, strlen(m12), "", seed, pk, payload);
+        hex("885ea7107d6e4e6d83fd1a9c7a5f9f62afe91cd426e1f5cbde82a5b7680550d2"
+            "145a163b941b1336e9fb9a9e05bae5e203bf554f05fae145bbd8336a52c24cc2", want, 64);
+        ok &= memcmp(seed, want, 64) == 0 && memcmp(payload, target12, 20) == 0;
+        hex("7e0ff53049d53cf0a49624f420a5ae6ae79034c069c3d611e49412eb96fc6156", want, 32);
+        ok &= memcmp(pk, want, 32) == 0;
+        bloom_recover_derive(m24, strlen(m24), "bloom", seed, pk, payload);
+        hex("e6c83f869069eb047aae3160c39c1c3f85e01100b2696292ae725a908040bcf5"
+            "c9dcea98819928b63140aaef0022c699302d7532f49753d5893241ec7ed76209", want, 64);
+        ok &= memcmp(seed, want, 64) == 0 && memcmp(payload, target24, 20) == 0;
+        printf("wallet derivation:        %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Lanes agree with single derivations */
+    {
+        const char *texts[LANES];
+        static const char *const pool[4] = { "alpha beta", "gamma", "a much longer phrase "
+            "that goes well past one hundred and twenty eight bytes so the hmac key is hashed "
+            "first, as pbkdf2 requires for long passwords", "" };
+        const uint8_t *mn[LANES];
+        size_t lens[LANES];
+        uint8_t payload[LANES][20], one[20];
+        for (int l = 0; l < LANES; l++) {
+            texts[l] = pool[l % 4];
+            mn[l] = (const uint8_t *)texts[l];
+            lens[l] = strlen(texts[l]);
+        }
+        derive_lanes(mn, lens, LANES, (const uint8_t *)"mnemonic\0\0\0\1", 12, payload);
+        ok = 1;
+        for (int l = 0; l < LANES; l++) {
+            bloom_recover_derive(texts[l], lens[l], NULL, NULL, NULL, one);
+            ok &= memcmp(one, payload[l], 20) == 0;
+        }
+        printf("lanes vs single:          %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    double rate = bloom_recover_benchmark(1.0);
+    printf("derivation rate:          %.0f mnemonics/s\n", rate);
+
+    /* Two lost words; the second remembered as one of 32 */
+    {
+        bloom_recover_query q;
+        bloom_recover_result res;
+        int unknown[2] = { 2, 7 };
+        uint16_t choices[32];
+        make_query(&q, m12, unknown, 2, "", target12);
+        for (int i = 0; i < 32; i++) choices[i] = (uint16_t)(511 + i);
+        q.choices[7] = choices;
+        q.n_choices[7] = 32;
+        printf("  2 words, 1 of 32:       %llu candidates, estimated %.1f s\n",
+               (unsigned long long)bloom_recover_space(&q), bloom_recover_eta(&q, rate));
+        int st = bloom_recover_search(&q, &res);
+        ok = st == BLOOM_RECOVER_FOUND && res.words[2] == 1544 && res.words[7] == 523;
+        printf("two-word recovery:        %llu enumerated, %llu derived, %.1f s  %s\n",
+               (unsigned long long)res.enumerated, (unsigned long long)res.derived,
+               res.seconds, ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* One lost word of a passphrase wallet; wrong target finds nothing */
+    {
+        bloom_recover_query q;
+        bloom_recover_result res;
+        int unknown[1] = { 23 };
+        make_query(&q, m24, unknown, 1, "bloom", target24);
+        int st = bloom_recover_search(&q, &res);
+        ok = st == BLOOM_RECOVER_FOUND && res.words[23] == 1742;
+        q.target[0] ^= 1;
+        st = bloom_recover_search(&q, &res);
+        ok &= st == BLOOM_RECOVER_OK && res.enumerated == 2048 && res.derived == 2048 / 256;
+        q.n_words = 13;
+        ok &= bloom_recover_search(&q, &res) == BLOOM_RECOVER_ERR_INVALID;
+        printf("last word / no match:     %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* What a support ticket would see before starting */
+    {
+        bloom_recover_query q;
+        int unknown[2] = { 3, 9 };
+        make_query(&q, m12, unknown, 2, "", target12);
+        printf("  2 words of 12, no hints: %llu candidates, estimated %.0f s on this machine\n",
+               (unsigned long long)bloom_recover_space(&q), bloom_recover_eta(&q, rate));
+    }
+
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
+
+/* ========================================================================== */
+/* Command Line                                                                */
+/* ========================================================================== */
+
+#ifdef RECOVER_MAIN
+
+static int usage(void) {
+    fprintf(stderr,
+            "usage: bloom_recover [-p passphrase] [-w wordlist] [-n] ADDRESS WORD...\n"
+            "  WORD      a known word, ? for a lost word, pre* for a lost word\n"
+            "            starting with pre\n"
+            "  -p        wallet passphrase (default none)\n"
+            "  -w        file with the 2048 words, one per line (default: the\n"
+            "            BIP39_WORDLIST_FULL of bloomcoin/wallet/keypair.py)\n"
+            "  -n        print the search space and estimate, do not search\n");
+    return 2;
+}
+
+/* One word per line; returns 0 when exactly 2048 were read */
+static int load_wordlist(const char *path) {
+    static char words[BLOOM_RECOVER_WORDS][64];
+    char line[256];
+    int n = 0;
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    while (fgets(line, sizeof(line), f)) {
+        size_t len = strcspn(line, "\r\n");
+        if (len == 0) continue;
+        if (n == BLOOM_RECOVER_WORDS || len >= sizeof(words[0])) {
+            n = -1;
+            break;
+        }
+        memcpy(words[n], line, len);
+        words[n][len] = 0;
+        wordlist[n] = words[n];
+        n++;
+    }
+    fclose(f);
+    return n == BLOOM_RECOVER_WORDS ? 0 : -1;
+}
+
+static void print_time(const char *label, double sec) {
+    if (sec < 120) printf("%s%.1f s\n", label, sec);
+    else if (sec < 7200) printf("%s%.1f min\n", label, sec / 60);
+    else if (sec < 172800) printf("%s%.1f h\n", label, sec / 3600);
+    else printf("%s%.1f days\n", label, sec / 86400);
+}
+
+int main(int argc, char **argv) {
+    static uint16_t choices[BLOOM_RECOVER_MAX_WORDS][BLOOM_RECOVER_WORDS];
+    const char *passphrase = "", *list = NULL;
+    int dry_run = 0, i = 1;
+    bloom_recover_query q;
+    bloom_recover_result res;
+
+    for (; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+        if (!strcmp(argv[i], "-n")) dry_run = 1;
+        else if (!strcmp(argv[i], "-p") && i + 1 < argc) passphrase = argv[++i];
+        else if (!strcmp(argv[i], "-w") && i + 1 < argc) list = argv[++i];
+        else return usage();
+    }
+    if (argc - i < 2 || argc - i - 1 > BLOOM_RECOVER_MAX_WORDS) return usage();
+
+    default_wordlist();
+    if (list && load_wordlist(list) != 0) {
+        fprintf(stderr, "%s: expected %d words, one per line\n", list, BLOOM_RECOVER_WORDS);
+        return 2;
+    }
+
+    memset(&q, 0, sizeof(q));
+    q.wordlist = wordlist;
+    q.passphrase = passphrase;
+    if (bloom_recover_address_payload(argv[i++], q.target) != BLOOM_RECOVER_OK) {
+        fprintf(stderr, "%s: not a valid address\n", argv[i - 1]);
+        return 2;
+    }
+    for (; i < argc; i++) {
+        const char *w = argv[i];
+        size_t len = strlen(w), k = q.n_words++;
+        if (!strcmp(w, "?")) {
+            q.words[k] = BLOOM_RECOVER_UNKNOWN;
+        } else if (len > 1 && w[len - 1] == '*') {
+            size_t n = 0;
+            for (int j = 0; j < BLOOM_RECOVER_WORDS; j++) {
+                if (!strncmp(wordlist[j], w, len - 1)) choices[k][n++] = (uint16_t)j;
+            }
+            if (n == 0) {
+                fprintf(stderr, "no word starts with \"%.*s\"\n", (int)(len - 1), w);
+                return 2;
+            }
+            q.words[k] = BLOOM_RECOVER_UNKNOWN;
+            q.choices[k] = choices[k];
+            q.n_choices[k] = n;
+        } else if ((q.words[k] = (int16_t)index_of(w)) < 0) {
+            fprintf(stderr, "\"%s\" is not in the wordlist\n", w);
+            return 2;
+        }
+    }
+    if (q.n_words % 3 || q.n_words < 12) {
+        fprintf(stderr, "a mnemonic has 12, 15, 18, 21 or 24 words, not %zu\n", q.n_words);
+        return 2;
+    }
+
+    int threads = 1;
+#ifdef _OPENMP
+    threads = omp_get_max_threads();
+#endif
+    uint64_t space = bloom_recover_space(&q);
+    double rate = bloom_recover_benchmark(1.0);
+    if (space == UINT64_MAX) printf("search space:    more than 2^64 candidates\n");
+    else printf("search space:    %llu candidates, ~%.0f pass the checksum\n",
+                (unsigned long long)space, (double)space / (double)(1u << (q.n_words / 3)));
+    printf("rate:            %.0f derivations/s (%d lanes x %d threads)\n",
+           rate, LANES, threads);
+    print_time("estimated time:  ", bloom_recover_eta(&q, rate));
+    if (dry_run) return 0;
+    fflush(stdout);
+
+    int st = bloom_recover_search(&q, &res);
+    if (st < 0) {
+        fprintf(stderr, "search failed (%d)\n", st);
+        return 2;
+    }
+    printf("checked:         %llu candidates, %llu derived\n",
+           (unsigned long long)res.enumerated, (unsigned long long)res.derived);
+    print_time("elapsed:         ", res.seconds);
+    if (st != BLOOM_RECOVER_FOUND) {
+        printf("no match\n");
+        return 1;
+    }
+    printf("mnemonic:       ");
+    for (size_t k = 0; k < q.n_words; k++) printf(" %s", wordlist[res.words[k]]);
+    printf("\n");
+    return 0;
+}
+#endif /* RECOVER_MAIN */
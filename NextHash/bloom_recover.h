@@ -0,0 +1,92 @@
+/*
+ * BloomCoin Mnemonic Recovery Search
+ * ==================================
+ *
+ * Recovers BIP39 mnemonics with missing words for wallets created by
+ * bloomcoin/wallet/keypair.py: candidate words at the unknown positions
+ * are enumerated, filtered by the mnemonic checksum, and every survivor is
+ * derived to an address and compared with the wallet's known address.
+ *
+ * Derivation as in the Python wallet:
+ *   seed    = PBKDF2-HMAC-SHA512(mnemonic, "mnemonic" + passphrase, 2048, 64)
+ *   public  = Ed25519 public key of seed[0..32]
+ *   payload = Blake2b-256(public)[0..20]   (address without version/checksum)
+ *
+ * Features:
+ * - Checksum (SHA-256 of the entropy) tested before any key stretching;
+ *   passes 1 in 2^(words / 3) candidates
+ * - PBKDF2 iterations for four candidates at once in AVX2 lanes
+ *   (scalar fallback), candidate blocks spread over all cores with OpenMP
+ * - Ed25519 base point multiplication from a table of 2^i B
+ * - Per-position candidate lists ("starts with b") shrink the search space
+ * - Measured derivation rate and time estimate before a search
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef BLOOM_RECOVER_H
+#define BLOOM_RECOVER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLOOM_RECOVER_WORDS     2048
+#define BLOOM_RECOVER_MAX_WORDS 24
+#define BLOOM_RECOVER_UNKNOWN   -1
+
+/* Status codes */
+#define BLOOM_RECOVER_FOUND          1
+#define BLOOM_RECOVER_OK             0
+#define BLOOM_RECOVER_ERR_NOMEM     -1
+#define BLOOM_RECOVER_ERR_INVALID   -2   /* bad query, word count or address */
+
+typedef struct {
+    const char *const *wordlist;                /* BIP39_WORDLIST_FULL, 2048 words */
+    size_t n_words;                             /* 12, 15, 18, 21 or 24 */
+    int16_t words[BLOOM_RECOVER_MAX_WORDS];     /* word index, or BLOOM_RECOVER_UNKNOWN */
+    /* Optional candidates for an unknown position; NULL = all 2048 */
+    const uint16_t *choices[BLOOM_RECOVER_MAX_WORDS];
+    size_t n_choices[BLOOM_RECOVER_MAX_WORDS];
+    const char *passphrase;                     /* NULL = "" */
+    uint8_t target[20];                         /* address payload */
+} bloom_recover_query;
+
+typedef struct {
+    uint16_t words[BLOOM_RECOVER_MAX_WORDS];    /* recovered word indices */
+    uint64_t enumerated;                        /* candidates generated */
+    uint64_t derived;                           /* passed the checksum */
+    double seconds;
+} bloom_recover_result;
+
+/* Address payload of a Base58Check address; checks version and checksum */
+int bloom_recover_address_payload(const char *address, uint8_t payload[20]);
+
+/* Full derivation of one mnemonic; any output may be NULL */
+int bloom_recover_derive(const char *mnemonic, size_t len, const char *passphrase,
+                         uint8_t seed[64], uint8_t public_key[32], uint8_t payload[20]);
+
+/* Candidates the query enumerates; UINT64_MAX if it does not fit */
+uint64_t bloom_recover_space(const bloom_recover_query *q);
+
+/* Derivations per second on all cores, measured over about `seconds` */
+double bloom_recover_benchmark(double seconds);
+
+/* Expected seconds to exhaust the query at `rate` derivations per second */
+double bloom_recover_eta(const bloom_recover_query *q, double rate);
+
+/*
+ * Search the query. Returns BLOOM_RECOVER_FOUND with res->words filled,
+ * BLOOM_RECOVER_OK if no candidate matches, or a negative status code.
+ */
+int bloom_recover_search(const bloom_recover_query *q, bloom_recover_result *res);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOOM_RECOVER_H */
@@ -0,0 +1,449 @@
+/*
+ * BloomCoin Validator Sampler
+ * ===========================
+ *
+ * Compile: gcc -O3 -c nexthash256.c nexthash_rng.c
+ *          gcc -O3 -o bloom_sampler bloom_sampler.c nexthash_rng.o nexthash256.o -lm -DTEST_MAIN
+ */
+
+#include "bloom_sampler.h"
+#include "nexthash256.h"
+#include "nexthash_rng.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Removed weights held during one draw, kept inline up to this many */
+#define INLINE_REMOVED 64
+
+struct bloom_sampler {
+    size_t n, cap;                  /* cap is a power of two */
+    uint64_t *tree;                 /* Fenwick tree, 1-based, cap + 1 */
+    bloom_sampler_node *nodes;
+    uint64_t total;
+};
+
+/* ========================================================================== */
+/* Fenwick Tree                                                                */
+/* ========================================================================== */
+
+/* Wrapping add: a negative delta is its two's complement */
+static void tree_add(bloom_sampler *s, uint32_t index, uint64_t delta) {
+    for (size_t i = (size_t)index + 1; i <= s->cap; i += i & (0 - i)) s->tree[i] += delta;
+    s->total += delta;
+}
+
+/* Smallest index whose prefix sum exceeds target (target < total) */
+static uint32_t tree_find(const bloom_sampler *s, uint64_t target) {
+    size_t pos = 0;
+    for (size_t step = s->cap; step; step >>= 1) {
+        if (pos + step <= s->cap && s->tree[pos + step] <= target) {
+            pos += step;
+            target -= s->tree[pos];
+        }
+    }
+    return (uint32_t)pos;
+}
+
+/* Rebuild over a new capacity in O(cap) */
+static int tree_grow(bloom_sampler *s, size_t cap) {
+    uint64_t *tree = (uint64_t *)calloc(cap + 1, sizeof(uint64_t));
+    bloom_sampler_node *nodes =
+        (bloom_sampler_node *)realloc(s->nodes, cap * sizeof(bloom_sampler_node));
+    if (nodes) s->nodes = nodes;
+    if (!tree || !nodes) {
+        free(tree);
+        return BLOOM_SAMPLER_ERR_NOMEM;
+    }
+    for (size_t i = 1; i <= s->n; i++) {
+        tree[i] += s->nodes[i - 1].weight;
+        size_t up = i + (i & (0 - i));
+        if (up <= cap) tree[up] += tree[i];
+    }
+    free(s->tree);
+    s->tree = tree;
+    s->cap = cap;
+    return BLOOM_SAMPLER_OK;
+}
+
+/* ========================================================================== */
+/* Validators                                                                  */
+/* ========================================================================== */
+
+bloom_sampler *bloom_sampler_create(void) {
+    bloom_sampler *s = (bloom_sampler *)calloc(1, sizeof(*s));
+    if (!s) return NULL;
+    if (tree_grow(s, 1024) != BLOOM_SAMPLER_OK) {
+        free(s);
+        return NULL;
+    }
+    return s;
+}
+
+void bloom_sampler_destroy(bloom_sampler *s) {
+    if (!s) return;
+    free(s->tree);
+    free(s->nodes);
+    free(s);
+}
+
+int bloom_sampler_register(bloom_sampler *s, uint32_t *index) {
+    if (s->n >= BLOOM_SAMPLER_MAX) return BLOOM_SAMPLER_ERR_NOMEM;
+    if (s->n == s->cap && tree_grow(s, s->cap * 2) != BLOOM_SAMPLER_OK) {
+        return BLOOM_SAMPLER_ERR_NOMEM;
+    }
+    uint32_t i = (uint32_t)s->n++;
+    bloom_sampler_node node = { 0, 0, 0 };
+    s->nodes[i] = node;
+    tree_add(s, i, BLOOM_SAMPLER_DEFAULT);
+    s->nodes[i].weight = BLOOM_SAMPLER_DEFAULT;
+    if (index) *index = i;
+    return BLOOM_SAMPLER_OK;
+}
+
+size_t bloom_sampler_count(const bloom_sampler *s) {
+    return s->n;
+}
+
+uint64_t bloom_sampler_total(const bloom_sampler *s) {
+    return s->total;
+}
+
+int bloom_sampler_get(const bloom_sampler *s, uint32_t index, bloom_sampler_node *out) {
+    if (index >= s->n) return BLOOM_SAMPLER_ERR_INVALID;
+    *out = s->nodes[index];
+    return BLOOM_SAMPLER_OK;
+}
+
+int bloom_sampler_set(bloom_sampler *s, uint32_t index, uint64_t weight) {
+    if (index >= s->n || weight > BLOOM_SAMPLER_ONE) return BLOOM_SAMPLER_ERR_INVALID;
+    tree_add(s, index, weight - s->nodes[index].weight);
+    s->nodes[index].weight = weight;
+    return BLOOM_SAMPLER_OK;
+}
+
+int bloom_sampler_update(bloom_sampler *s, uint32_t index, int success) {
+    if (index >= s->n) return BLOOM_SAMPLER_ERR_INVALID;
+    bloom_sampler_node *node = &s->nodes[index];
+    uint64_t w = node->weight;
+    node->validations_performed++;
+    if (success) {
+        node->successful_validations++;
+        w = w + BLOOM_SAMPLER_STEP < BLOOM_SAMPLER_ONE ? w + BLOOM_SAMPLER_STEP : BLOOM_SAMPLER_ONE;
+    } else {
+        w = w > BLOOM_SAMPLER_STEP ? w - BLOOM_SAMPLER_STEP : 0;
+    }
+    return bloom_sampler_set(s, index, w);
+}
+
+/* ========================================================================== */
+/* Draws                                                                       */
+/* ========================================================================== */
+
+typedef struct {
+    uint32_t index;
+    uint64_t weight;
+} removed_entry;
+
+/* Take index out of the tree, remembering its weight */
+static void take_out(bloom_sampler *s, uint32_t index, removed_entry *removed, size_t *n) {
+    uint64_t w = s->nodes[index].weight;
+    if (w == 0) return;
+    tree_add(s, index, 0 - w);
+    s->nodes[index].weight = 0;
+    removed[*n].index = index;
+    removed[*n].weight = w;
+    (*n)++;
+}
+
+uint32_t bloom_sampler_pick(const bloom_sampler *s, uint64_t r) {
+    return tree_find(s, (uint64_t)(((unsigned __int128)r * s->total) >> 64));
+}
+
+int bloom_sampler_draw(bloom_sampler *s, const uint8_t *seed, size_t seed_len,
+                       const uint32_t *exclude, size_t n_exclude,
+                       uint32_t k, uint32_t *out) {
+    removed_entry inline_removed[INLINE_REMOVED];
+    removed_entry *removed = inline_removed;
+    size_t n_removed = 0;
+
+    if (k > INT_MAX) return BLOOM_SAMPLER_ERR_INVALID;
+    if (n_exclude + k > INLINE_REMOVED) {
+        removed = (removed_entry *)malloc((n_exclude + k) * sizeof(removed_entry));
+        if (!removed) return BLOOM_SAMPLER_ERR_NOMEM;
+    }
+    for (size_t e = 0; e < n_exclude; e++) {
+        if (exclude[e] < s->n) take_out(s, exclude[e], removed, &n_removed);
+    }
+
+    /* Stream keyed by NEXTHASH-256(seed); pick j uses words 2j, 2j + 1 */
+    uint8_t digest[32];
+    uint32_t key[8], w[NEXTHASH_RNG_BLOCK];
+    nexthash256(seed, seed_len, digest);
+    for (int i = 0; i < 8; i++) {
+        key[i] = (uint32_t)digest[4 * i] | (uint32_t)digest[4 * i + 1] << 8 |
+                 (uint32_t)digest[4 * i + 2] << 16 | (uint32_t)digest[4 * i + 3] << 24;
+    }
+
+    uint32_t drawn = 0;
+    for (; drawn < k && s->total > 0; drawn++) {
+        uint32_t slot = (2 * drawn) % NEXTHASH_RNG_BLOCK;
+        if (slot == 0) nexthash_rng_block(key, 2 * (uint64_t)drawn / NEXTHASH_RNG_BLOCK, w);
+        uint64_t r = (uint64_t)w[slot] | (uint64_t)w[slot + 1] << 32;
+        uint32_t v = bloom_sampler_pick(s, r);
+        out[drawn] = v;
+        take_out(s, v, removed, &n_removed);
+    }
+
+    while (n_removed) {
+        n_removed--;
+        tree_add(s, removed[n_removed].index, removed[n_removed].weight);
+        s->nodes[removed[n_removed].index].weight = removed[n_removed].weight;
+    }
+    if (removed != inline_removed) free(removed);
+    return (int)drawn;
+}
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+static uint64_t test_rng = 0x2545F4914F6CDD1Dull;
+
+static uint64_t xorshift(void) {
+    test_rng ^= test_rng << 13;
+    test_rng ^= test_rng >> 7;
+    test_rng ^= test_rng << 17;
+    return test_rng;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Reference draw by linear scans over a weight copy: same stream, same
+ * targets, so it must pick the same validators
+ */
+static int linear_draw(uint64_t *weights, size_t n, const uint8_t *seed, size_t seed_len,
+                       const uint32_t *exclude, size_t n_exclude, uint32_t k, uint32_t *out) {
+    uint8_t digest[32];
+    uint32_t key[8], w[2];
+    uint64_t total = 0;
+    for (size_t e = 0; e < n_exclude; e++) {
+        if (exclude[e] < n) weights[exclude[e]] = 0;
+    }
+    for (size_t i = 0; i < n; i++) total += weights[i];
+    nexthash256(seed, seed_len, digest);
+    for (int i = 0; i < 8; i++) {
+        key[i] = (uint32_t)digest[4 * i] | (uint32_t)digest[4 * i + 1] << 8 |
+                 (uint32_t)digest[4 * i + 2] << 16 | (uint32_t)digest[4 * i + 3] << 24;
+    }
+
+    uint32_t drawn = 0;
+    for (; drawn < k && total > 0; drawn++) {
+        nexthash_rng_fill_at(key, 2 * (uint64_t)drawn, w, 2);
+        uint64_t r = (uint64_t)w[0] | (uint64_t)w[1] << 32;
+        uint64_t target = (uint64_t)(((unsigned __int128)r * total) >> 64), acc = 0;
+        size_t i = 0;
+        while (acc + weights[i] <= target) acc += weights[i++];
+        out[drawn] = (uint32_t)i;
+        total -= weights[i];
+        weights[i] = 0;
+    }
+    return (int)drawn;
+}
+
+int main(void) {
+    int fail = 0, ok;
+    printf("BloomCoin Validator Sampler\n");
+    printf("===========================\n\n");
+
+    const size_t N = 1000000;
+    bloom_sampler *s = bloom_sampler_create();
+    ok = 1;
+    for (size_t i = 0; i < N && ok; i++) {
+        uint32_t idx;
+        ok = bloom_sampler_register(s, &idx) == BLOOM_SAMPLER_OK && idx == i;
+    }
+    ok &= bloom_sampler_total(s) == N * BLOOM_SAMPLER_DEFAULT;
+    printf("register %zu:         %s\n", N, ok ? "OK" : "FAIL");
+    fail |= !ok;
+
+    /* Reputation churn: sets, updates and zeros */
+    uint64_t *weights = malloc(N * sizeof(uint64_t));
+    {
+        double t0 = now_sec();
+        const int UPDATES = 2000000;
+        for (int u = 0; u < UPDATES; u++) {
+            uint32_t i = (uint32_t)(xorshift() % N);
+            if (u % 50 == 0) {
+                bloom_sampler_set(s, i, u % 1000 == 0 ? 0 : xorshift() % (BLOOM_SAMPLER_ONE + 1));
+            } else {
+                bloom_sampler_update(s, i, xorshift() % 3 != 0);
+            }
+        }
+        double dt = now_sec() - t0;
+        uint64_t total = 0;
+        ok = 1;
+        for (size_t i = 0; i < N; i++) {
+            bloom_sampler_node node = { 0, 0, 0 };
+            bloom_sampler_get(s, (uint32_t)i, &node);
+            weights[i] = node.weight;
+            total += node.weight;
+            ok &= node.weight <= BLOOM_SAMPLER_ONE;
+        }
+        /* Every tree node holds the exact sum of its range */
+        for (size_t i = 1; i <= N && ok; i++) {
+            uint64_t sum = 0;
+            for (size_t j = i - (i & (0 - i)); j < i; j++) sum += weights[j];
+            ok = s->tree[i] == sum;
+        }
+        ok &= total == bloom_sampler_total(s);
+        printf("reputation updates:       %.0f ns each  %s\n", dt / UPDATES * 1e9,
+               ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Update rule: +-0.01, clamped */
+    {
+        uint32_t i = 5;
+        bloom_sampler_node node = { 0, 0, 0 };
+        bloom_sampler_set(s, i, BLOOM_SAMPLER_ONE - 5);
+        bloom_sampler_update(s, i, 1);
+        bloom_sampler_get(s, i, &node);
+        ok = node.weight == BLOOM_SAMPLER_ONE;
+        bloom_sampler_set(s, i, 3);
+        bloom_sampler_update(s, i, 0);
+        bloom_sampler_get(s, i, &node);
+        ok &= node.weight == 0;
+        bloom_sampler_set(s, i, BLOOM_SAMPLER_DEFAULT);
+        bloom_sampler_update(s, i, 1);
+        bloom_sampler_get(s, i, &node);
+        ok &= node.weight == BLOOM_SAMPLER_DEFAULT + BLOOM_SAMPLER_STEP;
+        ok &= bloom_sampler_set(s, i, BLOOM_SAMPLER_ONE + 1) == BLOOM_SAMPLER_ERR_INVALID;
+        ok &= bloom_sampler_update(s, (uint32_t)N, 1) == BLOOM_SAMPLER_ERR_INVALID;
+        weights[i] = node.weight;
+        printf("update clamps:            %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Draws against the linear reference, tree restored afterwards */
+    {
+        uint64_t *copy = malloc(N * sizeof(uint64_t));
+        uint64_t total = bloom_sampler_total(s);
+        ok = 1;
+        for (int d = 0; d < 50 && ok; d++) {
+            uint8_t seed[32];
+            uint32_t excl[3], a[7], b[7];
+            for (int j = 0; j < 32; j++) seed[j] = (uint8_t)xorshift();
+            for (int j = 0; j < 3; j++) excl[j] = (uint32_t)(xorshift() % N);
+            memcpy(copy, weights, N * sizeof(uint64_t));
+            int na = bloom_sampler_draw(s, seed, 32, excl, 3, 7, a);
+            int nb = linear_draw(copy, N, seed, 32, excl, 3, 7, b);
+            ok = na == 7 && nb == 7 && memcmp(a, b, sizeof(a)) == 0 &&
+                 bloom_sampler_total(s) == total;
+            for (int j = 0; j < 7 && ok; j++) {
+                ok = weights[a[j]] > 0 && a[j] != excl[0] && a[j] != excl[1] && a[j] != excl[2];
+                for (int t = 0; t < j; t++) ok &= a[t] != a[j];
+            }
+        }
+        for (size_t i = 1; i <= N && ok; i += 997) {
+            uint64_t sum = 0;
+            for (size_t j = i - (i & (0 - i)); j < i; j++) sum += weights[j];
+            ok = s->tree[i] == sum;
+        }
+        printf("draws match linear scan:  %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+
+        /* Throughput against the O(n) scan a per-bloom rebuild costs */
+        const int DRAWS = 200000;
+        uint32_t sel[7];
+        double t0 = now_sec();
+        for (int d = 0; d < DRAWS; d++) {
+            uint32_t proposer = (uint32_t)(d * 7919 % N);
+            bloom_sampler_draw(s, (const uint8_t *)&d, sizeof(d), &proposer, 1, 7, sel);
+        }
+        double t_tree = (now_sec() - t0) / DRAWS;
+        t0 = now_sec();
+        for (int d = 0; d < 20; d++) {
+            uint32_t proposer = (uint32_t)(d * 7919 % N);
+            memcpy(copy, weights, N * sizeof(uint64_t));
+            linear_draw(copy, N, (const uint8_t *)&d, sizeof(d), &proposer, 1, 7, sel);
+        }
+        double t_scan = (now_sec() - t0) / 20;
+        printf("draw k=7 of %zu:     %.2f us (linear %.0f us)\n", N, t_tree * 1e6,
+               t_scan * 1e6);
+        free(copy);
+    }
+
+    /* Pick frequencies follow weights; zero weights never drawn */
+    {
+        bloom_sampler *small = bloom_sampler_create();
+        enum { M = 12, DRAWS = 600000 };
+        uint64_t sum = 0;
+        uint32_t hits[M] = { 0 }, zero_hits = 0;
+        for (int i = 0; i < M; i++) {
+            bloom_sampler_register(small, NULL);
+            bloom_sampler_set(small, (uint32_t)i, i == 3 ? 0 : (uint64_t)(i + 1) * 300000000ull);
+            sum += i == 3 ? 0 : (uint64_t)(i + 1) * 300000000ull;
+        }
+        for (uint32_t d = 0; d < DRAWS; d++) {
+            uint32_t sel[3];
+            int got = bloom_sampler_draw(small, (const uint8_t *)&d, sizeof(d), NULL, 0, 3, sel);
+            if (got != 3) zero_hits = 1;
+            hits[sel[0]]++;
+            for (int j = 0; j < got; j++) zero_hits += sel[j] == 3;
+        }
+        /* Pearson chi-square, 10 degrees of freedom: 29.59 is p = 0.001 */
+        double chi2 = 0;
+        for (int i = 0; i < M; i++) {
+            if (i == 3) continue;
+            double expect = (double)DRAWS * (i + 1) * 300000000ull / sum;
+            chi2 += (hits[i] - expect) * (hits[i] - expect) / expect;
+        }
+        uint32_t all[M];
+        ok = chi2 < 29.59 && zero_hits == 0 && hits[3] == 0 &&
+             bloom_sampler_draw(small, (const uint8_t *)"x", 1, NULL, 0, M, all) == M - 1;
+        printf("first-pick frequencies:   chi2 %.1f (10 df)  %s\n", chi2, ok ? "OK" : "FAIL");
+        fail |= !ok;
+
+        /* Read-only picks give the same first pick as a draw */
+        ok = 1;
+        for (uint32_t d = 0; d < 1000 && ok; d++) {
+            uint8_t digest[32];
+            uint32_t key[8], w[2], sel[1] = { 0 };
+            nexthash256((const uint8_t *)&d, sizeof(d), digest);
+            for (int i = 0; i < 8; i++) {
+                key[i] = (uint32_t)digest[4 * i] | (uint32_t)digest[4 * i + 1] << 8 |
+                         (uint32_t)digest[4 * i + 2] << 16 | (uint32_t)digest[4 * i + 3] << 24;
+            }
+            nexthash_rng_fill_at(key, 0, w, 2);
+            ok = bloom_sampler_draw(small, (const uint8_t *)&d, sizeof(d), NULL, 0, 1, sel) == 1 &&
+                 bloom_sampler_pick(small, (uint64_t)w[0] | (uint64_t)w[1] << 32) == sel[0];
+        }
+        printf("pick matches draw:        %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+
+        uint32_t a[3], b[3];
+        bloom_sampler_draw(small, (const uint8_t *)"event", 5, NULL, 0, 3, a);
+        bloom_sampler_draw(small, (const uint8_t *)"event", 5, NULL, 0, 3, b);
+        ok = memcmp(a, b, sizeof(a)) == 0;
+        printf("same seed, same draw:     %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+        bloom_sampler_destroy(small);
+    }
+
+    free(weights);
+    bloom_sampler_destroy(s);
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
@@ -0,0 +1,94 @@
+/*
+ * BloomCoin Validator Sampler
+ * ===========================
+ *
+ * Reputation-weighted validator selection for ValidatorNetwork
+ * (garden/consensus/validator_network.py). select_validators() rebuilds
+ * and sorts the candidate list on every bloom; here the weights live in a
+ * Fenwick tree, so a reputation update is O(log n) and k distinct
+ * validators are drawn in O(k log n) without touching the rest.
+ *
+ * Features:
+ * - Reputations as 32.32 fixed point: sums are exact integers, so a draw
+ *   gives the same validators on every machine
+ * - Draws seeded by NEXTHASH-256(seed): anyone holding the seed (e.g. an
+ *   event hash) and the weights can verify a selection
+ * - Without replacement: each drawn validator is taken out of the tree
+ *   for the rest of the draw, excluded ids likewise; all are put back after
+ * - update_reputation(): +-0.01 clamped to [0, 1], with the counters
+ *
+ * Validators at weight zero are never drawn, so a draw returns fewer than
+ * k when fewer remain. A draw modifies and restores the tree: one draw at
+ * a time per sampler. bloom_sampler_pick() only reads it, for callers that
+ * draw from many threads and handle repeats themselves (bloom_garden.c).
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef BLOOM_SAMPLER_H
+#define BLOOM_SAMPLER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLOOM_SAMPLER_ONE     (1ull << 32)     /* reputation 1.0 */
+#define BLOOM_SAMPLER_STEP    42949673ull      /* reputation 0.01 */
+#define BLOOM_SAMPLER_DEFAULT (1ull << 31)     /* ValidatorNode.reputation = 0.5 */
+#define BLOOM_SAMPLER_MAX     (1u << 31)       /* validators */
+
+/* Status codes */
+#define BLOOM_SAMPLER_OK            0
+#define BLOOM_SAMPLER_ERR_NOMEM    -1
+#define BLOOM_SAMPLER_ERR_INVALID  -2   /* unknown index or weight above ONE */
+
+typedef struct {
+    uint64_t weight;                /* reputation x 2^32 */
+    uint32_t validations_performed;
+    uint32_t successful_validations;
+} bloom_sampler_node;
+
+typedef struct bloom_sampler bloom_sampler;
+
+bloom_sampler *bloom_sampler_create(void);
+void bloom_sampler_destroy(bloom_sampler *s);
+
+/* register_validator(): next index, reputation 0.5 */
+int bloom_sampler_register(bloom_sampler *s, uint32_t *index);
+
+size_t bloom_sampler_count(const bloom_sampler *s);
+
+/* Sum of all weights */
+uint64_t bloom_sampler_total(const bloom_sampler *s);
+
+int bloom_sampler_get(const bloom_sampler *s, uint32_t index, bloom_sampler_node *out);
+int bloom_sampler_set(bloom_sampler *s, uint32_t index, uint64_t weight);
+
+/* update_reputation(): reputation +-0.01 clamped to [0, 1], counters */
+int bloom_sampler_update(bloom_sampler *s, uint32_t index, int success);
+
+/*
+ * One pick with replacement for a uniform 64-bit r, in proportion to
+ * weight. Read-only, so picks may run in parallel between updates. The
+ * total must be nonzero.
+ */
+uint32_t bloom_sampler_pick(const bloom_sampler *s, uint64_t r);
+
+/*
+ * Draw up to k distinct validators, none in exclude[n_exclude], each
+ * pick in proportion to its weight among those left. Returns the number
+ * written to out, or a negative status.
+ */
+int bloom_sampler_draw(bloom_sampler *s, const uint8_t *seed, size_t seed_len,
+                       const uint32_t *exclude, size_t n_exclude,
+                       uint32_t k, uint32_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOOM_SAMPLER_H */
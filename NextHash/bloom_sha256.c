@@ -0,0 +1,181 @@
+/*
+ * BloomCoin SHA-256
+ * =================
+ *
+ * Compile: gcc -O3 -o bloom_sha256 bloom_sha256.c -DTEST_MAIN
+ */
+
+#include "bloom_sha256.h"
+#include <string.h>
+
+/* ========================================================================== */
+/* Compression                                                                 */
+/* ========================================================================== */
+
+static const uint32_t K256[64] = {
+    0x428A2F98u, 0x71374491u, 0xB5C0FBCFu, 0xE9B5DBA5u, 0x3956C25Bu, 0x59F111F1u, 0x923F82A4u, 0xAB1C5ED5u,
+    0xD807AA98u, 0x12835B01u, 0x243185BEu, 0x550C7DC3u, 0x72BE5D74u, 0x80DEB1FEu, 0x9BDC06A7u, 0xC19BF174u,
+    0xE49B69C1u, 0xEFBE4786u, 0x0FC19DC6u, 0x240CA1CCu, 0x2DE92C6Fu, 0x4A7484AAu, 0x5CB0A9DCu, 0x76F988DAu,
+    0x983E5152u, 0xA831C66Du, 0xB00327C8u, 0xBF597FC7u, 0xC6E00BF3u, 0xD5A79147u, 0x06CA6351u, 0x14292967u,
+    0x27B70A85u, 0x2E1B2138u, 0x4D2C6DFCu, 0x53380D13u, 0x650A7354u, 0x766A0ABBu, 0x81C2C92Eu, 0x92722C85u,
+    0xA2BFE8A1u, 0xA81A664Bu, 0xC24B8B70u, 0xC76C51A3u, 0xD192E819u, 0xD6990624u, 0xF40E3585u, 0x106AA070u,
+    0x19A4C116u, 0x1E376C08u, 0x2748774Cu, 0x34B0BCB5u, 0x391C0CB3u, 0x4ED8AA4Au, 0x5B9CCA4Fu, 0x682E6FF3u,
+    0x748F82EEu, 0x78A5636Fu, 0x84C87814u, 0x8CC70208u, 0x90BEFFFAu, 0xA4506CEBu, 0xBEF9A3F7u, 0xC67178F2u
+};
+
+const uint32_t bloom_sha256_iv[8] = {
+    0x6A09E667u, 0xBB67AE85u, 0x3C6EF372u, 0xA54FF53Au, 0x510E527Fu, 0x9B05688Cu, 0x1F83D9ABu, 0x5BE0CD19u
+};
+
+#define ROR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static uint32_t load32_be(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void store32_be(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+void bloom_sha256_block(uint32_t s[8], const uint8_t block[64]) {
+    uint32_t w[64], a, b, c, d, e, f, g, h;
+    for (int i = 0; i < 16; i++) w[i] = load32_be(block + 4 * i);
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = ROR32(w[i - 15], 7) ^ ROR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROR32(w[i - 2], 17) ^ ROR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    a = s[0]; b = s[1]; c = s[2]; d = s[3];
+    e = s[4]; f = s[5]; g = s[6]; h = s[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (ROR32(e, 6) ^ ROR32(e, 11) ^ ROR32(e, 25)) + ((e & f) ^ (~e & g)) +
+                      K256[i] + w[i];
+        uint32_t t2 = (ROR32(a, 2) ^ ROR32(a, 13) ^ ROR32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    s[0] += a; s[1] += b; s[2] += c; s[3] += d;
+    s[4] += e; s[5] += f; s[6] += g; s[7] += h;
+}
+
+/* ========================================================================== */
+/* Streaming Interface                                                         */
+/* ========================================================================== */
+
+void bloom_sha256_init(bloom_sha256_ctx *ctx) {
+    memcpy(ctx->state, bloom_sha256_iv, sizeof(ctx->state));
+    ctx->count = 0;
+}
+
+void bloom_sha256_update(bloom_sha256_ctx *ctx, const uint8_t *data, size_t len) {
+    size_t used = (size_t)(ctx->count & 63);
+    ctx->count += len;
+    if (used) {
+        size_t take = 64 - used < len ? 64 - used : len;
+        memcpy(ctx->buffer + used, data, take);
+        data += take;
+        len -= take;
+        if (used + take < 64) return;
+        bloom_sha256_block(ctx->state, ctx->buffer);
+    }
+    for (; len >= 64; data += 64, len -= 64) bloom_sha256_block(ctx->state, data);
+    if (len) memcpy(ctx->buffer, data, len);
+}
+
+void bloom_sha256_final(bloom_sha256_ctx *ctx, uint8_t digest[32]) {
+    size_t used = (size_t)(ctx->count & 63);
+    uint64_t bits = ctx->count * 8;
+    ctx->buffer[used++] = 0x80;
+    if (used > 56) {
+        memset(ctx->buffer + used, 0, 64 - used);
+        bloom_sha256_block(ctx->state, ctx->buffer);
+        used = 0;
+    }
+    memset(ctx->buffer + used, 0, 56 - used);
+    store32_be(ctx->buffer + 56, (uint32_t)(bits >> 32));
+    store32_be(ctx->buffer + 60, (uint32_t)bits);
+    bloom_sha256_block(ctx->state, ctx->buffer);
+    for (int i = 0; i < 8; i++) store32_be(digest + 4 * i, ctx->state[i]);
+}
+
+void bloom_sha256(const uint8_t *data, size_t len, uint8_t digest[32]) {
+    bloom_sha256_ctx ctx;
+    bloom_sha256_init(&ctx);
+    bloom_sha256_update(&ctx, data, len);
+    bloom_sha256_final(&ctx, digest);
+}
+
+void bloom_sha256d(const uint8_t *data, size_t len, uint8_t digest[32]) {
+    uint8_t inner[32];
+    bloom_sha256(data, len, inner);
+    bloom_sha256(inner, 32, digest);
+}
+
+/* ========================================================================== */
+/* Self-Test                                                                   */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <stdio.h>
+
+static void to_hex(const uint8_t d[32], char out[65]) {
+    for (int i = 0; i < 32; i++) sprintf(out + 2 * i, "%02x", d[i]);
+}
+
+int main(void) {
+    /* FIPS 180-4 examples, and hashlib for the rest */
+    static const struct { const char *msg; int sha256d; const char *hex; } vec[] = {
+        { "", 0, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+        { "abc", 0, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+        { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 0,
+          "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+        { "abc", 1, "4f8b42c22dd3729b519ba6f68d2da7cc5b2d606d05daed5ad5128cc03e6c6358" },
+    };
+    int fail = 0;
+    char hex[65];
+    uint8_t d[32];
+
+    printf("BloomCoin SHA-256\n");
+    printf("=================\n\n");
+
+    for (size_t i = 0; i < sizeof(vec) / sizeof(vec[0]); i++) {
+        const uint8_t *m = (const uint8_t *)vec[i].msg;
+        size_t len = strlen(vec[i].msg);
+        if (vec[i].sha256d) bloom_sha256d(m, len, d);
+        else bloom_sha256(m, len, d);
+        to_hex(d, hex);
+        int ok = strcmp(hex, vec[i].hex) == 0;
+        char label[32];
+        snprintf(label, sizeof(label), "%s(\"%.12s%s\"):", vec[i].sha256d ? "sha256d" : "sha256",
+                 vec[i].msg, len > 12 ? "..." : "");
+        printf("%-28s%s\n", label, ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* One million 'a', fed in uneven pieces */
+    {
+        static uint8_t a[1024];
+        bloom_sha256_ctx ctx;
+        size_t done = 0, step = 1;
+        memset(a, 'a', sizeof(a));
+        bloom_sha256_init(&ctx);
+        while (done < 1000000) {
+            size_t n = 1000000 - done < step ? 1000000 - done : step;
+            bloom_sha256_update(&ctx, a, n);
+            done += n;
+            step = step % 997 + 13;
+        }
+        bloom_sha256_final(&ctx, d);
+        to_hex(d, hex);
+        int ok = strcmp(hex, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0") == 0;
+        printf("streamed 10^6 x 'a':        %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
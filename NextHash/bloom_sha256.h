@@ -0,0 +1,50 @@
+/*
+ * BloomCoin SHA-256
+ * =================
+ *
+ * Plain FIPS 180-4 SHA-256 for the places the Python side uses hashlib:
+ * ConsensusCertificate.compute_hash(), the mnemonic checksum, and the
+ * double SHA-256 of the node's block headers. NEXTHASH-256 stays in
+ * nexthash256.h; this is only for matching digests Python already makes.
+ *
+ * Features:
+ * - Streaming init / update / final and one-shot helpers
+ * - sha256d(): SHA-256(SHA-256(data)), as hashlib in node.py
+ * - Raw compression function for callers that pad their own blocks
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef BLOOM_SHA256_H
+#define BLOOM_SHA256_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t count;                 /* bytes absorbed */
+    uint8_t buffer[64];
+} bloom_sha256_ctx;
+
+void bloom_sha256_init(bloom_sha256_ctx *ctx);
+void bloom_sha256_update(bloom_sha256_ctx *ctx, const uint8_t *data, size_t len);
+void bloom_sha256_final(bloom_sha256_ctx *ctx, uint8_t digest[32]);
+
+void bloom_sha256(const uint8_t *data, size_t len, uint8_t digest[32]);
+void bloom_sha256d(const uint8_t *data, size_t len, uint8_t digest[32]);
+
+/* Initial state, and one compression of a 64-byte block into state */
+extern const uint32_t bloom_sha256_iv[8];
+void bloom_sha256_block(uint32_t state[8], const uint8_t block[64]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOOM_SHA256_H */
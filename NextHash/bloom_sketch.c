@@ -0,0 +1,547 @@
+/*
+ * BloomCoin MinHash / LSH Similarity Index
+ * ========================================
+ *
+ * Compile: gcc -O3 -c nexthash256.c
+ *          gcc -O3 -fopenmp -o bloom_sketch bloom_sketch.c nexthash256.o -DTEST_MAIN
+ */
+
+#include "bloom_sketch.h"
+#include "nexthash256.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Tokens hashed per nexthash256_batch() call */
+#define HASH_CHUNK 256
+
+struct bloom_sketch_index {
+    uint32_t k, bands, rows;
+    uint64_t *a, *b;                /* hash family */
+
+    /* Items: signatures [n][k] */
+    uint32_t *sigs;
+    uint32_t *n_tokens;
+    uint8_t *alive;
+    uint32_t *stamp;                /* query epoch that last saw the item */
+    size_t n, cap, live;
+    uint32_t epoch;
+
+    /* Band buckets: open addressing key -> head entry + 1 */
+    uint64_t *bkey;
+    uint32_t *bhead;
+    size_t bcap, bused;
+
+    /* Bucket entries, chained */
+    uint32_t *eitem, *enext;
+    size_t ecount, ecap;
+
+    /* Query scratch */
+    bloom_sketch_match *found;
+    size_t found_cap;
+};
+
+/* ========================================================================== */
+/* Helpers                                                                     */
+/* ========================================================================== */
+
+static uint64_t load64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static void store64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+static int is_space(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r') || (c >= 0x1C && c <= 0x1F);
+}
+
+static int cmp_u64(const void *x, const void *y) {
+    uint64_t a = *(const uint64_t *)x, b = *(const uint64_t *)y;
+    return (a > b) - (a < b);
+}
+
+/* Sort and drop duplicates; returns the new length */
+static size_t unique_u64(uint64_t *v, size_t n) {
+    if (n < 2) return n;
+    qsort(v, n, sizeof(uint64_t), cmp_u64);
+    size_t m = 1;
+    for (size_t i = 1; i < n; i++) {
+        if (v[i] != v[m - 1]) v[m++] = v[i];
+    }
+    return m;
+}
+
+static int grow(void **p, size_t *cap, size_t need, size_t elem) {
+    if (need <= *cap) return 0;
+    size_t c = *cap ? *cap : 1024;
+    while (c < need) c *= 2;
+    void *q = realloc(*p, c * elem);
+    if (!q) return -1;
+    *p = q;
+    *cap = c;
+    return 0;
+}
+
+/* ========================================================================== */
+/* Index                                                                       */
+/* ========================================================================== */
+
+bloom_sketch_index *bloom_sketch_create(const bloom_sketch_config *cfg) {
+    uint32_t k = cfg && cfg->n_hashes ? cfg->n_hashes : BLOOM_SKETCH_HASHES;
+    uint32_t bands = cfg && cfg->bands ? cfg->bands : BLOOM_SKETCH_BANDS;
+    if (bands > k || k % bands != 0) return NULL;
+
+    bloom_sketch_index *idx = (bloom_sketch_index *)calloc(1, sizeof(*idx));
+    if (!idx) return NULL;
+    idx->k = k;
+    idx->bands = bands;
+    idx->rows = k / bands;
+    idx->a = (uint64_t *)malloc(k * sizeof(uint64_t));
+    idx->b = (uint64_t *)malloc(k * sizeof(uint64_t));
+    if (!idx->a || !idx->b) {
+        bloom_sketch_destroy(idx);
+        return NULL;
+    }
+
+    /* (a_i, b_i) from NEXTHASH-256(seed || i); a_i odd */
+    uint8_t msg[16], digest[32];
+    store64(msg, cfg ? cfg->seed : 0);
+    for (uint32_t i = 0; i < k; i++) {
+        store64(msg + 8, i);
+        nexthash256(msg, sizeof(msg), digest);
+        idx->a[i] = load64(digest) | 1;
+        idx->b[i] = load64(digest + 8);
+    }
+    return idx;
+}
+
+void bloom_sketch_destroy(bloom_sketch_index *idx) {
+    if (!idx) return;
+    free(idx->a);
+    free(idx->b);
+    free(idx->sigs);
+    free(idx->n_tokens);
+    free(idx->alive);
+    free(idx->stamp);
+    free(idx->bkey);
+    free(idx->bhead);
+    free(idx->eitem);
+    free(idx->enext);
+    free(idx->found);
+    free(idx);
+}
+
+uint32_t bloom_sketch_hashes(const bloom_sketch_index *idx) {
+    return idx->k;
+}
+
+size_t bloom_sketch_count(const bloom_sketch_index *idx) {
+    return idx->live;
+}
+
+/* ========================================================================== */
+/* Sketching                                                                   */
+/* ========================================================================== */
+
+void bloom_sketch_signature(const bloom_sketch_index *idx, const uint64_t *tokens,
+                            size_t n, uint32_t *sig) {
+    const uint64_t *a = idx->a, *b = idx->b;
+    uint32_t k = idx->k;
+    for (uint32_t i = 0; i < k; i++) sig[i] = UINT32_MAX;
+    for (size_t t = 0; t < n; t++) {
+        uint64_t x = tokens[t];
+        for (uint32_t i = 0; i < k; i++) {
+            uint32_t h = (uint32_t)((a[i] * x + b[i]) >> 32);
+            sig[i] = h < sig[i] ? h : sig[i];
+        }
+    }
+}
+
+int bloom_sketch_texts(const bloom_sketch_index *idx, const char *const *texts,
+                       const size_t *lens, size_t n, uint32_t *sigs, uint32_t *n_tokens) {
+    /* Lowercased copy of every text and the token spans within it */
+    size_t total_len = 0, total_tok = 0;
+    for (size_t i = 0; i < n; i++) total_len += lens[i];
+    char *low = (char *)malloc(total_len ? total_len : 1);
+    size_t *first = (size_t *)malloc((n + 1) * sizeof(size_t));
+    size_t tok_cap = total_len / 2 + 1;
+    const uint8_t **tok = (const uint8_t **)malloc(tok_cap * sizeof(*tok));
+    size_t *tok_len = (size_t *)malloc(tok_cap * sizeof(size_t));
+    uint64_t *hashes = (uint64_t *)malloc(tok_cap * sizeof(uint64_t));
+    int st = BLOOM_SKETCH_ERR_NOMEM;
+    if (!low || !first || !tok || !tok_len || !hashes) goto done;
+
+    char *p = low;
+    for (size_t i = 0; i < n; i++) {
+        first[i] = total_tok;
+        const char *s = texts[i];
+        for (size_t j = 0; j < lens[i]; j++) {
+            unsigned char c = (unsigned char)s[j];
+            p[j] = (char)(c >= 'A' && c <= 'Z' ? c + 32 : c);
+        }
+        for (size_t j = 0; j < lens[i];) {
+            while (j < lens[i] && is_space((unsigned char)p[j])) j++;
+            size_t start = j;
+            while (j < lens[i] && !is_space((unsigned char)p[j])) j++;
+            if (j > start) {
+                tok[total_tok] = (const uint8_t *)p + start;
+                tok_len[total_tok++] = j - start;
+            }
+        }
+        p += lens[i];
+    }
+    first[n] = total_tok;
+
+    long n_chunks = (long)((total_tok + HASH_CHUNK - 1) / HASH_CHUNK);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (long c = 0; c < n_chunks; c++) {
+        uint8_t digests[HASH_CHUNK][32];
+        size_t from = (size_t)c * HASH_CHUNK;
+        size_t cnt = total_tok - from < HASH_CHUNK ? total_tok - from : HASH_CHUNK;
+        nexthash256_batch(tok + from, tok_len + from, cnt, digests);
+        for (size_t t = 0; t < cnt; t++) hashes[from + t] = load64(digests[t]);
+    }
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 16)
+#endif
+    for (long i = 0; i < (long)n; i++) {
+        size_t m = unique_u64(hashes + first[i], first[i + 1] - first[i]);
+        n_tokens[i] = (uint32_t)m;
+        bloom_sketch_signature(idx, hashes + first[i], m, sigs + (size_t)i * idx->k);
+    }
+    st = BLOOM_SKETCH_OK;
+
+done:
+    free(low);
+    free(first);
+    free(tok);
+    free(tok_len);
+    free(hashes);
+    return st;
+}
+
+float bloom_sketch_jaccard(const uint32_t *a, const uint32_t *b, uint32_t k) {
+    uint32_t same = 0;
+    for (uint32_t i = 0; i < k; i++) same += a[i] == b[i];
+    return k ? (float)same / (float)k : 0.0f;
+}
+
+/* ========================================================================== */
+/* LSH Buckets                                                                 */
+/* ========================================================================== */
+
+static uint64_t band_key(const bloom_sketch_index *idx, const uint32_t *sig, uint32_t band) {
+    uint64_t h = mix64(0x9E3779B97F4A7C15ull * (band + 1));
+    const uint32_t *v = sig + (size_t)band * idx->rows;
+    for (uint32_t r = 0; r < idx->rows; r++) h = mix64(h ^ v[r]);
+    return h;
+}
+
+/* Slot of key: either holding it or the empty slot where it belongs */
+static size_t bucket_slot(const bloom_sketch_index *idx, uint64_t key) {
+    size_t mask = idx->bcap - 1, s = (size_t)key & mask;
+    while (idx->bhead[s] && idx->bkey[s] != key) s = (s + 1) & mask;
+    return s;
+}
+
+static int bucket_grow(bloom_sketch_index *idx) {
+    size_t old_cap = idx->bcap, cap = old_cap ? 2 * old_cap : 4096;
+    uint64_t *old_key = idx->bkey;
+    uint32_t *old_head = idx->bhead;
+    idx->bkey = (uint64_t *)malloc(cap * sizeof(uint64_t));
+    idx->bhead = (uint32_t *)calloc(cap, sizeof(uint32_t));
+    if (!idx->bkey || !idx->bhead) {
+        free(idx->bkey);
+        free(idx->bhead);
+        idx->bkey = old_key;
+        idx->bhead = old_head;
+        return -1;
+    }
+    idx->bcap = cap;
+    for (size_t i = 0; i < old_cap; i++) {
+        if (!old_head[i]) continue;
+        size_t s = bucket_slot(idx, old_key[i]);
+        idx->bkey[s] = old_key[i];
+        idx->bhead[s] = old_head[i];
+    }
+    free(old_key);
+    free(old_head);
+    return 0;
+}
+
+long bloom_sketch_add(bloom_sketch_index *idx, const uint32_t *sig, uint32_t n_tokens) {
+    size_t k = idx->k, id = idx->n;
+    if (id >= UINT32_MAX) return BLOOM_SKETCH_ERR_NOMEM;
+
+    if (id == idx->cap) {
+        size_t cap = idx->cap ? 2 * idx->cap : 1024;
+        uint32_t *sigs = (uint32_t *)realloc(idx->sigs, cap * k * sizeof(uint32_t));
+        if (sigs) idx->sigs = sigs;
+        uint32_t *nt = (uint32_t *)realloc(idx->n_tokens, cap * sizeof(uint32_t));
+        if (nt) idx->n_tokens = nt;
+        uint8_t *alive = (uint8_t *)realloc(idx->alive, cap);
+        if (alive) idx->alive = alive;
+        uint32_t *stamp = (uint32_t *)realloc(idx->stamp, cap * sizeof(uint32_t));
+        if (stamp) idx->stamp = stamp;
+        if (!sigs || !nt || !alive || !stamp) return BLOOM_SKETCH_ERR_NOMEM;
+        idx->cap = cap;
+    }
+    if (grow((void **)&idx->eitem, &idx->ecap, idx->ecount + idx->bands, sizeof(uint32_t))) {
+        return BLOOM_SKETCH_ERR_NOMEM;
+    }
+    uint32_t *enext = (uint32_t *)realloc(idx->enext, idx->ecap * sizeof(uint32_t));
+    if (!enext) return BLOOM_SKETCH_ERR_NOMEM;
+    idx->enext = enext;
+    while (2 * (idx->bused + idx->bands) > idx->bcap) {
+        if (bucket_grow(idx)) return BLOOM_SKETCH_ERR_NOMEM;
+    }
+
+    memcpy(idx->sigs + id * k, sig, k * sizeof(uint32_t));
+    idx->n_tokens[id] = n_tokens;
+    idx->alive[id] = 1;
+    idx->stamp[id] = 0;
+    for (uint32_t band = 0; band < idx->bands; band++) {
+        uint64_t key = band_key(idx, sig, band);
+        size_t s = bucket_slot(idx, key);
+        if (!idx->bhead[s]) {
+            idx->bkey[s] = key;
+            idx->bused++;
+        }
+        size_t e = idx->ecount++;
+        idx->eitem[e] = (uint32_t)id;
+        idx->enext[e] = idx->bhead[s];
+        idx->bhead[s] = (uint32_t)(e + 1);
+    }
+    idx->n++;
+    idx->live++;
+    return (long)id;
+}
+
+int bloom_sketch_remove(bloom_sketch_index *idx, uint32_t item) {
+    if (item >= idx->n || !idx->alive[item]) return BLOOM_SKETCH_ERR_INVALID;
+    idx->alive[item] = 0;
+    idx->live--;
+    return BLOOM_SKETCH_OK;
+}
+
+/* ========================================================================== */
+/* Queries                                                                     */
+/* ========================================================================== */
+
+static int cmp_match(const void *x, const void *y) {
+    const bloom_sketch_match *a = (const bloom_sketch_match *)x;
+    const bloom_sketch_match *b = (const bloom_sketch_match *)y;
+    if (a->jaccard != b->jaccard) return a->jaccard < b->jaccard ? 1 : -1;
+    return (a->item > b->item) - (a->item < b->item);
+}
+
+size_t bloom_sketch_query(bloom_sketch_index *idx, const uint32_t *sig, uint32_t n_tokens,
+                          float min_jaccard, bloom_sketch_match *out, size_t max) {
+    if (idx->n == 0) return 0;
+    if (++idx->epoch == 0) {
+        memset(idx->stamp, 0, idx->n * sizeof(uint32_t));
+        idx->epoch = 1;
+    }
+
+    size_t found = 0;
+    for (uint32_t band = 0; band < idx->bands; band++) {
+        size_t s = bucket_slot(idx, band_key(idx, sig, band));
+        for (uint32_t e = idx->bhead[s]; e; e = idx->enext[e - 1]) {
+            uint32_t item = idx->eitem[e - 1];
+            if (!idx->alive[item] || idx->stamp[item] == idx->epoch) continue;
+            idx->stamp[item] = idx->epoch;
+            float j = bloom_sketch_jaccard(sig, idx->sigs + (size_t)item * idx->k, idx->k);
+            if (j < min_jaccard) continue;
+            if (grow((void **)&idx->found, &idx->found_cap, found + 1,
+                     sizeof(bloom_sketch_match))) {
+                break;
+            }
+            /* |A & B| = J (|A| + |B|) / (1 + J) */
+            float c = 0.0f;
+            if (n_tokens) {
+                c = j * (float)(n_tokens + idx->n_tokens[item]) / ((1.0f + j) * (float)n_tokens);
+                if (c > 1.0f) c = 1.0f;
+            }
+            bloom_sketch_match m = { item, j, c };
+            idx->found[found++] = m;
+        }
+    }
+    qsort(idx->found, found, sizeof(bloom_sketch_match), cmp_match);
+    if (found > max) found = max;
+    memcpy(out, idx->found, found * sizeof(bloom_sketch_match));
+    return found;
+}
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+static uint64_t test_rng = 0x4F1BBCDCBFA53E0Bull;
+
+static uint64_t xorshift(void) {
+    test_rng ^= test_rng << 13;
+    test_rng ^= test_rng >> 7;
+    test_rng ^= test_rng << 17;
+    return test_rng;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Memory text: `words` words drawn from a vocabulary of 5000 */
+static size_t make_text(char *buf, const uint32_t *words, size_t n) {
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++) {
+        len += (size_t)sprintf(buf + len, "%s%sW%u", i ? " " : "",
+                               words[i] % 3 == 0 ? "\"" : "", words[i]);
+    }
+    return len;
+}
+
+int main(void) {
+    int fail = 0, ok;
+    printf("BloomCoin MinHash / LSH Similarity Index\n");
+    printf("========================================\n\n");
+
+    bloom_sketch_index *idx = bloom_sketch_create(NULL);
+    uint32_t k = bloom_sketch_hashes(idx);
+
+    /* Tokenizer: lower().split() as a set */
+    {
+        const char *a = "Alpha  beta\tGAMMA\nalpha", *b = "gamma beta alpha";
+        const char *texts[2] = { a, b };
+        size_t lens[2] = { strlen(a), strlen(b) };
+        uint32_t sigs[2 * BLOOM_SKETCH_HASHES], nt[2];
+        bloom_sketch_texts(idx, texts, lens, 2, sigs, nt);
+        ok = nt[0] == 3 && nt[1] == 3 && memcmp(sigs, sigs + k, k * 4) == 0;
+        printf("tokenizer:                %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Jaccard estimates for sets with known overlap */
+    {
+        static uint64_t base[400];
+        uint32_t sa[BLOOM_SKETCH_HASHES], sb[BLOOM_SKETCH_HASHES];
+        for (int i = 0; i < 400; i++) base[i] = xorshift();
+        double worst = 0;
+        for (int shared = 0; shared <= 200; shared += 50) {
+            /* |A| = |B| = 200, |A & B| = shared */
+            bloom_sketch_signature(idx, base, 200, sa);
+            bloom_sketch_signature(idx, base + 200 - shared, 200, sb);
+            double exact = shared / (400.0 - shared);
+            double est = bloom_sketch_jaccard(sa, sb, k);
+            if (fabs(est - exact) > worst) worst = fabs(est - exact);
+        }
+        ok = worst < 0.12;
+        printf("Jaccard estimate:         max error %.3f  %s\n", worst, ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* 10^5 memories; every 100th has a near-duplicate planted later */
+    enum { N = 100000, WORDS = 30, VOCAB = 5000 };
+    static uint32_t words[N][WORDS];
+    char **texts = malloc(N * sizeof(char *));
+    size_t *lens = malloc(N * sizeof(size_t));
+    for (int i = 0; i < N; i++) {
+        if (i % 100 == 50) {
+            /* 25 of 30 words shared with item i - 50: Jaccard 25/35 */
+            memcpy(words[i], words[i - 50], sizeof(words[i]));
+            for (int w = 25; w < WORDS; w++) words[i][w] = VOCAB + (uint32_t)xorshift() % 100000;
+        } else {
+            for (int w = 0; w < WORDS; w++) words[i][w] = (uint32_t)(xorshift() % VOCAB);
+        }
+        texts[i] = malloc(WORDS * 12);
+        lens[i] = make_text(texts[i], words[i], WORDS);
+    }
+    uint32_t *sigs = malloc((size_t)N * k * sizeof(uint32_t));
+    uint32_t *nt = malloc(N * sizeof(uint32_t));
+    double t0 = now_sec();
+    bloom_sketch_texts(idx, (const char *const *)texts, lens, N, sigs, nt);
+    double t1 = now_sec();
+    for (int i = 0; i < N; i++) bloom_sketch_add(idx, sigs + (size_t)i * k, nt[i]);
+    double t2 = now_sec();
+    printf("sketch + index:           %d memories, sketch %.0f ms, insert %.0f ms\n",
+           N, 1e3 * (t1 - t0), 1e3 * (t2 - t1));
+
+    /* Every planted pair is found; unrelated memories rarely are */
+    {
+        bloom_sketch_match m[16];
+        long found = 0, planted = 0, stray = 0;
+        double tq = now_sec();
+        for (int i = 50; i < N; i += 100) {
+            size_t got = bloom_sketch_query(idx, sigs + (size_t)i * k, nt[i], 0.3f, m, 16);
+            planted++;
+            for (size_t j = 0; j < got; j++) {
+                if (m[j].item == (uint32_t)(i - 50)) found++;
+                else if (m[j].item != (uint32_t)i) stray++;
+            }
+        }
+        tq = now_sec() - tq;
+        ok = found >= planted * 98 / 100 && stray < planted / 10;
+        printf("near-duplicate recall:    %ld / %ld, %ld unrelated, %.1f us/query  %s\n",
+               found, planted, stray, 1e6 * tq / planted, ok ? "OK" : "FAIL");
+        fail |= !ok;
+
+        /* Brute-force scan of the same queries, for scale */
+        double tb = now_sec();
+        long hits = 0;
+        for (int i = 50; i < 50 + 100 * 20; i += 100) {
+            for (int j = 0; j < N; j++) {
+                hits += bloom_sketch_jaccard(sigs + (size_t)i * k, sigs + (size_t)j * k, k) >= 0.3f;
+            }
+        }
+        tb = (now_sec() - tb) / 20;
+        printf("  linear scan:            %.1f us/query (%ld hits)\n", 1e6 * tb, hits);
+    }
+
+    /* Containment and removal */
+    {
+        bloom_sketch_match m[4];
+        size_t got = bloom_sketch_query(idx, sigs + 50 * (size_t)k, nt[50], 0.3f, m, 4);
+        ok = got >= 1 && m[0].item == 50 && fabsf(m[0].containment - 1.0f) < 1e-6f;
+        ok &= got >= 2 && m[1].item == 0 && fabsf(m[1].containment - 25.0f / 30) < 0.12f;
+        ok &= bloom_sketch_remove(idx, 0) == BLOOM_SKETCH_OK &&
+              bloom_sketch_remove(idx, 0) == BLOOM_SKETCH_ERR_INVALID;
+        got = bloom_sketch_query(idx, sigs + 50 * (size_t)k, nt[50], 0.3f, m, 4);
+        ok &= got == 1 && m[0].item == 50 && bloom_sketch_count(idx) == N - 1;
+        printf("containment / removal:    %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    bloom_sketch_config bad = { 100, 30, 0 };
+    ok = bloom_sketch_create(&bad) == NULL;
+    printf("invalid band layout:      %s\n", ok ? "OK" : "FAIL");
+    fail |= !ok;
+
+    for (int i = 0; i < N; i++) free(texts[i]);
+    free(texts);
+    free(lens);
+    free(sigs);
+    free(nt);
+    bloom_sketch_destroy(idx);
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
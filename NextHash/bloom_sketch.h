@@ -0,0 +1,98 @@
+/*
+ * BloomCoin MinHash / LSH Similarity Index
+ * ========================================
+ *
+ * Sketch index for agent memories (garden/agents/knowledge.py): instead of
+ * comparing a new memory's word set with every stored memory
+ * (calculate_overlap(), _find_associations()), each memory is reduced to a
+ * MinHash signature once and similar memories are found through LSH band
+ * buckets, so adding n memories costs O(n) rather than O(n^2).
+ *
+ * Features:
+ * - Tokens as in the Python code: text.lower().split(), as a set
+ * - Token hash: first 8 bytes of NEXTHASH-256(token), all tokens of a batch
+ *   of texts hashed through nexthash256_batch()
+ * - K hash functions h_i(x) = (a_i * x + b_i) >> 32 with (a_i, b_i) drawn
+ *   from NEXTHASH-256(seed || i); signature = per-function minimum
+ * - LSH with `bands` bands of K / bands rows: an item is a candidate when
+ *   any band matches exactly; candidates are ranked by estimated Jaccard
+ * - Containment estimate |A & B| / |A| for calculate_overlap()
+ * - Removal by tombstone; OpenMP over texts when enabled
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef BLOOM_SKETCH_H
+#define BLOOM_SKETCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLOOM_SKETCH_HASHES 128     /* default signature length */
+#define BLOOM_SKETCH_BANDS  32      /* default bands (4 rows each) */
+
+/* Status codes */
+#define BLOOM_SKETCH_OK            0
+#define BLOOM_SKETCH_ERR_NOMEM    -1
+#define BLOOM_SKETCH_ERR_INVALID  -2   /* bad config or unknown item */
+
+typedef struct {
+    uint32_t n_hashes;              /* 0 = BLOOM_SKETCH_HASHES */
+    uint32_t bands;                 /* 0 = BLOOM_SKETCH_BANDS; must divide n_hashes */
+    uint64_t seed;
+} bloom_sketch_config;
+
+typedef struct {
+    uint32_t item;
+    float jaccard;                  /* estimated */
+    float containment;              /* estimated |query & item| / |query| */
+} bloom_sketch_match;
+
+typedef struct bloom_sketch_index bloom_sketch_index;
+
+/* cfg may be NULL; returns NULL on a bad config or no memory */
+bloom_sketch_index *bloom_sketch_create(const bloom_sketch_config *cfg);
+void bloom_sketch_destroy(bloom_sketch_index *idx);
+
+/* Signature length K */
+uint32_t bloom_sketch_hashes(const bloom_sketch_index *idx);
+
+/*
+ * Sketch n texts: sigs[i * K .. +K) and n_tokens[i] (distinct tokens) for
+ * each. Tokens of all texts are hashed in shared batches.
+ */
+int bloom_sketch_texts(const bloom_sketch_index *idx, const char *const *texts,
+                       const size_t *lens, size_t n, uint32_t *sigs, uint32_t *n_tokens);
+
+/* Signature of a set of 64-bit token hashes (duplicates allowed) */
+void bloom_sketch_signature(const bloom_sketch_index *idx, const uint64_t *tokens,
+                            size_t n, uint32_t *sig);
+
+/* Insert a signature; returns the new item id or a negative status code */
+long bloom_sketch_add(bloom_sketch_index *idx, const uint32_t *sig, uint32_t n_tokens);
+
+int bloom_sketch_remove(bloom_sketch_index *idx, uint32_t item);
+
+/* Live items */
+size_t bloom_sketch_count(const bloom_sketch_index *idx);
+
+/*
+ * Items sharing an LSH band with sig and with estimated Jaccard >= min_jaccard,
+ * best first; at most max written. Returns the number written.
+ */
+size_t bloom_sketch_query(bloom_sketch_index *idx, const uint32_t *sig, uint32_t n_tokens,
+                          float min_jaccard, bloom_sketch_match *out, size_t max);
+
+/* Estimated Jaccard similarity of two signatures of length k */
+float bloom_sketch_jaccard(const uint32_t *a, const uint32_t *b, uint32_t k);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOOM_SKETCH_H */
@@ -0,0 +1,912 @@
+/*
+ * BloomCoin Block Store
+ * =====================
+ *
+ * Compile: gcc -O3 -c nexthash256.c
+ *          gcc -O3 -o bloom_store bloom_store.c nexthash256.o -DTEST_MAIN
+ */
+
+#define _GNU_SOURCE
+#include "bloom_store.h"
+#include "nexthash256.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#define SEG_MAGIC   0x314B4C42u     /* "BLK1" */
+#define IDX_MAGIC   0x31584449u     /* "IDX1" */
+#define IDX_VERSION 1
+#define IDX_HEADER  64              /* bytes before record 0 */
+#define REC_HEADER  56              /* segment record header */
+#define HSH_MAGIC   0x31485348u     /* "HSH1" */
+#define HSH_VERSION 1
+#define HSH_HEADER  64              /* bytes before slot 0 */
+#define TABLE_MIN   1024
+
+/* On-disk index record (little-endian host layout) */
+typedef struct {
+    uint8_t hash[32];
+    uint64_t offset;
+    uint32_t len;
+    uint32_t segment;
+    uint64_t checksum;
+    uint32_t height;
+    uint32_t reserved;
+} index_rec;
+
+/* hash.dat slot: low 32 bits of the block hash, height + 1 (0 = empty) */
+typedef struct {
+    uint32_t tag;
+    uint32_t height;
+} hash_slot;
+
+typedef struct {
+    int fd;
+    uint64_t size;              /* bytes written */
+    uint8_t *map;
+    size_t map_len;
+} segment;
+
+struct bloom_store {
+    char *dir;
+    uint64_t seg_size;
+    uint32_t sync_blocks;
+    uint64_t sync_bytes;
+
+    /* Index file, mapped; records [0, durable) are committed */
+    int idx_fd;
+    uint8_t *imap;
+    size_t imap_len;
+    uint32_t imap_cap;
+    uint32_t durable;
+
+    /* Appended but not yet committed */
+    index_rec *pending;
+    uint32_t n_pending, pending_cap;
+    uint64_t pending_bytes;
+    uint32_t first_dirty;       /* lowest segment written since the last commit */
+    int new_segment;            /* directory entry needs an fsync */
+
+    segment *segs;
+    uint32_t n_segs, segs_cap;
+
+    /* Hash -> height, open addressing in hash.dat, mapped read-write */
+    int hash_fd;
+    uint8_t *hmap;
+    size_t hmap_len;
+    hash_slot *table;
+    uint32_t table_mask;
+    uint32_t table_count;       /* heights [0, table_count) are in the table */
+    uint32_t table_builds;      /* full rebuilds since open */
+
+    uint32_t recovered;
+};
+
+/* ========================================================================== */
+/* Helpers                                                                     */
+/* ========================================================================== */
+
+static void store32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void store64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint32_t load32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+           (uint32_t)p[3] << 24;
+}
+
+static uint64_t load64(const uint8_t *p) {
+    return (uint64_t)load32(p) | (uint64_t)load32(p + 4) << 32;
+}
+
+static uint64_t rec_size(uint32_t len) {
+    return REC_HEADER + (((uint64_t)len + 7) & ~(uint64_t)7);
+}
+
+static uint64_t checksum(const uint8_t *data, uint32_t len) {
+    uint8_t digest[32];
+    nexthash256(data, len, digest);
+    return load64(digest);
+}
+
+static uint32_t count(const bloom_store *s) {
+    return s->durable + s->n_pending;
+}
+
+static index_rec *rec(const bloom_store *s, uint32_t height) {
+    if (height < s->durable) return (index_rec *)(s->imap + IDX_HEADER) + height;
+    return &s->pending[height - s->durable];
+}
+
+static void fsync_dir(const bloom_store *s) {
+    int fd = open(s->dir, O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+/* ========================================================================== */
+/* Segments                                                                    */
+/* ========================================================================== */
+
+static void seg_path(const bloom_store *s, uint32_t i, char *buf, size_t cap) {
+    snprintf(buf, cap, "%s/blk%05u.dat", s->dir, i);
+}
+
+/* Open segment i (== n_segs); returns 0, or -1 if absent and !create */
+static int seg_open(bloom_store *s, uint32_t i, int create) {
+    char path[4096];
+    seg_path(s, i, path, sizeof(path));
+    int fd = open(path, O_RDWR | (create ? O_CREAT : 0), 0644);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    if (s->n_segs == s->segs_cap) {
+        uint32_t cap = s->segs_cap ? 2 * s->segs_cap : 16;
+        segment *segs = (segment *)realloc(s->segs, cap * sizeof(segment));
+        if (!segs) {
+            close(fd);
+            return -1;
+        }
+        s->segs = segs;
+        s->segs_cap = cap;
+    }
+    segment *g = &s->segs[s->n_segs++];
+    g->fd = fd;
+    g->size = (uint64_t)st.st_size;
+    g->map = NULL;
+    g->map_len = 0;
+    if (create) s->new_segment = 1;
+    return 0;
+}
+
+static void seg_close(segment *g) {
+    if (g->map) munmap(g->map, g->map_len);
+    close(g->fd);
+}
+
+/* Mapping covering [0, end); segments are mapped whole, past EOF */
+static const uint8_t *seg_map(bloom_store *s, segment *g, uint64_t end) {
+    if (end <= g->map_len) return g->map;
+    size_t len = s->seg_size > end ? s->seg_size : end;
+    if (g->map) munmap(g->map, g->map_len);
+    g->map = (uint8_t *)mmap(NULL, len, PROT_READ, MAP_SHARED, g->fd, 0);
+    if (g->map == MAP_FAILED) {
+        g->map = NULL;
+        g->map_len = 0;
+        return NULL;
+    }
+    g->map_len = len;
+    return g->map;
+}
+
+/*
+ * Is there an intact record for height at (seg, off)? With full set the
+ * data is re-hashed, otherwise only the header is compared (against r if
+ * given).
+ */
+static int record_ok(bloom_store *s, uint32_t seg, uint64_t off, uint32_t height,
+                     const index_rec *r, int full) {
+    if (seg >= s->n_segs) return 0;
+    segment *g = &s->segs[seg];
+    if (off + REC_HEADER > g->size) return 0;
+    const uint8_t *m = seg_map(s, g, off + REC_HEADER);
+    if (!m) return 0;
+    const uint8_t *h = m + off;
+    uint32_t len = load32(h + 4);
+    if (load32(h) != SEG_MAGIC || load32(h + 8) != height) return 0;
+    if (off + rec_size(len) > g->size) return 0;
+    if (r && (r->len != len || r->checksum != load64(h + 16) ||
+              memcmp(r->hash, h + 24, 32) != 0)) {
+        return 0;
+    }
+    if (!full) return 1;
+    m = seg_map(s, g, off + rec_size(len));
+    return m && checksum(m + off + REC_HEADER, len) == load64(m + off + 16);
+}
+
+/* Drop segments after keep and cut segment keep at size */
+static int seg_cut(bloom_store *s, uint32_t keep, uint64_t size) {
+    char path[4096];
+    while (s->n_segs > keep + 1) {
+        uint32_t i = --s->n_segs;
+        seg_close(&s->segs[i]);
+        seg_path(s, i, path, sizeof(path));
+        unlink(path);
+    }
+    segment *g = &s->segs[keep];
+    if (g->size != size) {
+        if (ftruncate(g->fd, (off_t)size) != 0 || fdatasync(g->fd) != 0) {
+            return BLOOM_STORE_ERR_IO;
+        }
+        g->size = size;
+    }
+    fsync_dir(s);
+    if (s->first_dirty > keep) s->first_dirty = keep;
+    return BLOOM_STORE_OK;
+}
+
+/* ========================================================================== */
+/* Index                                                                       */
+/* ========================================================================== */
+
+static int index_map(bloom_store *s, uint32_t need) {
+    if (s->imap && need <= s->imap_cap) return BLOOM_STORE_OK;
+    uint32_t cap = s->imap_cap ? s->imap_cap : 4096;
+    while (cap < need) cap *= 2;
+    size_t len = IDX_HEADER + (size_t)cap * sizeof(index_rec);
+    if (s->imap) munmap(s->imap, s->imap_len);
+    s->imap = (uint8_t *)mmap(NULL, len, PROT_READ, MAP_SHARED, s->idx_fd, 0);
+    if (s->imap == MAP_FAILED) {
+        s->imap = NULL;
+        return BLOOM_STORE_ERR_IO;
+    }
+    s->imap_len = len;
+    s->imap_cap = cap;
+    return BLOOM_STORE_OK;
+}
+
+static int index_cut(bloom_store *s, uint32_t n) {
+    if (ftruncate(s->idx_fd, IDX_HEADER + (off_t)n * sizeof(index_rec)) != 0 ||
+        fdatasync(s->idx_fd) != 0) {
+        return BLOOM_STORE_ERR_IO;
+    }
+    s->durable = n;
+    return BLOOM_STORE_OK;
+}
+
+static index_rec *pending_push(bloom_store *s) {
+    if (s->n_pending == s->pending_cap) {
+        uint32_t cap = s->pending_cap ? 2 * s->pending_cap : 64;
+        index_rec *p = (index_rec *)realloc(s->pending, cap * sizeof(index_rec));
+        if (!p) return NULL;
+        s->pending = p;
+        s->pending_cap = cap;
+    }
+    return &s->pending[s->n_pending++];
+}
+
+/* ========================================================================== */
+/* Hash Table                                                                  */
+/* ========================================================================== */
+
+/*
+ * hash.dat: magic u32 | version u32 | capacity u32 | clean u32 | count u32,
+ * padded to 64 bytes, then capacity slots with linear probing. The table
+ * holds heights [0, count) and is trusted on open only if it was marked
+ * clean at close and count matches the index; otherwise it is rebuilt
+ * from index.dat once.
+ */
+
+static uint32_t hash_tag(const uint8_t hash[32]) {
+    return (uint32_t)load64(hash);
+}
+
+/* Map hash.dat with cap slots; fresh truncates it to an empty table */
+static int table_map(bloom_store *s, uint32_t cap, int fresh) {
+    size_t len = HSH_HEADER + (size_t)cap * sizeof(hash_slot);
+    if (s->hmap) {
+        munmap(s->hmap, s->hmap_len);
+        s->hmap = NULL;
+        s->table = NULL;
+    }
+    if (fresh && (ftruncate(s->hash_fd, 0) != 0 || ftruncate(s->hash_fd, (off_t)len) != 0)) {
+        return BLOOM_STORE_ERR_IO;
+    }
+    uint8_t *m = (uint8_t *)mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, s->hash_fd, 0);
+    if (m == MAP_FAILED) return BLOOM_STORE_ERR_IO;
+    s->hmap = m;
+    s->hmap_len = len;
+    s->table = (hash_slot *)(m + HSH_HEADER);
+    s->table_mask = cap - 1;
+    if (fresh) {
+        store32(m, HSH_MAGIC);
+        store32(m + 4, HSH_VERSION);
+        store32(m + 8, cap);
+        s->table_count = 0;
+    }
+    return BLOOM_STORE_OK;
+}
+
+/* Add height table_count */
+static void table_insert(bloom_store *s) {
+    uint32_t height = s->table_count++;
+    uint32_t tag = hash_tag(rec(s, height)->hash);
+    uint32_t i = tag & s->table_mask;
+    while (s->table[i].height) i = (i + 1) & s->table_mask;
+    s->table[i].tag = tag;
+    s->table[i].height = height + 1;
+}
+
+/* Remove height table_count - 1, shifting its probe run back */
+static void table_pop(bloom_store *s) {
+    uint32_t height = --s->table_count;
+    uint32_t i = hash_tag(rec(s, height)->hash) & s->table_mask;
+    while (s->table[i].height != height + 1) i = (i + 1) & s->table_mask;
+    for (uint32_t j = (i + 1) & s->table_mask; s->table[j].height; j = (j + 1) & s->table_mask) {
+        uint32_t home = s->table[j].tag & s->table_mask;
+        if (((j - home) & s->table_mask) >= ((j - i) & s->table_mask)) {
+            s->table[i] = s->table[j];
+            i = j;
+        }
+    }
+    s->table[i].tag = 0;
+    s->table[i].height = 0;
+}
+
+/* Drop heights >= n; the records must still be readable */
+static void table_trim(bloom_store *s, uint32_t n) {
+    if (!s->hmap) return;
+    while (s->table_count > n) table_pop(s);
+}
+
+static int table_build(bloom_store *s, uint32_t n) {
+    uint32_t cap = TABLE_MIN;
+    while (cap < 2 * (uint64_t)n + 2) cap *= 2;
+    int st = table_map(s, cap, 1);
+    if (st != BLOOM_STORE_OK) return st;
+    while (s->table_count < n) table_insert(s);
+    s->table_builds++;
+    return BLOOM_STORE_OK;
+}
+
+/* Open hash.dat; a clean table matching the index is mapped as is */
+static int table_open(bloom_store *s) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/hash.dat", s->dir);
+    s->hash_fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (s->hash_fd < 0) return BLOOM_STORE_ERR_IO;
+    struct stat st;
+    uint8_t hdr[HSH_HEADER];
+    if (fstat(s->hash_fd, &st) != 0) return BLOOM_STORE_ERR_IO;
+    if (st.st_size < HSH_HEADER || pread(s->hash_fd, hdr, HSH_HEADER, 0) != HSH_HEADER) {
+        return BLOOM_STORE_OK;
+    }
+    uint32_t cap = load32(hdr + 8);
+    if (load32(hdr) != HSH_MAGIC || load32(hdr + 4) != HSH_VERSION || !load32(hdr + 12) ||
+        load32(hdr + 16) != s->durable || cap < TABLE_MIN || (cap & (cap - 1)) ||
+        (uint64_t)st.st_size != HSH_HEADER + (uint64_t)cap * sizeof(hash_slot)) {
+        return BLOOM_STORE_OK;
+    }
+    int rc = table_map(s, cap, 0);
+    if (rc != BLOOM_STORE_OK) return rc;
+    s->table_count = s->durable;
+
+    /* Dirty until the next clean close */
+    store32(s->hmap + 12, 0);
+    return msync(s->hmap, HSH_HEADER, MS_SYNC) == 0 ? BLOOM_STORE_OK : BLOOM_STORE_ERR_IO;
+}
+
+/* Bring the table up to count(s), growing it at half load */
+static int table_update(bloom_store *s) {
+    uint32_t n = count(s);
+    if (!s->hmap || 2 * (uint64_t)n + 2 > s->table_mask + 1) return table_build(s, n);
+    while (s->table_count < n) table_insert(s);
+    return BLOOM_STORE_OK;
+}
+
+/* Write the slots back, then mark the table clean */
+static void table_close(bloom_store *s) {
+    if (s->hmap) {
+        if (s->table_count == s->durable && s->n_pending == 0 &&
+            msync(s->hmap, s->hmap_len, MS_SYNC) == 0) {
+            store32(s->hmap + 16, s->table_count);
+            store32(s->hmap + 12, 1);
+            msync(s->hmap, HSH_HEADER, MS_SYNC);
+        }
+        munmap(s->hmap, s->hmap_len);
+    }
+    if (s->hash_fd >= 0) close(s->hash_fd);
+}
+
+/* ========================================================================== */
+/* Open / Recovery                                                             */
+/* ========================================================================== */
+
+static int index_open(bloom_store *s) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/index.dat", s->dir);
+    s->idx_fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (s->idx_fd < 0) return BLOOM_STORE_ERR_IO;
+    struct stat st;
+    if (fstat(s->idx_fd, &st) != 0) return BLOOM_STORE_ERR_IO;
+
+    uint8_t hdr[IDX_HEADER];
+    if (st.st_size < IDX_HEADER) {
+        /* New store, or its creation was interrupted */
+        memset(hdr, 0, sizeof(hdr));
+        store32(hdr, IDX_MAGIC);
+        store32(hdr + 4, IDX_VERSION);
+        store64(hdr + 8, s->seg_size);
+        if (pwrite(s->idx_fd, hdr, IDX_HEADER, 0) != IDX_HEADER ||
+            ftruncate(s->idx_fd, IDX_HEADER) != 0 || fsync(s->idx_fd) != 0) {
+            return BLOOM_STORE_ERR_IO;
+        }
+        fsync_dir(s);
+        st.st_size = IDX_HEADER;
+    } else if (pread(s->idx_fd, hdr, IDX_HEADER, 0) != IDX_HEADER) {
+        return BLOOM_STORE_ERR_IO;
+    }
+    if (load32(hdr) != IDX_MAGIC || load32(hdr + 4) != IDX_VERSION) {
+        return BLOOM_STORE_ERR_CORRUPT;
+    }
+
+    s->durable = (uint32_t)((st.st_size - IDX_HEADER) / sizeof(index_rec));
+    if ((st.st_size - IDX_HEADER) % sizeof(index_rec) != 0) {
+        int st2 = index_cut(s, s->durable);             /* torn record */
+        if (st2 != BLOOM_STORE_OK) return st2;
+    }
+    return index_map(s, s->durable + 1);
+}
+
+static int recover(bloom_store *s) {
+    /* Committed tail: index records whose blocks did not survive */
+    uint32_t n = s->durable;
+    while (n > 0) {
+        const index_rec *r = rec(s, n - 1);
+        if (r->height == n - 1 &&
+            record_ok(s, r->segment, r->offset, n - 1, r, 1)) {
+            break;
+        }
+        n--;
+    }
+    if (n != s->durable) {
+        table_trim(s, n);
+        int st = index_cut(s, n);
+        if (st != BLOOM_STORE_OK) return st;
+    }
+
+    /* Uncommitted tail: complete, valid records after the last indexed one */
+    uint32_t seg = 0;
+    uint64_t off = 0;
+    if (n > 0) {
+        const index_rec *r = rec(s, n - 1);
+        seg = r->segment;
+        off = r->offset + rec_size(r->len);
+    }
+    s->first_dirty = seg;
+    for (;;) {
+        uint32_t h = count(s);
+        if (!record_ok(s, seg, off, h, NULL, 1)) {
+            if (!record_ok(s, seg + 1, 0, h, NULL, 1)) break;
+            seg++;
+            off = 0;
+        }
+        const uint8_t *m = s->segs[seg].map + off;
+        index_rec *r = pending_push(s);
+        if (!r) return BLOOM_STORE_ERR_NOMEM;
+        memcpy(r->hash, m + 24, 32);
+        r->offset = off;
+        r->len = load32(m + 4);
+        r->segment = seg;
+        r->checksum = load64(m + 16);
+        r->height = h;
+        r->reserved = 0;
+        off += rec_size(r->len);
+        s->recovered++;
+    }
+
+    int st = seg_cut(s, seg, off);
+    if (st != BLOOM_STORE_OK) return st;
+    return bloom_store_commit(s);
+}
+
+bloom_store *bloom_store_open(const char *dir, const bloom_store_config *cfg, int *status) {
+    int st = BLOOM_STORE_ERR_NOMEM;
+    bloom_store *s = (bloom_store *)calloc(1, sizeof(*s));
+    if (!s || !(s->dir = strdup(dir))) goto fail;
+    s->idx_fd = -1;
+    s->hash_fd = -1;
+    s->seg_size = cfg && cfg->segment_size ? cfg->segment_size : BLOOM_STORE_SEGMENT_SIZE;
+    s->sync_blocks = cfg && cfg->sync_blocks ? cfg->sync_blocks : BLOOM_STORE_SYNC_BLOCKS;
+    s->sync_bytes = cfg && cfg->sync_bytes ? cfg->sync_bytes : BLOOM_STORE_SYNC_BYTES;
+
+    if ((st = index_open(s)) != BLOOM_STORE_OK) goto fail;
+    if ((st = table_open(s)) != BLOOM_STORE_OK) goto fail;
+    while (seg_open(s, s->n_segs, 0) == 0) {}
+    st = BLOOM_STORE_ERR_IO;
+    if (s->n_segs == 0 && seg_open(s, 0, 1) != 0) goto fail;
+    if ((st = recover(s)) != BLOOM_STORE_OK) goto fail;
+    if ((st = table_update(s)) != BLOOM_STORE_OK) goto fail;
+    if (status) *status = BLOOM_STORE_OK;
+    return s;
+
+fail:
+    if (status) *status = st;
+    if (s) {
+        s->n_pending = 0;
+        bloom_store_close(s);
+    }
+    return NULL;
+}
+
+void bloom_store_close(bloom_store *s) {
+    if (!s) return;
+    if (s->idx_fd >= 0) bloom_store_commit(s);
+    table_close(s);
+    for (uint32_t i = 0; i < s->n_segs; i++) seg_close(&s->segs[i]);
+    if (s->imap) munmap(s->imap, s->imap_len);
+    if (s->idx_fd >= 0) close(s->idx_fd);
+    free(s->segs);
+    free(s->pending);
+    free(s->dir);
+    free(s);
+}
+
+/* ========================================================================== */
+/* Writes                                                                      */
+/* ========================================================================== */
+
+long bloom_store_append(bloom_store *s, const uint8_t hash[32],
+                        const uint8_t *data, uint32_t len) {
+    uint32_t h = count(s);
+    uint64_t size = rec_size(len);
+
+    /* Table kept at most half full */
+    if (2 * (uint64_t)h + 2 > s->table_mask + 1) {
+        int st = table_build(s, h);
+        if (st != BLOOM_STORE_OK) return st;
+    }
+
+    segment *g = &s->segs[s->n_segs - 1];
+    if (g->size > 0 && g->size + size > s->seg_size) {
+        if (seg_open(s, s->n_segs, 1) != 0) return BLOOM_STORE_ERR_IO;
+        g = &s->segs[s->n_segs - 1];
+        if (g->size != 0) return BLOOM_STORE_ERR_CORRUPT;     /* stray file */
+    }
+    index_rec *r = pending_push(s);
+    if (!r) return BLOOM_STORE_ERR_NOMEM;
+
+    uint8_t hdr[REC_HEADER], pad[8] = { 0 };
+    uint64_t sum = checksum(data, len);
+    store32(hdr, SEG_MAGIC);
+    store32(hdr + 4, len);
+    store32(hdr + 8, h);
+    store32(hdr + 12, 0);
+    store64(hdr + 16, sum);
+    memcpy(hdr + 24, hash, 32);
+    struct iovec iov[3] = {
+        { hdr, REC_HEADER },
+        { (void *)data, len },
+        { pad, (size_t)(size - REC_HEADER - len) },
+    };
+    if (pwritev(g->fd, iov, 3, (off_t)g->size) != (ssize_t)size) {
+        s->n_pending--;
+        if (ftruncate(g->fd, (off_t)g->size) != 0) {}
+        return BLOOM_STORE_ERR_IO;
+    }
+
+    memcpy(r->hash, hash, 32);
+    r->offset = g->size;
+    r->len = len;
+    r->segment = s->n_segs - 1;
+    r->checksum = sum;
+    r->height = h;
+    r->reserved = 0;
+    g->size += size;
+    s->pending_bytes += size;
+    table_insert(s);
+
+    if (s->n_pending >= s->sync_blocks || s->pending_bytes >= s->sync_bytes) {
+        int st = bloom_store_commit(s);
+        if (st != BLOOM_STORE_OK) return st;
+    }
+    return (long)h;
+}
+
+int bloom_store_commit(bloom_store *s) {
+    if (s->n_pending == 0) return BLOOM_STORE_OK;
+
+    /* Data first, so a committed index record never points at lost data */
+    for (uint32_t i = s->first_dirty; i < s->n_segs; i++) {
+        if (fdatasync(s->segs[i].fd) != 0) return BLOOM_STORE_ERR_IO;
+    }
+    if (s->new_segment) {
+        fsync_dir(s);
+        s->new_segment = 0;
+    }
+    size_t bytes = (size_t)s->n_pending * sizeof(index_rec);
+    off_t at = IDX_HEADER + (off_t)s->durable * sizeof(index_rec);
+    if (pwrite(s->idx_fd, s->pending, bytes, at) != (ssize_t)bytes ||
+        fdatasync(s->idx_fd) != 0) {
+        return BLOOM_STORE_ERR_IO;
+    }
+    /* Remap before the records move out of pending */
+    if (index_map(s, count(s)) != BLOOM_STORE_OK) return BLOOM_STORE_ERR_IO;
+    s->durable += s->n_pending;
+    s->n_pending = 0;
+    s->pending_bytes = 0;
+    s->first_dirty = s->n_segs - 1;
+    return BLOOM_STORE_OK;
+}
+
+int bloom_store_truncate(bloom_store *s, uint32_t height) {
+    if (height >= count(s)) return BLOOM_STORE_OK;
+    table_trim(s, height);
+    const index_rec *r = rec(s, height);
+    uint32_t seg = r->segment;
+    uint64_t off = r->offset;
+
+    /*
+     * Segments first: if the index were cut first, a crash in between
+     * would let the tail scan bring the dropped blocks back.
+     */
+    int st = seg_cut(s, seg, off);
+    if (st != BLOOM_STORE_OK) return st;
+    if (height < s->durable) {
+        s->n_pending = 0;
+        st = index_cut(s, height);
+        if (st != BLOOM_STORE_OK) return st;
+    } else {
+        s->n_pending = height - s->durable;
+    }
+    s->pending_bytes = 0;
+    for (uint32_t i = 0; i < s->n_pending; i++) {
+        s->pending_bytes += rec_size(s->pending[i].len);
+    }
+    return BLOOM_STORE_OK;
+}
+
+/* ========================================================================== */
+/* Reads                                                                       */
+/* ========================================================================== */
+
+uint32_t bloom_store_count(const bloom_store *s) { return count(s); }
+uint32_t bloom_store_durable(const bloom_store *s) { return s->durable; }
+uint32_t bloom_store_recovered(const bloom_store *s) { return s->recovered; }
+
+int bloom_store_get(bloom_store *s, uint32_t height, bloom_block_ref *out) {
+    if (height >= count(s)) return BLOOM_STORE_ERR_NOT_FOUND;
+    const index_rec *r = rec(s, height);
+    segment *g = &s->segs[r->segment];
+    const uint8_t *m = seg_map(s, g, r->offset + rec_size(r->len));
+    if (!m) return BLOOM_STORE_ERR_IO;
+    m += r->offset;
+    out->data = m + REC_HEADER;
+    out->len = r->len;
+    out->height = height;
+    out->hash = m + 24;
+    return BLOOM_STORE_OK;
+}
+
+long bloom_store_find(const bloom_store *s, const uint8_t hash[32]) {
+    uint32_t tag = hash_tag(hash);
+    uint32_t i = tag & s->table_mask;
+    while (s->table[i].height) {
+        uint32_t h = s->table[i].height - 1;
+        if (s->table[i].tag == tag && memcmp(rec(s, h)->hash, hash, 32) == 0) return (long)h;
+        i = (i + 1) & s->table_mask;
+    }
+    return BLOOM_STORE_ERR_NOT_FOUND;
+}
+
+long bloom_store_range(bloom_store *s, uint32_t start, uint32_t end, bloom_block_ref *out) {
+    if (end > count(s)) end = count(s);
+    long n = 0;
+    for (uint32_t h = start; h < end; h++) {
+        int st = bloom_store_get(s, h, &out[n]);
+        if (st != BLOOM_STORE_OK) return st;
+        n++;
+    }
+    return n;
+}
+
+int bloom_store_verify(bloom_store *s, uint32_t height) {
+    bloom_block_ref ref;
+    int st = bloom_store_get(s, height, &ref);
+    if (st != BLOOM_STORE_OK) return st;
+    return checksum(ref.data, ref.len) == rec(s, height)->checksum
+               ? BLOOM_STORE_OK : BLOOM_STORE_ERR_CHECKSUM;
+}
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <time.h>
+#include <sys/wait.h>
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Block h: deterministic bytes, hash = NEXTHASH-256 of them */
+static uint32_t make_block(uint32_t h, uint8_t *buf, uint8_t hash[32]) {
+    uint64_t x = 0x9E3779B97F4A7C15ull * (h + 1);
+    uint32_t len = 200 + (uint32_t)(x >> 40) % 4000;
+    for (uint32_t i = 0; i < len; i++) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        buf[i] = (uint8_t)x;
+    }
+    nexthash256(buf, len, hash);
+    return len;
+}
+
+/* Blocks [0, n) read back intact */
+static int check_prefix(bloom_store *s, uint32_t n) {
+    static uint8_t buf[4200];
+    uint8_t hash[32];
+    bloom_block_ref ref;
+    for (uint32_t h = 0; h < n; h++) {
+        uint32_t len = make_block(h, buf, hash);
+        if (bloom_store_get(s, h, &ref) != BLOOM_STORE_OK || ref.len != len ||
+            memcmp(ref.data, buf, len) != 0 || memcmp(ref.hash, hash, 32) != 0 ||
+            bloom_store_find(s, hash) != (long)h) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int check_blocks(bloom_store *s, uint32_t n) {
+    return bloom_store_count(s) == n && check_prefix(s, n);
+}
+
+static void append_blocks(bloom_store *s, uint32_t from, uint32_t to) {
+    static uint8_t buf[4200];
+    uint8_t hash[32];
+    for (uint32_t h = from; h < to; h++) {
+        uint32_t len = make_block(h, buf, hash);
+        bloom_store_append(s, hash, buf, len);
+    }
+}
+
+int main(void) {
+    int fail = 0, st, ok;
+    printf("BloomCoin Block Store\n");
+    printf("=====================\n\n");
+
+    char dir[] = "/tmp/bloom_store_XXXXXX";
+    if (!mkdtemp(dir)) return 1;
+    char path[4096];
+    bloom_store_config cfg = { 1u << 20, 0, 0 };
+    enum { N = 5000, TAIL = 37 };
+
+    bloom_store *s = bloom_store_open(dir, &cfg, &st);
+    double t0 = now_sec();
+    append_blocks(s, 0, N);
+    bloom_store_commit(s);
+    double t1 = now_sec();
+    ok = check_blocks(s, N) && bloom_store_durable(s) == N;
+    printf("append + group commit:    %d blocks in %.1f ms (%.0f blocks/s)  %s\n",
+           N, 1e3 * (t1 - t0), N / (t1 - t0), ok ? "OK" : "FAIL");
+    fail |= !ok;
+
+    /* Baseline: fsync every block */
+    {
+        char dir2[] = "/tmp/bloom_store_XXXXXX";
+        if (!mkdtemp(dir2)) return 1;
+        bloom_store_config one = { 1u << 20, 1, 0 };
+        bloom_store *s2 = bloom_store_open(dir2, &one, &st);
+        double t2 = now_sec();
+        append_blocks(s2, 0, 500);
+        double t3 = now_sec();
+        printf("  fsync per block:        %.0f blocks/s\n", 500 / (t3 - t2));
+        bloom_store_close(s2);
+        snprintf(path, sizeof(path), "rm -rf %s", dir2);
+        if (system(path) != 0) {}
+    }
+
+    bloom_block_ref refs[64];
+    long got = bloom_store_range(s, N - 10, N + 10, refs);
+    ok = got == 10 && refs[0].height == N - 10 && refs[9].height == N - 1;
+    uint8_t unknown[32] = { 1 };
+    ok &= bloom_store_find(s, unknown) == BLOOM_STORE_ERR_NOT_FOUND;
+    ok &= bloom_store_verify(s, 1234) == BLOOM_STORE_OK;
+    printf("range / find / verify:    %s\n", ok ? "OK" : "FAIL");
+    fail |= !ok;
+    bloom_store_close(s);
+
+    t0 = now_sec();
+    s = bloom_store_open(dir, &cfg, &st);
+    t1 = now_sec();
+    ok = s && check_blocks(s, N) && bloom_store_recovered(s) == 0 && s->table_builds == 0;
+    printf("reopen, hash.dat mapped:  %.2f ms  %s\n", 1e3 * (t1 - t0), ok ? "OK" : "FAIL");
+    fail |= !ok;
+    bloom_store_close(s);
+
+    /* Crash after appending without a commit, then a torn write */
+    pid_t pid = fork();
+    if (pid == 0) {
+        bloom_store_config lazy = { 1u << 20, 1000, 1u << 30 };
+        bloom_store *c = bloom_store_open(dir, &lazy, &st);
+        append_blocks(c, N, N + TAIL);
+        _exit(0);
+    }
+    waitpid(pid, NULL, 0);
+    {
+        uint32_t last = 0;
+        struct stat sb;
+        for (;; last++) {
+            snprintf(path, sizeof(path), "%s/blk%05u.dat", dir, last + 1);
+            if (stat(path, &sb) != 0) break;
+        }
+        snprintf(path, sizeof(path), "%s/blk%05u.dat", dir, last);
+        int fd = open(path, O_WRONLY | O_APPEND);
+        uint8_t junk[300];
+        memset(junk, 0xAB, sizeof(junk));
+        store32(junk, SEG_MAGIC);
+        store32(junk + 4, 1000);
+        store32(junk + 8, N + TAIL);
+        if (write(fd, junk, sizeof(junk)) != (ssize_t)sizeof(junk)) fail = 1;
+        close(fd);
+    }
+    s = bloom_store_open(dir, &cfg, &st);
+    ok = s && bloom_store_recovered(s) == TAIL && check_blocks(s, N + TAIL) &&
+         bloom_store_durable(s) == N + TAIL && s->table_builds == 1;
+    printf("crash recovery:           %u blocks recovered, torn tail cut  %s\n",
+           s ? bloom_store_recovered(s) : 0, ok ? "OK" : "FAIL");
+    fail |= !ok;
+
+    /*
+     * Corrupt committed data: damage at the tip is dropped on open, damage
+     * further down only shows up in bloom_store_verify()
+     */
+    {
+        uint32_t damaged[2] = { N + TAIL - 3, N + TAIL - 1 };
+        uint32_t segs[2];
+        uint64_t offs[2];
+        for (int i = 0; i < 2; i++) {
+            const index_rec *r = rec(s, damaged[i]);
+            segs[i] = r->segment;
+            offs[i] = r->offset + REC_HEADER + 5;
+        }
+        bloom_store_close(s);
+        for (int i = 0; i < 2; i++) {
+            snprintf(path, sizeof(path), "%s/blk%05u.dat", dir, segs[i]);
+            int fd = open(path, O_WRONLY);
+            uint8_t b = 0x5A;
+            if (pwrite(fd, &b, 1, (off_t)offs[i]) != 1) fail = 1;
+            close(fd);
+        }
+        s = bloom_store_open(dir, &cfg, &st);
+        uint8_t buf[4200], hash[32];
+        make_block(N + TAIL - 1, buf, hash);
+        ok = s && bloom_store_find(s, hash) == BLOOM_STORE_ERR_NOT_FOUND && s->table_builds == 0;
+        ok &= s && bloom_store_count(s) == N + TAIL - 1 && check_prefix(s, N + TAIL - 3) &&
+             bloom_store_verify(s, N + TAIL - 3) == BLOOM_STORE_ERR_CHECKSUM &&
+             bloom_store_verify(s, N + TAIL - 2) == BLOOM_STORE_OK;
+        printf("checksum mismatch:        count %u  %s\n",
+               s ? bloom_store_count(s) : 0, ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Reorg: drop the top blocks, append others, survive a reopen */
+    {
+        st = bloom_store_truncate(s, 4000);
+        ok = st == BLOOM_STORE_OK && check_blocks(s, 4000);
+        append_blocks(s, 4000, 4100);
+        bloom_store_close(s);
+        s = bloom_store_open(dir, &cfg, &st);
+        ok &= s && check_blocks(s, 4100) && bloom_store_recovered(s) == 0 &&
+              s->table_builds == 0;
+        uint8_t buf[4200], hash[32];
+        make_block(4500, buf, hash);
+        ok &= bloom_store_find(s, hash) == BLOOM_STORE_ERR_NOT_FOUND;
+        printf("truncate + reopen:        %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+        bloom_store_close(s);
+    }
+
+    snprintf(path, sizeof(path), "rm -rf %s", dir);
+    if (system(path) != 0) {}
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
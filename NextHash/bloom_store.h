@@ -0,0 +1,115 @@
+/*
+ * BloomCoin Block Store
+ * =====================
+ *
+ * Durable storage for serialized blocks (Block.serialize() in
+ * blockchain/block.py) in place of the in-memory lists kept by Blockchain
+ * in blockchain/chain.py. Blocks live in append-only segment files and are
+ * read back through mmap, so memory no longer grows with chain length and
+ * a restart only has to validate the tail.
+ *
+ * Features:
+ * - Append-only segment files blk00000.dat, blk00001.dat, ... rolled over
+ *   at a configurable size
+ * - Fixed 64-byte index records (index.dat), one per height; height lookup
+ *   is a direct offset
+ * - Hash lookup through an open-addressing table of 8-byte slots kept in
+ *   hash.dat and mapped read-write: appends insert into the mapping, and
+ *   opening after a clean close maps it without scanning the chain (a
+ *   crash leaves it marked dirty and it is rebuilt from the index once)
+ * - Group commit: appends are written immediately but fsynced in batches
+ *   (every sync_blocks blocks / sync_bytes bytes, or bloom_store_commit())
+ * - Crash recovery: index records at the tip whose blocks did not survive
+ *   are dropped, and blocks written after the last commit are recovered by
+ *   a tail scan that validates each record's NEXTHASH-256 checksum; torn
+ *   writes are cut off. Older damage is reported by bloom_store_verify()
+ * - Zero-copy reads: bloom_store_get() returns a pointer into the mapping
+ * - Truncation above a height for reorganisations
+ *
+ * Segment record: magic u32 | len u32 | height u32 | 0 u32 | checksum u64 |
+ *                 hash[32] | data[len] | zero pad to 8 bytes
+ * The checksum is the first 8 bytes (LE) of NEXTHASH-256(data).
+ *
+ * A store is used by one thread at a time; reads may remap segments.
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef BLOOM_STORE_H
+#define BLOOM_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLOOM_STORE_SEGMENT_SIZE  (128u << 20)   /* default rollover size */
+#define BLOOM_STORE_SYNC_BLOCKS   64
+#define BLOOM_STORE_SYNC_BYTES    (8u << 20)
+
+/* Status codes */
+#define BLOOM_STORE_OK              0
+#define BLOOM_STORE_ERR_IO         -1   /* open / write / fsync / mmap failed */
+#define BLOOM_STORE_ERR_CORRUPT    -2   /* index header unreadable or mismatched */
+#define BLOOM_STORE_ERR_NOT_FOUND  -3
+#define BLOOM_STORE_ERR_NOMEM      -4
+#define BLOOM_STORE_ERR_CHECKSUM   -5   /* block data does not match its checksum */
+
+typedef struct {
+    uint64_t segment_size;      /* 0 = BLOOM_STORE_SEGMENT_SIZE */
+    uint32_t sync_blocks;       /* 0 = BLOOM_STORE_SYNC_BLOCKS */
+    uint64_t sync_bytes;        /* 0 = BLOOM_STORE_SYNC_BYTES */
+} bloom_store_config;
+
+/* Zero-copy view of one stored block; valid until the store changes */
+typedef struct {
+    const uint8_t *data;
+    uint32_t len;
+    uint32_t height;
+    const uint8_t *hash;        /* 32 bytes */
+} bloom_block_ref;
+
+typedef struct bloom_store bloom_store;
+
+/*
+ * Open or create the store in directory dir (which must exist) and run
+ * recovery. cfg may be NULL. Returns NULL and sets *status on failure.
+ */
+bloom_store *bloom_store_open(const char *dir, const bloom_store_config *cfg, int *status);
+
+/* Commit pending blocks and release everything */
+void bloom_store_close(bloom_store *s);
+
+/* Append the block at the next height; returns the height or < 0 */
+long bloom_store_append(bloom_store *s, const uint8_t hash[32],
+                        const uint8_t *data, uint32_t len);
+
+/* Make every appended block durable (fsync segments, then the index) */
+int bloom_store_commit(bloom_store *s);
+
+uint32_t bloom_store_count(const bloom_store *s);      /* blocks stored */
+uint32_t bloom_store_durable(const bloom_store *s);    /* blocks committed */
+uint32_t bloom_store_recovered(const bloom_store *s);  /* found by the tail scan */
+
+int bloom_store_get(bloom_store *s, uint32_t height, bloom_block_ref *out);
+
+/* Height of the block with this hash, or BLOOM_STORE_ERR_NOT_FOUND */
+long bloom_store_find(const bloom_store *s, const uint8_t hash[32]);
+
+/* Blocks [start, end) clipped to the store; returns the number filled */
+long bloom_store_range(bloom_store *s, uint32_t start, uint32_t end, bloom_block_ref *out);
+
+/* Re-hash a block's data against its stored checksum */
+int bloom_store_verify(bloom_store *s, uint32_t height);
+
+/* Drop every block at or above height (durably) */
+int bloom_store_truncate(bloom_store *s, uint32_t height);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOOM_STORE_H */
@@ -0,0 +1,504 @@
+/*
+ * BloomCoin Crystal Ledger Synchronization
+ * ========================================
+ *
+ * Compile: gcc -O3 -c nexthash256.c
+ *          gcc -O3 -fopenmp -o bloom_sync bloom_sync.c nexthash256.o -DTEST_MAIN
+ */
+
+#include "bloom_sync.h"
+#include "nexthash256.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Nodes hashed per nexthash256_batch() call */
+#define HASH_CHUNK 256
+
+/* 0x01 || level || count u64 || left || right */
+#define NODE_MSG 74
+
+struct bloom_sync_ledger {
+    uint8_t (*nodes[BLOOM_SYNC_LEVELS])[32];  /* level 0 = block hashes */
+    size_t caps[BLOOM_SYNC_LEVELS];
+    size_t n;
+
+    /* Block positions changed since the last commit */
+    uint32_t *dirty;
+    size_t n_dirty, dirty_cap;
+};
+
+static const uint8_t zero_digest[32];
+
+/* ========================================================================== */
+/* Helpers                                                                     */
+/* ========================================================================== */
+
+static void store64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static size_t level_size(size_t n, int level) {
+    return (size_t)(((uint64_t)n + ((uint64_t)1 << level) - 1) >> level);
+}
+
+static int cmp_u32(const void *x, const void *y) {
+    uint32_t a = *(const uint32_t *)x, b = *(const uint32_t *)y;
+    return (a > b) - (a < b);
+}
+
+static int mark_dirty(bloom_sync_ledger *l, uint32_t pos) {
+    if (l->n_dirty == l->dirty_cap) {
+        size_t cap = l->dirty_cap ? 2 * l->dirty_cap : 256;
+        uint32_t *d = (uint32_t *)realloc(l->dirty, cap * sizeof(uint32_t));
+        if (!d) return BLOOM_SYNC_ERR_NOMEM;
+        l->dirty = d;
+        l->dirty_cap = cap;
+    }
+    l->dirty[l->n_dirty++] = pos;
+    return BLOOM_SYNC_OK;
+}
+
+static const uint8_t *node(const bloom_sync_ledger *l, int level, uint64_t index) {
+    return index < level_size(l->n, level) ? l->nodes[level][index] : zero_digest;
+}
+
+/* ========================================================================== */
+/* Ledger                                                                      */
+/* ========================================================================== */
+
+bloom_sync_ledger *bloom_sync_create(void) {
+    return (bloom_sync_ledger *)calloc(1, sizeof(bloom_sync_ledger));
+}
+
+void bloom_sync_destroy(bloom_sync_ledger *l) {
+    if (!l) return;
+    for (int i = 0; i < BLOOM_SYNC_LEVELS; i++) free(l->nodes[i]);
+    free(l->dirty);
+    free(l);
+}
+
+size_t bloom_sync_count(const bloom_sync_ledger *l) {
+    return l->n;
+}
+
+const uint8_t *bloom_sync_block(const bloom_sync_ledger *l, uint32_t pos) {
+    return pos < l->n ? l->nodes[0][pos] : NULL;
+}
+
+/* Room for n blocks on every level */
+static int reserve(bloom_sync_ledger *l, size_t n) {
+    for (int i = 0; i < BLOOM_SYNC_LEVELS; i++) {
+        size_t need = level_size(n, i);
+        if (need <= l->caps[i]) continue;
+        size_t cap = l->caps[i] ? l->caps[i] : 16;
+        while (cap < need) cap *= 2;
+        void *p = realloc(l->nodes[i], cap * 32);
+        if (!p) return BLOOM_SYNC_ERR_NOMEM;
+        l->nodes[i] = (uint8_t (*)[32])p;
+        l->caps[i] = cap;
+    }
+    return BLOOM_SYNC_OK;
+}
+
+int bloom_sync_append(bloom_sync_ledger *l, const uint8_t (*hashes)[32], size_t n) {
+    if (n == 0) return BLOOM_SYNC_OK;
+    if (l->n + n > UINT32_MAX) return BLOOM_SYNC_ERR_INVALID;
+    if (reserve(l, l->n + n)) return BLOOM_SYNC_ERR_NOMEM;
+    memcpy(l->nodes[0][l->n], hashes, n * 32);
+    /* Every ancestor of an appended block is an ancestor of one of these */
+    for (size_t pos = l->n & ~(size_t)1; pos < l->n + n; pos += 2) {
+        if (mark_dirty(l, (uint32_t)pos)) return BLOOM_SYNC_ERR_NOMEM;
+    }
+    l->n += n;
+    return BLOOM_SYNC_OK;
+}
+
+int bloom_sync_set(bloom_sync_ledger *l, uint32_t pos, const uint8_t hash[32]) {
+    if (pos >= l->n) return BLOOM_SYNC_ERR_INVALID;
+    memcpy(l->nodes[0][pos], hash, 32);
+    return mark_dirty(l, pos);
+}
+
+int bloom_sync_truncate(bloom_sync_ledger *l, size_t n) {
+    if (n > l->n) return BLOOM_SYNC_ERR_INVALID;
+    if (n == l->n) return BLOOM_SYNC_OK;
+    l->n = n;
+    size_t kept = 0;
+    for (size_t i = 0; i < l->n_dirty; i++) {
+        if (l->dirty[i] < n) l->dirty[kept++] = l->dirty[i];
+    }
+    l->n_dirty = kept;
+    return n ? mark_dirty(l, (uint32_t)(n - 1)) : BLOOM_SYNC_OK;
+}
+
+int bloom_sync_commit(bloom_sync_ledger *l) {
+    if (l->n_dirty == 0) return BLOOM_SYNC_OK;
+    qsort(l->dirty, l->n_dirty, sizeof(uint32_t), cmp_u32);
+
+    uint8_t *msgs = (uint8_t *)malloc(l->n_dirty * NODE_MSG);
+    if (!msgs) return BLOOM_SYNC_ERR_NOMEM;
+
+    /* dirty[] holds the level's dirty indices, turned into parents in place */
+    size_t n = l->n_dirty;
+    for (int level = 1; level < BLOOM_SYNC_LEVELS; level++) {
+        size_t m = 0, size = level_size(l->n, level);
+        for (size_t i = 0; i < n; i++) {
+            uint32_t parent = l->dirty[i] >> 1;
+            if (parent < size && (m == 0 || l->dirty[m - 1] != parent)) l->dirty[m++] = parent;
+        }
+        n = m;
+
+        for (size_t i = 0; i < n; i++) {
+            uint64_t k = l->dirty[i], start = k << level;
+            uint64_t count = l->n - start < ((uint64_t)1 << level) ? l->n - start
+                                                                    : (uint64_t)1 << level;
+            uint8_t *msg = msgs + i * NODE_MSG;
+            msg[0] = 0x01;
+            msg[1] = (uint8_t)level;
+            store64(msg + 2, count);
+            memcpy(msg + 10, node(l, level - 1, 2 * k), 32);
+            memcpy(msg + 42, node(l, level - 1, 2 * k + 1), 32);
+        }
+
+        long n_chunks = (long)((n + HASH_CHUNK - 1) / HASH_CHUNK);
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(static) if (n_chunks > 4)
+#endif
+        for (long c = 0; c < n_chunks; c++) {
+            const uint8_t *ptrs[HASH_CHUNK];
+            size_t lens[HASH_CHUNK];
+            uint8_t digests[HASH_CHUNK][32];
+            size_t from = (size_t)c * HASH_CHUNK;
+            size_t cnt = n - from < HASH_CHUNK ? n - from : HASH_CHUNK;
+            for (size_t t = 0; t < cnt; t++) {
+                ptrs[t] = msgs + (from + t) * NODE_MSG;
+                lens[t] = NODE_MSG;
+            }
+            nexthash256_batch(ptrs, lens, cnt, digests);
+            for (size_t t = 0; t < cnt; t++) {
+                memcpy(l->nodes[level][l->dirty[from + t]], digests[t], 32);
+            }
+        }
+    }
+    free(msgs);
+    l->n_dirty = 0;
+    return BLOOM_SYNC_OK;
+}
+
+int bloom_sync_root(const bloom_sync_ledger *l, uint8_t root[32]) {
+    if (l->n_dirty) return BLOOM_SYNC_ERR_DIRTY;
+    memcpy(root, node(l, BLOOM_SYNC_LEVELS - 1, 0), 32);
+    return BLOOM_SYNC_OK;
+}
+
+/* ========================================================================== */
+/* Reconciliation                                                              */
+/* ========================================================================== */
+
+int bloom_sync_answer(const bloom_sync_ledger *l, const bloom_sync_range *ranges, size_t n,
+                      uint8_t (*digests)[32]) {
+    if (l->n_dirty) return BLOOM_SYNC_ERR_DIRTY;
+    for (size_t i = 0; i < n; i++) {
+        if (ranges[i].level >= BLOOM_SYNC_LEVELS) return BLOOM_SYNC_ERR_INVALID;
+        memcpy(digests[i], node(l, ranges[i].level, ranges[i].index), 32);
+    }
+    return BLOOM_SYNC_OK;
+}
+
+int bloom_sync_fetch_local(void *ctx, const bloom_sync_range *ranges, size_t n,
+                           uint8_t (*digests)[32]) {
+    return bloom_sync_answer((const bloom_sync_ledger *)ctx, ranges, n, digests);
+}
+
+static int cmp_span(const void *x, const void *y) {
+    const bloom_sync_span *a = (const bloom_sync_span *)x, *b = (const bloom_sync_span *)y;
+    return (a->start > b->start) - (a->start < b->start);
+}
+
+typedef struct {
+    void *p;
+    size_t n, cap, elem;
+} vec;
+
+static void *vec_push(vec *v) {
+    if (v->n == v->cap) {
+        size_t cap = v->cap ? 2 * v->cap : 64;
+        void *p = realloc(v->p, cap * v->elem);
+        if (!p) return NULL;
+        v->p = p;
+        v->cap = cap;
+    }
+    return (uint8_t *)v->p + v->elem * v->n++;
+}
+
+long bloom_sync_diff(const bloom_sync_ledger *l, size_t remote_count,
+                     bloom_sync_fetch fetch, void *ctx,
+                     bloom_sync_span *out, size_t max, bloom_sync_stats *stats) {
+    if (l->n_dirty) return BLOOM_SYNC_ERR_DIRTY;
+    if (remote_count > UINT32_MAX) return BLOOM_SYNC_ERR_INVALID;
+    uint64_t lo_n = l->n < remote_count ? l->n : remote_count;
+    uint64_t hi_n = l->n > remote_count ? l->n : remote_count;
+    if (stats) memset(stats, 0, sizeof(*stats));
+    if (hi_n == 0) return 0;
+
+    vec pending = { NULL, 0, 0, sizeof(bloom_sync_range) };
+    vec next = { NULL, 0, 0, sizeof(bloom_sync_range) };
+    vec spans = { NULL, 0, 0, sizeof(bloom_sync_span) };
+    uint8_t (*digests)[32] = NULL;
+    size_t digests_cap = 0;
+    long st = BLOOM_SYNC_ERR_NOMEM;
+
+    int top = 0;
+    while (((uint64_t)1 << top) < hi_n) top++;
+    bloom_sync_range *root = (bloom_sync_range *)vec_push(&pending);
+    if (!root) goto done;
+    root->level = (uint8_t)top;
+    root->index = 0;
+
+    while (pending.n) {
+        bloom_sync_range *r = (bloom_sync_range *)pending.p;
+
+        /* Ranges past the shorter ledger differ outright */
+        size_t ask = 0;
+        for (size_t i = 0; i < pending.n; i++) {
+            uint64_t start = (uint64_t)r[i].index << r[i].level;
+            if (start < lo_n) {
+                r[ask++] = r[i];
+                continue;
+            }
+            uint64_t end = start + ((uint64_t)1 << r[i].level);
+            bloom_sync_span *s = (bloom_sync_span *)vec_push(&spans);
+            if (!s) goto done;
+            s->start = (uint32_t)start;
+            s->count = (uint32_t)((end < hi_n ? end : hi_n) - start);
+        }
+        if (ask == 0) break;
+
+        if (ask > digests_cap) {
+            free(digests);
+            digests_cap = 2 * ask;
+            digests = (uint8_t (*)[32])malloc(digests_cap * 32);
+            if (!digests) goto done;
+        }
+        st = fetch(ctx, r, ask, digests);
+        if (st != BLOOM_SYNC_OK) goto done;
+        st = BLOOM_SYNC_ERR_NOMEM;
+        if (stats) {
+            stats->rounds++;
+            stats->ranges += ask;
+        }
+
+        next.n = 0;
+        for (size_t i = 0; i < ask; i++) {
+            if (memcmp(digests[i], node(l, r[i].level, r[i].index), 32) == 0) continue;
+            if (r[i].level == 0) {
+                bloom_sync_span *s = (bloom_sync_span *)vec_push(&spans);
+                if (!s) goto done;
+                s->start = r[i].index;
+                s->count = 1;
+                continue;
+            }
+            for (uint32_t c = 0; c < 2; c++) {
+                uint64_t k = 2 * (uint64_t)r[i].index + c;
+                if ((k << (r[i].level - 1)) >= hi_n) break;
+                bloom_sync_range *child = (bloom_sync_range *)vec_push(&next);
+                if (!child) goto done;
+                child->level = (uint8_t)(r[i].level - 1);
+                child->index = (uint32_t)k;
+            }
+        }
+        vec t = pending;
+        pending = next;
+        next = t;
+    }
+
+    /* Sort and merge adjacent spans */
+    bloom_sync_span *s = (bloom_sync_span *)spans.p;
+    size_t m = 0;
+    if (spans.n) {                  /* identical trees leave spans.p NULL */
+        qsort(s, spans.n, sizeof(bloom_sync_span), cmp_span);
+        for (size_t i = 0; i < spans.n; i++) {
+            if (m && s[m - 1].start + s[m - 1].count == s[i].start) s[m - 1].count += s[i].count;
+            else s[m++] = s[i];
+        }
+        if (max) memcpy(out, s, (m < max ? m : max) * sizeof(bloom_sync_span));
+    }
+    st = (long)m;
+
+done:
+    free(pending.p);
+    free(next.p);
+    free(spans.p);
+    free(digests);
+    return st;
+}
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <stdio.h>
+#include <time.h>
+
+static uint64_t test_rng = 0x9E3779B97F4A7C15ull;
+
+static uint64_t xorshift(void) {
+    test_rng ^= test_rng << 13;
+    test_rng ^= test_rng >> 7;
+    test_rng ^= test_rng << 17;
+    return test_rng;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void random_hash(uint8_t h[32]) {
+    for (int i = 0; i < 32; i += 8) store64(h + i, xorshift());
+}
+
+/* Make l equal to r by copying the spans a diff reported */
+static void apply(bloom_sync_ledger *l, const bloom_sync_ledger *r,
+                  const bloom_sync_span *spans, long n) {
+    size_t rn = bloom_sync_count(r);
+    if (bloom_sync_count(l) > rn) bloom_sync_truncate(l, rn);
+    for (long i = 0; i < n; i++) {
+        for (uint32_t p = spans[i].start; p < spans[i].start + spans[i].count && p < rn; p++) {
+            if (p < bloom_sync_count(l)) bloom_sync_set(l, p, bloom_sync_block(r, p));
+            else bloom_sync_append(l, (const uint8_t (*)[32])bloom_sync_block(r, p), 1);
+        }
+    }
+    bloom_sync_commit(l);
+}
+
+static int same_root(const bloom_sync_ledger *a, const bloom_sync_ledger *b) {
+    uint8_t ra[32], rb[32];
+    return bloom_sync_root(a, ra) == BLOOM_SYNC_OK && bloom_sync_root(b, rb) == BLOOM_SYNC_OK &&
+           memcmp(ra, rb, 32) == 0;
+}
+
+int main(void) {
+    int fail = 0, ok;
+    printf("BloomCoin Crystal Ledger Synchronization\n");
+    printf("========================================\n\n");
+
+    enum { N = 1 << 20 };
+    uint8_t (*blocks)[32] = malloc((size_t)(N + 4096) * 32);
+    for (size_t i = 0; i < N + 4096; i++) random_hash(blocks[i]);
+
+    /* Incremental commits give the same tree as one bulk commit */
+    {
+        bloom_sync_ledger *a = bloom_sync_create(), *b = bloom_sync_create();
+        bloom_sync_append(a, (const uint8_t (*)[32])blocks, 1000);
+        bloom_sync_commit(a);
+        for (size_t i = 0; i < 1200; i++) {
+            bloom_sync_append(b, (const uint8_t (*)[32])blocks[i], 1);
+            if (xorshift() % 7 == 0) bloom_sync_commit(b);
+        }
+        bloom_sync_truncate(b, 1000);
+        bloom_sync_commit(b);
+        uint8_t root[32];
+        ok = same_root(a, b) && bloom_sync_set(b, 5, blocks[6]) == BLOOM_SYNC_OK &&
+             bloom_sync_root(b, root) == BLOOM_SYNC_ERR_DIRTY;
+        bloom_sync_commit(b);
+        ok &= !same_root(a, b);
+        bloom_sync_set(b, 5, blocks[5]);
+        bloom_sync_commit(b);
+        ok &= same_root(a, b);
+        /* Shorter prefix differs even with the last block zero */
+        bloom_sync_truncate(b, 999);
+        bloom_sync_commit(b);
+        ok &= !same_root(a, b);
+        printf("incremental commit:       %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+        bloom_sync_destroy(a);
+        bloom_sync_destroy(b);
+    }
+
+    bloom_sync_ledger *local = bloom_sync_create(), *remote = bloom_sync_create();
+    double t0 = now_sec();
+    bloom_sync_append(local, (const uint8_t (*)[32])blocks, N);
+    bloom_sync_commit(local);
+    double t1 = now_sec();
+    bloom_sync_append(remote, (const uint8_t (*)[32])blocks, N);
+    bloom_sync_commit(remote);
+    printf("tree build:               %d blocks in %.0f ms\n", N, 1e3 * (t1 - t0));
+
+    bloom_sync_span spans[64];
+    bloom_sync_stats stats;
+    long n = bloom_sync_diff(local, N, bloom_sync_fetch_local, remote, spans, 64, &stats);
+    ok = n == 0 && stats.rounds == 1 && stats.ranges == 1;
+    printf("identical ledgers:        %ld spans, %llu digest  %s\n", n,
+           (unsigned long long)stats.ranges, ok ? "OK" : "FAIL");
+    fail |= !ok;
+
+    /* Scattered edits on the remote side */
+    {
+        enum { D = 16 };
+        uint32_t pos[D];
+        for (int i = 0; i < D; i++) {
+            uint8_t h[32];
+            pos[i] = (uint32_t)(xorshift() % N);
+            random_hash(h);
+            bloom_sync_set(remote, pos[i], h);
+        }
+        t0 = now_sec();
+        bloom_sync_commit(remote);
+        t1 = now_sec();
+        qsort(pos, D, sizeof(uint32_t), cmp_u32);
+        n = bloom_sync_diff(local, N, bloom_sync_fetch_local, remote, spans, 64, &stats);
+        double t2 = now_sec();
+        long want = 0;
+        ok = 1;
+        for (int i = 0; i < D; i++) {
+            if (i && pos[i] == pos[i - 1]) continue;
+            ok &= want < n && spans[want].start == pos[i] && spans[want].count == 1;
+            want++;
+        }
+        ok &= n == want && stats.ranges <= (uint64_t)2 * D * 21 + 1;
+        printf("%d scattered edits:       %ld spans, %llu digests in %u rounds, "
+               "commit %.2f ms, diff %.2f ms  %s\n", D, n, (unsigned long long)stats.ranges,
+               stats.rounds, 1e3 * (t1 - t0), 1e3 * (t2 - t1), ok ? "OK" : "FAIL");
+        fail |= !ok;
+        apply(local, remote, spans, n);
+        ok = same_root(local, remote);
+        printf("  apply:                  %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Fork: remote replaces the last 1000 blocks with 3000 of its own */
+    {
+        bloom_sync_truncate(remote, N - 1000);
+        bloom_sync_append(remote, (const uint8_t (*)[32])blocks[N], 3000);
+        bloom_sync_commit(remote);
+        n = bloom_sync_diff(local, bloom_sync_count(remote), bloom_sync_fetch_local, remote,
+                            spans, 64, &stats);
+        ok = n == 1 && spans[0].start == N - 1000 && spans[0].count == 3000;
+        printf("forked tip:               [%u, +%u), %llu digests in %u rounds  %s\n",
+               n > 0 ? spans[0].start : 0, n > 0 ? spans[0].count : 0,
+               (unsigned long long)stats.ranges, stats.rounds, ok ? "OK" : "FAIL");
+        fail |= !ok;
+        apply(local, remote, spans, n);
+        ok = same_root(local, remote) && bloom_sync_count(local) == N + 2000;
+
+        /* And back: the remote is now the shorter side */
+        bloom_sync_truncate(remote, 10);
+        bloom_sync_commit(remote);
+        n = bloom_sync_diff(local, 10, bloom_sync_fetch_local, remote, spans, 64, &stats);
+        ok &= n == 1 && spans[0].start == 10 && spans[0].count == N + 1990;
+        apply(local, remote, spans, n);
+        ok &= same_root(local, remote);
+        printf("  apply both ways:        %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    bloom_sync_destroy(local);
+    bloom_sync_destroy(remote);
+    free(blocks);
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
@@ -0,0 +1,105 @@
+/*
+ * BloomCoin Crystal Ledger Synchronization
+ * ========================================
+ *
+ * Merkle-range reconciliation for crystal-ledger chains and branches
+ * (garden/crystal_ledger/synchronizer.py, ledger.py merge_branch()). Each
+ * ledger keeps a hash tree over its block positions; two ledgers find
+ * where they differ by exchanging range digests and descending only into
+ * ranges whose digests disagree, so mostly identical ledgers of n blocks
+ * reconcile in O(d log n) digests for d differing blocks.
+ *
+ * Features:
+ * - Node over positions [k 2^l, (k+1) 2^l): the block hash at level 0,
+ *   NEXTHASH-256(0x01 || l || count u64 || left || right) above, zero when
+ *   empty; the block count makes ranges of unequal ledgers differ
+ * - Fixed 33 levels, so a range names the same positions on both sides
+ * - Appends, overwrites and truncation mark paths dirty; commit rehashes
+ *   each dirty level in nexthash256_batch() calls (OpenMP when enabled)
+ * - Breadth-first descent: one request batch per level (log n round trips);
+ *   ranges past the shorter ledger are reported without any exchange
+ * - Transport left to the caller through a fetch callback;
+ *   bloom_sync_fetch_local() answers from another in-process ledger
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef BLOOM_SYNC_H
+#define BLOOM_SYNC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLOOM_SYNC_LEVELS 33        /* level 32 is the root */
+
+/* Status codes */
+#define BLOOM_SYNC_OK            0
+#define BLOOM_SYNC_ERR_NOMEM    -1
+#define BLOOM_SYNC_ERR_INVALID  -2   /* position or range out of bounds */
+#define BLOOM_SYNC_ERR_DIRTY    -3   /* uncommitted changes */
+
+typedef struct {
+    uint8_t level;
+    uint32_t index;                 /* covers [index << level, (index + 1) << level) */
+} bloom_sync_range;
+
+typedef struct {
+    uint32_t start, count;          /* differing block positions */
+} bloom_sync_span;
+
+typedef struct {
+    uint32_t rounds;                /* fetch calls */
+    uint64_t ranges;                /* digests received */
+} bloom_sync_stats;
+
+/*
+ * Remote side of a reconciliation: fill digests[i] for ranges[i].
+ * Returns BLOOM_SYNC_OK or a negative code, which aborts the diff.
+ */
+typedef int (*bloom_sync_fetch)(void *ctx, const bloom_sync_range *ranges, size_t n,
+                                uint8_t (*digests)[32]);
+
+typedef struct bloom_sync_ledger bloom_sync_ledger;
+
+bloom_sync_ledger *bloom_sync_create(void);
+void bloom_sync_destroy(bloom_sync_ledger *l);
+
+/* Block edits; take effect in the tree at the next commit */
+int bloom_sync_append(bloom_sync_ledger *l, const uint8_t (*hashes)[32], size_t n);
+int bloom_sync_set(bloom_sync_ledger *l, uint32_t pos, const uint8_t hash[32]);
+int bloom_sync_truncate(bloom_sync_ledger *l, size_t n);
+
+/* Rehash dirty nodes */
+int bloom_sync_commit(bloom_sync_ledger *l);
+
+size_t bloom_sync_count(const bloom_sync_ledger *l);
+const uint8_t *bloom_sync_block(const bloom_sync_ledger *l, uint32_t pos);
+int bloom_sync_root(const bloom_sync_ledger *l, uint8_t root[32]);
+
+/* Digests of ranges, for answering a remote diff */
+int bloom_sync_answer(const bloom_sync_ledger *l, const bloom_sync_range *ranges, size_t n,
+                      uint8_t (*digests)[32]);
+
+/* Fetch callback with ctx = the remote bloom_sync_ledger */
+int bloom_sync_fetch_local(void *ctx, const bloom_sync_range *ranges, size_t n,
+                           uint8_t (*digests)[32]);
+
+/*
+ * Positions where l differs from a remote ledger of remote_count blocks,
+ * as sorted disjoint spans. Writes at most max spans and returns the total
+ * number found, or a negative status code. stats may be NULL.
+ */
+long bloom_sync_diff(const bloom_sync_ledger *l, size_t remote_count,
+                     bloom_sync_fetch fetch, void *ctx,
+                     bloom_sync_span *out, size_t max, bloom_sync_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOOM_SYNC_H */
@@ -0,0 +1,339 @@
+/*
+ * BloomCoin Team Mining Tick Engine
+ * =================================
+ *
+ * Compile: gcc -O3 -c nexthash256.c nexthash_rng.c
+ *          gcc -O3 -fopenmp -o bloom_team bloom_team.c nexthash_rng.o nexthash256.o -lm -DTEST_MAIN
+ */
+
+#include "bloom_team.h"
+#include "nexthash256.h"
+#include "nexthash_rng.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Attempts hashed and scored per chunk */
+#define CHUNK     256
+#define MSG_SLOT  64                /* bytes per formatted attempt */
+#define MAX_ROUNDS 52
+
+struct bloom_team_engine {
+    uint32_t key[8];                /* chance-roll stream */
+    uint64_t tick;
+
+    /* Per-tick scratch, grown on demand */
+    size_t cap;
+    uint32_t *order;                /* attempt slots sorted by round count */
+    uint8_t *zeros;                 /* leading zero digits per attempt */
+    uint8_t *flags;                 /* ATTEMPT_* per attempt */
+};
+
+#define ATTEMPT_SUCCESS 1
+#define ATTEMPT_HASH    2
+
+/* ========================================================================== */
+/* Helpers                                                                     */
+/* ========================================================================== */
+
+static int leading_zero_hex(const uint8_t d[32]) {
+    int z = 0;
+    for (int i = 0; i < 32; i++) {
+        if (d[i] == 0) {
+            z += 2;
+            continue;
+        }
+        if (d[i] < 0x10) z++;
+        break;
+    }
+    return z;
+}
+
+static size_t put_decimal(char *p, uint64_t v) {
+    char tmp[20];
+    size_t n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    for (size_t i = 0; i < n; i++) p[i] = tmp[n - 1 - i];
+    return n;
+}
+
+/* "<id>:<tick>:<attempt>" into p; returns its length */
+static size_t format_attempt(char *p, const char *id, uint64_t tick, uint32_t attempt) {
+    size_t n = strlen(id);
+    memcpy(p, id, n);
+    p[n++] = ':';
+    n += put_decimal(p + n, tick);
+    p[n++] = ':';
+    n += put_decimal(p + n, attempt);
+    return n;
+}
+
+static int reserve(bloom_team_engine *e, size_t n) {
+    if (n <= e->cap) return BLOOM_TEAM_OK;
+    uint32_t *order = (uint32_t *)realloc(e->order, n * sizeof(uint32_t));
+    if (order) e->order = order;
+    uint8_t *zeros = (uint8_t *)realloc(e->zeros, n);
+    if (zeros) e->zeros = zeros;
+    uint8_t *flags = (uint8_t *)realloc(e->flags, n);
+    if (flags) e->flags = flags;
+    if (!order || !zeros || !flags) return BLOOM_TEAM_ERR_NOMEM;
+    e->cap = n;
+    return BLOOM_TEAM_OK;
+}
+
+/* ========================================================================== */
+/* Engine                                                                      */
+/* ========================================================================== */
+
+bloom_team_engine *bloom_team_engine_create(uint64_t seed) {
+    bloom_team_engine *e = (bloom_team_engine *)calloc(1, sizeof(*e));
+    if (!e) return NULL;
+    nexthash_rng_key(e->key, seed, 0x7465616D);     /* "team" */
+    return e;
+}
+
+void bloom_team_engine_destroy(bloom_team_engine *e) {
+    if (!e) return;
+    free(e->order);
+    free(e->zeros);
+    free(e->flags);
+    free(e);
+}
+
+uint64_t bloom_team_engine_ticks(const bloom_team_engine *e) {
+    return e->tick;
+}
+
+/*
+ * Hash and score attempt slots order[from, to). Slot s is attempt
+ * s % attempts of companion s / attempts; its chance rolls sit at stream
+ * position base + s * BLOOM_TEAM_MAX_ROLLS.
+ */
+static void run_chunk(const bloom_team_engine *e, const bloom_companion *companions,
+                      const float *multipliers, uint32_t difficulty, uint32_t attempts,
+                      uint64_t base, size_t from, size_t to) {
+    char msgs[CHUNK][MSG_SLOT];
+    const uint8_t *ptrs[CHUNK];
+    size_t lens[CHUNK];
+    uint8_t rounds[CHUNK];
+    uint8_t digests[CHUNK][32];
+    size_t cnt = to - from;
+
+    if (cnt == 0) return;
+    for (size_t k = 0; k < cnt; k++) {
+        uint32_t slot = e->order[from + k];
+        const bloom_companion *c = &companions[slot / attempts];
+        lens[k] = format_attempt(msgs[k], c->id, e->tick, slot % attempts);
+        ptrs[k] = (const uint8_t *)msgs[k];
+        rounds[k] = c->rounds;
+    }
+    nexthash256_batch_rounds(ptrs, lens, rounds, cnt, digests);
+
+    for (size_t k = 0; k < cnt; k++) {
+        uint32_t slot = e->order[from + k];
+        const bloom_companion *c = &companions[slot / attempts];
+        int eff = (int)difficulty - c->difficulty_reduction;
+        if (eff < 1) eff = 1;
+        int z = leading_zero_hex(digests[k]);
+        uint8_t flags = 0;
+
+        if (z >= eff) {
+            flags = ATTEMPT_SUCCESS | ATTEMPT_HASH;
+        } else {
+            float chance = c->mining_power * multipliers[c->team] * c->luck /
+                           (float)(1ull << (eff < 63 ? eff : 63));
+            float u[BLOOM_TEAM_MAX_ROLLS];
+            nexthash_rng_uniform_f32_at(e->key, base + (uint64_t)slot * BLOOM_TEAM_MAX_ROLLS,
+                                        u, c->rolls);
+            for (int r = 0; r < c->rolls; r++) {
+                if (u[r] < chance) {
+                    flags = ATTEMPT_SUCCESS;
+                    break;
+                }
+            }
+        }
+        e->zeros[slot] = (uint8_t)z;
+        e->flags[slot] = flags;
+    }
+}
+
+int bloom_team_tick(bloom_team_engine *e, const bloom_companion *companions, size_t n,
+                    const float *multipliers, size_t n_teams,
+                    uint32_t difficulty, uint32_t attempts,
+                    bloom_companion_result *out) {
+    size_t total = n * attempts;
+    for (size_t i = 0; i < n; i++) {
+        const bloom_companion *c = &companions[i];
+        if (c->team >= n_teams || c->rolls > BLOOM_TEAM_MAX_ROLLS ||
+            memchr(c->id, 0, BLOOM_TEAM_ID_MAX) == NULL) {
+            return BLOOM_TEAM_ERR_INVALID;
+        }
+    }
+    if (total > UINT32_MAX || reserve(e, total) != BLOOM_TEAM_OK) {
+        return BLOOM_TEAM_ERR_NOMEM;
+    }
+
+    /* Counting sort of attempt slots by round count */
+    size_t start[MAX_ROUNDS + 2] = { 0 };
+    for (size_t i = 0; i < n; i++) {
+        int r = companions[i].rounds > MAX_ROUNDS ? MAX_ROUNDS : companions[i].rounds;
+        start[r + 1] += attempts;
+    }
+    for (int r = 1; r <= MAX_ROUNDS + 1; r++) start[r] += start[r - 1];
+    for (size_t i = 0; i < n; i++) {
+        int r = companions[i].rounds > MAX_ROUNDS ? MAX_ROUNDS : companions[i].rounds;
+        for (uint32_t a = 0; a < attempts; a++) {
+            e->order[start[r]++] = (uint32_t)(i * attempts + a);
+        }
+    }
+
+    uint64_t base = e->tick * ((uint64_t)UINT32_MAX + 1) * BLOOM_TEAM_MAX_ROLLS;
+    long n_chunks = (long)((total + CHUNK - 1) / CHUNK);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 4)
+#endif
+    for (long ch = 0; ch < n_chunks; ch++) {
+        size_t from = (size_t)ch * CHUNK;
+        size_t to = from + CHUNK < total ? from + CHUNK : total;
+        run_chunk(e, companions, multipliers, difficulty, attempts, base, from, to);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        bloom_companion_result r = { 0, 0, 0 };
+        for (uint32_t a = 0; a < attempts; a++) {
+            size_t slot = i * attempts + a;
+            r.successes += (e->flags[slot] & ATTEMPT_SUCCESS) != 0;
+            r.hash_hits += (e->flags[slot] & ATTEMPT_HASH) != 0;
+            if (e->zeros[slot] > r.best_zeros) r.best_zeros = e->zeros[slot];
+        }
+        out[i] = r;
+    }
+    e->tick++;
+    return BLOOM_TEAM_OK;
+}
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <stdio.h>
+#include <time.h>
+
+static uint64_t test_rng = 0xD1B54A32D192ED03ull;
+
+static uint64_t xorshift(void) {
+    test_rng ^= test_rng << 13;
+    test_rng ^= test_rng >> 7;
+    test_rng ^= test_rng << 17;
+    return test_rng;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(void) {
+    int fail = 0, ok;
+    printf("BloomCoin Team Mining Tick Engine\n");
+    printf("=================================\n\n");
+
+    enum { TEAMS = 2000, PER_TEAM = 5, N = TEAMS * PER_TEAM, ATTEMPTS = 6 };
+    static bloom_companion comp[N];
+    static bloom_companion_result res[N], res2[N];
+    static float mult[TEAMS];
+    for (int t = 0; t < TEAMS; t++) mult[t] = 1.0f + 0.05f * (float)(xorshift() % 8);
+    for (int i = 0; i < N; i++) {
+        bloom_companion *c = &comp[i];
+        snprintf(c->id, sizeof(c->id), "%016llx", (unsigned long long)xorshift());
+        c->team = (uint32_t)(i / PER_TEAM);
+        c->mining_power = 1.0f + (float)(xorshift() % 400) / 100.0f;
+        c->luck = 1.0f;
+        c->rounds = (uint8_t)(xorshift() % 4 == 0 ? 48 : 52);
+        c->difficulty_reduction = (uint8_t)(c->rounds == 48 ? 2 : 0);
+        c->rolls = (uint8_t)(xorshift() % 5 == 0 ? 3 : 1);
+    }
+
+    bloom_team_engine *e = bloom_team_engine_create(42);
+    double t0 = now_sec();
+    int ticks = 0;
+    while (now_sec() - t0 < 1.0 || ticks < 3) {
+        if (bloom_team_tick(e, comp, N, mult, TEAMS, 4, ATTEMPTS, res) != BLOOM_TEAM_OK) fail = 1;
+        ticks++;
+    }
+    double t1 = now_sec();
+    printf("throughput:               %.0f teams/s (%.0f attempts/s)\n",
+           ticks * TEAMS / (t1 - t0), (double)ticks * N * ATTEMPTS / (t1 - t0));
+
+    /* Reproducible from (seed, tick) */
+    bloom_team_engine *e2 = bloom_team_engine_create(42);
+    for (int t = 0; t < ticks; t++) bloom_team_tick(e2, comp, N, mult, TEAMS, 4, ATTEMPTS, res2);
+    ok = memcmp(res, res2, sizeof(res)) == 0 && bloom_team_engine_ticks(e2) == (uint64_t)ticks;
+    printf("deterministic replay:     %s\n", ok ? "OK" : "FAIL");
+    fail |= !ok;
+
+    /* Digest outcomes against per-message hashing */
+    ok = 1;
+    uint64_t tick = (uint64_t)ticks - 1;
+    for (int i = 0; i < N && ok; i += 37) {
+        const bloom_companion *c = &comp[i];
+        int eff = 4 - c->difficulty_reduction, hits = 0, best = 0;
+        for (int a = 0; a < ATTEMPTS; a++) {
+            char msg[MSG_SLOT];
+            const uint8_t *p = (const uint8_t *)msg;
+            size_t len = format_attempt(msg, c->id, tick, (uint32_t)a);
+            uint8_t d[1][32];
+            nexthash256_batch_rounds(&p, &len, &c->rounds, 1, d);
+            int z = leading_zero_hex(d[0]);
+            hits += z >= eff;
+            if (z > best) best = z;
+        }
+        ok = res[i].hash_hits == hits && res[i].best_zeros == best &&
+             res[i].successes >= res[i].hash_hits;
+    }
+    printf("digests match one-shot:   %s\n", ok ? "OK" : "FAIL");
+    fail |= !ok;
+
+    /* Rates: digest hits ~16^-eff, chance rolls ~ power * mult * luck / 2^eff */
+    {
+        static bloom_companion one[4000];
+        static bloom_companion_result r1[4000];
+        float m1 = 1.0f;
+        for (int i = 0; i < 4000; i++) {
+            one[i] = comp[0];
+            snprintf(one[i].id, sizeof(one[i].id), "c%d", i);
+            one[i].team = 0;
+            one[i].rounds = 52;
+            one[i].difficulty_reduction = 0;
+            one[i].rolls = 1;
+            one[i].mining_power = 0.25f;
+        }
+        bloom_team_tick(e, one, 4000, &m1, 1, 2, 25, r1);
+        long hits = 0, succ = 0;
+        for (int i = 0; i < 4000; i++) {
+            hits += r1[i].hash_hits;
+            succ += r1[i].successes;
+        }
+        double n_att = 4000.0 * 25;
+        double hit_rate = hits / n_att, roll_rate = (succ - hits) / (n_att - hits);
+        ok = hit_rate > 0.0035 && hit_rate < 0.0043 && roll_rate > 0.058 && roll_rate < 0.067;
+        printf("success rates:            hash %.5f (1/256), roll %.4f (1/16)  %s\n",
+               hit_rate, roll_rate, ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    comp[3].team = TEAMS;
+    ok = bloom_team_tick(e, comp, N, mult, TEAMS, 4, ATTEMPTS, res) == BLOOM_TEAM_ERR_INVALID;
+    printf("invalid team index:       %s\n", ok ? "OK" : "FAIL");
+    fail |= !ok;
+
+    bloom_team_engine_destroy(e);
+    bloom_team_engine_destroy(e2);
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
@@ -0,0 +1,84 @@
+/*
+ * BloomCoin Team Mining Tick Engine
+ * =================================
+ *
+ * Native replacement for the attempt loop of CompanionMiningTeam.team_mine()
+ * (game/companion_mining_ultimate.py): every attempt of every companion in
+ * a tick, across any number of teams, is hashed in one batch and reduced
+ * to a few counters per companion. Rewards, patterns and residue stay with
+ * the Python game logic.
+ *
+ * Features:
+ * - Attempt message "<companion_id>:<tick>:<attempt>"
+ * - Per-companion NEXTHASH round counts (round_reduction skills) through
+ *   nexthash256_batch_rounds(); attempts are grouped by round count so
+ *   each eight-lane group runs to a single count
+ * - Success as in mine_with_nexthash(): the hex digest starts with
+ *   max(1, difficulty - difficulty_reduction) zeros, or else one of
+ *   `rolls` chance rolls below mining_power * team multiplier * luck /
+ *   2^effective_difficulty
+ * - Chance rolls drawn from a counter-based NEXTHASH stream, so a tick is
+ *   reproducible from (seed, tick) whatever the thread layout
+ * - OpenMP over attempt chunks when enabled
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef BLOOM_TEAM_H
+#define BLOOM_TEAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLOOM_TEAM_ID_MAX    32     /* companion id bytes incl. terminator */
+#define BLOOM_TEAM_MAX_ROLLS 4
+
+/* Status codes */
+#define BLOOM_TEAM_OK            0
+#define BLOOM_TEAM_ERR_NOMEM    -1
+#define BLOOM_TEAM_ERR_INVALID  -2   /* bad team index, rolls or id */
+
+typedef struct {
+    char id[BLOOM_TEAM_ID_MAX];     /* companion_id, NUL-terminated */
+    uint32_t team;                  /* index into the team multipliers */
+    float mining_power;             /* calculate_total_mining_power() */
+    float luck;
+    uint8_t rounds;                 /* NEXTHASH rounds per block, 1..52 */
+    uint8_t difficulty_reduction;   /* rounds_reduction */
+    uint8_t rolls;                  /* chance rolls: 3 for QUANTUM_EXPLORER, else 1 */
+} bloom_companion;
+
+typedef struct {
+    uint16_t successes;             /* blocks mined this tick */
+    uint16_t hash_hits;             /* successes met by the digest itself */
+    uint8_t best_zeros;             /* most leading zero hex digits seen */
+} bloom_companion_result;
+
+typedef struct bloom_team_engine bloom_team_engine;
+
+bloom_team_engine *bloom_team_engine_create(uint64_t seed);
+void bloom_team_engine_destroy(bloom_team_engine *e);
+
+/*
+ * Run one tick: `attempts` attempts for each of n companions, team
+ * multiplier (1 + synergy bonuses) taken from multipliers[c.team], which
+ * has n_teams entries. out[n] receives the per-companion counters.
+ */
+int bloom_team_tick(bloom_team_engine *e, const bloom_companion *companions, size_t n,
+                    const float *multipliers, size_t n_teams,
+                    uint32_t difficulty, uint32_t attempts,
+                    bloom_companion_result *out);
+
+/* Ticks run so far (the next tick's number) */
+uint64_t bloom_team_engine_ticks(const bloom_team_engine *e);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOOM_TEAM_H */
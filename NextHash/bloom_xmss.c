@@ -0,0 +1,624 @@
+/*
+ * BloomCoin Hash-Based Signatures (WOTS+ / XMSS over NEXTHASH-256)
+ * ================================================================
+ *
+ * Compile: gcc -O3 -c nexthash256.c
+ *          gcc -O3 -fopenmp -o bloom_xmss bloom_xmss.c nexthash256.o -DTEST_MAIN
+ */
+
+#include "bloom_xmss.h"
+#include "nexthash256.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Hashes per nexthash256_batch() call */
+#define HASH_CHUNK 256
+
+/* Parallelize a batch above this many hashes */
+#define PAR_MIN (4 * HASH_CHUNK)
+
+/* One-time keys generated per pass (bounds key generation memory) */
+#define KEYS_PER_PASS 256
+
+#define ADRS_BYTES 7
+#define PREFIX     (BLOOM_XMSS_SEED_BYTES + ADRS_BYTES)
+#define F_MSG      (PREFIX + 32)                      /* 55: one block */
+#define NODE_MSG   (PREFIX + 64)
+#define LEAF_MSG   (PREFIX + BLOOM_XMSS_LEN * 32)
+#define SECRET_MSG (32 + ADRS_BYTES)
+
+/* Address tags: every hash input is domain separated by one */
+enum {
+    TAG_CHAIN, TAG_LEAF, TAG_NODE, TAG_SECRET,
+    TAG_DIGEST, TAG_RANDOM, TAG_PUB_SEED, TAG_SK_SEED
+};
+
+struct bloom_xmss_key {
+    bloom_xmss_public pub;
+    uint8_t sk_seed[32];
+    uint32_t next;
+    uint8_t (*tree)[32];            /* leaves first, root last */
+};
+
+typedef struct {
+    uint8_t x[32];
+    const uint8_t *seed;            /* public seed */
+    uint32_t key;
+    uint8_t chain, start, steps;
+} chain_job;
+
+/* ========================================================================== */
+/* Helpers                                                                     */
+/* ========================================================================== */
+
+static void store32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t load32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+static void put_adrs(uint8_t *p, uint8_t tag, uint32_t key, uint8_t a, uint8_t b) {
+    p[0] = tag;
+    store32(p + 1, key);
+    p[5] = a;
+    p[6] = b;
+}
+
+/* Wipe secrets so the compiler cannot drop the stores */
+static void wipe(void *p, size_t n) {
+    volatile uint8_t *v = (volatile uint8_t *)p;
+    while (n--) *v++ = 0;
+}
+
+/* Offset of tree level l (2^(h-l) nodes) */
+static size_t level_offset(unsigned h, unsigned l) {
+    return ((size_t)2 << h) - ((size_t)2 << (h - l));
+}
+
+/* digests[i] = NEXTHASH-256(msgs + i * stride, len) */
+static void hash_all(const uint8_t *msgs, size_t stride, size_t len, size_t n,
+                     uint8_t (*digests)[32]) {
+    long n_chunks = (long)((n + HASH_CHUNK - 1) / HASH_CHUNK);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) if (n > PAR_MIN)
+#endif
+    for (long c = 0; c < n_chunks; c++) {
+        const uint8_t *ptrs[HASH_CHUNK];
+        size_t lens[HASH_CHUNK];
+        size_t from = (size_t)c * HASH_CHUNK;
+        size_t cnt = n - from < HASH_CHUNK ? n - from : HASH_CHUNK;
+        for (size_t t = 0; t < cnt; t++) {
+            ptrs[t] = msgs + (from + t) * stride;
+            lens[t] = len;
+        }
+        nexthash256_batch(ptrs, lens, cnt, digests + from);
+    }
+}
+
+/* ========================================================================== */
+/* WOTS Chains                                                                 */
+/* ========================================================================== */
+
+/*
+ * Advance every job by its step count. Jobs are ordered by steps, longest
+ * first, so the chains still running in round r are a prefix and each
+ * round is one dense batch.
+ */
+static int run_chains(chain_job *jobs, size_t n) {
+    size_t at_least[BLOOM_XMSS_W + 1] = { 0 };
+    uint32_t *order = (uint32_t *)malloc((n ? n : 1) * sizeof(uint32_t));
+    if (!order) return BLOOM_XMSS_ERR_NOMEM;
+
+    for (size_t i = 0; i < n; i++) at_least[jobs[i].steps]++;
+    for (int s = BLOOM_XMSS_W - 1; s >= 0; s--) at_least[s] += at_least[s + 1];
+    size_t fill[BLOOM_XMSS_W];
+    for (int s = 0; s < BLOOM_XMSS_W; s++) fill[s] = at_least[s + 1];
+    for (size_t i = 0; i < n; i++) order[fill[jobs[i].steps]++] = (uint32_t)i;
+
+    for (int r = 0; r < BLOOM_XMSS_W - 1; r++) {
+        size_t active = at_least[r + 1];
+        if (active == 0) break;
+        long n_chunks = (long)((active + HASH_CHUNK - 1) / HASH_CHUNK);
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(static) if (active > PAR_MIN)
+#endif
+        for (long c = 0; c < n_chunks; c++) {
+            uint8_t msgs[HASH_CHUNK][F_MSG];
+            const uint8_t *ptrs[HASH_CHUNK];
+            size_t lens[HASH_CHUNK];
+            uint8_t digests[HASH_CHUNK][32];
+            size_t from = (size_t)c * HASH_CHUNK;
+            size_t cnt = active - from < HASH_CHUNK ? active - from : HASH_CHUNK;
+            for (size_t t = 0; t < cnt; t++) {
+                chain_job *j = &jobs[order[from + t]];
+                memcpy(msgs[t], j->seed, BLOOM_XMSS_SEED_BYTES);
+                put_adrs(msgs[t] + BLOOM_XMSS_SEED_BYTES, TAG_CHAIN, j->key, j->chain,
+                         (uint8_t)(j->start + r));
+                memcpy(msgs[t] + PREFIX, j->x, 32);
+                ptrs[t] = msgs[t];
+                lens[t] = F_MSG;
+            }
+            nexthash256_batch(ptrs, lens, cnt, digests);
+            for (size_t t = 0; t < cnt; t++) memcpy(jobs[order[from + t]].x, digests[t], 32);
+        }
+    }
+    free(order);
+    return BLOOM_XMSS_OK;
+}
+
+/* 64 message nibbles, high first, then 3 checksum nibbles */
+static void wots_digits(const uint8_t m[32], uint8_t d[BLOOM_XMSS_LEN]) {
+    uint32_t csum = 0;
+    for (int i = 0; i < 32; i++) {
+        d[2 * i] = m[i] >> 4;
+        d[2 * i + 1] = m[i] & 15;
+    }
+    for (int i = 0; i < 64; i++) csum += BLOOM_XMSS_W - 1 - d[i];
+    d[64] = (uint8_t)((csum >> 8) & 15);
+    d[65] = (uint8_t)((csum >> 4) & 15);
+    d[66] = (uint8_t)(csum & 15);
+}
+
+/* Secret chain starts of jobs[i], chain i % LEN of key jobs[i].key */
+static int secret_starts(const uint8_t sk_seed[32], chain_job *jobs, size_t n) {
+    if (n == 0) return BLOOM_XMSS_OK;
+    uint8_t *msgs = (uint8_t *)malloc(n * SECRET_MSG);
+    uint8_t (*x)[32] = (uint8_t (*)[32])malloc(n * 32);
+    if (!msgs || !x) {
+        free(msgs);
+        free(x);
+        return BLOOM_XMSS_ERR_NOMEM;
+    }
+    for (size_t i = 0; i < n; i++) {
+        memcpy(msgs + i * SECRET_MSG, sk_seed, 32);
+        put_adrs(msgs + i * SECRET_MSG + 32, TAG_SECRET, jobs[i].key, jobs[i].chain, 0);
+    }
+    hash_all(msgs, SECRET_MSG, SECRET_MSG, n, x);
+    for (size_t i = 0; i < n; i++) memcpy(jobs[i].x, x[i], 32);
+    wipe(msgs, n * SECRET_MSG);
+    wipe(x, n * 32);
+    free(msgs);
+    free(x);
+    return BLOOM_XMSS_OK;
+}
+
+/* Leaf message: compress the 67 chain ends of one-time key `key` */
+static void leaf_msg(uint8_t *msg, const uint8_t *seed, uint32_t key, const chain_job *ends) {
+    memcpy(msg, seed, BLOOM_XMSS_SEED_BYTES);
+    put_adrs(msg + BLOOM_XMSS_SEED_BYTES, TAG_LEAF, key, 0, 0);
+    for (int c = 0; c < BLOOM_XMSS_LEN; c++) memcpy(msg + PREFIX + 32 * c, ends[c].x, 32);
+}
+
+static void node_msg(uint8_t *msg, const uint8_t *seed, uint32_t index, unsigned level,
+                     const uint8_t *left, const uint8_t *right) {
+    memcpy(msg, seed, BLOOM_XMSS_SEED_BYTES);
+    put_adrs(msg + BLOOM_XMSS_SEED_BYTES, TAG_NODE, index, (uint8_t)level, 0);
+    memcpy(msg + PREFIX, left, 32);
+    memcpy(msg + PREFIX + 32, right, 32);
+}
+
+/* Message digest M = H(pub_seed || adrs(index) || R || root || msg) */
+static void message_digest(const bloom_xmss_public *pub, uint32_t index, const uint8_t R[32],
+                           const uint8_t *msg, size_t len, uint8_t m[32]) {
+    uint8_t adrs[ADRS_BYTES];
+    nexthash256_ctx ctx;
+    put_adrs(adrs, TAG_DIGEST, index, 0, 0);
+    nexthash256_init(&ctx);
+    nexthash256_update(&ctx, pub->pub_seed, BLOOM_XMSS_SEED_BYTES);
+    nexthash256_update(&ctx, adrs, ADRS_BYTES);
+    nexthash256_update(&ctx, R, 32);
+    nexthash256_update(&ctx, pub->root, 32);
+    nexthash256_update(&ctx, msg, len);
+    nexthash256_final(&ctx, m);
+}
+
+/* ========================================================================== */
+/* Keys                                                                        */
+/* ========================================================================== */
+
+bloom_xmss_key *bloom_xmss_keygen(const uint8_t secret[32], unsigned height) {
+    if (height > BLOOM_XMSS_MAX_HEIGHT) return NULL;
+    bloom_xmss_key *key = (bloom_xmss_key *)calloc(1, sizeof(*key));
+    size_t n_keys = (size_t)1 << height;
+    chain_job *jobs = (chain_job *)malloc(KEYS_PER_PASS * BLOOM_XMSS_LEN * sizeof(chain_job));
+    size_t msg_bytes = KEYS_PER_PASS * LEAF_MSG;
+    if (n_keys / 2 * NODE_MSG > msg_bytes) msg_bytes = n_keys / 2 * NODE_MSG;
+    uint8_t *msgs = (uint8_t *)malloc(msg_bytes);
+    if (!key || !jobs || !msgs) goto fail;
+    key->tree = (uint8_t (*)[32])malloc((2 * n_keys - 1) * 32);
+    if (!key->tree) goto fail;
+
+    uint8_t in[32 + ADRS_BYTES], digest[32];
+    memcpy(in, secret, 32);
+    put_adrs(in + 32, TAG_SK_SEED, 0, 0, 0);
+    nexthash256(in, sizeof(in), key->sk_seed);
+    put_adrs(in + 32, TAG_PUB_SEED, 0, 0, 0);
+    nexthash256(in, sizeof(in), digest);
+    memcpy(key->pub.pub_seed, digest, BLOOM_XMSS_SEED_BYTES);
+    key->pub.height = (uint8_t)height;
+    wipe(in, sizeof(in));
+
+    /* Leaves: full chains of KEYS_PER_PASS one-time keys at a time */
+    const uint8_t *seed = key->pub.pub_seed;
+    for (size_t base = 0; base < n_keys; base += KEYS_PER_PASS) {
+        size_t cnt = n_keys - base < KEYS_PER_PASS ? n_keys - base : KEYS_PER_PASS;
+        for (size_t i = 0; i < cnt * BLOOM_XMSS_LEN; i++) {
+            jobs[i].seed = seed;
+            jobs[i].key = (uint32_t)(base + i / BLOOM_XMSS_LEN);
+            jobs[i].chain = (uint8_t)(i % BLOOM_XMSS_LEN);
+            jobs[i].start = 0;
+            jobs[i].steps = BLOOM_XMSS_W - 1;
+        }
+        if (secret_starts(key->sk_seed, jobs, cnt * BLOOM_XMSS_LEN) ||
+            run_chains(jobs, cnt * BLOOM_XMSS_LEN)) {
+            goto fail;
+        }
+        for (size_t i = 0; i < cnt; i++) {
+            leaf_msg(msgs + i * LEAF_MSG, seed, (uint32_t)(base + i), jobs + i * BLOOM_XMSS_LEN);
+        }
+        hash_all(msgs, LEAF_MSG, LEAF_MSG, cnt, key->tree + base);
+    }
+
+    /* Inner levels, one batch each */
+    for (unsigned l = 1; l <= height; l++) {
+        size_t cnt = n_keys >> l;
+        const uint8_t (*below)[32] = (const uint8_t (*)[32])key->tree + level_offset(height, l - 1);
+        for (size_t k = 0; k < cnt; k++) {
+            node_msg(msgs + k * NODE_MSG, seed, (uint32_t)k, l, below[2 * k], below[2 * k + 1]);
+        }
+        hash_all(msgs, NODE_MSG, NODE_MSG, cnt, key->tree + level_offset(height, l));
+    }
+    memcpy(key->pub.root, key->tree[2 * n_keys - 2], 32);
+    wipe(jobs, KEYS_PER_PASS * BLOOM_XMSS_LEN * sizeof(chain_job));
+    free(jobs);
+    free(msgs);
+    return key;
+
+fail:
+    free(jobs);
+    free(msgs);
+    bloom_xmss_destroy(key);
+    return NULL;
+}
+
+void bloom_xmss_destroy(bloom_xmss_key *key) {
+    if (!key) return;
+    free(key->tree);
+    wipe(key, sizeof(*key));
+    free(key);
+}
+
+void bloom_xmss_public_key(const bloom_xmss_key *key, bloom_xmss_public *pub) {
+    *pub = key->pub;
+}
+
+uint32_t bloom_xmss_next_index(const bloom_xmss_key *key) {
+    return key->next;
+}
+
+int bloom_xmss_set_index(bloom_xmss_key *key, uint32_t index) {
+    if (index < key->next || index > ((uint32_t)1 << key->pub.height)) {
+        return BLOOM_XMSS_ERR_INVALID;
+    }
+    key->next = index;
+    return BLOOM_XMSS_OK;
+}
+
+/* ========================================================================== */
+/* Signing                                                                     */
+/* ========================================================================== */
+
+int bloom_xmss_sign(bloom_xmss_key *key, const uint8_t *const *msgs, const size_t *lens,
+                    size_t n, uint8_t *sigs) {
+    unsigned h = key->pub.height;
+    size_t sig_bytes = BLOOM_XMSS_SIG_BYTES(h);
+    if (n > ((size_t)1 << h) - key->next) return BLOOM_XMSS_ERR_EXHAUSTED;
+    if (n == 0) return BLOOM_XMSS_OK;
+
+    chain_job *jobs = (chain_job *)malloc(n * BLOOM_XMSS_LEN * sizeof(chain_job));
+    if (!jobs) return BLOOM_XMSS_ERR_NOMEM;
+
+    for (size_t j = 0; j < n; j++) {
+        uint32_t index = key->next + (uint32_t)j;
+        uint8_t *sig = sigs + j * sig_bytes, adrs[ADRS_BYTES], m[32], d[BLOOM_XMSS_LEN];
+        nexthash256_ctx ctx;
+
+        store32(sig, index);
+        put_adrs(adrs, TAG_RANDOM, index, 0, 0);
+        nexthash256_init(&ctx);
+        nexthash256_update(&ctx, key->sk_seed, 32);
+        nexthash256_update(&ctx, adrs, ADRS_BYTES);
+        nexthash256_update(&ctx, msgs[j], lens[j]);
+        nexthash256_final(&ctx, sig + 4);
+        wipe(&ctx, sizeof(ctx));
+
+        message_digest(&key->pub, index, sig + 4, msgs[j], lens[j], m);
+        wots_digits(m, d);
+        for (int c = 0; c < BLOOM_XMSS_LEN; c++) {
+            chain_job *job = &jobs[j * BLOOM_XMSS_LEN + c];
+            job->seed = key->pub.pub_seed;
+            job->key = index;
+            job->chain = (uint8_t)c;
+            job->start = 0;
+            job->steps = d[c];
+        }
+
+        /* Authentication path: sibling on every level */
+        for (unsigned l = 0; l < h; l++) {
+            memcpy(sig + 36 + BLOOM_XMSS_LEN * 32 + 32 * l,
+                   key->tree[level_offset(h, l) + ((index >> l) ^ 1)], 32);
+        }
+    }
+
+    int st = secret_starts(key->sk_seed, jobs, n * BLOOM_XMSS_LEN);
+    if (st == BLOOM_XMSS_OK) st = run_chains(jobs, n * BLOOM_XMSS_LEN);
+    if (st == BLOOM_XMSS_OK) {
+        for (size_t i = 0; i < n * BLOOM_XMSS_LEN; i++) {
+            size_t j = i / BLOOM_XMSS_LEN, c = i % BLOOM_XMSS_LEN;
+            memcpy(sigs + j * sig_bytes + 36 + 32 * c, jobs[i].x, 32);
+        }
+        key->next += (uint32_t)n;
+    }
+    wipe(jobs, n * BLOOM_XMSS_LEN * sizeof(chain_job));
+    free(jobs);
+    return st;
+}
+
+/* ========================================================================== */
+/* Verification                                                                */
+/* ========================================================================== */
+
+int bloom_xmss_verify_batch(const bloom_xmss_public *const *pubs,
+                            const uint8_t *const *msgs, const size_t *lens,
+                            const uint8_t *const *sigs, size_t n, uint8_t *valid) {
+    chain_job *jobs = (chain_job *)malloc((n ? n : 1) * BLOOM_XMSS_LEN * sizeof(chain_job));
+    uint32_t *live = (uint32_t *)malloc((n ? n : 1) * sizeof(uint32_t));
+    uint8_t (*nodes)[32] = (uint8_t (*)[32])malloc((n ? n : 1) * 32);
+    uint8_t *buf = (uint8_t *)malloc((n ? n : 1) * LEAF_MSG);
+    int st = BLOOM_XMSS_ERR_NOMEM;
+    if (!jobs || !live || !nodes || !buf) goto done;
+
+    /* Chains from each signature element to its public end */
+    size_t m = 0;
+    unsigned max_h = 0;
+    for (size_t i = 0; i < n; i++) {
+        const bloom_xmss_public *pub = pubs[i];
+        uint32_t index = load32(sigs[i]);
+        uint8_t digest[32], d[BLOOM_XMSS_LEN];
+        valid[i] = 0;
+        if (pub->height > BLOOM_XMSS_MAX_HEIGHT || (index >> pub->height) != 0) continue;
+        if (pub->height > max_h) max_h = pub->height;
+
+        message_digest(pub, index, sigs[i] + 4, msgs[i], lens[i], digest);
+        wots_digits(digest, d);
+        for (int c = 0; c < BLOOM_XMSS_LEN; c++) {
+            chain_job *job = &jobs[m * BLOOM_XMSS_LEN + c];
+            memcpy(job->x, sigs[i] + 36 + 32 * c, 32);
+            job->seed = pub->pub_seed;
+            job->key = index;
+            job->chain = (uint8_t)c;
+            job->start = d[c];
+            job->steps = (uint8_t)(BLOOM_XMSS_W - 1 - d[c]);
+        }
+        live[m++] = (uint32_t)i;
+    }
+    if ((st = run_chains(jobs, m * BLOOM_XMSS_LEN)) != BLOOM_XMSS_OK) goto done;
+
+    for (size_t j = 0; j < m; j++) {
+        leaf_msg(buf + j * LEAF_MSG, pubs[live[j]]->pub_seed, load32(sigs[live[j]]),
+                 jobs + j * BLOOM_XMSS_LEN);
+    }
+    hash_all(buf, LEAF_MSG, LEAF_MSG, m, nodes);
+
+    /* Climb the authentication paths, one level for all signatures at once */
+    for (unsigned l = 0; l < max_h; l++) {
+        size_t cnt = 0;
+        for (size_t j = 0; j < m; j++) {
+            const bloom_xmss_public *pub = pubs[live[j]];
+            if (l >= pub->height) continue;
+            const uint8_t *sig = sigs[live[j]];
+            uint32_t index = load32(sig) >> l;
+            const uint8_t *auth = sig + 36 + BLOOM_XMSS_LEN * 32 + 32 * l;
+            node_msg(buf + cnt * NODE_MSG, pub->pub_seed, index >> 1, l + 1,
+                     index & 1 ? auth : nodes[j], index & 1 ? nodes[j] : auth);
+            cnt++;
+        }
+        /* Hash into jobs[].x as scratch, then scatter back */
+        hash_all(buf, NODE_MSG, NODE_MSG, cnt, (uint8_t (*)[32])jobs);
+        cnt = 0;
+        for (size_t j = 0; j < m; j++) {
+            if (l < pubs[live[j]]->height) {
+                memcpy(nodes[j], ((uint8_t (*)[32])jobs)[cnt++], 32);
+            }
+        }
+    }
+    for (size_t j = 0; j < m; j++) {
+        valid[live[j]] = memcmp(nodes[j], pubs[live[j]]->root, 32) == 0;
+    }
+    st = BLOOM_XMSS_OK;
+
+done:
+    free(jobs);
+    free(live);
+    free(nodes);
+    free(buf);
+    return st;
+}
+
+int bloom_xmss_verify(const bloom_xmss_public *pub, const uint8_t *msg, size_t len,
+                      const uint8_t *sig) {
+    uint8_t valid = 0;
+    if (bloom_xmss_verify_batch(&pub, &msg, &len, &sig, 1, &valid) != BLOOM_XMSS_OK) return 0;
+    return valid;
+}
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <stdio.h>
+#include <time.h>
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Plain per-hash WOTS chain, as a reference for the batched engine */
+static void ref_chain(const uint8_t *seed, uint32_t key, uint8_t chain, uint8_t start,
+                      uint8_t steps, uint8_t x[32]) {
+    uint8_t msg[F_MSG];
+    for (uint8_t s = start; s < start + steps; s++) {
+        memcpy(msg, seed, BLOOM_XMSS_SEED_BYTES);
+        put_adrs(msg + BLOOM_XMSS_SEED_BYTES, TAG_CHAIN, key, chain, s);
+        memcpy(msg + PREFIX, x, 32);
+        nexthash256(msg, F_MSG, x);
+    }
+}
+
+int main(void) {
+    int fail = 0, ok;
+    printf("BloomCoin Hash-Based Signatures (WOTS+ / XMSS)\n");
+    printf("==============================================\n\n");
+
+    uint8_t secret[32];
+    for (int i = 0; i < 32; i++) secret[i] = (uint8_t)(i * 7 + 1);
+
+    /* Batched chains against one hash at a time */
+    {
+        static chain_job jobs[300];
+        uint8_t seed[BLOOM_XMSS_SEED_BYTES] = { 1, 2, 3 };
+        for (int i = 0; i < 300; i++) {
+            memset(jobs[i].x, i, 32);
+            jobs[i].seed = seed;
+            jobs[i].key = (uint32_t)i;
+            jobs[i].chain = (uint8_t)(i % BLOOM_XMSS_LEN);
+            jobs[i].start = (uint8_t)(i % 5);
+            jobs[i].steps = (uint8_t)((i * 7) % (BLOOM_XMSS_W - i % 5));
+        }
+        run_chains(jobs, 300);
+        ok = 1;
+        for (int i = 0; i < 300; i++) {
+            uint8_t x[32];
+            memset(x, i, 32);
+            ref_chain(seed, (uint32_t)i, (uint8_t)(i % BLOOM_XMSS_LEN), (uint8_t)(i % 5),
+                      (uint8_t)((i * 7) % (BLOOM_XMSS_W - i % 5)), x);
+            ok &= memcmp(x, jobs[i].x, 32) == 0;
+        }
+        printf("batched chains:           %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    enum { H = 10, NS = 64 };
+    double t0 = now_sec();
+    bloom_xmss_key *key = bloom_xmss_keygen(secret, H);
+    double t1 = now_sec();
+    bloom_xmss_public pub;
+    bloom_xmss_public_key(key, &pub);
+    printf("key generation:           height %d (%d signatures) in %.0f ms\n",
+           H, 1 << H, 1e3 * (t1 - t0));
+
+    size_t sig_bytes = BLOOM_XMSS_SIG_BYTES(H);
+    uint8_t *sigs = malloc(NS * sig_bytes);
+    const uint8_t *msgs[NS], *sig_ptr[NS];
+    const bloom_xmss_public *pubs[NS];
+    size_t lens[NS];
+    char text[NS][48];
+    for (int i = 0; i < NS; i++) {
+        lens[i] = (size_t)sprintf(text[i], "transfer %d BLOOM to bloom1q%04d", 10 + i, i);
+        msgs[i] = (const uint8_t *)text[i];
+        sig_ptr[i] = sigs + i * sig_bytes;
+        pubs[i] = &pub;
+    }
+
+    /* One signature, then tampering */
+    {
+        ok = bloom_xmss_sign(key, msgs, lens, 1, sigs) == BLOOM_XMSS_OK &&
+             bloom_xmss_next_index(key) == 1 && bloom_xmss_verify(&pub, msgs[0], lens[0], sigs);
+        ok &= !bloom_xmss_verify(&pub, msgs[1], lens[1], sigs);
+        size_t spots[3] = { 10, 36 + 32 * 40 + 5, sig_bytes - 1 };
+        for (int s = 0; s < 3; s++) {
+            sigs[spots[s]] ^= 1;
+            ok &= !bloom_xmss_verify(&pub, msgs[0], lens[0], sigs);
+            sigs[spots[s]] ^= 1;
+        }
+        sigs[0] ^= 1;                           /* another index */
+        ok &= !bloom_xmss_verify(&pub, msgs[0], lens[0], sigs);
+        sigs[0] ^= 1;
+        bloom_xmss_public other = pub;
+        other.root[0] ^= 1;
+        ok &= !bloom_xmss_verify(&other, msgs[0], lens[0], sigs);
+        printf("sign / verify / tamper:   %zu-byte signature  %s\n", sig_bytes, ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Batch signing matches one-at-a-time signing with the same indices */
+    {
+        bloom_xmss_key *twin = bloom_xmss_keygen(secret, H);
+        uint8_t *one = malloc(NS * sig_bytes);
+        bloom_xmss_set_index(twin, 1);
+        t0 = now_sec();
+        for (int i = 1; i < NS; i++) bloom_xmss_sign(twin, msgs + i, lens + i, 1, one + i * sig_bytes);
+        t1 = now_sec();
+        bloom_xmss_sign(key, msgs + 1, lens + 1, NS - 1, sigs + sig_bytes);
+        double t2 = now_sec();
+        ok = memcmp(one + sig_bytes, sigs + sig_bytes, (NS - 1) * sig_bytes) == 0;
+        printf("batch signing:            %.0f us/sig single, %.0f us/sig batched  %s\n",
+               1e6 * (t1 - t0) / (NS - 1), 1e6 * (t2 - t1) / (NS - 1), ok ? "OK" : "FAIL");
+        fail |= !ok;
+        free(one);
+        bloom_xmss_destroy(twin);
+    }
+
+    {
+        uint8_t valid[NS];
+        int single = 1;
+        t0 = now_sec();
+        for (int i = 0; i < NS; i++) single &= bloom_xmss_verify(&pub, msgs[i], lens[i], sig_ptr[i]);
+        t1 = now_sec();
+        bloom_xmss_verify_batch(pubs, msgs, lens, sig_ptr, NS, valid);
+        double t2 = now_sec();
+        ok = single;
+        for (int i = 0; i < NS; i++) ok &= valid[i] == 1;
+        sigs[5 * sig_bytes + 100] ^= 0x40;
+        bloom_xmss_verify_batch(pubs, msgs, lens, sig_ptr, NS, valid);
+        for (int i = 0; i < NS; i++) ok &= valid[i] == (i != 5);
+        printf("batch verification:       %.0f us/sig single, %.0f us/sig batched  %s\n",
+               1e6 * (t1 - t0) / NS, 1e6 * (t2 - t1) / NS, ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Few-time key: four signatures, then exhausted */
+    {
+        bloom_xmss_key *few = bloom_xmss_keygen(secret, 2);
+        bloom_xmss_public fp;
+        bloom_xmss_public_key(few, &fp);
+        uint8_t *fs = malloc(5 * BLOOM_XMSS_SIG_BYTES(2));
+        ok = bloom_xmss_sign(few, msgs, lens, 5, fs) == BLOOM_XMSS_ERR_EXHAUSTED &&
+             bloom_xmss_sign(few, msgs, lens, 4, fs) == BLOOM_XMSS_OK &&
+             bloom_xmss_sign(few, msgs, lens, 1, fs) == BLOOM_XMSS_ERR_EXHAUSTED &&
+             bloom_xmss_verify(&fp, msgs[3], lens[3], fs + 3 * BLOOM_XMSS_SIG_BYTES(2)) &&
+             !bloom_xmss_verify(&pub, msgs[3], lens[3], fs + 3 * BLOOM_XMSS_SIG_BYTES(2));
+        ok &= bloom_xmss_set_index(key, 3) == BLOOM_XMSS_ERR_INVALID &&
+              bloom_xmss_set_index(key, 1000) == BLOOM_XMSS_OK &&
+              bloom_xmss_keygen(secret, BLOOM_XMSS_MAX_HEIGHT + 1) == NULL;
+        printf("few-time key / state:     %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+        free(fs);
+        bloom_xmss_destroy(few);
+    }
+
+    free(sigs);
+    bloom_xmss_destroy(key);
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
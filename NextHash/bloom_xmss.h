@@ -0,0 +1,101 @@
+/*
+ * BloomCoin Hash-Based Signatures (WOTS+ / XMSS over NEXTHASH-256)
+ * ================================================================
+ *
+ * Stateful post-quantum signatures for wallet keys: a replacement for the
+ * placeholder WalletKey.sign_message() / private_to_public() construction
+ * in game/bloomcoin_nexthash_wallet.py. A key signs up to 2^height
+ * messages; small heights give few-time keys.
+ *
+ * Features:
+ * - Winternitz one-time keys, w = 16: 64 message nibbles + 3 checksum
+ *   nibbles = 67 chains of up to 15 steps
+ * - Chain step F = NEXTHASH-256(pub_seed[16] || adrs[7] || x[32]): one
+ *   55-byte block, addressed by (tag, key index, chain, step)
+ * - Every chain of every key / signature in a call advances together, one
+ *   step per nexthash256_batch() pass, so the eight AVX2 lanes stay full
+ * - Merkle tree over compressed one-time public keys, built level by level
+ *   in batches; OpenMP over hash chunks for key generation
+ * - Deterministic randomizer R = NEXTHASH-256(sk_seed || index || msg)
+ * - Batch verification across signatures and public keys
+ *
+ * Signature (little-endian):
+ *   index u32 | R[32] | wots[67][32] | auth_path[height][32]
+ *
+ * The key is stateful: persist bloom_xmss_next_index() before releasing a
+ * signature, and never sign twice with the same index.
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef BLOOM_XMSS_H
+#define BLOOM_XMSS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLOOM_XMSS_W          16
+#define BLOOM_XMSS_LEN        67    /* WOTS chains per one-time key */
+#define BLOOM_XMSS_SEED_BYTES 16    /* public seed */
+#define BLOOM_XMSS_MAX_HEIGHT 20
+
+#define BLOOM_XMSS_SIG_BYTES(height) (4 + 32 + BLOOM_XMSS_LEN * 32 + (height) * 32)
+
+/* Status codes */
+#define BLOOM_XMSS_OK             0
+#define BLOOM_XMSS_ERR_NOMEM     -1
+#define BLOOM_XMSS_ERR_INVALID   -2   /* bad height or index */
+#define BLOOM_XMSS_ERR_EXHAUSTED -3   /* all one-time keys used */
+
+typedef struct {
+    uint8_t root[32];
+    uint8_t pub_seed[BLOOM_XMSS_SEED_BYTES];
+    uint8_t height;
+} bloom_xmss_public;
+
+typedef struct bloom_xmss_key bloom_xmss_key;
+
+/*
+ * Derive a key of 2^height one-time keys from a 32-byte secret (e.g. the
+ * wallet private key). Returns NULL on a bad height or no memory.
+ */
+bloom_xmss_key *bloom_xmss_keygen(const uint8_t secret[32], unsigned height);
+void bloom_xmss_destroy(bloom_xmss_key *key);
+
+void bloom_xmss_public_key(const bloom_xmss_key *key, bloom_xmss_public *pub);
+
+/* Next one-time key index; signatures left = 2^height - index */
+uint32_t bloom_xmss_next_index(const bloom_xmss_key *key);
+
+/* Restore a persisted index; it may only move forward */
+int bloom_xmss_set_index(bloom_xmss_key *key, uint32_t index);
+
+/*
+ * Sign n messages with consecutive one-time keys; sigs receives n
+ * signatures of BLOOM_XMSS_SIG_BYTES(height) bytes each.
+ */
+int bloom_xmss_sign(bloom_xmss_key *key, const uint8_t *const *msgs, const size_t *lens,
+                    size_t n, uint8_t *sigs);
+
+/* 1 if sig is a valid signature of msg under pub, else 0 */
+int bloom_xmss_verify(const bloom_xmss_public *pub, const uint8_t *msg, size_t len,
+                      const uint8_t *sig);
+
+/*
+ * Verify n (public key, message, signature) triples; valid[i] = 1 or 0.
+ * Returns BLOOM_XMSS_OK or BLOOM_XMSS_ERR_NOMEM.
+ */
+int bloom_xmss_verify_batch(const bloom_xmss_public *const *pubs,
+                            const uint8_t *const *msgs, const size_t *lens,
+                            const uint8_t *const *sigs, size_t n, uint8_t *valid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOOM_XMSS_H */
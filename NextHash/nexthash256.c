@@ -8,6 +8,14 @@
 #include "nexthash256.h"
 #include <string.h>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define NEXTHASH_HAVE_AVX2_DISPATCH 1
+#if defined(__clang__) || __GNUC__ >= 5
+#define NEXTHASH_HAVE_AVX512_DISPATCH 1
+#endif
+#endif
+
 /* ========================================================================== */
 /* Constants                                                                   */
 /* ========================================================================== */
@@ -178,7 +186,8 @@ static void full_permutation(uint32_t state[16]) {
 /* Compression Function                                                        */
 /* ========================================================================== */
 
-static void compress(uint32_t state[16], const uint8_t block[64]) {
+/* Compression truncated to the first `rounds` rounds (52 = full) */
+static void compress_rounds(uint32_t state[16], const uint8_t block[64], int rounds) {
     uint32_t W[52];
     uint32_t working[16];
     int round_num;
@@ -186,7 +195,7 @@ static void compress(uint32_t state[16], const uint8_t block[64]) {
     expand_message(block, W);
     memcpy(working, state, 64);
 
-    for (round_num = 0; round_num < 52; round_num++) {
+    for (round_num = 0; round_num < rounds; round_num++) {
         nexthash_round(working, W[round_num], K[round_num]);
         if ((round_num + 1) % 4 == 0) {
             full_permutation(working);
@@ -199,6 +208,10 @@ static void compress(uint32_t state[16], const uint8_t block[64]) {
     }
 }
 
+static void compress(uint32_t state[16], const uint8_t block[64]) {
+    compress_rounds(state, block, 52);
+}
+
 /* ========================================================================== */
 /* Finalization                                                                */
 /* ========================================================================== */
@@ -240,6 +253,200 @@ static void finalize_hash(uint32_t state[16], uint8_t digest[32]) {
     }
 }
 
+/* ========================================================================== */
+/* Single-Message Vector Path                                                  */
+/* ========================================================================== */
+
+/*
+ * Latency path for one message. The 16-word state lives in one zmm
+ * register; each round builds the ten widening_mul() operand pairs with
+ * lane permutes and multiplies them in a single 16-lane product, and
+ * finalize_hash() mixes all eight words per step. The message schedule
+ * is serial and stays scalar.
+ */
+#ifdef NEXTHASH_HAVE_AVX512_DISPATCH
+
+#define NH_AVX512 __attribute__((target("avx512f")))
+
+/* CPU check done once at load, not on every block */
+static int use_zmm;
+
+__attribute__((constructor)) static void detect_zmm(void) {
+    __builtin_cpu_init();
+    use_zmm = __builtin_cpu_supports("avx512f");
+}
+
+/* Sixteen widening_mul() at once */
+NH_AVX512 static inline __m512i z_wmul(__m512i a, __m512i b) {
+    __m512i even = _mm512_mul_epu32(a, b);
+    __m512i odd = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), _mm512_srli_epi64(b, 32));
+    even = _mm512_xor_si512(even, _mm512_srli_epi64(even, 32));
+    odd = _mm512_xor_si512(odd, _mm512_slli_epi64(odd, 32));
+    return _mm512_mask_blend_epi32(0xAAAA, even, odd);
+}
+
+#define Z_IDX(...) _mm512_setr_epi32(__VA_ARGS__)
+#define Z_PERM(v, ...) _mm512_permutexvar_epi32(Z_IDX(__VA_ARGS__), (v))
+#define Z_PERMZ(k, v, ...) _mm512_maskz_permutexvar_epi32((k), Z_IDX(__VA_ARGS__), (v))
+
+/* Lane bits for the state words a..p (lane 0 = a) */
+#define ZL(x) (1u << (x))
+
+NH_AVX512 static void compress_zmm(uint32_t state[16], const uint8_t block[64]) {
+    uint32_t W[52], kw_hi[52], kw_lo[52];
+    int r;
+
+    /*
+     * Schedule words are produced inside the round loop: the scalar
+     * expansion then runs on the integer ports alongside the vector round.
+     */
+    for (r = 0; r < 16; r++) {
+        W[r] = ((uint32_t)block[r*4] << 24) | ((uint32_t)block[r*4 + 1] << 16) |
+               ((uint32_t)block[r*4 + 2] << 8) | (uint32_t)block[r*4 + 3];
+    }
+
+    /* Sigma0 on lanes a/i, Sigma1 on lanes e/m */
+    const __m512i rot1 = Z_IDX(2, 0, 0, 0, 6, 0, 0, 0, 2, 0, 0, 0, 6, 0, 0, 0);
+    const __m512i rot2 = Z_IDX(13, 0, 0, 0, 11, 0, 0, 0, 13, 0, 0, 0, 11, 0, 0, 0);
+    const __m512i rot3 = Z_IDX(22, 0, 0, 0, 25, 0, 0, 0, 22, 0, 0, 0, 25, 0, 0, 0);
+    const __mmask16 ch_lanes = ZL(4) | ZL(12);
+
+    const __m512i s0 = _mm512_loadu_si512((const void *)state);
+    __m512i s = s0;
+
+    for (r = 0; r < 52; r++) {
+        if (r >= 16) {
+            uint32_t linear = sigma1(W[r-2]) + W[r-7] + sigma0(W[r-15]) + W[r-16];
+            uint32_t nl1 = widening_mul(W[r-3], W[r-10]);
+            uint32_t nl2 = widening_mul(W[r-5], W[r-12]);
+            uint32_t nl3 = widening_mul(W[r-1] ^ W[r-8], W[r-4] ^ W[r-14]);
+            W[r] = linear + nl1 + (nl2 ^ nl3);
+        }
+        kw_hi[r] = K[r] + W[r];
+        kw_lo[r] = (K[r] ^ 0x5A5A5A5A) + W[r];
+
+        /* M1..M10 operands in lanes 0..9 */
+        __m512i x = _mm512_xor_si512(
+            Z_PERM(s, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 0, 0, 0, 0, 0, 0),
+            Z_PERM(s, 8, 9, 10, 11, 12, 13, 14, 15, 15, 14, 0, 0, 0, 0, 0, 0));
+        __m512i y = _mm512_xor_si512(
+            Z_PERM(s, 4, 5, 6, 7, 4, 5, 6, 7, 3, 2, 0, 0, 0, 0, 0, 0),
+            Z_PERM(s, 12, 13, 14, 15, 8, 9, 10, 11, 12, 13, 0, 0, 0, 0, 0, 0));
+        __m512i M = z_wmul(x, y);
+
+        /*
+         * T2 in lane a, T1 in lane e, T4 in lane i, T3 in lane m: the two
+         * compression halves are the same expression on neighbouring lanes.
+         */
+        __m512i s1 = _mm512_alignr_epi32(s, s, 1);
+        __m512i s2 = _mm512_alignr_epi32(s, s, 2);
+        __m512i s3 = _mm512_alignr_epi32(s, s, 3);
+        __m512i sig = _mm512_ternarylogic_epi32(_mm512_rorv_epi32(s, rot1),
+                                                _mm512_rorv_epi32(s, rot2),
+                                                _mm512_rorv_epi32(s, rot3), 0x96);
+        __m512i fn = _mm512_mask_blend_epi32(ch_lanes,
+                                             _mm512_ternarylogic_epi32(s, s1, s2, 0xE8),
+                                             _mm512_ternarylogic_epi32(s, s1, s2, 0xCA));
+        __m512i kw = _mm512_mask_broadcastd_epi32(
+            _mm512_maskz_broadcastd_epi32(ZL(4), _mm_loadu_si32(&kw_hi[r])),
+            ZL(12), _mm_loadu_si32(&kw_lo[r]));
+        __m512i T = _mm512_add_epi32(_mm512_add_epi32(sig, fn),
+                                     _mm512_add_epi32(_mm512_maskz_mov_epi32(ch_lanes, s3), kw));
+
+        /* Shifted words: new[i] = old[i - 1] except in lanes a and i */
+        __m512i base = Z_PERMZ((__mmask16)~(ZL(0) | ZL(8)), s,
+                               0, 0, 1, 2, 3, 4, 5, 6, 0, 8, 9, 10, 11, 12, 13, 14);
+        __m512i tsum = _mm512_add_epi32(
+            Z_PERMZ(ZL(0) | ZL(4) | ZL(8) | ZL(12), T,
+                    4, 0, 0, 0, 4, 0, 0, 0, 12, 0, 0, 0, 12, 0, 0, 0),
+            _mm512_maskz_mov_epi32(ZL(0) | ZL(8), T));
+
+        /* Product terms; lane p gets M2 ^ M3 ^ M4 */
+        const __mmask16 k1 = ZL(0) | ZL(1) | ZL(3) | ZL(4) | ZL(5) | ZL(7) |
+                             ZL(8) | ZL(9) | ZL(11) | ZL(12) | ZL(13) | ZL(15);
+        __m512i p1 = Z_PERMZ(k1, M, 0, 5, 0, 1, 8, 7, 0, 2, 0, 5, 0, 3, 8, 7, 0, 1);
+        __m512i p2 = Z_PERMZ(ZL(0) | ZL(1) | ZL(3) | ZL(7) | ZL(8) | ZL(11) | ZL(15), M,
+                             4, 9, 0, 6, 0, 0, 0, 9, 4, 0, 0, 6, 0, 0, 0, 9);
+        __m512i p3 = Z_PERMZ(ZL(0) | ZL(15), M,
+                             8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2);
+        __m512i p4 = Z_PERMZ(ZL(15), M,
+                             0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3);
+        /* Lane 0 adds M9 from p3; lane 15 xors M3 and M4 into p1's M2 */
+        __m512i mix = _mm512_mask_ternarylogic_epi32(p1, ZL(15), p3, p4, 0x96);
+        __m512i m9 = _mm512_maskz_mov_epi32(ZL(0), p3);
+
+        s = _mm512_add_epi32(_mm512_add_epi32(_mm512_add_epi32(base, tsum), p2),
+                             _mm512_add_epi32(mix, m9));
+
+        if ((r + 1) % 4 == 0) {
+            s = Z_PERM(s, 0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15);
+        }
+    }
+
+    _mm512_storeu_si512((void *)state, _mm512_add_epi32(s0, s));
+}
+
+NH_AVX512 static void finalize_zmm(const uint32_t state[16], uint8_t digest[32]) {
+    uint32_t out[16];
+    int i, round;
+
+    /* First fold: lanes 0..7 carry upper = state[i], lower = state[i + 8] */
+    __m512i u = _mm512_loadu_si512((const void *)state);
+    __m512i l = _mm512_alignr_epi32(u, u, 8);
+    __m512i x = _mm512_xor_si512(u, l);
+    __m512i f = _mm512_add_epi32(
+        _mm512_add_epi32(x, z_wmul(u, _mm512_rol_epi32(l, 13))),
+        _mm512_add_epi32(z_wmul(l, _mm512_ror_epi32(u, 7)),
+                         z_wmul(x, _mm512_xor_si512(_mm512_ror_epi32(u, 3),
+                                                    _mm512_rol_epi32(l, 11)))));
+    f = _mm512_add_epi32(f, _mm512_rorv_epi32(x, Z_IDX(1, 2, 3, 4, 5, 6, 7, 8,
+                                                       0, 0, 0, 0, 0, 0, 0, 0)));
+
+    /* Mixing rounds: both products of a word in one 16-lane multiply */
+    for (round = 0; round < 3; round++) {
+        __m512i a = Z_PERM(f, 1, 2, 3, 4, 5, 6, 7, 0, 2, 3, 4, 5, 6, 7, 0, 1);
+        __m512i b = Z_PERM(f, 5, 6, 7, 0, 1, 2, 3, 4, 6, 7, 0, 1, 2, 3, 4, 5);
+        __m512i m = z_wmul(a, b);
+        m = _mm512_add_epi32(m, _mm512_alignr_epi32(m, m, 8));
+        __m512i r3 = _mm512_ror_epi32(Z_PERM(f, 3, 4, 5, 6, 7, 0, 1, 2,
+                                             0, 0, 0, 0, 0, 0, 0, 0), 7);
+        __m512i r7 = _mm512_rol_epi32(Z_PERM(f, 7, 0, 1, 2, 3, 4, 5, 6,
+                                             0, 0, 0, 0, 0, 0, 0, 0), 11);
+        f = _mm512_add_epi32(_mm512_add_epi32(f, m), _mm512_add_epi32(r3, r7));
+    }
+
+    _mm512_storeu_si512((void *)out, f);
+    for (i = 0; i < 8; i++) {
+        digest[i*4] = (uint8_t)(out[i] >> 24);
+        digest[i*4 + 1] = (uint8_t)(out[i] >> 16);
+        digest[i*4 + 2] = (uint8_t)(out[i] >> 8);
+        digest[i*4 + 3] = (uint8_t)out[i];
+    }
+}
+
+#endif /* NEXTHASH_HAVE_AVX512_DISPATCH */
+
+/* compress() / finalize_hash() with the vector path when available */
+static void compress_one(uint32_t state[16], const uint8_t block[64]) {
+#ifdef NEXTHASH_HAVE_AVX512_DISPATCH
+    if (use_zmm) {
+        compress_zmm(state, block);
+        return;
+    }
+#endif
+    compress(state, block);
+}
+
+static void finalize_one(uint32_t state[16], uint8_t digest[32]) {
+#ifdef NEXTHASH_HAVE_AVX512_DISPATCH
+    if (use_zmm) {
+        finalize_zmm(state, digest);
+        return;
+    }
+#endif
+    finalize_hash(state, digest);
+}
+
 /* ========================================================================== */
 /* Public API                                                                  */
 /* ========================================================================== */
@@ -264,7 +471,7 @@ void nexthash256_update(nexthash256_ctx *ctx, const uint8_t *data, size_t len) {
             return;
         }
         memcpy(ctx->buffer + ctx->buflen, data, need);
-        compress(ctx->state, ctx->buffer);
+        compress_one(ctx->state, ctx->buffer);
         data += need;
         len -= need;
         ctx->buflen = 0;
@@ -272,7 +479,7 @@ void nexthash256_update(nexthash256_ctx *ctx, const uint8_t *data, size_t len) {
 
     /* Process complete blocks */
     while (len >= 64) {
-        compress(ctx->state, data);
+        compress_one(ctx->state, data);
         data += 64;
         len -= 64;
     }
@@ -306,7 +513,7 @@ void nexthash256_final(nexthash256_ctx *ctx, uint8_t digest[32]) {
 
     nexthash256_update(ctx, pad, padlen + 8);
 
-    finalize_hash(ctx->state, digest);
+    finalize_one(ctx->state, digest);
 
     /* Clear sensitive data */
     memset(ctx, 0, sizeof(*ctx));
@@ -319,6 +526,277 @@ void nexthash256(const uint8_t *data, size_t len, uint8_t digest[32]) {
     nexthash256_final(&ctx, digest);
 }
 
+/* ========================================================================== */
+/* Batch Hashing                                                               */
+/* ========================================================================== */
+
+/* Pad a message tail into tail[128]; returns total block count */
+static size_t pad_tail(const uint8_t *data, size_t len, uint8_t tail[128],
+                       size_t *full_blocks) {
+    size_t full = len / 64, rem = len % 64;
+    size_t tail_blocks = (rem < 56) ? 1 : 2;
+    uint64_t bits = (uint64_t)len * 8;
+    uint8_t *end;
+
+    memset(tail, 0, 128);
+    if (rem) memcpy(tail, data + full * 64, rem);
+    tail[rem] = 0x80;
+    end = tail + tail_blocks * 64 - 8;
+    for (int k = 0; k < 8; k++) end[k] = (uint8_t)(bits >> (56 - 8 * k));
+
+    *full_blocks = full;
+    return full + tail_blocks;
+}
+
+#ifdef NEXTHASH_HAVE_AVX2_DISPATCH
+
+#define NH_AVX2 __attribute__((target("avx2")))
+
+NH_AVX2 static inline __m256i v_rotr(__m256i x, int n) {
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+NH_AVX2 static inline __m256i v_rotl(__m256i x, int n) {
+    return _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - n));
+}
+
+/* Eight widening_mul() at once: even and odd lanes use separate multiplies */
+NH_AVX2 static inline __m256i v_wmul(__m256i a, __m256i b) {
+    __m256i even = _mm256_mul_epu32(a, b);
+    __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    even = _mm256_xor_si256(even, _mm256_srli_epi64(even, 32));
+    odd = _mm256_xor_si256(odd, _mm256_slli_epi64(odd, 32));
+    return _mm256_blend_epi32(even, odd, 0xAA);
+}
+
+#define V_ADD(a, b) _mm256_add_epi32((a), (b))
+#define V_XOR(a, b) _mm256_xor_si256((a), (b))
+#define V_AND(a, b) _mm256_and_si256((a), (b))
+
+NH_AVX2 static inline __m256i v_Ch(__m256i x, __m256i y, __m256i z) {
+    return V_XOR(V_AND(x, y), _mm256_andnot_si256(x, z));
+}
+
+NH_AVX2 static inline __m256i v_Maj(__m256i x, __m256i y, __m256i z) {
+    return V_XOR(V_XOR(V_AND(x, y), V_AND(x, z)), V_AND(y, z));
+}
+
+NH_AVX2 static inline __m256i v_Sigma0(__m256i x) {
+    return V_XOR(V_XOR(v_rotr(x, 2), v_rotr(x, 13)), v_rotr(x, 22));
+}
+
+NH_AVX2 static inline __m256i v_Sigma1(__m256i x) {
+    return V_XOR(V_XOR(v_rotr(x, 6), v_rotr(x, 11)), v_rotr(x, 25));
+}
+
+NH_AVX2 static inline __m256i v_sigma0(__m256i x) {
+    return V_XOR(V_XOR(v_rotr(x, 7), v_rotr(x, 18)), _mm256_srli_epi32(x, 3));
+}
+
+NH_AVX2 static inline __m256i v_sigma1(__m256i x) {
+    return V_XOR(V_XOR(v_rotr(x, 17), v_rotr(x, 19)), _mm256_srli_epi32(x, 10));
+}
+
+/*
+ * compress() over eight independent (state, block) lanes; lane l stops
+ * after rounds[l] rounds (all 52 when rounds is NULL).
+ */
+NH_AVX2 static void compress_x8(__m256i state[16], const uint8_t *const blocks[8],
+                                const uint8_t *rounds) {
+    __m256i W[52], s[16], t[16], fin[16];
+    __m256i lane_rounds = _mm256_set1_epi32(52);
+    uint64_t stops = 1ull << 52;      /* bit r: some lane stops after r rounds */
+    int max_rounds = 52;
+    const __m256i bswap = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    int i, r;
+
+    if (rounds) {
+        int32_t lr[8];
+        stops = 0;
+        max_rounds = 0;
+        for (i = 0; i < 8; i++) {
+            lr[i] = rounds[i];
+            stops |= 1ull << rounds[i];
+            if (rounds[i] > max_rounds) max_rounds = rounds[i];
+        }
+        lane_rounds = _mm256_loadu_si256((const __m256i *)lr);
+    }
+
+    /* Transpose 8 blocks of 16 big-endian words into 16 lane vectors */
+    for (i = 0; i < 16; i++) {
+        uint32_t w[8];
+        for (int l = 0; l < 8; l++) memcpy(&w[l], blocks[l] + 4 * i, 4);
+        W[i] = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)w), bswap);
+    }
+    for (i = 16; i < max_rounds; i++) {
+        __m256i linear = V_ADD(V_ADD(v_sigma1(W[i-2]), W[i-7]),
+                               V_ADD(v_sigma0(W[i-15]), W[i-16]));
+        __m256i nl1 = v_wmul(W[i-3], W[i-10]);
+        __m256i nl2 = v_wmul(W[i-5], W[i-12]);
+        __m256i nl3 = v_wmul(V_XOR(W[i-1], W[i-8]), V_XOR(W[i-4], W[i-14]));
+        W[i] = V_ADD(V_ADD(linear, nl1), V_XOR(nl2, nl3));
+    }
+
+    memcpy(s, state, sizeof(s));
+    memcpy(fin, state, sizeof(fin));
+    for (r = 0; r < max_rounds; r++) {
+        const __m256i Ki = _mm256_set1_epi32((int)K[r]);
+        const __m256i Kl = _mm256_set1_epi32((int)(K[r] ^ 0x5A5A5A5A));
+        __m256i a = s[0], b = s[1], c = s[2], d = s[3];
+        __m256i e = s[4], f = s[5], g = s[6], h = s[7];
+        __m256i ii = s[8], j = s[9], k = s[10], l = s[11];
+        __m256i m = s[12], n = s[13], o = s[14], p = s[15];
+
+        __m256i T1 = V_ADD(V_ADD(V_ADD(h, v_Sigma1(e)), V_ADD(v_Ch(e, f, g), Ki)), W[r]);
+        __m256i T2 = V_ADD(v_Sigma0(a), v_Maj(a, b, c));
+
+        __m256i M1 = v_wmul(V_XOR(a, ii), V_XOR(e, m));
+        __m256i M2 = v_wmul(V_XOR(b, j), V_XOR(f, n));
+        __m256i M3 = v_wmul(V_XOR(c, k), V_XOR(g, o));
+        __m256i M4 = v_wmul(V_XOR(d, l), V_XOR(h, p));
+        __m256i M5 = v_wmul(V_XOR(a, m), V_XOR(e, ii));
+        __m256i M6 = v_wmul(V_XOR(b, n), V_XOR(f, j));
+        __m256i M7 = v_wmul(V_XOR(c, o), V_XOR(g, k));
+        __m256i M8 = v_wmul(V_XOR(d, p), V_XOR(h, l));
+        __m256i M9 = v_wmul(V_XOR(a, p), V_XOR(d, m));
+        __m256i M10 = v_wmul(V_XOR(b, o), V_XOR(c, n));
+
+        __m256i T3 = V_ADD(V_ADD(V_ADD(p, v_Sigma1(m)), V_ADD(v_Ch(m, n, o), Kl)), W[r]);
+        __m256i T4 = V_ADD(v_Sigma0(ii), v_Maj(ii, j, k));
+
+        s[0] = V_ADD(V_ADD(V_ADD(T1, T2), V_ADD(M1, M5)), M9);
+        s[1] = V_ADD(V_ADD(a, M6), M10);
+        s[2] = b;
+        s[3] = V_ADD(V_ADD(c, M2), M7);
+        s[4] = V_ADD(V_ADD(d, T1), M9);
+        s[5] = V_ADD(e, M8);
+        s[6] = f;
+        s[7] = V_ADD(V_ADD(g, M3), M10);
+        s[8] = V_ADD(V_ADD(T3, T4), V_ADD(M1, M5));
+        s[9] = V_ADD(ii, M6);
+        s[10] = j;
+        s[11] = V_ADD(V_ADD(k, M4), M7);
+        s[12] = V_ADD(V_ADD(l, T3), M9);
+        s[13] = V_ADD(m, M8);
+        s[14] = n;
+        s[15] = V_ADD(V_ADD(o, V_XOR(V_XOR(M2, M3), M4)), M10);
+
+        if ((r + 1) % 4 == 0) {
+            for (i = 0; i < 8; i++) {
+                t[2 * i] = s[i];
+                t[2 * i + 1] = s[i + 8];
+            }
+            memcpy(s, t, sizeof(s));
+        }
+        if (stops >> (r + 1) & 1) {
+            __m256i done = _mm256_cmpeq_epi32(lane_rounds, _mm256_set1_epi32(r + 1));
+            for (i = 0; i < 16; i++) fin[i] = _mm256_blendv_epi8(fin[i], s[i], done);
+        }
+    }
+
+    for (i = 0; i < 16; i++) state[i] = V_ADD(state[i], fin[i]);
+}
+
+/* Hash up to eight messages; idle lanes replay lane 0 and are discarded */
+NH_AVX2 static void batch_x8(const uint8_t *const *data, const size_t *lens,
+                             const uint8_t *rounds, size_t n, uint8_t (*digests)[32]) {
+    uint8_t tails[8][128];
+    size_t full[8], total[8], max_blocks = 0;
+    const uint8_t *blocks[8];
+    uint8_t lane_rounds[8];
+    __m256i state[16];
+    uint32_t lane_state[8][16];
+    size_t l, b;
+    int i;
+
+    for (l = 0; l < 8; l++) {
+        size_t src = l < n ? l : 0;
+        total[l] = pad_tail(data[src], lens[src], tails[l], &full[l]);
+        if (total[l] > max_blocks) max_blocks = total[l];
+        if (rounds) lane_rounds[l] = rounds[src];
+    }
+    for (i = 0; i < 16; i++) state[i] = _mm256_set1_epi32((int)H_INIT[i]);
+
+    for (b = 0; b < max_blocks; b++) {
+        __m256i saved[16];
+        int32_t active[8];
+        __m256i mask;
+        for (l = 0; l < 8; l++) {
+            size_t src = l < n ? l : 0;
+            active[l] = (b < total[l]) ? -1 : 0;
+            if (b < full[l]) blocks[l] = data[src] + 64 * b;
+            else if (b < total[l]) blocks[l] = tails[l] + 64 * (b - full[l]);
+            else blocks[l] = tails[l];
+        }
+        memcpy(saved, state, sizeof(saved));
+        compress_x8(state, blocks, rounds ? lane_rounds : NULL);
+        mask = _mm256_loadu_si256((const __m256i *)active);
+        for (i = 0; i < 16; i++) state[i] = _mm256_blendv_epi8(saved[i], state[i], mask);
+    }
+
+    for (i = 0; i < 16; i++) {
+        uint32_t w[8];
+        _mm256_storeu_si256((__m256i *)w, state[i]);
+        for (l = 0; l < 8; l++) lane_state[l][i] = w[l];
+    }
+    for (l = 0; l < n; l++) finalize_one(lane_state[l], digests[l]);
+}
+
+#endif /* NEXTHASH_HAVE_AVX2_DISPATCH */
+
+void nexthash256_batch(const uint8_t *const *data, const size_t *lens,
+                       size_t n, uint8_t (*digests)[32]) {
+    size_t i = 0;
+
+#ifdef NEXTHASH_HAVE_AVX2_DISPATCH
+    if (n >= 4 && __builtin_cpu_supports("avx2")) {
+        for (; i < n; i += 8) {
+            batch_x8(data + i, lens + i, NULL, (n - i < 8) ? n - i : 8, digests + i);
+        }
+        return;
+    }
+#endif
+    for (; i < n; i++) nexthash256(data[i], lens[i], digests[i]);
+}
+
+/* Scalar reduced-round hash of one message */
+static void hash_rounds(const uint8_t *data, size_t len, int rounds, uint8_t digest[32]) {
+    uint8_t tail[128];
+    uint32_t state[16];
+    size_t full, total = pad_tail(data, len, tail, &full);
+
+    memcpy(state, H_INIT, 64);
+    for (size_t b = 0; b < total; b++) {
+        compress_rounds(state, b < full ? data + 64 * b : tail + 64 * (b - full), rounds);
+    }
+    finalize_hash(state, digest);
+}
+
+void nexthash256_batch_rounds(const uint8_t *const *data, const size_t *lens,
+                              const uint8_t *rounds, size_t n, uint8_t (*digests)[32]) {
+    uint8_t r[8];
+    size_t i = 0;
+
+#ifdef NEXTHASH_HAVE_AVX2_DISPATCH
+    if (n >= 4 && __builtin_cpu_supports("avx2")) {
+        for (; i < n; i += 8) {
+            size_t cnt = (n - i < 8) ? n - i : 8;
+            for (size_t l = 0; l < cnt; l++) {
+                r[l] = rounds[i + l] < 1 ? 1 : rounds[i + l] > 52 ? 52 : rounds[i + l];
+            }
+            batch_x8(data + i, lens + i, r, cnt, digests + i);
+        }
+        return;
+    }
+#endif
+    for (; i < n; i++) {
+        r[0] = rounds[i] < 1 ? 1 : rounds[i] > 52 ? 52 : rounds[i];
+        hash_rounds(data[i], lens[i], r[0], digests[i]);
+    }
+}
+
 /* ========================================================================== */
 /* HMAC-NEXTHASH-256                                                           */
 /* ========================================================================== */
@@ -402,6 +880,76 @@ int main(void) {
     printf("  HMAC(\"key\", \"message\") -> ");
     print_hex(digest, 32);
 
+    /* Batch API must agree with the one-shot function */
+    {
+        uint8_t buf[300], batch[13][32], one[32];
+        const uint8_t *ptrs[13];
+        size_t lens[13];
+        int ok = 1;
+        for (size_t k = 0; k < sizeof(buf); k++) buf[k] = (uint8_t)(k * 31 + 7);
+        for (int k = 0; k < 13; k++) {
+            ptrs[k] = buf + k;
+            lens[k] = (size_t)(k * 23) % 200;
+        }
+        nexthash256_batch(ptrs, lens, 13, batch);
+        for (int k = 0; k < 13; k++) {
+            nexthash256(ptrs[k], lens[k], one);
+            if (memcmp(one, batch[k], 32) != 0) ok = 0;
+        }
+        printf("\nBatch API matches one-shot: %s\n", ok ? "OK" : "FAIL");
+    }
+
+    /* Reduced rounds: 52 is NEXTHASH-256, mixed lanes match the scalar path */
+    {
+        uint8_t buf[300], batch[13][32], one[32], rounds[13];
+        const uint8_t *ptrs[13];
+        size_t lens[13];
+        int ok = 1;
+        for (size_t k = 0; k < sizeof(buf); k++) buf[k] = (uint8_t)(k * 17 + 3);
+        for (int k = 0; k < 13; k++) {
+            ptrs[k] = buf + 2 * k;
+            lens[k] = (size_t)(k * 37) % 150;
+            rounds[k] = 52;
+        }
+        nexthash256_batch_rounds(ptrs, lens, rounds, 13, batch);
+        for (int k = 0; k < 13; k++) {
+            nexthash256(ptrs[k], lens[k], one);
+            if (memcmp(one, batch[k], 32) != 0) ok = 0;
+        }
+        for (int k = 0; k < 13; k++) rounds[k] = (uint8_t)(4 + (k * 11) % 49);
+        nexthash256_batch_rounds(ptrs, lens, rounds, 13, batch);
+        for (int k = 0; k < 13; k++) {
+            hash_rounds(ptrs[k], lens[k], rounds[k], one);
+            if (memcmp(one, batch[k], 32) != 0) ok = 0;
+        }
+        printf("Reduced-round batch: %s\n", ok ? "OK" : "FAIL");
+    }
+
+#ifdef NEXTHASH_HAVE_AVX512_DISPATCH
+    /* Single-message vector path must agree with the scalar reference */
+    if (use_zmm) {
+        uint32_t st_a[16], st_b[16], x = 0x12345678;
+        uint8_t block[64], da[32], db[32];
+        int ok = 1;
+        for (int t = 0; t < 1000; t++) {
+            for (int k = 0; k < 16; k++) {
+                x = x * 1664525u + 1013904223u;
+                st_a[k] = st_b[k] = x;
+            }
+            for (int k = 0; k < 64; k++) {
+                x = x * 1664525u + 1013904223u;
+                block[k] = (uint8_t)(x >> 24);
+            }
+            compress(st_a, block);
+            compress_zmm(st_b, block);
+            finalize_hash(st_a, da);
+            finalize_zmm(st_b, db);
+            if (memcmp(st_a, st_b, 64) != 0 || memcmp(da, db, 32) != 0) ok = 0;
+        }
+        printf("Vector path matches scalar: %s\n", ok ? "OK" : "FAIL");
+    }
+#endif
+
     printf("\nC implementation complete.\n");
     return 0;
 }
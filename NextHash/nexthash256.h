@@ -46,6 +46,24 @@ void nexthash256_final(nexthash256_ctx *ctx, uint8_t digest[32]);
 /* One-shot hash function */
 void nexthash256(const uint8_t *data, size_t len, uint8_t digest[32]);
 
+/*
+ * Batch hash: digests[i] = NEXTHASH-256(data[i], lens[i]).
+ * Messages are hashed eight at a time in AVX2 lanes when the CPU supports
+ * it; results are identical to calling nexthash256() per message.
+ */
+void nexthash256_batch(const uint8_t *const *data, const size_t *lens,
+                       size_t n, uint8_t (*digests)[32]);
+
+/*
+ * Reduced-round batch for simulations: as nexthash256_batch(), but every
+ * block of message i is compressed with only rounds[i] (1..52) rounds;
+ * 52 gives NEXTHASH-256. Each group of eight runs to its largest round
+ * count, so callers should order messages by rounds. Not a secure hash
+ * below 52 rounds.
+ */
+void nexthash256_batch_rounds(const uint8_t *const *data, const size_t *lens,
+                              const uint8_t *rounds, size_t n, uint8_t (*digests)[32]);
+
 /* HMAC-NEXTHASH-256 */
 void hmac_nexthash256(const uint8_t *key, size_t keylen,
                       const uint8_t *data, size_t datalen,
@@ -0,0 +1,403 @@
+/*
+ * NEXTHASH-256 v6 Compile-Time Evaluation
+ * =======================================
+ *
+ * constexpr C++17 version of the NEXTHASH-256 compression function, for
+ * hashing constant inputs at compile time and for baking midstates of
+ * fixed domain prefixes into the binary.
+ *
+ * Features:
+ * - nexthash::digest("abc") is a compile-time constant
+ * - prefix("BloomCoin seed") yields a nexthash256_ctx that runtime code
+ *   copies and continues with nexthash256_update()/nexthash256_final()
+ * - make_hmac_key("...") precomputes the k_ipad/k_opad blocks, saving two of
+ *   the four compressions of every HMAC under a fixed key
+ * - Known-answer tests run as static_asserts
+ *
+ * Compile (self-test):
+ *   gcc -O3 -c nexthash256.c
+ *   g++ -std=c++17 -O3 -DTEST_MAIN -o nexthash256_hpp -x c++ nexthash256.hpp -x none nexthash256.o
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef NEXTHASH256_HPP
+#define NEXTHASH256_HPP
+
+#include "nexthash256.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace nexthash {
+
+using digest_t = std::array<uint8_t, 32>;
+
+namespace detail {
+
+/* Same tables as nexthash256.c */
+inline constexpr uint32_t K[52] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5
+};
+
+inline constexpr uint32_t H_INIT[16] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    0xcbbb9d5d, 0x629a292a, 0x9159015a, 0x152fecd8,
+    0x67332667, 0x8eb44a87, 0xdb0c2e0d, 0x47b5481d
+};
+
+constexpr uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+constexpr uint32_t rotl(uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+
+constexpr uint32_t widening_mul(uint32_t a, uint32_t b) {
+    uint64_t product = (uint64_t)a * (uint64_t)b;
+    return (uint32_t)(product >> 32) ^ (uint32_t)product;
+}
+
+constexpr uint32_t Ch(uint32_t x, uint32_t y, uint32_t z) { return (x & y) ^ (~x & z); }
+constexpr uint32_t Maj(uint32_t x, uint32_t y, uint32_t z) { return (x & y) ^ (x & z) ^ (y & z); }
+constexpr uint32_t Sigma0(uint32_t x) { return rotr(x, 2) ^ rotr(x, 13) ^ rotr(x, 22); }
+constexpr uint32_t Sigma1(uint32_t x) { return rotr(x, 6) ^ rotr(x, 11) ^ rotr(x, 25); }
+constexpr uint32_t sigma0(uint32_t x) { return rotr(x, 7) ^ rotr(x, 18) ^ (x >> 3); }
+constexpr uint32_t sigma1(uint32_t x) { return rotr(x, 17) ^ rotr(x, 19) ^ (x >> 10); }
+
+/* compress() from nexthash256.c */
+constexpr void compress(uint32_t state[16], const uint8_t block[64]) {
+    uint32_t W[52] = {};
+    for (int i = 0; i < 16; i++) {
+        W[i] = ((uint32_t)block[i*4] << 24) | ((uint32_t)block[i*4 + 1] << 16) |
+               ((uint32_t)block[i*4 + 2] << 8) | (uint32_t)block[i*4 + 3];
+    }
+    for (int i = 16; i < 52; i++) {
+        uint32_t linear = sigma1(W[i-2]) + W[i-7] + sigma0(W[i-15]) + W[i-16];
+        uint32_t nl1 = widening_mul(W[i-3], W[i-10]);
+        uint32_t nl2 = widening_mul(W[i-5], W[i-12]);
+        uint32_t nl3 = widening_mul(W[i-1] ^ W[i-8], W[i-4] ^ W[i-14]);
+        W[i] = linear + nl1 + (nl2 ^ nl3);
+    }
+
+    uint32_t s[16] = {};
+    for (int i = 0; i < 16; i++) s[i] = state[i];
+
+    for (int r = 0; r < 52; r++) {
+        uint32_t a = s[0], b = s[1], c = s[2], d = s[3];
+        uint32_t e = s[4], f = s[5], g = s[6], h = s[7];
+        uint32_t i = s[8], j = s[9], k = s[10], l = s[11];
+        uint32_t m = s[12], n = s[13], o = s[14], p = s[15];
+
+        uint32_t T1 = h + Sigma1(e) + Ch(e, f, g) + K[r] + W[r];
+        uint32_t T2 = Sigma0(a) + Maj(a, b, c);
+        uint32_t M1 = widening_mul(a ^ i, e ^ m);
+        uint32_t M2 = widening_mul(b ^ j, f ^ n);
+        uint32_t M3 = widening_mul(c ^ k, g ^ o);
+        uint32_t M4 = widening_mul(d ^ l, h ^ p);
+        uint32_t M5 = widening_mul(a ^ m, e ^ i);
+        uint32_t M6 = widening_mul(b ^ n, f ^ j);
+        uint32_t M7 = widening_mul(c ^ o, g ^ k);
+        uint32_t M8 = widening_mul(d ^ p, h ^ l);
+        uint32_t M9 = widening_mul(a ^ p, d ^ m);
+        uint32_t M10 = widening_mul(b ^ o, c ^ n);
+        uint32_t T3 = p + Sigma1(m) + Ch(m, n, o) + (K[r] ^ 0x5A5A5A5A) + W[r];
+        uint32_t T4 = Sigma0(i) + Maj(i, j, k);
+
+        s[0] = T1 + T2 + M1 + M5 + M9;
+        s[1] = a + M6 + M10;
+        s[2] = b;
+        s[3] = c + M2 + M7;
+        s[4] = d + T1 + M9;
+        s[5] = e + M8;
+        s[6] = f;
+        s[7] = g + M3 + M10;
+        s[8] = T3 + T4 + M1 + M5;
+        s[9] = i + M6;
+        s[10] = j;
+        s[11] = k + M4 + M7;
+        s[12] = l + T3 + M9;
+        s[13] = m + M8;
+        s[14] = n;
+        s[15] = o + (M2 ^ M3 ^ M4) + M10;
+
+        if ((r + 1) % 4 == 0) {
+            uint32_t t[16] = {};
+            for (int q = 0; q < 8; q++) {
+                t[2 * q] = s[q];
+                t[2 * q + 1] = s[q + 8];
+            }
+            for (int q = 0; q < 16; q++) s[q] = t[q];
+        }
+    }
+
+    for (int q = 0; q < 16; q++) state[q] += s[q];
+}
+
+/* finalize_hash() from nexthash256.c */
+constexpr digest_t finalize(const uint32_t state[16]) {
+    uint32_t folded[8] = {};
+    for (int i = 0; i < 8; i++) {
+        uint32_t upper = state[i], lower = state[i + 8];
+        folded[i] = (upper ^ lower) +
+                    widening_mul(upper, rotl(lower, 13)) +
+                    widening_mul(lower, rotr(upper, 7)) +
+                    widening_mul(upper ^ lower, rotr(upper, 3) ^ rotl(lower, 11)) +
+                    rotr(upper ^ lower, i + 1);
+    }
+    for (int round = 0; round < 3; round++) {
+        uint32_t nf[8] = {};
+        for (int i = 0; i < 8; i++) {
+            nf[i] = folded[i] +
+                    widening_mul(folded[(i + 1) % 8], folded[(i + 5) % 8]) +
+                    widening_mul(folded[(i + 2) % 8], folded[(i + 6) % 8]) +
+                    rotr(folded[(i + 3) % 8], 7) +
+                    rotl(folded[(i + 7) % 8], 11);
+        }
+        for (int i = 0; i < 8; i++) folded[i] = nf[i];
+    }
+
+    digest_t out = {};
+    for (int i = 0; i < 8; i++) {
+        out[i*4] = (uint8_t)(folded[i] >> 24);
+        out[i*4 + 1] = (uint8_t)(folded[i] >> 16);
+        out[i*4 + 2] = (uint8_t)(folded[i] >> 8);
+        out[i*4 + 3] = (uint8_t)folded[i];
+    }
+    return out;
+}
+
+} /* namespace detail */
+
+/* ========================================================================== */
+/* Streaming                                                                   */
+/* ========================================================================== */
+
+/* nexthash256_init() */
+constexpr nexthash256_ctx init() {
+    nexthash256_ctx ctx = {};
+    for (int i = 0; i < 16; i++) ctx.state[i] = detail::H_INIT[i];
+    return ctx;
+}
+
+/* nexthash256_update() over bytes */
+constexpr nexthash256_ctx update(nexthash256_ctx ctx, const uint8_t *data, size_t len) {
+    ctx.bitcount += (uint64_t)len * 8;
+    for (size_t i = 0; i < len; i++) {
+        ctx.buffer[ctx.buflen++] = data[i];
+        if (ctx.buflen == 64) {
+            detail::compress(ctx.state, ctx.buffer);
+            ctx.buflen = 0;
+        }
+    }
+    return ctx;
+}
+
+constexpr nexthash256_ctx update(nexthash256_ctx ctx, std::string_view s) {
+    ctx.bitcount += (uint64_t)s.size() * 8;
+    for (char ch : s) {
+        ctx.buffer[ctx.buflen++] = (uint8_t)ch;
+        if (ctx.buflen == 64) {
+            detail::compress(ctx.state, ctx.buffer);
+            ctx.buflen = 0;
+        }
+    }
+    return ctx;
+}
+
+/* nexthash256_final() */
+constexpr digest_t final(nexthash256_ctx ctx) {
+    uint64_t bits = ctx.bitcount;
+    uint8_t pad[128] = {};
+    size_t padlen = (ctx.buflen < 56) ? (56 - ctx.buflen) : (120 - ctx.buflen);
+    pad[0] = 0x80;
+    for (int k = 0; k < 8; k++) pad[padlen + k] = (uint8_t)(bits >> (56 - 8 * k));
+    ctx = update(ctx, pad, padlen + 8);
+    return detail::finalize(ctx.state);
+}
+
+/* One-shot digest */
+constexpr digest_t digest(std::string_view s) {
+    return final(update(init(), s));
+}
+
+/*
+ * Context after absorbing a constant prefix. Copy it and continue at run
+ * time; prefixes of 64 bytes or more skip their compressions entirely.
+ */
+constexpr nexthash256_ctx prefix(std::string_view tag) {
+    return update(init(), tag);
+}
+
+/* ========================================================================== */
+/* HMAC With a Fixed Key                                                       */
+/* ========================================================================== */
+
+struct hmac_key {
+    nexthash256_ctx inner;  /* after k_ipad */
+    nexthash256_ctx outer;  /* after k_opad */
+};
+
+/* hmac_nexthash256() key setup; keys over 64 bytes are hashed first */
+constexpr hmac_key make_hmac_key(std::string_view key) {
+    uint8_t k[64] = {};
+    if (key.size() > 64) {
+        digest_t hk = digest(key);
+        for (int i = 0; i < 32; i++) k[i] = hk[i];
+    } else {
+        for (size_t i = 0; i < key.size(); i++) k[i] = (uint8_t)key[i];
+    }
+    uint8_t ipad[64] = {}, opad[64] = {};
+    for (int i = 0; i < 64; i++) {
+        ipad[i] = (uint8_t)(k[i] ^ 0x36);
+        opad[i] = (uint8_t)(k[i] ^ 0x5C);
+    }
+    return hmac_key{ update(init(), ipad, 64), update(init(), opad, 64) };
+}
+
+/* hmac_nexthash256() resumed from precomputed pads (run time) */
+inline void hmac(const hmac_key &key, const uint8_t *data, size_t len, uint8_t out[32]) {
+    nexthash256_ctx ctx = key.inner;
+    nexthash256_update(&ctx, data, len);
+    nexthash256_final(&ctx, out);
+    ctx = key.outer;
+    nexthash256_update(&ctx, out, 32);
+    nexthash256_final(&ctx, out);
+}
+
+/* Compile-time HMAC of constant data */
+constexpr digest_t hmac(const hmac_key &key, std::string_view data) {
+    digest_t inner = final(update(key.inner, data));
+    return final(update(key.outer, inner.data(), inner.size()));
+}
+
+/* ========================================================================== */
+/* Domain Tags                                                                 */
+/* ========================================================================== */
+
+/* Prefixes hashed by game/bloomcoin_nexthash_wallet.py */
+namespace tags {
+inline constexpr nexthash256_ctx seed = prefix("BloomCoin seed");
+inline constexpr nexthash256_ctx chain = prefix("chain");
+inline constexpr nexthash256_ctx public_round[3] = {
+    prefix("public_round_0"), prefix("public_round_1"), prefix("public_round_2")
+};
+} /* namespace tags */
+
+/* Run-time digest of tag || data, starting from a baked context */
+inline void tagged(const nexthash256_ctx &tag, const uint8_t *data, size_t len,
+                   uint8_t out[32]) {
+    nexthash256_ctx ctx = tag;
+    nexthash256_update(&ctx, data, len);
+    nexthash256_final(&ctx, out);
+}
+
+/* ========================================================================== */
+/* Known-Answer Tests                                                          */
+/* ========================================================================== */
+
+namespace detail {
+
+constexpr bool equal_hex(const digest_t &d, std::string_view hex) {
+    constexpr char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < 32; i++) {
+        if (hex[2 * i] != digits[d[i] >> 4] || hex[2 * i + 1] != digits[d[i] & 15]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(equal_hex(digest(""),
+    "358285dfcac6757d8fde93327ff754a1f0a8baf8582c28664dfcfefaf609e70b"), "KAT \"\"");
+static_assert(equal_hex(digest("abc"),
+    "2522d5fef2a05ae3db9574af7623611cc029e99226b408a0d036df03a333c1b8"), "KAT abc");
+static_assert(equal_hex(digest("The quick brown fox jumps over the lazy dog"),
+    "23f979d42679cee10a12de96eebf8af2073ae52dd543bfd70d80d9450c6d4d59"), "KAT fox");
+static_assert(equal_hex(hmac(make_hmac_key("key"), "message"),
+    "91df38346f9d1355ebd10920119c62e11554c0c5acd51d720d01b10eaa348916"), "KAT HMAC");
+
+} /* namespace detail */
+
+} /* namespace nexthash */
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <cstdio>
+#include <cstring>
+
+int main() {
+    int fail = 0;
+    printf("NEXTHASH-256 constexpr\n");
+    printf("======================\n\n");
+
+    /* Baked tag contexts continue exactly like hashing tag || data */
+    uint8_t data[200], a[32], b[32];
+    for (int i = 0; i < 200; i++) data[i] = (uint8_t)(i * 13 + 1);
+    {
+        const char *tag = "BloomCoin seed";
+        uint8_t joined[214];
+        memcpy(joined, tag, 14);
+        memcpy(joined + 14, data, 200);
+        nexthash::tagged(nexthash::tags::seed, data, 32, a);
+        nexthash256(joined, 14 + 32, b);
+        int ok = memcmp(a, b, 32) == 0;
+        nexthash::tagged(nexthash::tags::seed, data, 200, a);
+        nexthash256(joined, 214, b);
+        ok &= memcmp(a, b, 32) == 0;
+        printf("tag midstate resume:      %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* 64-byte prefix: compression done at compile time */
+    {
+        constexpr std::string_view block64 =
+            "BloomCoin/phase-encoded-header/v1/0123456789abcdef0123456789abcd";
+        static_assert(block64.size() == 64, "prefix length");
+        constexpr nexthash256_ctx pre = nexthash::prefix(block64);
+        static_assert(pre.buflen == 0, "full block absorbed");
+        uint8_t joined[128];
+        memcpy(joined, block64.data(), 64);
+        memcpy(joined + 64, data, 64);
+        nexthash::tagged(pre, data, 64, a);
+        nexthash256(joined, 128, b);
+        int ok = memcmp(a, b, 32) == 0;
+        printf("64-byte prefix midstate:  %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Fixed-key HMAC matches hmac_nexthash256() */
+    {
+        static constexpr nexthash::hmac_key key = nexthash::make_hmac_key("BloomCoin HMAC key");
+        int ok = 1;
+        for (size_t len = 0; len <= 200; len += 25) {
+            nexthash::hmac(key, data, len, a);
+            hmac_nexthash256((const uint8_t *)"BloomCoin HMAC key", 18, data, len, b);
+            ok &= memcmp(a, b, 32) == 0;
+        }
+        printf("fixed-key HMAC:           %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    printf("compile-time KATs:        OK (static_assert)\n");
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
+
+#endif /* NEXTHASH256_HPP */
@@ -0,0 +1,1006 @@
+/*
+ * NEXTHASH-256 Local Hashing Daemon
+ * =================================
+ *
+ * Compile: gcc -O3 -c nexthash256.c
+ *          gcc -O3 -pthread -o nexthash_daemon nexthash_daemon.c nexthash256.o -DTEST_MAIN
+ */
+
+#define _GNU_SOURCE
+#include "nexthash_daemon.h"
+#include "nexthash256.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#define NH_MAGIC    0x4D44484Eu     /* "NHDM" */
+#define NH_VERSION  2
+
+#define NH_INFLIGHT 16              /* slots one client call may hold */
+#define NH_LANES    64              /* sweep messages per nexthash256_batch() */
+#define NH_DIGITS   20              /* decimal digits of UINT64_MAX */
+#define NH_BURST    4               /* chunks in a row for one sweep before rotating */
+#define NH_RECLAIM_MS 1000          /* reserved slot with no owner recorded */
+
+enum { JOB_HASH = 1, JOB_SWEEP = 2 };
+
+/* ========================================================================== */
+/* Shared Layout                                                               */
+/* ========================================================================== */
+
+typedef struct {
+    uint64_t seq;                   /* ring sequence number */
+    uint64_t owner_pos;             /* ring position owner was recorded for */
+    int32_t owner;                  /* pid of the reserving client */
+    uint32_t done;                  /* futex: set to 1 by the daemon */
+    uint32_t type;
+    int32_t status;
+
+    /* JOB_HASH */
+    uint32_t n_msgs;
+    uint32_t lens[NEXTHASH_DAEMON_MAX_MSGS];
+    uint8_t digests[NEXTHASH_DAEMON_MAX_MSGS][32];
+
+    /* JOB_SWEEP */
+    uint64_t start;
+    uint64_t count;
+    uint32_t difficulty;
+    uint32_t prefix_len;
+    uint32_t found;
+    uint64_t nonce;
+    uint8_t digest[32];
+
+    uint8_t payload[NEXTHASH_DAEMON_PAYLOAD];
+} __attribute__((aligned(64))) nh_slot;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t n_slots;
+    uint32_t slot_size;
+    uint32_t stop;
+    uint32_t work;                  /* futex: bumped per submission */
+    uint32_t freed;                 /* futex: bumped per released slot */
+    uint64_t head __attribute__((aligned(64)));
+    uint64_t tail __attribute__((aligned(64)));
+    nh_slot slots[] __attribute__((aligned(64)));
+} nh_shm;
+
+#define NH_MASK (NEXTHASH_DAEMON_SLOTS - 1)
+
+static size_t shm_size(void) {
+    return sizeof(nh_shm) + NEXTHASH_DAEMON_SLOTS * sizeof(nh_slot);
+}
+
+static void shm_path(char *out, size_t cap, const char *name) {
+    snprintf(out, cap, "%s%s", name[0] == '/' ? "" : "/", name);
+}
+
+/* ========================================================================== */
+/* Futex                                                                       */
+/* ========================================================================== */
+
+/* Shared (not PRIVATE) operations: waiters live in other processes */
+static void futex_wait(uint32_t *addr, uint32_t val, long timeout_ms) {
+    struct timespec ts = { timeout_ms / 1000, (timeout_ms % 1000) * 1000000L };
+    syscall(SYS_futex, addr, FUTEX_WAIT, val, timeout_ms >= 0 ? &ts : NULL, NULL, 0);
+}
+
+static void futex_wake(uint32_t *addr, int n) {
+    syscall(SYS_futex, addr, FUTEX_WAKE, n, NULL, NULL, 0);
+}
+
+static void bump(uint32_t *addr, int wake) {
+    __atomic_add_fetch(addr, 1, __ATOMIC_RELEASE);
+    futex_wake(addr, wake);
+}
+
+/* ========================================================================== */
+/* Ring                                                                        */
+/* ========================================================================== */
+
+/*
+ * Bounded MPMC ring (sequence-numbered slots). Unlike a plain queue a slot
+ * is not recycled when a worker takes it: the job is answered in place and
+ * the submitting client returns the slot after reading its results.
+ *
+ *   seq == pos              free for the producer at pos
+ *   seq == pos + 1          queued for a worker
+ *   seq == pos + n_slots    released, free for the next lap
+ *
+ * Each slot records the pid of the client holding it. A slot whose owner
+ * died is reclaimed: by a worker when it was reserved but never published
+ * (it blocks the tail), by the next producer when it was answered but
+ * never released (it blocks the head a lap later).
+ */
+
+static int pid_alive(int32_t pid) {
+    return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+/* Answered slot of the previous lap whose owner is gone: free it for pos */
+static int reclaim_head(nh_slot *s, uint64_t pos) {
+    uint64_t prev = pos - NEXTHASH_DAEMON_SLOTS;
+    uint64_t expect = prev + 1;
+    if (__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) != expect ||
+        !__atomic_load_n(&s->done, __ATOMIC_ACQUIRE) ||
+        __atomic_load_n(&s->owner_pos, __ATOMIC_ACQUIRE) != prev || pid_alive(s->owner)) {
+        return 0;
+    }
+    return __atomic_compare_exchange_n(&s->seq, &expect, pos, 0,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+/* Claim a slot for writing; returns NULL once the daemon stops */
+static nh_slot *ring_reserve(nh_shm *shm, uint64_t *pos_out) {
+    for (;;) {
+        if (__atomic_load_n(&shm->stop, __ATOMIC_ACQUIRE)) return NULL;
+        uint32_t freed = __atomic_load_n(&shm->freed, __ATOMIC_ACQUIRE);
+        uint64_t pos = __atomic_load_n(&shm->head, __ATOMIC_RELAXED);
+        nh_slot *s = &shm->slots[pos & NH_MASK];
+        int64_t dif = (int64_t)(__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) - pos);
+        if (dif == 0) {
+            if (__atomic_compare_exchange_n(&shm->head, &pos, pos + 1, 0,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                s->owner = (int32_t)getpid();
+                __atomic_store_n(&s->owner_pos, pos, __ATOMIC_RELEASE);
+                *pos_out = pos;
+                return s;
+            }
+        } else if (dif < 0 && !reclaim_head(s, pos)) {
+            futex_wait(&shm->freed, freed, 100);    /* ring full */
+        }
+    }
+}
+
+/* Returns 0 if a worker reclaimed the slot in the meantime */
+static int ring_publish(nh_shm *shm, nh_slot *s, uint64_t pos) {
+    uint64_t expect = pos;
+    s->done = 0;
+    if (!__atomic_compare_exchange_n(&s->seq, &expect, pos + 1, 0,
+                                     __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        return 0;
+    }
+    bump(&shm->work, 1);
+    return 1;
+}
+
+static nh_slot *ring_take(nh_shm *shm) {
+    for (;;) {
+        uint64_t pos = __atomic_load_n(&shm->tail, __ATOMIC_RELAXED);
+        nh_slot *s = &shm->slots[pos & NH_MASK];
+        int64_t dif = (int64_t)(__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) - (pos + 1));
+        if (dif == 0) {
+            if (__atomic_compare_exchange_n(&shm->tail, &pos, pos + 1, 0,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                return s;
+            }
+        } else if (dif < 0) {
+            return NULL;
+        }
+    }
+}
+
+static void ring_release(nh_shm *shm, nh_slot *s, uint64_t pos) {
+    __atomic_store_n(&s->seq, pos + NEXTHASH_DAEMON_SLOTS, __ATOMIC_RELEASE);
+    bump(&shm->freed, INT_MAX);
+}
+
+static void slot_complete(nh_slot *s, int status) {
+    s->status = status;
+    __atomic_store_n(&s->done, 1, __ATOMIC_RELEASE);
+    futex_wake(&s->done, 1);
+}
+
+/* Returns the slot status, or ERR_STOPPED if the daemon went away */
+static int slot_wait(nh_shm *shm, nh_slot *s) {
+    while (!__atomic_load_n(&s->done, __ATOMIC_ACQUIRE)) {
+        if (__atomic_load_n(&shm->stop, __ATOMIC_ACQUIRE) == 2) {
+            return NEXTHASH_DAEMON_ERR_STOPPED;
+        }
+        futex_wait(&s->done, 0, 100);
+    }
+    return s->status;
+}
+
+/* ========================================================================== */
+/* Sweeps                                                                      */
+/* ========================================================================== */
+
+/*
+ * A sweep being worked on; chunks are handed out under the daemon lock.
+ * The job is copied out of the slot once, after validation, so a client
+ * rewriting shared memory mid-sweep cannot change what the workers read.
+ */
+typedef struct sweep_run {
+    nh_slot *slot;
+    uint8_t prefix[NEXTHASH_DAEMON_MAX_PREFIX];
+    uint32_t prefix_len;
+    unsigned difficulty;
+    uint64_t start;
+    uint64_t count;
+    uint64_t chunks;
+    uint64_t next;              /* next unclaimed chunk */
+    unsigned active;            /* chunks being hashed */
+    unsigned streak;            /* chunks handed out since it reached the front */
+    uint64_t best;              /* lowest matching nonce, UINT64_MAX if none */
+    uint8_t digest[32];
+    struct sweep_run *next_run;
+} sweep_run;
+
+static int leading_zero_hex(const uint8_t d[32], unsigned difficulty) {
+    if (difficulty > 64) return 0;
+    for (unsigned i = 0; i < difficulty / 2; i++) {
+        if (d[i]) return 0;
+    }
+    return !(difficulty & 1) || (d[difficulty / 2] >> 4) == 0;
+}
+
+static unsigned format_u64(uint64_t v, uint8_t *out) {
+    uint8_t tmp[NH_DIGITS];
+    unsigned n = 0;
+    do {
+        tmp[n++] = (uint8_t)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    for (unsigned i = 0; i < n; i++) out[i] = tmp[n - 1 - i];
+    return n;
+}
+
+/* Hash nonces [lo, hi) in lane batches; stops at the first match */
+static int sweep_chunk(const sweep_run *r, uint64_t lo, uint64_t hi,
+                       uint64_t *nonce, uint8_t digest[32]) {
+    enum { STRIDE = NEXTHASH_DAEMON_MAX_PREFIX + NH_DIGITS };
+    uint8_t msgs[NH_LANES][STRIDE];
+    const uint8_t *ptrs[NH_LANES];
+    size_t lens[NH_LANES];
+    uint8_t out[NH_LANES][32];
+    uint32_t plen = r->prefix_len;
+
+    for (int i = 0; i < NH_LANES; i++) {
+        memcpy(msgs[i], r->prefix, plen);
+        ptrs[i] = msgs[i];
+    }
+    for (uint64_t base = lo; base < hi; base += NH_LANES) {
+        size_t n = hi - base < NH_LANES ? (size_t)(hi - base) : NH_LANES;
+        for (size_t i = 0; i < n; i++) {
+            lens[i] = plen + format_u64(base + i, msgs[i] + plen);
+        }
+        nexthash256_batch(ptrs, lens, n, out);
+        for (size_t i = 0; i < n; i++) {
+            if (leading_zero_hex(out[i], r->difficulty)) {
+                *nonce = base + i;
+                memcpy(digest, out[i], 32);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* ========================================================================== */
+/* Daemon                                                                      */
+/* ========================================================================== */
+
+struct nexthash_daemon {
+    char path[NAME_MAX];
+    nh_shm *shm;
+    pthread_t *threads;
+    unsigned n_threads;
+    int pin;
+
+    pthread_mutex_t lock;
+    sweep_run *runs;
+
+    /* Tail slot seen reserved with no owner recorded, and since when */
+    uint64_t stall_pos;
+    double stall_since;
+};
+
+typedef struct {
+    nexthash_daemon *d;
+    unsigned index;
+} worker_arg;
+
+static void finish_sweep(sweep_run *r, int status) {
+    nh_slot *s = r->slot;
+    s->found = r->best != UINT64_MAX;
+    if (s->found) {
+        s->nonce = r->best;
+        memcpy(s->digest, r->digest, 32);
+    }
+    slot_complete(s, status);
+    free(r);
+}
+
+static void start_sweep(nexthash_daemon *d, nh_slot *s) {
+    sweep_run *r = (sweep_run *)calloc(1, sizeof(sweep_run));
+    if (!r) {
+        slot_complete(s, NEXTHASH_DAEMON_ERR_SYS);
+        return;
+    }
+    r->slot = s;
+    r->prefix_len = s->prefix_len;
+    r->difficulty = s->difficulty;
+    r->start = s->start;
+    r->count = s->count;
+    if (r->prefix_len > NEXTHASH_DAEMON_MAX_PREFIX || r->count > UINT64_MAX - r->start) {
+        free(r);
+        slot_complete(s, NEXTHASH_DAEMON_ERR_TOO_BIG);
+        return;
+    }
+    memcpy(r->prefix, s->payload, r->prefix_len);
+    r->chunks = r->count / NEXTHASH_DAEMON_CHUNK + (r->count % NEXTHASH_DAEMON_CHUNK != 0);
+    r->best = UINT64_MAX;
+    if (r->chunks == 0) {
+        finish_sweep(r, NEXTHASH_DAEMON_OK);
+        return;
+    }
+    pthread_mutex_lock(&d->lock);
+    r->next_run = d->runs;
+    d->runs = r;
+    pthread_mutex_unlock(&d->lock);
+    bump(&d->shm->work, INT_MAX);       /* call in the idle workers */
+}
+
+/*
+ * Hash one chunk of some active sweep; returns 0 if there was none. After
+ * NH_BURST chunks a sweep moves to the back of the list, so concurrent
+ * sweeps share the workers.
+ */
+static int help_sweep(nexthash_daemon *d) {
+    pthread_mutex_lock(&d->lock);
+    sweep_run **pp = &d->runs;
+    while (*pp && (*pp)->next >= (*pp)->chunks) pp = &(*pp)->next_run;
+    sweep_run *r = *pp;
+    if (!r) {
+        pthread_mutex_unlock(&d->lock);
+        return 0;
+    }
+    uint64_t c = r->next++;
+    r->active++;
+    if (++r->streak >= NH_BURST && r->next_run) {
+        r->streak = 0;
+        *pp = r->next_run;
+        sweep_run **tail = pp;
+        while (*tail) tail = &(*tail)->next_run;
+        *tail = r;
+        r->next_run = NULL;
+    }
+    pthread_mutex_unlock(&d->lock);
+
+    uint64_t lo = r->start + c * NEXTHASH_DAEMON_CHUNK;
+    uint64_t end = r->start + r->count;
+    uint64_t hi = end - lo < NEXTHASH_DAEMON_CHUNK ? end : lo + NEXTHASH_DAEMON_CHUNK;
+    uint64_t nonce;
+    uint8_t digest[32];
+    int found = sweep_chunk(r, lo, hi, &nonce, digest);
+
+    pthread_mutex_lock(&d->lock);
+    r->active--;
+    if (found && nonce < r->best) {
+        r->best = nonce;
+        memcpy(r->digest, digest, 32);
+    }
+    if (found) {
+        /* Unclaimed chunks all lie above this one */
+        r->next = r->chunks;
+    }
+    int finished = r->next >= r->chunks && r->active == 0;
+    if (finished) {
+        pp = &d->runs;
+        while (*pp != r) pp = &(*pp)->next_run;
+        *pp = r->next_run;
+    }
+    pthread_mutex_unlock(&d->lock);
+
+    if (finished) finish_sweep(r, NEXTHASH_DAEMON_OK);
+    return 1;
+}
+
+/* Counts and lengths are read once and checked: the slot is client memory */
+static void run_hash(nh_slot *s) {
+    const uint8_t *ptrs[NEXTHASH_DAEMON_MAX_MSGS];
+    size_t lens[NEXTHASH_DAEMON_MAX_MSGS];
+    size_t off = 0;
+    uint32_t n = s->n_msgs;
+    if (n > NEXTHASH_DAEMON_MAX_MSGS) {
+        slot_complete(s, NEXTHASH_DAEMON_ERR_TOO_BIG);
+        return;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        lens[i] = s->lens[i];
+        if (lens[i] > NEXTHASH_DAEMON_PAYLOAD - off) {
+            slot_complete(s, NEXTHASH_DAEMON_ERR_TOO_BIG);
+            return;
+        }
+        ptrs[i] = s->payload + off;
+        off += lens[i];
+    }
+    nexthash256_batch(ptrs, lens, n, s->digests);
+    slot_complete(s, NEXTHASH_DAEMON_OK);
+}
+
+static double mono_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+}
+
+/*
+ * The tail slot is reserved but unpublished. If its owner died (or never
+ * recorded itself within NH_RECLAIM_MS), move the tail past it and free
+ * the slot. Returns the slot instead when the owner published after all.
+ */
+static nh_slot *reclaim_tail(nexthash_daemon *d) {
+    nh_shm *shm = d->shm;
+    uint64_t pos = __atomic_load_n(&shm->tail, __ATOMIC_ACQUIRE);
+    nh_slot *s = &shm->slots[pos & NH_MASK];
+    if (__atomic_load_n(&shm->head, __ATOMIC_ACQUIRE) <= pos ||
+        __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) != pos) {
+        return NULL;
+    }
+
+    int dead;
+    if (__atomic_load_n(&s->owner_pos, __ATOMIC_ACQUIRE) == pos) {
+        dead = !pid_alive(s->owner);
+    } else {
+        double now = mono_ms();
+        pthread_mutex_lock(&d->lock);
+        if (d->stall_pos != pos) {
+            d->stall_pos = pos;
+            d->stall_since = now;
+        }
+        dead = now - d->stall_since >= NH_RECLAIM_MS;
+        pthread_mutex_unlock(&d->lock);
+    }
+    if (!dead || !__atomic_compare_exchange_n(&shm->tail, &pos, pos + 1, 0,
+                                              __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        return NULL;
+    }
+    uint64_t expect = pos;
+    if (__atomic_compare_exchange_n(&s->seq, &expect, pos + NEXTHASH_DAEMON_SLOTS, 0,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        bump(&shm->freed, INT_MAX);
+        return NULL;
+    }
+    return s;       /* published between the checks: ours to run */
+}
+
+static void *worker_main(void *arg) {
+    nexthash_daemon *d = ((worker_arg *)arg)->d;
+    unsigned index = ((worker_arg *)arg)->index;
+    nh_shm *shm = d->shm;
+    free(arg);
+
+    if (d->pin) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(index % (cpus > 0 ? (unsigned)cpus : 1), &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    /* Ring jobs first, one sweep chunk at most between two ring checks,
+     * so a long sweep never holds up other clients' jobs */
+    while (!__atomic_load_n(&shm->stop, __ATOMIC_ACQUIRE)) {
+        uint32_t seen = __atomic_load_n(&shm->work, __ATOMIC_ACQUIRE);
+        nh_slot *s = ring_take(shm);
+        if (!s) s = reclaim_tail(d);
+        if (s) {
+            if (s->type == JOB_HASH) run_hash(s);
+            else start_sweep(d, s);
+            continue;
+        }
+        if (help_sweep(d)) continue;
+
+        /* Poll while a reserved slot is outstanding: its owner may die */
+        int pending = __atomic_load_n(&shm->head, __ATOMIC_ACQUIRE) !=
+                      __atomic_load_n(&shm->tail, __ATOMIC_ACQUIRE);
+        futex_wait(&shm->work, seen, pending ? 100 : -1);
+    }
+    return NULL;
+}
+
+nexthash_daemon *nexthash_daemon_start(const char *name, unsigned threads, int pin) {
+    nexthash_daemon *d = (nexthash_daemon *)calloc(1, sizeof(nexthash_daemon));
+    if (!d) return NULL;
+    shm_path(d->path, sizeof(d->path), name);
+    d->pin = pin;
+    d->stall_pos = UINT64_MAX;
+
+    /* A stale segment from a crashed daemon is replaced */
+    shm_unlink(d->path);
+    int fd = shm_open(d->path, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        free(d);
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t)shm_size()) != 0) {
+        close(fd);
+        shm_unlink(d->path);
+        free(d);
+        return NULL;
+    }
+    d->shm = (nh_shm *)mmap(NULL, shm_size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (d->shm == MAP_FAILED) {
+        shm_unlink(d->path);
+        free(d);
+        return NULL;
+    }
+
+    nh_shm *shm = d->shm;
+    shm->n_slots = NEXTHASH_DAEMON_SLOTS;
+    shm->slot_size = sizeof(nh_slot);
+    for (uint64_t i = 0; i < NEXTHASH_DAEMON_SLOTS; i++) shm->slots[i].seq = i;
+    shm->version = NH_VERSION;
+    __atomic_store_n(&shm->magic, NH_MAGIC, __ATOMIC_RELEASE);
+
+    pthread_mutex_init(&d->lock, NULL);
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (unsigned)cpus : 1;
+    }
+    d->threads = (pthread_t *)calloc(threads, sizeof(pthread_t));
+    for (unsigned i = 0; d->threads && i < threads; i++) {
+        worker_arg *a = (worker_arg *)malloc(sizeof(worker_arg));
+        if (!a) break;
+        a->d = d;
+        a->index = i;
+        if (pthread_create(&d->threads[i], NULL, worker_main, a) != 0) {
+            free(a);
+            break;
+        }
+        d->n_threads++;
+    }
+    if (d->n_threads == 0) {
+        nexthash_daemon_stop(d);
+        return NULL;
+    }
+    return d;
+}
+
+void nexthash_daemon_stop(nexthash_daemon *d) {
+    if (!d) return;
+    nh_shm *shm = d->shm;
+    __atomic_store_n(&shm->stop, 1, __ATOMIC_RELEASE);
+    bump(&shm->work, INT_MAX);
+    bump(&shm->freed, INT_MAX);
+    for (unsigned i = 0; i < d->n_threads; i++) {
+        pthread_join(d->threads[i], NULL);
+    }
+
+    /* Answer everything still in flight */
+    while (d->runs) {
+        sweep_run *r = d->runs;
+        d->runs = r->next_run;
+        finish_sweep(r, NEXTHASH_DAEMON_ERR_STOPPED);
+    }
+    nh_slot *s;
+    while ((s = ring_take(shm)) != NULL) {
+        slot_complete(s, NEXTHASH_DAEMON_ERR_STOPPED);
+    }
+    /* Clients that reserved but never published give up on stop == 2 */
+    __atomic_store_n(&shm->stop, 2, __ATOMIC_RELEASE);
+
+    pthread_mutex_destroy(&d->lock);
+    munmap(shm, shm_size());
+    shm_unlink(d->path);
+    free(d->threads);
+    free(d);
+}
+
+/* ========================================================================== */
+/* Client                                                                      */
+/* ========================================================================== */
+
+struct nexthash_client {
+    nh_shm *shm;
+};
+
+nexthash_client *nexthash_client_open(const char *name, int *status) {
+    char path[NAME_MAX];
+    int st = NEXTHASH_DAEMON_ERR_SYS;
+    nexthash_client *c = NULL;
+    shm_path(path, sizeof(path), name);
+
+    int fd = shm_open(path, O_RDWR, 0);
+    if (fd >= 0) {
+        struct stat sb;
+        void *map = MAP_FAILED;
+        if (fstat(fd, &sb) == 0 && (size_t)sb.st_size == shm_size()) {
+            map = mmap(NULL, shm_size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        } else {
+            st = NEXTHASH_DAEMON_ERR_VERSION;
+        }
+        close(fd);
+        if (map != MAP_FAILED) {
+            nh_shm *shm = (nh_shm *)map;
+            if (__atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) != NH_MAGIC ||
+                shm->version != NH_VERSION || shm->slot_size != sizeof(nh_slot)) {
+                st = NEXTHASH_DAEMON_ERR_VERSION;
+                munmap(map, shm_size());
+            } else if ((c = (nexthash_client *)malloc(sizeof(nexthash_client))) != NULL) {
+                c->shm = shm;
+                st = NEXTHASH_DAEMON_OK;
+            } else {
+                munmap(map, shm_size());
+            }
+        }
+    }
+    if (status) *status = st;
+    return c;
+}
+
+void nexthash_client_close(nexthash_client *c) {
+    if (!c) return;
+    munmap(c->shm, shm_size());
+    free(c);
+}
+
+typedef struct {
+    nh_slot *slot;
+    uint64_t pos;
+    size_t first;       /* index of the slot's first message */
+} inflight;
+
+static int collect(nexthash_client *c, const inflight *f, uint8_t (*digests)[32]) {
+    int st = slot_wait(c->shm, f->slot);
+    if (st == NEXTHASH_DAEMON_OK) {
+        memcpy(digests[f->first], f->slot->digests, (size_t)f->slot->n_msgs * 32);
+    }
+    if (f->slot->done) ring_release(c->shm, f->slot, f->pos);
+    return st;
+}
+
+int nexthash_client_hash(nexthash_client *c, const uint8_t *const *data,
+                         const size_t *lens, size_t n, uint8_t (*digests)[32]) {
+    for (size_t i = 0; i < n; i++) {
+        if (lens[i] > NEXTHASH_DAEMON_PAYLOAD) return NEXTHASH_DAEMON_ERR_TOO_BIG;
+    }
+
+    inflight q[NH_INFLIGHT];
+    size_t q_head = 0, q_len = 0, i = 0;
+    int status = NEXTHASH_DAEMON_OK;
+
+    while (i < n || q_len > 0) {
+        if (i < n && q_len < NH_INFLIGHT && status == NEXTHASH_DAEMON_OK) {
+            uint64_t pos;
+            nh_slot *s = ring_reserve(c->shm, &pos);
+            if (!s) {
+                status = NEXTHASH_DAEMON_ERR_STOPPED;
+                continue;
+            }
+            size_t off = 0;
+            uint32_t k = 0;
+            inflight *f = &q[(q_head + q_len) % NH_INFLIGHT];
+            f->slot = s;
+            f->pos = pos;
+            f->first = i;
+            while (i < n && k < NEXTHASH_DAEMON_MAX_MSGS &&
+                   off + lens[i] <= NEXTHASH_DAEMON_PAYLOAD) {
+                memcpy(s->payload + off, data[i], lens[i]);
+                s->lens[k++] = (uint32_t)lens[i];
+                off += lens[i];
+                i++;
+            }
+            s->type = JOB_HASH;
+            s->n_msgs = k;
+            if (!ring_publish(c->shm, s, pos)) {
+                status = NEXTHASH_DAEMON_ERR_LOST;
+                continue;
+            }
+            q_len++;
+        } else if (q_len > 0) {
+            int st = collect(c, &q[q_head], digests);
+            if (st != NEXTHASH_DAEMON_OK && status == NEXTHASH_DAEMON_OK) status = st;
+            q_head = (q_head + 1) % NH_INFLIGHT;
+            q_len--;
+        } else {
+            break;
+        }
+    }
+    return status;
+}
+
+int nexthash_client_sweep(nexthash_client *c, const uint8_t *prefix, size_t prefix_len,
+                          uint64_t start, uint64_t count, unsigned difficulty,
+                          uint64_t *nonce, uint8_t digest[32]) {
+    if (prefix_len > NEXTHASH_DAEMON_MAX_PREFIX) return NEXTHASH_DAEMON_ERR_TOO_BIG;
+    if (count > UINT64_MAX - start) count = UINT64_MAX - start;
+
+    uint64_t pos;
+    nh_slot *s = ring_reserve(c->shm, &pos);
+    if (!s) return NEXTHASH_DAEMON_ERR_STOPPED;
+    memcpy(s->payload, prefix, prefix_len);
+    s->type = JOB_SWEEP;
+    s->prefix_len = (uint32_t)prefix_len;
+    s->start = start;
+    s->count = count;
+    s->difficulty = difficulty;
+    s->found = 0;
+    if (!ring_publish(c->shm, s, pos)) return NEXTHASH_DAEMON_ERR_LOST;
+
+    int st = slot_wait(c->shm, s);
+    if (st == NEXTHASH_DAEMON_OK) {
+        st = (int)s->found;
+        if (s->found) {
+            if (nonce) *nonce = s->nonce;
+            if (digest) memcpy(digest, s->digest, 32);
+        }
+    }
+    if (s->done) ring_release(c->shm, s, pos);
+    return st;
+}
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <sys/wait.h>
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* mine_nexthash() one hash at a time */
+static int scalar_sweep(const char *prefix, uint64_t count, unsigned difficulty,
+                        uint64_t *nonce, uint8_t digest[32]) {
+    uint8_t msg[NEXTHASH_DAEMON_MAX_PREFIX + NH_DIGITS];
+    size_t plen = strlen(prefix);
+    memcpy(msg, prefix, plen);
+    for (uint64_t i = 0; i < count; i++) {
+        size_t len = plen + format_u64(i, msg + plen);
+        nexthash256(msg, len, digest);
+        if (leading_zero_hex(digest, difficulty)) {
+            *nonce = i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Exhaustive sweep from its own client, for the latency test */
+static void *long_sweep(void *arg) {
+    nexthash_client *c = nexthash_client_open((const char *)arg, NULL);
+    uint64_t nonce;
+    if (c) nexthash_client_sweep(c, (const uint8_t *)"long:", 5, 0, 1000000, 64, &nonce, NULL);
+    nexthash_client_close(c);
+    return NULL;
+}
+
+/*
+ * A client that dies holding slots: 0 reserves one and never publishes,
+ * 1 fills the whole ring with answered jobs it never releases, 2 takes a
+ * ring position and dies before recording itself as owner
+ */
+static int dying_client(const char *name, int how) {
+    nexthash_client *c = nexthash_client_open(name, NULL);
+    if (!c) return 10;
+    uint64_t pos;
+    if (how == 0) {
+        ring_reserve(c->shm, &pos);
+    } else if (how == 1) {
+        for (int i = 0; i < NEXTHASH_DAEMON_SLOTS; i++) {
+            nh_slot *s = ring_reserve(c->shm, &pos);
+            s->type = JOB_HASH;
+            s->n_msgs = 0;
+            ring_publish(c->shm, s, pos);
+            slot_wait(c->shm, s);
+        }
+    } else {
+        __atomic_fetch_add(&c->shm->head, 1, __ATOMIC_RELAXED);
+    }
+    return 0;       /* exits without closing */
+}
+
+/* Hash `rounds` single messages; 1 if all match */
+static int hash_rounds(nexthash_client *c, int rounds) {
+    int ok = 1;
+    for (int i = 0; i < rounds; i++) {
+        uint8_t msg[8], out[1][32], ref[32];
+        const uint8_t *p = msg;
+        size_t len = sizeof(msg);
+        memcpy(msg, &i, sizeof(i));
+        memcpy(msg + 4, "dead", 4);
+        ok &= nexthash_client_hash(c, &p, &len, 1, out) == NEXTHASH_DAEMON_OK;
+        nexthash256(msg, len, ref);
+        ok &= memcmp(ref, out[0], 32) == 0;
+    }
+    return ok;
+}
+
+/* One client process: sweeps and batches checked against local hashing */
+static int child_main(const char *name, int id) {
+    int st;
+    nexthash_client *c = nexthash_client_open(name, &st);
+    if (!c) return 10;
+    int bad = 0;
+
+    for (int round = 0; round < 3; round++) {
+        char prefix[64];
+        snprintf(prefix, sizeof(prefix), "player%d-block%d:", id, round);
+        uint64_t n1 = 0, n2 = 0;
+        uint8_t d1[32], d2[32];
+        int f1 = nexthash_client_sweep(c, (const uint8_t *)prefix, strlen(prefix),
+                                       0, 200000, 3, &n1, d1);
+        int f2 = scalar_sweep(prefix, 200000, 3, &n2, d2);
+        bad |= f1 != f2 || (f1 == 1 && (n1 != n2 || memcmp(d1, d2, 32)));
+    }
+
+    enum { N = 700 };
+    static uint8_t buf[N][600];
+    static uint8_t dig[N][32];
+    const uint8_t *ptrs[N];
+    size_t lens[N];
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < 600; j++) buf[i][j] = (uint8_t)(i * 31 + j * 7 + id);
+        ptrs[i] = buf[i];
+        lens[i] = (size_t)(i * 53 + id) % 600;
+    }
+    bad |= nexthash_client_hash(c, ptrs, lens, N, dig) != NEXTHASH_DAEMON_OK;
+    for (int i = 0; i < N; i++) {
+        uint8_t ref[32];
+        nexthash256(ptrs[i], lens[i], ref);
+        bad |= memcmp(ref, dig[i], 32) != 0;
+    }
+    nexthash_client_close(c);
+    return bad;
+}
+
+int main(void) {
+    int fail = 0;
+    char name[64];
+    snprintf(name, sizeof(name), "/nexthash_daemon_test_%d", (int)getpid());
+
+    printf("NEXTHASH-256 Local Hashing Daemon\n");
+    printf("=================================\n\n");
+
+    nexthash_daemon *d = nexthash_daemon_start(name, 0, 1);
+    if (!d) {
+        printf("daemon start: FAIL\n");
+        return 1;
+    }
+
+    /* Several client processes at once */
+    {
+        enum { CHILDREN = 4 };
+        pid_t pids[CHILDREN];
+        for (int i = 0; i < CHILDREN; i++) {
+            pids[i] = fork();
+            if (pids[i] == 0) _exit(child_main(name, i));
+        }
+        int ok = 1;
+        for (int i = 0; i < CHILDREN; i++) {
+            int ws;
+            waitpid(pids[i], &ws, 0);
+            ok &= WIFEXITED(ws) && WEXITSTATUS(ws) == 0;
+        }
+        printf("%d client processes:       %s\n", CHILDREN, ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    nexthash_client *c = nexthash_client_open(name, NULL);
+
+    /* Edge cases */
+    {
+        uint8_t big[NEXTHASH_DAEMON_PAYLOAD + 1] = {0};
+        const uint8_t *p = big;
+        size_t len = sizeof(big);
+        uint8_t out[1][32];
+        uint64_t nonce = 0;
+        int ok = c != NULL;
+        ok &= nexthash_client_hash(c, &p, &len, 1, out) == NEXTHASH_DAEMON_ERR_TOO_BIG;
+        ok &= nexthash_client_sweep(c, big, 0, 0, 0, 1, &nonce, NULL) == 0;
+        ok &= nexthash_client_sweep(c, (const uint8_t *)"x:", 2, 5, 1000, 0, &nonce, NULL) == 1
+              && nonce == 5;
+        ok &= nexthash_client_hash(c, NULL, NULL, 0, NULL) == NEXTHASH_DAEMON_OK;
+        printf("edge cases:                %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Malformed slots written straight into the ring are failed, not run */
+    {
+        int ok = c != NULL;
+        for (int bad = 0; bad < 4 && ok; bad++) {
+            uint64_t pos;
+            nh_slot *s = ring_reserve(c->shm, &pos);
+            s->type = bad < 2 ? JOB_HASH : JOB_SWEEP;
+            s->n_msgs = bad == 0 ? NEXTHASH_DAEMON_MAX_MSGS + 1 : 2;
+            s->lens[0] = NEXTHASH_DAEMON_PAYLOAD;
+            s->lens[1] = UINT32_MAX;
+            s->prefix_len = bad == 2 ? UINT32_MAX : 0;
+            s->start = bad == 3 ? UINT64_MAX - 10 : 0;
+            s->count = bad == 3 ? 100 : 1;
+            s->difficulty = 1;
+            ok &= ring_publish(c->shm, s, pos);
+            ok &= slot_wait(c->shm, s) == NEXTHASH_DAEMON_ERR_TOO_BIG;
+            ring_release(c->shm, s, pos);
+        }
+        printf("malformed slots:           %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* A small job submitted during a long sweep is answered between chunks */
+    {
+        pthread_t th;
+        uint8_t out[1][32], ref[32];
+        const uint8_t *p = (const uint8_t *)"hi";
+        size_t len = 2;
+        int ok = pthread_create(&th, NULL, long_sweep, name) == 0;
+        usleep(100000);
+        double t0 = now_sec();
+        ok &= nexthash_client_hash(c, &p, &len, 1, out) == NEXTHASH_DAEMON_OK;
+        double dt = now_sec() - t0;
+        nexthash256(p, len, ref);
+        ok &= memcmp(ref, out[0], 32) == 0 && dt < 0.1;
+        if (ok) pthread_join(th, NULL);
+        printf("hash during long sweep:    %.2f ms  %s\n", dt * 1e3, ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Slots held by dead clients are reclaimed */
+    {
+        static const char *what[3] = { "unpublished", "unreleased", "unrecorded" };
+        for (int how = 0; how < 3; how++) {
+            pid_t pid = fork();
+            if (pid == 0) _exit(dying_client(name, how));
+            int ws;
+            waitpid(pid, &ws, 0);
+            double t0 = now_sec();
+            int ok = WIFEXITED(ws) && WEXITSTATUS(ws) == 0;
+            ok &= hash_rounds(c, 2 * NEXTHASH_DAEMON_SLOTS);
+            double dt = now_sec() - t0;
+            ok &= dt < 2.0;
+            printf("dead client, %-14s %.0f ms  %s\n", what[how], dt * 1e3,
+                   ok ? "OK" : "FAIL");
+            fail |= !ok;
+        }
+    }
+
+    /* Throughput: exhaustive sweep vs one-at-a-time hashing */
+    {
+        const uint64_t count = 300000;
+        uint64_t nonce;
+        uint8_t dg[32];
+        double t0 = now_sec();
+        int f1 = nexthash_client_sweep(c, (const uint8_t *)"bench:", 6, 0, count, 64, &nonce, dg);
+        double t1 = now_sec();
+        int f2 = scalar_sweep("bench:", count, 64, &nonce, dg);
+        double t2 = now_sec();
+        printf("sweep throughput:          daemon %.2f MH/s, scalar %.2f MH/s  %s\n",
+               count / (t1 - t0) / 1e6, count / (t2 - t1) / 1e6,
+               f1 == 0 && f2 == 0 ? "OK" : "FAIL");
+        fail |= !(f1 == 0 && f2 == 0);
+    }
+
+    nexthash_daemon_stop(d);
+    {
+        uint64_t nonce;
+        int ok = nexthash_client_sweep(c, (const uint8_t *)"x", 1, 0, 10, 0, &nonce, NULL)
+                 == NEXTHASH_DAEMON_ERR_STOPPED;
+        printf("stopped daemon:            %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+    nexthash_client_close(c);
+
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
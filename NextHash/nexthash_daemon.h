@@ -0,0 +1,83 @@
+/*
+ * NEXTHASH-256 Local Hashing Daemon
+ * =================================
+ *
+ * One host-wide worker pool shared by every process that mines or hashes
+ * (Discord bot, web UIs, MUD). Clients place jobs in a shared-memory ring
+ * and sleep on a futex until the daemon marks them done.
+ *
+ * Features:
+ * - Lock-free multi-producer ring in a POSIX shared-memory segment
+ * - Futex wakeups in both directions (no polling, no sockets)
+ * - Batch hash jobs run through nexthash256_batch()
+ * - Nonce sweeps matching mine_nexthash() in game/discord_bot/cogs/mining.py:
+ *   message = prefix || decimal(nonce), success when the hex digest starts
+ *   with `difficulty` zeros; the lowest matching nonce is returned
+ * - A sweep is split across all workers; workers can be pinned to cores
+ * - Slots held by clients that died are reclaimed (owner pid per slot)
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef NEXTHASH_DAEMON_H
+#define NEXTHASH_DAEMON_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NEXTHASH_DAEMON_SLOTS      64       /* ring entries (power of two) */
+#define NEXTHASH_DAEMON_PAYLOAD    16384    /* message bytes per slot */
+#define NEXTHASH_DAEMON_MAX_MSGS   128      /* messages per batch slot */
+#define NEXTHASH_DAEMON_MAX_PREFIX 256      /* sweep prefix bytes */
+#define NEXTHASH_DAEMON_CHUNK      1024     /* nonces claimed per worker pass */
+
+/* Status codes */
+#define NEXTHASH_DAEMON_OK             0
+#define NEXTHASH_DAEMON_ERR_SYS       -1   /* shm / mmap / thread failure */
+#define NEXTHASH_DAEMON_ERR_VERSION   -2   /* segment from another build */
+#define NEXTHASH_DAEMON_ERR_TOO_BIG   -3   /* message or prefix exceeds a slot */
+#define NEXTHASH_DAEMON_ERR_STOPPED   -4   /* daemon shut down */
+#define NEXTHASH_DAEMON_ERR_LOST      -5   /* slot reclaimed while the client stalled */
+
+typedef struct nexthash_daemon nexthash_daemon;
+typedef struct nexthash_client nexthash_client;
+
+/*
+ * Create the segment /name and start the workers (threads == 0 uses all
+ * online CPUs; pin != 0 binds worker i to CPU i). Returns NULL on failure.
+ */
+nexthash_daemon *nexthash_daemon_start(const char *name, unsigned threads, int pin);
+
+/* Fail pending and future jobs, join the workers and unlink the segment */
+void nexthash_daemon_stop(nexthash_daemon *d);
+
+/* Map an existing daemon segment; NULL and *status set on failure */
+nexthash_client *nexthash_client_open(const char *name, int *status);
+void nexthash_client_close(nexthash_client *c);
+
+/*
+ * digests[i] = NEXTHASH-256(data[i], lens[i]). Large batches are spread
+ * over several slots and waited on together. Returns a status code.
+ */
+int nexthash_client_hash(nexthash_client *c, const uint8_t *const *data,
+                         const size_t *lens, size_t n, uint8_t (*digests)[32]);
+
+/*
+ * Search nonces [start, start + count) for the first whose hash has
+ * `difficulty` leading zero hex digits. Returns 1 with *nonce / digest
+ * set when found, 0 when not, or a negative status code.
+ */
+int nexthash_client_sweep(nexthash_client *c, const uint8_t *prefix, size_t prefix_len,
+                          uint64_t start, uint64_t count, unsigned difficulty,
+                          uint64_t *nonce, uint8_t digest[32]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NEXTHASH_DAEMON_H */
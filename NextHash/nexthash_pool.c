@@ -0,0 +1,498 @@
+/*
+ * NEXTHASH-256 Hashing Pool
+ * =========================
+ *
+ * Compile: gcc -O3 -c nexthash256.c bloom_sha256.c
+ *          gcc -O3 -pthread -o nexthash_pool nexthash_pool.c nexthash256.o bloom_sha256.o -DTEST_MAIN
+ *
+ * Shared library for network/native_hash.py:
+ *          gcc -O3 -march=native -shared -fPIC -pthread -o libnexthash_pool.so \
+ *              nexthash_pool.c nexthash256.c bloom_sha256.c
+ */
+
+#include "nexthash_pool.h"
+#include "nexthash256.h"
+#include "bloom_sha256.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+/* ========================================================================== */
+/* Jobs                                                                        */
+/* ========================================================================== */
+
+typedef struct pool_job pool_job;
+
+/* One unit of worker time: a message, or a slice of a batch */
+typedef struct pool_work {
+    pool_job *job;
+    const uint8_t *const *data;
+    const size_t *lens;
+    size_t n;
+    uint8_t (*digests)[32];
+    struct pool_work *next;
+} pool_work;
+
+/* A submission; completes when its last work item finishes */
+struct pool_job {
+    uint64_t tag;
+    unsigned hash;                  /* NEXTHASH_POOL_* */
+    size_t remaining;
+    pool_job *next_done;
+    /* Single-message jobs point their work item here */
+    const uint8_t *msg;
+    size_t msg_len;
+    pool_work work[];
+};
+
+typedef struct {
+    pool_work *head, *tail;
+} work_queue;
+
+struct nexthash_pool {
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    pthread_t *threads;
+    unsigned n_threads;
+    int stop;
+
+    work_queue small;       /* served first */
+    work_queue large;
+    pool_job *done_head, *done_tail;
+    size_t pending;
+
+    int rfd, wfd;           /* eventfd: rfd == wfd */
+};
+
+static void queue_push(work_queue *q, pool_work *w) {
+    w->next = NULL;
+    if (q->tail) q->tail->next = w;
+    else q->head = w;
+    q->tail = w;
+}
+
+static pool_work *queue_pop(work_queue *q) {
+    pool_work *w = q->head;
+    if (w) {
+        q->head = w->next;
+        if (!q->head) q->tail = NULL;
+    }
+    return w;
+}
+
+/* ========================================================================== */
+/* Wakeup Descriptor                                                           */
+/* ========================================================================== */
+
+static int notify_open(nexthash_pool *p) {
+#ifdef __linux__
+    p->rfd = p->wfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    return p->rfd >= 0 ? 0 : -1;
+#else
+    int fds[2];
+    if (pipe(fds) != 0) return -1;
+    for (int i = 0; i < 2; i++) {
+        fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+        fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+    }
+    p->rfd = fds[0];
+    p->wfd = fds[1];
+    return 0;
+#endif
+}
+
+static void notify_close(nexthash_pool *p) {
+    if (p->rfd >= 0) close(p->rfd);
+    if (p->wfd >= 0 && p->wfd != p->rfd) close(p->wfd);
+}
+
+static void notify_signal(nexthash_pool *p) {
+#ifdef __linux__
+    uint64_t one = 1;
+    ssize_t r = write(p->wfd, &one, sizeof(one));
+#else
+    uint8_t one = 1;
+    ssize_t r = write(p->wfd, &one, 1);     /* a full pipe is still readable */
+#endif
+    (void)r;
+}
+
+static void notify_clear(nexthash_pool *p) {
+#ifdef __linux__
+    uint64_t count;
+    ssize_t r = read(p->rfd, &count, sizeof(count));
+    (void)r;
+#else
+    uint8_t buf[256];
+    while (read(p->rfd, buf, sizeof(buf)) > 0) {
+    }
+#endif
+}
+
+/* ========================================================================== */
+/* Workers                                                                     */
+/* ========================================================================== */
+
+static void *worker_main(void *arg) {
+    nexthash_pool *p = (nexthash_pool *)arg;
+
+    for (;;) {
+        pthread_mutex_lock(&p->lock);
+        pool_work *w;
+        while (!(w = queue_pop(&p->small)) && !(w = queue_pop(&p->large))) {
+            if (p->stop) {
+                pthread_mutex_unlock(&p->lock);
+                return NULL;
+            }
+            pthread_cond_wait(&p->ready, &p->lock);
+        }
+        pthread_mutex_unlock(&p->lock);
+
+        pool_job *job = w->job;
+        if (job->hash == NEXTHASH_POOL_SHA256D) {
+            for (size_t i = 0; i < w->n; i++) bloom_sha256d(w->data[i], w->lens[i], w->digests[i]);
+        } else if (w->n == 1) {
+            nexthash256(w->data[0], w->lens[0], w->digests[0]);
+        } else if (w->n > 1) {
+            nexthash256_batch(w->data, w->lens, w->n, w->digests);
+        }
+
+        if (__atomic_sub_fetch(&job->remaining, 1, __ATOMIC_ACQ_REL) == 0) {
+            pthread_mutex_lock(&p->lock);
+            job->next_done = NULL;
+            if (p->done_tail) p->done_tail->next_done = job;
+            else p->done_head = job;
+            p->done_tail = job;
+            pthread_mutex_unlock(&p->lock);
+            notify_signal(p);
+        }
+    }
+}
+
+/* ========================================================================== */
+/* Public API                                                                  */
+/* ========================================================================== */
+
+nexthash_pool *nexthash_pool_create(unsigned threads) {
+    nexthash_pool *p = (nexthash_pool *)calloc(1, sizeof(nexthash_pool));
+    if (!p) return NULL;
+    p->rfd = p->wfd = -1;
+
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (unsigned)cpus : 1;
+    }
+    p->threads = (pthread_t *)calloc(threads, sizeof(pthread_t));
+    if (!p->threads || notify_open(p) != 0) {
+        notify_close(p);
+        free(p->threads);
+        free(p);
+        return NULL;
+    }
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->ready, NULL);
+
+    for (unsigned i = 0; i < threads; i++) {
+        if (pthread_create(&p->threads[i], NULL, worker_main, p) != 0) {
+            break;
+        }
+        p->n_threads++;
+    }
+    if (p->n_threads == 0) {
+        nexthash_pool_destroy(p);
+        return NULL;
+    }
+    return p;
+}
+
+void nexthash_pool_destroy(nexthash_pool *p) {
+    if (!p) return;
+    pthread_mutex_lock(&p->lock);
+    p->stop = 1;
+    pthread_cond_broadcast(&p->ready);
+    pthread_mutex_unlock(&p->lock);
+    for (unsigned i = 0; i < p->n_threads; i++) {
+        pthread_join(p->threads[i], NULL);
+    }
+    while (p->done_head) {
+        pool_job *j = p->done_head;
+        p->done_head = j->next_done;
+        free(j);
+    }
+    pthread_cond_destroy(&p->ready);
+    pthread_mutex_destroy(&p->lock);
+    notify_close(p);
+    free(p->threads);
+    free(p);
+}
+
+int nexthash_pool_fd(const nexthash_pool *p) {
+    return p->rfd;
+}
+
+/* Queue a job's work items; wakes one worker per item */
+static void enqueue(nexthash_pool *p, pool_job *job, size_t items, size_t bytes) {
+    work_queue *q = bytes <= NEXTHASH_POOL_SMALL_JOB ? &p->small : &p->large;
+    pthread_mutex_lock(&p->lock);
+    for (size_t i = 0; i < items; i++) {
+        queue_push(q, &job->work[i]);
+    }
+    p->pending++;
+    if (items == 1) pthread_cond_signal(&p->ready);
+    else pthread_cond_broadcast(&p->ready);
+    pthread_mutex_unlock(&p->lock);
+}
+
+int nexthash_pool_submit(nexthash_pool *p, unsigned hash, const uint8_t *data,
+                         size_t len, uint8_t digest[32], uint64_t tag) {
+    if (hash > NEXTHASH_POOL_SHA256D) return -1;
+    pool_job *job = (pool_job *)malloc(sizeof(pool_job) + sizeof(pool_work));
+    if (!job) return -1;
+    job->tag = tag;
+    job->hash = hash;
+    job->remaining = 1;
+    job->msg = data;
+    job->msg_len = len;
+    job->work[0].job = job;
+    job->work[0].data = &job->msg;
+    job->work[0].lens = &job->msg_len;
+    job->work[0].n = 1;
+    job->work[0].digests = (uint8_t (*)[32])digest;
+    enqueue(p, job, 1, len);
+    return 0;
+}
+
+int nexthash_pool_submit_batch(nexthash_pool *p, unsigned hash,
+                               const uint8_t *const *data, const size_t *lens, size_t n,
+                               uint8_t (*digests)[32], uint64_t tag) {
+    if (hash > NEXTHASH_POOL_SHA256D) return -1;
+    size_t items = n ? (n + NEXTHASH_POOL_CHUNK - 1) / NEXTHASH_POOL_CHUNK : 1;
+    pool_job *job = (pool_job *)malloc(sizeof(pool_job) + items * sizeof(pool_work));
+    if (!job) return -1;
+    job->tag = tag;
+    job->hash = hash;
+    job->remaining = items;
+    job->msg = NULL;
+    job->msg_len = 0;
+
+    size_t bytes = 0;
+    for (size_t i = 0; i < n; i++) bytes += lens[i];
+    for (size_t c = 0; c < items; c++) {
+        size_t off = c * NEXTHASH_POOL_CHUNK;
+        size_t cnt = n - off < NEXTHASH_POOL_CHUNK ? n - off : NEXTHASH_POOL_CHUNK;
+        pool_work *w = &job->work[c];
+        w->job = job;
+        w->data = data + off;
+        w->lens = lens + off;
+        w->n = n ? cnt : 0;
+        w->digests = digests + off;
+    }
+    enqueue(p, job, items, bytes);
+    return 0;
+}
+
+size_t nexthash_pool_poll(nexthash_pool *p, uint64_t *tags, size_t max) {
+    size_t k = 0;
+    notify_clear(p);
+    pthread_mutex_lock(&p->lock);
+    while (k < max && p->done_head) {
+        pool_job *j = p->done_head;
+        p->done_head = j->next_done;
+        if (!p->done_head) p->done_tail = NULL;
+        tags[k++] = j->tag;
+        free(j);
+    }
+    p->pending -= k;
+    int more = p->done_head != NULL;
+    pthread_mutex_unlock(&p->lock);
+    /* Keep the fd readable for completions left behind */
+    if (more) notify_signal(p);
+    return k;
+}
+
+size_t nexthash_pool_pending(nexthash_pool *p) {
+    pthread_mutex_lock(&p->lock);
+    size_t n = p->pending;
+    pthread_mutex_unlock(&p->lock);
+    return n;
+}
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <stdio.h>
+#include <poll.h>
+#include <time.h>
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Event-loop style wait: block in poll(2) on the fd, then drain */
+static size_t wait_some(nexthash_pool *p, uint64_t *tags, size_t max) {
+    struct pollfd pfd = { nexthash_pool_fd(p), POLLIN, 0 };
+    size_t k;
+    while ((k = nexthash_pool_poll(p, tags, max)) == 0) {
+        poll(&pfd, 1, 1000);
+    }
+    return k;
+}
+
+int main(void) {
+    int fail = 0;
+    printf("NEXTHASH-256 Hashing Pool\n");
+    printf("=========================\n\n");
+
+    nexthash_pool *p = nexthash_pool_create(2);
+    if (!p) {
+        printf("create: FAIL\n");
+        return 1;
+    }
+
+    /* Mixed single and batch jobs agree with nexthash256() */
+    {
+        enum { SINGLES = 500, BATCH = 300 };
+        static uint8_t buf[SINGLES][300];
+        static uint8_t dig[SINGLES][32], bdig[BATCH][32], ref[32];
+        const uint8_t *ptrs[BATCH];
+        size_t lens[BATCH];
+        for (int i = 0; i < SINGLES; i++) {
+            for (int j = 0; j < 300; j++) buf[i][j] = (uint8_t)(i * 7 + j * 13);
+        }
+        for (int i = 0; i < BATCH; i++) {
+            ptrs[i] = buf[i % SINGLES];
+            lens[i] = (size_t)(i * 37) % 300;
+        }
+
+        for (int i = 0; i < SINGLES; i++) {
+            nexthash_pool_submit(p, NEXTHASH_POOL_NEXTHASH, buf[i], (size_t)i % 300, dig[i],
+                                 (uint64_t)i);
+        }
+        nexthash_pool_submit_batch(p, NEXTHASH_POOL_NEXTHASH, ptrs, lens, BATCH, bdig, 1000000);
+
+        static int seen[SINGLES];
+        int batch_seen = 0;
+        size_t got = 0;
+        uint64_t tags[64];
+        while (got < SINGLES + 1) {
+            size_t k = wait_some(p, tags, 64);
+            for (size_t t = 0; t < k; t++) {
+                if (tags[t] == 1000000) batch_seen++;
+                else seen[tags[t]]++;
+            }
+            got += k;
+        }
+
+        int ok = batch_seen == 1 && nexthash_pool_pending(p) == 0;
+        for (int i = 0; i < SINGLES; i++) {
+            nexthash256(buf[i], (size_t)i % 300, ref);
+            ok &= seen[i] == 1 && memcmp(ref, dig[i], 32) == 0;
+        }
+        for (int i = 0; i < BATCH; i++) {
+            nexthash256(ptrs[i], lens[i], ref);
+            ok &= memcmp(ref, bdig[i], 32) == 0;
+        }
+        printf("singles + batch digests:  %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Double SHA-256 jobs match bloom_sha256d(); unknown hashes are refused */
+    {
+        enum { BATCH = 150 };
+        static uint8_t msgs[BATCH][200], bdig[BATCH][32], one[32], ref[32];
+        const uint8_t *ptrs[BATCH];
+        size_t lens[BATCH];
+        uint64_t tags[2];
+        for (int i = 0; i < BATCH; i++) {
+            memset(msgs[i], i, sizeof(msgs[i]));
+            ptrs[i] = msgs[i];
+            lens[i] = (size_t)i;
+        }
+        int ok = nexthash_pool_submit(p, 7, msgs[0], 1, one, 0) == -1;
+        nexthash_pool_submit_batch(p, NEXTHASH_POOL_SHA256D, ptrs, lens, BATCH, bdig, 1);
+        nexthash_pool_submit(p, NEXTHASH_POOL_SHA256D, (const uint8_t *)"abc", 3, one, 2);
+        size_t got = 0;
+        while (got < 2) got += wait_some(p, tags + got, 2 - got);
+        for (int i = 0; i < BATCH; i++) {
+            bloom_sha256d(ptrs[i], lens[i], ref);
+            ok &= memcmp(ref, bdig[i], 32) == 0;
+        }
+        bloom_sha256d((const uint8_t *)"abc", 3, ref);
+        ok &= memcmp(ref, one, 32) == 0 && ref[0] == 0x4f;
+        printf("sha256d singles + batch:  %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Empty batch still completes */
+    {
+        uint64_t tag;
+        nexthash_pool_submit_batch(p, NEXTHASH_POOL_NEXTHASH, NULL, NULL, 0, NULL, 42);
+        size_t k = wait_some(p, &tag, 1);
+        int ok = k == 1 && tag == 42;
+        printf("empty batch:              %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Small-job latency while large blocks are queued */
+    {
+        enum { BLOCKS = 16, TXS = 200 };
+        const size_t block_len = 1 << 20;
+        uint8_t *blocks = malloc(BLOCKS * block_len);
+        static uint8_t bd[BLOCKS][32], td[TXS][32], tx[TXS][250];
+        double submitted[TXS], lat[TXS];
+        memset(blocks, 0xAB, BLOCKS * block_len);
+        memset(tx, 0x11, sizeof(tx));
+
+        for (int b = 0; b < BLOCKS; b++) {
+            nexthash_pool_submit(p, NEXTHASH_POOL_NEXTHASH, blocks + b * block_len, block_len,
+                                 bd[b], 10000 + b);
+        }
+        for (int t = 0; t < TXS; t++) {
+            submitted[t] = now_sec();
+            nexthash_pool_submit(p, NEXTHASH_POOL_SHA256D, tx[t], sizeof(tx[t]), td[t],
+                                 (uint64_t)t);
+        }
+        size_t got = 0;
+        uint64_t tags[64];
+        double t_blocks = 0.0;
+        while (got < BLOCKS + TXS) {
+            size_t k = wait_some(p, tags, 64);
+            double now = now_sec();
+            for (size_t i = 0; i < k; i++) {
+                if (tags[i] < TXS) {
+                    lat[tags[i]] = now - submitted[tags[i]];
+                } else {
+                    t_blocks = now - submitted[0];
+                }
+            }
+            got += k;
+        }
+        qsort(lat, TXS, sizeof(double), cmp_double);
+        printf("tx latency under flood:   p50 %.2f ms, p99 %.2f ms "
+               "(%d MiB of blocks: %.1f ms)  %s\n",
+               1e3 * lat[TXS / 2], 1e3 * lat[TXS * 99 / 100], BLOCKS, 1e3 * t_blocks,
+               lat[TXS * 99 / 100] < 0.5 * t_blocks ? "OK" : "FAIL");
+        fail |= !(lat[TXS * 99 / 100] < 0.5 * t_blocks);
+        free(blocks);
+    }
+
+    nexthash_pool_destroy(p);
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
@@ -0,0 +1,85 @@
+/*
+ * NEXTHASH-256 Hashing Pool
+ * =========================
+ *
+ * Background hashing for event-loop callers (network/node.py). Jobs are
+ * queued to the pool's worker threads; completions are signalled on a
+ * single file descriptor so the loop thread never blocks on a hash.
+ *
+ * Features:
+ * - One-message and batch jobs, split across workers in slices
+ * - NEXTHASH-256 (batches through nexthash256_batch()) or double SHA-256,
+ *   the node's transaction hash (Transaction.hash in transaction.py)
+ * - Small jobs are served ahead of large ones, so transaction hashing
+ *   is not queued behind a block flood
+ * - Completion wakeup through eventfd (pipe on non-Linux systems)
+ *
+ * Event-loop pattern (asyncio), as network/native_hash.py does it:
+ *   fd = nexthash_pool_fd(pool)
+ *   loop.add_reader(fd, drain)      # drain(): nexthash_pool_poll() and
+ *                                   # set_result() on each tag's Future
+ *   tag = next_tag(); futures[tag] = loop.create_future()
+ *   nexthash_pool_submit(pool, NEXTHASH_POOL_SHA256D, buf, len, out, tag)
+ * Buffers must stay alive until their tag is returned by poll.
+ *
+ * Author: NEXTHASH Research Project
+ * License: Public Domain / CC0
+ */
+
+#ifndef NEXTHASH_POOL_H
+#define NEXTHASH_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Jobs up to this many bytes use the priority queue */
+#define NEXTHASH_POOL_SMALL_JOB   4096
+
+/* Messages per work item when a batch is split */
+#define NEXTHASH_POOL_CHUNK       64
+
+/* Hash functions */
+#define NEXTHASH_POOL_NEXTHASH    0     /* NEXTHASH-256 */
+#define NEXTHASH_POOL_SHA256D     1     /* SHA-256(SHA-256(data)) */
+
+typedef struct nexthash_pool nexthash_pool;
+
+/* threads == 0 uses the number of online CPUs */
+nexthash_pool *nexthash_pool_create(unsigned threads);
+
+/* Finishes queued jobs, then joins the workers */
+void nexthash_pool_destroy(nexthash_pool *pool);
+
+/* Readable when completions are waiting */
+int nexthash_pool_fd(const nexthash_pool *pool);
+
+/*
+ * digest = hash(data, len) with hash one of NEXTHASH_POOL_*; returns 0,
+ * or -1 on allocation failure or an unknown hash
+ */
+int nexthash_pool_submit(nexthash_pool *pool, unsigned hash, const uint8_t *data,
+                         size_t len, uint8_t digest[32], uint64_t tag);
+
+/* digests[i] = hash(data[i], lens[i]); one completion for the batch */
+int nexthash_pool_submit_batch(nexthash_pool *pool, unsigned hash,
+                               const uint8_t *const *data, const size_t *lens, size_t n,
+                               uint8_t (*digests)[32], uint64_t tag);
+
+/*
+ * Non-blocking: clears the fd and writes up to max finished tags.
+ * Returns the number written; call again if it equals max.
+ */
+size_t nexthash_pool_poll(nexthash_pool *pool, uint64_t *tags, size_t max);
+
+/* Submitted jobs not yet returned by poll */
+size_t nexthash_pool_pending(nexthash_pool *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NEXTHASH_POOL_H */
@@ -0,0 +1,696 @@
+/*
+ * NEXTHASH Counter-Based Random Streams
+ * =====================================
+ *
+ * Compile: gcc -O3 -c nexthash256.c
+ *          gcc -O3 -mavx2 -o nexthash_rng nexthash_rng.c nexthash256.o -lm -DTEST_MAIN
+ */
+
+#include "nexthash_rng.h"
+#include "nexthash256.h"
+#include <string.h>
+#include <math.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#define TILE_WORDS 1024             /* conversion buffer, multiple of 16 */
+
+/* ========================================================================== */
+/* Constants                                                                   */
+/* ========================================================================== */
+
+/* First round constants and IV of NEXTHASH-256 */
+static const uint32_t K[NEXTHASH_RNG_ROUNDS] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3
+};
+
+static const uint32_t H_INIT[16] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    0xcbbb9d5d, 0x629a292a, 0x9159015a, 0x152fecd8,
+    0x67332667, 0x8eb44a87, 0xdb0c2e0d, 0x47b5481d
+};
+
+#define TWO_PI_F  6.28318530717958647692f
+#define PI_F      3.14159265358979323846f
+#define INV_2PI_F 0.15915494309189533577f
+#define HALF_PI_F 1.57079632679489661923f
+#define TWO_M24   5.9604644775390625e-08f     /* 2^-24 */
+
+/* ========================================================================== */
+/* Block Function                                                              */
+/* ========================================================================== */
+
+static inline uint32_t rotr(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+static inline uint32_t widening_mul(uint32_t a, uint32_t b) {
+    uint64_t p = (uint64_t)a * b;
+    return (uint32_t)(p >> 32) ^ (uint32_t)p;
+}
+
+#define Ch(x, y, z)  (((x) & (y)) ^ (~(x) & (z)))
+#define Maj(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define Sigma0(x)    (rotr((x), 2) ^ rotr((x), 13) ^ rotr((x), 22))
+#define Sigma1(x)    (rotr((x), 6) ^ rotr((x), 11) ^ rotr((x), 25))
+
+/* nexthash_round() with the key word in place of the message word */
+static void rng_round(uint32_t s[16], uint32_t W_i, uint32_t K_i) {
+    uint32_t a = s[0], b = s[1], c = s[2], d = s[3];
+    uint32_t e = s[4], f = s[5], g = s[6], h = s[7];
+    uint32_t i = s[8], j = s[9], k = s[10], l = s[11];
+    uint32_t m = s[12], n = s[13], o = s[14], p = s[15];
+
+    uint32_t T1 = h + Sigma1(e) + Ch(e, f, g) + K_i + W_i;
+    uint32_t T2 = Sigma0(a) + Maj(a, b, c);
+    uint32_t M1 = widening_mul(a ^ i, e ^ m);
+    uint32_t M2 = widening_mul(b ^ j, f ^ n);
+    uint32_t M3 = widening_mul(c ^ k, g ^ o);
+    uint32_t M4 = widening_mul(d ^ l, h ^ p);
+    uint32_t M5 = widening_mul(a ^ m, e ^ i);
+    uint32_t M6 = widening_mul(b ^ n, f ^ j);
+    uint32_t M7 = widening_mul(c ^ o, g ^ k);
+    uint32_t M8 = widening_mul(d ^ p, h ^ l);
+    uint32_t M9 = widening_mul(a ^ p, d ^ m);
+    uint32_t M10 = widening_mul(b ^ o, c ^ n);
+    uint32_t T3 = p + Sigma1(m) + Ch(m, n, o) + (K_i ^ 0x5A5A5A5A) + W_i;
+    uint32_t T4 = Sigma0(i) + Maj(i, j, k);
+
+    s[0] = T1 + T2 + M1 + M5 + M9;
+    s[1] = a + M6 + M10;
+    s[2] = b;
+    s[3] = c + M2 + M7;
+    s[4] = d + T1 + M9;
+    s[5] = e + M8;
+    s[6] = f;
+    s[7] = g + M3 + M10;
+    s[8] = T3 + T4 + M1 + M5;
+    s[9] = i + M6;
+    s[10] = j;
+    s[11] = k + M4 + M7;
+    s[12] = l + T3 + M9;
+    s[13] = m + M8;
+    s[14] = n;
+    s[15] = o + (M2 ^ M3 ^ M4) + M10;
+}
+
+/*
+ * x = IV with the counter in words 0-1 and 8-9 (one per half), then
+ * ROUNDS keyed rounds with the usual interleave every fourth round and a
+ * feed-forward of x.
+ */
+void nexthash_rng_block(const uint32_t key[8], uint64_t counter,
+                        uint32_t out[NEXTHASH_RNG_BLOCK]) {
+    uint32_t x[16], s[16], t[16];
+    memcpy(x, H_INIT, sizeof(x));
+    x[0] ^= (uint32_t)counter;
+    x[1] ^= (uint32_t)(counter >> 32);
+    x[8] ^= (uint32_t)counter;
+    x[9] ^= (uint32_t)(counter >> 32);
+    memcpy(s, x, sizeof(s));
+
+    for (int r = 0; r < NEXTHASH_RNG_ROUNDS; r++) {
+        rng_round(s, key[r & 7], K[r]);
+        if ((r + 1) % 4 == 0) {
+            for (int i = 0; i < 8; i++) {
+                t[2 * i] = s[i];
+                t[2 * i + 1] = s[i + 8];
+            }
+            memcpy(s, t, sizeof(s));
+        }
+    }
+    for (int i = 0; i < 16; i++) out[i] = s[i] + x[i];
+}
+
+#if defined(__AVX2__)
+
+static inline __m256i v_rotr(__m256i x, int n) {
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+static inline __m256i v_wmul(__m256i a, __m256i b) {
+    __m256i even = _mm256_mul_epu32(a, b);
+    __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    even = _mm256_xor_si256(even, _mm256_srli_epi64(even, 32));
+    odd = _mm256_xor_si256(odd, _mm256_slli_epi64(odd, 32));
+    return _mm256_blend_epi32(even, odd, 0xAA);
+}
+
+#define V_ADD(a, b) _mm256_add_epi32((a), (b))
+#define V_XOR(a, b) _mm256_xor_si256((a), (b))
+#define V_AND(a, b) _mm256_and_si256((a), (b))
+#define V_CH(x, y, z)  V_XOR(V_AND((x), (y)), _mm256_andnot_si256((x), (z)))
+#define V_MAJ(x, y, z) V_XOR(V_XOR(V_AND((x), (y)), V_AND((x), (z))), V_AND((y), (z)))
+#define V_S0(x) V_XOR(V_XOR(v_rotr((x), 2), v_rotr((x), 13)), v_rotr((x), 22))
+#define V_S1(x) V_XOR(V_XOR(v_rotr((x), 6), v_rotr((x), 11)), v_rotr((x), 25))
+
+/* Blocks counter .. counter + 7 in lanes, written in position order */
+static void block_x8(const uint32_t key[8], uint64_t counter, uint32_t *out) {
+    __m256i x[16], s[16], t[16];
+    uint32_t lo[8], hi[8];
+    for (int l = 0; l < 8; l++) {
+        lo[l] = (uint32_t)(counter + l);
+        hi[l] = (uint32_t)((counter + l) >> 32);
+    }
+    __m256i vlo = _mm256_loadu_si256((const __m256i *)lo);
+    __m256i vhi = _mm256_loadu_si256((const __m256i *)hi);
+    for (int i = 0; i < 16; i++) x[i] = _mm256_set1_epi32((int)H_INIT[i]);
+    x[0] = V_XOR(x[0], vlo);
+    x[1] = V_XOR(x[1], vhi);
+    x[8] = V_XOR(x[8], vlo);
+    x[9] = V_XOR(x[9], vhi);
+    memcpy(s, x, sizeof(s));
+
+    for (int r = 0; r < NEXTHASH_RNG_ROUNDS; r++) {
+        const __m256i W = _mm256_set1_epi32((int)key[r & 7]);
+        const __m256i Ki = V_ADD(_mm256_set1_epi32((int)K[r]), W);
+        const __m256i Kl = V_ADD(_mm256_set1_epi32((int)(K[r] ^ 0x5A5A5A5A)), W);
+        __m256i a = s[0], b = s[1], c = s[2], d = s[3];
+        __m256i e = s[4], f = s[5], g = s[6], h = s[7];
+        __m256i ii = s[8], j = s[9], k = s[10], l = s[11];
+        __m256i m = s[12], n = s[13], o = s[14], p = s[15];
+
+        __m256i T1 = V_ADD(V_ADD(h, V_S1(e)), V_ADD(V_CH(e, f, g), Ki));
+        __m256i T2 = V_ADD(V_S0(a), V_MAJ(a, b, c));
+        __m256i M1 = v_wmul(V_XOR(a, ii), V_XOR(e, m));
+        __m256i M2 = v_wmul(V_XOR(b, j), V_XOR(f, n));
+        __m256i M3 = v_wmul(V_XOR(c, k), V_XOR(g, o));
+        __m256i M4 = v_wmul(V_XOR(d, l), V_XOR(h, p));
+        __m256i M5 = v_wmul(V_XOR(a, m), V_XOR(e, ii));
+        __m256i M6 = v_wmul(V_XOR(b, n), V_XOR(f, j));
+        __m256i M7 = v_wmul(V_XOR(c, o), V_XOR(g, k));
+        __m256i M8 = v_wmul(V_XOR(d, p), V_XOR(h, l));
+        __m256i M9 = v_wmul(V_XOR(a, p), V_XOR(d, m));
+        __m256i M10 = v_wmul(V_XOR(b, o), V_XOR(c, n));
+        __m256i T3 = V_ADD(V_ADD(p, V_S1(m)), V_ADD(V_CH(m, n, o), Kl));
+        __m256i T4 = V_ADD(V_S0(ii), V_MAJ(ii, j, k));
+
+        s[0] = V_ADD(V_ADD(V_ADD(T1, T2), V_ADD(M1, M5)), M9);
+        s[1] = V_ADD(V_ADD(a, M6), M10);
+        s[2] = b;
+        s[3] = V_ADD(V_ADD(c, M2), M7);
+        s[4] = V_ADD(V_ADD(d, T1), M9);
+        s[5] = V_ADD(e, M8);
+        s[6] = f;
+        s[7] = V_ADD(V_ADD(g, M3), M10);
+        s[8] = V_ADD(V_ADD(T3, T4), V_ADD(M1, M5));
+        s[9] = V_ADD(ii, M6);
+        s[10] = j;
+        s[11] = V_ADD(V_ADD(k, M4), M7);
+        s[12] = V_ADD(V_ADD(l, T3), M9);
+        s[13] = V_ADD(m, M8);
+        s[14] = n;
+        s[15] = V_ADD(V_ADD(o, V_XOR(V_XOR(M2, M3), M4)), M10);
+
+        if ((r + 1) % 4 == 0) {
+            for (int i = 0; i < 8; i++) {
+                t[2 * i] = s[i];
+                t[2 * i + 1] = s[i + 8];
+            }
+            memcpy(s, t, sizeof(s));
+        }
+    }
+
+    /* Word-major lanes to block-major output */
+    uint32_t w[16][8];
+    for (int i = 0; i < 16; i++) {
+        _mm256_storeu_si256((__m256i *)w[i], V_ADD(s[i], x[i]));
+    }
+    for (int l = 0; l < 8; l++) {
+        for (int i = 0; i < 16; i++) out[16 * l + i] = w[i][l];
+    }
+}
+
+#endif /* __AVX2__ */
+
+/* Whole blocks counter .. counter + n_blocks - 1 into out */
+static void gen_blocks(const uint32_t key[8], uint64_t counter, size_t n_blocks,
+                       uint32_t *out) {
+    size_t b = 0;
+#if defined(__AVX2__)
+    for (; b + 8 <= n_blocks; b += 8) {
+        block_x8(key, counter + b, out + 16 * b);
+    }
+#endif
+    for (; b < n_blocks; b++) {
+        nexthash_rng_block(key, counter + b, out + 16 * b);
+    }
+}
+
+/* ========================================================================== */
+/* Conversions                                                                 */
+/* ========================================================================== */
+
+/*
+ * Branch-free float kernels shared by the scalar and AVX2 paths, with the
+ * same operation order so both produce the same values.
+ */
+
+/* log(x), x in (0, 1]: Cephes logf polynomial */
+static inline float poly_logf(float x) {
+    union { float f; uint32_t u; } v = { x };
+    int e = (int)(v.u >> 23) - 126;
+    v.u = (v.u & 0x007FFFFFu) | 0x3F000000u;           /* [0.5, 1) */
+    float m = v.f;
+    int small = m < 0.70710678118654752440f;
+    e -= small;
+    m = small ? m + m - 1.0f : m - 1.0f;
+    float z = m * m;
+    float y = 7.0376836292e-2f;
+    y = y * m - 1.1514610310e-1f;
+    y = y * m + 1.1676998740e-1f;
+    y = y * m - 1.2420140846e-1f;
+    y = y * m + 1.4249322787e-1f;
+    y = y * m - 1.6668057665e-1f;
+    y = y * m + 2.0000714765e-1f;
+    y = y * m - 2.4999993993e-1f;
+    y = y * m + 3.3333331174e-1f;
+    y = y * m * z;
+    float fe = (float)e;
+    y = y + fe * -2.12194440e-4f;
+    y = y - 0.5f * z;
+    return m + y + fe * 0.693359375f;
+}
+
+/* sin(x), x in [-2pi, 2pi] */
+static inline float poly_sinf(float x) {
+    float k = x * INV_2PI_F;
+    k = (float)(int)(k + (k >= 0.0f ? 0.5f : -0.5f));
+    x = x - k * TWO_PI_F;
+    float ax = fabsf(x);
+    float y = fminf(ax, PI_F - ax);
+    float y2 = y * y;
+    float p = -2.5052108385441720e-08f;
+    p = p * y2 + 2.7557319223985893e-06f;
+    p = p * y2 - 1.9841269841269841e-04f;
+    p = p * y2 + 8.3333333333333333e-03f;
+    p = p * y2 - 1.6666666666666667e-01f;
+    p = p * y2 * y + y;
+    return x < 0.0f ? -p : p;
+}
+
+static inline float word_uniform(uint32_t w) {
+    return (float)(w >> 8) * TWO_M24;
+}
+
+/* Box-Muller on words (w0, w1): returns cos half, sin half in *z1 */
+static inline float box_muller(uint32_t w0, uint32_t w1, float *z1) {
+    float u1 = (float)((w0 >> 8) + 1) * TWO_M24;        /* (0, 1] */
+    float theta = (float)(w1 >> 8) * TWO_M24 * TWO_PI_F - PI_F;
+    float rad = sqrtf(-2.0f * poly_logf(u1));
+    *z1 = rad * poly_sinf(theta);
+    return rad * poly_sinf(theta + HALF_PI_F);
+}
+
+#if defined(__AVX2__)
+
+static inline __m256 v_logf(__m256 x) {
+    __m256i u = _mm256_castps_si256(x);
+    __m256i e = _mm256_sub_epi32(_mm256_srli_epi32(u, 23), _mm256_set1_epi32(126));
+    u = _mm256_or_si256(_mm256_and_si256(u, _mm256_set1_epi32(0x007FFFFF)),
+                        _mm256_set1_epi32(0x3F000000));
+    __m256 m = _mm256_castsi256_ps(u);
+    __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(0.70710678118654752440f), _CMP_LT_OQ);
+    e = _mm256_add_epi32(e, _mm256_castps_si256(small));       /* -1 where small */
+    m = _mm256_blendv_ps(_mm256_sub_ps(m, _mm256_set1_ps(1.0f)),
+                         _mm256_sub_ps(_mm256_add_ps(m, m), _mm256_set1_ps(1.0f)), small);
+    __m256 z = _mm256_mul_ps(m, m);
+    __m256 y = _mm256_set1_ps(7.0376836292e-2f);
+    y = _mm256_sub_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(1.1514610310e-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(1.1676998740e-1f));
+    y = _mm256_sub_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(1.2420140846e-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(1.4249322787e-1f));
+    y = _mm256_sub_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(1.6668057665e-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(2.0000714765e-1f));
+    y = _mm256_sub_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(2.4999993993e-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(3.3333331174e-1f));
+    y = _mm256_mul_ps(_mm256_mul_ps(y, m), z);
+    __m256 fe = _mm256_cvtepi32_ps(e);
+    y = _mm256_add_ps(y, _mm256_mul_ps(fe, _mm256_set1_ps(-2.12194440e-4f)));
+    y = _mm256_sub_ps(y, _mm256_mul_ps(_mm256_set1_ps(0.5f), z));
+    return _mm256_add_ps(_mm256_add_ps(m, y), _mm256_mul_ps(fe, _mm256_set1_ps(0.693359375f)));
+}
+
+static inline __m256 v_sinf(__m256 x) {
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    /* Round half away from zero, as the scalar (int)(k +- 0.5) */
+    __m256 kr = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(INV_2PI_F)),
+                              _mm256_or_ps(_mm256_set1_ps(0.5f),
+                                           _mm256_and_ps(sign, x)));
+    __m256 k = _mm256_round_ps(kr, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    x = _mm256_sub_ps(x, _mm256_mul_ps(k, _mm256_set1_ps(TWO_PI_F)));
+    __m256 ax = _mm256_andnot_ps(sign, x);
+    __m256 y = _mm256_min_ps(ax, _mm256_sub_ps(_mm256_set1_ps(PI_F), ax));
+    __m256 y2 = _mm256_mul_ps(y, y);
+    __m256 p = _mm256_set1_ps(-2.5052108385441720e-08f);
+    p = _mm256_add_ps(_mm256_mul_ps(p, y2), _mm256_set1_ps(2.7557319223985893e-06f));
+    p = _mm256_sub_ps(_mm256_mul_ps(p, y2), _mm256_set1_ps(1.9841269841269841e-04f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, y2), _mm256_set1_ps(8.3333333333333333e-03f));
+    p = _mm256_sub_ps(_mm256_mul_ps(p, y2), _mm256_set1_ps(1.6666666666666667e-01f));
+    p = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(p, y2), y), y);
+    return _mm256_xor_ps(p, _mm256_and_ps(x, sign));
+}
+
+static inline __m256 v_word_uniform(__m256i w) {
+    return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(w, 8)),
+                         _mm256_set1_ps(TWO_M24));
+}
+
+#endif /* __AVX2__ */
+
+static void convert_uniform(const uint32_t *w, float *out, size_t n) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(w + i));
+        _mm256_storeu_ps(out + i, v_word_uniform(v));
+    }
+#endif
+    for (; i < n; i++) out[i] = word_uniform(w[i]);
+}
+
+/* n even; w[2k], w[2k+1] form pair k */
+static void convert_normal(const uint32_t *w, float *out, size_t n) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 16 <= n; i += 16) {
+        __m256 a = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i *)(w + i)));
+        __m256 b = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i *)(w + i + 8)));
+        /* Per 128-bit half: even = a0 a2 b0 b2, odd = a1 a3 b1 b3 */
+        __m256i even = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        __m256i odd = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+
+        __m256 u1 = _mm256_mul_ps(
+            _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_srli_epi32(even, 8),
+                                                _mm256_set1_epi32(1))),
+            _mm256_set1_ps(TWO_M24));
+        __m256 theta = _mm256_sub_ps(_mm256_mul_ps(v_word_uniform(odd),
+                                                   _mm256_set1_ps(TWO_PI_F)),
+                                     _mm256_set1_ps(PI_F));
+        __m256 rad = _mm256_sqrt_ps(_mm256_mul_ps(_mm256_set1_ps(-2.0f), v_logf(u1)));
+        __m256 z1 = _mm256_mul_ps(rad, v_sinf(theta));
+        __m256 z0 = _mm256_mul_ps(rad, v_sinf(_mm256_add_ps(theta, _mm256_set1_ps(HALF_PI_F))));
+
+        _mm256_storeu_ps(out + i, _mm256_unpacklo_ps(z0, z1));
+        _mm256_storeu_ps(out + i + 8, _mm256_unpackhi_ps(z0, z1));
+    }
+#endif
+    for (; i < n; i += 2) {
+        out[i] = box_muller(w[i], w[i + 1], &out[i + 1]);
+    }
+}
+
+/* ========================================================================== */
+/* Positional Access                                                           */
+/* ========================================================================== */
+
+void nexthash_rng_fill_at(const uint32_t key[8], uint64_t pos, uint32_t *out, size_t n) {
+    uint32_t blk[NEXTHASH_RNG_BLOCK];
+
+    if (n && (pos & 15)) {
+        size_t off = (size_t)(pos & 15);
+        size_t take = 16 - off < n ? 16 - off : n;
+        nexthash_rng_block(key, pos >> 4, blk);
+        memcpy(out, blk + off, take * sizeof(uint32_t));
+        out += take;
+        pos += take;
+        n -= take;
+    }
+    size_t whole = n / 16;
+    gen_blocks(key, pos >> 4, whole, out);
+    out += 16 * whole;
+    pos += 16 * whole;
+    n -= 16 * whole;
+    if (n) {
+        nexthash_rng_block(key, pos >> 4, blk);
+        memcpy(out, blk, n * sizeof(uint32_t));
+    }
+}
+
+void nexthash_rng_uniform_f32_at(const uint32_t key[8], uint64_t pos, float *out, size_t n) {
+    uint32_t tile[TILE_WORDS];
+    while (n) {
+        size_t take = n < TILE_WORDS ? n : TILE_WORDS;
+        nexthash_rng_fill_at(key, pos, tile, take);
+        convert_uniform(tile, out, take);
+        out += take;
+        pos += take;
+        n -= take;
+    }
+}
+
+/* Gaussian at one position (the other half of its pair is dropped) */
+static float normal_one(const uint32_t key[8], uint64_t pos) {
+    uint32_t w[2];
+    float z1;
+    nexthash_rng_fill_at(key, pos & ~(uint64_t)1, w, 2);
+    float z0 = box_muller(w[0], w[1], &z1);
+    return (pos & 1) ? z1 : z0;
+}
+
+void nexthash_rng_normal_f32_at(const uint32_t key[8], uint64_t pos, float *out, size_t n) {
+    uint32_t tile[TILE_WORDS];
+    if (n && (pos & 1)) {
+        *out++ = normal_one(key, pos++);
+        n--;
+    }
+    while (n >= 2) {
+        size_t take = n < TILE_WORDS ? n & ~(size_t)1 : TILE_WORDS;
+        nexthash_rng_fill_at(key, pos, tile, take);
+        convert_normal(tile, out, take);
+        out += take;
+        pos += take;
+        n -= take;
+    }
+    if (n) *out = normal_one(key, pos);
+}
+
+/* ========================================================================== */
+/* Streams                                                                     */
+/* ========================================================================== */
+
+void nexthash_rng_key(uint32_t key[8], uint64_t seed, uint64_t stream) {
+    uint8_t msg[16], digest[32];
+    for (int i = 0; i < 8; i++) {
+        msg[i] = (uint8_t)(seed >> (8 * i));
+        msg[8 + i] = (uint8_t)(stream >> (8 * i));
+    }
+    nexthash256(msg, sizeof(msg), digest);
+    for (int i = 0; i < 8; i++) {
+        key[i] = (uint32_t)digest[4 * i] | (uint32_t)digest[4 * i + 1] << 8 |
+                 (uint32_t)digest[4 * i + 2] << 16 | (uint32_t)digest[4 * i + 3] << 24;
+    }
+}
+
+void nexthash_rng_init(nexthash_rng *r, uint64_t seed, uint64_t stream) {
+    nexthash_rng_key(r->key, seed, stream);
+    r->pos = 0;
+    r->buf_block = UINT64_MAX;
+}
+
+void nexthash_rng_seek(nexthash_rng *r, uint64_t pos) {
+    r->pos = pos;
+}
+
+void nexthash_rng_skip(nexthash_rng *r, uint64_t words) {
+    r->pos += words;
+}
+
+uint32_t nexthash_rng_u32(nexthash_rng *r) {
+    uint64_t block = r->pos >> 4;
+    if (block != r->buf_block) {
+        nexthash_rng_block(r->key, block, r->buf);
+        r->buf_block = block;
+    }
+    return r->buf[r->pos++ & 15];
+}
+
+uint64_t nexthash_rng_u64(nexthash_rng *r) {
+    uint64_t lo = nexthash_rng_u32(r);
+    return lo | (uint64_t)nexthash_rng_u32(r) << 32;
+}
+
+double nexthash_rng_uniform(nexthash_rng *r) {
+    return (double)(nexthash_rng_u64(r) >> 11) * 0x1.0p-53;
+}
+
+/* Lemire's multiply-and-reject: unbiased for every bound */
+uint32_t nexthash_rng_below(nexthash_rng *r, uint32_t bound) {
+    if (bound == 0) return 0;
+    uint64_t m = (uint64_t)nexthash_rng_u32(r) * bound;
+    if ((uint32_t)m < bound) {
+        uint32_t threshold = (uint32_t)(-bound) % bound;
+        while ((uint32_t)m < threshold) {
+            m = (uint64_t)nexthash_rng_u32(r) * bound;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+float nexthash_rng_normal(nexthash_rng *r) {
+    return normal_one(r->key, r->pos++);
+}
+
+void nexthash_rng_fill(nexthash_rng *r, uint32_t *out, size_t n) {
+    nexthash_rng_fill_at(r->key, r->pos, out, n);
+    r->pos += n;
+}
+
+void nexthash_rng_uniform_f32(nexthash_rng *r, float *out, size_t n) {
+    nexthash_rng_uniform_f32_at(r->key, r->pos, out, n);
+    r->pos += n;
+}
+
+void nexthash_rng_normal_f32(nexthash_rng *r, float *out, size_t n) {
+    nexthash_rng_normal_f32_at(r->key, r->pos, out, n);
+    r->pos += n;
+}
+
+/* ========================================================================== */
+/* Test                                                                        */
+/* ========================================================================== */
+
+#ifdef TEST_MAIN
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(void) {
+    int fail = 0;
+    printf("NEXTHASH Counter-Based Random Streams\n");
+    printf("=====================================\n\n");
+
+    nexthash_rng r;
+    nexthash_rng_init(&r, 2026, 0);
+    enum { N = 1 << 22 };
+    uint32_t *w = malloc(N * sizeof(uint32_t));
+    float *f = malloc(N * sizeof(float));
+    float *g = malloc(N * sizeof(float));
+
+    /* Bulk, scalar and positional draws agree */
+    {
+        int ok = 1;
+        nexthash_rng_fill(&r, w, 5000);
+        nexthash_rng_seek(&r, 0);
+        for (int i = 0; i < 5000; i++) ok &= nexthash_rng_u32(&r) == w[i];
+        for (uint64_t p = 0; p < 64; p += 7) {
+            uint32_t tmp[100];
+            nexthash_rng_fill_at(r.key, p, tmp, 100);
+            ok &= memcmp(tmp, w + p, sizeof(tmp)) == 0;
+        }
+        uint32_t blk[16];
+        nexthash_rng_block(r.key, 37, blk);
+        ok &= memcmp(blk, w + 37 * 16, sizeof(blk)) == 0;
+        printf("scalar / bulk / seek:     %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Gaussians: any split of a range gives the same values */
+    {
+        int ok = 1;
+        nexthash_rng_normal_f32_at(r.key, 1000, f, 4001);
+        size_t cuts[] = { 0, 1, 2, 17, 18, 1023, 1024, 2049, 4000, 4001 };
+        for (size_t c = 0; c + 1 < sizeof(cuts) / sizeof(cuts[0]); c++) {
+            nexthash_rng_seek(&r, 1000 + cuts[c]);
+            nexthash_rng_normal_f32(&r, g, cuts[c + 1] - cuts[c]);
+            ok &= memcmp(g, f + cuts[c], (cuts[c + 1] - cuts[c]) * sizeof(float)) == 0;
+        }
+        nexthash_rng_seek(&r, 1333);
+        float one = nexthash_rng_normal(&r);
+        ok &= one == f[333];
+        float z1, z0 = box_muller(w[1000], w[1001], &z1);
+        ok &= fabsf(z0 - f[0]) < 1e-6f && fabsf(z1 - f[1]) < 1e-6f;
+        ok &= fabsf(z0 - sqrtf(-2.0f * logf(((w[1000] >> 8) + 1) * TWO_M24)) *
+                    cosf((w[1001] >> 8) * TWO_M24 * TWO_PI_F - PI_F)) < 1e-5f;
+        printf("gaussian splits:          %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Moments */
+    {
+        nexthash_rng_seek(&r, 0);
+        nexthash_rng_uniform_f32(&r, f, N);
+        nexthash_rng_normal_f32(&r, g, N);
+        double um = 0, uv = 0, nm = 0, nv = 0, nk = 0;
+        for (int i = 0; i < N; i++) {
+            um += f[i];
+            uv += (f[i] - 0.5) * (f[i] - 0.5);
+            nm += g[i];
+            nv += (double)g[i] * g[i];
+            nk += (double)g[i] * g[i] * g[i] * g[i];
+        }
+        um /= N; uv /= N; nm /= N; nv /= N; nk /= N;
+        int ok = fabs(um - 0.5) < 1e-3 && fabs(uv - 1.0 / 12) < 1e-3 &&
+                 fabs(nm) < 2e-3 && fabs(nv - 1) < 3e-3 && fabs(nk - 3) < 3e-2;
+        printf("moments:                  uniform %.4f/%.4f, normal %.4f/%.4f/%.3f  %s\n",
+               um, uv, nm, nv, nk, ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Avalanche over the counter and between streams */
+    {
+        double flips = 0;
+        int trials = 0;
+        for (uint64_t c = 0; c < 256; c++) {
+            uint32_t a[16], b[16];
+            nexthash_rng_block(r.key, c * 0x9E3779B97F4A7C15ull, a);
+            for (int bit = 0; bit < 64; bit++) {
+                nexthash_rng_block(r.key, (c * 0x9E3779B97F4A7C15ull) ^ (1ull << bit), b);
+                for (int i = 0; i < 16; i++) flips += __builtin_popcount(a[i] ^ b[i]);
+                trials++;
+            }
+        }
+        double mean = flips / trials;
+        nexthash_rng s0, s1;
+        nexthash_rng_init(&s0, 7, 0);
+        nexthash_rng_init(&s1, 7, 1);
+        double sflips = 0;
+        for (int i = 0; i < 4096; i++) {
+            sflips += __builtin_popcount(nexthash_rng_u32(&s0) ^ nexthash_rng_u32(&s1));
+        }
+        sflips /= 4096;
+        int ok = fabs(mean - 256) < 2 && fabs(sflips - 16) < 0.5;
+        printf("avalanche:                %.2f / 256 bits per counter flip, "
+               "%.2f / 32 between streams  %s\n", mean, sflips, ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Unbiased bounded draws */
+    {
+        int counts[6] = {0};
+        for (int i = 0; i < 600000; i++) counts[nexthash_rng_below(&r, 6)]++;
+        int ok = 1;
+        for (int i = 0; i < 6; i++) ok &= abs(counts[i] - 100000) < 1500;
+        printf("below(6):                 %s\n", ok ? "OK" : "FAIL");
+        fail |= !ok;
+    }
+
+    /* Throughput */
+    {
+        double t0 = now_sec();
+        nexthash_rng_fill(&r, w, N);
+        double t1 = now_sec();
+        nexthash_rng_normal_f32(&r, g, N);
+        double t2 = now_sec();
+        printf("throughput:               %.0f MB/s words, %.0f M normals/s\n",
+               N * 4.0 / (t1 - t0) / 1e6, N / (t2 - t1) / 1e6);
+    }
+
+    free(w);
+    free(f);
+    free(g);
+    printf("\n%s\n", fail ? "FAIL" : "All tests passed");
+    return fail;
+}
+#endif /* TEST_MAIN */
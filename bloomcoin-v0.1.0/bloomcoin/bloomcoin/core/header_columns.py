@@ -0,0 +1,334 @@
+"""
+Columnar Header Views
+=====================
+
+NumPy views over the native columnar header archive
+(NextHash/bloom_headers.c): one contiguous typed column per
+PhaseEncodedHeader field, so coherence and retarget studies scan arrays
+instead of building header objects.
+
+Build the library next to its sources:
+
+    gcc -O3 -mavx2 -shared -fPIC -o libbloom_headers.so bloom_headers.c
+
+or point BLOOMCOIN_HEADERS_LIB at it.
+
+Usage:
+    cols = HeaderColumns.from_headers(headers)
+    r = cols.order_parameter                  # float32 view, no copy
+    blooms = cols.select_ge('order_parameter', Z_C)
+    retargets = cols.runs('difficulty')
+
+Column views share memory with the archive and keep it alive, so a view
+stays valid after close() or after its HeaderColumns is collected. An
+append() that has to grow the columns while views exist moves the rows to
+new memory; the views keep reading the rows they were taken from.
+"""
+
+import ctypes
+import os
+import weakref
+from typing import Dict, Iterable, Optional
+
+import numpy as np
+
+from .hash_wrapper import PhaseEncodedHeader
+
+HEADER_SIZE = 92
+
+_DEFAULT_LIB = os.path.join(
+    os.path.dirname(os.path.abspath(__file__)),
+    '..', '..', '..', '..', 'NextHash', 'libbloom_headers.so'
+)
+
+_U32 = ctypes.POINTER(ctypes.c_uint32)
+_F32 = ctypes.POINTER(ctypes.c_float)
+_U8 = ctypes.POINTER(ctypes.c_uint8)
+
+# Column name -> (ctypes element, NumPy dtype, row shape)
+_COLUMNS = {
+    'version': (_U32, np.uint32, ()),
+    'timestamp': (_U32, np.uint32, ()),
+    'difficulty': (_U32, np.uint32, ()),
+    'nonce': (_U32, np.uint32, ()),
+    'order_parameter': (_F32, np.float32, ()),
+    'mean_phase': (_F32, np.float32, ()),
+    'oscillator_count': (_U32, np.uint32, ()),
+    'prev_hash': (_U8, np.uint8, (32,)),
+    'merkle_root': (_U8, np.uint8, (32,)),
+}
+
+
+class _Headers(ctypes.Structure):
+    """bloom_headers"""
+    _fields_ = [('n', ctypes.c_size_t), ('cap', ctypes.c_size_t)] + [
+        (name, ptr) for name, (ptr, _, _) in _COLUMNS.items()
+    ]
+
+
+class _ColStats(ctypes.Structure):
+    """bloom_col_stats"""
+    _fields_ = [
+        ('n', ctypes.c_size_t),
+        ('min', ctypes.c_float),
+        ('max', ctypes.c_float),
+        ('sum', ctypes.c_double),
+        ('sum_sq', ctypes.c_double),
+    ]
+
+
+def _load_library() -> ctypes.CDLL:
+    path = os.environ.get('BLOOMCOIN_HEADERS_LIB', _DEFAULT_LIB)
+    lib = ctypes.CDLL(path)
+    h = ctypes.POINTER(_Headers)
+    size = ctypes.c_size_t
+
+    lib.bloom_headers_init.argtypes = [h, size]
+    lib.bloom_headers_init.restype = ctypes.c_int
+    lib.bloom_headers_free.argtypes = [h]
+    lib.bloom_headers_free.restype = None
+    lib.bloom_headers_append.argtypes = [h, ctypes.c_char_p, size, size]
+    lib.bloom_headers_append.restype = ctypes.c_int
+    lib.bloom_headers_row.argtypes = [h, size, ctypes.c_char_p]
+    lib.bloom_headers_row.restype = None
+    lib.bloom_headers_encode.argtypes = [h, ctypes.c_char_p, size]
+    lib.bloom_headers_encode.restype = ctypes.c_long
+    lib.bloom_headers_decode.argtypes = [h, ctypes.c_char_p, size]
+    lib.bloom_headers_decode.restype = ctypes.c_int
+
+    lib.bloom_col_stats_f32.argtypes = [_F32, size, ctypes.POINTER(_ColStats)]
+    lib.bloom_col_stats_f32.restype = None
+    lib.bloom_col_count_ge_f32.argtypes = [_F32, size, ctypes.c_float]
+    lib.bloom_col_count_ge_f32.restype = size
+    lib.bloom_col_select_ge_f32.argtypes = [_F32, size, ctypes.c_float, _U32]
+    lib.bloom_col_select_ge_f32.restype = size
+    lib.bloom_col_deltas_u32.argtypes = [_U32, size, ctypes.POINTER(ctypes.c_int32)]
+    lib.bloom_col_deltas_u32.restype = None
+    lib.bloom_col_window_mean_f32.argtypes = [_F32, size, size, _F32]
+    lib.bloom_col_window_mean_f32.restype = None
+    lib.bloom_col_window_mean_u32.argtypes = [_U32, size, size,
+                                              ctypes.POINTER(ctypes.c_double)]
+    lib.bloom_col_window_mean_u32.restype = None
+    lib.bloom_col_runs_u32.argtypes = [_U32, size, _U32]
+    lib.bloom_col_runs_u32.restype = size
+    return lib
+
+
+_lib: Optional[ctypes.CDLL] = None
+
+
+def _library() -> ctypes.CDLL:
+    global _lib
+    if _lib is None:
+        _lib = _load_library()
+    return _lib
+
+
+def _out(array: np.ndarray, ptr):
+    return array.ctypes.data_as(ptr)
+
+
+def _row_bytes(name: str) -> int:
+    _, dtype, row = _COLUMNS[name]
+    return int(np.dtype(dtype).itemsize * np.prod(row, dtype=np.int64))
+
+
+class _Columns:
+    """One bloom_headers, freed when no HeaderColumns or view refers to it."""
+
+    def __init__(self, lib: ctypes.CDLL, capacity: int):
+        self.lib = lib
+        self.h = _Headers()
+        self.views = weakref.WeakSet()
+        if lib.bloom_headers_init(ctypes.byref(self.h), capacity) != 0:
+            self.h = None
+            raise MemoryError("bloom_headers_init failed")
+
+    def __del__(self):
+        if getattr(self, 'h', None) is not None:
+            self.lib.bloom_headers_free(ctypes.byref(self.h))
+            self.h = None
+
+    def view(self, name: str) -> np.ndarray:
+        _, dtype, row = _COLUMNS[name]
+        ref = _ColumnRef(self, getattr(self.h, name), (self.h.n,) + row, dtype)
+        self.views.add(ref)
+        return np.asarray(ref)
+
+
+class _ColumnRef:
+    """Base of a column view: holds the _Columns the view points into."""
+
+    def __init__(self, columns: _Columns, ptr, shape, dtype):
+        self.columns = columns
+        self.__array_interface__ = {
+            'version': 3,
+            'shape': shape,
+            'typestr': np.dtype(dtype).str,
+            'data': (ctypes.cast(ptr, ctypes.c_void_p).value, False),
+        }
+
+
+class HeaderColumns:
+    """
+    The header chain as native columns with zero-copy NumPy views.
+
+    Each PhaseEncodedHeader field is available as an attribute:
+    order_parameter and mean_phase as float32 arrays, prev_hash and
+    merkle_root as (n, 32) uint8 arrays, the rest as uint32 arrays.
+    """
+
+    def __init__(self, capacity: int = 0):
+        self._lib = _library()
+        self._columns: Optional[_Columns] = _Columns(self._lib, capacity)
+
+    @property
+    def _h(self) -> _Headers:
+        if self._columns is None:
+            raise ValueError("HeaderColumns is closed")
+        return self._columns.h
+
+    @classmethod
+    def from_headers(cls, headers: Iterable[PhaseEncodedHeader]) -> 'HeaderColumns':
+        raw = b''.join(h.serialize() for h in headers)
+        cols = cls(len(raw) // HEADER_SIZE)
+        cols.append_raw(raw)
+        return cols
+
+    @classmethod
+    def from_archive(cls, archive: bytes) -> 'HeaderColumns':
+        cols = cls()
+        if cols._lib.bloom_headers_decode(ctypes.byref(cols._h), archive, len(archive)) != 0:
+            cols.close()
+            raise ValueError("malformed header archive")
+        return cols
+
+    def __len__(self) -> int:
+        return self._h.n
+
+    def close(self):
+        """Release the columns; memory still used by views is freed with them."""
+        self._columns = None
+
+    def _reserve(self, extra: int):
+        """
+        Make room for extra rows. Growing reallocates every column, so if
+        views of the current columns exist the rows are copied to a new
+        bloom_headers instead and the old one is left to the views.
+        """
+        old = self._columns
+        h = self._h
+        if h.n + extra <= h.cap or not len(old.views):
+            return
+        fresh = _Columns(self._lib, max(h.n + extra, 2 * h.cap))
+        for name in _COLUMNS:
+            ctypes.memmove(getattr(fresh.h, name), getattr(h, name), h.n * _row_bytes(name))
+        fresh.h.n = h.n
+        self._columns = fresh
+
+    def append(self, headers: Iterable[PhaseEncodedHeader]):
+        self.append_raw(b''.join(h.serialize() for h in headers))
+
+    def append_raw(self, raw: bytes, stride: int = HEADER_SIZE):
+        """Append serialized headers, header i at raw[i * stride:]."""
+        if stride < HEADER_SIZE:
+            raise ValueError(f"stride must be at least {HEADER_SIZE}")
+        n = (len(raw) - HEADER_SIZE) // stride + 1 if len(raw) >= HEADER_SIZE else 0
+        if n:
+            self._reserve(n)
+        if n and self._lib.bloom_headers_append(ctypes.byref(self._h), raw, n, stride) != 0:
+            raise MemoryError("bloom_headers_append failed")
+
+    def header(self, i: int) -> PhaseEncodedHeader:
+        if not 0 <= i < self._h.n:
+            raise IndexError(i)
+        out = ctypes.create_string_buffer(HEADER_SIZE)
+        self._lib.bloom_headers_row(ctypes.byref(self._h), i, out)
+        return PhaseEncodedHeader.deserialize(out.raw)
+
+    def to_archive(self) -> bytes:
+        size = self._lib.bloom_headers_encode(ctypes.byref(self._h), None, 0)
+        out = ctypes.create_string_buffer(size)
+        if self._lib.bloom_headers_encode(ctypes.byref(self._h), out, size) != size:
+            raise MemoryError("bloom_headers_encode failed")
+        return out.raw
+
+    # -------------------------------------------------------------------------
+    # Columns
+    # -------------------------------------------------------------------------
+
+    def column(self, name: str) -> np.ndarray:
+        """Zero-copy view of one column; it keeps the rows alive."""
+        _, dtype, row = _COLUMNS[name]
+        if self._h.n == 0:
+            return np.empty((0,) + row, dtype=dtype)
+        return self._columns.view(name)
+
+    def __getattr__(self, name: str) -> np.ndarray:
+        if name in _COLUMNS:
+            return self.column(name)
+        raise AttributeError(name)
+
+    def _f32(self, name: str):
+        if _COLUMNS[name][0] is not _F32:
+            raise TypeError(f"{name} is not a float32 column")
+        return getattr(self._h, name)
+
+    def _u32(self, name: str):
+        if _COLUMNS[name][0] is not _U32:
+            raise TypeError(f"{name} is not a uint32 column")
+        return getattr(self._h, name)
+
+    # -------------------------------------------------------------------------
+    # Kernels
+    # -------------------------------------------------------------------------
+
+    def stats(self, name: str) -> Dict[str, float]:
+        """min, max, mean and variance of a float32 column."""
+        st = _ColStats()
+        self._lib.bloom_col_stats_f32(self._f32(name), self._h.n, ctypes.byref(st))
+        n = st.n or 1
+        mean = st.sum / n
+        return {
+            'n': st.n, 'min': st.min, 'max': st.max,
+            'mean': mean, 'var': max(st.sum_sq / n - mean * mean, 0.0),
+        }
+
+    def count_ge(self, name: str, threshold: float) -> int:
+        return self._lib.bloom_col_count_ge_f32(self._f32(name), self._h.n, threshold)
+
+    def select_ge(self, name: str, threshold: float) -> np.ndarray:
+        """Row indices where a float32 column is >= threshold."""
+        x = self._f32(name)
+        idx = np.empty(self._h.n, dtype=np.uint32)
+        k = self._lib.bloom_col_select_ge_f32(x, self._h.n, threshold, _out(idx, _U32))
+        return idx[:k]
+
+    def deltas(self, name: str) -> np.ndarray:
+        """out[0] = 0, out[i] = x[i] - x[i-1] for a uint32 column."""
+        x = self._u32(name)
+        out = np.empty(self._h.n, dtype=np.int32)
+        self._lib.bloom_col_deltas_u32(x, self._h.n, _out(out, ctypes.POINTER(ctypes.c_int32)))
+        return out
+
+    def window_mean(self, name: str, window: int) -> np.ndarray:
+        """Mean of each `window` rows; the last window may be short."""
+        if window < 1:
+            raise ValueError("window must be positive")
+        n = self._h.n
+        count = (n + window - 1) // window
+        if _COLUMNS[name][0] is _F32:
+            out = np.empty(count, dtype=np.float32)
+            self._lib.bloom_col_window_mean_f32(self._f32(name), n, window, _out(out, _F32))
+        else:
+            out = np.empty(count, dtype=np.float64)
+            self._lib.bloom_col_window_mean_u32(self._u32(name), n, window,
+                                                _out(out, ctypes.POINTER(ctypes.c_double)))
+        return out
+
+    def runs(self, name: str) -> np.ndarray:
+        """Start row of every run of equal values (difficulty retargets)."""
+        x = self._u32(name)
+        starts = np.empty(self._h.n, dtype=np.uint32)
+        k = self._lib.bloom_col_runs_u32(x, self._h.n, _out(starts, _U32))
+        return starts[:k]
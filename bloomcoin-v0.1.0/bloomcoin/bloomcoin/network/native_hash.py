@@ -0,0 +1,172 @@
+"""
+BloomCoin Native Hash Offload
+
+Runs the node's transaction hashing (double SHA-256) on the worker threads
+of the native hashing pool (NextHash/nexthash_pool.c). Completions arrive
+on the pool's eventfd, which the event loop watches with add_reader(), so
+the loop thread never blocks on a hash.
+
+Build the library next to its sources:
+
+    gcc -O3 -march=native -shared -fPIC -pthread -o libnexthash_pool.so \\
+        nexthash_pool.c nexthash256.c bloom_sha256.c
+
+or point BLOOMCOIN_HASH_POOL_LIB at it. Without the library every call
+hashes inline with hashlib, as before.
+"""
+
+import asyncio
+import ctypes
+import hashlib
+import itertools
+import logging
+import os
+from typing import List, Optional
+
+logger = logging.getLogger(__name__)
+
+# nexthash_pool.h
+POOL_SHA256D = 1
+POOL_POLL_MAX = 64
+
+_DEFAULT_LIB = os.path.join(
+    os.path.dirname(os.path.abspath(__file__)),
+    '..', '..', '..', '..', 'NextHash', 'libnexthash_pool.so'
+)
+
+
+def _load_library() -> Optional[ctypes.CDLL]:
+    """Load libnexthash_pool.so, or None if it is not available."""
+    path = os.environ.get('BLOOMCOIN_HASH_POOL_LIB', _DEFAULT_LIB)
+    try:
+        lib = ctypes.CDLL(path)
+    except OSError:
+        return None
+
+    lib.nexthash_pool_create.argtypes = [ctypes.c_uint]
+    lib.nexthash_pool_create.restype = ctypes.c_void_p
+    lib.nexthash_pool_destroy.argtypes = [ctypes.c_void_p]
+    lib.nexthash_pool_destroy.restype = None
+    lib.nexthash_pool_fd.argtypes = [ctypes.c_void_p]
+    lib.nexthash_pool_fd.restype = ctypes.c_int
+    lib.nexthash_pool_submit.argtypes = [
+        ctypes.c_void_p, ctypes.c_uint, ctypes.c_char_p, ctypes.c_size_t,
+        ctypes.c_void_p, ctypes.c_uint64
+    ]
+    lib.nexthash_pool_submit.restype = ctypes.c_int
+    lib.nexthash_pool_submit_batch.argtypes = [
+        ctypes.c_void_p, ctypes.c_uint, ctypes.c_void_p, ctypes.c_void_p,
+        ctypes.c_size_t, ctypes.c_void_p, ctypes.c_uint64
+    ]
+    lib.nexthash_pool_submit_batch.restype = ctypes.c_int
+    lib.nexthash_pool_poll.argtypes = [
+        ctypes.c_void_p, ctypes.POINTER(ctypes.c_uint64), ctypes.c_size_t
+    ]
+    lib.nexthash_pool_poll.restype = ctypes.c_size_t
+    return lib
+
+
+def sha256d(data: bytes) -> bytes:
+    """Double SHA-256, as Transaction.hash computes it."""
+    return hashlib.sha256(hashlib.sha256(data).digest()).digest()
+
+
+class HashPool:
+    """
+    Awaitable double SHA-256 on native worker threads.
+
+    Each submission gets a tag and an asyncio.Future; the eventfd reader
+    resolves the futures as the pool reports tags done. Input and output
+    buffers are held until their tag comes back, even if the awaiting task
+    is cancelled.
+    """
+
+    def __init__(self, threads: int = 0):
+        self._lib = _load_library()
+        self._pool = None
+        self._loop: Optional[asyncio.AbstractEventLoop] = None
+        self._jobs = {}
+        self._tags = itertools.count(1)
+        self._done = (ctypes.c_uint64 * POOL_POLL_MAX)()
+        if self._lib is not None:
+            self._pool = self._lib.nexthash_pool_create(threads)
+            if not self._pool:
+                logger.warning("Native hash pool could not start, hashing inline")
+        else:
+            logger.debug("libnexthash_pool.so not found, hashing inline")
+
+    @property
+    def native(self) -> bool:
+        """True when hashes run on the native pool."""
+        return bool(self._pool)
+
+    def _attach(self) -> asyncio.AbstractEventLoop:
+        loop = asyncio.get_running_loop()
+        if self._loop is None:
+            self._loop = loop
+            loop.add_reader(self._lib.nexthash_pool_fd(self._pool), self._drain)
+        return self._loop
+
+    def _drain(self):
+        """eventfd readable: resolve every finished job."""
+        while True:
+            n = self._lib.nexthash_pool_poll(self._pool, self._done, POOL_POLL_MAX)
+            for tag in self._done[:n]:
+                future, _buffers, result = self._jobs.pop(tag)
+                if not future.cancelled():
+                    future.set_result(result())
+            if n < POOL_POLL_MAX:
+                break
+
+    async def sha256d(self, data: bytes) -> bytes:
+        """Double SHA-256 of data."""
+        if not self._pool:
+            return sha256d(data)
+        loop = self._attach()
+        data = bytes(data)
+        out = ctypes.create_string_buffer(32)
+        tag = next(self._tags)
+        future = loop.create_future()
+        self._jobs[tag] = (future, (data, out), lambda: out.raw)
+        if self._lib.nexthash_pool_submit(self._pool, POOL_SHA256D, data, len(data),
+                                          out, tag) != 0:
+            del self._jobs[tag]
+            raise MemoryError("native hash pool submit failed")
+        return await future
+
+    async def sha256d_batch(self, messages: List[bytes]) -> List[bytes]:
+        """Double SHA-256 of each message; one wakeup for the whole batch."""
+        if not self._pool or not messages:
+            return [sha256d(m) for m in messages]
+        loop = self._attach()
+        n = len(messages)
+        messages = [bytes(m) for m in messages]
+        ptrs = (ctypes.c_char_p * n)(*messages)
+        lens = (ctypes.c_size_t * n)(*(len(m) for m in messages))
+        out = ctypes.create_string_buffer(32 * n)
+        tag = next(self._tags)
+        future = loop.create_future()
+        self._jobs[tag] = (
+            future, (messages, ptrs, lens, out),
+            lambda: [out.raw[32 * i:32 * i + 32] for i in range(n)]
+        )
+        if self._lib.nexthash_pool_submit_batch(self._pool, POOL_SHA256D, ptrs, lens,
+                                                n, out, tag) != 0:
+            del self._jobs[tag]
+            raise MemoryError("native hash pool submit failed")
+        return await future
+
+    async def close(self):
+        """Wait for submitted jobs, then stop the workers."""
+        if not self._pool:
+            return
+        pending = [job[0] for job in self._jobs.values()]
+        if pending:
+            await asyncio.gather(*pending, return_exceptions=True)
+        if self._loop is not None:
+            self._loop.remove_reader(self._lib.nexthash_pool_fd(self._pool))
+            self._loop = None
+        # Runs the queued jobs of cancelled callers before returning
+        self._lib.nexthash_pool_destroy(self._pool)
+        self._pool = None
+        self._jobs.clear()
@@ -12,6 +12,7 @@ import time
 import logging
 
 from ..constants import DEFAULT_PORT, MAX_MESSAGE_SIZE
+from .native_hash import HashPool
 
 logger = logging.getLogger(__name__)
 
@@ -117,6 +118,9 @@ class Node:
         self.handlers: Dict[int, Callable] = {}
         self.server: Optional[asyncio.Server] = None
 
+        # Transaction hashing off the event loop thread
+        self.hash_pool = HashPool()
+
         # Register default handlers
         self._register_handlers()
 
@@ -151,6 +155,7 @@ class Node:
             await self.server.wait_closed()
         for peer in list(self.peers.values()):
             await peer.close()
+        await self.hash_pool.close()
         logger.info("Node stopped")
 
     async def connect(self, host: str, port: int) -> Optional[Peer]:
@@ -336,6 +341,14 @@ class Node:
             block_dict = Block.deserialize_from_bytes(payload)
             block = Block.from_dict(block_dict)
 
+            # Fill the txid caches on the hash pool so validation finds them
+            txs = [tx for tx in block.transactions if tx._hash is None]
+            digests = await self.hash_pool.sha256d_batch(
+                [tx.serialize_for_signing() for tx in txs]
+            )
+            for tx, digest in zip(txs, digests):
+                tx._hash = digest
+
             # Validate and add
             success = self.chain.add_block(block)
 
@@ -359,6 +372,8 @@ class Node:
             # Deserialize transaction
             tx_dict = Transaction.deserialize_from_bytes(payload)
             tx = Transaction.from_dict(tx_dict)
+            if tx._hash is None:
+                tx._hash = await self.hash_pool.sha256d(tx.serialize_for_signing())
 
             # Add to mempool
             if self.mempool.add(tx):
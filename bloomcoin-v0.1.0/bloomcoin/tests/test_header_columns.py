@@ -0,0 +1,120 @@
+"""
+Columnar header view tests.
+
+VERIFIES:
+  1. Columns match the headers they were built from
+  2. Archive round trip through to_archive() / from_archive()
+  3. A column view stays readable after its HeaderColumns is collected
+  4. A column view stays readable after close()
+  5. Views taken before a growing append() keep their rows
+  6. Scan kernels agree with NumPy
+
+Needs libbloom_headers.so (see core/header_columns.py); skipped without it.
+"""
+
+import gc
+import hashlib
+
+import pytest
+import numpy as np
+
+from bloomcoin.core.hash_wrapper import PhaseEncodedHeader
+from bloomcoin.core.header_columns import HeaderColumns
+
+try:
+    HeaderColumns().close()
+    HAS_LIBRARY = True
+except OSError:
+    HAS_LIBRARY = False
+
+pytestmark = pytest.mark.skipif(not HAS_LIBRARY, reason="libbloom_headers.so not built")
+
+
+def make_headers(n, start=0):
+    return [
+        PhaseEncodedHeader(
+            version=1,
+            prev_hash=hashlib.sha256(b"prev%d" % i).digest(),
+            merkle_root=hashlib.sha256(b"root%d" % i).digest(),
+            timestamp=1000 + i,
+            difficulty=1 + i // 100,
+            nonce=i * 7,
+            order_parameter=(i % 50) / 50.0,
+            mean_phase=0.25,
+            oscillator_count=64,
+        )
+        for i in range(start, start + n)
+    ]
+
+
+class TestColumns:
+    """Columns and archive."""
+
+    def test_columns_match_headers(self):
+        headers = make_headers(300)
+        cols = HeaderColumns.from_headers(headers)
+        assert len(cols) == 300
+        assert list(cols.timestamp) == [h.timestamp for h in headers]
+        assert cols.prev_hash.shape == (300, 32)
+        assert bytes(cols.merkle_root[17]) == headers[17].merkle_root
+        assert cols.header(42).serialize() == headers[42].serialize()
+
+    def test_archive_round_trip(self):
+        cols = HeaderColumns.from_headers(make_headers(500))
+        again = HeaderColumns.from_archive(cols.to_archive())
+        assert again.to_archive() == cols.to_archive()
+        assert np.array_equal(again.order_parameter, cols.order_parameter)
+
+
+class TestViewLifetime:
+    """Views keep the native columns alive."""
+
+    def test_view_outlives_owner(self):
+        archive = HeaderColumns.from_headers(make_headers(200)).to_archive()
+        r = HeaderColumns.from_archive(archive).timestamp
+        gc.collect()
+        # Reuse the freed sizes, so a dangling view would read other data
+        junk = [HeaderColumns.from_headers(make_headers(200, 5000)) for _ in range(4)]
+        assert int(r[:50].sum()) == 51225
+        assert int(r[-1]) == 1199
+        del junk
+
+    def test_slice_outlives_owner(self):
+        cols = HeaderColumns.from_headers(make_headers(200))
+        tail = cols.prev_hash[150:]
+        del cols
+        gc.collect()
+        assert bytes(tail[0]) == hashlib.sha256(b"prev150").digest()
+
+    def test_view_after_close(self):
+        cols = HeaderColumns.from_headers(make_headers(100))
+        nonce = cols.nonce
+        cols.close()
+        assert int(nonce[99]) == 99 * 7
+        with pytest.raises(ValueError):
+            len(cols)
+
+    def test_views_before_growing_append(self):
+        cols = HeaderColumns(capacity=100)
+        cols.append(make_headers(100))
+        before = cols.timestamp
+        cols.append(make_headers(5000, 100))
+        assert len(before) == 100
+        assert int(before[-1]) == 1099
+        after = cols.timestamp
+        assert len(after) == 5100
+        assert np.array_equal(after[:100], before)
+        assert int(after[-1]) == 1000 + 5099
+
+
+class TestKernels:
+    """Native scans agree with NumPy."""
+
+    def test_select_and_runs(self):
+        cols = HeaderColumns.from_headers(make_headers(1000))
+        r = cols.order_parameter
+        assert np.array_equal(cols.select_ge('order_parameter', 0.5),
+                              np.flatnonzero(r >= np.float32(0.5)))
+        assert cols.count_ge('order_parameter', 0.5) == int((r >= np.float32(0.5)).sum())
+        assert list(cols.runs('difficulty')) == list(range(0, 1000, 100))
+        assert list(cols.deltas('timestamp')) == [0] + [1] * 999
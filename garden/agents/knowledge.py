@@ -93,9 +93,18 @@ class KnowledgeBase:
     Manages an agent's complete knowledge base.
 
     Handles storage, retrieval, and reasoning over memories and skills.
+    With a MemoryStore (native_memory.py) memories are MemoryViews of
+    row `agent` in the store, and decay / consolidation run natively over
+    this agent's memories only.
     """
 
-    def __init__(self):
+    def __init__(self, store=None, agent: int = 0):
+        # Native column store shared by all agents, or None
+        self.store = store
+        self.agent = agent
+        if store is not None:
+            store.attach(agent, self)
+
         # Memory storage
         self.memories: Dict[str, Memory] = {}  # memory_id -> Memory
         self.memory_index: Dict[str, List[str]] = {}  # content_hash -> [memory_ids]
@@ -145,13 +154,23 @@ class KnowledgeBase:
             novelty = 0.3
 
         # Create memory
-        memory = Memory(
-            content=content,
-            memory_type=knowledge_type,
-            source=source,
-            coherence=coherence,
-            novelty=novelty
-        )
+        if self.store is not None:
+            memory = self.store.new_memory(
+                self.agent,
+                content=content,
+                memory_type=knowledge_type,
+                source=source,
+                coherence=coherence,
+                novelty=novelty
+            )
+        else:
+            memory = Memory(
+                content=content,
+                memory_type=knowledge_type,
+                source=source,
+                coherence=coherence,
+                novelty=novelty
+            )
 
         # Store memory
         self.memories[memory.memory_id] = memory
@@ -247,16 +266,19 @@ class KnowledgeBase:
 
         return max_overlap
 
-    def _index_topics(self, memory: Memory):
-        """Extract and index topics from a memory"""
+    def _topic_words(self, memory: Memory) -> List[str]:
+        """Topics of a memory, as indexed by _index_topics()"""
         # Simple topic extraction (in production, use NLP)
         content_str = json.dumps(memory.content).lower()
 
         # Extract potential topics (words longer than 4 chars)
         words = content_str.split()
         topics = [w for w in words if len(w) > 4 and w.isalpha()]
+        return topics[:5]  # Limit to 5 topics per memory
 
-        for topic in topics[:5]:  # Limit to 5 topics per memory
+    def _index_topics(self, memory: Memory):
+        """Extract and index topics from a memory"""
+        for topic in self._topic_words(memory):
             if topic not in self.topics:
                 self.topics[topic] = []
             self.topics[topic].append(memory.memory_id)
@@ -380,9 +402,60 @@ class KnowledgeBase:
 
     def apply_decay(self, decay_factor: float = 0.001):
         """Apply temporal decay to all memories (forgetting)"""
+        if self.store is not None:
+            self.store.decay_memories(self._native_ids(), decay_factor)
+            return
         for memory in self.memories.values():
             memory.decay(decay_factor)
 
+    def forget(self, fade_novelty: float = 0.0, keep_access: int = 1) -> int:
+        """
+        Drop faded memories: novelty <= fade_novelty and accessed fewer
+        than keep_access times. With a store this is one pass over every
+        agent's memories, and each attached KnowledgeBase drops its own.
+        """
+        if self.store is not None:
+            return self.store.forget(fade_novelty, keep_access)
+        faded = [
+            mid for mid, m in self.memories.items()
+            if m.novelty <= fade_novelty and m.access_count < keep_access
+        ]
+        self._forgotten(faded)
+        return len(faded)
+
+    def _native_ids(self) -> List[int]:
+        """Store ids of this agent's memories, in insertion order"""
+        return [m.native_id for m in self.memories.values()]
+
+    def _forgotten(self, memory_ids: List[str]):
+        """Remove forgotten memories from the index, topics and associations"""
+        for mid in memory_ids:
+            memory = self.memories.pop(mid, None)
+            if memory is None:
+                continue
+            self.total_memories -= 1
+
+            content_hash = memory.compute_hash()
+            ids = self.memory_index.get(content_hash, [])
+            if mid in ids:
+                ids.remove(mid)
+                if not ids:
+                    del self.memory_index[content_hash]
+
+            for topic in self._topic_words(memory):
+                ids = self.topics.get(topic, [])
+                if mid in ids:
+                    ids[:] = [t for t in ids if t != mid]
+                    if not ids:
+                        del self.topics[topic]
+
+            for related_id in self.associations.pop(mid, set()):
+                self.associations.get(related_id, set()).discard(mid)
+                related = self.memories.get(related_id)
+                if related is not None and mid in related.associations:
+                    related.associations[:] = [a for a in related.associations if a != mid]
+        self.last_updated = time.time()
+
     def consolidate(self) -> Dict[str, Any]:
         """
         Consolidate knowledge by identifying patterns and insights.
@@ -392,11 +465,15 @@ class KnowledgeBase:
         insights = []
 
         # Find frequently accessed memories
-        top_memories = sorted(
-            self.memories.values(),
-            key=lambda m: m.access_count,
-            reverse=True
-        )[:5]
+        if self.store is not None:
+            top_memories = [self.store.view(i)
+                            for i in self.store.summarize(self._native_ids())['top']]
+        else:
+            top_memories = sorted(
+                self.memories.values(),
+                key=lambda m: m.access_count,
+                reverse=True
+            )[:5]
 
         if top_memories:
             insights.append({
@@ -465,6 +542,8 @@ class KnowledgeBase:
 
     def add_existing(self, memory: Memory):
         """Add an existing memory (e.g., from import)"""
+        if self.store is not None and getattr(memory, '_store', None) is not self.store:
+            memory = self.store.adopt(self.agent, memory)
         self.memories[memory.memory_id] = memory
         self._index_topics(memory)
         self.total_memories += 1
\ No newline at end of file
@@ -0,0 +1,361 @@
+"""
+Native memory store for agent knowledge
+
+Keeps the numeric fields of every agent's memories in one column store
+(NextHash/bloom_memstore.c), so decay and consolidation are a single pass
+over all agents instead of a method call per Memory object. MemoryView
+has the fields and methods of Memory; content, source and associations
+stay in Python, the rest is read from and written to the store.
+
+MemoryStore.decay() and consolidate() are the all-agent pass, run once
+per garden tick. A KnowledgeBase only touches its own memories through
+decay_memories() and summarize(), so calling it for every agent costs
+the total number of memories, not agents x memories.
+
+Build the library next to its sources:
+
+    gcc -O3 -mavx2 -shared -fPIC -o libbloom_memstore.so bloom_memstore.c
+
+or point BLOOMCOIN_MEMSTORE_LIB at it. A KnowledgeBase uses the store
+when given one: KnowledgeBase(store=MemoryStore(n_agents), agent=i).
+"""
+
+import copy
+import ctypes
+import hashlib
+import json
+import os
+import time
+import uuid
+import weakref
+from typing import Any, Dict, Iterable, List, Optional
+
+# bloom_memstore.h
+NONE = 0xFFFFFFFF
+TOP = 5
+
+_DEFAULT_LIB = os.path.join(
+    os.path.dirname(os.path.abspath(__file__)),
+    '..', '..', 'NextHash', 'libbloom_memstore.so'
+)
+
+
+class _Entry(ctypes.Structure):
+    """bloom_memstore_entry"""
+    _fields_ = [
+        ('agent', ctypes.c_uint32),
+        ('type', ctypes.c_uint8),
+        ('timestamp', ctypes.c_double),
+        ('coherence', ctypes.c_double),
+        ('novelty', ctypes.c_double),
+        ('access_count', ctypes.c_uint32),
+    ]
+
+
+class _Policy(ctypes.Structure):
+    """bloom_memstore_policy"""
+    _fields_ = [
+        ('now', ctypes.c_double),
+        ('recent_window', ctypes.c_double),
+        ('fade_novelty', ctypes.c_double),
+        ('keep_access', ctypes.c_uint32),
+    ]
+
+
+class _Summary(ctypes.Structure):
+    """bloom_memstore_summary"""
+    _fields_ = [
+        ('memories', ctypes.c_uint32),
+        ('recent', ctypes.c_uint32),
+        ('faded', ctypes.c_uint32),
+        ('n_top', ctypes.c_uint32),
+        ('top', ctypes.c_uint32 * TOP),
+    ]
+
+
+def _load_library() -> ctypes.CDLL:
+    path = os.environ.get('BLOOMCOIN_MEMSTORE_LIB', _DEFAULT_LIB)
+    lib = ctypes.CDLL(path)
+    store = ctypes.c_void_p
+    ids = ctypes.POINTER(ctypes.c_uint32)
+
+    lib.bloom_memstore_create.argtypes = [ctypes.c_uint32]
+    lib.bloom_memstore_create.restype = store
+    lib.bloom_memstore_destroy.argtypes = [store]
+    lib.bloom_memstore_destroy.restype = None
+    lib.bloom_memstore_add.argtypes = [store, ctypes.POINTER(_Entry), ctypes.c_size_t, ids]
+    lib.bloom_memstore_add.restype = ctypes.c_int
+    lib.bloom_memstore_count.argtypes = [store]
+    lib.bloom_memstore_count.restype = ctypes.c_size_t
+    lib.bloom_memstore_row.argtypes = [store, ctypes.c_uint32]
+    lib.bloom_memstore_row.restype = ctypes.c_uint32
+    lib.bloom_memstore_get.argtypes = [store, ctypes.c_uint32, ctypes.POINTER(_Entry)]
+    lib.bloom_memstore_get.restype = ctypes.c_int
+    lib.bloom_memstore_set.argtypes = [store, ctypes.c_uint32, ctypes.POINTER(_Entry)]
+    lib.bloom_memstore_set.restype = ctypes.c_int
+    lib.bloom_memstore_strengthen.argtypes = [store, ids, ctypes.c_size_t]
+    lib.bloom_memstore_strengthen.restype = ctypes.c_size_t
+    lib.bloom_memstore_decay.argtypes = [store, ctypes.c_double, ctypes.c_double,
+                                         ctypes.POINTER(ctypes.c_double)]
+    lib.bloom_memstore_decay.restype = None
+    lib.bloom_memstore_decay_ids.argtypes = [store, ctypes.c_double, ctypes.c_double,
+                                             ids, ctypes.c_size_t]
+    lib.bloom_memstore_decay_ids.restype = None
+    lib.bloom_memstore_consolidate.argtypes = [store, ctypes.POINTER(_Policy),
+                                               ctypes.POINTER(_Summary)]
+    lib.bloom_memstore_consolidate.restype = None
+    lib.bloom_memstore_summarize.argtypes = [store, ctypes.POINTER(_Policy), ids,
+                                             ctypes.c_size_t, ctypes.POINTER(_Summary)]
+    lib.bloom_memstore_summarize.restype = None
+    lib.bloom_memstore_forget.argtypes = [store, ctypes.POINTER(_Policy)]
+    lib.bloom_memstore_forget.restype = ctypes.c_size_t
+    return lib
+
+
+class MemoryStore:
+    """
+    Memory columns for agents 0 .. n_agents-1.
+
+    decay() and consolidate() cover every agent in one native call;
+    decay_memories() and summarize() cover a list of memories, such as
+    one KnowledgeBase's.
+    """
+
+    def __init__(self, n_agents: int):
+        self._lib = _load_library()
+        self._store = self._lib.bloom_memstore_create(n_agents)
+        if not self._store:
+            raise MemoryError("bloom_memstore_create failed")
+        self.n_agents = n_agents
+        self._views: Dict[int, 'MemoryView'] = {}
+        self._owners: Dict[int, weakref.ref] = {}
+        self._type_codes: Dict[str, int] = {'fact': 0, 'skill': 1, 'creation': 2, 'insight': 3}
+
+    def __del__(self):
+        self.close()
+
+    def __len__(self) -> int:
+        return self._lib.bloom_memstore_count(self._store)
+
+    def close(self):
+        if getattr(self, '_store', None):
+            self._lib.bloom_memstore_destroy(self._store)
+            self._store = None
+            self._views.clear()
+
+    def attach(self, agent: int, owner):
+        """Register the owner of agent's memories; forget() reports to it."""
+        self._owners[agent] = weakref.ref(owner)
+
+    def _type_code(self, memory_type: str) -> int:
+        code = self._type_codes.get(memory_type)
+        if code is None:
+            if len(self._type_codes) > 255:
+                raise ValueError("too many memory types")
+            code = self._type_codes[memory_type] = len(self._type_codes)
+        return code
+
+    # -------------------------------------------------------------------------
+    # Memories
+    # -------------------------------------------------------------------------
+
+    def new_memory(
+        self,
+        agent: int,
+        content: Optional[Dict[str, Any]] = None,
+        memory_type: str = "fact",
+        source: Optional[str] = None,
+        coherence: float = 0.5,
+        novelty: float = 1.0,
+        timestamp: Optional[float] = None,
+        access_count: int = 0,
+        memory_id: Optional[str] = None,
+        associations: Optional[List[str]] = None
+    ) -> 'MemoryView':
+        """Store a memory of agent and return its view."""
+        entry = _Entry(agent, self._type_code(memory_type),
+                       time.time() if timestamp is None else timestamp,
+                       coherence, novelty, access_count)
+        native_id = ctypes.c_uint32()
+        st = self._lib.bloom_memstore_add(self._store, ctypes.byref(entry), 1,
+                                          ctypes.byref(native_id))
+        if st != 0:
+            raise (ValueError(f"agent {agent} out of range") if st == -2
+                   else MemoryError("bloom_memstore_add failed"))
+        view = MemoryView(self, native_id.value, agent, memory_id or str(uuid.uuid4()),
+                          content if content is not None else {}, memory_type, source,
+                          associations if associations is not None else [])
+        self._views[native_id.value] = view
+        return view
+
+    def adopt(self, agent: int, memory) -> 'MemoryView':
+        """Copy a Memory (or any object with its fields) into the store."""
+        return self.new_memory(
+            agent, memory.content, memory.memory_type, memory.source, memory.coherence,
+            memory.novelty, memory.timestamp, memory.access_count, memory.memory_id,
+            memory.associations
+        )
+
+    def view(self, native_id: int) -> 'MemoryView':
+        return self._views[native_id]
+
+    def _get(self, native_id: int) -> _Entry:
+        entry = _Entry()
+        if self._lib.bloom_memstore_get(self._store, native_id, ctypes.byref(entry)) != 0:
+            raise KeyError(f"memory {native_id} is not in the store")
+        return entry
+
+    def _set(self, native_id: int, entry: _Entry):
+        if self._lib.bloom_memstore_set(self._store, native_id, ctypes.byref(entry)) != 0:
+            raise KeyError(f"memory {native_id} is not in the store")
+
+    # -------------------------------------------------------------------------
+    # Bulk operations
+    # -------------------------------------------------------------------------
+
+    def strengthen(self, native_ids: Iterable[int]) -> int:
+        """Memory.strengthen() for each id; returns the number found."""
+        ids = list(native_ids)
+        arr = (ctypes.c_uint32 * len(ids))(*ids)
+        return self._lib.bloom_memstore_strengthen(self._store, arr, len(ids))
+
+    def decay(self, decay_factor: float = 0.001, now: Optional[float] = None):
+        """Memory.decay() for every memory of every agent."""
+        now = time.time() if now is None else now
+        self._lib.bloom_memstore_decay(self._store, now, decay_factor, None)
+
+    def decay_memories(self, native_ids: Iterable[int], decay_factor: float = 0.001,
+                       now: Optional[float] = None):
+        """Memory.decay() for the listed memories only."""
+        ids = list(native_ids)
+        arr = (ctypes.c_uint32 * len(ids))(*ids)
+        self._lib.bloom_memstore_decay_ids(self._store, time.time() if now is None else now,
+                                           decay_factor, arr, len(ids))
+
+    def consolidate(self, now: Optional[float] = None, recent_window: float = 3600.0,
+                    fade_novelty: float = 0.0, keep_access: int = 1) -> List[Dict[str, Any]]:
+        """Per-agent counts and most accessed memories, all agents in one pass."""
+        policy = _Policy(time.time() if now is None else now, recent_window,
+                         fade_novelty, keep_access)
+        out = (_Summary * self.n_agents)()
+        self._lib.bloom_memstore_consolidate(self._store, ctypes.byref(policy), out)
+        return [_summary_dict(s) for s in out]
+
+    def summarize(self, native_ids: Iterable[int], now: Optional[float] = None,
+                  recent_window: float = 3600.0, fade_novelty: float = 0.0,
+                  keep_access: int = 1) -> Dict[str, Any]:
+        """consolidate() over the listed memories only, given oldest first."""
+        ids = list(native_ids)
+        arr = (ctypes.c_uint32 * len(ids))(*ids)
+        policy = _Policy(time.time() if now is None else now, recent_window,
+                         fade_novelty, keep_access)
+        out = _Summary()
+        self._lib.bloom_memstore_summarize(self._store, ctypes.byref(policy), arr, len(ids),
+                                           ctypes.byref(out))
+        return _summary_dict(out)
+
+    def forget(self, fade_novelty: float = 0.0, keep_access: int = 1,
+               now: Optional[float] = None) -> int:
+        """
+        Drop memories with novelty <= fade_novelty and fewer accesses, for
+        every agent. Each attached owner gets _forgotten(memory_ids) with
+        the memories it lost.
+        """
+        policy = _Policy(time.time() if now is None else now, 3600.0, fade_novelty, keep_access)
+        removed = self._lib.bloom_memstore_forget(self._store, ctypes.byref(policy))
+        if not removed:
+            return 0
+        lost: Dict[int, List[str]] = {}
+        for native_id in [i for i in self._views
+                          if self._lib.bloom_memstore_row(self._store, i) == NONE]:
+            view = self._views.pop(native_id)
+            lost.setdefault(view._agent, []).append(view.memory_id)
+        for agent, memory_ids in lost.items():
+            ref = self._owners.get(agent)
+            owner = ref() if ref is not None else None
+            if owner is not None:
+                owner._forgotten(memory_ids)
+        return removed
+
+
+def _summary_dict(s: _Summary) -> Dict[str, Any]:
+    return {
+        'memories': s.memories,
+        'recent': s.recent,
+        'faded': s.faded,
+        'top': [s.top[k] for k in range(s.n_top)],
+    }
+
+
+def _column(name: str):
+    def get(self):
+        return getattr(self._store._get(self._native_id), name)
+
+    def set(self, value):
+        entry = self._store._get(self._native_id)
+        setattr(entry, name, value)
+        self._store._set(self._native_id, entry)
+
+    return property(get, set, doc=f"Memory.{name}, held in the store")
+
+
+class MemoryView:
+    """
+    A Memory whose timestamp, coherence, novelty and access_count live in a
+    MemoryStore. Same fields and methods as Memory.
+    """
+
+    __slots__ = ('_store', '_native_id', '_agent', 'memory_id', 'content', 'memory_type',
+                 'source', 'associations')
+
+    def __init__(self, store: MemoryStore, native_id: int, agent: int, memory_id: str,
+                 content: Dict[str, Any], memory_type: str, source: Optional[str],
+                 associations: List[str]):
+        self._store = store
+        self._native_id = native_id
+        self._agent = agent
+        self.memory_id = memory_id
+        self.content = content
+        self.memory_type = memory_type
+        self.source = source
+        self.associations = associations
+
+    timestamp = _column('timestamp')
+    coherence = _column('coherence')
+    novelty = _column('novelty')
+    access_count = _column('access_count')
+
+    @property
+    def native_id(self) -> int:
+        return self._native_id
+
+    def compute_hash(self) -> str:
+        """Compute hash of memory content for comparison"""
+        content_str = json.dumps(self.content, sort_keys=True)
+        return hashlib.sha256(content_str.encode()).hexdigest()
+
+    def to_dict(self) -> Dict[str, Any]:
+        """Same keys and order as Memory.to_dict()"""
+        entry = self._store._get(self._native_id)
+        return {
+            'memory_id': self.memory_id,
+            'content': copy.deepcopy(self.content),
+            'memory_type': self.memory_type,
+            'timestamp': entry.timestamp,
+            'source': self.source,
+            'coherence': entry.coherence,
+            'novelty': entry.novelty,
+            'access_count': entry.access_count,
+            'associations': copy.deepcopy(self.associations),
+        }
+
+    def strengthen(self):
+        """Memory.strengthen(), in the store"""
+        self._store.strengthen((self._native_id,))
+
+    def decay(self, time_factor: float = 0.001):
+        """Memory.decay() for this memory alone"""
+        entry = self._store._get(self._native_id)
+        age = time.time() - entry.timestamp
+        entry.novelty = max(0, entry.novelty - age * time_factor)
+        self._store._set(self._native_id, entry)
@@ -0,0 +1,117 @@
+"""
+Native Memory Store Tests
+=========================
+
+KnowledgeBase backed by a MemoryStore (native_memory.py) against the
+plain Python KnowledgeBase. Needs libbloom_memstore.so (see
+native_memory.py); skipped without it.
+
+Run with: python -m pytest garden/agents/test_native_memory.py
+"""
+
+import time
+
+import pytest
+
+from garden.agents.knowledge import KnowledgeBase
+from garden.agents.native_memory import MemoryStore
+
+try:
+    MemoryStore(1).close()
+    HAS_LIBRARY = True
+except OSError:
+    HAS_LIBRARY = False
+
+pytestmark = pytest.mark.skipif(not HAS_LIBRARY, reason="libbloom_memstore.so not built")
+
+TOPICS = ["crystal", "garden", "lattice", "phase", "bloom", "ledger"]
+
+
+def fill(kb, n, start=0):
+    """Add n memories with overlapping topics; every third is never accessed."""
+    for i in range(start, start + n):
+        kb.add_knowledge(
+            {"text": f"{TOPICS[i % 6]} {TOPICS[(i + 1) % 6]} notes", "n": i},
+            knowledge_type="fact" if i % 2 else "insight",
+            coherence=0.5,
+        )
+    for i, memory in enumerate(list(kb.memories.values())):
+        if i % 3:
+            memory.strengthen()
+
+
+def fade(kb):
+    """Zero the novelty of every memory, so forget() drops the unaccessed ones"""
+    for memory in kb.memories.values():
+        memory.novelty = 0.0
+
+
+def test_forget_then_consolidate():
+    store = MemoryStore(2)
+    kb = KnowledgeBase(store=store, agent=0)
+    other = KnowledgeBase(store=store, agent=1)
+    plain = KnowledgeBase()
+    for k in (kb, other, plain):
+        fill(k, 30)
+        fade(k)
+
+    removed = kb.forget(fade_novelty=0.0, keep_access=1)
+    assert plain.forget(fade_novelty=0.0, keep_access=1) == 10
+    assert removed == 20            # both agents of the store
+    assert len(kb.memories) == len(other.memories) == len(plain.memories) == 20
+    assert kb.total_memories == 20
+
+    # No map may still name a forgotten memory
+    for k in (kb, other, plain):
+        live = set(k.memories)
+        assert all(set(ids) <= live for ids in k.memory_index.values())
+        assert all(set(ids) <= live for ids in k.topics.values())
+        assert set(k.associations) <= live
+        assert all(assocs <= live for assocs in k.associations.values())
+        assert all(set(m.associations) <= live for m in k.memories.values())
+
+    summary = kb.consolidate()
+    expect = plain.consolidate()
+    assert summary["total_memories"] == expect["total_memories"] == 20
+    top = [i for i in summary["insights"] if i["type"] == "frequently_accessed"][0]
+    assert all(mid in kb.memories for mid in top["memories"])
+    other.consolidate()
+    assert kb.get_related_memories(next(iter(kb.memories))) is not None
+
+
+def test_forget_keeps_accessed():
+    store = MemoryStore(1)
+    kb = KnowledgeBase(store=store, agent=0)
+    fill(kb, 12)
+    fade(kb)
+    kept = {mid for mid, m in kb.memories.items() if m.access_count >= 1}
+    kb.forget(fade_novelty=0.0, keep_access=1)
+    assert set(kb.memories) == kept
+    assert all(m.timestamp <= time.time() for m in kb.memories.values())
+
+
+def test_decay_and_consolidate_touch_own_memories():
+    store = MemoryStore(3)
+    kbs = [KnowledgeBase(store=store, agent=g) for g in range(3)]
+    plain = KnowledgeBase()
+    for k in kbs + [plain]:
+        fill(k, 40)
+    for k in kbs + [plain]:
+        for m in k.memories.values():
+            m.timestamp -= 100.0
+
+    before = [m.novelty for m in kbs[1].memories.values()]
+    kbs[0].apply_decay(0.001)
+    plain.apply_decay(0.001)
+    assert [m.novelty for m in kbs[1].memories.values()] == before
+    for got, want in zip(kbs[0].memories.values(), plain.memories.values()):
+        assert abs(got.novelty - want.novelty) < 1e-3
+
+    def top_contents(k):
+        top = [i for i in k.consolidate()["insights"] if i["type"] == "frequently_accessed"][0]
+        return [k.memories[mid].content for mid in top["memories"]]
+
+    assert top_contents(kbs[0]) == top_contents(plain)
+    kbs[2].retrieve_memories("garden")
+    plain.retrieve_memories("garden")
+    assert top_contents(kbs[2]) == top_contents(plain)